@@ -1,4 +1,6 @@
 #include "../bff_file/g_bff.h"
+#include "compress.h"
+#include "cook.h"
 
 typedef struct
 {
@@ -20,12 +22,18 @@ static void help(int index);
 static void write(int index);
 static void decompile(int index);
 static void test(int index);
+static void bench(int index);
 
 static const cmdarg_t cmdargs[] = {
     {{"-h", "--help"},      "-h --help                                   display this message", help},
-    {{"-w", "--write"},     "-w --write OUTPUT.bff ENTRIES.json          write archive from a json entries file into a bff file", write},
+    {{"-w", "--write"},     "-w --write OUTPUT.bff ENTRIES.json          write archive from a json entries file into a bff file\n"
+                            "         -C --compress zlib|bzip2|zstd|lz4|auto   codec for every chunk, auto picks one per asset type\n"
+                            "         -j --threads N                             threads to compress with, defaults to the core count\n"
+                            "         -k --cook rgba|bc1|bc3|bc7|auto            cook textures into dds files with their mips built\n"
+                            "         -K --cache DIR|none                        where cooked textures are kept between runs, defaults to " COOK_DEFAULT_CACHE, write},
     {{"-d", "--decompile"}, "-d --decompile INPUT.bff                    display the contents of a bff file", decompile},
-    {{"-t", "--test"},      "-t --test INPUT.bff                         test a bff's contents (corruption proofing)", test},
+    {{"-t", "--test"},      "-t --test [INPUT.bff]                       test a bff's contents (corruption proofing), or round trip every codec and cook format", test},
+    {{"-b", "--bench"},     "-b --bench [FILES...]                       pack/unpack throughput of every codec over the files or test data", bench},
 };
 
 static const char **Cmd_Args(void);
@@ -61,19 +69,30 @@ static void write(int index)
     const char *entries = Cmd_Argv(index + 2);
 
     int compression = Cmd_Exists("-C", "--compress");
-    int compressionLib = COMPRESSION_NONE;
+    int compressionLib = COMPRESS_NONE;
     if (compression != -1) {
-        const char *compressArg = Cmd_Argv(compression + 1);
-        if (!strcmp(compressArg, "zlib")) {
-            compressionLib = COMPRESSION_ZLIB;
-            Con_Printf("using zlib compression");
-        }
-        else if (!strcmp(compressArg, "bzip2")) {
-            compressionLib = COMPRESSION_BZIP2;
-            Con_Printf("using bzip2 compression");
-        }
-        else
-            usage("-w|--write OUTPUT.bff ENTRIES.json -C|--compress zlib|bzip2");
+        compressionLib = BFF_CompressionFromString(Cmd_Argv(compression + 1));
+        if (compressionLib == -2)
+            usage("-w|--write OUTPUT.bff ENTRIES.json -C|--compress zlib|bzip2|zstd|lz4|auto");
+        Con_Printf("using %s compression", BFF_CompressionString(compressionLib));
+    }
+
+    int threads = Cmd_Exists("-j", "--threads");
+    if (threads != -1) {
+        bff_numThreads = atoi(Cmd_Argv(threads + 1));
+    }
+
+    int cook = Cmd_Exists("-k", "--cook");
+    if (cook != -1) {
+        bff_cookFormat = BFF_CookFormatFromString(Cmd_Argv(cook + 1));
+        if (bff_cookFormat == COOK_NONE)
+            usage("-w|--write OUTPUT.bff ENTRIES.json -k|--cook rgba|bc1|bc3|bc7|auto");
+        Con_Printf("cooking textures to %s", BFF_CookFormatString(bff_cookFormat));
+    }
+
+    int cache = Cmd_Exists("-K", "--cache");
+    if (cache != -1) {
+        bff_cookCache = !strcmp(Cmd_Argv(cache + 1), "none") ? "" : Cmd_Argv(cache + 1);
     }
 
     Con_Printf("writing archive from entries file %s to output %s", entries, out);
@@ -100,7 +119,28 @@ static void help(int index)
 
 static void test(int index)
 {
+    if (index + 1 < Cmd_Argc() && Cmd_Argv(index + 1)[0] != '-') {
+        Con_Printf("testing contents of bff archive %s", Cmd_Argv(index + 1));
+        TestBFF(Cmd_Argv(index + 1));
+    }
+    else {
+        TestCodecs();
+        TestCook();
+    }
+}
 
+static void bench(int index)
+{
+    int threads = Cmd_Exists("-j", "--threads");
+    if (threads != -1) {
+        bff_numThreads = atoi(Cmd_Argv(threads + 1));
+    }
+
+    int count = 0;
+    while (index + 1 + count < Cmd_Argc() && Cmd_Argv(index + 1 + count)[0] != '-') {
+        count++;
+    }
+    BenchCodecs(Cmd_Args() + index + 1, count);
 }
 
 static const char **Cmd_Args(void)
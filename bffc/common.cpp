@@ -2,6 +2,16 @@
 #define LOG_WARN(...) Con_Printf(__VA_ARGS__)
 #define N_Error BFF_Error
 #include "zone.h"
+#include "compress.h"
+#include <bzlib.h>
+#include <zlib.h>
+#include <zstd.h>
+#include <lz4.h>
+#include <lz4hc.h>
+#include <thread>
+#include <atomic>
+#include <vector>
+#include <chrono>
 
 #if 0
 bff_short_t LittleShort(bff_short_t x)
@@ -114,24 +124,91 @@ static void SafeRead(FILE* fp, void *data, size_t size)
 	}
 }
 
-static inline const char *BFF_CompressionString(int compression)
+const char *BFF_CompressionString(int compression)
 {
 	switch (compression) {
-	case COMPRESSION_BZIP2: return "bzip2";
-	case COMPRESSION_ZLIB: return "zlib";
+	case COMPRESS_BZIP2: return "bzip2";
+	case COMPRESS_ZLIB: return "zlib";
+	case COMPRESS_ZSTD: return "zstd";
+	case COMPRESS_LZ4: return "lz4";
+	case COMPRESS_AUTO: return "auto";
 	};
 	return "None";
 }
 
+int BFF_CompressionFromString(const char *name)
+{
+	static const int codecs[] = { COMPRESS_NONE, COMPRESS_ZLIB, COMPRESS_BZIP2, COMPRESS_ZSTD, COMPRESS_LZ4, COMPRESS_AUTO };
+
+	for (const auto& i : codecs) {
+		if (!strcasecmp(name, BFF_CompressionString(i)))
+			return i;
+	}
+	return -2;
+}
+
+/*
+* BFF_CodecForFile: lz4 for anything that has to decode fast while a level loads (textures, sounds),
+* zstd for text that compresses well (scripts, levels, configs), nothing for formats that are
+* already compressed
+*/
+int BFF_CodecForFile(const char *name)
+{
+	static const struct {
+		const char *ext;
+		int codec;
+	} codecs[] = {
+		{ "png", COMPRESS_NONE }, { "jpg", COMPRESS_NONE }, { "jpeg", COMPRESS_NONE },
+		{ "ogg", COMPRESS_NONE }, { "mp3", COMPRESS_NONE }, { "bank", COMPRESS_NONE },
+		{ "tga", COMPRESS_LZ4 }, { "bmp", COMPRESS_LZ4 }, { "dds", COMPRESS_LZ4 }, { "pcx", COMPRESS_LZ4 },
+		{ "tex2d", COMPRESS_LZ4 }, { "wav", COMPRESS_LZ4 },
+		{ "as", COMPRESS_ZSTD }, { "asb", COMPRESS_ZSTD }, { "bmf", COMPRESS_ZSTD }, { "map", COMPRESS_ZSTD },
+		{ "tile2d", COMPRESS_ZSTD }, { "anim2d", COMPRESS_ZSTD }, { "json", COMPRESS_ZSTD }, { "txt", COMPRESS_ZSTD },
+		{ "cfg", COMPRESS_ZSTD }, { "glsl", COMPRESS_ZSTD }, { "shader", COMPRESS_ZSTD },
+	};
+	const char *ext, *slash;
+
+	ext = strrchr(name, '.');
+	slash = strrchr(name, '/');
+	if (ext && (!slash || slash < ext)) {
+		ext++;
+		for (const auto& i : codecs) {
+			if (!strcasecmp(ext, i.ext))
+				return i.codec;
+		}
+	}
+	return COMPRESS_ZSTD;
+}
+
 #ifdef PATH_MAX
 #define MAX_OSPATH PATH_MAX
 #else
 #define MAX_OSPATH 256
 #endif
 
+/*
+* ReadChunkCompression: archives older than BFF_VERSION_CHUNK_COMPRESSION have one codec in the
+* header and no compressed size when that's COMPRESS_NONE
+*/
+static void ReadChunkCompression(FILE *fp, const bffheader_t *header, int64_t *compression, uint64_t *compressedSize, uint64_t size)
+{
+	if (header->version >= BFF_VERSION_CHUNK_COMPRESSION) {
+		SafeRead(fp, compression, sizeof(int64_t));
+	}
+	else {
+		*compression = header->compression;
+		if (*compression == COMPRESS_NONE) {
+			*compressedSize = size;
+			return;
+		}
+	}
+	SafeRead(fp, compressedSize, sizeof(uint64_t));
+}
+
 void DecompileBFF(const char *filepath)
 {
-	uint64_t offset, nameLen, size;
+	uint64_t offset, nameLen, size, compressedSize;
+	int64_t compression;
 	bffheader_t header;
 	char name[MAX_OSPATH];
 	char gameName[MAX_BFF_PATH];
@@ -169,15 +246,17 @@ void DecompileBFF(const char *filepath)
 		SafeRead(fp, &nameLen, sizeof(uint64_t));
 		SafeRead(fp, name, nameLen);
 		SafeRead(fp, &size, sizeof(int64_t));
+		ReadChunkCompression(fp, &header, &compression, &compressedSize, size);
 		Con_Printf(
 			"<-------- CHUNK %li -------->\n"
 			"size: %3.03f KiB\n"
+			"compressed: %3.03f KiB (%s)\n"
 			"name: %s\n"
 			"offset: %lu\n",
-		i, ((float)size / 1024), name, offset);
+		i, ((float)size / 1024), ((float)compressedSize / 1024), BFF_CompressionString(compression), name, offset);
 
 		offset = ftell(fp);
-		fseek(fp, offset + size, SEEK_SET);
+		fseek(fp, offset + compressedSize, SEEK_SET);
 	}
 	fclose(fp);
 }
@@ -189,7 +268,7 @@ static inline const char *bzip2_strerror(int err)
 	case BZ_DATA_ERROR: return "(BZ_DATA_ERROR) buffer provided to bzip2 was corrupted";
 	case BZ_MEM_ERROR: return "(BZ_MEM_ERROR) memory allocation request made by bzip2 failed";
 	case BZ_DATA_ERROR_MAGIC: return "(BZ_DATA_ERROR_MAGIC) buffer was not compressed with bzip2, it did not contain \"BZA\"";
-	case BZ_IO_ERROR: return va("(BZ_IO_ERROR) failure to read or write, file I/O error");
+	case BZ_IO_ERROR: return "(BZ_IO_ERROR) failure to read or write, file I/O error";
 	case BZ_UNEXPECTED_EOF: return "(BZ_UNEXPECTED_EOF) unexpected end of data stream";
 	case BZ_OUTBUFF_FULL: return "(BZ_OUTBUFF_FULL) buffer overflow";
 	case BZ_SEQUENCE_ERROR: return "(BZ_SEQUENCE_ERROR) bad function call error, please report this bug";
@@ -217,126 +296,78 @@ static inline void CheckBZIP2(int errcode, uint64_t buflen, const char *action)
 	case BZ_SEQUENCE_ERROR:
 	case BZ_OUTBUFF_FULL:
 	case BZ_UNEXPECTED_EOF:
-		Error("Failure on %s of %lu bytes. BZIP2 error reason:\n\t%s", action, buflen, bzip2_strerror(errcode));
+		BFF_Error("Failure on %s of %lu bytes. BZIP2 error reason:\n\t%s", action, buflen, bzip2_strerror(errcode));
 		break;
 	};
 }
 
+//
+// the codecs get called from the worker threads, so they stick to malloc and don't print anything,
+// WriteBFF reports every chunk once they're all done
+//
+
 static char *Compress_BZIP2(void *buf, uint64_t buflen, uint64_t *outlen)
 {
-#ifdef _WIN32
-	return NULL;
-#else
-	char *out, *newbuf;
+	char *out;
 	unsigned int len;
 	int ret;
 
-	Printf("Compressing %lu bytes with bzip2...", buflen);
-
-	len = buflen;
-	out = (char *)GetMemory(buflen);
-	ret = BZ2_bzBuffToBuffCompress(out, &len, (char *)buf, buflen, 9, 4, 50);
+	// worst case according to the bzip2 docs
+	len = buflen + buflen / 100 + 600;
+	out = (char *)SafeMalloc(len, "bzip2");
+	ret = BZ2_bzBuffToBuffCompress(out, &len, (char *)buf, buflen, 9, 0, 30);
 	CheckBZIP2(ret, buflen, "compression");
-
-	Printf("Successful compression of %lu to %u bytes with zlib", buflen, len);
-	newbuf = (char *)GetMemory(len);
-	memcpy(newbuf, out, len);
-	FreeMemory(out);
 	*outlen = len;
 
-	return newbuf;
-#endif
+	return out;
 }
 
-static inline const char *zlib_strerror(int err)
+static char *Compress_ZLIB(void *buf, uint64_t buflen, uint64_t *outlen)
 {
-	switch (err) {
-	case Z_DATA_ERROR: return "(Z_DATA_ERROR) buffer provided to zlib was corrupted";
-	case Z_BUF_ERROR: return "(Z_BUF_ERROR) buffer overflow";
-	case Z_STREAM_ERROR: return "(Z_STREAM_ERROR) bad params passed to zlib, please report this bug";
-	case Z_MEM_ERROR: return "(Z_MEM_ERROR) memory allocation request made by zlib failed";
-	case Z_OK:
-		break;
-	};
-	return "No Error... How?";
-}
+	char *out;
+	uLongf len;
+	int ret;
 
-static void *zalloc(voidpf opaque, uInt items, uInt size)
-{
-	(void)opaque;
-	(void)items;
-	return GetMemory(size);
+	len = compressBound(buflen);
+	out = (char *)SafeMalloc(len, "zlib");
+	ret = compress2((Bytef *)out, &len, (const Bytef *)buf, buflen, Z_BEST_COMPRESSION);
+	if (ret != Z_OK)
+		BFF_Error("Failure on compression of %lu bytes. ZLIB error reason:\n\t%s", buflen, zError(ret));
+	*outlen = len;
+
+	return out;
 }
 
-static void zfreeMemory(voidpf opaque, voidpf address)
+static char *Compress_ZSTD(void *buf, uint64_t buflen, uint64_t *outlen)
 {
-	(void)opaque;
-	FreeMemory((void *)address);
+	char *out;
+	size_t ret;
+
+	out = (char *)SafeMalloc(ZSTD_compressBound(buflen), "zstd");
+	ret = ZSTD_compress(out, ZSTD_compressBound(buflen), buf, buflen, 19);
+	if (ZSTD_isError(ret))
+		BFF_Error("Failure on compression of %lu bytes. ZSTD error reason:\n\t%s", buflen, ZSTD_getErrorName(ret));
+	*outlen = ret;
+
+	return out;
 }
 
-static char *Compress_ZLIB(void *buf, uint64_t buflen, uint64_t *outlen)
+static char *Compress_LZ4(void *buf, uint64_t buflen, uint64_t *outlen)
 {
-	char *out, *newbuf;
-	const uint64_t expectedLen = buflen / 2;
+	char *out;
 	int ret;
 
-	out = (char *)GetMemory(buflen);
-
-#if 0
-	stream.zalloc = zalloc;
-	stream.zfree = zfree;
-	stream.opaque = Z_NULL;
-	stream.next_in = (Bytef *)buf;
-	stream.avail_in = buflen;
-	stream.next_out = (Bytef *)out;
-	stream.avail_out = buflen;
-
-	ret = deflateInit2(&stream, Z_BEST_COMPRESSION, Z_DEFLATED, 15, 9, );
-	if (ret != Z_OK) {
-		Error("Failed to compress buffer of %lu bytes (inflateInit2)", buflen);
-		return NULL;
-	}
-	inflate
-
-	do {
-		ret = inflate(&stream, Z_SYNC_FLUSH);
-
-		switch (ret) {
-		case Z_NEED_DICT:
-		case Z_STREAM_ERROR:
-			ret = Z_DATA_ERROR;
-			break;
-		case Z_DATA_ERRO:
-		case Z_MEM_ERROR:
-			inflateEnd(&stream);
-			Error("Failed to compress buffer of %lu bytes (inflate)", buflen);
-			return NULL;
-		};
-		
-		if (ret != Z_STREAM_END) {
-			newbuf = (char *)Malloc(buflen * 2);
-			memcpy(newbuf, out, buflen * 2);
-			FreeMemory(out);
-			out = newbuf;
-
-			stream.next_out = (Bytef *)(out + buflen);
-			stream.avail_out = buflen;
-			buflen *= 2;
-		}
-	} while (ret != Z_STREAM_END);
-#endif
-	Printf("Compressing %lu bytes with zlib", buflen);
+	if (buflen > LZ4_MAX_INPUT_SIZE)
+		BFF_Error("Failure on compression of %lu bytes, LZ4 can't take more than %i", buflen, LZ4_MAX_INPUT_SIZE);
 
-	ret = compress2((Bytef *)out, (uLongf *)outlen, (const Bytef *)buf, buflen, Z_BEST_COMPRESSION);
-	if (ret != Z_OK)
-		Error("Failure on compression of %lu bytes. ZLIB error reason:\n\t%s", buflen, zError(ret));
-	
-	Printf("Successful compression of %lu to %lu bytes with zlib", buflen, *outlen);
-	newbuf = (char *)GetMemory(*outlen);
-	memcpy(newbuf, out, *outlen);
-	FreeMemory(out);
+	// the high compression mode only costs time here, decoding is just as fast
+	out = (char *)SafeMalloc(LZ4_compressBound(buflen), "lz4");
+	ret = LZ4_compress_HC((const char *)buf, out, buflen, LZ4_compressBound(buflen), LZ4HC_CLEVEL_MAX);
+	if (ret <= 0)
+		BFF_Error("Failure on compression of %lu bytes with LZ4", buflen);
+	*outlen = ret;
 
-	return newbuf;
+	return out;
 }
 
 char *Compress(void *buf, uint64_t buflen, uint64_t *outlen, int compression)
@@ -346,55 +377,78 @@ char *Compress(void *buf, uint64_t buflen, uint64_t *outlen, int compression)
 		return Compress_BZIP2(buf, buflen, outlen);
 	case COMPRESS_ZLIB:
 		return Compress_ZLIB(buf, buflen, outlen);
+	case COMPRESS_ZSTD:
+		return Compress_ZSTD(buf, buflen, outlen);
+	case COMPRESS_LZ4:
+		return Compress_LZ4(buf, buflen, outlen);
 	default:
 		break;
 	};
+	*outlen = buflen;
 	return (char *)buf;
 }
 
+//
+// *outlen has to be the uncompressed size going in, every archive stores it next to the compressed one
+//
+
 static char *Decompress_BZIP2(void *buf, uint64_t buflen, uint64_t *outlen)
 {
-#ifdef _WIN32
-	return NULL;
-#else
-	char *out, *newbuf;
+	char *out;
 	unsigned int len;
 	int ret;
 
-	Printf("Decompressing %lu bytes with bzip2", buflen);
-	len = buflen * 2;
-	out = (char *)GetMemory(buflen * 2);
-	ret = BZ2_bzBuffToBuffDecompress(out, &len, (char *)buf, buflen, 0, 4);
+	len = *outlen;
+	out = (char *)SafeMalloc(len, "bzip2");
+	ret = BZ2_bzBuffToBuffDecompress(out, &len, (char *)buf, buflen, 0, 0);
 	CheckBZIP2(ret, buflen, "decompression");
-
-	Printf("Successful decompression of %lu to %u bytes with bzip2", buflen, len);
-	newbuf = (char *)GetMemory(len);
-	memcpy(newbuf, out, len);
-	FreeMemory(out);
 	*outlen = len;
 
-	return newbuf;
-#endif
+	return out;
 }
 
 static char *Decompress_ZLIB(void *buf, uint64_t buflen, uint64_t *outlen)
 {
-	char *out, *newbuf;
+	char *out;
+	uLongf len;
 	int ret;
 
-	Printf("Decompressing %lu bytes with zlib...", buflen);
-	out = (char *)GetMemory(buflen * 2);
-	*outlen = buflen * 2;
-	ret = uncompress((Bytef *)out, (uLongf *)outlen, (const Bytef *)buf, buflen);
+	len = *outlen;
+	out = (char *)SafeMalloc(len, "zlib");
+	ret = uncompress((Bytef *)out, &len, (const Bytef *)buf, buflen);
 	if (ret != Z_OK)
-		Error("Failure on decompression of %lu bytes. ZLIB error reason:\n\t:%s", buflen * 2, zError(ret));
-	
-	Printf("Successful decompression of %lu bytes to %lu bytes with zlib", buflen, *outlen);
-	newbuf = (char *)GetMemory(*outlen);
-	memcpy(newbuf, out, *outlen);
-	FreeMemory(out);
+		BFF_Error("Failure on decompression of %lu bytes. ZLIB error reason:\n\t:%s", buflen, zError(ret));
+	*outlen = len;
+
+	return out;
+}
+
+static char *Decompress_ZSTD(void *buf, uint64_t buflen, uint64_t *outlen)
+{
+	char *out;
+	size_t ret;
+
+	out = (char *)SafeMalloc(*outlen, "zstd");
+	ret = ZSTD_decompress(out, *outlen, buf, buflen);
+	if (ZSTD_isError(ret))
+		BFF_Error("Failure on decompression of %lu bytes. ZSTD error reason:\n\t%s", buflen, ZSTD_getErrorName(ret));
+	*outlen = ret;
+
+	return out;
+}
 
-	return newbuf;
+static char *Decompress_LZ4(void *buf, uint64_t buflen, uint64_t *outlen)
+{
+	char *out;
+	int ret;
+
+	out = (char *)SafeMalloc(*outlen, "lz4");
+	ret = LZ4_decompress_safe((const char *)buf, out, buflen, *outlen);
+	if (ret < 0)
+		BFF_Error("Failure on decompression of %lu bytes with LZ4, the buffer is corrupted", buflen);
+	*outlen = ret;
+
+	return out;
 }
 
 char *Decompress(void *buf, uint64_t buflen, uint64_t *outlen, int compression)
@@ -404,8 +458,239 @@ char *Decompress(void *buf, uint64_t buflen, uint64_t *outlen, int compression)
 		return Decompress_BZIP2(buf, buflen, outlen);
 	case COMPRESS_ZLIB:
 		return Decompress_ZLIB(buf, buflen, outlen);
+	case COMPRESS_ZSTD:
+		return Decompress_ZSTD(buf, buflen, outlen);
+	case COMPRESS_LZ4:
+		return Decompress_LZ4(buf, buflen, outlen);
 	default:
 		break;
 	};
+	*outlen = buflen;
 	return (char *)buf;
 }
+
+int bff_numThreads;
+
+void BFF_ParallelFor(uint64_t count, const std::function<void(uint64_t)>& func)
+{
+	std::vector<std::thread> workers;
+	std::atomic<uint64_t> next(0);
+	int numThreads;
+
+	numThreads = bff_numThreads > 0 ? bff_numThreads : (int)std::thread::hardware_concurrency();
+	if (numThreads < 1)
+		numThreads = 1;
+	if ((uint64_t)numThreads > count)
+		numThreads = count;
+
+	// chunks are handed out one at a time, the big ones would leave threads idle with fixed ranges
+	const auto worker = [&]() {
+		uint64_t i;
+		while ((i = next.fetch_add(1)) < count) {
+			func(i);
+		}
+	};
+	for (int i = 1; i < numThreads; i++) {
+		workers.emplace_back(worker);
+	}
+	worker();
+	for (auto& i : workers) {
+		i.join();
+	}
+}
+
+/*
+* TestBFF: decompresses every chunk in the archive and checks it against its recorded size
+*/
+void TestBFF(const char *filepath)
+{
+	bffheader_t header;
+	char name[MAX_OSPATH];
+	char gameName[MAX_BFF_PATH];
+	uint64_t nameLen, size, compressedSize, outlen;
+	int64_t compression;
+	char *buf, *out;
+	int64_t failed;
+	FILE *fp;
+
+	fp = SafeOpen(filepath, "rb");
+
+	SafeRead(fp, &header, sizeof(bffheader_t));
+	if (header.ident != BFF_IDENT || header.magic != HEADER_MAGIC) {
+		BFF_Error("TestBFF: file isn't a bff archive");
+	}
+	SafeRead(fp, gameName, sizeof(gameName));
+
+	failed = 0;
+	for (int64_t i = 0; i < header.numChunks; i++) {
+		SafeRead(fp, &nameLen, sizeof(uint64_t));
+		if (nameLen > sizeof(name)) {
+			BFF_Error("TestBFF: chunk %li has a name length of %lu, the archive is corrupted", i, nameLen);
+		}
+		SafeRead(fp, name, nameLen);
+		SafeRead(fp, &size, sizeof(int64_t));
+		ReadChunkCompression(fp, &header, &compression, &compressedSize, size);
+
+		buf = (char *)SafeMalloc(compressedSize ? compressedSize : 1, "chunk");
+		if (compressedSize) {
+			SafeRead(fp, buf, compressedSize);
+		}
+
+		outlen = size;
+		out = Decompress(buf, compressedSize, &outlen, compression);
+		if (outlen != size) {
+			Con_Printf("FAILED: %s (%s) decompressed to %lu bytes, expected %lu", name, BFF_CompressionString(compression), outlen, size);
+			failed++;
+		}
+		if (out != buf) {
+			free(out);
+		}
+		free(buf);
+	}
+	fclose(fp);
+
+	Con_Printf("%s: %li of %li chunks ok", filepath, header.numChunks - failed, header.numChunks);
+	if (failed) {
+		exit(EXIT_FAILURE);
+	}
+}
+
+static const int bff_codecs[] = { COMPRESS_ZLIB, COMPRESS_BZIP2, COMPRESS_ZSTD, COMPRESS_LZ4 };
+
+/*
+* MakeTestBuffers: the kinds of data that go into an archive, text that compresses well, pixels that
+* compress somewhat and noise that doesn't compress at all, in sizes from a byte up to a few megs
+*/
+static std::vector<std::vector<char>> MakeTestBuffers(void)
+{
+	static const char *words[] = { "void ", "int ", "return ", "if ( ", " ) {\n", "}\n", "TheNomad::", "float ", "m_", "const " };
+	static const uint64_t sizes[] = { 1, 17, 4096, 65537, 3 * 1024 * 1024 + 11 };
+	std::vector<std::vector<char>> buffers;
+	uint32_t seed;
+
+	seed = 0x5f3759df;
+	for (const auto& size : sizes) {
+		std::vector<char> text, pixels, noise;
+
+		while (text.size() < size) {
+			seed = seed * 1664525 + 1013904223;
+			const char *word = words[(seed >> 16) % (sizeof(words) / sizeof(*words))];
+			text.insert(text.end(), word, word + strlen(word));
+		}
+		text.resize(size);
+
+		pixels.resize(size);
+		for (uint64_t i = 0; i < size; i++) {
+			seed = seed * 1664525 + 1013904223;
+			pixels[i] = (char)((i / 4) % 64 + ((seed >> 24) & 3));
+		}
+
+		noise.resize(size);
+		for (uint64_t i = 0; i < size; i++) {
+			seed = seed * 1664525 + 1013904223;
+			noise[i] = (char)(seed >> 24);
+		}
+
+		buffers.emplace_back(std::move(text));
+		buffers.emplace_back(std::move(pixels));
+		buffers.emplace_back(std::move(noise));
+	}
+	return buffers;
+}
+
+/*
+* TestCodecs: round trips every codec through the same buffers the writer and the engine would see
+*/
+void TestCodecs(void)
+{
+	const std::vector<std::vector<char>> buffers = MakeTestBuffers();
+	int failed, total;
+
+	failed = total = 0;
+	for (const auto& codec : bff_codecs) {
+		for (const auto& buffer : buffers) {
+			uint64_t packedLen, outlen;
+			char *packed, *out;
+
+			packed = Compress((void *)buffer.data(), buffer.size(), &packedLen, codec);
+			outlen = buffer.size();
+			out = Decompress(packed, packedLen, &outlen, codec);
+
+			total++;
+			if (outlen != buffer.size() || memcmp(out, buffer.data(), outlen)) {
+				Con_Printf("FAILED: %s round trip of %lu bytes", BFF_CompressionString(codec), buffer.size());
+				failed++;
+			}
+			free(out);
+			free(packed);
+		}
+	}
+
+	Con_Printf("codec round trips: %i of %i ok", total - failed, total);
+	if (failed) {
+		exit(EXIT_FAILURE);
+	}
+}
+
+/*
+* BenchCodecs: pack and unpack throughput of every codec over the given files, or the test
+* buffers if there aren't any, using as many threads as WriteBFF would
+*/
+void BenchCodecs(const char **files, int numFiles)
+{
+	std::vector<std::vector<char>> buffers;
+	uint64_t totalSize;
+
+	if (numFiles) {
+		for (int i = 0; i < numFiles; i++) {
+			FILE *fp;
+			void *data;
+			int64_t length;
+
+			fp = SafeOpen(files[i], "rb");
+			LoadFile(fp, &data, &length);
+			fclose(fp);
+
+			buffers.emplace_back((char *)data, (char *)data + length);
+			free(data);
+		}
+	} else {
+		buffers = MakeTestBuffers();
+	}
+
+	totalSize = 0;
+	for (const auto& buffer : buffers) {
+		totalSize += buffer.size();
+	}
+
+	Con_Printf("%lu buffers, %.02f MiB, %i threads", buffers.size(), (double)totalSize / (1024 * 1024),
+		bff_numThreads > 0 ? bff_numThreads : (int)std::thread::hardware_concurrency());
+	Con_Printf("codec   ratio    pack MiB/s   unpack MiB/s");
+	for (const auto& codec : bff_codecs) {
+		std::vector<char *> packed(buffers.size());
+		std::vector<uint64_t> packedLen(buffers.size());
+		std::atomic<uint64_t> totalPacked(0);
+
+		const auto packStart = std::chrono::steady_clock::now();
+		BFF_ParallelFor(buffers.size(), [&](uint64_t i) {
+			packed[i] = Compress((void *)buffers[i].data(), buffers[i].size(), &packedLen[i], codec);
+			totalPacked += packedLen[i];
+		});
+		const auto packEnd = std::chrono::steady_clock::now();
+
+		BFF_ParallelFor(buffers.size(), [&](uint64_t i) {
+			uint64_t outlen = buffers[i].size();
+			free(Decompress(packed[i], packedLen[i], &outlen, codec));
+		});
+		const auto unpackEnd = std::chrono::steady_clock::now();
+
+		const double packSeconds = std::chrono::duration<double>(packEnd - packStart).count();
+		const double unpackSeconds = std::chrono::duration<double>(unpackEnd - packEnd).count();
+		Con_Printf("%-6s %6.02f%%  %11.02f  %13.02f", BFF_CompressionString(codec), 100.0 * totalPacked / totalSize,
+			totalSize / (1024.0 * 1024.0) / packSeconds, totalSize / (1024.0 * 1024.0) / unpackSeconds);
+
+		for (auto& i : packed) {
+			free(i);
+		}
+	}
+}
@@ -0,0 +1,42 @@
+#ifndef _BFF_COMPRESS_
+#define _BFF_COMPRESS_
+
+#pragma once
+
+#include <stdint.h>
+#include <functional>
+
+//
+// chunk codecs, the ids are written into the archive so they have to stay in sync
+// with the COMPRESS_* defines in code/engine/n_common.h
+//
+#ifndef COMPRESS_NONE
+#define COMPRESS_NONE 0
+#define COMPRESS_ZLIB 1
+#define COMPRESS_BZIP2 2
+#endif
+#define COMPRESS_ZSTD 5
+#define COMPRESS_LZ4 6
+
+// not a codec, picks one for each chunk with BFF_CodecForFile
+#define COMPRESS_AUTO -1
+
+// from here on every chunk stores its own codec and compressed size, same as BFF_VERSION_CHUNK_COMPRESSION in the engine
+#define BFF_VERSION_CHUNK_COMPRESSION ((0<<8)+2)
+
+// all of these are safe to call from the worker threads, the returned buffers come from malloc
+char *Compress(void *buf, uint64_t buflen, uint64_t *outlen, int compression);
+char *Decompress(void *buf, uint64_t buflen, uint64_t *outlen, int compression);
+const char *BFF_CompressionString(int compression);
+int BFF_CompressionFromString(const char *name);
+int BFF_CodecForFile(const char *name);
+
+// runs func for every index in [0, count) across bff_numThreads threads
+void BFF_ParallelFor(uint64_t count, const std::function<void(uint64_t)>& func);
+extern int bff_numThreads;
+
+void TestBFF(const char *filepath);
+void TestCodecs(void);
+void BenchCodecs(const char **files, int numFiles);
+
+#endif
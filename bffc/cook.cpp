@@ -0,0 +1,1394 @@
+#include "../bff_file/g_bff.h"
+#include "compress.h"
+#include "cook.h"
+#include <math.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// the same loaders R_LoadImage has
+#define STB_IMAGE_IMPLEMENTATION
+#define STBI_ONLY_PNG
+#define STBI_ONLY_TGA
+#define STBI_ONLY_JPEG
+#define STBI_ONLY_BMP
+#include "../code/rendergl/stb_image.h"
+
+int bff_cookFormat = COOK_NONE;
+const char *bff_cookCache = COOK_DEFAULT_CACHE;
+
+// same layout as ddsHeader_t in code/rendergl/rgl_image_dds.c
+typedef struct {
+	uint32_t headerSize;
+	uint32_t flags;
+	uint32_t height;
+	uint32_t width;
+	uint32_t pitchOrFirstMipSize;
+	uint32_t volumeDepth;
+	uint32_t numMips;
+	uint32_t reserved1[11];
+	uint32_t always_0x00000020;
+	uint32_t pixelFormatFlags;
+	uint32_t fourCC;
+	uint32_t rgbBitCount;
+	uint32_t rBitMask;
+	uint32_t gBitMask;
+	uint32_t bBitMask;
+	uint32_t aBitMask;
+	uint32_t caps;
+	uint32_t caps2;
+	uint32_t caps3;
+	uint32_t caps4;
+	uint32_t reserved2;
+} ddsHeader_t;
+
+typedef struct {
+	uint32_t dxgiFormat;
+	uint32_t dimensions;
+	uint32_t miscFlags;
+	uint32_t arraySize;
+	uint32_t miscFlags2;
+} ddsHeaderDxt10_t;
+
+#define DDSFLAGS_REQUIRED 0x001007
+#define DDSFLAGS_PITCH 0x8
+#define DDSFLAGS_MIPMAPCOUNT 0x20000
+#define DDSFLAGS_LINEARSIZE 0x80000
+
+#define DDSPF_ALPHAPIXELS 0x1
+#define DDSPF_FOURCC 0x4
+#define DDSPF_RGB 0x40
+
+#define DDSCAPS_COMPLEX 0x8
+#define DDSCAPS_MIPMAP 0x400000
+#define DDSCAPS_REQUIRED 0x1000
+
+#define DXGI_FORMAT_BC7_UNORM 98
+#define DDS_DIMENSION_TEXTURE2D 3
+
+#define EncodeFourCC(x) ((((uint32_t)((x)[0]))      ) | \
+                         (((uint32_t)((x)[1])) << 8 ) | \
+                         (((uint32_t)((x)[2])) << 16) | \
+                         (((uint32_t)((x)[3])) << 24) )
+
+static const struct {
+	const char *name;
+	int format;
+} cookFormats[] = {
+	{ "rgba", COOK_RGBA }, { "bc1", COOK_BC1 }, { "bc3", COOK_BC3 }, { "bc7", COOK_BC7 }, { "auto", COOK_AUTO },
+};
+
+const char *BFF_CookFormatString(int format)
+{
+	for (const auto& i : cookFormats) {
+		if (i.format == format)
+			return i.name;
+	}
+	return "none";
+}
+
+int BFF_CookFormatFromString(const char *name)
+{
+	for (const auto& i : cookFormats) {
+		if (!strcasecmp(name, i.name))
+			return i.format;
+	}
+	return COOK_NONE;
+}
+
+static const char *GetExtension(const char *name)
+{
+	const char *ext, *slash;
+
+	ext = strrchr(name, '.');
+	slash = strrchr(name, '/');
+	if (ext && (!slash || slash < ext))
+		return ext + 1;
+	return "";
+}
+
+bool BFF_IsCookable(const char *name)
+{
+	static const char *exts[] = { "png", "tga", "jpg", "jpeg", "bmp" };
+	const char *ext;
+
+	ext = GetExtension(name);
+	for (const auto& i : exts) {
+		if (!strcasecmp(ext, i))
+			return true;
+	}
+	return false;
+}
+
+// the renderer looks for NAME_n next to a texture to find its normal map
+static bool IsNormalMap(const char *name)
+{
+	const char *ext;
+
+	ext = GetExtension(name);
+	if (*ext)
+		ext--;
+	else
+		ext = name + strlen(name);
+	return ext - name >= 2 && ext[-2] == '_' && ext[-1] == 'n';
+}
+
+static bool IsPowerOfTwo(int n)
+{
+	return n > 0 && !(n & (n - 1));
+}
+
+/*
+===============================================================================
+
+MIP CHAIN
+
+===============================================================================
+*/
+
+static const float *SrgbLookup(void)
+{
+	static float lookup[256];
+	static std::once_flag once;
+
+	std::call_once(once, [] {
+		for (int x = 0; x < 256; x++)
+			lookup[x] = powf(x / 255.0f, 2.2f) * 0.25f;
+	});
+	return lookup;
+}
+
+/*
+* MipColor: one level of R_MipMapsRGB, colors are averaged in linear space and alpha as is. It has to come
+* out with the exact bytes the renderer would make, TestCook holds it against a copy of the original
+*/
+static void MipColor(const uint8_t *in, uint8_t *out, int width, int height)
+{
+	const float *lookup = SrgbLookup();
+	const uint8_t *in2;
+	float total;
+	int x, y, c;
+
+	if (width == 1 || height == 1) {
+		for (x = (width * height) >> 1; x; x--, in += 8) {
+			for (c = 0; c < 3; c++) {
+				total = (lookup[in[c]] + lookup[in[c + 4]]) * 2.0f;
+				*out++ = (uint8_t)(powf(total, 1.0f / 2.2f) * 255.0f);
+			}
+			*out++ = (in[3] + in[7]) >> 1;
+		}
+		return;
+	}
+
+
+	for (y = height >> 1; y; y--, in += width * 4) {
+		in2 = in + width * 4;
+		for (x = width >> 1; x; x--, in += 8, in2 += 8) {
+			for (c = 0; c < 3; c++) {
+				total = lookup[in[c]] + lookup[in[c + 4]] + lookup[in2[c]] + lookup[in2[c + 4]];
+				*out++ = (uint8_t)(powf(total, 1.0f / 2.2f) * 255.0f);
+			}
+			*out++ = (in[3] + in[7] + in2[3] + in2[7]) >> 2;
+		}
+	}
+}
+
+// Q_rsqrt without the sse path, rsqrtss doesn't give the same answer on every cpu
+static float Cook_rsqrt(float number)
+{
+	union {
+		float f;
+		int32_t i;
+	} t;
+	float x2;
+
+	x2 = number * 0.5f;
+	t.f = number;
+	t.i = 0x5f3759df - (t.i >> 1);
+	t.f = t.f * (1.5f - (x2 * t.f * t.f));
+	return t.f;
+}
+
+#define OffsetByteToFloat(a) ((float)(a) * 1.0f/127.5f - 1.0f)
+#define FloatToOffsetByte(a) (uint8_t)((a) * 127.5f + 128.0f)
+
+/*
+* MipNormal: R_MipMapNormalHeight, the vectors are summed and renormalized and the height keeps its peak. The
+* renderer's version skips levels that are a single pixel wide, this one samples the edge twice instead
+*/
+static void MipNormal(const uint8_t *in, uint8_t *out, int width, int height)
+{
+	const int outWidth = std::max(1, width >> 1);
+	const int outHeight = std::max(1, height >> 1);
+	const uint8_t *p[4];
+	float v[3], ilength;
+	int x, y, c, x1, y1;
+
+	for (y = 0; y < outHeight; y++) {
+		for (x = 0; x < outWidth; x++, out += 4) {
+			x1 = std::min(x * 2 + 1, width - 1);
+			y1 = std::min(y * 2 + 1, height - 1);
+			p[0] = in + ((uint64_t)(y * 2) * width + x * 2) * 4;
+			p[1] = in + ((uint64_t)(y * 2) * width + x1) * 4;
+			p[2] = in + ((uint64_t)y1 * width + x * 2) * 4;
+			p[3] = in + ((uint64_t)y1 * width + x1) * 4;
+
+			for (c = 0; c < 3; c++) {
+				v[c] = OffsetByteToFloat(p[0][c]) + OffsetByteToFloat(p[1][c]) + OffsetByteToFloat(p[2][c])
+					+ OffsetByteToFloat(p[3][c]);
+			}
+			ilength = Cook_rsqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+			for (c = 0; c < 3; c++) {
+				out[c] = FloatToOffsetByte(v[c] * ilength);
+			}
+			out[3] = std::max(std::max(p[0][3], p[1][3]), std::max(p[2][3], p[3][3]));
+		}
+	}
+}
+
+/*
+* BuildMipChain: every level down to 1x1 one after another, same as R_BuildMipChain non power of two images
+* only get the first level and the driver makes the rest
+*/
+static int BuildMipChain(const uint8_t *pic, int width, int height, bool normalMap, std::vector<uint8_t>& chain)
+{
+	uint64_t offset, size;
+	int numMips, w, h;
+
+	chain.assign(pic, pic + (uint64_t)width * height * 4);
+	if (!IsPowerOfTwo(width) || !IsPowerOfTwo(height)) {
+		return 1;
+	}
+
+	numMips = 1;
+	offset = 0;
+	while (width > 1 || height > 1) {
+		w = std::max(1, width >> 1);
+		h = std::max(1, height >> 1);
+		size = (uint64_t)width * height * 4;
+		chain.resize(offset + size + (uint64_t)w * h * 4);
+		if (normalMap) {
+			MipNormal(chain.data() + offset, chain.data() + offset + size, width, height);
+		} else {
+			MipColor(chain.data() + offset, chain.data() + offset + size, width, height);
+		}
+		offset += size;
+		width = w;
+		height = h;
+		numMips++;
+	}
+	return numMips;
+}
+
+/*
+===============================================================================
+
+BLOCK COMPRESSION
+
+===============================================================================
+*/
+
+// blocks hanging off the edge of a small mip repeat the last row and column
+static void FetchBlock(const uint8_t *pic, int width, int height, int bx, int by, uint8_t block[16][4])
+{
+	int x, y;
+
+	for (y = 0; y < 4; y++) {
+		for (x = 0; x < 4; x++) {
+			const int sx = std::min(bx * 4 + x, width - 1);
+			const int sy = std::min(by * 4 + y, height - 1);
+			memcpy(block[y * 4 + x], pic + ((uint64_t)sy * width + sx) * 4, 4);
+		}
+	}
+}
+
+/*
+* BlockEndpoints: fits a line through the block's colors with a few rounds of power iteration on their covariance
+* and returns where the pixels start and end along it
+*/
+static void BlockEndpoints(const uint8_t block[16][4], int channels, float lo[4], float hi[4])
+{
+	float mean[4], axis[4], next[4], cov[4][4];
+	float t, tmin, tmax, scale;
+	int i, j, c, iter;
+
+	for (c = 0; c < channels; c++) {
+		mean[c] = 0.0f;
+		for (i = 0; i < 16; i++)
+			mean[c] += block[i][c];
+		mean[c] /= 16.0f;
+	}
+
+	for (i = 0; i < channels; i++) {
+		for (j = 0; j < channels; j++) {
+			cov[i][j] = 0.0f;
+			for (c = 0; c < 16; c++)
+				cov[i][j] += (block[c][i] - mean[i]) * (block[c][j] - mean[j]);
+		}
+	}
+
+	for (c = 0; c < channels; c++)
+		axis[c] = 1.0f;
+	for (iter = 0; iter < 8; iter++) {
+		scale = 0.0f;
+		for (i = 0; i < channels; i++) {
+			next[i] = 0.0f;
+			for (j = 0; j < channels; j++)
+				next[i] += cov[i][j] * axis[j];
+			scale = std::max(scale, fabsf(next[i]));
+		}
+		// a flat block, any direction will do
+		if (scale == 0.0f)
+			break;
+		for (i = 0; i < channels; i++)
+			axis[i] = next[i] / scale;
+	}
+
+	scale = 0.0f;
+	for (c = 0; c < channels; c++)
+		scale += axis[c] * axis[c];
+	scale = 1.0f / sqrtf(scale);
+	for (c = 0; c < channels; c++)
+		axis[c] *= scale;
+
+	tmin = tmax = 0.0f;
+	for (i = 0; i < 16; i++) {
+		t = 0.0f;
+		for (c = 0; c < channels; c++)
+			t += (block[i][c] - mean[c]) * axis[c];
+		tmin = std::min(tmin, t);
+		tmax = std::max(tmax, t);
+	}
+
+	for (c = 0; c < channels; c++) {
+		lo[c] = std::clamp(mean[c] + tmin * axis[c], 0.0f, 255.0f);
+		hi[c] = std::clamp(mean[c] + tmax * axis[c], 0.0f, 255.0f);
+	}
+}
+
+static uint16_t To565(const float c[3])
+{
+	return ((uint16_t)(c[0] * 31.0f / 255.0f + 0.5f) << 11) | ((uint16_t)(c[1] * 63.0f / 255.0f + 0.5f) << 5)
+		| (uint16_t)(c[2] * 31.0f / 255.0f + 0.5f);
+}
+
+static void From565(uint16_t c, int out[3])
+{
+	out[0] = (c >> 11) & 31;
+	out[1] = (c >> 5) & 63;
+	out[2] = c & 31;
+	out[0] = (out[0] << 3) | (out[0] >> 2);
+	out[1] = (out[1] << 2) | (out[1] >> 4);
+	out[2] = (out[2] << 3) | (out[2] >> 2);
+}
+
+static void ColorPalette(uint16_t c0, uint16_t c1, int palette[4][3])
+{
+	int c;
+
+	From565(c0, palette[0]);
+	From565(c1, palette[1]);
+	for (c = 0; c < 3; c++) {
+		palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+		palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+	}
+}
+
+/*
+* EncodeColorBlock: the bc1 half of a block, always in four color mode so the same block works for bc3
+*/
+static void EncodeColorBlock(const uint8_t block[16][4], uint8_t *out)
+{
+	float lo[4], hi[4];
+	int palette[4][3];
+	uint32_t indices;
+	uint16_t c0, c1;
+	int i, j, c, d, dist, best, bestDist;
+
+	BlockEndpoints(block, 3, lo, hi);
+	c0 = To565(hi);
+	c1 = To565(lo);
+	if (c0 < c1) {
+		std::swap(c0, c1);
+	}
+
+	indices = 0;
+	if (c0 != c1) {
+		ColorPalette(c0, c1, palette);
+		for (i = 0; i < 16; i++) {
+			best = 0;
+			bestDist = INT32_MAX;
+			for (j = 0; j < 4; j++) {
+				dist = 0;
+				for (c = 0; c < 3; c++) {
+					d = block[i][c] - palette[j][c];
+					dist += d * d;
+				}
+				if (dist < bestDist) {
+					bestDist = dist;
+					best = j;
+				}
+			}
+			indices |= (uint32_t)best << (i * 2);
+		}
+	}
+
+	out[0] = c0 & 0xff;
+	out[1] = c0 >> 8;
+	out[2] = c1 & 0xff;
+	out[3] = c1 >> 8;
+	for (i = 0; i < 4; i++)
+		out[4 + i] = (indices >> (i * 8)) & 0xff;
+}
+
+static void AlphaPalette(int a0, int a1, int palette[8])
+{
+	int i;
+
+	palette[0] = a0;
+	palette[1] = a1;
+	if (a0 > a1) {
+		for (i = 2; i < 8; i++)
+			palette[i] = ((8 - i) * a0 + (i - 1) * a1) / 7;
+	} else {
+		for (i = 2; i < 6; i++)
+			palette[i] = ((6 - i) * a0 + (i - 1) * a1) / 5;
+		palette[6] = 0;
+		palette[7] = 255;
+	}
+}
+
+/*
+* EncodeAlphaBlock: the bc3 alpha half, the block's extremes as the endpoints and the eight step ramp between them
+*/
+static void EncodeAlphaBlock(const uint8_t block[16][4], uint8_t *out)
+{
+	int palette[8];
+	uint64_t indices;
+	int i, j, a0, a1, dist, best, bestDist;
+
+	a0 = 0;
+	a1 = 255;
+	for (i = 0; i < 16; i++) {
+		a0 = std::max(a0, (int)block[i][3]);
+		a1 = std::min(a1, (int)block[i][3]);
+	}
+
+	indices = 0;
+	if (a0 != a1) {
+		AlphaPalette(a0, a1, palette);
+		for (i = 0; i < 16; i++) {
+			best = 0;
+			bestDist = INT32_MAX;
+			for (j = 0; j < 8; j++) {
+				dist = abs(block[i][3] - palette[j]);
+				if (dist < bestDist) {
+					bestDist = dist;
+					best = j;
+				}
+			}
+			indices |= (uint64_t)best << (i * 3);
+		}
+	}
+
+	out[0] = a0;
+	out[1] = a1;
+	for (i = 0; i < 6; i++)
+		out[2 + i] = (indices >> (i * 8)) & 0xff;
+}
+
+static const int bc7Weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+static void PutBits(uint8_t *out, int *bit, uint32_t value, int count)
+{
+	int i;
+
+	for (i = 0; i < count; i++, (*bit)++) {
+		if ((value >> i) & 1)
+			out[*bit >> 3] |= 1 << (*bit & 7);
+	}
+}
+
+/*
+* QuantizeBC7Endpoint: mode 6 endpoints are 7 bits a channel plus a p-bit shared by all four, pick the
+* p-bit that lands closer
+*/
+static void QuantizeBC7Endpoint(const float color[4], int out[4], int *pbit)
+{
+	int p, c, v, err, bestErr;
+	int q[4];
+
+	bestErr = INT32_MAX;
+	for (p = 0; p < 2; p++) {
+		err = 0;
+		for (c = 0; c < 4; c++) {
+			q[c] = std::clamp((int)((color[c] - p) / 2.0f + 0.5f), 0, 127);
+			v = (q[c] << 1) | p;
+			err += (v - (int)(color[c] + 0.5f)) * (v - (int)(color[c] + 0.5f));
+		}
+		if (err < bestErr) {
+			bestErr = err;
+			*pbit = p;
+			memcpy(out, q, sizeof(q));
+		}
+	}
+}
+
+/*
+* EncodeBC7Block: mode 6 only, one subset with rgba endpoints and sixteen steps between them, it's the mode
+* that does best on smooth color and alpha and doesn't need a partition search
+*/
+static void EncodeBC7Block(const uint8_t block[16][4], uint8_t *out)
+{
+	float lo[4], hi[4];
+	int endpoints[2][4], pbits[2], expanded[2][4];
+	int indices[16];
+	int i, j, c, d, v, dist, best, bestDist;
+	int bit;
+
+	BlockEndpoints(block, 4, lo, hi);
+	QuantizeBC7Endpoint(lo, endpoints[0], &pbits[0]);
+	QuantizeBC7Endpoint(hi, endpoints[1], &pbits[1]);
+	for (i = 0; i < 2; i++) {
+		for (c = 0; c < 4; c++)
+			expanded[i][c] = (endpoints[i][c] << 1) | pbits[i];
+	}
+
+	for (i = 0; i < 16; i++) {
+		best = 0;
+		bestDist = INT32_MAX;
+		for (j = 0; j < 16; j++) {
+			dist = 0;
+			for (c = 0; c < 4; c++) {
+				v = ((64 - bc7Weights[j]) * expanded[0][c] + bc7Weights[j] * expanded[1][c] + 32) >> 6;
+				d = block[i][c] - v;
+				dist += d * d;
+			}
+			if (dist < bestDist) {
+				bestDist = dist;
+				best = j;
+			}
+		}
+		indices[i] = best;
+	}
+
+	// the first pixel's index only gets three bits, so its top bit has to be clear, the weights are
+	// symmetric so swapping the endpoints and flipping the indices gives the same colors
+	if (indices[0] & 8) {
+		for (c = 0; c < 4; c++)
+			std::swap(endpoints[0][c], endpoints[1][c]);
+		std::swap(pbits[0], pbits[1]);
+		for (i = 0; i < 16; i++)
+			indices[i] = 15 - indices[i];
+	}
+
+	memset(out, 0, 16);
+	bit = 0;
+	PutBits(out, &bit, 1 << 6, 7);
+	for (c = 0; c < 4; c++) {
+		PutBits(out, &bit, endpoints[0][c], 7);
+		PutBits(out, &bit, endpoints[1][c], 7);
+	}
+	PutBits(out, &bit, pbits[0], 1);
+	PutBits(out, &bit, pbits[1], 1);
+	PutBits(out, &bit, indices[0], 3);
+	for (i = 1; i < 16; i++)
+		PutBits(out, &bit, indices[i], 4);
+}
+
+static uint64_t LevelSize(int width, int height, int format)
+{
+	const uint64_t numBlocks = (uint64_t)((width + 3) / 4) * ((height + 3) / 4);
+
+	switch (format) {
+	case COOK_BC1:
+		return numBlocks * 8;
+	case COOK_BC3:
+	case COOK_BC7:
+		return numBlocks * 16;
+	default:
+		return (uint64_t)width * height * 4;
+	};
+}
+
+static void EncodeLevel(const uint8_t *pic, int width, int height, int format, uint8_t *out)
+{
+	uint8_t block[16][4];
+	int bx, by;
+
+	if (format == COOK_RGBA) {
+		memcpy(out, pic, (uint64_t)width * height * 4);
+		return;
+	}
+
+	for (by = 0; by < (height + 3) / 4; by++) {
+		for (bx = 0; bx < (width + 3) / 4; bx++) {
+			FetchBlock(pic, width, height, bx, by, block);
+			switch (format) {
+			case COOK_BC1:
+				EncodeColorBlock(block, out);
+				out += 8;
+				break;
+			case COOK_BC3:
+				EncodeAlphaBlock(block, out);
+				EncodeColorBlock(block, out + 8);
+				out += 16;
+				break;
+			case COOK_BC7:
+				EncodeBC7Block(block, out);
+				out += 16;
+				break;
+			};
+		}
+	}
+}
+
+/*
+===============================================================================
+
+DDS OUTPUT
+
+===============================================================================
+*/
+
+static uint64_t DDSHeaderSize(int format)
+{
+	return 4 + sizeof(ddsHeader_t) + (format == COOK_BC7 ? sizeof(ddsHeaderDxt10_t) : 0);
+}
+
+/*
+* WriteDDS: bc1 and bc3 go out as the old DXT1/DXT5 fourccs and rgba with the bit masks R_LoadDDS checks
+* for, bc7 only exists with a dx10 header
+*/
+static char *WriteDDS(const std::vector<uint8_t>& chain, int width, int height, int numMips, int format, uint64_t *outlen)
+{
+	ddsHeader_t header;
+	ddsHeaderDxt10_t dxt10;
+	uint64_t size, offset;
+	uint8_t *data;
+	char *out;
+	int i, w, h;
+
+	size = 0;
+	for (i = 0, w = width, h = height; i < numMips; i++) {
+		size += LevelSize(w, h, format);
+		w = std::max(1, w >> 1);
+		h = std::max(1, h >> 1);
+	}
+
+	memset(&header, 0, sizeof(header));
+	header.headerSize = sizeof(header);
+	header.flags = DDSFLAGS_REQUIRED | DDSFLAGS_MIPMAPCOUNT | (format == COOK_RGBA ? DDSFLAGS_PITCH : DDSFLAGS_LINEARSIZE);
+	header.width = width;
+	header.height = height;
+	header.pitchOrFirstMipSize = format == COOK_RGBA ? width * 4 : LevelSize(width, height, format);
+	header.numMips = numMips;
+	header.always_0x00000020 = 0x00000020;
+	header.caps = DDSCAPS_REQUIRED | (numMips > 1 ? DDSCAPS_COMPLEX | DDSCAPS_MIPMAP : 0);
+
+	switch (format) {
+	case COOK_RGBA:
+		header.pixelFormatFlags = DDSPF_RGB | DDSPF_ALPHAPIXELS;
+		header.rgbBitCount = 32;
+		header.rBitMask = 0x000000ff;
+		header.gBitMask = 0x0000ff00;
+		header.bBitMask = 0x00ff0000;
+		header.aBitMask = 0xff000000;
+		break;
+	case COOK_BC1:
+		header.pixelFormatFlags = DDSPF_FOURCC;
+		header.fourCC = EncodeFourCC("DXT1");
+		break;
+	case COOK_BC3:
+		header.pixelFormatFlags = DDSPF_FOURCC;
+		header.fourCC = EncodeFourCC("DXT5");
+		break;
+	case COOK_BC7:
+		header.pixelFormatFlags = DDSPF_FOURCC;
+		header.fourCC = EncodeFourCC("DX10");
+		break;
+	};
+
+	*outlen = DDSHeaderSize(format) + size;
+	out = (char *)SafeMalloc(*outlen, "dds");
+
+	memcpy(out, "DDS ", 4);
+	memcpy(out + 4, &header, sizeof(header));
+	if (format == COOK_BC7) {
+		memset(&dxt10, 0, sizeof(dxt10));
+		dxt10.dxgiFormat = DXGI_FORMAT_BC7_UNORM;
+		dxt10.dimensions = DDS_DIMENSION_TEXTURE2D;
+		dxt10.arraySize = 1;
+		memcpy(out + 4 + sizeof(header), &dxt10, sizeof(dxt10));
+	}
+
+	data = (uint8_t *)out + DDSHeaderSize(format);
+	offset = 0;
+	for (i = 0, w = width, h = height; i < numMips; i++) {
+		EncodeLevel(chain.data() + offset, w, h, format, data);
+		data += LevelSize(w, h, format);
+		offset += (uint64_t)w * h * 4;
+		w = std::max(1, w >> 1);
+		h = std::max(1, h >> 1);
+	}
+
+	return out;
+}
+
+static bool HasAlpha(const uint8_t *pic, uint64_t numPixels)
+{
+	uint64_t i;
+
+	for (i = 0; i < numPixels; i++) {
+		if (pic[i * 4 + 3] != 255)
+			return true;
+	}
+	return false;
+}
+
+/*
+* CookTexture: decodes the image and writes it back out as a dds with its mips, normal maps and non power
+* of two images are always rgba, the block formats would wreck the normals and the renderer can't make
+* mips for a compressed texture
+*/
+char *CookTexture(const char *name, const void *buf, uint64_t buflen, int format, uint64_t *outlen)
+{
+	std::vector<uint8_t> chain;
+	uint8_t *pic;
+	int width, height, channels, numMips;
+	bool normalMap;
+
+	pic = stbi_load_from_memory((const stbi_uc *)buf, (int)buflen, &width, &height, &channels, 4);
+	if (!pic) {
+		Con_Printf("WARNING: couldn't decode texture %s, %s", name, stbi_failure_reason());
+		return NULL;
+	}
+
+	normalMap = IsNormalMap(name);
+	numMips = BuildMipChain(pic, width, height, normalMap, chain);
+	stbi_image_free(pic);
+
+	if (normalMap || !IsPowerOfTwo(width) || !IsPowerOfTwo(height)) {
+		format = COOK_RGBA;
+	} else if (format == COOK_AUTO) {
+		format = HasAlpha(chain.data(), (uint64_t)width * height) ? COOK_BC3 : COOK_BC1;
+	}
+
+	return WriteDDS(chain, width, height, numMips, format, outlen);
+}
+
+/*
+===============================================================================
+
+COOK CACHE
+
+===============================================================================
+*/
+
+static uint64_t HashBuffer(const void *buf, uint64_t len, uint64_t hash)
+{
+	const uint8_t *p = (const uint8_t *)buf;
+	uint64_t i;
+
+	for (i = 0; i < len; i++) {
+		hash ^= p[i];
+		hash *= 0x100000001b3ULL;
+	}
+	return hash;
+}
+
+/*
+* CookKey: a hash of the source image and everything else that changes what comes out, textures with the
+* same contents share an entry
+*/
+static uint64_t CookKey(const char *name, const void *buf, uint64_t buflen, int format)
+{
+	const int version = COOK_VERSION;
+	const bool normalMap = IsNormalMap(name);
+	uint64_t hash;
+
+	hash = HashBuffer(buf, buflen, 0xcbf29ce484222325ULL);
+	hash = HashBuffer(&format, sizeof(format), hash);
+	hash = HashBuffer(&version, sizeof(version), hash);
+	hash = HashBuffer(&normalMap, sizeof(normalMap), hash);
+	return hash;
+}
+
+/*
+* CookTextureCached: cooks through the cache directory so an unchanged texture is only a file read, an empty
+* bff_cookCache turns it off
+*/
+static char *CookTextureCached(const char *name, const void *buf, uint64_t buflen, int format, uint64_t *outlen, bool *cached)
+{
+	char key[32];
+	void *data;
+	int64_t length;
+	char *out;
+	FILE *fp;
+
+	*cached = false;
+	if (!bff_cookCache || !*bff_cookCache) {
+		return CookTexture(name, buf, buflen, format, outlen);
+	}
+
+	snprintf(key, sizeof(key), "%016lx", (unsigned long)CookKey(name, buf, buflen, format));
+	const std::string path = std::string(bff_cookCache) + "/" + key + ".dds";
+
+	fp = fopen(path.c_str(), "rb");
+	if (fp) {
+		LoadFile(fp, &data, &length);
+		fclose(fp);
+		if (length > 4 && !memcmp(data, "DDS ", 4)) {
+			*outlen = length;
+			*cached = true;
+			return (char *)data;
+		}
+		Con_Printf("WARNING: cook cache entry %s is corrupt, cooking %s again", path.c_str(), name);
+		free(data);
+	}
+
+	out = CookTexture(name, buf, buflen, format, outlen);
+	if (!out) {
+		return NULL;
+	}
+
+	// written under a name of its own first so a cook that gets killed never leaves half a file behind
+	const std::string temp = path + "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".tmp";
+	fp = fopen(temp.c_str(), "wb");
+	if (!fp) {
+		Con_Printf("WARNING: couldn't write %s to the cook cache", path.c_str());
+		return out;
+	}
+	const bool written = fwrite(out, *outlen, 1, fp) == 1;
+	fclose(fp);
+
+	std::error_code err;
+	if (written) {
+		std::filesystem::rename(temp, path, err);
+	}
+	if (!written || err) {
+		Con_Printf("WARNING: couldn't write %s to the cook cache", path.c_str());
+		std::filesystem::remove(temp, err);
+	}
+
+	return out;
+}
+
+/*
+* CookChunks: swaps every texture for its cooked dds, the dds probe in R_LoadImage strips the extension
+* so the renderer still finds it under the name the game asks for
+*/
+void CookChunks(bff_chunk_t *chunks, uint64_t numChunks)
+{
+	std::atomic<uint64_t> numCooked(0), numCached(0);
+	uint64_t before, after;
+	std::error_code err;
+
+	if (bff_cookCache && *bff_cookCache) {
+		std::filesystem::create_directories(bff_cookCache, err);
+		if (err) {
+			Con_Printf("WARNING: couldn't create cook cache %s, %s", bff_cookCache, err.message().c_str());
+			bff_cookCache = "";
+		}
+	}
+
+	before = after = 0;
+	for (uint64_t i = 0; i < numChunks; i++) {
+		if (BFF_IsCookable(chunks[i].chunkName))
+			before += chunks[i].chunkSize;
+	}
+
+	const auto start = std::chrono::steady_clock::now();
+	BFF_ParallelFor(numChunks, [&](uint64_t i) {
+		bff_chunk_t *chunk = &chunks[i];
+		uint64_t cookedLen;
+		bool cached;
+		char *cooked;
+
+		if (!BFF_IsCookable(chunk->chunkName)) {
+			return;
+		}
+		cooked = CookTextureCached(chunk->chunkName, chunk->chunkBuffer, chunk->chunkSize, bff_cookFormat, &cookedLen, &cached);
+		if (!cooked) {
+			return;
+		}
+
+		free(chunk->chunkBuffer);
+		chunk->chunkBuffer = cooked;
+		chunk->chunkSize = cookedLen;
+
+		std::string name = chunk->chunkName;
+		name.resize(name.size() - strlen(GetExtension(chunk->chunkName)));
+		name += "dds";
+		free(chunk->chunkName);
+		chunk->chunkName = strdup(name.c_str());
+		chunk->chunkNameLen = name.size() + 1;
+
+		numCooked++;
+		if (cached)
+			numCached++;
+	});
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	for (uint64_t i = 0; i < numChunks; i++) {
+		if (!strcasecmp(GetExtension(chunks[i].chunkName), "dds"))
+			after += chunks[i].chunkSize;
+	}
+
+	Con_Printf("cooked %lu textures to %s (%lu from the cache), %.02f MiB to %.02f MiB in %.02f seconds",
+		(uint64_t)numCooked, BFF_CookFormatString(bff_cookFormat), (uint64_t)numCached, before / (1024.0 * 1024.0),
+		after / (1024.0 * 1024.0), seconds);
+}
+
+/*
+===============================================================================
+
+TESTS
+
+===============================================================================
+*/
+
+static float downmipSrgbLookup[256];
+
+/*
+* R_MipMapsRGB: as it is in code/rendergl/rgl_texture.c, the cooked levels have to match it byte for byte
+*/
+static void R_MipMapsRGB( uint8_t *in, int inWidth, int inHeight)
+{
+	int x, y, c, stride;
+	const uint8_t *in2;
+	float total;
+	uint8_t *out = in;
+
+	if (inWidth == 1 && inHeight == 1)
+		return;
+
+	if (inWidth == 1 || inHeight == 1) {
+		for (x = (inWidth * inHeight) >> 1; x; x--) {
+			for (c = 3; c; c--, in++) {
+				total  = (downmipSrgbLookup[*(in)] + downmipSrgbLookup[*(in + 4)]) * 2.0f;
+
+				*out++ = (uint8_t)(powf(total, 1.0f / 2.2f) * 255.0f);
+			}
+			*out++ = (*(in) + *(in + 4)) >> 1; in += 5;
+		}
+		
+		return;
+	}
+
+	stride = inWidth * 4;
+	inWidth >>= 1; inHeight >>= 1;
+
+	in2 = in + stride;
+	for (y = inHeight; y; y--, in += stride, in2 += stride) {
+		for (x = inWidth; x; x--) {
+			for (c = 3; c; c--, in++, in2++) {
+				total = downmipSrgbLookup[*(in)]  + downmipSrgbLookup[*(in + 4)]
+				      + downmipSrgbLookup[*(in2)] + downmipSrgbLookup[*(in2 + 4)];
+
+				*out++ = (uint8_t)(powf(total, 1.0f / 2.2f) * 255.0f);
+			}
+
+			*out++ = (*(in) + *(in + 4) + *(in2) + *(in2 + 4)) >> 2; in += 5, in2 += 5;
+		}
+	}
+}
+
+// the chain R_BuildMipChain makes, every level copied down and mipped in place
+static int ReferenceMipChain(const uint8_t *pic, int width, int height, std::vector<uint8_t>& chain)
+{
+	uint64_t offset, levelSize;
+	int numMips, w, h;
+
+	chain.assign(pic, pic + (uint64_t)width * height * 4);
+	if (!IsPowerOfTwo(width) || !IsPowerOfTwo(height)) {
+		return 1;
+	}
+
+	numMips = 1;
+	offset = 0;
+	for (w = width, h = height; w > 1 || h > 1; ) {
+		levelSize = (uint64_t)w * h * 4;
+		chain.resize(offset + levelSize * 2);
+		memcpy(chain.data() + offset + levelSize, chain.data() + offset, levelSize);
+		R_MipMapsRGB(chain.data() + offset + levelSize, w, h);
+		offset += levelSize;
+		w = std::max(1, w >> 1);
+		h = std::max(1, h >> 1);
+		numMips++;
+	}
+	chain.resize(offset + (uint64_t)w * h * 4);
+	return numMips;
+}
+
+// smooth gradients with some noise on top, pure noise is nothing like a real texture
+static std::vector<uint8_t> MakeTestImage(int width, int height, bool alpha, uint32_t seed)
+{
+	std::vector<uint8_t> pic((uint64_t)width * height * 4);
+	int x, y;
+
+	for (y = 0; y < height; y++) {
+		for (x = 0; x < width; x++) {
+			uint8_t *p = &pic[((uint64_t)y * width + x) * 4];
+
+			seed = seed * 1664525 + 1013904223;
+			p[0] = std::min(255, x * 255 / width + (int)((seed >> 24) & 7));
+			p[1] = std::min(255, y * 255 / height + (int)((seed >> 16) & 7));
+			p[2] = std::min(255, (x + y) * 127 / (width + height) + 64 + (int)((seed >> 8) & 7));
+			p[3] = alpha ? (uint8_t)(255 - x * 255 / width) : 255;
+		}
+	}
+	return pic;
+}
+
+// an uncompressed top down tga, stb_image reads it the same as anything an artist would hand over
+static std::vector<uint8_t> MakeTGA(const std::vector<uint8_t>& pic, int width, int height)
+{
+	std::vector<uint8_t> tga(18 + pic.size());
+	uint64_t i;
+
+	tga[2] = 2;
+	tga[12] = width & 0xff;
+	tga[13] = width >> 8;
+	tga[14] = height & 0xff;
+	tga[15] = height >> 8;
+	tga[16] = 32;
+	tga[17] = 0x28;
+	for (i = 0; i < pic.size(); i += 4) {
+		tga[18 + i + 0] = pic[i + 2];
+		tga[18 + i + 1] = pic[i + 1];
+		tga[18 + i + 2] = pic[i + 0];
+		tga[18 + i + 3] = pic[i + 3];
+	}
+	return tga;
+}
+
+static void DecodeColorBlock(const uint8_t *in, uint8_t out[16][4])
+{
+	const uint16_t c0 = in[0] | (in[1] << 8);
+	const uint16_t c1 = in[2] | (in[3] << 8);
+	int palette[4][3];
+	int i, c, index;
+
+	ColorPalette(c0, c1, palette);
+	for (i = 0; i < 16; i++) {
+		index = (in[4 + i / 4] >> ((i % 4) * 2)) & 3;
+		for (c = 0; c < 3; c++)
+			out[i][c] = palette[index][c];
+		out[i][3] = 255;
+	}
+}
+
+static void DecodeAlphaBlock(const uint8_t *in, uint8_t out[16][4])
+{
+	int palette[8];
+	uint64_t indices;
+	int i;
+
+	AlphaPalette(in[0], in[1], palette);
+	indices = 0;
+	for (i = 0; i < 6; i++)
+		indices |= (uint64_t)in[2 + i] << (i * 8);
+	for (i = 0; i < 16; i++)
+		out[i][3] = palette[(indices >> (i * 3)) & 7];
+}
+
+static uint32_t GetBits(const uint8_t *in, int *bit, int count)
+{
+	uint32_t value;
+	int i;
+
+	value = 0;
+	for (i = 0; i < count; i++, (*bit)++) {
+		value |= (uint32_t)((in[*bit >> 3] >> (*bit & 7)) & 1) << i;
+	}
+	return value;
+}
+
+static bool DecodeBC7Block(const uint8_t *in, uint8_t out[16][4])
+{
+	int endpoints[2][4], pbits[2], indices[16];
+	int i, c, bit;
+
+	bit = 0;
+	if (GetBits(in, &bit, 7) != (1 << 6)) {
+		return false;
+	}
+	for (c = 0; c < 4; c++) {
+		endpoints[0][c] = GetBits(in, &bit, 7);
+		endpoints[1][c] = GetBits(in, &bit, 7);
+	}
+	pbits[0] = GetBits(in, &bit, 1);
+	pbits[1] = GetBits(in, &bit, 1);
+	indices[0] = GetBits(in, &bit, 3);
+	for (i = 1; i < 16; i++)
+		indices[i] = GetBits(in, &bit, 4);
+
+	for (i = 0; i < 16; i++) {
+		for (c = 0; c < 4; c++) {
+			const int e0 = (endpoints[0][c] << 1) | pbits[0];
+			const int e1 = (endpoints[1][c] << 1) | pbits[1];
+			out[i][c] = ((64 - bc7Weights[indices[i]]) * e0 + bc7Weights[indices[i]] * e1 + 32) >> 6;
+		}
+	}
+	return true;
+}
+
+static bool DecodeLevel(const uint8_t *in, int width, int height, int format, uint8_t *out)
+{
+	uint8_t block[16][4];
+	int bx, by, x, y;
+
+	if (format == COOK_RGBA) {
+		memcpy(out, in, (uint64_t)width * height * 4);
+		return true;
+	}
+
+	for (by = 0; by < (height + 3) / 4; by++) {
+		for (bx = 0; bx < (width + 3) / 4; bx++) {
+			switch (format) {
+			case COOK_BC1:
+				DecodeColorBlock(in, block);
+				in += 8;
+				break;
+			case COOK_BC3:
+				DecodeColorBlock(in + 8, block);
+				DecodeAlphaBlock(in, block);
+				in += 16;
+				break;
+			case COOK_BC7:
+				if (!DecodeBC7Block(in, block))
+					return false;
+				in += 16;
+				break;
+			};
+			for (y = 0; y < 4 && by * 4 + y < height; y++) {
+				for (x = 0; x < 4 && bx * 4 + x < width; x++)
+					memcpy(out + ((uint64_t)(by * 4 + y) * width + bx * 4 + x) * 4, block[y * 4 + x], 4);
+			}
+		}
+	}
+	return true;
+}
+
+/*
+* CheckCookedDDS: reads the dds back the way R_LoadDDS would and holds every level against the chain it
+* was cooked from, rgba has to be exact and the block formats within maxError on the top level. The small
+* levels squeeze a whole gradient into one block and no single line through the colors follows that
+*/
+static bool CheckCookedDDS(const char *label, const char *dds, uint64_t length, const std::vector<uint8_t>& chain, int width,
+	int height, int numMips, int format, double maxError)
+{
+	ddsHeader_t header;
+	ddsHeaderDxt10_t dxt10;
+	std::vector<uint8_t> decoded;
+	const uint8_t *data;
+	uint64_t size, offset;
+	double error, top;
+	int i, w, h, expected;
+
+	if (length < DDSHeaderSize(format) || memcmp(dds, "DDS ", 4)) {
+		Con_Printf("FAILED: %s isn't a dds", label);
+		return false;
+	}
+	memcpy(&header, dds + 4, sizeof(header));
+
+	switch (format) {
+	case COOK_BC1:
+		expected = EncodeFourCC("DXT1");
+		break;
+	case COOK_BC3:
+		expected = EncodeFourCC("DXT5");
+		break;
+	case COOK_BC7:
+		expected = EncodeFourCC("DX10");
+		break;
+	default:
+		expected = 0;
+		break;
+	};
+	if (header.headerSize != sizeof(header) || header.width != (uint32_t)width || header.height != (uint32_t)height
+		|| !(header.flags & DDSFLAGS_MIPMAPCOUNT) || header.numMips != (uint32_t)numMips || header.fourCC != (uint32_t)expected)
+	{
+		Con_Printf("FAILED: %s has a bad header (%ux%u, %u mips, fourcc 0x%08x)", label, header.width, header.height,
+			header.numMips, header.fourCC);
+		return false;
+	}
+	if (format == COOK_RGBA && (header.rgbBitCount != 32 || header.rBitMask != 0x000000ff || header.aBitMask != 0xff000000)) {
+		Con_Printf("FAILED: %s doesn't have the rgba masks R_LoadDDS looks for", label);
+		return false;
+	}
+	if (format == COOK_BC7) {
+		memcpy(&dxt10, dds + 4 + sizeof(header), sizeof(dxt10));
+		if (dxt10.dxgiFormat != DXGI_FORMAT_BC7_UNORM) {
+			Con_Printf("FAILED: %s has dxgi format %u", label, dxt10.dxgiFormat);
+			return false;
+		}
+	}
+
+	size = 0;
+	for (i = 0, w = width, h = height; i < numMips; i++) {
+		size += LevelSize(w, h, format);
+		w = std::max(1, w >> 1);
+		h = std::max(1, h >> 1);
+	}
+	if (length != DDSHeaderSize(format) + size) {
+		Con_Printf("FAILED: %s is %lu bytes, its levels add up to %lu", label, length, DDSHeaderSize(format) + size);
+		return false;
+	}
+
+	data = (const uint8_t *)dds + DDSHeaderSize(format);
+	offset = 0;
+	top = 0.0;
+	for (i = 0, w = width, h = height; i < numMips; i++) {
+		decoded.resize((uint64_t)w * h * 4);
+		if (!DecodeLevel(data, w, h, format, decoded.data())) {
+			Con_Printf("FAILED: %s level %i has a block that isn't bc7 mode 6", label, i);
+			return false;
+		}
+
+		// bc1 goes up as rgb, whatever alpha the source had is gone
+		error = 0.0;
+		for (uint64_t p = 0; p < decoded.size(); p++) {
+			if (format == COOK_BC1 && p % 4 == 3)
+				continue;
+			const double d = (double)decoded[p] - chain[offset + p];
+			error += d * d;
+		}
+		error = sqrt(error / (format == COOK_BC1 ? decoded.size() / 4 * 3 : decoded.size()));
+		if (i == 0)
+			top = error;
+		if ((format == COOK_RGBA && error != 0.0) || (i == 0 && error > maxError)) {
+			Con_Printf("FAILED: %s level %i (%ix%i) is off by %.02f rms", label, i, w, h, error);
+			return false;
+		}
+
+		data += LevelSize(w, h, format);
+		offset += (uint64_t)w * h * 4;
+		w = std::max(1, w >> 1);
+		h = std::max(1, h >> 1);
+	}
+
+	Con_Printf("%-32s %2i mips, %7lu bytes, %.02f rms", label, numMips, length, top);
+	return true;
+}
+
+/*
+* TestCook: the cooked mips against the renderer's own filter, every output format read back and decoded,
+* and the cache handing back what it was given
+*/
+void TestCook(void)
+{
+	static const struct {
+		int width, height;
+	} mipSizes[] = {
+		{ 1, 1 }, { 2, 2 }, { 4, 4 }, { 256, 256 }, { 64, 16 }, { 16, 64 }, { 1, 32 }, { 128, 1 }, { 8, 2 }, { 48, 20 },
+	};
+	static const struct {
+		const char *name;
+		int width, height;
+		bool alpha;
+	} images[] = {
+		{ "opaque.tga", 128, 128, false }, { "alpha.tga", 64, 32, true }, { "npot.tga", 12, 20, true }, { "wall_n.tga", 16, 16, false },
+	};
+	// rms limits for the block formats on the test images, loose enough for any sane encoder and tight
+	// enough to catch a broken one
+	static const struct {
+		int format;
+		double maxError;
+	} formats[] = {
+		{ COOK_RGBA, 0.0 }, { COOK_BC1, 6.0 }, { COOK_BC3, 6.0 }, { COOK_BC7, 5.0 }, { COOK_AUTO, 6.0 },
+	};
+	std::vector<uint8_t> chain, reference;
+	int total, failed, numMips, refMips;
+	uint64_t length, length2;
+	char label[128];
+	char *dds, *dds2;
+	bool cached, cached2;
+
+	for (int x = 0; x < 256; x++)
+		downmipSrgbLookup[x] = powf(x / 255.0f, 2.2f) * 0.25f;
+
+	total = failed = 0;
+	for (const auto& size : mipSizes) {
+		for (int alpha = 0; alpha < 2; alpha++) {
+			const std::vector<uint8_t> pic = MakeTestImage(size.width, size.height, alpha, 0x5f3759df + size.width * 31 + size.height);
+
+			numMips = BuildMipChain(pic.data(), size.width, size.height, false, chain);
+			refMips = ReferenceMipChain(pic.data(), size.width, size.height, reference);
+
+			total++;
+			if (numMips != refMips || chain != reference) {
+				Con_Printf("FAILED: %ix%i mip chain doesn't match R_MipMapsRGB (%i mips, expected %i)", size.width, size.height,
+					numMips, refMips);
+				failed++;
+			}
+		}
+	}
+	Con_Printf("mip chains: %i of %i match R_MipMapsRGB", total - failed, total);
+
+	for (const auto& image : images) {
+		const std::vector<uint8_t> pic = MakeTestImage(image.width, image.height, image.alpha, 0x2545f491 + image.width);
+		const std::vector<uint8_t> tga = MakeTGA(pic, image.width, image.height);
+
+		numMips = BuildMipChain(pic.data(), image.width, image.height, IsNormalMap(image.name), chain);
+		for (const auto& format : formats) {
+			int expected;
+
+			expected = format.format;
+			if (IsNormalMap(image.name) || !IsPowerOfTwo(image.width) || !IsPowerOfTwo(image.height)) {
+				expected = COOK_RGBA;
+			} else if (expected == COOK_AUTO) {
+				expected = image.alpha ? COOK_BC3 : COOK_BC1;
+			}
+
+			snprintf(label, sizeof(label), "%s as %s", image.name, BFF_CookFormatString(format.format));
+			total++;
+			dds = CookTexture(image.name, tga.data(), tga.size(), format.format, &length);
+			if (!dds) {
+				Con_Printf("FAILED: couldn't cook %s", label);
+				failed++;
+				continue;
+			}
+			if (!CheckCookedDDS(label, dds, length, chain, image.width, image.height, numMips, expected, format.maxError)) {
+				failed++;
+			}
+			free(dds);
+		}
+	}
+
+	{
+		const std::string cacheDir = (std::filesystem::temp_directory_path() / ("bffc-cook-" + std::to_string(
+			std::hash<std::thread::id>()(std::this_thread::get_id())))).string();
+		const std::vector<uint8_t> pic = MakeTestImage(64, 64, true, 0x1234);
+		const std::vector<uint8_t> tga = MakeTGA(pic, 64, 64);
+		const char *oldCache = bff_cookCache;
+		std::error_code err;
+
+		bff_cookCache = cacheDir.c_str();
+		std::filesystem::create_directories(cacheDir, err);
+
+		dds = CookTextureCached("cached.tga", tga.data(), tga.size(), COOK_BC7, &length, &cached);
+		dds2 = CookTextureCached("renamed.tga", tga.data(), tga.size(), COOK_BC7, &length2, &cached2);
+
+		total++;
+		if (!dds || !dds2 || cached || !cached2 || length != length2 || memcmp(dds, dds2, length)) {
+			Con_Printf("FAILED: the cook cache didn't hand back the texture it was given (cached %i/%i)", cached, cached2);
+			failed++;
+		}
+		free(dds);
+		free(dds2);
+
+		bff_cookCache = oldCache;
+		std::filesystem::remove_all(cacheDir, err);
+	}
+
+	Con_Printf("texture cooking: %i of %i ok", total - failed, total);
+	if (failed) {
+		exit(EXIT_FAILURE);
+	}
+}
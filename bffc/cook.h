@@ -0,0 +1,39 @@
+#ifndef _BFF_COOK_
+#define _BFF_COOK_
+
+#pragma once
+
+#include <stdint.h>
+
+//
+// texture cooking, turns the source images into dds files with the whole mip chain already built so
+// the dds probe in R_LoadImage picks them up and the renderer doesn't have to decode or mip anything
+//
+#define COOK_NONE -1
+#define COOK_RGBA 0
+#define COOK_BC1 1
+#define COOK_BC3 2
+#define COOK_BC7 3
+#define COOK_AUTO 4 // bc1 for opaque textures, bc3 for the ones with alpha
+
+// bump whenever the cooked output changes, it's part of the cache key
+#define COOK_VERSION 1
+
+#define COOK_DEFAULT_CACHE "bffcache"
+
+const char *BFF_CookFormatString(int format);
+int BFF_CookFormatFromString(const char *name);
+bool BFF_IsCookable(const char *name);
+
+// returns a malloc'd dds or NULL if the image couldn't be decoded, safe to call from the worker threads
+char *CookTexture(const char *name, const void *buf, uint64_t buflen, int format, uint64_t *outlen);
+
+// cooks every texture in the chunk list in place, renaming them to .dds
+void CookChunks(bff_chunk_t *chunks, uint64_t numChunks);
+
+void TestCook(void);
+
+extern int bff_cookFormat;
+extern const char *bff_cookCache;
+
+#endif
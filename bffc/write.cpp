@@ -2,9 +2,10 @@
 #define LOG_WARN(...) Con_Printf(__VA_ARGS__)
 #define N_Error BFF_Error
 #include "zone.h"
-#include <bzlib.h>
-#include <zlib.h>
+#include "compress.h"
+#include "cook.h"
 #include <SDL2/SDL_endian.h>
+#include <chrono>
 
 static const char *defName = DEFAULT_BFF_GAMENAME;
 
@@ -103,41 +104,14 @@ void BFF_WriteLevel(const bfflevel_t *lvl, bff_chunk_t *chunk)
 	}
 }
 
-template<typename CharT>
-static const CharT* CompressBuffer(CharT *buffer, uint64_t inlen, uint64_t *outlen, int compression)
-{
-	const CharT *buf;
-	switch (compression) {
-	case COMPRESSION_BZIP2:
-		buf = Compress_BZIP2(buffer, inlen, outlen);
-		break;
-	case COMPRESSION_ZLIB:
-		buf = Compress_ZLIB(buffer, inlen, outlen);
-		break;
-	case COMPRESSION_NONE:
-		buf = buffer;
-		*outlen = inlen;
-		break;
-	};
-	return buf;
-}
-
-static inline const char *CompressionString(int compression)
-{
-	switch (compression) {
-	case COMPRESSION_BZIP2: return "bzip2";
-	case COMPRESSION_ZLIB: return "zlib";
-	};
-	return "None";
-}
-
-static inline void BFF_Report(int64_t index, int64_t size, const char *name)
+static inline void BFF_Report(int64_t index, int64_t size, uint64_t compressedSize, int compression, const char *name)
 {
 	Con_Printf(
 		"<-------- CHUNK %li -------->\n"
 		"size: %3.03f KiB\n"
+		"compressed: %3.03f KiB (%s)\n"
 		"name: %s\n",
-	index, ((float)size / 1024), name);
+	index, ((float)size / 1024), ((float)compressedSize / 1024), BFF_CompressionString(compression), name);
 }
 
 // from Quake3e
@@ -156,11 +130,15 @@ void StripExtension(const char *in, char* out, uint32_t destsize)
 	}
 }
 
+/*
+* WriteBFF: loads every file in the entries list, compresses them on all cores and writes
+* them in order, each chunk with its own codec
+*/
 void WriteBFF(const char *outfile, const char *jsonfile, int compression)
 {
 	bff_t *archive;
 	FILE *fp, *jsonfp;
-	uint64_t nameLen;
+	uint64_t nameLen, totalSize, totalCompressed;
 
 	nameLen = 0;
 	jsonfp = SafeOpen(jsonfile, "r");
@@ -173,12 +151,13 @@ void WriteBFF(const char *outfile, const char *jsonfile, int compression)
 	archive->numChunks = data.at("files").size();
 	archive->chunkList = new bff_chunk_t[archive->numChunks];
 
+	// the header's method is only informational from BFF_VERSION_CHUNK_COMPRESSION on
 	bffheader_t header = {
 		.ident = BFF_IDENT,
 		.magic = HEADER_MAGIC,
 		.numChunks = archive->numChunks,
-		.compression = compression,
-		.version = BFF_VERSION
+		.compression = compression == COMPRESS_AUTO ? COMPRESS_NONE : compression,
+		.version = BFF_VERSION_CHUNK_COMPRESSION
 	};
 
 	Con_Printf(
@@ -186,7 +165,7 @@ void WriteBFF(const char *outfile, const char *jsonfile, int compression)
 		"total chunks: %li\n"
 		"compression: %s\n"
 		"version: %hu\n",
-	header.numChunks, CompressionString(compression), header.version);
+	header.numChunks, BFF_CompressionString(compression), header.version);
 
 
 	fp = SafeOpen(outfile, "wb");
@@ -208,22 +187,70 @@ void WriteBFF(const char *outfile, const char *jsonfile, int compression)
 		LoadFile(tempfp, (void **)&chunk->chunkBuffer, &chunk->chunkSize);
 		fclose(tempfp);
 
-		BFF_Report(index, chunk->chunkSize, chunk->chunkName);
-		
 		index++;
 	}
+
+	if (bff_cookFormat != COOK_NONE) {
+		CookChunks(archive->chunkList, archive->numChunks);
+	}
+
+	std::vector<int64_t> codecs(archive->numChunks);
+	std::vector<char *> compressed(archive->numChunks);
+	std::vector<uint64_t> compressedSizes(archive->numChunks);
+
+	const auto start = std::chrono::steady_clock::now();
+	BFF_ParallelFor(archive->numChunks, [&](uint64_t i) {
+		bff_chunk_t *chunk = &archive->chunkList[i];
+		int codec;
+
+		codec = compression == COMPRESS_AUTO ? BFF_CodecForFile(chunk->chunkName) : compression;
+		compressed[i] = chunk->chunkBuffer;
+		compressedSizes[i] = chunk->chunkSize;
+		if (codec != COMPRESS_NONE && chunk->chunkSize > 0) {
+			compressed[i] = Compress(chunk->chunkBuffer, chunk->chunkSize, &compressedSizes[i], codec);
+
+			// don't make the engine decompress something that didn't get any smaller
+			if (compressedSizes[i] >= (uint64_t)chunk->chunkSize) {
+				free(compressed[i]);
+				compressed[i] = chunk->chunkBuffer;
+				compressedSizes[i] = chunk->chunkSize;
+				codec = COMPRESS_NONE;
+			}
+		} else {
+			codec = COMPRESS_NONE;
+		}
+		codecs[i] = codec;
+	});
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	totalSize = 0;
+	totalCompressed = 0;
 	for (uint64_t i = 0; i < archive->numChunks; i++) {
 		bff_chunk_t *chunk = &archive->chunkList[i];
 
+		BFF_Report(i, chunk->chunkSize, compressedSizes[i], codecs[i], chunk->chunkName);
+		totalSize += chunk->chunkSize;
+		totalCompressed += compressedSizes[i];
+
 		SafeWrite(fp, &chunk->chunkNameLen, sizeof(int64_t));
 		SafeWrite(fp, chunk->chunkName, chunk->chunkNameLen);
 		SafeWrite(fp, &chunk->chunkSize, sizeof(int64_t));
-		SafeWrite(fp, chunk->chunkBuffer, chunk->chunkSize);
-
+		SafeWrite(fp, &codecs[i], sizeof(int64_t));
+		SafeWrite(fp, &compressedSizes[i], sizeof(uint64_t));
+		if (compressedSizes[i]) {
+			SafeWrite(fp, compressed[i], compressedSizes[i]);
+		}
+
+		if (compressed[i] != chunk->chunkBuffer) {
+			free(compressed[i]);
+		}
 		free(chunk->chunkBuffer);
 	}
 
-	delete archive->chunkList;
+	Con_Printf("compressed %.02f MiB to %.02f MiB in %.02f seconds (%.02f MiB/s)", totalSize / (1024.0 * 1024.0),
+		totalCompressed / (1024.0 * 1024.0), seconds, totalSize / (1024.0 * 1024.0) / seconds);
+
+	delete[] archive->chunkList;
 
 	free(archive);
 	fclose(fp);
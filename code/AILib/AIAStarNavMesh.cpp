@@ -0,0 +1,812 @@
+#include "AIAStarNavMesh.h"
+
+CAIAStarNavMesh *g_pNavMesh;
+
+static cvar_t *ai_pathBudget;
+
+// indexed by dirtype_t, north is -y
+const int32_t navDirX[ NAV_DIRS ] = { 0, 1, 1, 1, 0, -1, -1, -1 };
+const int32_t navDirY[ NAV_DIRS ] = { -1, -1, 0, 1, 1, 1, 0, -1 };
+
+#define NAV_DIR_LEFT( dir ) ( ( ( dir ) + 6 ) & 7 )
+#define NAV_DIR_RIGHT( dir ) ( ( ( dir ) + 2 ) & 7 )
+
+static inline int32_t NavSign( int32_t x ) {
+	return ( x > 0 ) - ( x < 0 );
+}
+
+static uint32_t NavDirForDelta( int32_t dx, int32_t dy ) {
+	uint32_t i;
+
+	dx = NavSign( dx );
+	dy = NavSign( dy );
+	for ( i = 0; i < NAV_DIRS; i++ ) {
+		if ( navDirX[i] == dx && navDirY[i] == dy ) {
+			return i;
+		}
+	}
+	return DIR_NULL;
+}
+
+CAIAStarNavMesh::CAIAStarNavMesh( void ) {
+	memset( this, 0, sizeof( *this ) );
+}
+
+CAIAStarNavMesh::~CAIAStarNavMesh() {
+}
+
+uint64_t CAIAStarNavMesh::MemoryRequired( uint32_t width, uint32_t height )
+{
+	uint64_t numTiles;
+
+	numTiles = (uint64_t)width * height;
+	return PAD( sizeof( *m_pMoveMask ) * numTiles, sizeof( uintptr_t ) )
+		+ sizeof( *m_pRegions ) * numTiles
+		+ sizeof( *m_pCost ) * numTiles
+		+ sizeof( *m_pParent ) * numTiles
+		+ sizeof( *m_pStamps ) * numTiles
+		+ sizeof( *m_pHeapIndex ) * numTiles
+		+ sizeof( *m_pHeap ) * numTiles;
+}
+
+void CAIAStarNavMesh::Init( const mapinfo_t *info, void *pMemory )
+{
+	byte *pBuffer;
+
+	PROFILE_FUNCTION();
+
+	if ( !ai_pathBudget ) {
+		ai_pathBudget = Cvar_Get( "ai_pathBudget", "8192", CVAR_SAVE );
+		Cvar_SetDescription( ai_pathBudget, "Maximum number of nodes expanded by queued path requests each frame, 0 for no limit." );
+		Cvar_CheckRange( ai_pathBudget, "0", NULL, CVT_INT );
+	}
+
+	memset( m_Requests, 0, sizeof( m_Requests ) );
+	memset( m_Cache, 0, sizeof( m_Cache ) );
+	m_nNextRequest = 0;
+	m_nPendingHead = 0;
+	m_nPendingCount = 0;
+
+	m_pMapInfo = info;
+	m_nWidth = info->width;
+	m_nHeight = info->height;
+	m_nTiles = info->width * info->height;
+
+	pBuffer = (byte *)pMemory;
+	m_pMoveMask = (uint8_t *)pBuffer;
+	pBuffer += PAD( sizeof( *m_pMoveMask ) * m_nTiles, sizeof( uintptr_t ) );
+	m_pRegions = (uint32_t *)pBuffer;
+	pBuffer += sizeof( *m_pRegions ) * m_nTiles;
+	m_pCost = (float *)pBuffer;
+	pBuffer += sizeof( *m_pCost ) * m_nTiles;
+	m_pParent = (uint32_t *)pBuffer;
+	pBuffer += sizeof( *m_pParent ) * m_nTiles;
+	m_pStamps = (uint32_t *)pBuffer;
+	pBuffer += sizeof( *m_pStamps ) * m_nTiles;
+	m_pHeapIndex = (int32_t *)pBuffer;
+	pBuffer += sizeof( *m_pHeapIndex ) * m_nTiles;
+	m_pHeap = (navHeapNode_t *)pBuffer;
+
+	memset( m_pStamps, 0, sizeof( *m_pStamps ) * m_nTiles );
+	m_nSearchStamp = 0;
+
+	RebuildArea( 0, 0, m_nWidth - 1, m_nHeight - 1 );
+
+	Con_DPrintf( "CAIAStarNavMesh::Init: %ux%u tiles, %u regions\n", m_nWidth, m_nHeight, m_nRegions );
+}
+
+uint8_t CAIAStarNavMesh::BuildOrthogonalMask( uint32_t x, uint32_t y ) const
+{
+	const maptile_t *tiles;
+	uint32_t tile, next, dir;
+	int32_t nx, ny;
+	uint8_t mask;
+
+	tiles = m_pMapInfo->tiles;
+	tile = y * m_nWidth + x;
+	if ( tiles[ tile ].flags & TILESIDE_INSIDE ) {
+		return 0;
+	}
+
+	mask = 0;
+	for ( dir = DIR_NORTH; dir < NAV_DIRS; dir += 2 ) {
+		nx = (int32_t)x + navDirX[ dir ];
+		ny = (int32_t)y + navDirY[ dir ];
+		if ( nx < 0 || ny < 0 || nx >= (int32_t)m_nWidth || ny >= (int32_t)m_nHeight ) {
+			continue;
+		}
+		next = ny * m_nWidth + nx;
+		if ( tiles[ tile ].flags & tileside_flags[ dir ] ) {
+			continue;
+		}
+		if ( tiles[ next ].flags & ( inversedirs_flags[ dir ] | TILESIDE_INSIDE ) ) {
+			continue;
+		}
+		mask |= 1 << dir;
+	}
+	return mask;
+}
+
+/*
+* BuildDiagonalMask: a diagonal step is only allowed when both of the orthogonal
+* steps around it are, so mobs never clip a wall corner
+*/
+uint8_t CAIAStarNavMesh::BuildDiagonalMask( uint32_t x, uint32_t y ) const
+{
+	const maptile_t *tiles;
+	uint32_t tile, next, dir, a, b;
+	int32_t nx, ny;
+	uint8_t mask;
+
+	tiles = m_pMapInfo->tiles;
+	tile = y * m_nWidth + x;
+	mask = 0;
+	for ( dir = DIR_NORTH_EAST; dir < NAV_DIRS; dir += 2 ) {
+		a = dir - 1;
+		b = ( dir + 1 ) & 7;
+		if ( !CanMove( tile, (dirtype_t)a ) || !CanMove( tile, (dirtype_t)b ) ) {
+			continue;
+		}
+		nx = (int32_t)x + navDirX[ dir ];
+		ny = (int32_t)y + navDirY[ dir ];
+		next = ny * m_nWidth + nx;
+		if ( !CanMove( tile + navDirY[ a ] * (int32_t)m_nWidth + navDirX[ a ], (dirtype_t)b )
+			|| !CanMove( tile + navDirY[ b ] * (int32_t)m_nWidth + navDirX[ b ], (dirtype_t)a ) )
+		{
+			continue;
+		}
+		if ( ( tiles[ tile ].flags & tileside_flags[ dir ] ) || ( tiles[ next ].flags & inversedirs_flags[ dir ] ) ) {
+			continue;
+		}
+		mask |= 1 << dir;
+	}
+	return mask;
+}
+
+/*
+* BuildRegions: flood fills every walkable tile into a connected region, the search
+* heap doubles as the fill queue since no search can be running at the same time
+*/
+void CAIAStarNavMesh::BuildRegions( void )
+{
+	uint32_t *queue;
+	uint32_t i, tile, next, head, tail, dir;
+
+	queue = (uint32_t *)m_pHeap;
+	memset( m_pRegions, 0, sizeof( *m_pRegions ) * m_nTiles );
+	m_nRegions = 0;
+
+	for ( i = 0; i < m_nTiles; i++ ) {
+		if ( m_pRegions[i] != NAV_REGION_NONE || !m_pMoveMask[i] ) {
+			continue;
+		}
+		m_nRegions++;
+		m_pRegions[i] = m_nRegions;
+
+		head = tail = 0;
+		queue[ tail++ ] = i;
+		while ( head < tail ) {
+			tile = queue[ head++ ];
+			for ( dir = DIR_NORTH; dir < NAV_DIRS; dir += 2 ) {
+				if ( !CanMove( tile, (dirtype_t)dir ) ) {
+					continue;
+				}
+				next = tile + navDirY[ dir ] * (int32_t)m_nWidth + navDirX[ dir ];
+				if ( m_pRegions[ next ] == NAV_REGION_NONE ) {
+					m_pRegions[ next ] = m_nRegions;
+					queue[ tail++ ] = next;
+				}
+			}
+		}
+	}
+}
+
+/*
+* RebuildArea: recomputes the move masks inside the given tile rectangle after the map
+* changes (doors, destroyed walls), regions are always rebuilt in full since a single
+* tile can join or split two of them
+*/
+void CAIAStarNavMesh::RebuildArea( uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1 )
+{
+	uint32_t x, y, ox0, oy0, ox1, oy1;
+
+	if ( !m_nTiles ) {
+		return;
+	}
+
+	// the neighbours' orthogonal masks look into the changed tiles, and the
+	// diagonal masks look one tile further out than that
+	ox0 = x0 > 0 ? x0 - 1 : 0;
+	oy0 = y0 > 0 ? y0 - 1 : 0;
+	ox1 = MIN( x1 + 1, m_nWidth - 1 );
+	oy1 = MIN( y1 + 1, m_nHeight - 1 );
+	x0 = x0 > 1 ? x0 - 2 : 0;
+	y0 = y0 > 1 ? y0 - 2 : 0;
+	x1 = MIN( x1 + 2, m_nWidth - 1 );
+	y1 = MIN( y1 + 2, m_nHeight - 1 );
+
+	for ( y = oy0; y <= oy1; y++ ) {
+		for ( x = ox0; x <= ox1; x++ ) {
+			m_pMoveMask[ y * m_nWidth + x ] = BuildOrthogonalMask( x, y );
+		}
+	}
+	for ( y = y0; y <= y1; y++ ) {
+		for ( x = x0; x <= x1; x++ ) {
+			m_pMoveMask[ y * m_nWidth + x ] = ( m_pMoveMask[ y * m_nWidth + x ] & 0x55 ) | BuildDiagonalMask( x, y );
+		}
+	}
+
+	BuildRegions();
+
+	// cached paths might go through the changed area
+	memset( m_Cache, 0, sizeof( m_Cache ) );
+}
+
+float CAIAStarNavMesh::Heuristic( uint32_t tile, uint32_t goal ) const
+{
+	uint32_t dx, dy;
+
+	dx = abs( (int32_t)( tile % m_nWidth ) - (int32_t)( goal % m_nWidth ) );
+	dy = abs( (int32_t)( tile / m_nWidth ) - (int32_t)( goal / m_nWidth ) );
+
+	// octile distance
+	return NAV_COST_STRAIGHT * ( dx + dy ) + ( NAV_COST_DIAGONAL - 2.0f * NAV_COST_STRAIGHT ) * MIN( dx, dy );
+}
+
+void CAIAStarNavMesh::HeapSiftUp( int32_t index )
+{
+	navHeapNode_t node;
+	int32_t parent;
+
+	node = m_pHeap[ index ];
+	while ( index > 0 ) {
+		parent = ( index - 1 ) >> 1;
+		if ( m_pHeap[ parent ].f <= node.f ) {
+			break;
+		}
+		m_pHeap[ index ] = m_pHeap[ parent ];
+		m_pHeapIndex[ m_pHeap[ index ].tile ] = index;
+		index = parent;
+	}
+	m_pHeap[ index ] = node;
+	m_pHeapIndex[ node.tile ] = index;
+}
+
+void CAIAStarNavMesh::HeapSiftDown( int32_t index )
+{
+	navHeapNode_t node;
+	int32_t child;
+
+	node = m_pHeap[ index ];
+	for ( ;; ) {
+		child = ( index << 1 ) + 1;
+		if ( child >= m_nHeapSize ) {
+			break;
+		}
+		if ( child + 1 < m_nHeapSize && m_pHeap[ child + 1 ].f < m_pHeap[ child ].f ) {
+			child++;
+		}
+		if ( node.f <= m_pHeap[ child ].f ) {
+			break;
+		}
+		m_pHeap[ index ] = m_pHeap[ child ];
+		m_pHeapIndex[ m_pHeap[ index ].tile ] = index;
+		index = child;
+	}
+	m_pHeap[ index ] = node;
+	m_pHeapIndex[ node.tile ] = index;
+}
+
+void CAIAStarNavMesh::HeapPush( uint32_t tile, float f )
+{
+	m_pHeap[ m_nHeapSize ].tile = tile;
+	m_pHeap[ m_nHeapSize ].f = f;
+	HeapSiftUp( m_nHeapSize++ );
+}
+
+void CAIAStarNavMesh::HeapUpdate( uint32_t tile, float f )
+{
+	// costs only ever go down
+	m_pHeap[ m_pHeapIndex[ tile ] ].f = f;
+	HeapSiftUp( m_pHeapIndex[ tile ] );
+}
+
+uint32_t CAIAStarNavMesh::HeapPop( void )
+{
+	uint32_t tile;
+
+	tile = m_pHeap[0].tile;
+	if ( --m_nHeapSize > 0 ) {
+		m_pHeap[0] = m_pHeap[ m_nHeapSize ];
+		HeapSiftDown( 0 );
+	}
+	return tile;
+}
+
+void CAIAStarNavMesh::OpenNode( uint32_t tile, uint32_t parent, float g, uint32_t goal )
+{
+	if ( m_pStamps[ tile ] != m_nSearchStamp ) {
+		m_pStamps[ tile ] = m_nSearchStamp;
+		m_pCost[ tile ] = g;
+		m_pParent[ tile ] = parent;
+		HeapPush( tile, g + Heuristic( tile, goal ) );
+	} else if ( g < m_pCost[ tile ] ) {
+		m_pCost[ tile ] = g;
+		m_pParent[ tile ] = parent;
+		HeapUpdate( tile, g + Heuristic( tile, goal ) );
+	}
+}
+
+qboolean CAIAStarNavMesh::SearchAStar( uint32_t start, uint32_t goal )
+{
+	uint32_t tile, next, dir, mask, closed;
+
+	closed = m_nSearchStamp + 1;
+	OpenNode( start, start, 0.0f, goal );
+
+	while ( m_nHeapSize ) {
+		tile = HeapPop();
+		m_pStamps[ tile ] = closed;
+		m_nExpanded++;
+
+		if ( tile == goal ) {
+			return qtrue;
+		}
+
+		mask = m_pMoveMask[ tile ];
+		for ( dir = 0; dir < NAV_DIRS; dir++ ) {
+			if ( !( mask & ( 1 << dir ) ) ) {
+				continue;
+			}
+			next = tile + navDirY[ dir ] * (int32_t)m_nWidth + navDirX[ dir ];
+			if ( m_pStamps[ next ] == closed ) {
+				continue;
+			}
+			OpenNode( next, tile, m_pCost[ tile ] + ( ( dir & 1 ) ? NAV_COST_DIAGONAL : NAV_COST_STRAIGHT ), goal );
+		}
+	}
+	return qfalse;
+}
+
+/*
+* JumpStraight: walks in a cardinal direction until the goal or a tile with a forced
+* neighbour. A tile beside us is only reached cheaper by stepping diagonally out of the
+* previous tile, when a wall or a diagonal side blocks that step it has to be expanded
+* from here
+*/
+int32_t CAIAStarNavMesh::JumpStraight( uint32_t tile, uint32_t dir, uint32_t goal ) const
+{
+	const int32_t step = navDirY[ dir ] * (int32_t)m_nWidth + navDirX[ dir ];
+	const dirtype_t left = (dirtype_t)NAV_DIR_LEFT( dir );
+	const dirtype_t right = (dirtype_t)NAV_DIR_RIGHT( dir );
+	const dirtype_t leftDiagonal = (dirtype_t)( ( dir + 7 ) & 7 );
+	const dirtype_t rightDiagonal = (dirtype_t)( ( dir + 1 ) & 7 );
+	uint32_t prev, cur;
+
+	prev = tile;
+	while ( CanMove( prev, (dirtype_t)dir ) ) {
+		cur = prev + step;
+		if ( cur == goal ) {
+			return cur;
+		}
+		if ( ( CanMove( cur, left ) && !CanMove( prev, leftDiagonal ) )
+			|| ( CanMove( cur, right ) && !CanMove( prev, rightDiagonal ) ) )
+		{
+			return cur;
+		}
+		prev = cur;
+	}
+	return -1;
+}
+
+int32_t CAIAStarNavMesh::Jump( uint32_t tile, uint32_t dir, uint32_t goal ) const
+{
+	int32_t step;
+	uint32_t cur;
+
+	if ( !( dir & 1 ) ) {
+		return JumpStraight( tile, dir, goal );
+	}
+
+	step = navDirY[ dir ] * (int32_t)m_nWidth + navDirX[ dir ];
+	while ( CanMove( tile, (dirtype_t)dir ) ) {
+		cur = tile + step;
+		if ( cur == goal ) {
+			return cur;
+		}
+		if ( JumpStraight( cur, dir - 1, goal ) != -1 || JumpStraight( cur, ( dir + 1 ) & 7, goal ) != -1 ) {
+			return cur;
+		}
+		tile = cur;
+	}
+	return -1;
+}
+
+qboolean CAIAStarNavMesh::SearchJumpPoint( uint32_t start, uint32_t goal )
+{
+	uint32_t tile, parent, dir, dirs, closed;
+	int32_t next, dx, dy;
+
+	closed = m_nSearchStamp + 1;
+	OpenNode( start, start, 0.0f, goal );
+
+	while ( m_nHeapSize ) {
+		tile = HeapPop();
+		m_pStamps[ tile ] = closed;
+		m_nExpanded++;
+
+		if ( tile == goal ) {
+			return qtrue;
+		}
+
+		// prune the neighbours we could already have reached through the parent
+		if ( tile == start ) {
+			dirs = m_pMoveMask[ tile ];
+		} else {
+			parent = m_pParent[ tile ];
+			dir = NavDirForDelta( (int32_t)( tile % m_nWidth ) - (int32_t)( parent % m_nWidth ),
+				(int32_t)( tile / m_nWidth ) - (int32_t)( parent / m_nWidth ) );
+			if ( dir & 1 ) {
+				dirs = ( 1 << dir ) | ( 1 << ( dir - 1 ) ) | ( 1 << ( ( dir + 1 ) & 7 ) );
+			} else {
+				dirs = ( 1 << dir ) | ( 1 << NAV_DIR_LEFT( dir ) ) | ( 1 << NAV_DIR_RIGHT( dir ) )
+					| ( 1 << ( ( dir + 1 ) & 7 ) ) | ( 1 << ( ( dir + 7 ) & 7 ) );
+			}
+			dirs &= m_pMoveMask[ tile ];
+		}
+
+		for ( dir = 0; dir < NAV_DIRS; dir++ ) {
+			if ( !( dirs & ( 1 << dir ) ) ) {
+				continue;
+			}
+			next = Jump( tile, dir, goal );
+			if ( next == -1 || m_pStamps[ next ] == closed ) {
+				continue;
+			}
+			dx = abs( (int32_t)( (uint32_t)next % m_nWidth ) - (int32_t)( tile % m_nWidth ) );
+			dy = abs( (int32_t)( (uint32_t)next / m_nWidth ) - (int32_t)( tile / m_nWidth ) );
+			OpenNode( next, tile, m_pCost[ tile ] + ( ( dir & 1 ) ? NAV_COST_DIAGONAL * dx : NAV_COST_STRAIGHT * ( dx + dy ) ),
+				goal );
+		}
+	}
+	return qfalse;
+}
+
+/*
+* BuildWaypoints: follows the parent chain back from the goal, only keeping the tiles
+* where the path turns, if there's more than nMaxWaypoints the ones closest to the
+* start are kept so that the caller can request the rest later on
+*/
+uint32_t CAIAStarNavMesh::BuildWaypoints( uint32_t goal, uint32_t *pWaypoints, uint32_t nMaxWaypoints ) const
+{
+	uint32_t tile, parent, dir, lastDir, count, index;
+	int pass;
+
+	count = 0;
+	for ( pass = 0; pass < 2; pass++ ) {
+		index = count;
+		tile = goal;
+		lastDir = DIR_NULL;
+
+		for ( ;; ) {
+			parent = m_pParent[ tile ];
+			if ( parent == tile ) {
+				dir = DIR_NULL;
+			} else {
+				dir = NavDirForDelta( (int32_t)( tile % m_nWidth ) - (int32_t)( parent % m_nWidth ),
+					(int32_t)( tile / m_nWidth ) - (int32_t)( parent / m_nWidth ) );
+			}
+			if ( dir != lastDir || parent == tile ) {
+				if ( pass == 0 ) {
+					count++;
+				} else {
+					index--;
+					if ( index < nMaxWaypoints ) {
+						pWaypoints[ index ] = tile;
+					}
+				}
+			}
+			if ( parent == tile ) {
+				break;
+			}
+			lastDir = dir;
+			tile = parent;
+		}
+	}
+
+	return MIN( count, nMaxWaypoints );
+}
+
+/*
+* FindPath: runs a blocking search from start to goal, the returned waypoints are tile
+* indices including both ends
+*/
+qboolean CAIAStarNavMesh::FindPath( uint32_t start, uint32_t goal, qboolean bJumpPoint, uint32_t *pWaypoints,
+	uint32_t *nWaypoints, uint32_t nMaxWaypoints, float *pCost )
+{
+	qboolean found;
+
+	*nWaypoints = 0;
+	m_nExpanded = 0;
+
+	if ( start >= m_nTiles || goal >= m_nTiles || m_pRegions[ start ] == NAV_REGION_NONE
+		|| m_pRegions[ start ] != m_pRegions[ goal ] )
+	{
+		return qfalse;
+	}
+
+	// once the stamps wrap every tile has to be cleared
+	m_nSearchStamp += 2;
+	if ( m_nSearchStamp < 2 ) {
+		memset( m_pStamps, 0, sizeof( *m_pStamps ) * m_nTiles );
+		m_nSearchStamp = 2;
+	}
+	m_nHeapSize = 0;
+
+	found = bJumpPoint ? SearchJumpPoint( start, goal ) : SearchAStar( start, goal );
+	if ( !found ) {
+		return qfalse;
+	}
+
+	if ( pCost ) {
+		*pCost = m_pCost[ goal ];
+	}
+	*nWaypoints = BuildWaypoints( goal, pWaypoints, nMaxWaypoints );
+	return qtrue;
+}
+
+uint32_t CAIAStarNavMesh::TileForPoint( const vec3_t origin ) const
+{
+	int32_t x, y;
+
+	x = (int32_t)floorf( origin[0] + 0.5f );
+	y = (int32_t)floorf( origin[1] + 0.5f );
+	x = MAX( 0, MIN( x, (int32_t)m_nWidth - 1 ) );
+	y = MAX( 0, MIN( y, (int32_t)m_nHeight - 1 ) );
+
+	return y * m_nWidth + x;
+}
+
+pathCacheEntry_t *CAIAStarNavMesh::CacheSlot( uint32_t start, uint32_t goal )
+{
+	return &m_Cache[ ( ( start * 2654435761u ) ^ ( goal * 40503u ) ) & ( PATH_CACHE_SIZE - 1 ) ];
+}
+
+/*
+* RequestPath: queues a path search that's run inside of Update, paths that are already
+* cached or can't possibly exist are resolved right away
+*/
+nhandle_t CAIAStarNavMesh::RequestPath( const vec3_t origin, const vec3_t goal, qboolean bJumpPoint )
+{
+	pathRequest_t *req;
+	pathCacheEntry_t *cache;
+	uint32_t i, index;
+
+	if ( !m_nTiles ) {
+		return FS_INVALID_HANDLE;
+	}
+
+	req = NULL;
+	for ( i = 0; i < MAX_PATH_REQUESTS; i++ ) {
+		index = ( m_nNextRequest + i ) & ( MAX_PATH_REQUESTS - 1 );
+		if ( m_Requests[ index ].status == PATH_FREE && !m_Requests[ index ].queued ) {
+			req = &m_Requests[ index ];
+			m_nNextRequest = index + 1;
+			break;
+		}
+	}
+	if ( !req ) {
+		Con_DPrintf( COLOR_YELLOW "CAIAStarNavMesh::RequestPath: no free path requests\n" );
+		return FS_INVALID_HANDLE;
+	}
+
+	req->start = TileForPoint( origin );
+	req->goal = TileForPoint( goal );
+	req->jumpPoint = bJumpPoint;
+	req->numWaypoints = 0;
+
+	if ( m_pRegions[ req->start ] == NAV_REGION_NONE || m_pRegions[ req->start ] != m_pRegions[ req->goal ] ) {
+		req->status = PATH_NOT_FOUND;
+		return index + 1;
+	}
+
+	cache = CacheSlot( req->start, req->goal );
+	if ( cache->valid && cache->start == req->start && cache->goal == req->goal ) {
+		memcpy( req->waypoints, cache->waypoints, sizeof( *cache->waypoints ) * cache->numWaypoints );
+		req->numWaypoints = cache->numWaypoints;
+		req->status = PATH_FOUND;
+		return index + 1;
+	}
+
+	req->status = PATH_PENDING;
+	req->queued = qtrue;
+	m_PendingQueue[ ( m_nPendingHead + m_nPendingCount ) & ( MAX_PATH_REQUESTS - 1 ) ] = index;
+	m_nPendingCount++;
+
+	return index + 1;
+}
+
+pathStatus_t CAIAStarNavMesh::PollPath( nhandle_t hPath, const uint32_t **pWaypoints, uint32_t *nWaypoints ) const
+{
+	const pathRequest_t *req;
+
+	if ( hPath <= FS_INVALID_HANDLE || hPath > MAX_PATH_REQUESTS ) {
+		return PATH_FREE;
+	}
+	req = &m_Requests[ hPath - 1 ];
+	if ( pWaypoints ) {
+		*pWaypoints = req->waypoints;
+	}
+	if ( nWaypoints ) {
+		*nWaypoints = req->numWaypoints;
+	}
+	return req->status;
+}
+
+void CAIAStarNavMesh::ReleasePath( nhandle_t hPath )
+{
+	if ( hPath <= FS_INVALID_HANDLE || hPath > MAX_PATH_REQUESTS ) {
+		return;
+	}
+	// if it's still queued, Update will skip over it
+	m_Requests[ hPath - 1 ].status = PATH_FREE;
+}
+
+/*
+* Update: runs queued path searches in request order until this frame's node budget
+* has been spent, always done on the main thread so that demos stay deterministic
+*/
+void CAIAStarNavMesh::Update( void )
+{
+	pathRequest_t *req;
+	pathCacheEntry_t *cache;
+	uint32_t budget, spent;
+
+	PROFILE_FUNCTION();
+
+	budget = ai_pathBudget ? ai_pathBudget->i : 0;
+	spent = 0;
+
+	while ( m_nPendingCount && ( !budget || spent < budget ) ) {
+		req = &m_Requests[ m_PendingQueue[ m_nPendingHead ] ];
+		m_nPendingHead = ( m_nPendingHead + 1 ) & ( MAX_PATH_REQUESTS - 1 );
+		m_nPendingCount--;
+
+		req->queued = qfalse;
+		if ( req->status != PATH_PENDING ) {
+			continue;
+		}
+
+		if ( !FindPath( req->start, req->goal, req->jumpPoint, req->waypoints, &req->numWaypoints,
+			arraylen( req->waypoints ), NULL ) )
+		{
+			req->status = PATH_NOT_FOUND;
+		} else {
+			req->status = PATH_FOUND;
+
+			if ( req->numWaypoints <= MAX_CACHED_WAYPOINTS && req->waypoints[ req->numWaypoints - 1 ] == req->goal ) {
+				cache = CacheSlot( req->start, req->goal );
+				memcpy( cache->waypoints, req->waypoints, sizeof( *req->waypoints ) * req->numWaypoints );
+				cache->numWaypoints = req->numWaypoints;
+				cache->start = req->start;
+				cache->goal = req->goal;
+				cache->valid = qtrue;
+			}
+		}
+		spent += m_nExpanded;
+	}
+}
+
+/*
+* G_NavBench_f: queues path requests on a synthetic map scattered with walls and solid
+* tiles, then checks that the jump point search finds paths as short as plain A*
+*/
+void G_NavBench_f( void )
+{
+	CAIAStarNavMesh *navMesh;
+	void *pNavMemory;
+	mapinfo_t info;
+	nhandle_t *handles;
+	uint32_t *waypoints;
+	vec3_t origin, goal;
+	uint32_t i, nPaths, nFound, nFrames, nMismatched, nWaypoints, start, end;
+	uint64_t startTime, queueTime, astarTime, jpsTime, astarExpanded, jpsExpanded;
+	float astarCost, jpsCost;
+	qboolean astarFound, jpsFound;
+	int seed;
+
+	nPaths = 1000;
+	if ( Cmd_Argc() > 1 ) {
+		nPaths = MIN( MAX( atoi( Cmd_Argv( 1 ) ), 1 ), MAX_PATH_REQUESTS );
+	}
+
+	memset( &info, 0, sizeof( info ) );
+	N_strncpyz( info.name, "nav_bench", sizeof( info.name ) );
+	info.width = 512;
+	info.height = 512;
+	info.numTiles = info.width * info.height;
+	info.numLevels = 1;
+
+	info.tiles = (maptile_t *)Hunk_AllocateTempMemory( sizeof( *info.tiles ) * info.numTiles );
+	memset( info.tiles, 0, sizeof( *info.tiles ) * info.numTiles );
+
+	seed = 0x4e4d4144;
+	for ( i = 0; i < info.numTiles; i++ ) {
+		if ( Q_random( &seed ) < 0.15f ) {
+			info.tiles[i].flags |= TILESIDE_INSIDE;
+		} else if ( Q_random( &seed ) < 0.1f ) {
+			info.tiles[i].flags |= tileside_flags[ (uint32_t)( Q_random( &seed ) * 8.0f ) & 7 ];
+		}
+	}
+
+	navMesh = new ( Hunk_AllocateTempMemory( sizeof( *navMesh ) ) ) CAIAStarNavMesh();
+	pNavMemory = Hunk_AllocateTempMemory( CAIAStarNavMesh::MemoryRequired( info.width, info.height ) );
+	navMesh->Init( &info, pNavMemory );
+
+	handles = (nhandle_t *)Hunk_AllocateTempMemory( sizeof( *handles ) * nPaths );
+	waypoints = (uint32_t *)Hunk_AllocateTempMemory( sizeof( *waypoints ) * MAX_PATH_WAYPOINTS );
+
+	startTime = Sys_Milliseconds();
+	for ( i = 0; i < nPaths; i++ ) {
+		VectorSet( origin, Q_random( &seed ) * info.width, Q_random( &seed ) * info.height, 0.0f );
+		VectorSet( goal, Q_random( &seed ) * info.width, Q_random( &seed ) * info.height, 0.0f );
+		handles[i] = navMesh->RequestPath( origin, goal, qtrue );
+	}
+	nFrames = 0;
+	for ( ;; ) {
+		navMesh->Update();
+		nFrames++;
+		for ( i = 0; i < nPaths; i++ ) {
+			if ( navMesh->PollPath( handles[i], NULL, NULL ) == PATH_PENDING ) {
+				break;
+			}
+		}
+		if ( i == nPaths ) {
+			break;
+		}
+	}
+	queueTime = Sys_Milliseconds() - startTime;
+
+	nFound = 0;
+	for ( i = 0; i < nPaths; i++ ) {
+		if ( navMesh->PollPath( handles[i], NULL, NULL ) == PATH_FOUND ) {
+			nFound++;
+		}
+		navMesh->ReleasePath( handles[i] );
+	}
+
+	// run the same searches blocking with both algorithms
+	nMismatched = 0;
+	astarTime = jpsTime = 0;
+	astarExpanded = jpsExpanded = 0;
+	for ( i = 0; i < nPaths; i++ ) {
+		start = (uint32_t)( Q_random( &seed ) * info.numTiles ) % info.numTiles;
+		end = (uint32_t)( Q_random( &seed ) * info.numTiles ) % info.numTiles;
+
+		startTime = Sys_Milliseconds();
+		astarFound = navMesh->FindPath( start, end, qfalse, waypoints, &nWaypoints, MAX_PATH_WAYPOINTS, &astarCost );
+		astarTime += Sys_Milliseconds() - startTime;
+		astarExpanded += navMesh->NumExpanded();
+
+		startTime = Sys_Milliseconds();
+		jpsFound = navMesh->FindPath( start, end, qtrue, waypoints, &nWaypoints, MAX_PATH_WAYPOINTS, &jpsCost );
+		jpsTime += Sys_Milliseconds() - startTime;
+		jpsExpanded += navMesh->NumExpanded();
+
+		if ( astarFound != jpsFound || ( astarFound && fabsf( astarCost - jpsCost ) > 0.01f ) ) {
+			nMismatched++;
+		}
+	}
+
+	Con_Printf( "nav_bench: %ux%u map, %u paths\n", info.width, info.height, nPaths );
+	Con_Printf( "queued: %lu msec over %u frames, %u found\n", queueTime, nFrames, nFound );
+	Con_Printf( "A*: %lu msec, %lu nodes expanded\n", astarTime, astarExpanded );
+	Con_Printf( "JPS: %lu msec, %lu nodes expanded, %u mismatched\n", jpsTime, jpsExpanded, nMismatched );
+
+	Hunk_FreeTempMemory( waypoints );
+	Hunk_FreeTempMemory( handles );
+	Hunk_FreeTempMemory( pNavMemory );
+	navMesh->~CAIAStarNavMesh();
+	Hunk_FreeTempMemory( navMesh );
+	Hunk_FreeTempMemory( info.tiles );
+}
@@ -0,0 +1,155 @@
+#ifndef __AI_ASTAR_NAVMESH_H__
+#define __AI_ASTAR_NAVMESH_H__
+
+#pragma once
+
+#include "../game/g_game.h"
+#include "../game/g_world.h"
+
+#define MAX_PATH_REQUESTS 2048
+#define MAX_PATH_WAYPOINTS 256
+
+// direct mapped, must be a power of two
+#define PATH_CACHE_SIZE 4096
+#define MAX_CACHED_WAYPOINTS 64
+
+// tiles that can't be walked on at all
+#define NAV_REGION_NONE 0
+
+#define NAV_COST_STRAIGHT 1.0f
+#define NAV_COST_DIAGONAL 1.41421356f
+
+// every direction but DIR_NULL
+#define NAV_DIRS ( NUMDIRS - 1 )
+
+extern const int32_t navDirX[ NAV_DIRS ];
+extern const int32_t navDirY[ NAV_DIRS ];
+
+typedef enum {
+	PATH_FREE,
+	PATH_PENDING,
+	PATH_FOUND,
+	PATH_NOT_FOUND,
+} pathStatus_t;
+
+typedef struct {
+	uint32_t waypoints[ MAX_PATH_WAYPOINTS ]; // tile indices, start to goal
+	uint32_t numWaypoints;
+	uint32_t start;
+	uint32_t goal;
+	pathStatus_t status;
+	qboolean jumpPoint;
+	qboolean queued; // still sitting in the pending queue, can't be reused yet
+} pathRequest_t;
+
+typedef struct {
+	uint32_t waypoints[ MAX_CACHED_WAYPOINTS ];
+	uint32_t numWaypoints;
+	uint32_t start;
+	uint32_t goal;
+	qboolean valid;
+} pathCacheEntry_t;
+
+typedef struct {
+	float f;
+	uint32_t tile;
+} navHeapNode_t;
+
+/*
+* CAIAStarNavMesh: tile grid pathfinding built from mapinfo_t::tiles, every tile gets a
+* mask of the directions it can be left in (walls, solid tiles and corner cutting are all
+* resolved up front), which the A* and jump point searches run over. Tiles are also
+* flood filled into connected regions so that impossible requests fail without a search.
+*/
+class CAIAStarNavMesh
+{
+public:
+	CAIAStarNavMesh( void );
+	~CAIAStarNavMesh();
+
+	static uint64_t MemoryRequired( uint32_t width, uint32_t height );
+
+	void Init( const mapinfo_t *info, void *pMemory );
+	void RebuildArea( uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1 );
+	void Update( void );
+
+	nhandle_t RequestPath( const vec3_t origin, const vec3_t goal, qboolean bJumpPoint );
+	pathStatus_t PollPath( nhandle_t hPath, const uint32_t **pWaypoints, uint32_t *nWaypoints ) const;
+	void ReleasePath( nhandle_t hPath );
+
+	qboolean FindPath( uint32_t start, uint32_t goal, qboolean bJumpPoint, uint32_t *pWaypoints, uint32_t *nWaypoints,
+		uint32_t nMaxWaypoints, float *pCost );
+
+	uint32_t TileForPoint( const vec3_t origin ) const;
+
+	inline qboolean CanMove( uint32_t tile, dirtype_t dir ) const {
+		return (qboolean)( ( m_pMoveMask[ tile ] >> dir ) & 1 );
+	}
+	inline uint32_t GetRegion( uint32_t tile ) const {
+		return m_pRegions[ tile ];
+	}
+	inline uint32_t GetWidth( void ) const {
+		return m_nWidth;
+	}
+	inline uint32_t GetHeight( void ) const {
+		return m_nHeight;
+	}
+	inline uint32_t NumExpanded( void ) const {
+		return m_nExpanded;
+	}
+private:
+	uint8_t BuildOrthogonalMask( uint32_t x, uint32_t y ) const;
+	uint8_t BuildDiagonalMask( uint32_t x, uint32_t y ) const;
+	void BuildRegions( void );
+
+	float Heuristic( uint32_t tile, uint32_t goal ) const;
+	void HeapPush( uint32_t tile, float f );
+	void HeapUpdate( uint32_t tile, float f );
+	uint32_t HeapPop( void );
+	void HeapSiftUp( int32_t index );
+	void HeapSiftDown( int32_t index );
+
+	qboolean SearchAStar( uint32_t start, uint32_t goal );
+	qboolean SearchJumpPoint( uint32_t start, uint32_t goal );
+	int32_t JumpStraight( uint32_t tile, uint32_t dir, uint32_t goal ) const;
+	int32_t Jump( uint32_t tile, uint32_t dir, uint32_t goal ) const;
+	void OpenNode( uint32_t tile, uint32_t parent, float g, uint32_t goal );
+	uint32_t BuildWaypoints( uint32_t goal, uint32_t *pWaypoints, uint32_t nMaxWaypoints ) const;
+
+	pathCacheEntry_t *CacheSlot( uint32_t start, uint32_t goal );
+
+	const mapinfo_t *m_pMapInfo;
+	uint32_t m_nWidth;
+	uint32_t m_nHeight;
+	uint32_t m_nTiles;
+
+	uint8_t *m_pMoveMask;
+	uint32_t *m_pRegions;
+	uint32_t m_nRegions;
+
+	// per search scratch, a node belongs to the current search when its
+	// stamp is m_nSearchStamp (open) or m_nSearchStamp + 1 (closed)
+	float *m_pCost;
+	uint32_t *m_pParent;
+	uint32_t *m_pStamps;
+	int32_t *m_pHeapIndex;
+	navHeapNode_t *m_pHeap;
+	int32_t m_nHeapSize;
+	uint32_t m_nSearchStamp;
+	uint32_t m_nExpanded;
+
+	pathRequest_t m_Requests[ MAX_PATH_REQUESTS ];
+	uint32_t m_nNextRequest;
+
+	uint32_t m_PendingQueue[ MAX_PATH_REQUESTS ];
+	uint32_t m_nPendingHead;
+	uint32_t m_nPendingCount;
+
+	pathCacheEntry_t m_Cache[ PATH_CACHE_SIZE ];
+};
+
+extern CAIAStarNavMesh *g_pNavMesh;
+
+void G_NavBench_f( void );
+
+#endif
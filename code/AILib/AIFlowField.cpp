@@ -0,0 +1,506 @@
+#include "AIFlowField.h"
+
+CAIFlowField *g_pFlowField;
+
+static cvar_t *ai_flowFieldRadius;
+
+#define FLOW_INVERSE_DIR( dir ) ( ( ( dir ) + 4 ) & 7 )
+
+CAIFlowField::CAIFlowField( void ) {
+	memset( this, 0, sizeof( *this ) );
+}
+
+CAIFlowField::~CAIFlowField() {
+}
+
+uint64_t CAIFlowField::MemoryRequired( uint32_t width, uint32_t height )
+{
+	uint64_t numTiles;
+
+	numTiles = (uint64_t)width * height;
+	return PAD( sizeof( *m_pDirections ) * numTiles, sizeof( uintptr_t ) )
+		+ sizeof( *m_pDistance ) * numTiles
+		+ sizeof( *m_pStamps ) * numTiles
+		+ sizeof( *m_pHeapIndex ) * numTiles
+		+ sizeof( *m_pHeap ) * numTiles
+		+ sizeof( *m_pQueue ) * numTiles;
+}
+
+void CAIFlowField::Init( const CAIAStarNavMesh *pNavMesh, void *pMemory )
+{
+	byte *pBuffer;
+
+	if ( !ai_flowFieldRadius ) {
+		ai_flowFieldRadius = Cvar_Get( "ai_flowFieldRadius", "64", CVAR_SAVE );
+		Cvar_SetDescription( ai_flowFieldRadius, "Path distance in tiles from the player that mobs can follow the shared flow field within." );
+		Cvar_CheckRange( ai_flowFieldRadius, "8", "1024", CVT_INT );
+	}
+
+	m_pNavMesh = pNavMesh;
+	m_nWidth = pNavMesh->GetWidth();
+	m_nHeight = pNavMesh->GetHeight();
+	m_nTiles = m_nWidth * m_nHeight;
+
+	pBuffer = (byte *)pMemory;
+	m_pDirections = (uint8_t *)pBuffer;
+	pBuffer += PAD( sizeof( *m_pDirections ) * m_nTiles, sizeof( uintptr_t ) );
+	m_pDistance = (float *)pBuffer;
+	pBuffer += sizeof( *m_pDistance ) * m_nTiles;
+	m_pStamps = (uint32_t *)pBuffer;
+	pBuffer += sizeof( *m_pStamps ) * m_nTiles;
+	m_pHeapIndex = (int32_t *)pBuffer;
+	pBuffer += sizeof( *m_pHeapIndex ) * m_nTiles;
+	m_pHeap = (navHeapNode_t *)pBuffer;
+	pBuffer += sizeof( *m_pHeap ) * m_nTiles;
+	m_pQueue = (uint32_t *)pBuffer;
+
+	memset( m_pStamps, 0, sizeof( *m_pStamps ) * m_nTiles );
+	memset( m_pHeapIndex, 0xff, sizeof( *m_pHeapIndex ) * m_nTiles );
+	m_nStamp = 1;
+	m_nHeapSize = 0;
+
+	// nothing to chase until a target is set
+	m_nTarget = m_nTiles;
+	m_bTargetMoved = qfalse;
+	m_bDirty = qfalse;
+}
+
+void CAIFlowField::SetTarget( const vec3_t origin )
+{
+	uint32_t tile;
+
+	if ( !m_nTiles ) {
+		return;
+	}
+	tile = m_pNavMesh->TileForPoint( origin );
+	if ( tile != m_nTarget ) {
+		m_nTarget = tile;
+		m_bTargetMoved = qtrue;
+	}
+}
+
+/*
+* MarkDirty: queues a repair of the field after the nav mesh was rebuilt in the given
+* area, several changes in the same frame are merged
+*/
+void CAIFlowField::MarkDirty( uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1 )
+{
+	if ( !m_bDirty ) {
+		m_DirtyMins[0] = x0;
+		m_DirtyMins[1] = y0;
+		m_DirtyMaxs[0] = x1;
+		m_DirtyMaxs[1] = y1;
+		m_bDirty = qtrue;
+		return;
+	}
+	m_DirtyMins[0] = MIN( m_DirtyMins[0], x0 );
+	m_DirtyMins[1] = MIN( m_DirtyMins[1], y0 );
+	m_DirtyMaxs[0] = MAX( m_DirtyMaxs[0], x1 );
+	m_DirtyMaxs[1] = MAX( m_DirtyMaxs[1], y1 );
+}
+
+void CAIFlowField::Update( void )
+{
+	PROFILE_FUNCTION();
+
+	if ( m_nTarget >= m_nTiles ) {
+		return;
+	}
+
+	// a full rebuild picks up any map changes as well
+	if ( m_bTargetMoved ) {
+		Rebuild();
+	} else if ( m_bDirty ) {
+		RepairArea( m_DirtyMins[0], m_DirtyMins[1], m_DirtyMaxs[0], m_DirtyMaxs[1] );
+	}
+	m_bTargetMoved = qfalse;
+	m_bDirty = qfalse;
+}
+
+void CAIFlowField::HeapSiftUp( int32_t index )
+{
+	navHeapNode_t node;
+	int32_t parent;
+
+	node = m_pHeap[ index ];
+	while ( index > 0 ) {
+		parent = ( index - 1 ) >> 1;
+		if ( m_pHeap[ parent ].f <= node.f ) {
+			break;
+		}
+		m_pHeap[ index ] = m_pHeap[ parent ];
+		m_pHeapIndex[ m_pHeap[ index ].tile ] = index;
+		index = parent;
+	}
+	m_pHeap[ index ] = node;
+	m_pHeapIndex[ node.tile ] = index;
+}
+
+void CAIFlowField::HeapSiftDown( int32_t index )
+{
+	navHeapNode_t node;
+	int32_t child;
+
+	node = m_pHeap[ index ];
+	for ( ;; ) {
+		child = ( index << 1 ) + 1;
+		if ( child >= m_nHeapSize ) {
+			break;
+		}
+		if ( child + 1 < m_nHeapSize && m_pHeap[ child + 1 ].f < m_pHeap[ child ].f ) {
+			child++;
+		}
+		if ( node.f <= m_pHeap[ child ].f ) {
+			break;
+		}
+		m_pHeap[ index ] = m_pHeap[ child ];
+		m_pHeapIndex[ m_pHeap[ index ].tile ] = index;
+		index = child;
+	}
+	m_pHeap[ index ] = node;
+	m_pHeapIndex[ node.tile ] = index;
+}
+
+/*
+* HeapPush: inserts the tile, or lowers its key if it's already queued
+*/
+void CAIFlowField::HeapPush( uint32_t tile, float f )
+{
+	if ( m_pHeapIndex[ tile ] != -1 ) {
+		m_pHeap[ m_pHeapIndex[ tile ] ].f = f;
+		HeapSiftUp( m_pHeapIndex[ tile ] );
+		return;
+	}
+	m_pHeap[ m_nHeapSize ].tile = tile;
+	m_pHeap[ m_nHeapSize ].f = f;
+	HeapSiftUp( m_nHeapSize++ );
+}
+
+uint32_t CAIFlowField::HeapPop( void )
+{
+	uint32_t tile;
+
+	tile = m_pHeap[0].tile;
+	m_pHeapIndex[ tile ] = -1;
+	if ( --m_nHeapSize > 0 ) {
+		m_pHeap[0] = m_pHeap[ m_nHeapSize ];
+		HeapSiftDown( 0 );
+	}
+	return tile;
+}
+
+/*
+* Relax: the field runs from the target outwards, so a neighbour is only updated if
+* it can step back onto this tile
+*/
+void CAIFlowField::Relax( uint32_t tile, float fMaxDistance )
+{
+	int32_t x, y, nx, ny;
+	uint32_t next, dir;
+	float distance;
+
+	x = tile % m_nWidth;
+	y = tile / m_nWidth;
+
+	for ( dir = 0; dir < NAV_DIRS; dir++ ) {
+		nx = x + navDirX[ dir ];
+		ny = y + navDirY[ dir ];
+		if ( nx < 0 || ny < 0 || nx >= (int32_t)m_nWidth || ny >= (int32_t)m_nHeight ) {
+			continue;
+		}
+		next = ny * m_nWidth + nx;
+		if ( !m_pNavMesh->CanMove( next, (dirtype_t)FLOW_INVERSE_DIR( dir ) ) ) {
+			continue;
+		}
+
+		distance = m_pDistance[ tile ] + ( ( dir & 1 ) ? NAV_COST_DIAGONAL : NAV_COST_STRAIGHT );
+		if ( distance > fMaxDistance ) {
+			continue;
+		}
+		if ( m_pStamps[ next ] == m_nStamp && m_pDistance[ next ] <= distance ) {
+			continue;
+		}
+
+		m_pStamps[ next ] = m_nStamp;
+		m_pDistance[ next ] = distance;
+		m_pDirections[ next ] = FLOW_INVERSE_DIR( dir );
+		HeapPush( next, distance );
+	}
+}
+
+void CAIFlowField::RunDijkstra( float fMaxDistance )
+{
+	while ( m_nHeapSize ) {
+		Relax( HeapPop(), fMaxDistance );
+		m_nExpanded++;
+	}
+}
+
+/*
+* Rebuild: throws the old field away by bumping the stamp, only the tiles within
+* ai_flowFieldRadius are ever touched so the size of the map doesn't matter
+*/
+void CAIFlowField::Rebuild( void )
+{
+	PROFILE_FUNCTION();
+
+	m_nExpanded = 0;
+	if ( m_nTarget >= m_nTiles ) {
+		return;
+	}
+
+	if ( ++m_nStamp == 0 ) {
+		memset( m_pStamps, 0, sizeof( *m_pStamps ) * m_nTiles );
+		m_nStamp = 1;
+	}
+
+	m_pStamps[ m_nTarget ] = m_nStamp;
+	m_pDistance[ m_nTarget ] = 0.0f;
+	m_pDirections[ m_nTarget ] = DIR_NULL;
+	HeapPush( m_nTarget, 0.0f );
+
+	RunDijkstra( ai_flowFieldRadius->f );
+}
+
+/*
+* RepairArea: every tile whose path to the target ran through the changed area is
+* thrown out, then they're seeded again from their untouched neighbours. The changed
+* tiles are queued as well so that a newly opened passage can shorten the paths around it
+*/
+void CAIFlowField::RepairArea( uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1 )
+{
+	uint32_t x, y, tile, next, dir, head, tail, best;
+	int32_t nx, ny;
+	float distance, fMaxDistance;
+
+	PROFILE_FUNCTION();
+
+	m_nExpanded = 0;
+	if ( m_nTarget >= m_nTiles ) {
+		return;
+	}
+
+	// the nav mesh masks change up to two tiles out from the rebuilt area
+	x0 = x0 > 1 ? x0 - 2 : 0;
+	y0 = y0 > 1 ? y0 - 2 : 0;
+	x1 = MIN( x1 + 2, m_nWidth - 1 );
+	y1 = MIN( y1 + 2, m_nHeight - 1 );
+
+	if ( m_nTarget % m_nWidth >= x0 && m_nTarget % m_nWidth <= x1 && m_nTarget / m_nWidth >= y0 && m_nTarget / m_nWidth <= y1 ) {
+		Rebuild();
+		return;
+	}
+
+	fMaxDistance = ai_flowFieldRadius->f;
+	head = tail = 0;
+
+	for ( y = y0; y <= y1; y++ ) {
+		for ( x = x0; x <= x1; x++ ) {
+			tile = y * m_nWidth + x;
+			if ( m_pStamps[ tile ] == m_nStamp ) {
+				m_pStamps[ tile ] = m_nStamp - 1;
+				m_pQueue[ tail++ ] = tile;
+			}
+		}
+	}
+
+	// find everything downstream, a tile depends on the neighbour it points at
+	while ( head < tail ) {
+		tile = m_pQueue[ head++ ];
+		for ( dir = 0; dir < NAV_DIRS; dir++ ) {
+			nx = (int32_t)( tile % m_nWidth ) + navDirX[ dir ];
+			ny = (int32_t)( tile / m_nWidth ) + navDirY[ dir ];
+			if ( nx < 0 || ny < 0 || nx >= (int32_t)m_nWidth || ny >= (int32_t)m_nHeight ) {
+				continue;
+			}
+			next = ny * m_nWidth + nx;
+			if ( m_pStamps[ next ] == m_nStamp && m_pDirections[ next ] == FLOW_INVERSE_DIR( dir ) ) {
+				m_pStamps[ next ] = m_nStamp - 1;
+				m_pQueue[ tail++ ] = next;
+			}
+		}
+	}
+
+	// seed the thrown out tiles from whatever still has a valid distance
+	for ( head = 0; head < tail; head++ ) {
+		tile = m_pQueue[ head ];
+		best = DIR_NULL;
+		distance = fMaxDistance;
+		for ( dir = 0; dir < NAV_DIRS; dir++ ) {
+			if ( !m_pNavMesh->CanMove( tile, (dirtype_t)dir ) ) {
+				continue;
+			}
+			next = tile + navDirY[ dir ] * (int32_t)m_nWidth + navDirX[ dir ];
+			if ( m_pStamps[ next ] != m_nStamp ) {
+				continue;
+			}
+			if ( m_pDistance[ next ] + ( ( dir & 1 ) ? NAV_COST_DIAGONAL : NAV_COST_STRAIGHT ) <= distance ) {
+				distance = m_pDistance[ next ] + ( ( dir & 1 ) ? NAV_COST_DIAGONAL : NAV_COST_STRAIGHT );
+				best = dir;
+			}
+		}
+		if ( best != DIR_NULL ) {
+			m_pStamps[ tile ] = m_nStamp;
+			m_pDistance[ tile ] = distance;
+			m_pDirections[ tile ] = best;
+			HeapPush( tile, distance );
+		}
+	}
+
+	// untouched tiles inside the area can lead through a new opening
+	for ( y = y0; y <= y1; y++ ) {
+		for ( x = x0; x <= x1; x++ ) {
+			tile = y * m_nWidth + x;
+			if ( m_pStamps[ tile ] == m_nStamp ) {
+				HeapPush( tile, m_pDistance[ tile ] );
+			}
+		}
+	}
+
+	RunDijkstra( fMaxDistance );
+}
+
+/*
+* G_FlowBench_f: chases a randomly walking target with 500 mobs on a synthetic map,
+* once with the shared flow field and once with a search per mob, then checks that
+* repairing the field after a door toggles matches a full rebuild
+*/
+void G_FlowBench_f( void )
+{
+	CAIAStarNavMesh *navMesh;
+	CAIFlowField *flowField;
+	void *pNavMemory, *pFlowMemory;
+	mapinfo_t info;
+	uint32_t *mobs;
+	uint32_t *waypoints;
+	float *distances;
+	vec3_t origin;
+	uint32_t i, j, nMobs, nTics, nDoors, nMismatched, nWaypoints, tile, dir, x, y;
+	uint64_t startTime, buildTime, sampleTime, searchTime, repairTime;
+	uint64_t buildExpanded, repairExpanded;
+	int seed;
+
+	nMobs = 500;
+	nTics = 1000;
+	if ( Cmd_Argc() > 1 ) {
+		nMobs = MAX( atoi( Cmd_Argv( 1 ) ), 1 );
+	}
+
+	memset( &info, 0, sizeof( info ) );
+	N_strncpyz( info.name, "flow_bench", sizeof( info.name ) );
+	info.width = 512;
+	info.height = 512;
+	info.numTiles = info.width * info.height;
+	info.numLevels = 1;
+
+	info.tiles = (maptile_t *)Hunk_AllocateTempMemory( sizeof( *info.tiles ) * info.numTiles );
+	memset( info.tiles, 0, sizeof( *info.tiles ) * info.numTiles );
+
+	seed = 0x4e4d4144;
+	for ( i = 0; i < info.numTiles; i++ ) {
+		if ( Q_random( &seed ) < 0.1f ) {
+			info.tiles[i].flags |= TILESIDE_INSIDE;
+		}
+	}
+
+	navMesh = new ( Hunk_AllocateTempMemory( sizeof( *navMesh ) ) ) CAIAStarNavMesh();
+	pNavMemory = Hunk_AllocateTempMemory( CAIAStarNavMesh::MemoryRequired( info.width, info.height ) );
+	navMesh->Init( &info, pNavMemory );
+
+	flowField = new ( Hunk_AllocateTempMemory( sizeof( *flowField ) ) ) CAIFlowField();
+	pFlowMemory = Hunk_AllocateTempMemory( CAIFlowField::MemoryRequired( info.width, info.height ) );
+	flowField->Init( navMesh, pFlowMemory );
+
+	mobs = (uint32_t *)Hunk_AllocateTempMemory( sizeof( *mobs ) * nMobs );
+	waypoints = (uint32_t *)Hunk_AllocateTempMemory( sizeof( *waypoints ) * MAX_PATH_WAYPOINTS );
+	distances = (float *)Hunk_AllocateTempMemory( sizeof( *distances ) * info.numTiles );
+
+	// the target wanders around the middle of the map with the mobs scattered around it
+	VectorSet( origin, info.width / 2, info.height / 2, 0.0f );
+	for ( i = 0; i < nMobs; i++ ) {
+		x = info.width / 2 - 48 + (uint32_t)( Q_random( &seed ) * 96.0f );
+		y = info.height / 2 - 48 + (uint32_t)( Q_random( &seed ) * 96.0f );
+		mobs[i] = y * info.width + x;
+	}
+
+	// what every mob searching on its own would cost for a single tic
+	tile = navMesh->TileForPoint( origin );
+	startTime = Sys_Milliseconds();
+	for ( j = 0; j < nMobs; j++ ) {
+		navMesh->FindPath( mobs[j], tile, qtrue, waypoints, &nWaypoints, MAX_PATH_WAYPOINTS, NULL );
+	}
+	searchTime = Sys_Milliseconds() - startTime;
+
+	buildTime = sampleTime = 0;
+	buildExpanded = 0;
+	for ( i = 0; i < nTics; i++ ) {
+		if ( ( i & 7 ) == 0 ) {
+			origin[0] = MAX( 0.0f, MIN( origin[0] + (int)( Q_random( &seed ) * 3.0f ) - 1, info.width - 1.0f ) );
+			origin[1] = MAX( 0.0f, MIN( origin[1] + (int)( Q_random( &seed ) * 3.0f ) - 1, info.height - 1.0f ) );
+		}
+
+		startTime = Sys_Milliseconds();
+		flowField->SetTarget( origin );
+		flowField->Update();
+		buildTime += Sys_Milliseconds() - startTime;
+		buildExpanded += flowField->NumExpanded();
+
+		startTime = Sys_Milliseconds();
+		for ( j = 0; j < nMobs; j++ ) {
+			dir = flowField->GetDirection( mobs[j] );
+			if ( dir != DIR_NULL ) {
+				mobs[j] += navDirY[ dir ] * (int32_t)info.width + navDirX[ dir ];
+			}
+		}
+		sampleTime += Sys_Milliseconds() - startTime;
+	}
+
+	// toggle doors near the target and compare the repaired field with a fresh one
+	nDoors = 100;
+	nMismatched = 0;
+	repairTime = 0;
+	repairExpanded = 0;
+	for ( i = 0; i < nDoors; i++ ) {
+		x = MIN( (uint32_t)origin[0] - 32 + (uint32_t)( Q_random( &seed ) * 64.0f ), info.width - 1 );
+		y = MIN( (uint32_t)origin[1] - 32 + (uint32_t)( Q_random( &seed ) * 64.0f ), info.height - 1 );
+		tile = y * info.width + x;
+		if ( tile == flowField->GetTarget() ) {
+			continue;
+		}
+		info.tiles[ tile ].flags ^= TILESIDE_INSIDE;
+		navMesh->RebuildArea( x, y, x, y );
+
+		startTime = Sys_Milliseconds();
+		flowField->MarkDirty( x, y, x, y );
+		flowField->Update();
+		repairTime += Sys_Milliseconds() - startTime;
+		repairExpanded += flowField->NumExpanded();
+
+		for ( j = 0; j < info.numTiles; j++ ) {
+			distances[j] = flowField->GetDistance( j );
+		}
+		flowField->Rebuild();
+		for ( j = 0; j < info.numTiles; j++ ) {
+			if ( fabsf( distances[j] - flowField->GetDistance( j ) ) > 0.01f ) {
+				nMismatched++;
+			}
+		}
+	}
+
+	Con_Printf( "flow_bench: %ux%u map, %u mobs, %u tics, radius %i\n", info.width, info.height, nMobs, nTics, ai_flowFieldRadius->i );
+	Con_Printf( "field updates: %lu msec total, %.3f msec/tic, %lu tiles expanded\n", buildTime, (float)buildTime / nTics, buildExpanded );
+	Con_Printf( "mob lookups: %lu msec total, %.3f msec/tic\n", sampleTime, (float)sampleTime / nTics );
+	Con_Printf( "one search per mob: %lu msec for a single tic\n", searchTime );
+	Con_Printf( "%u door repairs: %lu msec, %lu tiles expanded, %u tiles mismatched\n", nDoors, repairTime, repairExpanded, nMismatched );
+
+	Hunk_FreeTempMemory( distances );
+	Hunk_FreeTempMemory( waypoints );
+	Hunk_FreeTempMemory( mobs );
+	Hunk_FreeTempMemory( pFlowMemory );
+	flowField->~CAIFlowField();
+	Hunk_FreeTempMemory( flowField );
+	Hunk_FreeTempMemory( pNavMemory );
+	navMesh->~CAIAStarNavMesh();
+	Hunk_FreeTempMemory( navMesh );
+	Hunk_FreeTempMemory( info.tiles );
+}
@@ -0,0 +1,85 @@
+#ifndef __AI_FLOWFIELD_H__
+#define __AI_FLOWFIELD_H__
+
+#pragma once
+
+#include "AIAStarNavMesh.h"
+
+/*
+* CAIFlowField: a distance map from every tile around a single target (the player) back to
+* it, built with Dijkstra over the nav mesh's move masks. Every mob chasing the target only
+* has to look up the direction stored in its tile instead of running its own search.
+*
+* The field is only rebuilt when the target moves onto another tile and is limited to
+* ai_flowFieldRadius, when the map changes only the tiles whose path went through the
+* changed area are recomputed.
+*/
+class CAIFlowField
+{
+public:
+	CAIFlowField( void );
+	~CAIFlowField();
+
+	static uint64_t MemoryRequired( uint32_t width, uint32_t height );
+
+	void Init( const CAIAStarNavMesh *pNavMesh, void *pMemory );
+	void SetTarget( const vec3_t origin );
+	void MarkDirty( uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1 );
+	void Update( void );
+
+	void Rebuild( void );
+	void RepairArea( uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1 );
+
+	inline dirtype_t GetDirection( uint32_t tile ) const {
+		return m_pStamps[ tile ] == m_nStamp ? (dirtype_t)m_pDirections[ tile ] : DIR_NULL;
+	}
+	inline float GetDistance( uint32_t tile ) const {
+		return m_pStamps[ tile ] == m_nStamp ? m_pDistance[ tile ] : -1.0f;
+	}
+	inline uint32_t GetTarget( void ) const {
+		return m_nTarget;
+	}
+	inline uint32_t NumExpanded( void ) const {
+		return m_nExpanded;
+	}
+private:
+	void HeapPush( uint32_t tile, float f );
+	uint32_t HeapPop( void );
+	void HeapSiftUp( int32_t index );
+	void HeapSiftDown( int32_t index );
+
+	void Relax( uint32_t tile, float fMaxDistance );
+	void RunDijkstra( float fMaxDistance );
+
+	const CAIAStarNavMesh *m_pNavMesh;
+	uint32_t m_nWidth;
+	uint32_t m_nHeight;
+	uint32_t m_nTiles;
+
+	uint32_t m_nTarget;
+	qboolean m_bTargetMoved;
+
+	// tiles from the last build belong to the field when their stamp is m_nStamp
+	float *m_pDistance;
+	uint8_t *m_pDirections;
+	uint32_t *m_pStamps;
+	uint32_t m_nStamp;
+
+	// always -1 for tiles that aren't in the heap
+	int32_t *m_pHeapIndex;
+	navHeapNode_t *m_pHeap;
+	int32_t m_nHeapSize;
+
+	uint32_t *m_pQueue;
+	uint32_t m_nExpanded;
+
+	qboolean m_bDirty;
+	uint32_t m_DirtyMins[2];
+	uint32_t m_DirtyMaxs[2];
+};
+
+extern CAIFlowField *g_pFlowField;
+
+void G_FlowBench_f( void );
+
+#endif
@@ -3,6 +3,9 @@
 
 #include <zlib.h>
 #include <bzlib.h>
+#include <zstd/zstd.h>
+#include <lz4.h>
+#include <lz4hc.h>
 
 #define BUFFER_SIZE (8*1024)
 
@@ -174,6 +177,49 @@ static char *Compress_ZLIB( void *buf, uint64_t buflen, uint64_t *outlen )
 	return newbuf;
 }
 
+static char *Compress_ZSTD( void *buf, uint64_t buflen, uint64_t *outlen )
+{
+	char *out;
+	size_t ret;
+
+	Con_Printf( "Compressing %lu bytes with zstd...\n", buflen );
+
+	out = (char *)Z_Malloc( ZSTD_compressBound( buflen ), TAG_BFF );
+	ret = ZSTD_compress( out, ZSTD_compressBound( buflen ), buf, buflen, 19 );
+	if ( ZSTD_isError( ret ) ) {
+		N_Error( ERR_FATAL, "ZStd Compression Failure: failure on compression of %lu bytes. ZSTD error reason:\n\t%s", buflen,
+			ZSTD_getErrorName( ret ) );
+	}
+
+	Con_Printf( "Successful compression of %lu to %lu bytes with zstd.\n", buflen, (uint64_t)ret );
+	*outlen = ret;
+
+	return out;
+}
+
+static char *Compress_LZ4( void *buf, uint64_t buflen, uint64_t *outlen )
+{
+	char *out;
+	int ret;
+
+	if ( buflen > LZ4_MAX_INPUT_SIZE ) {
+		N_Error( ERR_FATAL, "LZ4 Compression Failure: %lu bytes is over the maximum of %i", buflen, LZ4_MAX_INPUT_SIZE );
+	}
+
+	Con_Printf( "Compressing %lu bytes with lz4...\n", buflen );
+
+	out = (char *)Z_Malloc( LZ4_compressBound( buflen ), TAG_BFF );
+	ret = LZ4_compress_HC( (const char *)buf, out, buflen, LZ4_compressBound( buflen ), LZ4HC_CLEVEL_MAX );
+	if ( ret <= 0 ) {
+		N_Error( ERR_FATAL, "LZ4 Compression Failure: failure on compression of %lu bytes", buflen );
+	}
+
+	Con_Printf( "Successful compression of %lu to %i bytes with lz4.\n", buflen, ret );
+	*outlen = ret;
+
+	return out;
+}
+
 char *Compress( void *buf, uint64_t buflen, uint64_t *outlen, int compression )
 {
 	switch ( compression ) {
@@ -181,6 +227,10 @@ char *Compress( void *buf, uint64_t buflen, uint64_t *outlen, int compression )
 		return Compress_BZIP2( buf, buflen, outlen );
 	case COMPRESS_ZLIB:
 		return Compress_ZLIB( buf, buflen, outlen );
+	case COMPRESS_ZSTD:
+		return Compress_ZSTD( buf, buflen, outlen );
+	case COMPRESS_LZ4:
+		return Compress_LZ4( buf, buflen, outlen );
 	default:
 		break;
 	};
@@ -243,6 +293,51 @@ char *Decompress_ZLIB( void *buf, uint64_t buflen, uint64_t *outlen )
 	return out;
 }
 
+/*
+* Decompress_ZSTD: the size is known up front, so unlike zlib and bzip2 this goes straight
+* into the final buffer without a copy through the temp hunk
+*/
+static char *Decompress_ZSTD( void *buf, uint64_t buflen, uint64_t *outlen )
+{
+	char *out;
+	size_t ret;
+
+	Con_Printf( "Decompressing %lu bytes with zstd...\n", buflen );
+
+	out = (char *)Z_Malloc( *outlen, TAG_BFF );
+	ret = ZSTD_decompress( out, *outlen, buf, buflen );
+	if ( ZSTD_isError( ret ) ) {
+		N_Error( ERR_FATAL, "ZStd Decompression Failure: failure on decompression of %lu bytes. ZSTD error reason: %s", buflen,
+			ZSTD_getErrorName( ret ) );
+	}
+	*outlen = ret;
+
+	Con_Printf( "Successful decompression of %lu bytes to %lu bytes with zstd (inflate %0.02f%%).\n", buflen, *outlen,
+		( (float)*outlen / (float)buflen ) );
+
+	return out;
+}
+
+static char *Decompress_LZ4( void *buf, uint64_t buflen, uint64_t *outlen )
+{
+	char *out;
+	int ret;
+
+	Con_Printf( "Decompressing %lu bytes with lz4...\n", buflen );
+
+	out = (char *)Z_Malloc( *outlen, TAG_BFF );
+	ret = LZ4_decompress_safe( (const char *)buf, out, buflen, *outlen );
+	if ( ret < 0 ) {
+		N_Error( ERR_FATAL, "LZ4 Decompression Failure: failure on decompression of %lu bytes, the buffer is corrupted", buflen );
+	}
+	*outlen = ret;
+
+	Con_Printf( "Successful decompression of %lu bytes to %lu bytes with lz4 (inflate %0.02f%%).\n", buflen, *outlen,
+		( (float)*outlen / (float)buflen ) );
+
+	return out;
+}
+
 char *Decompress( void *buf, uint64_t buflen, uint64_t *outlen, int compression )
 {
 	switch ( compression ) {
@@ -250,8 +345,42 @@ char *Decompress( void *buf, uint64_t buflen, uint64_t *outlen, int compression
 		return Decompress_BZIP2( buf, buflen, outlen );
 	case COMPRESS_ZLIB:
 		return Decompress_ZLIB( buf, buflen, outlen );
+	case COMPRESS_ZSTD:
+		return Decompress_ZSTD( buf, buflen, outlen );
+	case COMPRESS_LZ4:
+		return Decompress_LZ4( buf, buflen, outlen );
 	default:
 		break;
 	};
 	return (char *)buf;
-}
\ No newline at end of file
+}
+
+/*
+* DecompressInto: decompresses into a buffer the caller already sized, returns qfalse if the data's corrupt
+* or doesn't come out to exactly outlen bytes. Doesn't allocate, print or error out, so it's safe on any thread
+*/
+qboolean DecompressInto( const void *buf, uint64_t buflen, void *out, uint64_t outlen, int compression )
+{
+	switch ( compression ) {
+	case COMPRESS_BZIP2: {
+		unsigned int len = (unsigned int)outlen;
+		return BZ2_bzBuffToBuffDecompress( (char *)out, &len, (char *)buf, buflen, 0, 0 ) == BZ_OK && len == outlen;
+	}
+	case COMPRESS_ZLIB: {
+		uLongf len = outlen;
+		return uncompress( (Bytef *)out, &len, (const Bytef *)buf, buflen ) == Z_OK && len == outlen;
+	}
+	case COMPRESS_ZSTD: {
+		const size_t ret = ZSTD_decompress( out, outlen, buf, buflen );
+		return !ZSTD_isError( ret ) && ret == outlen;
+	}
+	case COMPRESS_LZ4:
+		if ( buflen > INT_MAX || outlen > INT_MAX ) {
+			return qfalse;
+		}
+		return LZ4_decompress_safe( (const char *)buf, (char *)out, (int)buflen, (int)outlen ) == (int)outlen;
+	default:
+		break;
+	};
+	return qfalse;
+}
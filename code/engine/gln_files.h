@@ -87,6 +87,8 @@ typedef enum { qfalse = 0, qtrue = 1 } qboolean;
 #define COMPRESS_NONE 0
 #define COMPRESS_ZLIB 1
 #define COMPRESS_BZIP2 2
+#define COMPRESS_ZSTD 5
+#define COMPRESS_LZ4 6
 
 #define TEXTURE_FILE_EXT ".tex2d"
 #define TILESET_FILE_EXT ".tile2d"
@@ -38,6 +38,8 @@ cvar_t *com_logfile;
 cvar_t *com_maxfps;
 cvar_t *com_maxfpsUnfocused;
 cvar_t *com_yieldCPU;
+static cvar_t *com_maxfpsMinimized;
+static cvar_t *com_frameSpin;
 cvar_t *com_pauseUnfocused;
 errorCode_t com_errorCode;
 #ifdef USE_AFFINITY_MASK
@@ -51,6 +53,7 @@ cvar_t *com_viewlog;
 cvar_t *com_timescale;
 cvar_t *com_fixedtime;
 cvar_t *com_timedemo;
+static cvar_t *com_configWriteDelay;
 static int lastTime;
 int com_frameTime;
 uint64_t com_frameNumber = 0;
@@ -106,16 +109,25 @@ static qboolean printableChar( char c ) {
 	return qfalse;
 }
 
-void GDR_ATTRIBUTE((format(printf, 1, 2))) GDR_DECL Con_Printf( const char *fmt, ... )
+/*
+* Con_LogLevel: guesses how bad a message is from the color it starts with
+*/
+static logLevel_t Con_LogLevel( const char *msg )
 {
-    va_list argptr;
-    int length, i;
-    char msg[MAXPRINTMSG];
+	if ( !N_strncmp( msg, COLOR_RED, 2 ) ) {
+		return LOG_ERROR;
+	} else if ( !N_strncmp( msg, COLOR_YELLOW, 2 ) ) {
+		return LOG_WARNING;
+	}
+	return LOG_INFO;
+}
+
+static void Con_PrintLevel( logLevel_t level, char *msg )
+{
+    int length;
     static qboolean opening_console = qfalse;
 
-    va_start( argptr, fmt );
-    length = N_vsnprintf( msg, sizeof( msg ) - 1, fmt, argptr );
-    va_end( argptr );
+    length = strlen( msg );
 
     if ( rd_buffer && !rd_flushing ) {
         if ( length + strlen( rd_buffer ) > ( rd_buffersize + 1 ) ) {
@@ -130,9 +142,6 @@ void GDR_ATTRIBUTE((format(printf, 1, 2))) GDR_DECL Con_Printf( const char *fmt,
     // append to the debug console buffer
 	G_ConsolePrint( msg );
 
-    // echo to the actual console
-    Sys_Print( msg );
-
     // slap that shit into the logfile
     if ( com_logfile && com_logfile->i ) {
         if ( logfile == FS_INVALID_HANDLE && FS_Initialized() && !opening_console ) {
@@ -170,10 +179,21 @@ void GDR_ATTRIBUTE((format(printf, 1, 2))) GDR_DECL Con_Printf( const char *fmt,
 			}
             opening_console = qfalse;
         }
+    }
+
+    // the log writer thread takes care of the terminal and the logfile if it's running
+    if ( Com_LogPrint( level, msg, length ) ) {
+        return;
+    }
+
+    // echo to the actual console
+    Sys_Print( msg );
+
+    if ( com_logfile && com_logfile->i ) {
         if ( logfile != FS_INVALID_HANDLE && FS_Initialized() ) {
 			char *ptr = msg;
 			char *out = msg;
-	        while ( *ptr != '\0' && out < ptr + sizeof( msg ) ) {
+	        while ( *ptr != '\0' ) {
 				while ( Q_IsColorString( ptr ) && *( ptr + 1 ) != '\n' ) {
 					ptr += 2;
 				}
@@ -188,6 +208,18 @@ void GDR_ATTRIBUTE((format(printf, 1, 2))) GDR_DECL Con_Printf( const char *fmt,
     }
 }
 
+void GDR_ATTRIBUTE((format(printf, 1, 2))) GDR_DECL Con_Printf( const char *fmt, ... )
+{
+    va_list argptr;
+    char msg[MAXPRINTMSG];
+
+    va_start( argptr, fmt );
+    N_vsnprintf( msg, sizeof( msg ) - 1, fmt, argptr );
+    va_end( argptr );
+
+    Con_PrintLevel( Con_LogLevel( msg ), msg );
+}
+
 void GDR_ATTRIBUTE((format(printf, 1, 2))) GDR_DECL Con_DPrintf( const char *fmt, ... )
 {
 	va_list argptr;
@@ -197,11 +229,13 @@ void GDR_ATTRIBUTE((format(printf, 1, 2))) GDR_DECL Con_DPrintf( const char *fmt
 		return; // don't confuse non-developers with techie stuff... "it's a techy thing!"
 	}
 
+	msg[0] = Q_COLOR_ESCAPE;
+	msg[1] = COLOR_CYAN[1];
 	va_start( argptr,fmt );
-	N_vsnprintf( msg, sizeof( msg ), fmt, argptr );
+	N_vsnprintf( msg + 2, sizeof( msg ) - 3, fmt, argptr );
 	va_end( argptr );
 
-	Con_Printf( COLOR_CYAN "%s", msg );
+	Con_PrintLevel( LOG_DEVELOPER, msg );
 }
 
 void GDR_NORETURN GDR_ATTRIBUTE((format(printf, 2, 3))) GDR_DECL N_Error( errorCode_t code, const char *err, ... )
@@ -607,11 +641,6 @@ void Com_QueueEvent( uint32_t evTime, sysEventType_t evType, uint32_t evValue, u
 	ev->evPtrLength = ptrLength;
 	ev->evPtr = ptr;
 
-	if ( gi.state == GS_LEVEL && gi.demorecording && gi.recordfile != FS_INVALID_HANDLE ) {
-		// record to the demofile
-		G_RecordEvent( ev );
-	}
-
 	lastEvent = ev;
 }
 
@@ -624,6 +653,32 @@ static sysEvent_t Com_GetEvent( void )
 	return Com_GetRealEvent();
 }
 
+/*
+* Com_RunEvent: hands a single event to whatever handles it, demo playback runs its events through here too
+*/
+void Com_RunEvent( const sysEvent_t *ev )
+{
+	switch ( ev->evType ) {
+	case SE_KEY:
+		G_KeyEvent( ev->evValue, (qboolean)ev->evValue2, ev->evTime );
+		break;
+	case SE_MOUSE:
+		G_MouseEvent( ev->evValue, ev->evValue2 );
+		break;
+	case SE_JOYSTICK_AXIS:
+		G_JoystickEvent( ev->evValue, ev->evValue2, ev->evTime );
+		break;
+	case SE_CHAR:
+		break;
+	case SE_CONSOLE:
+		Cbuf_AddText( (char *)ev->evPtr );
+		Cbuf_AddText("\n");
+		break;
+	default:
+		N_Error( ERR_FATAL, "Com_RunEvent: bad event type %i", ev->evType );
+	};
+}
+
 uint64_t Com_EventLoop( void )
 {
 	sysEvent_t ev;
@@ -636,25 +691,12 @@ uint64_t Com_EventLoop( void )
 			return ev.evTime;
 		}
 
-		switch ( ev.evType ) {
-		case SE_KEY:
-			G_KeyEvent( ev.evValue, (qboolean)ev.evValue2, ev.evTime );
-			break;
-		case SE_MOUSE:
-			G_MouseEvent( ev.evValue, ev.evValue2 );
-			break;
-		case SE_JOYSTICK_AXIS:
-			G_JoystickEvent( ev.evValue, ev.evValue2, ev.evTime );
-			break;
-		case SE_CHAR:
-			break;
-		case SE_CONSOLE:
-			Cbuf_AddText( (char *)ev.evPtr );
-			Cbuf_AddText("\n");
-			break;
-		default:
-			N_Error( ERR_FATAL, "Com_EventLoop: bad event type %i", ev.evType );
-		};
+		if ( gi.state == GS_LEVEL && gi.demorecording && gi.recordfile != FS_INVALID_HANDLE ) {
+			// record to the demofile, after mouse moves are combined so it gets exactly what the game does
+			G_RecordEvent( &ev );
+		}
+
+		Com_RunEvent( &ev );
 
 		// free any block data
 		if ( ev.evPtr ) {
@@ -810,8 +852,15 @@ static void Com_GameRestart_f( void ) {
 /*
 * Com_Shutdown: closes logging files
 */
+static void Com_WaitConfigWriter( void );
+
 void Com_Shutdown( void )
 {
+	Com_WaitConfigWriter();
+
+	// everything that's still queued has to make it into the logfile before it's closed
+	Com_ShutdownLog();
+
 	if ( logfile != FS_INVALID_HANDLE ) {
 		FS_FClose( logfile );
 		logfile = FS_INVALID_HANDLE;
@@ -1415,6 +1464,7 @@ void Com_Quit_f( void ) {
 		// which would trigger an unload of active VM error.
 		// Sys_Quit will kill this process anyways, so
 		// a corrupt call stack makes no difference
+		Com_FlushConfiguration();
 		G_Shutdown( qtrue );
 		Com_Shutdown();
 		FS_Shutdown( qtrue );
@@ -1445,6 +1495,9 @@ int Com_Milliseconds( void )
 }
 
 static void Com_WriteConfig_f( void );
+static void Com_ConfigTest_f( void );
+static void Com_FrameStats_f( void );
+static void Com_PacerTest_f( void );
 
 static void Com_PrintDivider( void ) {
 	for (uint32_t i = 0; i < 75; ++i) {
@@ -1596,6 +1649,9 @@ void Com_Init( char *commandLine )
 	Com_InitJournals();
 	Com_LoadConfig();
 
+	Com_StartupVariable( "com_logAsync" );
+	Com_InitLog();
+
 #ifdef _NOMAD_EXPERIMENTAL
 	Con_Printf( "\n*****************************\n"
 				"NOTICE: This is an experimental build of \"The Nomad\",\n"
@@ -1615,6 +1671,7 @@ void Com_Init( char *commandLine )
 	// if any archived cvars are modified after this, we will trigger a writing
 	// of the config file
 	cvar_modifiedFlags &= ~CVAR_SAVE;
+	key_bindingsModified = qfalse;
 
 	//
 	// init commands and vars
@@ -1632,11 +1689,20 @@ void Com_Init( char *commandLine )
 	com_maxfpsUnfocused = Cvar_Get( "com_maxfpsUnfocused", "60", CVAR_ARCHIVE_ND );
 	Cvar_CheckRange( com_maxfpsUnfocused, "0", "1000", CVT_INT );
 	Cvar_SetDescription( com_maxfpsUnfocused, "Sets maximum frames per second in unfocused game window." );
+	com_maxfpsMinimized = Cvar_Get( "com_maxfpsMinimized", "15", CVAR_ARCHIVE_ND );
+	Cvar_CheckRange( com_maxfpsMinimized, "0", "1000", CVT_INT );
+	Cvar_SetDescription( com_maxfpsMinimized, "Sets maximum frames per second while the game window is minimized, 0 uses com_maxfpsUnfocused." );
 	com_yieldCPU = Cvar_Get( "com_yieldCPU", "1", CVAR_ARCHIVE_ND );
 	Cvar_CheckRange( com_yieldCPU, "0", "16", CVT_INT );
-	Cvar_SetDescription( com_yieldCPU, "Attempt to sleep specified amount of time between rendered frames when game is active, this will greatly reduce CPU load. Use 0 only if you're experiencing some lag." );
+	Cvar_SetDescription( com_yieldCPU, "Sleep between rendered frames instead of busy waiting, this will greatly reduce CPU load. Use 0 only if you're experiencing some lag." );
+	com_frameSpin = Cvar_Get( "com_frameSpin", "500", CVAR_ARCHIVE_ND );
+	Cvar_CheckRange( com_frameSpin, "0", "4000", CVT_INT );
+	Cvar_SetDescription( com_frameSpin, "Microseconds at the end of each frame's time slice that are busy waited instead of slept through, raise it if the frame rate isn't steady." );
 	com_pauseUnfocused = Cvar_Get( "com_pauseUnfocused", "0", CVAR_SAVE );
 	Cvar_SetDescription( com_pauseUnfocused, "Pauses the game when set to \"1\" when game window is unfocused." );
+	com_configWriteDelay = Cvar_Get( "com_configWriteDelay", "2", CVAR_SAVE );
+	Cvar_CheckRange( com_configWriteDelay, "0", "60", CVT_INT );
+	Cvar_SetDescription( com_configWriteDelay, "Minimum number of seconds between two writes of the config file, changes made in between are written together." );
 #ifdef USE_AFFINITY_MASK
 	Com_StartupVariable( "com_affinityMask" );
 	com_affinityMask = Cvar_Get( "com_affinityMask", "0x6", CVAR_SAVE | CVAR_LATCH );
@@ -1696,6 +1762,10 @@ void Com_Init( char *commandLine )
 	Cmd_AddCommand( "writeconfig", Com_WriteConfig_f );
 	Cmd_SetCommandCompletionFunc( "writeconfig", Cmd_CompleteWriteCfgName );
 	Cmd_SetCommandCompletionFunc( "writecfg", Cmd_CompleteWriteCfgName );
+	Cmd_AddCommand( "com_logbench", Com_LogBench_f );
+	Cmd_AddCommand( "com_configtest", Com_ConfigTest_f );
+	Cmd_AddCommand( "com_framestats", Com_FrameStats_f );
+	Cmd_AddCommand( "com_pacertest", Com_PacerTest_f );
 
 	s = va( "%s %s %s", GLN_VERSION, OS_STRING, __DATE__ );
 	com_version = Cvar_Get( "version", s, CVAR_PROTECTED | CVAR_ROM );
@@ -1899,21 +1969,221 @@ out:
 #endif
 }
 
+/*
+===============================================================
+
+CONFIG WRITER
+
+the main thread only reformats the sections of the config that actually changed, a
+worker thread writes the snapshot into a temp file that's renamed over the old config,
+so the slider drags in the settings menu don't hitch and a crash mid-write never leaves
+a truncated config behind
+
+===============================================================
+*/
+
+#define CONFIG_HEADER \
+	"// generated by The Nomad, modify at your own risk" GDR_NEWLINE \
+	"// " OS_STRING ", " ARCH_STRING "" GDR_NEWLINE
+
+typedef struct {
+	char *pText;
+	uint64_t nLength;
+	uint64_t nSize;
+} configSection_t;
+
+typedef struct {
+	configSection_t binds;
+	configSection_t cvars;
+	configSection_t snapshot;	// only ever touched by the worker while it's running
+
+	char ospath[ MAX_OSPATH ];
+	char tmppath[ MAX_OSPATH ];
+
+	SDL_Thread *thread;
+	std::atomic<bool> writing;
+	std::atomic<bool> failed;
+
+	qboolean pending;			// the sections hold changes that haven't been written out yet
+	uint64_t lastWriteTime;
+} configWriter_t;
+
+static configWriter_t com_config;
+
+uint64_t Com_AppendText( char *buffer, uint64_t bufferSize, uint64_t offset, const char *text, uint64_t length )
+{
+	if ( offset + length < bufferSize ) {
+		memcpy( buffer + offset, text, length );
+		buffer[ offset + length ] = '\0';
+	}
+	return length;
+}
+
+static void Com_ReserveConfigSection( configSection_t *section, uint64_t length )
+{
+	if ( length < section->nSize ) {
+		return;
+	}
+	section->nSize = PAD( length + 1, 4096 );
+	section->pText = (char *)Z_Realloc( section->pText, section->nSize, TAG_STATIC );
+}
+
+static void Com_FormatConfigSection( configSection_t *section, uint64_t (*pfnWrite)( char *, uint64_t ) )
+{
+	// the writers report how much space they needed, so grow and run it again if it didn't fit
+	for ( ;; ) {
+		section->nLength = pfnWrite( section->pText, section->nSize );
+		if ( section->nLength < section->nSize ) {
+			break;
+		}
+		Com_ReserveConfigSection( section, section->nLength );
+	}
+}
+
+/*
+* Com_UpdateConfigSections: reformats whatever changed since the last call
+*/
+static void Com_UpdateConfigSections( void )
+{
+	// the first call only fills the cache, there's nothing to write until something changes
+	if ( key_bindingsModified || !com_config.binds.pText ) {
+		if ( key_bindingsModified ) {
+			com_config.pending = qtrue;
+		}
+		key_bindingsModified = qfalse;
+		Com_FormatConfigSection( &com_config.binds, Key_WriteBindings );
+	}
+	if ( ( cvar_modifiedFlags & CVAR_SAVE ) || !com_config.cvars.pText ) {
+		if ( cvar_modifiedFlags & CVAR_SAVE ) {
+			com_config.pending = qtrue;
+		}
+		cvar_modifiedFlags &= ~CVAR_SAVE;
+		Com_FormatConfigSection( &com_config.cvars, Cvar_WriteVariables );
+	}
+}
+
+static void Com_BuildConfigSnapshot( configSection_t *snapshot )
+{
+	snapshot->nLength = 0;
+	Com_ReserveConfigSection( snapshot, strlen( CONFIG_HEADER ) + com_config.binds.nLength + com_config.cvars.nLength );
+
+	snapshot->nLength += Com_AppendText( snapshot->pText, snapshot->nSize, snapshot->nLength, CONFIG_HEADER, strlen( CONFIG_HEADER ) );
+	snapshot->nLength += Com_AppendText( snapshot->pText, snapshot->nSize, snapshot->nLength, com_config.binds.pText, com_config.binds.nLength );
+	snapshot->nLength += Com_AppendText( snapshot->pText, snapshot->nSize, snapshot->nLength, com_config.cvars.pText, com_config.cvars.nLength );
+}
+
+/*
+* Com_WriteConfigText: writes the text into tmppath and swaps it with ospath once it's on the disk,
+* safe to call from any thread
+*/
+static qboolean Com_WriteConfigText( const char *ospath, const char *tmppath, const char *text, uint64_t length )
+{
+	FILE *fp;
+	qboolean ok;
+
+	fp = Sys_FOpen( tmppath, "wb" );
+	if ( !fp ) {
+		return qfalse;
+	}
+
+	ok = fwrite( text, 1, length, fp ) == length;
+	if ( ok ) {
+		ok = Sys_FSync( fp );
+	}
+	if ( fclose( fp ) != 0 ) {
+		ok = qfalse;
+	}
+
+	if ( !ok ) {
+		remove( tmppath );
+		return qfalse;
+	}
+	return Sys_ReplaceFile( tmppath, ospath );
+}
+
+static int Com_ConfigWriterThread( void *data )
+{
+	configWriter_t *writer = (configWriter_t *)data;
+
+	writer->failed.store( !Com_WriteConfigText( writer->ospath, writer->tmppath, writer->snapshot.pText,
+		writer->snapshot.nLength ), std::memory_order_relaxed );
+	writer->writing.store( false, std::memory_order_release );
+
+	return 0;
+}
+
+static void Com_SetConfigPath( const char *filename )
+{
+	N_strncpyz( com_config.ospath, FS_BuildOSPath( FS_GetHomePath(), FS_GetCurrentGameDir(), filename ), sizeof( com_config.ospath ) );
+	Com_snprintf( com_config.tmppath, sizeof( com_config.tmppath ), "%s.tmp", com_config.ospath );
+	FS_CreatePath( com_config.ospath );
+}
+
+/*
+* Com_WaitConfigWriter: joins the worker if there is one, the cloud gets the new config once it's on the disk
+*/
+static void Com_WaitConfigWriter( void )
+{
+	if ( !com_config.thread ) {
+		return;
+	}
+
+	SDL_WaitThread( com_config.thread, NULL );
+	com_config.thread = NULL;
+
+	if ( com_config.failed.load( std::memory_order_relaxed ) ) {
+		Con_Printf( COLOR_YELLOW "WARNING: couldn't write %s\n", com_config.ospath );
+		com_config.pending = qtrue;
+	} else {
+		SteamApp_CloudSave();
+	}
+}
+
+/*
+* Com_ConfigWriteDue: whether a write should start at time now, kept apart from the rest so that
+* com_configtest can run it against a fake clock
+*/
+static qboolean Com_ConfigWriteDue( uint64_t now, uint64_t lastWriteTime, uint64_t delay, qboolean pending, qboolean writing )
+{
+	if ( !pending || writing ) {
+		return qfalse;
+	}
+	return now - lastWriteTime >= delay;
+}
+
+static void Com_WriteCDKeys( void )
+{
+	const char *basegame;
+	const char *gamedir;
+
+	gamedir = Cvar_VariableString( "fs_game" );
+	basegame = Cvar_VariableString( "fs_basegame" );
+	if ( gamedir[0] && N_stricmp( basegame, gamedir ) ) {
+		Com_WriteCDKey( gamedir, &cl_cdkey[16] );
+	} else {
+		Com_WriteCDKey( basegame, cl_cdkey );
+	}
+//	if ( UI_usesUniqueCDKey() && gamedir[0] && Q_stricmp( basegame, gamedir ) ) {
+//		Com_WriteCDKey( gamedir, &cl_cdkey[16] );
+//	} else {
+//		Com_WriteCDKey( basegame, cl_cdkey );
+//	}
+}
+
 static void Com_WriteConfigToFile( const char *filename ) {
 	fileHandle_t f;
 
 	f = FS_FOpenWrite( filename );
 	if ( f == FS_INVALID_HANDLE ) {
-		if ( ( f = FS_FOpenWrite( filename ) ) == FS_INVALID_HANDLE ) {
-			Con_Printf( "Couldn't write %s.\n", filename );
-			return;
-		}
+		Con_Printf( "Couldn't write %s.\n", filename );
+		return;
 	}
 
-	FS_Printf( f, "// generated by The Nomad, modify at your own risk" GDR_NEWLINE );
-	FS_Printf( f, "// " OS_STRING ", " ARCH_STRING "" GDR_NEWLINE );
-	Key_WriteBindings( f );
-	Cvar_WriteVariables( f );
+	Com_UpdateConfigSections();
+
+	FS_Write( CONFIG_HEADER, strlen( CONFIG_HEADER ), f );
+	FS_Write( com_config.binds.pText, com_config.binds.nLength, f );
+	FS_Write( com_config.cvars.pText, com_config.cvars.nLength, f );
 	FS_FClose( f );
 }
 
@@ -1922,12 +2192,12 @@ static void Com_WriteConfigToFile( const char *filename ) {
 ===============
 Com_WriteConfiguration
 
-Writes key bindings and archived cvars to config file if modified
+Hands key bindings and archived cvars to the config writer if modified,
+no more than once every com_configWriteDelay seconds
 ===============
 */
 void Com_WriteConfiguration( void ) {
-	const char *basegame;
-	const char *gamedir;
+	uint64_t now;
 
 	// if we are quitting without fully initializing, make sure
 	// we don't write out anything
@@ -1935,26 +2205,171 @@ void Com_WriteConfiguration( void ) {
 		return;
 	}
 
-	if ( !( cvar_modifiedFlags & CVAR_SAVE ) ) {
+	Com_UpdateConfigSections();
+
+	if ( com_config.thread && !com_config.writing.load( std::memory_order_acquire ) ) {
+		Com_WaitConfigWriter();
+	}
+
+	now = Sys_Milliseconds();
+	if ( !Com_ConfigWriteDue( now, com_config.lastWriteTime, com_configWriteDelay->i * 1000, com_config.pending,
+		com_config.thread != NULL ) )
+	{
 		return;
 	}
-	cvar_modifiedFlags &= ~CVAR_SAVE;
 
+	com_config.pending = qfalse;
+	com_config.lastWriteTime = now;
+
+	Com_SetConfigPath( LOG_DIR "/" NOMAD_CONFIG );
+	Com_BuildConfigSnapshot( &com_config.snapshot );
+
+	com_config.writing.store( true, std::memory_order_relaxed );
+	com_config.thread = SDL_CreateThread( Com_ConfigWriterThread, "ConfigWriter", &com_config );
+	if ( !com_config.thread ) {
+		Con_DPrintf( "Com_WriteConfiguration: couldn't create the writer thread, %s\n", SDL_GetError() );
+		Com_ConfigWriterThread( &com_config );
+	}
+
+	Com_WriteCDKeys();
+}
+
+
+/*
+===============
+Com_FlushConfiguration
+
+Waits for the writer and writes out anything still pending,
+called when quitting so nothing that was changed gets lost
+===============
+*/
+void Com_FlushConfiguration( void ) {
+	if ( !com_fullyInitialized ) {
+		return;
+	}
+
+	Com_WaitConfigWriter();
+	Com_UpdateConfigSections();
+	if ( !com_config.pending ) {
+		return;
+	}
+	com_config.pending = qfalse;
+
+	Com_SetConfigPath( LOG_DIR "/" NOMAD_CONFIG );
+	Com_BuildConfigSnapshot( &com_config.snapshot );
+	if ( !Com_WriteConfigText( com_config.ospath, com_config.tmppath, com_config.snapshot.pText, com_config.snapshot.nLength ) ) {
+		Con_Printf( COLOR_YELLOW "WARNING: couldn't write %s\n", com_config.ospath );
+		return;
+	}
 	SteamApp_CloudSave();
-	Com_WriteConfigToFile( LOG_DIR "/" NOMAD_CONFIG );
+	Com_WriteCDKeys();
+}
 
-	gamedir = Cvar_VariableString( "fs_game" );
-	basegame = Cvar_VariableString( "fs_basegame" );
-	if ( gamedir[0] && N_stricmp( basegame, gamedir ) ) {
-		Com_WriteCDKey( gamedir, &cl_cdkey[16] );
-	} else {
-		Com_WriteCDKey( basegame, cl_cdkey );
+static qboolean Com_ConfigFileEquals( const char *ospath, const char *text, uint64_t length )
+{
+	FILE *fp;
+	char *buffer;
+	qboolean equal;
+
+	fp = Sys_FOpen( ospath, "rb" );
+	if ( !fp ) {
+		return qfalse;
 	}
-//	if ( UI_usesUniqueCDKey() && gamedir[0] && Q_stricmp( basegame, gamedir ) ) {
-//		Com_WriteCDKey( gamedir, &cl_cdkey[16] );
-//	} else {
-//		Com_WriteCDKey( basegame, cl_cdkey );
-//	}
+	buffer = (char *)Z_Malloc( length + 1, TAG_STATIC );
+	equal = fread( buffer, 1, length + 1, fp ) == length && !memcmp( buffer, text, length );
+	Z_Free( buffer );
+	fclose( fp );
+
+	return equal;
+}
+
+/*
+===============
+Com_ConfigTest_f
+
+Checks that a write that dies halfway leaves the old config alone and that
+dragging a slider doesn't write more than once every com_configWriteDelay seconds
+===============
+*/
+static void Com_ConfigTest_f( void ) {
+	char ospath[ MAX_OSPATH ];
+	char tmppath[ MAX_OSPATH ];
+	configSection_t snapshot;
+	FILE *fp;
+	uint64_t now, delay, lastWriteTime, busyUntil, duration;
+	uint32_t value, writtenValue, writes, maxWrites;
+	qboolean pending, passed;
+
+	memset( &snapshot, 0, sizeof( snapshot ) );
+	Com_UpdateConfigSections();
+	Com_BuildConfigSnapshot( &snapshot );
+
+	N_strncpyz( ospath, FS_BuildOSPath( FS_GetHomePath(), FS_GetCurrentGameDir(), LOG_DIR "/configtest.cfg" ), sizeof( ospath ) );
+	Com_snprintf( tmppath, sizeof( tmppath ), "%s.tmp", ospath );
+	FS_CreatePath( ospath );
+
+	passed = qtrue;
+
+	// crash safety, the writer dying before the rename mustn't touch what's already there
+	if ( !Com_WriteConfigText( ospath, tmppath, snapshot.pText, snapshot.nLength ) ) {
+		Con_Printf( "com_configtest: couldn't write %s\n", ospath );
+		Z_Free( snapshot.pText );
+		return;
+	}
+	fp = Sys_FOpen( tmppath, "wb" );
+	if ( fp ) {
+		fwrite( "unbindall" GDR_NEWLINE "sets ", 1, strlen( "unbindall" GDR_NEWLINE "sets " ), fp );
+		fclose( fp );
+	}
+	if ( !Com_ConfigFileEquals( ospath, snapshot.pText, snapshot.nLength ) ) {
+		Con_Printf( COLOR_RED "com_configtest: interrupted write truncated the config\n" );
+		passed = qfalse;
+	}
+
+	// a finished write has to replace the leftover temp and the old config
+	if ( !Com_WriteConfigText( ospath, tmppath, snapshot.pText, snapshot.nLength / 2 )
+		|| !Com_ConfigFileEquals( ospath, snapshot.pText, snapshot.nLength / 2 ) )
+	{
+		Con_Printf( COLOR_RED "com_configtest: config doesn't match what was written\n" );
+		passed = qfalse;
+	}
+	remove( ospath );
+	remove( tmppath );
+	Z_Free( snapshot.pText );
+
+	// debounce, the value changes every frame for five seconds at 60 fps with every write
+	// taking 30 msec, then the user lets go of the slider
+	delay = com_configWriteDelay->i * 1000;
+	duration = 5000;
+	value = writtenValue = writes = 0;
+	lastWriteTime = busyUntil = 0;
+	pending = qfalse;
+	for ( now = 1; now < duration + delay * 2 + 100; now += 16 ) {
+		if ( now < duration ) {
+			value++;
+			pending = qtrue;
+		}
+		if ( Com_ConfigWriteDue( now, lastWriteTime, delay, pending, now < busyUntil ) ) {
+			pending = qfalse;
+			lastWriteTime = now;
+			busyUntil = now + 30;
+			writtenValue = value;
+			writes++;
+		}
+	}
+
+	maxWrites = delay ? duration / delay + 1 : duration / 16 + 1;
+	if ( writes > maxWrites ) {
+		Con_Printf( COLOR_RED "com_configtest: %u writes while dragging, expected at most %u\n", writes, maxWrites );
+		passed = qfalse;
+	}
+	if ( writtenValue != value ) {
+		Con_Printf( COLOR_RED "com_configtest: last write had %u, the slider ended at %u\n", writtenValue, value );
+		passed = qfalse;
+	}
+
+	Con_Printf( "com_configtest: %s, %u writes over %lu msec with a %lu msec delay\n",
+		passed ? "passed" : "FAILED", writes, duration, delay );
 }
 
 
@@ -2016,19 +2431,175 @@ static int Com_ModifyMsec( int msec )
 	return msec;
 }
 
-static int Com_TimeVal( int minMsec )
+/*
+===============================================================
+
+FRAME PACING
+
+instead of spinning on the event loop until the frame's time slice is up, the pacer sleeps
+until just before the deadline and only spins for the last com_frameSpin microseconds,
+which is enough to cover the scheduler's wakeup latency without burning a core
+
+===============================================================
+*/
+
+#define FRAME_STATS_SAMPLES 256
+
+typedef struct {
+	uint64_t nextFrame;			// when the next frame is allowed to start, in Sys_Microseconds
+	uint64_t lastFrame;
+	uint32_t targetUsec;
+
+	uint32_t samples[ FRAME_STATS_SAMPLES ];	// time between the starts of the last frames
+	uint32_t numSamples;
+	uint32_t sampleIndex;
+} framePacer_t;
+
+static framePacer_t com_pacer;
+
+/*
+* Com_FrameTargetUsec: how long a frame should take with the current window state, 0 if unlimited
+*/
+static uint32_t Com_FrameTargetUsec( void )
+{
+	int fps;
+
+	if ( gw_minimized && com_maxfpsMinimized->i > 0 ) {
+		fps = com_maxfpsMinimized->i;
+	} else if ( !gw_active && com_maxfpsUnfocused->i > 0 ) {
+		fps = com_maxfpsUnfocused->i;
+	} else {
+		fps = com_maxfps->i;
+	}
+
+	return fps > 0 ? 1000000 / fps : 0;
+}
+
+/*
+* Com_PaceFrame: waits until the next frame is due and returns the time it started at
+*/
+static uint64_t Com_PaceFrame( framePacer_t *pacer, uint32_t targetUsec, uint32_t spinUsec )
 {
-	int timeVal;
+	uint64_t now, deadline;
+
+	now = Sys_Microseconds();
+	pacer->targetUsec = targetUsec;
 
-	timeVal = Com_Milliseconds() - com_frameTime;
+	if ( targetUsec ) {
+		deadline = pacer->nextFrame;
+
+		// don't try to catch up with a burst of frames after a hitch, and don't keep
+		// waiting on a deadline from a lower frame rate limit
+		if ( now > deadline + targetUsec || deadline > now + targetUsec ) {
+			deadline = now;
+		}
+
+		if ( deadline > now + spinUsec ) {
+			Sys_SleepUntil( deadline - spinUsec );
+		}
+		do {
+			now = Sys_Microseconds();
+		} while ( now < deadline );
 
-	if ( timeVal >= minMsec ) {
-		timeVal = 0;
+		pacer->nextFrame = deadline + targetUsec;
 	} else {
-		timeVal = minMsec - timeVal;
+		pacer->nextFrame = now;
 	}
 
-	return timeVal;
+	if ( pacer->lastFrame ) {
+		pacer->samples[ pacer->sampleIndex ] = (uint32_t)MIN( now - pacer->lastFrame, (uint64_t)UINT32_MAX );
+		pacer->sampleIndex = ( pacer->sampleIndex + 1 ) % FRAME_STATS_SAMPLES;
+		if ( pacer->numSamples < FRAME_STATS_SAMPLES ) {
+			pacer->numSamples++;
+		}
+	}
+	pacer->lastFrame = now;
+
+	return now;
+}
+
+static void Com_ComputeFrameStats( const framePacer_t *pacer, frameStats_t *stats )
+{
+	uint32_t i;
+	double sum, deviation, variance;
+
+	memset( stats, 0, sizeof( *stats ) );
+	stats->targetUsec = pacer->targetUsec;
+	stats->numFrames = pacer->numSamples;
+	if ( !pacer->numSamples ) {
+		return;
+	}
+
+	sum = 0.0;
+	stats->minUsec = UINT32_MAX;
+	for ( i = 0; i < pacer->numSamples; i++ ) {
+		sum += pacer->samples[i];
+		stats->minUsec = MIN( stats->minUsec, pacer->samples[i] );
+		stats->maxUsec = MAX( stats->maxUsec, pacer->samples[i] );
+	}
+	stats->meanUsec = sum / pacer->numSamples;
+
+	variance = 0.0;
+	for ( i = 0; i < pacer->numSamples; i++ ) {
+		deviation = pacer->samples[i] - stats->meanUsec;
+		variance += deviation * deviation;
+	}
+	stats->jitterUsec = sqrt( variance / pacer->numSamples );
+}
+
+/*
+* Com_GetFrameStats: frame times over the last FRAME_STATS_SAMPLES frames
+*/
+void Com_GetFrameStats( frameStats_t *stats )
+{
+	Com_ComputeFrameStats( &com_pacer, stats );
+}
+
+static void Com_FrameStats_f( void )
+{
+	frameStats_t stats;
+
+	Com_GetFrameStats( &stats );
+	Con_Printf( "target: %u usec (%s)\n", stats.targetUsec, gw_minimized ? "minimized" : gw_active ? "focused" : "unfocused" );
+	Con_Printf( "frames: %u\n", stats.numFrames );
+	Con_Printf( "mean: %.1f usec\n", stats.meanUsec );
+	Con_Printf( "jitter: %.1f usec\n", stats.jitterUsec );
+	Con_Printf( "min/max: %u/%u usec\n", stats.minUsec, stats.maxUsec );
+}
+
+/*
+* Com_PacerTest_f: runs the pacer without a game attached at 60, 144 and 240 hz and reports how
+* steady the frames were and how much cpu time the waiting cost
+*/
+static void Com_PacerTest_f( void )
+{
+	const uint32_t rates[] = { 60, 144, 240 };
+	framePacer_t pacer;
+	frameStats_t stats;
+	uint64_t start, end, cpuStart, cpuEnd;
+	uint32_t seconds, i;
+
+	seconds = Cmd_Argc() > 1 ? atoi( Cmd_Argv( 1 ) ) : 2;
+	if ( !seconds ) {
+		seconds = 2;
+	}
+
+	Con_Printf( "com_pacertest: %u seconds per rate, %i usec spin\n", seconds, com_frameSpin->i );
+	Con_Printf( "   hz   mean usec  jitter usec  min/max usec     cpu\n" );
+	for ( i = 0; i < arraylen( rates ); i++ ) {
+		memset( &pacer, 0, sizeof( pacer ) );
+
+		start = Sys_Microseconds();
+		cpuStart = Sys_ThreadCPUTime();
+		do {
+			end = Com_PaceFrame( &pacer, 1000000 / rates[i], com_yieldCPU->i ? com_frameSpin->i : UINT32_MAX );
+		} while ( end - start < seconds * 1000000ULL );
+		cpuEnd = Sys_ThreadCPUTime();
+
+		Com_ComputeFrameStats( &pacer, &stats );
+		Con_Printf( "  %3u   %9.1f  %11.1f  %6u/%-6u  %5.1f%%\n", rates[i], stats.meanUsec, stats.jitterUsec,
+			stats.minUsec, stats.maxUsec, 100.0 * ( cpuEnd - cpuStart ) / ( end - start ) );
+	}
 }
 
 /*
@@ -2036,18 +2607,13 @@ static int Com_TimeVal( int minMsec )
 */
 void Com_Frame( qboolean noDelay )
 {
-	static int bias = 0;
-	int msec, realMsec, minMsec;
-	int sleepMsec;
-	int timeVal;
+	int msec;
+	uint32_t targetUsec;
 
 	if ( Q_setjmp( abortframe ) ) {
 		return; // an ERR_DROP was thrown
 	}
 
-	// silence compiler warning
-	minMsec = 0;
-
 	// write config file if anything changed
 #ifndef DELAY_WRITECONFIG
 	Com_WriteConfiguration();
@@ -2065,71 +2631,25 @@ void Com_Frame( qboolean noDelay )
 	// main event loop
 	//
 
-#if 0 // broken
-	if ( noDelay ) {
-		minMsec = 0;
-		bias = 0;
-	} else {
-		if ( !gw_active && com_maxfpsUnfocused->i > 0 ) {
-			minMsec = 1000 / com_maxfpsUnfocused->i;
-		} else if ( com_maxfps->i > 0 ) {
-			minMsec = 1000 / com_maxfps->i;
-		} else {
-			minMsec = 1;
-		}
-
-		timeVal = com_frameTime - lastTime;
-		bias += timeVal - minMsec;
-
-		if ( bias > minMsec ) {
-			bias = minMsec;
-		}
-
-		// Adjust minMsec if previous frame took too long to render so
-		// that framerate is stable at the requested value.
-		minMsec -= bias;
+	// we may want to wait here if things are going too fast
+	targetUsec = noDelay ? 0 : Com_FrameTargetUsec();
+	if ( gi.demoplaying ) {
+		// demo playback is paced by the frames in the demo
+		targetUsec = G_DemoTargetUsec( targetUsec );
 	}
+	Com_PaceFrame( &com_pacer, targetUsec, com_yieldCPU->i ? com_frameSpin->i : UINT32_MAX );
 
-	// we may want to spin here if things are going too fast
-	do {
-		timeVal = Com_TimeVal( minMsec );
-		sleepMsec = timeVal;
-		if ( !gw_minimized && timeVal > com_yieldCPU->i ) {
-			sleepMsec = com_yieldCPU->i;
-		}
-		if ( timeVal > sleepMsec ) {
-			Com_EventLoop();
-		}
-	} while ( Com_TimeVal( minMsec ) );
-
-	lastTime = com_frameTime;
 	com_frameTime = Com_EventLoop();
-	realMsec = com_frameTime - lastTime;
-
-	Cbuf_Execute();
-#else // old fashioned Quake III method but without stabilizing the frames if it gets kinda stuffy
-	// we may want to spin here if things are going too fast
-	if ( !gw_active && com_maxfpsUnfocused->i > 0 ) {
-		minMsec = 1000 / com_maxfpsUnfocused->i;
-	} else if ( com_maxfps->i > 0 ) {
-		minMsec = 1000 / com_maxfps->i;
-	} else {
-		minMsec = 0;
+	if ( lastTime > com_frameTime ) {
+		lastTime = com_frameTime;		// possible on first frame
 	}
-	do {
-		com_frameTime = Com_EventLoop();
-		if ( lastTime > com_frameTime ) {
-			lastTime = com_frameTime;		// possible on first frame
-		}
-		msec = com_frameTime - lastTime;
-	} while ( msec < minMsec );
+	msec = com_frameTime - lastTime;
 	Cbuf_Execute();
 
 	lastTime = com_frameTime;
-#endif
+
 	// mess with msec if needed
 	msec = Com_ModifyMsec( msec );
-	realMsec = Sys_Milliseconds() - lastTime;
 
 	//
 	// run the game loop
@@ -22,9 +22,42 @@ qboolean Com_EarlyParseCmdLine( char *commandLine, char *con_title, int title_si
 void Com_StartupVariable( const char *match );
 void Com_Init(char *commandLine);
 void Com_Shutdown(void);
+
+typedef struct {
+	uint32_t targetUsec;		// 0 when the frame rate isn't limited
+	uint32_t numFrames;
+	uint32_t minUsec;
+	uint32_t maxUsec;
+	float meanUsec;
+	float jitterUsec;			// standard deviation of the time between frames
+} frameStats_t;
+
+void Com_GetFrameStats( frameStats_t *stats );
+
+//
+// n_log.cpp
+//
+typedef enum {
+	LOG_DEVELOPER,
+	LOG_INFO,
+	LOG_WARNING,
+	LOG_ERROR,
+
+	NUM_LOG_LEVELS
+} logLevel_t;
+
+void Com_InitLog( void );
+void Com_ShutdownLog( void );
+void Com_FlushLog( void );
+qboolean Com_LogPrint( logLevel_t level, const char *msg, uint64_t length );
+void Com_LogBench_f( void );
+
 uint64_t Com_GenerateHashValue(const char *fname, const uint64_t size);
 void Con_RenderConsole(void);
 void Com_WriteConfig(void);
+void Com_WriteConfiguration( void );
+void Com_FlushConfiguration( void );
+uint64_t Com_AppendText( char *buffer, uint64_t bufferSize, uint64_t offset, const char *text, uint64_t length );
 void COM_DefaultExtension( char *path, uint64_t maxSize, const char *extension );
 int32_t Com_HexStrToInt(const char *str);
 qboolean Com_FilterExt( const char *filter, const char *name );
@@ -81,9 +114,12 @@ extern	cvar_t	*com_journal;
 #define COMPRESS_BZIP2 2
 #define COMPRESS_7Z 3
 #define COMPRESS_GZIP 4
+#define COMPRESS_ZSTD 5
+#define COMPRESS_LZ4 6
 
 char *Compress( void *buf, uint64_t buflen, uint64_t *outlen, int compression );
 char *Decompress( void *buf, uint64_t buflen, uint64_t *outlen, int compression );
+qboolean DecompressInto( const void *buf, uint64_t buflen, void *out, uint64_t outlen, int compression );
 
 /*
 
@@ -236,6 +272,7 @@ void Com_QueueEvent(uint32_t evTime, sysEventType_t evType, uint32_t evValue, ui
 void Com_SendKeyEvents(void);
 void Com_KeyEvent(uint32_t key, qboolean down, uint32_t time);
 uint64_t Com_EventLoop(void);
+void Com_RunEvent(const sysEvent_t *ev);
 
 #include "keycodes.h"
 
@@ -254,7 +291,8 @@ uint32_t Key_GetCatcher( void );
 int32_t Key_GetKey( const char *binding );
 qboolean Key_GetOverstrikeMode( void );
 void Key_SetOverstrikeMode( qboolean overstrike );
-void Key_WriteBindings( fileHandle_t f );
+uint64_t Key_WriteBindings( char *buffer, uint64_t bufferSize );
+extern qboolean key_bindingsModified;
 void Key_SetBinding( uint32_t keynum, const char *binding );
 
 typedef struct
@@ -383,9 +421,13 @@ typedef enum {
 
 #define MAX_BFF_PATH 256
 #define BFF_VERSION_MAJOR 0
-#define BFF_VERSION_MINOR 1
+#define BFF_VERSION_MINOR 2
 #define BFF_VERSION ((BFF_VERSION_MAJOR<<8)+BFF_VERSION_MINOR)
 
+// from here on every chunk stores its own compression method instead of the header
+// having one for the whole archive, older archives are still readable
+#define BFF_VERSION_CHUNK_COMPRESSION ((0<<8)+2)
+
 extern cvar_t *com_demo;
 extern cvar_t *com_journal;
 extern cvar_t *com_logfile;
@@ -489,10 +531,15 @@ void FS_FilenameCompletion( const char *dir, const char *ext, qboolean stripExt,
 qboolean FS_AllowedExtension(const char *fileName, qboolean allowBFFs, const char **ext);
 qboolean FS_StripExt(char *filename, const char *ext);
 qboolean FS_FileIsInBFF(const char *path);
+qboolean FS_FileInPathExists(const char *npath);
+void FS_FlushMissingFiles(void);
+uint64_t FS_LookupSyscalls(void);
 qboolean FS_Initialized(void);
 char **FS_GetCurrentChunkList(uint64_t *numchunks);
 void FS_SetBFFIndex(uint64_t index);
 void FS_FreeFile(void *buffer);
+uint64_t FS_LoadFileView(const char *npath, const void **buffer);
+void FS_FreeFileView(const void *buffer);
 void FS_FreeFileList(char **list);
 char **FS_ListFiles(const char *path, const char *extension, uint64_t *numfiles);
 char *FS_ReadLine(char *buf, uint64_t size, fileHandle_t f);
@@ -550,6 +597,7 @@ void *S_Malloc(uint64_t size);
 void Z_Free(void *ptr);
 uint64_t Z_FreeTags( memtag_t tag );
 uint64_t Z_AvailableMemory( void );
+void Z_GetAllocCounts( uint64_t *numAllocs, uint64_t *numFrees );
 char *CopyString( const char *str );
 
 void Com_DrawMemoryView_Hunk( void );
@@ -595,7 +643,12 @@ typedef struct {
 #define MUTEX_TYPE_RECURSIVE 2
 
 uint64_t Sys_Milliseconds( void );
+uint64_t Sys_Microseconds( void );
+void Sys_SleepUntil( uint64_t usec );
+uint64_t Sys_ThreadCPUTime( void );
 FILE *Sys_FOpen( const char *filepath, const char *mode );
+qboolean Sys_FSync( FILE *fp );
+qboolean Sys_ReplaceFile( const char *from, const char *to );
 
 int Sys_MessageBox( const char *title, const char *text, bool ShowOkAndCancelButton );
 
@@ -665,6 +718,12 @@ void Sys_DecommitVirtualMemory( void *pMemory, uint64_t nBytes );
 void Sys_LockMemory( void *pAddress, uint64_t nBytes );
 void Sys_UnlockMemory( void *pAddress, uint64_t nBytes );
 
+// read-only file mappings, Sys_MapFile returns NULL if the file can't be mapped
+void *Sys_MapFile( const char *path, qboolean temp );
+void *Sys_GetMappedFileBuffer( void *file );
+uint64_t Sys_GetMappedFileSize( void *file );
+void Sys_UnmapFile( void *file );
+
 qboolean Sys_SetAffinityMask( const uint64_t mask );
 uint64_t Sys_GetAffinityMask( void );
 
@@ -39,6 +39,17 @@ static uint64_t cvar_numIndexes;
 
 static int32_t cvar_group[CVG_MAX];
 
+uint32_t cvar_generation = 1;
+
+// cvars the modules want to hear about, the handle of a watched cvar gets queued once when it
+// changes and the module drains the queue with Cvar_NextChanged instead of checking every cvar
+#define CVAR_WATCHED 0x01
+#define CVAR_QUEUED 0x02
+static byte cvar_watchState[MAX_CVARS];
+static cvarHandle_t cvar_changed[MAX_CVARS];
+static uint64_t cvar_changedHead;
+static uint64_t cvar_changedTail;
+
 #define FILE_HASH_SIZE 256
 static cvar_t *hashTable[FILE_HASH_SIZE];
 static qboolean cvar_sort = qfalse;
@@ -116,6 +127,41 @@ static cvar_t *Cvar_FindVar(const char *var_name)
 	return NULL;
 }
 
+/*
+============
+Cvar_Find
+
+for CvarHandle, everything else should go through Cvar_Get or the Cvar_Variable* functions
+============
+*/
+cvar_t *Cvar_Find(const char *var_name)
+{
+	return Cvar_FindVar(var_name);
+}
+
+/*
+============
+Cvar_Changed
+
+queues the cvar for the modules if they're watching it
+============
+*/
+static void Cvar_Changed(cvar_t *var)
+{
+	const cvarHandle_t handle = var - cvar_indexes;
+
+	if ((cvar_watchState[handle] & (CVAR_WATCHED | CVAR_QUEUED)) != CVAR_WATCHED) {
+		return;
+	}
+
+	// every cvar is queued at most once, only handles left behind by unset cvars can fill it up
+	if (cvar_changedTail - cvar_changedHead >= MAX_CVARS) {
+		return;
+	}
+	cvar_watchState[handle] |= CVAR_QUEUED;
+	cvar_changed[cvar_changedTail++ % MAX_CVARS] = handle;
+}
+
 /*
 ============
 Cvar_VariableFloat
@@ -472,6 +518,7 @@ cvar_t *Cvar_Get(const char *var_name, const char *var_value, uint32_t flags)
 	}
 
 	var = &cvar_indexes[index];
+	cvar_generation++;
 
 	if ( index >= cvar_numIndexes ) {
 		cvar_numIndexes = index + 1;
@@ -719,6 +766,7 @@ cvar_t *Cvar_Set2(const char *var_name, const char *value, qboolean force)
 			var->modified = qtrue;
 			var->modificationCount++;
 			cvar_group[var->group] = 1;
+			Cvar_Changed(var);
 			return var;
 		}
 	}
@@ -738,6 +786,7 @@ cvar_t *Cvar_Set2(const char *var_name, const char *value, qboolean force)
 	var->s = CopyString(value);
 	var->f = N_atof(var->s);
 	var->i = atol(var->s);
+	Cvar_Changed(var);
 
 	return var;
 }
@@ -1324,20 +1373,23 @@ static void Cvar_Func_f(void)
 Cvar_WriteVariables
 
 Appends lines containing "set variable value" for all variables
-with the archive flag set to qtrue.
+with the archive flag set to qtrue to the text buffer, returns the
+length of all of them like Key_WriteBindings
 ============
 */
-void Cvar_WriteVariables(fileHandle_t f)
+uint64_t Cvar_WriteVariables(char *text, uint64_t textSize)
 {
 	cvar_t *var;
 	char buffer[MAX_CMD_LINE];
 	const char *value;
+	uint64_t length;
 
 	if (cvar_sort) {
 		cvar_sort = qfalse;
 		Cvar_Sort();
 	}
 
+	length = 0;
 	for (var = cvar_vars; var; var = var->next) {
 		if (!var->name || N_stricmp(var->name, "cl_cdkey") == 0)
 			continue;
@@ -1356,9 +1408,11 @@ void Cvar_WriteVariables(fileHandle_t f)
 			}
 			len = Com_snprintf(buffer, sizeof(buffer), "sets %s \"%s\"" GDR_NEWLINE, var->name, value);
 
-			FS_Write(buffer, len, f);
+			length += Com_AppendText(text, textSize, length, buffer, len);
 		}
 	}
+
+	return length;
 }
 
 /*
@@ -1563,7 +1617,10 @@ static cvar_t *Cvar_Unset(cvar_t *cv)
 	if (cv->hashNext)
 		cv->hashNext->hashPrev = cv->hashPrev;
 
+	// a queued handle is skipped by Cvar_NextChanged once the watch is gone
+	cvar_watchState[cv - cvar_indexes] = 0;
 	memset(cv, 0, sizeof(*cv));
+	cvar_generation++;
 
 	return next;
 }
@@ -1987,6 +2044,97 @@ void Cvar_Update(vmCvar_t *vmCvar, uint32_t privateFlag)
 	vmCvar->i = cv->i;
 }
 
+/*
+=====================
+Cvar_Watch
+
+queue the cvar for Cvar_NextChanged whenever it's changed from now on
+=====================
+*/
+void Cvar_Watch(cvarHandle_t handle)
+{
+	if ((unsigned)handle >= cvar_numIndexes || !cvar_indexes[handle].name) {
+		N_Error(ERR_DROP, "Cvar_Watch: handle out of range");
+	}
+	cvar_watchState[handle] |= CVAR_WATCHED;
+}
+
+/*
+=====================
+Cvar_NextChanged
+
+returns the handle of a watched cvar that's changed since it was last returned,
+or FS_INVALID_HANDLE when there aren't any left
+=====================
+*/
+cvarHandle_t Cvar_NextChanged(void)
+{
+	cvarHandle_t handle;
+
+	while (cvar_changedHead != cvar_changedTail) {
+		handle = cvar_changed[cvar_changedHead++ % MAX_CVARS];
+		if (!(cvar_watchState[handle] & CVAR_QUEUED)) {
+			continue; // unset while it was queued
+		}
+		cvar_watchState[handle] &= ~CVAR_QUEUED;
+		return handle;
+	}
+	return FS_INVALID_HANDLE;
+}
+
+/*
+=====================
+Cvar_ClearWatches
+
+called when the modules are shut down
+=====================
+*/
+void Cvar_ClearWatches(void)
+{
+	memset(cvar_watchState, 0, sizeof(cvar_watchState));
+	cvar_changedHead = cvar_changedTail = 0;
+}
+
+/*
+=====================
+Cvar_Bench_f
+
+cvar_bench [reads], times looking cvars up by name against reading them through a CvarHandle
+=====================
+*/
+static void Cvar_Bench_f(void)
+{
+	static const char *names[] = { "com_maxfps", "g_paused", "r_mode", "sgame_NoClip", "snd_muteUnfocused", "nonexistent_cvar" };
+	CvarHandle<int64_t> handles[] = {
+		CvarHandle<int64_t>( names[0] ), CvarHandle<int64_t>( names[1] ), CvarHandle<int64_t>( names[2] ),
+		CvarHandle<int64_t>( names[3] ), CvarHandle<int64_t>( names[4] ), CvarHandle<int64_t>( names[5] )
+	};
+	uint64_t reads, i, start, lookupMsec, handleMsec;
+	volatile int64_t sum;
+
+	reads = 10000000;
+	if (Cmd_Argc() > 1) {
+		reads = MAX(1, atoll(Cmd_Argv(1)));
+	}
+
+	sum = 0;
+	start = Sys_Milliseconds();
+	for (i = 0; i < reads; i++) {
+		sum += Cvar_VariableInteger(names[i % arraylen(names)]);
+	}
+	lookupMsec = Sys_Milliseconds() - start;
+
+	start = Sys_Milliseconds();
+	for (i = 0; i < reads; i++) {
+		sum += handles[i % arraylen(handles)].Get();
+	}
+	handleMsec = Sys_Milliseconds() - start;
+
+	Con_Printf("%lu reads over %lu cvars (one of them doesn't exist)\n", reads, arraylen(names));
+	Con_Printf("Cvar_VariableInteger: %lums, %.2fns per read\n", lookupMsec, (double)lookupMsec * 1e6 / reads);
+	Con_Printf("CvarHandle: %lums, %.2fns per read\n", handleMsec, (double)handleMsec * 1e6 / reads);
+}
+
 /*
 ==================
 Cvar_CompleteCvarName
@@ -2057,4 +2205,5 @@ void Cvar_Init( void )
 	Cmd_AddCommand( "cvar_modified", Cvar_ListModified_f );
 	Cmd_AddCommand( "cvar_restart", Cvar_Restart_f );
 	Cmd_AddCommand( "cvar_trim", Cvar_Trim_f );
+	Cmd_AddCommand( "cvar_bench", Cvar_Bench_f );
 }
\ No newline at end of file
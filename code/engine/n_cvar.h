@@ -60,6 +60,95 @@ qboolean Cvar_SetModified(const char *name, qboolean modified);
 void Cvar_SetIntegerValue(const char *name, int64_t value);
 void Cvar_SetFloatValue(const char *name, float value);
 void Cvar_SetStringValue(const char *name, const char *value);
-void Cvar_WriteVariables(fileHandle_t f);
+uint64_t Cvar_WriteVariables(char *text, uint64_t textSize);
+cvar_t *Cvar_Find(const char *name);
+void Cvar_Watch(cvarHandle_t handle);
+cvarHandle_t Cvar_NextChanged(void);
+void Cvar_ClearWatches(void);
+
+// bumped whenever a cvar is created or unset, see CvarHandle
+extern uint32_t cvar_generation;
+
+#ifdef __cplusplus
+//
+// CvarHandle: looks the cvar up by name once and reads it through the cached pointer after that,
+// use it instead of Cvar_VariableInteger & co. anywhere that runs more than once a frame. The pointer
+// is looked up again if any cvar has been created or unset since, a cvar that doesn't exist yet reads
+// as zero or an empty string
+//
+template<typename T>
+class CvarHandle
+{
+public:
+	CvarHandle( const char *pName )
+		: m_pName( pName ), m_pVar( NULL ), m_nGeneration( 0 ), m_nModificationCount( 0 )
+	{ }
+
+	GDR_INLINE T Get( void ) {
+		return Value( Resolve() );
+	}
+	GDR_INLINE operator T( void ) {
+		return Get();
+	}
+
+	// returns qtrue once for every time the cvar's been changed since the last call
+	GDR_INLINE qboolean Modified( void ) {
+		const cvar_t *pVar = Resolve();
+
+		if ( !pVar || pVar->modificationCount == m_nModificationCount ) {
+			return qfalse;
+		}
+		m_nModificationCount = pVar->modificationCount;
+		return qtrue;
+	}
+
+	GDR_INLINE cvar_t *GetVar( void ) {
+		return Resolve();
+	}
+	GDR_INLINE const char *GetName( void ) const {
+		return m_pName;
+	}
+private:
+	GDR_INLINE cvar_t *Resolve( void ) {
+		if ( m_nGeneration != cvar_generation ) {
+			m_pVar = Cvar_Find( m_pName );
+			m_nGeneration = cvar_generation;
+		}
+		return m_pVar;
+	}
+
+	static T Value( const cvar_t *pVar );
+
+	const char *m_pName;
+	cvar_t *m_pVar;
+	uint32_t m_nGeneration;
+	uint32_t m_nModificationCount;
+};
+
+template<>
+GDR_INLINE int32_t CvarHandle<int32_t>::Value( const cvar_t *pVar ) {
+	return pVar ? pVar->i : 0;
+}
+
+template<>
+GDR_INLINE int64_t CvarHandle<int64_t>::Value( const cvar_t *pVar ) {
+	return pVar ? pVar->i : 0;
+}
+
+template<>
+GDR_INLINE bool CvarHandle<bool>::Value( const cvar_t *pVar ) {
+	return pVar ? pVar->i != 0 : false;
+}
+
+template<>
+GDR_INLINE float CvarHandle<float>::Value( const cvar_t *pVar ) {
+	return pVar ? pVar->f : 0.0f;
+}
+
+template<>
+GDR_INLINE const char *CvarHandle<const char *>::Value( const cvar_t *pVar ) {
+	return pVar && pVar->s ? pVar->s : "";
+}
+#endif
 
 #endif
\ No newline at end of file
@@ -14,8 +14,15 @@ static const uint32_t bff_checksums[] = {
 
 #ifdef _WIN32
 	#define WIN32_LEAN_AND_MEAN
+	#include <windows.h>
 	#include <io.h>
+#else
+	#include <unistd.h>
+	#include <errno.h>
 #endif
+#include <atomic>
+#include <SDL2/SDL_thread.h>
+#include <SDL2/SDL_cpuinfo.h>
 
 //#define USE_ZIP
 
@@ -56,11 +63,9 @@ typedef struct fileInBFF_s {
 	struct	fileInBFF_s*	next;		// next file in the hash
 #else
 	char *name;
-	char *buf;
 	int64_t nameLen;
 	int64_t size;
 	int64_t compressedSize;
-    int64_t bytesRead;
 	int64_t pos;
 	int64_t compression;
 	struct fileInBFF_s *next;
@@ -87,7 +92,12 @@ typedef struct bffFile_s
 	fileInBFF_t **hashTable;			// hash table
 	fileInBFF_t *buildBuffer;			// buffer with the filenames etc.
 	int64_t index;
-	uint32_t handlesUsed;
+	std::atomic<uint32_t> handlesUsed;
+	std::atomic<qboolean> opened;		// handle (and mapping) are ready for reads
+
+	void *mapping;						// Sys_MapFile handle, NULL if fs_mapBFFs is off or mapping failed
+	const byte *mappedData;
+	uint64_t mappedSize;
 
 #ifdef USE_HANDLE_CACHE
 	struct bffFile_s	*next_h;		// double-linked list of unreferenced bffs with open file handles
@@ -122,6 +132,8 @@ typedef struct {
 
 	int64_t bffIndex;
 	bffFile_t *bff;
+	int64_t bffPos;						// read position inside the chunk, each handle has its own
+	char *bffBuf;						// decompressed chunk data, only used for compressed archives
 	qboolean bffFile;
 	qboolean handleSync;
 #ifdef USE_ZIP
@@ -154,7 +166,20 @@ typedef struct searchpath_s {
 
 #define FS_HashFileName(name,len) Com_GenerateHashValue((name),(len))
 
+// fs_mutex guards mounting and the search paths, reads never take it: a bff's hash table doesn't change
+// after it's mounted and chunks are read with positional reads on the archive's descriptor. It does nothing
+// for the zone or the temp hunk, nothing else that allocates from them takes it, so anything that allocates
+// from either is main thread only
 static CThreadMutex	fs_mutex;
+
+// the handle table is split into shards with their own lock, every thread allocates from its own
+// shard first so opening files on different threads doesn't contend
+#define FS_HANDLE_SHARDS 8
+#define FS_HANDLES_PER_SHARD ( MAX_FILE_HANDLES / FS_HANDLE_SHARDS )
+static CThreadMutex fs_handleLocks[ FS_HANDLE_SHARDS ];
+static std::atomic<uint32_t> fs_nextHandleShard;
+static thread_local int32_t fs_handleShard = -1;
+
 static bffFile_t	**fs_archives;
 #define MAX_BASEGAMES 4
 static  char		basegame_str[MAX_OSPATH], *basegames[MAX_BASEGAMES];
@@ -166,6 +191,7 @@ static searchpath_t *fs_searchpaths;
 static cvar_t		*fs_excludeReference;
 static cvar_t		*fs_homepath;
 static cvar_t		*fs_locked;
+static cvar_t		*fs_mapBFFs;
 #ifdef __APPLE__
 // Also search the .app bundle for .bff files
 static cvar_t		*fs_apppath;
@@ -246,18 +272,38 @@ static uint64_t FS_FileLength( FILE *fp )
 
 static void FS_InitHandle( fileHandleData_t *f )
 {
-	f->used = qfalse;
 	f->bffFile = qfalse;
 	f->bff = NULL;
 	f->bffIndex = -1;
+	f->bffPos = 0;
+	f->bffBuf = NULL;
 	f->mapped = qfalse;
 	f->tmp = qfalse;
 }
 
+/*
+* FS_HandleForFile: claims a free handle, it stays marked as used until FS_ReleaseHandle
+*/
 static fileHandle_t FS_HandleForFile( void )
 {
-	for ( fileHandle_t i = 1; i < MAX_FILE_HANDLES; i++ ) {
-		if ( !handles[i].used || !handles[i].data.stream ) {
+	fileHandle_t i, first;
+	int32_t s, shard;
+
+	if ( fs_handleShard == -1 ) {
+		fs_handleShard = fs_nextHandleShard++ % FS_HANDLE_SHARDS;
+	}
+
+	for ( s = 0; s < FS_HANDLE_SHARDS; s++ ) {
+		shard = ( fs_handleShard + s ) % FS_HANDLE_SHARDS;
+		first = shard * FS_HANDLES_PER_SHARD;
+
+		CThreadAutoLock<CThreadMutex> lock( fs_handleLocks[ shard ] );
+		for ( i = first; i < first + FS_HANDLES_PER_SHARD; i++ ) {
+			if ( i == FS_INVALID_HANDLE || handles[i].used ) {
+				continue;
+			}
+			memset( &handles[i], 0, sizeof( handles[i] ) );
+			handles[i].used = qtrue;
 			return i;
 		}
 	}
@@ -265,14 +311,68 @@ static fileHandle_t FS_HandleForFile( void )
 	return FS_INVALID_HANDLE;
 }
 
+static void FS_ReleaseHandle( fileHandle_t f )
+{
+	CThreadAutoLock<CThreadMutex> lock( fs_handleLocks[ f / FS_HANDLES_PER_SHARD ] );
+	memset( &handles[f], 0, sizeof( handles[f] ) );
+}
+
+/*
+* FS_ReadAt: reads from an absolute offset in the archive without touching the descriptor's
+* file position, so any number of threads can read from the same bff at once
+*/
+static qboolean FS_ReadAt( const bffFile_t *bff, void *buffer, uint64_t size, int64_t offset )
+{
+	byte *buf;
+#ifdef _WIN32
+	OVERLAPPED overlapped;
+	HANDLE hFile;
+	DWORD nBlock, nRead;
+
+	hFile = (HANDLE)_get_osfhandle( _fileno( bff->handle ) );
+	buf = (byte *)buffer;
+	while ( size ) {
+		nBlock = size > 0x40000000 ? 0x40000000 : (DWORD)size;
+		memset( &overlapped, 0, sizeof( overlapped ) );
+		overlapped.Offset = (DWORD)( offset & 0xffffffff );
+		overlapped.OffsetHigh = (DWORD)( offset >> 32 );
+		if ( !ReadFile( hFile, buf, nBlock, &nRead, &overlapped ) || nRead == 0 ) {
+			return qfalse;
+		}
+		buf += nRead;
+		size -= nRead;
+		offset += nRead;
+	}
+#else
+	ssize_t nRead;
+	int fd;
+
+	fd = fileno( bff->handle );
+	buf = (byte *)buffer;
+	while ( size ) {
+		nRead = pread( fd, buf, size, (off_t)offset );
+		if ( nRead < 0 && errno == EINTR ) {
+			continue;
+		}
+		if ( nRead <= 0 ) {
+			return qfalse;
+		}
+		buf += nRead;
+		size -= nRead;
+		offset += nRead;
+	}
+#endif
+	return qtrue;
+}
+
 /*
 * FS_BuildOSPath: npath may have either forward or backwards slashes
 */
 char *FS_BuildOSPath( const char *base, const char *game, const char *npath )
 {
 	char temp[MAX_OSPATH*2+1];
-	static char ospath[2][sizeof(temp)+MAX_OSPATH];
-	static int toggle;
+	static thread_local char ospath[2][sizeof(temp)+MAX_OSPATH];
+	static thread_local int toggle;
 
 	toggle ^= 1; // flip-flop to allow two returns without clash
 	
@@ -850,7 +950,6 @@ static void FS_CopyFile( const char *fromOSPath, const char *toOSPath )
 
 qboolean FS_FileIsInBFF( const char *filename )
 {
-	CThreadAutoLock<CThreadMutex> lock( fs_mutex );
 	const fileInBFF_t *file;
 	const searchpath_t *sp;
 	const bffFile_t *bff;
@@ -880,7 +979,7 @@ qboolean FS_FileIsInBFF( const char *filename )
 			bff = sp->bff;
 			file = sp->bff->hashTable[hash];
 			do {
-				if ( !FS_FilenameCompare( file->name, filename ) ) {
+				if ( FS_FilenameCompare( file->name, filename ) ) {
 					return qtrue;
 				}
 				file = file->next;
@@ -891,6 +990,324 @@ qboolean FS_FileIsInBFF( const char *filename )
 }
 
 
+//
+// asset index: every file the search paths can see, hashed when they're mounted so FS_FOpenFileRead goes
+// straight to the bff or directory that has a file instead of trying to open it in every directory on the way.
+// Names that aren't anywhere are remembered in the missing set, so asking for the same missing file again
+// (the renderer probing every image extension) doesn't touch the disk. fs_restart rebuilds both, and
+// writing a file through the file system empties the missing set
+//
+
+typedef struct fileIndex_s {
+	const char *name;
+	const searchpath_t *sp;
+	fileInBFF_t *chunk;			// NULL for a loose file
+	struct fileIndex_s *next;
+} fileIndex_t;
+
+typedef struct {
+	uint32_t generation;		// the slot's empty unless this matches fs_missingGeneration
+	uint64_t hash;
+	char name[MAX_NPATH];
+} missingFile_t;
+
+#define FS_MISSING_FILES 2048
+
+static cvar_t		*fs_assetIndex;
+
+static fileIndex_t	**fs_indexTable;
+static fileIndex_t	*fs_indexEntries;
+static uint64_t		fs_indexSize;
+static uint64_t		fs_indexCount;
+static char			***fs_indexLists; // the directory listings loose file names point into
+static uint64_t		fs_numIndexLists;
+
+static CThreadMutex	fs_missingLock;
+static missingFile_t fs_missingFiles[ FS_MISSING_FILES ];
+static uint32_t		fs_missingGeneration = 1;
+static uint32_t		fs_numMissingFiles;
+
+// every time a lookup had to ask the os whether a file is there
+static std::atomic<uint64_t> fs_lookupSyscalls;
+
+static void FS_FreeIndex( void )
+{
+	uint64_t i;
+
+	for ( i = 0; i < fs_numIndexLists; i++ ) {
+		if ( fs_indexLists[i] ) {
+			Sys_FreeFileList( fs_indexLists[i] );
+		}
+	}
+	if ( fs_indexLists ) {
+		Z_Free( fs_indexLists );
+	}
+	if ( fs_indexEntries ) {
+		Z_Free( fs_indexEntries );
+	}
+	if ( fs_indexTable ) {
+		Z_Free( fs_indexTable );
+	}
+
+	fs_indexLists = NULL;
+	fs_numIndexLists = 0;
+	fs_indexEntries = NULL;
+	fs_indexTable = NULL;
+	fs_indexSize = 0;
+	fs_indexCount = 0;
+}
+
+static void FS_AddToIndex( const char *name, const searchpath_t *sp, fileInBFF_t *chunk )
+{
+	fileIndex_t *entry;
+	uint64_t hash;
+
+	hash = FS_HashFileName( name, fs_indexSize );
+
+	// the search paths are walked in priority order, so whatever's already there wins
+	for ( entry = fs_indexTable[ hash ]; entry; entry = entry->next ) {
+		if ( FS_FilenameCompare( entry->name, name ) ) {
+			return;
+		}
+	}
+
+	entry = &fs_indexEntries[ fs_indexCount++ ];
+	entry->name = name;
+	entry->sp = sp;
+	entry->chunk = chunk;
+	entry->next = fs_indexTable[ hash ];
+	fs_indexTable[ hash ] = entry;
+}
+
+void FS_FlushMissingFiles( void )
+{
+	CThreadAutoLock<CThreadMutex> lock( fs_missingLock );
+
+	fs_missingGeneration++;
+	fs_numMissingFiles = 0;
+}
+
+/*
+* FS_BuildIndex: lists every directory on the search path and merges them with the bff hash tables,
+* called whenever the search paths change
+*/
+static void FS_BuildIndex( void )
+{
+	const searchpath_t *sp;
+	const char *name;
+	uint64_t numFiles, numListed, total, i, j;
+	uint64_t start;
+
+	FS_FreeIndex();
+	FS_FlushMissingFiles();
+
+	if ( !fs_assetIndex->i ) {
+		return;
+	}
+
+	start = Sys_Milliseconds();
+
+	total = 0;
+	fs_numIndexLists = 0;
+	for ( sp = fs_searchpaths; sp; sp = sp->next ) {
+		if ( sp->bff ) {
+			total += sp->bff->numfiles;
+		} else if ( sp->dir ) {
+			fs_numIndexLists++;
+		}
+	}
+
+	fs_indexLists = (char ***)Z_Malloc( sizeof( *fs_indexLists ) * MAX( fs_numIndexLists, 1 ), TAG_SEARCH_PATH );
+	for ( sp = fs_searchpaths, i = 0; sp; sp = sp->next ) {
+		if ( !sp->dir ) {
+			continue;
+		}
+		fs_indexLists[i] = Sys_ListFiles( FS_BuildOSPath( sp->dir->path, sp->dir->gamedir, NULL ), NULL, "*", &numListed,
+			qfalse );
+		total += numListed;
+		i++;
+
+		// a truncated listing would let a lower priority bff shadow the files that didn't make it in
+		if ( numListed >= MAX_FOUND_FILES - 1 ) {
+			Con_Printf( COLOR_YELLOW "WARNING: more than %i files in \"%s/%s\", asset index disabled\n", MAX_FOUND_FILES - 1,
+				sp->dir->path, sp->dir->gamedir );
+			fs_numIndexLists = i;
+			FS_FreeIndex();
+			return;
+		}
+	}
+
+	for ( fs_indexSize = 256; fs_indexSize < total && fs_indexSize < ( 1 << 20 ); fs_indexSize <<= 1 )
+		;
+
+	fs_indexTable = (fileIndex_t **)Z_Malloc( sizeof( *fs_indexTable ) * fs_indexSize, TAG_SEARCH_PATH );
+	memset( fs_indexTable, 0, sizeof( *fs_indexTable ) * fs_indexSize );
+	fs_indexEntries = (fileIndex_t *)Z_Malloc( sizeof( *fs_indexEntries ) * MAX( total, 1 ), TAG_SEARCH_PATH );
+
+	for ( sp = fs_searchpaths, i = 0; sp; sp = sp->next ) {
+		if ( sp->bff ) {
+			for ( j = 0; j < sp->bff->numfiles; j++ ) {
+				FS_AddToIndex( sp->bff->buildBuffer[j].name, sp, &sp->bff->buildBuffer[j] );
+			}
+		} else if ( sp->dir ) {
+			if ( fs_indexLists[i] ) {
+				for ( numFiles = 0; fs_indexLists[i][ numFiles ]; numFiles++ ) {
+					// the listing puts a separator in front of top level files, npaths don't have one
+					name = fs_indexLists[i][ numFiles ];
+					while ( *name == '/' || *name == '\\' ) {
+						name++;
+					}
+					FS_AddToIndex( name, sp, NULL );
+				}
+			}
+			i++;
+		}
+	}
+
+	Con_Printf( "%lu files in the asset index, built in %lu msec\n", fs_indexCount, Sys_Milliseconds() - start );
+}
+
+static const fileIndex_t *FS_FindInIndex( const char *path, uint64_t fullHash )
+{
+	const fileIndex_t *entry;
+
+	if ( !fs_indexTable || !fs_assetIndex->i ) {
+		return NULL;
+	}
+
+	for ( entry = fs_indexTable[ fullHash & ( fs_indexSize - 1 ) ]; entry; entry = entry->next ) {
+		if ( FS_FilenameCompare( entry->name, path ) ) {
+			return entry;
+		}
+	}
+	return NULL;
+}
+
+static qboolean FS_IsMissingFile( const char *path, uint64_t fullHash )
+{
+	const missingFile_t *file;
+	uint64_t i, slot;
+
+	if ( !fs_assetIndex->i ) {
+		return qfalse;
+	}
+
+	CThreadAutoLock<CThreadMutex> lock( fs_missingLock );
+
+	for ( i = 0; i < FS_MISSING_FILES; i++ ) {
+		slot = ( fullHash + i ) & ( FS_MISSING_FILES - 1 );
+		file = &fs_missingFiles[ slot ];
+		if ( file->generation != fs_missingGeneration ) {
+			break;
+		}
+		if ( file->hash == fullHash && FS_FilenameCompare( file->name, path ) ) {
+			return qtrue;
+		}
+	}
+	return qfalse;
+}
+
+static void FS_AddMissingFile( const char *path, uint64_t fullHash )
+{
+	missingFile_t *file;
+	uint64_t i;
+
+	if ( !fs_assetIndex->i || strlen( path ) >= MAX_NPATH ) {
+		return;
+	}
+
+	CThreadAutoLock<CThreadMutex> lock( fs_missingLock );
+
+	// start over rather than let the probes get long
+	if ( fs_numMissingFiles >= FS_MISSING_FILES * 3 / 4 ) {
+		fs_missingGeneration++;
+		fs_numMissingFiles = 0;
+	}
+
+	for ( i = 0; i < FS_MISSING_FILES; i++ ) {
+		file = &fs_missingFiles[ ( fullHash + i ) & ( FS_MISSING_FILES - 1 ) ];
+		if ( file->generation != fs_missingGeneration ) {
+			break;
+		}
+		if ( file->hash == fullHash && FS_FilenameCompare( file->name, path ) ) {
+			return; // another thread got here first
+		}
+	}
+
+	file->generation = fs_missingGeneration;
+	file->hash = fullHash;
+	N_strncpyz( file->name, path, sizeof( file->name ) );
+	fs_numMissingFiles++;
+}
+
+uint64_t FS_LookupSyscalls( void )
+{
+	return fs_lookupSyscalls;
+}
+
+/*
+* FS_FileInPathExists: unlike FS_FileExists, checks every search path and bff
+*/
+qboolean FS_FileInPathExists( const char *npath )
+{
+	const fileIndex_t *entry;
+	const searchpath_t *sp;
+	const fileInBFF_t *chunk;
+	fileStats_t stats;
+	uint64_t fullHash;
+
+	if ( !fs_searchpaths ) {
+		N_Error( ERR_FATAL, "Filesystem call made without initialization" );
+	}
+	if ( !npath || !*npath ) {
+		return qfalse;
+	}
+
+	// npaths are not supposed to have a leading slash
+	while ( npath[0] == '/' || npath[0] == '\\' ) {
+		npath++;
+	}
+
+	if ( FS_CheckDirTraversal( npath ) ) {
+		return qfalse;
+	}
+
+	fullHash = FS_HashFileName( npath, 0U );
+
+	entry = FS_FindInIndex( npath, fullHash );
+	if ( entry ) {
+		if ( entry->chunk ) {
+			return qtrue;
+		}
+		fs_lookupSyscalls++;
+		if ( Sys_GetFileStats( &stats, FS_BuildOSPath( entry->sp->dir->path, entry->sp->dir->gamedir, npath ) ) ) {
+			return qtrue;
+		}
+	}
+	if ( FS_IsMissingFile( npath, fullHash ) ) {
+		return qfalse;
+	}
+
+	for ( sp = fs_searchpaths; sp; sp = sp->next ) {
+		if ( sp->bff ) {
+			for ( chunk = sp->bff->hashTable[ fullHash & ( sp->bff->hashSize - 1 ) ]; chunk; chunk = chunk->next ) {
+				if ( FS_FilenameCompare( chunk->name, npath ) ) {
+					return qtrue;
+				}
+			}
+		} else if ( sp->dir ) {
+			fs_lookupSyscalls++;
+			if ( Sys_GetFileStats( &stats, FS_BuildOSPath( sp->dir->path, sp->dir->gamedir, npath ) ) ) {
+				return qtrue;
+			}
+		}
+	}
+
+	FS_AddMissingFile( npath, fullHash );
+	return qfalse;
+}
+
+
 static uint64_t FS_AddFileToList( const char *name, char **list, uint64_t nfiles )
 {
 	uint64_t i;
@@ -932,13 +1349,11 @@ static void FS_SortFileList( char **list, uint64_t n )
 	if ( n > i ) FS_SortFileList( list+i, n-i );
 }
 
-static fileInBFF_t *FS_GetChunkHandle( const char *path, int64_t *bffIndex )
+static fileInBFF_t *FS_GetChunkHandle( const char *path, bffFile_t **bff )
 {
-	CThreadAutoLock<CThreadMutex> lock( fs_mutex );
 	fileInBFF_t *file;
 	searchpath_t *sp;
-	bffFile_t *bff;
-	uint64_t i;
+	uint64_t fullHash;
 
 	if ( !fs_searchpaths ) {
 		N_Error( ERR_FATAL, "Filesystem call made without initialization" );
@@ -947,16 +1362,17 @@ static fileInBFF_t *FS_GetChunkHandle( const char *path, int64_t *bffIndex )
 		N_Error( ERR_FATAL, "FS_GetChunkHandle: NULL filename" );
 	}
 
+	fullHash = FS_HashFileName( path, 0U );
+
 	for ( sp = fs_searchpaths; sp; sp = sp->next ) {
-		if ( sp->bff ) {
-			bff = sp->bff;
-			
-			for ( i = 0; i < bff->numfiles; i++ ) {
-				file = &bff->buildBuffer[i];
-				if ( !FS_FilenameCompare( file->name, path ) ) {
-					// found it!
-					return file;
-				}
+		if ( !sp->bff ) {
+			continue;
+		}
+		for ( file = sp->bff->hashTable[ fullHash & ( sp->bff->hashSize - 1 ) ]; file; file = file->next ) {
+			if ( FS_FilenameCompare( file->name, path ) ) {
+				// found it!
+				*bff = sp->bff;
+				return file;
 			}
 		}
 	}
@@ -1017,7 +1433,6 @@ uint64_t FS_FOpenFileWithMode( const char *npath, fileHandle_t *f, fileMode_t mo
 
 fileHandle_t FS_FOpenAppend( const char *path )
 {
-	CThreadAutoLock<CThreadMutex> lock( fs_mutex );
 	fileHandle_t fd;
 	fileHandleData_t *f;
 	FILE *fp;
@@ -1055,26 +1470,32 @@ fileHandle_t FS_FOpenAppend( const char *path )
 	fp = Sys_FOpen( ospath, "a" );
 	if ( !fp ) {
 		if ( FS_CreatePath( ospath ) ) {
+			FS_ReleaseHandle( fd );
 			return FS_INVALID_HANDLE;
 		}
 		fp = Sys_FOpen( ospath, "a" );
 		if ( !fp ) {
+			FS_ReleaseHandle( fd );
 			return FS_INVALID_HANDLE;
 		}
 	}
 
 	N_strncpyz( f->name, path, sizeof(f->name) );
-	f->used = qtrue;
 	f->data.fp = fp;
 
+	FS_FlushMissingFiles();
+
 	return fd;
 }
 
+static qboolean FS_OpenChunk( const char *name, fileInBFF_t *chunk, fileHandleData_t *f, bffFile_t *bff );
+
 fileHandle_t FS_OpenFileMapping( const char *path, qboolean temp )
 {
-	CThreadAutoLock<CThreadMutex> lock( fs_mutex );
 	fileHandle_t fd;
 	fileHandleData_t *f;
+	fileInBFF_t *chunk;
+	bffFile_t *bff;
 	const char *ospath;
 	searchpath_t *sp;
 	FILE *fp;
@@ -1096,15 +1517,15 @@ fileHandle_t FS_OpenFileMapping( const char *path, qboolean temp )
 
 	// the path isn't a unique file, don't map it
 	if ( FS_FileIsInBFF( path ) ) {
-		f->data.chunk = FS_GetChunkHandle( path, &f->bffIndex );
-		if ( !f->data.chunk ) {
+		chunk = FS_GetChunkHandle( path, &bff );
+		if ( !chunk ) {
+			FS_ReleaseHandle( fd );
+			return FS_INVALID_HANDLE;
+		}
+		if ( !FS_OpenChunk( path, chunk, f, bff ) ) {
 			return FS_INVALID_HANDLE;
 		}
-		N_strncpyz( f->name, f->data.chunk->name, MAX_NPATH );
 		f->mapped = qfalse;
-		f->bff = fs_archives[f->bffIndex];
-		f->bffFile = qtrue;
-		f->used = qtrue;
 		return fd;
 	}
 
@@ -1119,6 +1540,7 @@ fileHandle_t FS_OpenFileMapping( const char *path, qboolean temp )
 			f->data.fp = fp;
 			break;
 		}
+		FS_ReleaseHandle( fd );
 		return FS_INVALID_HANDLE;
 	}
 
@@ -1183,23 +1605,20 @@ static qboolean FS_GeneralRef( const char *filename )
 	return qtrue;
 }
 
-static void FS_OpenChunk( const char *name, fileInBFF_t *chunk, fileHandleData_t *f, bffFile_t *bff )
+/*
+* FS_OpenBFFHandle: the archive's descriptor is opened (and mapped) once and then shared by every
+* handle until the bff is freed, only this first open needs the lock
+*/
+static qboolean FS_OpenBFFHandle( bffFile_t *bff )
 {
 #ifdef USE_ZIP
 	int err;
-	zip_error_t error;
-	zip_file_t *file;
 #endif
-	if ( !( bff->referenced & FS_GENERAL_REF ) && FS_GeneralRef( chunk->name ) ) {
-		bff->referenced |= FS_GENERAL_REF;
-	}
-	if ( !( bff->referenced & FS_SGAME_REF ) && !strcmp( chunk->name, "vm/sgame.qvm" ) ) {
-		bff->referenced |= FS_SGAME_REF;
-	}
-	if ( !( bff->referenced & FS_UI_REF ) && !strcmp( chunk->name, "vm/ui.qvm" ) ) {
-		bff->referenced |= FS_UI_REF;
-	}
+	CThreadAutoLock<CThreadMutex> lock( fs_mutex );
 
+	if ( bff->opened ) {
+		return qtrue;
+	}
 
 	if ( !bff->handle ) {
 #ifdef USE_ZIP
@@ -1208,18 +1627,75 @@ static void FS_OpenChunk( const char *name, fileInBFF_t *chunk, fileHandleData_t
 		bff->handle = Sys_FOpen( bff->bffFilename, "rb" );
 #endif
 		if ( !bff->handle ) {
-			Con_Printf( COLOR_RED "Error opening %s@%s\n", bff->bffBasename, name );
-			memset( f, 0, sizeof( *f ) );
-			return;
+			return qfalse;
 		}
 	}
 
+#ifndef USE_ZIP
+	// reads fall back to the descriptor if the mapping fails
+	if ( fs_mapBFFs->i ) {
+		bff->mapping = Sys_MapFile( bff->bffFilename, qfalse );
+		if ( bff->mapping ) {
+			bff->mappedData = (const byte *)Sys_GetMappedFileBuffer( bff->mapping );
+			bff->mappedSize = Sys_GetMappedFileSize( bff->mapping );
+		}
+	}
+#endif
+
+	bff->opened = qtrue;
+
+	return qtrue;
+}
+
+/*
+* FS_ChunkView: returns the chunk's data in the archive's mapping if it's stored uncompressed
+*/
+static const byte *FS_ChunkView( const bffFile_t *bff, const fileInBFF_t *chunk )
+{
+#ifndef USE_ZIP
+	if ( bff->mappedData && chunk->compression == COMPRESS_NONE && (uint64_t)( chunk->pos + chunk->size ) <= bff->mappedSize ) {
+		return bff->mappedData + chunk->pos;
+	}
+#endif
+	return NULL;
+}
+
+static qboolean FS_OpenChunk( const char *name, fileInBFF_t *chunk, fileHandleData_t *f, bffFile_t *bff )
+{
+#ifdef USE_ZIP
+	zip_error_t error;
+	zip_file_t *file;
+#endif
+	uint32_t referenced;
+
+	referenced = 0;
+	if ( !( bff->referenced & FS_GENERAL_REF ) && FS_GeneralRef( chunk->name ) ) {
+		referenced |= FS_GENERAL_REF;
+	}
+	if ( !( bff->referenced & FS_SGAME_REF ) && !strcmp( chunk->name, "vm/sgame.qvm" ) ) {
+		referenced |= FS_SGAME_REF;
+	}
+	if ( !( bff->referenced & FS_UI_REF ) && !strcmp( chunk->name, "vm/ui.qvm" ) ) {
+		referenced |= FS_UI_REF;
+	}
+
+	if ( referenced ) {
+		CThreadAutoLock<CThreadMutex> lock( fs_mutex );
+		bff->referenced |= referenced;
+	}
+
+	if ( !bff->opened && !FS_OpenBFFHandle( bff ) ) {
+		Con_Printf( COLOR_RED "Error opening %s@%s\n", bff->bffBasename, name );
+		FS_ReleaseHandle( (fileHandle_t)( f - handles ) );
+		return qfalse;
+	}
+
 #ifdef USE_ZIP
 	chunk->file = zip_fopen_index( bff->handle, chunk->pos, 0 );
 	if ( !chunk->file ) {
 		Con_Printf( COLOR_RED "Error opening %s@%s\n", bff->bffBasename, name );
-		memset( f, 0, sizeof( *f ) );
-		return;
+		FS_ReleaseHandle( (fileHandle_t)( f - handles ) );
+		return qfalse;
 	}
 	f->zipFilePos = chunk->pos;
 	f->zipFileLen = chunk->size;
@@ -1229,11 +1705,13 @@ static void FS_OpenChunk( const char *name, fileInBFF_t *chunk, fileHandleData_t
 	f->bffIndex = bff->index;
 	f->bffFile = qtrue;
 	f->data.chunk = chunk;
-	f->used = qtrue;
+	f->bffPos = 0;
 	fs_lastBFFIndex = bff->index;
 	N_strncpyz( f->name, chunk->name, sizeof( f->name ) );
 
 	bff->handlesUsed++;
+
+	return qtrue;
 }
 
 
@@ -1570,7 +2048,7 @@ static qboolean fs_cacheSynced = qtrue;
 // 3: [size of file offset and file time]
 // non-matching header will cause whole file being ignored
 static const byte cache_header[ 4 ] = {
-	0, //version
+	1, //version
 #ifdef GDR_LITTLE_ENDIAN
 	0x0,
 #else
@@ -1596,6 +2074,7 @@ typedef struct {
 	int64_t compressedSize;
 	int64_t size;
 	int64_t pos;
+	int64_t compression;
 } bffCacheFileItem_t;
 
 #pragma pack(pop)
@@ -1841,6 +2320,7 @@ static void FS_WriteCachedItems( const bffFile_t *bff, char *namePtr, FILE *f )
 		it.name = (uint64_t)( bff->buildBuffer[i].name - namePtr );
 		it.size = bff->buildBuffer[i].size;
 		it.pos = bff->buildBuffer[i].pos;
+		it.compression = bff->buildBuffer[i].compression;
 		fwrite( &it, sizeof( it ), 1, f );
 	}
 }
@@ -1898,6 +2378,7 @@ static qboolean FS_SaveBFFToFile( const bffFile_t *bff, FILE *f )
 		it.size = bff->buildBuffer[i].size;
 		it.compressedSize = bff->buildBuffer[i].compressedSize;
 		it.pos = bff->buildBuffer[i].pos;
+		it.compression = bff->buildBuffer[i].compression;
 		fwrite( &it, sizeof( it ), 1, f );
 	}
 
@@ -2049,6 +2530,7 @@ static qboolean FS_LoadBffFromFile( FILE *f )
 			curFile->size = it.size;
 			curFile->pos = it.pos;
 			curFile->compressedSize = it.compressedSize;
+			curFile->compression = it.compression;
 
 			// update hash table
 			hash = FS_HashFileName( filename_inbff, bff->hashSize );
@@ -2219,6 +2701,47 @@ BFF FILE LOADING
 /*
 * FS_LoadBFF: creates a new bffFile_t in the search chain for the contents of a bff archive file
 */
+#ifndef USE_ZIP
+/*
+* FS_ReadChunkCompression: archives before BFF_VERSION_CHUNK_COMPRESSION only have the header's
+* method and no compressedSize for stored chunks, newer ones have both for every chunk
+*/
+static qboolean FS_ReadChunkCompression( const bffheader_t *header, int64_t *compression, uint64_t *compressedSize, FILE *fp )
+{
+	if ( header->version >= BFF_VERSION_CHUNK_COMPRESSION ) {
+		if ( !fread( compression, sizeof( *compression ), 1, fp ) ) {
+			return qfalse;
+		}
+		*compression = LittleLong( *compression );
+	} else {
+		*compression = header->compression;
+		if ( *compression == COMPRESS_NONE ) {
+			return qtrue;
+		}
+	}
+	if ( !fread( compressedSize, sizeof( *compressedSize ), 1, fp ) ) {
+		return qfalse;
+	}
+	*compressedSize = LittleLong( *compressedSize );
+	return qtrue;
+}
+
+static qboolean FS_CompressionSupported( int64_t compression )
+{
+	switch ( compression ) {
+	case COMPRESS_NONE:
+	case COMPRESS_ZLIB:
+	case COMPRESS_BZIP2:
+	case COMPRESS_ZSTD:
+	case COMPRESS_LZ4:
+		return qtrue;
+	default:
+		break;
+	};
+	return qfalse;
+}
+#endif
+
 static bffFile_t *FS_LoadBFF( const char *bffpath )
 {
 	CThreadAutoLock<CThreadMutex> lock( fs_mutex );
@@ -2240,6 +2763,7 @@ static bffFile_t *FS_LoadBFF( const char *bffpath )
 	uint64_t gameNameLen;
 	uint64_t baseNameLen, fileNameLen;
 	uint64_t compressedSize;
+	int64_t compression;
 	FILE *fp;
 	fileStats_t stats;
 	char *tempBuf;
@@ -2396,12 +2920,17 @@ static bffFile_t *FS_LoadBFF( const char *bffpath )
 			Con_Printf( COLOR_RED "ERROR: failed reading chunk size at %lu\n", i );
 			return NULL;
 		}
-		if ( header.compression != COMPRESS_NONE ) {
-			if ( !fread( &compressedSize, sizeof( compressedSize ), 1, fp ) ) {
-				fclose( fp );
-				Con_Printf( COLOR_RED "ERROR: failed reading chunk compressedSize size at %lu\n", i );
-				return NULL;
-			}
+		if ( !FS_ReadChunkCompression( &header, &compression, &compressedSize, fp ) ) {
+			fclose( fp );
+			Con_Printf( COLOR_RED "ERROR: failed reading chunk compressedSize size at %lu\n", i );
+			return NULL;
+		}
+		if ( !FS_CompressionSupported( compression ) ) {
+			fclose( fp );
+			Con_Printf( COLOR_RED "ERROR: chunk %lu in '%s' uses unknown compression method %li\n", i, bffpath, compression );
+			return NULL;
+		}
+		if ( compression != COMPRESS_NONE ) {
 			tmp = compressedSize;
 		}
 		fseek( fp, tmp, SEEK_CUR );
@@ -2518,12 +3047,12 @@ static bffFile_t *FS_LoadBFF( const char *bffpath )
 			Con_Printf( COLOR_RED "ERROR: failed reading chunk size at %lu\n", i );
 			return NULL;
 		}
-		if ( header.compression != COMPRESS_NONE ) {
-			if ( !fread( &compressedSize, sizeof( compressedSize ), 1, fp ) ) {
-				fclose( fp );
-				Con_Printf( COLOR_RED "ERROR: failed reading chunk size at %lu\n", i );
-				return NULL;
-			}
+		if ( !FS_ReadChunkCompression( &header, &curFile->compression, &compressedSize, fp ) ) {
+			fclose( fp );
+			Con_Printf( COLOR_RED "ERROR: failed reading chunk size at %lu\n", i );
+			return NULL;
+		}
+		if ( curFile->compression != COMPRESS_NONE ) {
 			curFile->compressedSize = compressedSize;
 		} else {
 			curFile->compressedSize = curFile->size;
@@ -2538,7 +3067,6 @@ static bffFile_t *FS_LoadBFF( const char *bffpath )
 		// store the file position in the bff
 		curFile->pos = ftell( fp );
 		curFile->name = namePtr;
-		curFile->compression = header.compression;
 		strcpy( curFile->name, filename_inbff );
 		namePtr += strlen( filename_inbff ) + 1;
 
@@ -2605,13 +3133,21 @@ Frees a bff structure and releases all associated resources
 */
 static void FS_FreeBFF( bffFile_t *bff )
 {
+#ifdef USE_ZIP
 	fileInBFF_t *file;
 	uint64_t i;
+#endif
 
 	if ( !bff ) {
 		N_Error( ERR_FATAL, "FS_FreeBFF(NULL)" );
 	}
 
+	if ( bff->mapping ) {
+		Sys_UnmapFile( bff->mapping );
+		bff->mapping = NULL;
+		bff->mappedData = NULL;
+	}
+
 	if ( bff->handle ) {
 #ifdef USE_HANDLE_CACHE
 		if ( bff->next_h ) {
@@ -2625,17 +3161,13 @@ static void FS_FreeBFF( bffFile_t *bff )
 	#endif
 		bff->handle = NULL;
 
+#ifdef USE_ZIP
 		for ( file = bff->buildBuffer, i = 0; i < bff->numfiles; file = bff->buildBuffer->next, i++ ) {
-#ifndef USE_ZIP
-			if ( file->buf ) {
-				Z_Free( file->buf );
-			}
-#else
 			if ( file->file ) {
 				zip_fclose( file->file );
 			}
-#endif
 		}
+#endif
 	}
 
 	Z_Free( bff );
@@ -2686,7 +3218,6 @@ void FS_ForceFlush(fileHandle_t f)
 
 fileOffset_t FS_FileTell( fileHandle_t f )
 {
-	CThreadAutoLock<CThreadMutex> lock( fs_mutex );
 	fileHandleData_t *p;
 
 	if ( f <= FS_INVALID_HANDLE || f >= MAX_FILE_HANDLES ) {
@@ -2699,7 +3230,7 @@ fileOffset_t FS_FileTell( fileHandle_t f )
 	if ( p->bffFile ) {
 #ifdef USE_ZIP
 #else
-		return (fileOffset_t)( p->data.chunk->size - p->data.chunk->bytesRead );
+		return (fileOffset_t)( p->data.chunk->size - p->bffPos );
 #endif
 	}
 	
@@ -2711,7 +3242,6 @@ fileOffset_t FS_FileTell( fileHandle_t f )
 
 fileOffset_t FS_FileSeek( fileHandle_t f, fileOffset_t offset, uint32_t whence )
 {
-	CThreadAutoLock<CThreadMutex> lock( fs_mutex );
 	fileHandleData_t *file;
 	uint32_t fwhence;
 	
@@ -2746,23 +3276,23 @@ fileOffset_t FS_FileSeek( fileHandle_t f, fileOffset_t offset, uint32_t whence )
 		if ( whence == FS_SEEK_END && offset ) {
 			return -1;
 		}
-		else if ( whence == FS_SEEK_CUR && file->data.chunk->bytesRead + offset >= file->data.chunk->size ) {
+		else if ( whence == FS_SEEK_CUR && file->bffPos + offset >= file->data.chunk->size ) {
 			return -1;
 		}
 		switch ( whence ) {
 		case FS_SEEK_CUR:
-			file->data.chunk->bytesRead += offset;
+			file->bffPos += offset;
 			break;
 		case FS_SEEK_BEGIN:
-			file->data.chunk->bytesRead = offset;
+			file->bffPos = offset;
 			break;
 		case FS_SEEK_END:
-			file->data.chunk->bytesRead = file->data.chunk->size - offset;
+			file->bffPos = file->data.chunk->size - offset;
 			break;
 		default:
 			N_Error( ERR_FATAL, "FS_FileSeek: invalid seek" );
 		};
-		return (fileOffset_t)( file->data.chunk->size - file->data.chunk->bytesRead );
+		return (fileOffset_t)( file->data.chunk->size - file->bffPos );
 	#endif
 	}
 
@@ -2784,7 +3314,6 @@ fileOffset_t FS_FileSeek( fileHandle_t f, fileOffset_t offset, uint32_t whence )
 
 uint64_t FS_FileLength( fileHandle_t f )
 {
-	CThreadAutoLock<CThreadMutex> lock( fs_mutex );
 	uint64_t curPos, length;
 
 	if ( f <= FS_INVALID_HANDLE || f >= MAX_FILE_HANDLES ) {
@@ -2855,59 +3384,55 @@ uint64_t FS_Write( const void *buffer, uint64_t size, fileHandle_t f )
 }
 
 #ifndef USE_ZIP
-static uint64_t FS_ReadFromChunk( void *buffer, uint64_t size, fileHandle_t f )
+/*
+* FS_DecompressChunk: compressed chunks can't be read piecewise, so the handle gets its own
+* decompressed copy on the first read. Reads can come from any thread and neither the zone nor
+* the temp hunk have a lock, so both buffers are malloc'd
+*/
+static void FS_DecompressChunk( fileHandleData_t *handle )
 {
-	CThreadAutoLock<CThreadMutex> lock( fs_mutex );
-	fileHandleData_t *handle = &handles[f];
+	const fileInBFF_t *chunk = handle->data.chunk;
+	char *tempBuf;
 
-	if ( !handle->data.chunk->buf ) {
-		if ( handle->data.chunk->compression != COMPRESS_NONE ) {
-			uint64_t outLen;
-			int64_t compressedSize;
-			char *tempBuf;
+	tempBuf = (char *)malloc( chunk->compressedSize );
+	handle->bffBuf = (char *)malloc( chunk->size );
+	if ( !tempBuf || !handle->bffBuf ) {
+		N_Error( ERR_FATAL, "FS_ReadFromChunk: failed to allocate %li bytes for %s", chunk->size + chunk->compressedSize, handle->name );
+	}
+	if ( !FS_ReadAt( handle->bff, tempBuf, chunk->compressedSize, chunk->pos ) ) {
+		N_Error( ERR_FATAL, "Error reading chunk buffer at %s", handle->name );
+	}
+	if ( !DecompressInto( tempBuf, chunk->compressedSize, handle->bffBuf, chunk->size, chunk->compression ) ) {
+		N_Error( ERR_DROP, "FS_ReadFromChunk: %s didn't decompress to the expected %li bytes", handle->name, chunk->size );
+	}
+	free( tempBuf );
+}
 
-			outLen = handle->data.chunk->size;
-			tempBuf = (char *)Hunk_AllocateTempMemory( handle->data.chunk->compressedSize );
+static uint64_t FS_ReadFromChunk( void *buffer, uint64_t size, fileHandle_t f )
+{
+	fileHandleData_t *handle = &handles[f];
+	const fileInBFF_t *chunk = handle->data.chunk;
+	const byte *view;
 
-			fseek( handle->bff->handle, handle->data.chunk->pos, SEEK_SET );
-			if ( !fread( tempBuf, handle->data.chunk->compressedSize, 1, handle->bff->handle ) ) {
-				N_Error( ERR_FATAL, "Error reading chunk buffer at %s", handle->name );
-			}
-			handle->data.chunk->buf = Decompress( tempBuf, handle->data.chunk->compressedSize, &outLen, handle->data.chunk->compression );
-			handle->data.chunk->size = outLen;
-			Hunk_FreeTempMemory( tempBuf );
-		}
-		else {
-			// read the chunk data
-			handle->data.chunk->buf = (char *)Z_Malloc( handle->data.chunk->size, TAG_BFF );
-			fseek( handle->bff->handle, handle->data.chunk->pos, SEEK_SET );
-			if ( !fread( handle->data.chunk->buf, handle->data.chunk->size, 1, handle->bff->handle ) ) {
-				fclose( handle->bff->handle );
-				N_Error( ERR_DROP, "Error reading chunk buffer at %lu\n", (uint64_t)( handle->bff->buildBuffer - handle->data.chunk ) );
-			}
-			handle->data.chunk->bytesRead = 0;
-		}
+	if ( handle->bffPos + size > (uint64_t)chunk->size ) {
+		N_Error( ERR_FATAL, "FS_ReadFromChunk: overread of %lu bytes\n", ( handle->bffPos + size ) - chunk->size );
 	}
 
-	if ( handle->data.chunk->bytesRead + size > handle->data.chunk->size ) {
-#if 0
-		if (size >= handle->data.chunk->size) {
-			N_Error( ERR_FATAL, "FS_ReadFromChunk: size >= chunk size" );
-		}
-		else {
-			uint64_t amount = (handle->data.chunk->bytesRead + size) - handle->data.chunk->size;
-			Con_DPrintf( "WARNING: chunk overread of %lu bytes\n", amount );
-			size = amount;
+	if ( ( view = FS_ChunkView( handle->bff, chunk ) ) != NULL ) {
+		memcpy( buffer, view + handle->bffPos, size );
+	}
+	else if ( chunk->compression != COMPRESS_NONE ) {
+		if ( !handle->bffBuf ) {
+			FS_DecompressChunk( handle );
 		}
-#else
-		N_Error( ERR_FATAL, "FS_ReadFromChunk: overread of %lu bytes\n",
-			( handle->data.chunk->bytesRead + size ) - handle->data.chunk->size );
-#endif
+		memcpy( buffer, handle->bffBuf + handle->bffPos, size );
+	}
+	// stored chunks go straight from the archive into the caller's buffer
+	else if ( !FS_ReadAt( handle->bff, buffer, size, chunk->pos + handle->bffPos ) ) {
+		N_Error( ERR_DROP, "Error reading chunk buffer at %lu\n", (uint64_t)( chunk - handle->bff->buildBuffer ) );
 	}
 
-	fseek( handle->bff->handle, handle->data.chunk->pos + handle->data.chunk->bytesRead, SEEK_SET );
-	memcpy( buffer, handle->data.chunk->buf + handle->data.chunk->bytesRead, size );
-	handle->data.chunk->bytesRead += size;
+	handle->bffPos += size;
 	return size;
 }
 #endif
@@ -2921,7 +3446,6 @@ Properly handles partial reads
 */
 uint64_t FS_Read( void *buffer, uint64_t size, fileHandle_t f )
 {
-	CThreadAutoLock<CThreadMutex> lock( fs_mutex );
 	int64_t readCount, remaining, block;
 	byte *buf;
 	int tries;
@@ -2936,7 +3460,7 @@ uint64_t FS_Read( void *buffer, uint64_t size, fileHandle_t f )
 	buf = (byte *)buffer;
 	fs_readCount += size;
 
-	if ( !handles[f].bffFile || !N_stricmp( COM_GetExtension( handles[f].name ), "ngd" ) ) {
+	if ( !handles[f].bffFile ) {
 		remaining = size;
 		tries = 0;
 
@@ -3417,7 +3941,6 @@ void GDR_DECL FS_Printf(fileHandle_t f, const char *fmt, ...)
 
 fileHandle_t FS_FOpenWrite(const char *path)
 {
-	CThreadAutoLock<CThreadMutex> lock( fs_mutex );
 	fileHandle_t fd;
 	fileHandleData_t *f;
 	FILE *fp;
@@ -3450,24 +3973,26 @@ fileHandle_t FS_FOpenWrite(const char *path)
 	fp = Sys_FOpen(ospath, "wb");
 	if (!fp) {
 		if (FS_CreatePath(ospath)) {
+			FS_ReleaseHandle(fd);
 			return FS_INVALID_HANDLE;
 		}
 		fp = Sys_FOpen(ospath, "wb");
 		if (!fp) {
+			FS_ReleaseHandle(fd);
 			return FS_INVALID_HANDLE;
 		}
 	}
 
 	N_strncpyz(f->name, path, sizeof(f->name));
-	f->used = qtrue;
 	f->data.fp = fp;
 
+	FS_FlushMissingFiles();
+
 	return fd;
 }
 
 fileHandle_t FS_FOpenRW(const char *path)
 {
-	CThreadAutoLock<CThreadMutex> lock( fs_mutex );
 	fileHandle_t fd;
 	fileHandleData_t *f;
 	FILE *fp;
@@ -3501,23 +4026,16 @@ fileHandle_t FS_FOpenRW(const char *path)
 		N_Error(ERR_FATAL, "FS_FOpenRW: failed to create read/write stream for %s", path);
 	}
 
-	f->used = qtrue;
 	f->data.fp = fp;
 
+	FS_FlushMissingFiles();
+
 	return fd;
 }
 
 fileHandle_t FS_FOpenRead( const char *path )
 {
-	CThreadAutoLock<CThreadMutex> lock( fs_mutex );
 	fileHandle_t fd;
-	fileHandleData_t *f;
-	fileInBFF_t *chunk;
-	int64_t unused;
-	searchpath_t *sp;
-	FILE *fp;
-	const char *ospath;
-	uint64_t fullHash, hash;
 
 	if (!fs_searchpaths) {
 		N_Error(ERR_FATAL, "Filesystem call made without initialization");
@@ -3526,59 +4044,80 @@ fileHandle_t FS_FOpenRead( const char *path )
 		N_Error(ERR_FATAL, "FS_FOpenRead: NULL or empty path");
 	}
 
-	fd = FS_HandleForFile();
-	if (fd == FS_INVALID_HANDLE)
-		return fd;
-	
-	f = &handles[fd];
-	FS_InitHandle(f);
+	FS_FOpenFileRead( path, &fd );
 
-	// we will calculate full hash only once then just mask it by current bff->hashSize
-	// we can do that as long as we know properties of our hash function
-	fullHash = FS_HashFileName( path, 0U );
+	return fd;
+}
 
-	for (sp = fs_searchpaths; sp; sp = sp->next) {
-		// is the element a bff file?
-		if (sp->bff) {
-			// look through all the chunks
-			chunk = FS_GetChunkHandle(path, &unused);
-			if (chunk) {
-				// found it!
-				FS_OpenChunk(path, chunk, f, sp->bff);
-				return fd;
-			}
-		}
-		else if (sp->dir) {
-			ospath = FS_BuildOSPath(sp->dir->path, sp->dir->gamedir, path);
-			Con_DPrintf("FS_FOpenRead: %s\n", ospath);
-			fp = Sys_FOpen(ospath, "rb");
-			if (!fp) {
-				continue;
-			}
+/*
+* FS_OpenDirFile: returns qfalse if path isn't in the directory, fd can be NULL if all that's wanted is the length
+*/
+static qboolean FS_OpenDirFile( const char *path, const directory_t *dir, fileHandle_t *fd, uint64_t *length )
+{
+	fileHandleData_t *f;
+	const char *ospath;
+	FILE *fp;
 
-			f->data.fp = fp;
-			N_strncpyz(f->name, path, sizeof(f->name));
-			f->bffFile = qfalse;
-			f->used = qtrue;
+	ospath = FS_BuildOSPath( dir->path, dir->gamedir, path );
+	fs_lookupSyscalls++;
+	fp = Sys_FOpen( ospath, "rb" );
+	if ( !fp ) {
+		return qfalse;
+	}
 
-			return fd;
-		}
+	*length = FS_FileLength( fp );
+
+	if ( fd == NULL ) {
+		fclose( fp );
+		return qtrue;
 	}
 
-	return FS_INVALID_HANDLE;
+	*fd = FS_HandleForFile();
+	if ( *fd == FS_INVALID_HANDLE ) {
+		fclose( fp );
+		*length = 0;
+		return qtrue;
+	}
+
+	f = &handles[*fd];
+	FS_InitHandle( f );
+
+	f->data.fp = fp;
+	N_strncpyz( f->name, path, sizeof( f->name ) );
+	f->bffFile = qfalse;
+
+	return qtrue;
 }
 
-uint64_t FS_FOpenFileRead(const char *path, fileHandle_t *fd)
+static uint64_t FS_OpenBFFFile( const char *path, fileInBFF_t *chunk, bffFile_t *bff, fileHandle_t *fd )
 {
-	CThreadAutoLock<CThreadMutex> lock( fs_mutex );
 	fileHandleData_t *f;
-	const char *ospath;
-	FILE *fp;
-	searchpath_t *sp;
+
+	if ( fd == NULL ) {
+		return chunk->size;
+	}
+
+	*fd = FS_HandleForFile();
+	if ( *fd == FS_INVALID_HANDLE ) {
+		return 0;
+	}
+	f = &handles[*fd];
+	FS_InitHandle( f );
+
+	if ( !FS_OpenChunk( path, chunk, f, bff ) ) {
+		*fd = FS_INVALID_HANDLE;
+		return 0;
+	}
+	return chunk->size;
+}
+
+uint64_t FS_FOpenFileRead(const char *path, fileHandle_t *fd)
+{
+	const searchpath_t *sp;
+	const fileIndex_t *entry;
 	fileInBFF_t *chunk;
-	int64_t index;
 	uint64_t length;
-	uint64_t fullHash, hash;
+	uint64_t fullHash;
 
 	if (!fs_searchpaths) {
 		N_Error(ERR_FATAL, "Filesystem call made without initialization");
@@ -3596,7 +4135,9 @@ uint64_t FS_FOpenFileRead(const char *path, fileHandle_t *fd)
 	// The searchpaths do guarantee that something will always
 	// be prepended, so we don't need to worry about "c:" or "//limbo"
 	if ( FS_CheckDirTraversal( path ) ) {
-		*fd = FS_INVALID_HANDLE;
+		if ( fd ) {
+			*fd = FS_INVALID_HANDLE;
+		}
 		return -1;
 	}
 
@@ -3604,31 +4145,20 @@ uint64_t FS_FOpenFileRead(const char *path, fileHandle_t *fd)
 	// we can do that as long as we know properties of our hash function
 	fullHash = FS_HashFileName( path, 0U );
 
-	// we just want the file's size
-	if (fd == NULL) {
-		for (sp = fs_searchpaths; sp; sp = sp->next) {
-			// is the element a bff file?
-			if (sp->bff && sp->bff->hashTable[(hash = fullHash & (sp->bff->hashSize-1))]) {
-				// look through all the bff chunks
-				chunk = sp->bff->hashTable[hash];
-				do {
-					// case and separator insensitive comparisons
-					if (FS_FilenameCompare(chunk->name, path)) {
-						// found it!
-						return chunk->size;
-					}
-					chunk = chunk->next;
-				} while (chunk != NULL);
-			}
-			else if (sp->dir) {
-				ospath = FS_BuildOSPath(sp->dir->path, sp->dir->gamedir, path);
-				fp = Sys_FOpen(ospath, "rb");
-				if (fp) {
-					length = FS_FileLength(fp);
-					fclose(fp);
-					return length;
-				}
-			}
+	// the index knows where it is, or that it's nowhere
+	entry = FS_FindInIndex( path, fullHash );
+	if ( entry ) {
+		if ( entry->chunk ) {
+			return FS_OpenBFFFile( path, entry->chunk, entry->sp->bff, fd );
+		}
+		if ( FS_OpenDirFile( path, entry->sp->dir, fd, &length ) ) {
+			return length;
+		}
+		// it's been deleted since the index was built, look for it the slow way
+	}
+	if ( FS_IsMissingFile( path, fullHash ) ) {
+		if ( fd ) {
+			*fd = FS_INVALID_HANDLE;
 		}
 		return 0;
 	}
@@ -3638,51 +4168,31 @@ uint64_t FS_FOpenFileRead(const char *path, fileHandle_t *fd)
 	//
 	for (sp = fs_searchpaths; sp; sp = sp->next) {
 		// is the element a bff file?
-		if (sp->bff && sp->bff->hashTable[(hash = fullHash & (sp->bff->hashSize-1))]) {
+		if (sp->bff && sp->bff->hashTable[fullHash & (sp->bff->hashSize-1)]) {
 			// look through all the bff chunks
-			chunk = sp->bff->hashTable[hash];
+			chunk = sp->bff->hashTable[fullHash & (sp->bff->hashSize-1)];
 			do {
 				// case and separator insensitive comparisons
 				if (FS_FilenameCompare(chunk->name, path)) {
 					// found it!
-					*fd = FS_HandleForFile();
-					if (*fd == FS_INVALID_HANDLE) {
-						return 0;
-					}
-					f = &handles[*fd];
-					FS_InitHandle(f);
-
-					FS_OpenChunk(path, chunk, f, sp->bff);
-					return chunk->size;
+					return FS_OpenBFFFile( path, chunk, sp->bff, fd );
 				}
 				chunk = chunk->next;
 			} while (chunk != NULL);
 		}
 		else if (sp->dir) {
 			// check a file in the directory tree
-			ospath = FS_BuildOSPath(sp->dir->path, sp->dir->gamedir, path);
-			fp = Sys_FOpen(ospath, "rb");
-			if (!fp) {
-				continue;
+			if ( FS_OpenDirFile( path, sp->dir, fd, &length ) ) {
+				return length;
 			}
-
-			*fd = FS_HandleForFile();
-			if (*fd == FS_INVALID_HANDLE) {
-				return 0;
-			}
-
-			f = &handles[*fd];
-			FS_InitHandle(f);
-
-			f->data.fp = fp;
-			N_strncpyz(f->name, path, sizeof(f->name));
-			f->bffFile = qfalse;
-
-			return FS_FileLength(fp);
 		}
 	}
 
-	*fd = FS_INVALID_HANDLE;
+	FS_AddMissingFile( path, fullHash );
+
+	if ( fd ) {
+		*fd = FS_INVALID_HANDLE;
+	}
 	return 0;
 }
 
@@ -3692,7 +4202,6 @@ A null buffer will just return the file length without loading
 */
 uint64_t FS_LoadFile(const char *npath, void **buffer)
 {
-	CThreadAutoLock<CThreadMutex> lock( fs_mutex );
 	fileHandle_t fd;
 	fileHandleData_t *f;
 	byte *buf;
@@ -3719,13 +4228,16 @@ uint64_t FS_LoadFile(const char *npath, void **buffer)
 		return size;
 	}
 
-	buf = (byte *)Hunk_AllocateTempMemory(size + 1);
+	{
+		// only covers fs_loadStack, the temp hunk makes FS_LoadFile main thread only anyway
+		CThreadAutoLock<CThreadMutex> lock( fs_mutex );
+		buf = (byte *)Hunk_AllocateTempMemory(size + 1);
+		fs_loadStack++;
+	}
 	*buffer = buf;
 
 	FS_Read( buf, size, fd );
 
-	fs_loadStack++;
-
 	// guarentee that it will have a trialing 0 for string operations
 	buf[size] = '\0';
 	FS_FClose( fd );
@@ -3766,9 +4278,79 @@ void FS_FreeFile( void *buffer )
 	}
 }
 
+/*
+* FS_LoadFileView: like FS_LoadFile, but an uncompressed chunk in a mapped bff is returned straight out of
+* the mapping instead of being copied into temp memory. The view is read-only, it isn't guaranteed to be
+* zero terminated and it has to be released with FS_FreeFileView
+*/
+uint64_t FS_LoadFileView( const char *npath, const void **buffer )
+{
+	fileHandle_t fd;
+	const byte *view;
+	uint64_t size;
+	byte *buf;
+
+	if ( !fs_searchpaths ) {
+		N_Error( ERR_FATAL, "Filesystem call made without initialization" );
+	}
+	if ( !npath || !*npath ) {
+		N_Error( ERR_FATAL, "FS_LoadFileView: NULL or empty path" );
+	}
+	if ( !buffer ) {
+		N_Error( ERR_FATAL, "FS_LoadFileView: NULL buffer" );
+	}
+
+	*buffer = NULL;
+
+	size = FS_FOpenFileRead( npath, &fd );
+	if ( fd == FS_INVALID_HANDLE ) {
+		return 0;
+	}
+
+	view = handles[fd].bffFile ? FS_ChunkView( handles[fd].bff, handles[fd].data.chunk ) : NULL;
+	if ( view ) {
+		FS_FClose( fd );
+		fs_readCount += size;
+		*buffer = view;
+		return size;
+	}
+
+	// not mapped, same as FS_LoadFile
+	{
+		CThreadAutoLock<CThreadMutex> lock( fs_mutex );
+		buf = (byte *)Hunk_AllocateTempMemory( size + 1 );
+		fs_loadStack++;
+	}
+	FS_Read( buf, size, fd );
+	buf[size] = '\0';
+	FS_FClose( fd );
+
+	*buffer = buf;
+	return size;
+}
+
+void FS_FreeFileView( const void *buffer )
+{
+	const searchpath_t *sp;
+	const byte *p;
+
+	if ( !buffer ) {
+		N_Error( ERR_FATAL, "FS_FreeFileView(NULL)" );
+	}
+
+	// views into a mapping live as long as the bff does
+	p = (const byte *)buffer;
+	for ( sp = fs_searchpaths; sp; sp = sp->next ) {
+		if ( sp->bff && sp->bff->mappedData && p >= sp->bff->mappedData && p < sp->bff->mappedData + sp->bff->mappedSize ) {
+			return;
+		}
+	}
+
+	FS_FreeFile( (void *)buffer );
+}
+
 void FS_FClose( fileHandle_t f )
 {
-	CThreadAutoLock<CThreadMutex> lock( fs_mutex );
 	fileHandleData_t *p;
 //	fileStats_t stats;
 
@@ -3782,31 +4364,17 @@ void FS_FClose( fileHandle_t f )
 #ifdef USE_ZIP
 		zip_fclose( p->data.chunk->file );
 #else
-		p->data.chunk->bytesRead = 0;
-		if ( p->data.chunk->buf ) {
-			Z_Free( p->data.chunk->buf );
-			p->data.chunk->buf = NULL;
-		}
+		free( p->bffBuf );
+		p->bffBuf = NULL;
 #endif
 		p->data.stream = NULL;
 		p->bffFile = qfalse;
+		// the archive's descriptor stays open for the other handles until the bff is freed
 		p->bff->handlesUsed--;
 #ifdef USE_HANDLE_CACHE
 		if ( p->bff->handlesUsed == 0 ) {
 			FS_AddToHandleList( p->bff );
 		}
-#endif
-#ifdef USE_BFF_CACHE_FILE
-		if ( !fs_locked->i ) {
-			if ( p->bff->handle && !p->bff->handlesUsed ) {
-#ifdef USE_ZIP
-				zip_close( p->bff->handle );
-#else
-				fclose( p->bff->handle );
-#endif
-				p->bff->handle = NULL;
-			}
-		}
 #endif
 	}
 	else {
@@ -3816,7 +4384,7 @@ void FS_FClose( fileHandle_t f )
 		}
 	}
 
-	memset( p, 0, sizeof( *p ) );
+	FS_ReleaseHandle( f );
 }
 
 qboolean FS_StripExt( char *filename, const char *ext )
@@ -4062,6 +4630,8 @@ void FS_Rename( const char *from, const char *to ) {
 		FS_CopyFile( from_ospath, to_ospath );
 		FS_Remove( from_ospath );
 	}
+
+	FS_FlushMissingFiles();
 }
 
 static void FS_AddGameDirectory( const char *path, const char *dir )
@@ -4354,6 +4924,7 @@ static void FS_AddMod_f( void )
 	}
 
 	FS_AddGameDirectory(moddir, moddir);
+	FS_BuildIndex();
 }
 
 static void FS_Touch_f(void)
@@ -4396,6 +4967,8 @@ void FS_Shutdown( qboolean closeFiles )
 	}
 	fs_searchpaths = NULL;
 
+	FS_FreeIndex();
+
 	Z_FreeTags( TAG_SEARCH_PATH );
 	Z_FreeTags( TAG_SEARCH_DIR );
 	Z_FreeTags( TAG_BFF );
@@ -4414,6 +4987,7 @@ void FS_Shutdown( qboolean closeFiles )
 	Cmd_RemoveCommand( "fs_restart" );
 	Cmd_RemoveCommand( "lsof" );
 	Cmd_RemoveCommand( "which" );
+	Cmd_RemoveCommand( "fs_readbench" );
 }
 
 void FS_Restart( void )
@@ -4479,6 +5053,118 @@ static void FS_ListOpenFiles_f( void )
 	}
 }
 
+#define FS_READBENCH_MAX_THREADS 32
+
+typedef struct {
+	const bffFile_t *bff;
+	std::atomic<uint64_t> nextFile;
+	std::atomic<uint64_t> bytesRead;
+	std::atomic<uint64_t> filesRead;
+} readBench_t;
+
+static int FS_ReadBenchThread( void *pData )
+{
+	readBench_t *bench;
+	fileHandle_t fd;
+	uint64_t index, size, bufSize;
+	char *buf;
+
+	bench = (readBench_t *)pData;
+	buf = NULL;
+	bufSize = 0;
+
+	while ( ( index = bench->nextFile++ ) < bench->bff->numfiles ) {
+		size = FS_FOpenFileRead( bench->bff->buildBuffer[ index ].name, &fd );
+		if ( fd == FS_INVALID_HANDLE ) {
+			continue;
+		}
+		if ( size > bufSize ) {
+			bufSize = size;
+			buf = (char *)realloc( buf, bufSize );
+		}
+		if ( size ) {
+			FS_Read( buf, size, fd );
+		}
+		FS_FClose( fd );
+
+		bench->bytesRead += size;
+		bench->filesRead++;
+	}
+
+	free( buf );
+	return 0;
+}
+
+/*
+* FS_ReadBench_f: loads every file in a bff with 1, 2, 4... up to fs_readbench [threads] threads
+* at once and prints the read throughput of each run
+*/
+static void FS_ReadBench_f( void )
+{
+	SDL_Thread *threads[ FS_READBENCH_MAX_THREADS ];
+	const bffFile_t *bff;
+	const searchpath_t *sp;
+	readBench_t bench;
+	uint64_t start, msec;
+	int32_t maxThreads, nThreads, i;
+
+	maxThreads = SDL_GetCPUCount();
+	if ( Cmd_Argc() > 1 ) {
+		maxThreads = atoi( Cmd_Argv( 1 ) );
+	}
+	maxThreads = CLAMP( maxThreads, 1, FS_READBENCH_MAX_THREADS );
+
+	// use the requested archive or the one with the most files in it
+	bff = NULL;
+	for ( sp = fs_searchpaths; sp; sp = sp->next ) {
+		if ( !sp->bff ) {
+			continue;
+		}
+		if ( Cmd_Argc() > 2 ) {
+			if ( !N_stricmp( sp->bff->bffBasename, Cmd_Argv( 2 ) ) ) {
+				bff = sp->bff;
+				break;
+			}
+		} else if ( !bff || sp->bff->numfiles > bff->numfiles ) {
+			bff = sp->bff;
+		}
+	}
+	if ( !bff ) {
+		Con_Printf( "fs_readbench: no bff archive to read from\n" );
+		return;
+	}
+
+	Con_Printf( "fs_readbench: reading %lu files from %s with up to %i threads\n", bff->numfiles, bff->bffBasename, maxThreads );
+
+	for ( nThreads = 1; ; nThreads = MIN( nThreads * 2, maxThreads ) ) {
+		bench.bff = bff;
+		bench.nextFile = 0;
+		bench.bytesRead = 0;
+		bench.filesRead = 0;
+
+		start = Sys_Milliseconds();
+		for ( i = 0; i < nThreads; i++ ) {
+			threads[i] = SDL_CreateThread( FS_ReadBenchThread, "FSReadBench", &bench );
+			if ( !threads[i] ) {
+				N_Error( ERR_DROP, "FS_ReadBench_f: SDL_CreateThread failed -- %s", SDL_GetError() );
+			}
+		}
+		for ( i = 0; i < nThreads; i++ ) {
+			SDL_WaitThread( threads[i], NULL );
+		}
+		msec = MAX( Sys_Milliseconds() - start, 1 );
+
+		Con_Printf( "%2i threads: %lu files, %.2f MiB in %lu msec, %.2f MiB/sec, %.0f files/sec\n", nThreads,
+			bench.filesRead.load(), (double)bench.bytesRead / ( 1024.0 * 1024.0 ), msec,
+			( (double)bench.bytesRead / ( 1024.0 * 1024.0 ) ) / ( (double)msec * 0.001 ),
+			(double)bench.filesRead / ( (double)msec * 0.001 ) );
+
+		if ( nThreads == maxThreads ) {
+			break;
+		}
+	}
+}
+
 /*
 ================
 FS_InitFilesystem
@@ -4570,9 +5256,14 @@ void FS_Startup( void )
 #ifndef USE_HANDLE_CACHE
 	fs_locked = Cvar_Get( "fs_locked", "0", CVAR_INIT );
 	Cvar_SetDescription( fs_locked, "Set file handle policy for bff files:\n"
-		" 0 - release after use, unlimited number of bff files can be loaded\n"
-		" 1 - keep file handle locked, more consistent, total bff files count limited to ~1k-4k\n" );
+		" 0 - open the bff file on first use\n"
+		" 1 - keep file handle locked from load time, total bff files count limited to ~1k-4k\n" );
 #endif
+	fs_mapBFFs = Cvar_Get( "fs_mapBFFs", "1", CVAR_INIT );
+	Cvar_SetDescription( fs_mapBFFs, "Memory-map bff files so uncompressed chunks are read without copying them." );
+	fs_assetIndex = Cvar_Get( "fs_assetIndex", "1", 0 );
+	Cvar_SetDescription( fs_assetIndex, "Index every file on the search path at startup and remember lookups that failed, so\n"
+		"opening a file doesn't have to try every directory. Changing it needs \\fs_restart to rebuild the index." );
 
 #ifdef NOMAD_STEAM_APP
 	fs_steampath = Cvar_Get( "fs_steampath", Sys_GetSteamPath(), CVAR_INIT | CVAR_PROTECTED | CVAR_PRIVATE );
@@ -4655,6 +5346,8 @@ void FS_Startup( void )
 	}
 	
 
+	FS_BuildIndex();
+
 	timer.Stop();
 
 	Com_ReadCDKey( basegame );
@@ -4671,6 +5364,7 @@ void FS_Startup( void )
 	Cmd_AddCommand( "fs_restart", FS_Restart );
 	Cmd_AddCommand( "lsof", FS_ListOpenFiles_f );
 	Cmd_AddCommand( "which", FS_Which_f );
+	Cmd_AddCommand( "fs_readbench", FS_ReadBench_f );
 	Cmd_SetCommandCompletionFunc( "which", FS_CompleteFileName );
 
 	Con_Printf(
@@ -0,0 +1,645 @@
+// n_log.cpp -- hands console output to a writer thread so printing never waits on the terminal or the logfile
+
+#include "n_shared.h"
+#include "n_common.h"
+#include "n_cvar.h"
+#include "n_threads.h"
+#include <SDL2/SDL.h>
+#include <atomic>
+
+//
+// every message is copied into a bounded ring of fixed size slots, a message longer than one slot claims
+// several in a row with a single compare and swap so messages from different threads never interleave.
+// A slot's sequence number says whose turn it is: i when it's free for the producer claiming position i,
+// i + 1 once that producer has filled it in. The writer thread is the only consumer, it copies the text
+// into a batch and writes the batch out with one Sys_Print and one FS_Write
+//
+
+#define LOG_SLOT_TEXT 224
+#define LOG_QUEUE_SLOTS 8192 // must be a power of two
+#define LOG_MAX_SLOTS ( ( MAXPRINTMSG + LOG_SLOT_TEXT - 1 ) / LOG_SLOT_TEXT )
+#define LOG_BATCH_SIZE ( 64 * 1024 )
+
+// Sys_Print truncates anything longer than MAXPRINTMSG
+#define LOG_CONSOLE_BATCH_SIZE ( MAXPRINTMSG / 2 )
+
+typedef struct {
+	std::atomic<uint64_t> sequence;
+	uint64_t time;				// performance counter when it was printed
+	uint32_t thread;
+	uint16_t level;
+	uint16_t numSlots;			// how many slots the message spans, only valid in the first one
+	uint32_t length;			// bytes of text in this slot
+	char text[ LOG_SLOT_TEXT ];
+} logSlot_t;
+
+typedef struct logQueue_s {
+	logSlot_t *slots;
+	std::atomic<uint64_t> writePos;		// next position a producer can claim
+	std::atomic<uint64_t> readPos;		// only ever written by the writer thread
+	std::atomic<uint64_t> dropped[ NUM_LOG_LEVELS ];
+	std::atomic<uint64_t> totalDropped;
+	std::atomic<bool> writerSleeping;
+	std::atomic<bool> quit;
+	SDL_sem *wake;
+	SDL_Thread *thread;
+	SDL_threadID threadId;
+
+	fileHandle_t *file;					// NULL or FS_INVALID_HANDLE to skip the file
+	qboolean toConsole;
+	qboolean blocking;					// producers wait for room instead of dropping anything
+
+	// called by the writer with every message, for com_logbench to check the order
+	void (*check)( struct logQueue_s *queue, uint32_t thread, const char *text, uint64_t length );
+	void *checkData;
+
+	uint64_t startTime;
+	qboolean atLineStart;
+
+	char message[ MAXPRINTMSG ];
+	char consoleBatch[ LOG_CONSOLE_BATCH_SIZE + 1 ];
+	uint64_t consoleLength;
+	char fileBatch[ LOG_BATCH_SIZE ];
+	uint64_t fileLength;
+} logQueue_t;
+
+static const char *logLevelNames[ NUM_LOG_LEVELS ] = {
+	"dev",
+	"info",
+	"warn",
+	"error"
+};
+
+static logQueue_t *com_logQueue;
+static cvar_t *com_logAsync;
+static cvar_t *com_logTimestamps;
+
+static std::atomic<uint32_t> com_logThreadCount;
+static thread_local uint32_t com_logThread;
+static thread_local qboolean com_isLogWriter;
+
+extern fileHandle_t logfile;
+
+static uint32_t Log_ThreadNumber( void )
+{
+	if ( !com_logThread ) {
+		com_logThread = ++com_logThreadCount;
+	}
+	return com_logThread;
+}
+
+static void Log_WakeWriter( logQueue_t *queue )
+{
+	if ( queue->writerSleeping.exchange( false ) ) {
+		SDL_SemPost( queue->wake );
+	}
+}
+
+/*
+* Log_Push: copies a message into the ring, returns qfalse if it had to be dropped
+*/
+static qboolean Log_Push( logQueue_t *queue, logLevel_t level, const char *text, uint64_t length )
+{
+	logSlot_t *slot;
+	uint64_t pos, numSlots, i, count;
+	int64_t diff;
+	uint64_t time;
+
+	if ( !length ) {
+		return qtrue;
+	}
+
+	length = MIN( length, (uint64_t)LOG_MAX_SLOTS * LOG_SLOT_TEXT );
+	numSlots = ( length + LOG_SLOT_TEXT - 1 ) / LOG_SLOT_TEXT;
+	time = SDL_GetPerformanceCounter();
+
+	pos = queue->writePos.load( std::memory_order_relaxed );
+	for ( ;; ) {
+		// the writer frees slots in order, so if the last one's free they all are
+		slot = &queue->slots[ ( pos + numSlots - 1 ) & ( LOG_QUEUE_SLOTS - 1 ) ];
+		diff = (int64_t)slot->sequence.load( std::memory_order_acquire ) - (int64_t)( pos + numSlots - 1 );
+		if ( diff == 0 ) {
+			if ( queue->writePos.compare_exchange_weak( pos, pos + numSlots, std::memory_order_relaxed ) ) {
+				break;
+			}
+		} else if ( diff < 0 ) {
+			// full, errors and warnings wait for the writer but nothing can wait on the writer from the writer
+			if ( ( queue->blocking || level >= LOG_WARNING ) && !com_isLogWriter && !queue->quit ) {
+				Log_WakeWriter( queue );
+				SDL_Delay( 1 );
+				pos = queue->writePos.load( std::memory_order_relaxed );
+				continue;
+			}
+			queue->dropped[ level ]++;
+			queue->totalDropped++;
+			return qfalse;
+		} else {
+			pos = queue->writePos.load( std::memory_order_relaxed );
+		}
+	}
+
+	for ( i = 0; i < numSlots; i++ ) {
+		slot = &queue->slots[ ( pos + i ) & ( LOG_QUEUE_SLOTS - 1 ) ];
+		count = MIN( length - i * LOG_SLOT_TEXT, (uint64_t)LOG_SLOT_TEXT );
+
+		slot->time = time;
+		slot->thread = Log_ThreadNumber();
+		slot->level = level;
+		slot->numSlots = numSlots;
+		slot->length = count;
+		memcpy( slot->text, text + i * LOG_SLOT_TEXT, count );
+
+		slot->sequence.store( pos + i + 1, std::memory_order_release );
+	}
+
+	Log_WakeWriter( queue );
+
+	return qtrue;
+}
+
+static void Log_FlushBatch( logQueue_t *queue )
+{
+	if ( queue->consoleLength ) {
+		queue->consoleBatch[ queue->consoleLength ] = '\0';
+		Sys_Print( queue->consoleBatch );
+		queue->consoleLength = 0;
+	}
+	if ( queue->fileLength ) {
+		if ( queue->file && *queue->file != FS_INVALID_HANDLE ) {
+			FS_Write( queue->fileBatch, queue->fileLength, *queue->file );
+		}
+		queue->fileLength = 0;
+	}
+}
+
+static void Log_AppendConsole( logQueue_t *queue, const char *text, uint64_t length )
+{
+	uint64_t count;
+
+	while ( length ) {
+		if ( queue->consoleLength == LOG_CONSOLE_BATCH_SIZE ) {
+			Log_FlushBatch( queue );
+		}
+		count = MIN( length, LOG_CONSOLE_BATCH_SIZE - queue->consoleLength );
+		memcpy( queue->consoleBatch + queue->consoleLength, text, count );
+		queue->consoleLength += count;
+		text += count;
+		length -= count;
+	}
+}
+
+/*
+* Log_AppendFile: the logfile gets the text without color codes, with when and where it was printed at the start
+* of every line
+*/
+static void Log_AppendFile( logQueue_t *queue, uint64_t time, uint32_t thread, logLevel_t level, const char *text,
+	uint64_t length )
+{
+	const char *end;
+	char prefix[64];
+	uint64_t prefixLength, usec, frequency;
+
+	if ( !queue->file || *queue->file == FS_INVALID_HANDLE ) {
+		return;
+	}
+
+	frequency = SDL_GetPerformanceFrequency();
+	time -= queue->startTime;
+	usec = ( time / frequency ) * 1000000 + ( ( time % frequency ) * 1000000 ) / frequency;
+	prefixLength = Com_snprintf( prefix, sizeof( prefix ), "[%lu.%06lu %2u %-5s] ", usec / 1000000, usec % 1000000, thread,
+		logLevelNames[ level ] );
+
+	for ( end = text + length; text < end; text++ ) {
+		// room for a prefix and the character
+		if ( queue->fileLength + sizeof( prefix ) + 1 > sizeof( queue->fileBatch ) ) {
+			Log_FlushBatch( queue );
+		}
+		while ( text < end - 1 && Q_IsColorString( text ) && text[1] != '\n' ) {
+			text += 2;
+		}
+		if ( text == end ) {
+			break;
+		}
+		if ( !( ( *text >= ' ' && *text <= '~' ) || *text == '\n' || *text == '\r' || *text == '\t' ) ) {
+			continue;
+		}
+		if ( queue->atLineStart && com_logTimestamps && com_logTimestamps->i ) {
+			memcpy( queue->fileBatch + queue->fileLength, prefix, prefixLength );
+			queue->fileLength += prefixLength;
+		}
+		queue->fileBatch[ queue->fileLength++ ] = *text;
+		queue->atLineStart = *text == '\n';
+	}
+}
+
+/*
+* Log_Drain: writes out everything that's been pushed so far, returns how many messages that was
+*/
+static uint64_t Log_Drain( logQueue_t *queue )
+{
+	logSlot_t *slot;
+	uint64_t pos, numSlots, length, i, count, dropped;
+	uint32_t thread;
+	logLevel_t level;
+	uint64_t time;
+
+	pos = queue->readPos.load( std::memory_order_relaxed );
+	count = 0;
+
+	for ( ;; ) {
+		slot = &queue->slots[ pos & ( LOG_QUEUE_SLOTS - 1 ) ];
+		if ( slot->sequence.load( std::memory_order_acquire ) != pos + 1 ) {
+			break;
+		}
+
+		numSlots = slot->numSlots;
+		time = slot->time;
+		thread = slot->thread;
+		level = (logLevel_t)slot->level;
+
+		// the producer claimed all of them at once, it might just not be done copying into the rest
+		length = 0;
+		for ( i = 0; i < numSlots; i++ ) {
+			slot = &queue->slots[ ( pos + i ) & ( LOG_QUEUE_SLOTS - 1 ) ];
+			while ( slot->sequence.load( std::memory_order_acquire ) != pos + i + 1 ) {
+				SDL_Delay( 0 );
+			}
+			memcpy( queue->message + length, slot->text, slot->length );
+			length += slot->length;
+			slot->sequence.store( pos + i + LOG_QUEUE_SLOTS, std::memory_order_release );
+		}
+		pos += numSlots;
+		queue->readPos.store( pos, std::memory_order_release );
+
+		if ( queue->check ) {
+			queue->check( queue, thread, queue->message, length );
+		}
+		if ( queue->toConsole ) {
+			Log_AppendConsole( queue, queue->message, length );
+		}
+		Log_AppendFile( queue, time, thread, level, queue->message, length );
+		count++;
+	}
+
+	if ( queue->totalDropped.load( std::memory_order_relaxed ) && queue->toConsole ) {
+		char msg[ 256 ];
+		uint64_t levels[ NUM_LOG_LEVELS ];
+
+		dropped = queue->totalDropped.exchange( 0 );
+		for ( i = 0; i < NUM_LOG_LEVELS; i++ ) {
+			levels[i] = queue->dropped[i].exchange( 0 );
+		}
+		length = Com_snprintf( msg, sizeof( msg ), COLOR_YELLOW "WARNING: the log fell behind, dropped %lu messages"
+			" (%lu dev, %lu info)\n", dropped, levels[ LOG_DEVELOPER ], levels[ LOG_INFO ] );
+		Log_AppendConsole( queue, msg, length );
+		Log_AppendFile( queue, SDL_GetPerformanceCounter(), 0, LOG_WARNING, msg, length );
+	}
+
+	Log_FlushBatch( queue );
+
+	return count;
+}
+
+static int Log_WriterThread( void *data )
+{
+	logQueue_t *queue;
+
+	queue = (logQueue_t *)data;
+	com_isLogWriter = qtrue;
+
+	for ( ;; ) {
+		Log_Drain( queue );
+
+		if ( queue->quit ) {
+			// anything pushed before quit was set is already in the ring
+			Log_Drain( queue );
+			break;
+		}
+
+		queue->writerSleeping = true;
+		// check again so a push between the drain and the flag doesn't sit there until the timeout
+		if ( queue->readPos.load() != queue->writePos.load() ) {
+			queue->writerSleeping = false;
+			continue;
+		}
+		SDL_SemWaitTimeout( queue->wake, 100 );
+		queue->writerSleeping = false;
+	}
+
+	return 0;
+}
+
+static logQueue_t *Log_CreateQueue( const char *name, fileHandle_t *file, qboolean toConsole, qboolean blocking )
+{
+	logQueue_t *queue;
+	uint64_t i;
+
+	// the zone isn't thread safe and the writer lives for as long as the engine does
+	queue = (logQueue_t *)calloc( 1, sizeof( *queue ) );
+	if ( !queue ) {
+		return NULL;
+	}
+	queue->slots = (logSlot_t *)calloc( LOG_QUEUE_SLOTS, sizeof( *queue->slots ) );
+	if ( !queue->slots ) {
+		free( queue );
+		return NULL;
+	}
+	for ( i = 0; i < LOG_QUEUE_SLOTS; i++ ) {
+		queue->slots[i].sequence.store( i, std::memory_order_relaxed );
+	}
+
+	queue->file = file;
+	queue->toConsole = toConsole;
+	queue->blocking = blocking;
+	queue->startTime = SDL_GetPerformanceCounter();
+	queue->atLineStart = qtrue;
+
+	queue->wake = SDL_CreateSemaphore( 0 );
+	queue->thread = SDL_CreateThread( Log_WriterThread, name, queue );
+	if ( !queue->wake || !queue->thread ) {
+		if ( queue->wake ) {
+			SDL_DestroySemaphore( queue->wake );
+		}
+		free( queue->slots );
+		free( queue );
+		return NULL;
+	}
+	queue->threadId = SDL_GetThreadID( queue->thread );
+
+	return queue;
+}
+
+static void Log_DestroyQueue( logQueue_t *queue )
+{
+	queue->quit = true;
+	SDL_SemPost( queue->wake );
+	SDL_WaitThread( queue->thread, NULL );
+
+	SDL_DestroySemaphore( queue->wake );
+	free( queue->slots );
+	free( queue );
+}
+
+/*
+* Com_LogPrint: returns qfalse if the writer isn't running and the caller has to print it itself
+*/
+qboolean Com_LogPrint( logLevel_t level, const char *msg, uint64_t length )
+{
+	logQueue_t *queue;
+
+	queue = com_logQueue;
+	if ( !queue ) {
+		return qfalse;
+	}
+	Log_Push( queue, level, msg, length );
+	return qtrue;
+}
+
+/*
+* Com_FlushLog: waits until everything printed before the call has been written, called before
+* anything that might not come back
+*/
+void Com_FlushLog( void )
+{
+	logQueue_t *queue;
+	uint64_t target, start;
+
+	queue = com_logQueue;
+	if ( !queue || com_isLogWriter ) {
+		return;
+	}
+
+	target = queue->writePos.load();
+	start = Sys_Milliseconds();
+
+	// don't hang forever if we're crashing because the writer did
+	while ( (int64_t)( queue->readPos.load() - target ) < 0 && Sys_Milliseconds() - start < 1000 ) {
+		SDL_SemPost( queue->wake );
+		SDL_Delay( 1 );
+	}
+	if ( queue->file && *queue->file != FS_INVALID_HANDLE ) {
+		FS_Flush( *queue->file );
+	}
+}
+
+void Com_InitLog( void )
+{
+	com_logAsync = Cvar_Get( "com_logAsync", "1", CVAR_SAVE | CVAR_LATCH );
+	Cvar_SetDescription( com_logAsync, "Write console output to the terminal and the logfile on a separate thread." );
+	com_logTimestamps = Cvar_Get( "com_logTimestamps", "1", CVAR_SAVE );
+	Cvar_SetDescription( com_logTimestamps, "Start every line in the logfile with the time, thread and severity it was printed with,\n"
+		"only when \\com_logAsync is on." );
+
+	if ( !com_logAsync->i || com_logQueue ) {
+		return;
+	}
+
+	com_logQueue = Log_CreateQueue( "LogWriter", &logfile, qtrue, qfalse );
+	if ( !com_logQueue ) {
+		Con_Printf( COLOR_YELLOW "WARNING: couldn't start the log writer thread, logging synchronously\n" );
+	}
+}
+
+void Com_ShutdownLog( void )
+{
+	logQueue_t *queue;
+
+	queue = com_logQueue;
+	if ( !queue ) {
+		return;
+	}
+
+	// anything printed from here on is written out directly
+	com_logQueue = NULL;
+	Log_DestroyQueue( queue );
+}
+
+//
+// com_logbench
+//
+
+typedef struct {
+	logQueue_t *queue;
+	uint32_t producer;
+	uint32_t numLines;
+	uint64_t usec;
+} logBenchProducer_t;
+
+typedef struct {
+	uint32_t next[ 64 ];			// the line each producer should print next
+	uint64_t received;
+	uint64_t outOfOrder;
+} logBenchCheck_t;
+
+static CThreadMutex com_logBenchLock;
+static fileHandle_t com_logBenchFile;
+
+static uint64_t Log_BenchMicroseconds( void )
+{
+	const uint64_t counter = SDL_GetPerformanceCounter();
+	const uint64_t frequency = SDL_GetPerformanceFrequency();
+
+	return ( counter / frequency ) * 1000000 + ( ( counter % frequency ) * 1000000 ) / frequency;
+}
+
+static void Log_BenchCheck( logQueue_t *queue, uint32_t thread, const char *text, uint64_t length )
+{
+	logBenchCheck_t *check;
+	uint32_t producer, line;
+
+	check = (logBenchCheck_t *)queue->checkData;
+	if ( sscanf( text, "logbench %u %u", &producer, &line ) != 2 || producer >= arraylen( check->next ) ) {
+		return;
+	}
+
+	if ( check->next[ producer ] != line ) {
+		check->outOfOrder++;
+	}
+	check->next[ producer ] = line + 1;
+	check->received++;
+}
+
+static int Log_BenchAsyncThread( void *data )
+{
+	logBenchProducer_t *producer;
+	char msg[ 128 ];
+	uint64_t length;
+	uint32_t i;
+
+	producer = (logBenchProducer_t *)data;
+
+	producer->usec = Log_BenchMicroseconds();
+	for ( i = 0; i < producer->numLines; i++ ) {
+		length = Com_snprintf( msg, sizeof( msg ), "logbench %u %u: the quick brown fox jumps over the lazy dog\n",
+			producer->producer, i );
+		Log_Push( producer->queue, LOG_INFO, msg, length );
+	}
+	producer->usec = Log_BenchMicroseconds() - producer->usec;
+
+	return 0;
+}
+
+// what every Con_Printf used to do, format and write it on the thread that printed it
+static int Log_BenchSyncThread( void *data )
+{
+	logBenchProducer_t *producer;
+	char msg[ 128 ];
+	uint64_t length;
+	uint32_t i;
+
+	producer = (logBenchProducer_t *)data;
+
+	producer->usec = Log_BenchMicroseconds();
+	for ( i = 0; i < producer->numLines; i++ ) {
+		length = Com_snprintf( msg, sizeof( msg ), "logbench %u %u: the quick brown fox jumps over the lazy dog\n",
+			producer->producer, i );
+		CThreadAutoLock<CThreadMutex> lock( com_logBenchLock );
+		FS_Write( msg, length, com_logBenchFile );
+	}
+	producer->usec = Log_BenchMicroseconds() - producer->usec;
+
+	return 0;
+}
+
+static uint64_t Log_BenchRun( SDL_ThreadFunction func, logQueue_t *queue, uint32_t numThreads, uint32_t numLines,
+	uint64_t *maxProducerUsec )
+{
+	logBenchProducer_t producers[ 64 ];
+	SDL_Thread *threads[ 64 ];
+	uint64_t start;
+	uint32_t i;
+
+	start = Log_BenchMicroseconds();
+	for ( i = 0; i < numThreads; i++ ) {
+		producers[i].queue = queue;
+		producers[i].producer = i;
+		producers[i].numLines = numLines / numThreads;
+		threads[i] = SDL_CreateThread( func, "LogBench", &producers[i] );
+		if ( !threads[i] ) {
+			N_Error( ERR_DROP, "Com_LogBench_f: SDL_CreateThread failed -- %s", SDL_GetError() );
+		}
+	}
+
+	*maxProducerUsec = 0;
+	for ( i = 0; i < numThreads; i++ ) {
+		SDL_WaitThread( threads[i], NULL );
+		*maxProducerUsec = MAX( *maxProducerUsec, producers[i].usec );
+	}
+
+	// a clean shutdown has to write out everything that's still queued
+	if ( queue ) {
+		Log_DestroyQueue( queue );
+	}
+
+	return Log_BenchMicroseconds() - start;
+}
+
+/*
+* Com_LogBench_f: com_logbench [lines] [threads], prints the lines from several threads at once into a scratch
+* file, first the way Con_Printf used to and then through a private log writer. The writer's queue is shut down
+* as soon as the producers are done and every line has to come out exactly once and in order
+*/
+void Com_LogBench_f( void )
+{
+	logBenchCheck_t check;
+	logQueue_t *queue;
+	uint32_t numLines, numThreads, i;
+	uint64_t syncUsec, syncProducerUsec, asyncUsec, asyncProducerUsec, expected;
+	const char *fileName = "logbench.log";
+
+	numLines = 1000000;
+	numThreads = 4;
+	if ( Cmd_Argc() > 1 ) {
+		numLines = MAX( 1, atoi( Cmd_Argv( 1 ) ) );
+	}
+	if ( Cmd_Argc() > 2 ) {
+		numThreads = CLAMP( atoi( Cmd_Argv( 2 ) ), 1, (int)arraylen( check.next ) );
+	}
+	expected = ( numLines / numThreads ) * numThreads;
+
+	com_logBenchFile = FS_FOpenWrite( fileName );
+	if ( com_logBenchFile == FS_INVALID_HANDLE ) {
+		Con_Printf( "com_logbench: couldn't open %s\n", fileName );
+		return;
+	}
+	syncUsec = Log_BenchRun( Log_BenchSyncThread, NULL, numThreads, numLines, &syncProducerUsec );
+	FS_FClose( com_logBenchFile );
+
+	com_logBenchFile = FS_FOpenWrite( fileName );
+	if ( com_logBenchFile == FS_INVALID_HANDLE ) {
+		Con_Printf( "com_logbench: couldn't open %s\n", fileName );
+		return;
+	}
+	memset( &check, 0, sizeof( check ) );
+	queue = Log_CreateQueue( "LogBenchWriter", &com_logBenchFile, qfalse, qtrue );
+	if ( !queue ) {
+		FS_FClose( com_logBenchFile );
+		Con_Printf( "com_logbench: couldn't start the writer thread\n" );
+		return;
+	}
+	queue->check = Log_BenchCheck;
+	queue->checkData = &check;
+	asyncUsec = Log_BenchRun( Log_BenchAsyncThread, queue, numThreads, numLines, &asyncProducerUsec );
+	FS_FClose( com_logBenchFile );
+
+	FS_HomeRemove( fileName );
+
+	Con_Printf( "com_logbench: %lu lines from %u threads\n", expected, numThreads );
+	Con_Printf( "%-6s %14s %14s %14s\n", "", "total usec", "producer usec", "lines/sec" );
+	Con_Printf( "%-6s %14lu %14lu %14.0f\n", "sync", syncUsec, syncProducerUsec,
+		(double)expected / ( (double)MAX( syncProducerUsec, 1 ) * 1e-6 ) );
+	Con_Printf( "%-6s %14lu %14lu %14.0f\n", "async", asyncUsec, asyncProducerUsec,
+		(double)expected / ( (double)MAX( asyncProducerUsec, 1 ) * 1e-6 ) );
+
+	for ( i = 0; i < numThreads; i++ ) {
+		if ( check.next[i] != numLines / numThreads ) {
+			break;
+		}
+	}
+	if ( check.received != expected || check.outOfOrder || i != numThreads ) {
+		Con_Printf( COLOR_RED "com_logbench: FAILED, %lu of %lu lines written, %lu out of order\n", check.received,
+			expected, check.outOfOrder );
+	} else {
+		Con_Printf( "com_logbench: passed, every line was written once and in order\n" );
+	}
+}
@@ -113,6 +113,8 @@ typedef struct freeblock_s {
 typedef struct memzone_s {
 	uint64_t	size;			// total bytes malloced, including header
 	uint64_t	used;			// total bytes used
+	uint64_t	numAllocs;		// allocations made since startup
+	uint64_t	numFrees;		// frees made since startup
 	memblock_t	blocklist;	// start / end cap for linked list
 #ifdef USE_MULTI_SEGMENT
 	memblock_t	dummy0;		// just to allocate some space before freelist
@@ -406,6 +408,8 @@ static void Z_ClearZone( memzone_t *zone, memzone_t *head, uint64_t size, uint64
 #endif
 	zone->size = size;
 	zone->used = 0;
+	zone->numAllocs = 0;
+	zone->numFrees = 0;
 
 	block->prev = block->next = &zone->blocklist;
 	block->tag = TAG_FREE;	// free block
@@ -506,6 +510,19 @@ uint64_t Z_AvailableMemory( void ) {
 }
 
 
+/*
+========================
+Z_GetAllocCounts
+
+Running totals over both zones, take the difference between two calls to count a stretch of frames
+========================
+*/
+void Z_GetAllocCounts( uint64_t *numAllocs, uint64_t *numFrees ) {
+	*numAllocs = mainzone->numAllocs + smallzone->numAllocs;
+	*numFrees = mainzone->numFrees + smallzone->numFrees;
+}
+
+
 static void MergeBlock( memblock_t *curr_free, const memblock_t *next )
 {
 	curr_free->size += next->size;
@@ -550,6 +567,7 @@ void Z_Free( void *ptr ) {
 	}
 
 	zone->used -= block->size;
+	zone->numFrees++;
 
 	// set the block to something that should cause problems
 	// if it is referenced...
@@ -737,6 +755,7 @@ void *Z_Alloc( uint64_t size, memtag_t tag )
 	zone->rover = base->next;	// next allocation will start looking here
 #endif
 	zone->used += base->size;
+	zone->numAllocs++;
 
 	base->tag = tag;			// no longer a free block
 	base->id = ZONEID;
@@ -1031,6 +1031,7 @@ typedef struct {
 #if defined(_NOMAD_DEBUG) && defined(__cplusplus) && !defined(_WIN32)
 	#define USING_EASY_PROFILER
 	#include <easy/profiler.h>
+	#include <easy/arbitrary_value.h>
 
 	#define PROFILE_BEGIN_LISTEN \
 		EASY_PROFILER_ENABLE; \
@@ -1041,6 +1042,7 @@ typedef struct {
 	#define PROFILE_SCOPE( name ) EASY_BLOCK( name, profiler::colors::Green )
 	#define PROFILE_BLOCK_BEGIN( name ) PROFILE_SCOPE( name )
 	#define PROFILE_BLOCK_END EASY_END_BLOCK
+	#define PROFILE_VALUE( name, value ) EASY_VALUE( name, value )
 	#ifdef GDR_DLLCOMPILE
 		#define PROFILE_FUNCTION() EASY_FUNCTION( profiler::colors::Blue )
 	#else
@@ -1052,6 +1054,7 @@ typedef struct {
 	#define PROFILE_SCOPE( name )
 	#define PROFILE_BLOCK_BEGIN( name )
 	#define PROFILE_BLOCK_END
+	#define PROFILE_VALUE( name, value )
 	#define PROFILE_FUNCTION()
 #endif
 
@@ -4,6 +4,8 @@
 #include "g_archive.h"
 #include "../engine/n_steam.h"
 #include "../ui/ui_lib.h"
+#include <lz4.h>
+#include <atomic>
 
 #define NGD_MAGIC 0xff5ad1120
 #define XOR_MAGIC 0xff
@@ -15,10 +17,11 @@
 #define SIZEOF_MOD_METADATA ( MAX_NPATH + ( sizeof( int32_t ) * 2 ) + sizeof( uint64_t ) )
 
 #define IDENT (('d'<<24)+('g'<<16)+('n'<<8)+'!')
+#define IDENT_INDEXED (('2'<<24)+('d'<<16)+('g'<<8)+'n')
 
 /*
 
-.ngd save file layout:
+.ngd save file layout (v1, loaded but never written anymore):
 
 section		|  name         	|  value				| type
 -----------------------------------------------------------------
@@ -34,6 +37,23 @@ GAMEDATA	| playTimeHours		| Hours					| uint32
 GAMEDATA	| playTimeMinutes	| Minutes				| uint32
 GAMEDATA	| numMods			| N/A					| uint64
 
+followed by the sections, each one is { nameLength, name, numFields } and then the fields,
+{ nameLength, name, type, [dataSize for strings and arrays], data }
+
+.ngd save file layout (v2):
+
+ngdindexheader_t, uncompressed so the slot list can read it without touching the rest,
+followed by compressedSize bytes of the index, compressed with header.compression:
+
+ngdsection_t	sections[ numSections ]
+uint32_t		buckets[ numBuckets ]		open addressed hash table for each section, field number + 1
+ngdfield_t		fields[ numFields ]
+char			strings[ stringsSize ]		section and field names
+byte			data[ dataSize ]
+
+a load is a single read and a decompress, after that every field lookup is a hash probe
+into memory instead of a string compare over the whole section and a seek
+
 */
 
 CGameArchive *g_pArchiveHandler;
@@ -60,21 +80,510 @@ enum {
 	FT_ARRAY
 };
 
+/*
+===============================================================
+
+INDEX BUILDER
+
+the save calls append into these instead of writing to the file, they're kept around
+between saves so an autosave doesn't have to grow them again
+
+===============================================================
+*/
+
+typedef struct {
+	byte *pData;
+	uint64_t nUsed;
+	uint64_t nSize;
+} ngdbuffer_t;
+
+typedef struct {
+	ngdbuffer_t sections;
+	ngdbuffer_t fields;
+	ngdbuffer_t strings;
+	ngdbuffer_t data;
+
+	uint32_t nNumSections;
+	uint32_t nNumFields;
+} ngdbuilder_t;
+
+static ngdbuilder_t g_indexBuilder;
+
+// not Com_GenerateHashValue, that one stops at the first '.' and every "player.*" field would end up in the same bucket
+static uint32_t G_HashFieldName( const char *name )
+{
+	uint32_t hash;
+
+	hash = 2166136261u;
+	while ( *name ) {
+		hash ^= (uint32_t)tolower( (unsigned char)*name++ );
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+static uint32_t G_FieldTypeSize( int32_t type )
+{
+	switch ( type ) {
+	case FT_CHAR:
+	case FT_UCHAR:
+		return sizeof( uint8_t );
+	case FT_SHORT:
+	case FT_USHORT:
+		return sizeof( uint16_t );
+	case FT_INT:
+	case FT_UINT:
+		return sizeof( uint32_t );
+	case FT_LONG:
+	case FT_ULONG:
+		return sizeof( uint64_t );
+	case FT_FLOAT:
+		return sizeof( float );
+	case FT_VECTOR2:
+		return sizeof( vec2_t );
+	case FT_VECTOR3:
+		return sizeof( vec3_t );
+	case FT_VECTOR4:
+		return sizeof( vec4_t );
+	default:
+		break;
+	};
+	// strings and arrays carry their own size
+	return 0;
+}
+
+static uint32_t G_AppendBuffer( ngdbuffer_t *buffer, const void *data, uint64_t size )
+{
+	uint64_t offset;
+
+	if ( buffer->nUsed + size > UINT32_MAX ) {
+		N_Error( ERR_DROP, "CGameArchive::AddField: save file is larger than 4 GiB" );
+	}
+	if ( buffer->nUsed + size > buffer->nSize ) {
+		buffer->nSize = PAD( MAX( buffer->nUsed + size, buffer->nSize * 2 ), 4096 );
+		buffer->pData = (byte *)Z_Realloc( buffer->pData, buffer->nSize, TAG_SAVEFILE );
+	}
+
+	offset = buffer->nUsed;
+	if ( size ) {
+		memcpy( buffer->pData + offset, data, size );
+	}
+	buffer->nUsed += size;
+
+	return (uint32_t)offset;
+}
+
+static void G_ResetIndexBuilder( ngdbuilder_t *builder )
+{
+	builder->sections.nUsed = 0;
+	builder->fields.nUsed = 0;
+	builder->strings.nUsed = 0;
+	builder->data.nUsed = 0;
+	builder->nNumSections = 0;
+	builder->nNumFields = 0;
+}
+
+static void G_BeginIndexSection( ngdbuilder_t *builder, const char *name )
+{
+	ngdsection_t section;
+
+	memset( &section, 0, sizeof( section ) );
+	section.nameOffset = G_AppendBuffer( &builder->strings, name, strlen( name ) + 1 );
+	section.firstField = builder->nNumFields;
+
+	G_AppendBuffer( &builder->sections, &section, sizeof( section ) );
+	builder->nNumSections++;
+}
+
+static void G_AddIndexField( ngdbuilder_t *builder, const char *name, int32_t type, const void *data, uint32_t dataSize )
+{
+	ngdfield_t field;
+	ngdsection_t *section;
+
+	field.hash = G_HashFieldName( name );
+	field.nameOffset = G_AppendBuffer( &builder->strings, name, strlen( name ) + 1 );
+	field.type = type;
+	field.dataSize = dataSize;
+	field.dataOffset = G_AppendBuffer( &builder->data, data, dataSize );
+
+	G_AppendBuffer( &builder->fields, &field, sizeof( field ) );
+	builder->nNumFields++;
+
+	section = (ngdsection_t *)builder->sections.pData + builder->nNumSections - 1;
+	section->numFields++;
+}
+
+/*
+* G_BuildIndex: lays the sections, hash tables, fields and names out the way they're stored in
+* the file, returns a TAG_SAVEFILE block and fills in the counts in the header
+*/
+static byte *G_BuildIndex( const ngdbuilder_t *builder, ngdindexheader_t *header, uint64_t *size )
+{
+	const ngdfield_t *fields;
+	ngdsection_t *sections;
+	uint32_t *buckets;
+	uint32_t numBuckets, mask, slot;
+	uint32_t i, j;
+	byte *index, *pos;
+
+	numBuckets = 0;
+	for ( i = 0; i < builder->nNumSections; i++ ) {
+		const ngdsection_t *section = (const ngdsection_t *)builder->sections.pData + i;
+		for ( j = 1; section->numFields && j < section->numFields * 2; j <<= 1 )
+			;
+		numBuckets += section->numFields ? j : 0;
+	}
+
+	header->numSections = builder->nNumSections;
+	header->numBuckets = numBuckets;
+	header->numFields = builder->nNumFields;
+	header->stringsSize = builder->strings.nUsed;
+	header->dataSize = builder->data.nUsed;
+
+	*size = ( header->numSections * sizeof( ngdsection_t ) ) + ( header->numBuckets * sizeof( uint32_t ) )
+		+ ( header->numFields * sizeof( ngdfield_t ) ) + header->stringsSize + header->dataSize;
+
+	index = (byte *)Z_Malloc( MAX( *size, 1 ), TAG_SAVEFILE );
+	pos = index;
+
+	sections = (ngdsection_t *)pos;
+	memcpy( sections, builder->sections.pData, header->numSections * sizeof( ngdsection_t ) );
+	pos += header->numSections * sizeof( ngdsection_t );
+
+	buckets = (uint32_t *)pos;
+	memset( buckets, 0, header->numBuckets * sizeof( uint32_t ) );
+	pos += header->numBuckets * sizeof( uint32_t );
+
+	fields = (const ngdfield_t *)builder->fields.pData;
+	numBuckets = 0;
+	for ( i = 0; i < header->numSections; i++ ) {
+		for ( j = 1; sections[i].numFields && j < sections[i].numFields * 2; j <<= 1 )
+			;
+		sections[i].firstBucket = numBuckets;
+		sections[i].numBuckets = sections[i].numFields ? j : 0;
+		numBuckets += sections[i].numBuckets;
+
+		// inserted in order, so a duplicate name still finds the first field like the linear search did
+		mask = sections[i].numBuckets - 1;
+		for ( j = 0; j < sections[i].numFields; j++ ) {
+			slot = fields[ sections[i].firstField + j ].hash & mask;
+			while ( buckets[ sections[i].firstBucket + slot ] ) {
+				slot = ( slot + 1 ) & mask;
+			}
+			buckets[ sections[i].firstBucket + slot ] = j + 1;
+		}
+	}
+
+	memcpy( pos, builder->fields.pData, header->numFields * sizeof( ngdfield_t ) );
+	pos += header->numFields * sizeof( ngdfield_t );
+	memcpy( pos, builder->strings.pData, header->stringsSize );
+	pos += header->stringsSize;
+	memcpy( pos, builder->data.pData, header->dataSize );
+
+	return index;
+}
+
+/*
+* G_ParseIndex: points the index at the tables in the buffer, checking every offset so a
+* damaged file gets refused here instead of crashing in the middle of a module's load
+*/
+static qboolean G_ParseIndex( ngdindex_t *index, byte *buffer, uint64_t size, const ngdindexheader_t *header, const char *name )
+{
+	const ngdsection_t *section;
+	const ngdfield_t *field;
+	uint64_t expected;
+	uint32_t i, j, fieldSize;
+	const byte *pos;
+
+	expected = ( (uint64_t)header->numSections * sizeof( ngdsection_t ) ) + ( (uint64_t)header->numBuckets * sizeof( uint32_t ) )
+		+ ( (uint64_t)header->numFields * sizeof( ngdfield_t ) ) + header->stringsSize + header->dataSize;
+	if ( expected != size ) {
+		Con_Printf( COLOR_RED "ERROR: save file '%s' index is %lu bytes, should be %lu\n", name, size, expected );
+		return qfalse;
+	}
+
+	pos = buffer;
+	index->m_pBuffer = buffer;
+	index->m_pSections = (const ngdsection_t *)pos;
+	pos += header->numSections * sizeof( ngdsection_t );
+	index->m_pBuckets = (const uint32_t *)pos;
+	pos += header->numBuckets * sizeof( uint32_t );
+	index->m_pFields = (const ngdfield_t *)pos;
+	pos += header->numFields * sizeof( ngdfield_t );
+	index->m_pStrings = (const char *)pos;
+	pos += header->stringsSize;
+	index->m_pData = pos;
+
+	index->m_nSections = header->numSections;
+	index->m_nBuckets = header->numBuckets;
+	index->m_nFields = header->numFields;
+	index->m_nStringsSize = header->stringsSize;
+	index->m_nDataSize = header->dataSize;
+
+	if ( index->m_nStringsSize && index->m_pStrings[ index->m_nStringsSize - 1 ] != '\0' ) {
+		Con_Printf( COLOR_RED "ERROR: save file '%s' has an unterminated string pool\n", name );
+		return qfalse;
+	}
+
+	for ( i = 0; i < index->m_nSections; i++ ) {
+		section = &index->m_pSections[i];
+		if ( section->nameOffset >= index->m_nStringsSize
+			|| (uint64_t)section->firstField + section->numFields > index->m_nFields
+			|| (uint64_t)section->firstBucket + section->numBuckets > index->m_nBuckets
+			|| ( section->numBuckets & ( section->numBuckets - 1 ) )
+			|| section->numBuckets < section->numFields )
+		{
+			Con_Printf( COLOR_RED "ERROR: save file '%s' section %u is corrupt\n", name, i );
+			return qfalse;
+		}
+		for ( j = 0; j < section->numBuckets; j++ ) {
+			if ( index->m_pBuckets[ section->firstBucket + j ] > section->numFields ) {
+				Con_Printf( COLOR_RED "ERROR: save file '%s' section %u has a bad hash table\n", name, i );
+				return qfalse;
+			}
+		}
+	}
+
+	for ( i = 0; i < index->m_nFields; i++ ) {
+		field = &index->m_pFields[i];
+		fieldSize = G_FieldTypeSize( field->type );
+		if ( field->nameOffset >= index->m_nStringsSize
+			|| (uint64_t)field->dataOffset + field->dataSize > index->m_nDataSize
+			|| field->type < FT_CHAR || field->type > FT_ARRAY
+			|| ( fieldSize && field->dataSize != fieldSize ) || ( field->type == FT_STRING && !field->dataSize ) )
+		{
+			Con_Printf( COLOR_RED "ERROR: save file '%s' field %u is corrupt\n", name, i );
+			return qfalse;
+		}
+	}
+
+	return qtrue;
+}
+
+static void G_FreeIndex( ngdindex_t *index )
+{
+	if ( index->m_pBuffer ) {
+		Z_Free( index->m_pBuffer );
+	}
+	memset( index, 0, sizeof( *index ) );
+}
+
+/*
+===============================================================
+
+SAVE WRITER
+
+the index is built on the main thread, compressing it and getting it on the disk is done
+by a worker so an autosave doesn't hitch, the file is written next to the old one and
+renamed over it so a crash in the middle never leaves a broken save behind
+
+===============================================================
+*/
+
+typedef struct {
+	ngdindexheader_t header;
+
+	byte *pIndex;			// only ever touched by the worker while it's running
+	uint64_t nIndexSize;
+	byte *pFile;
+	uint64_t nFileSize;
+
+	char path[ MAX_NPATH ];
+	char ospath[ MAX_OSPATH ];
+	char tmppath[ MAX_OSPATH ];
+
+	SDL_Thread *thread;
+	qboolean active;
+	std::atomic<bool> failed;
+	std::atomic<uint64_t> writeTime;
+} saveWriter_t;
+
+static saveWriter_t g_saveWriter;
+
+static qboolean G_WriteSaveFile( const char *ospath, const char *tmppath, const byte *data, uint64_t length )
+{
+	FILE *fp;
+	qboolean ok;
+
+	fp = Sys_FOpen( tmppath, "wb" );
+	if ( !fp ) {
+		return qfalse;
+	}
+
+	ok = fwrite( data, 1, length, fp ) == length;
+	if ( ok ) {
+		ok = Sys_FSync( fp );
+	}
+	if ( fclose( fp ) != 0 ) {
+		ok = qfalse;
+	}
+
+	if ( !ok ) {
+		remove( tmppath );
+		return qfalse;
+	}
+	return Sys_ReplaceFile( tmppath, ospath );
+}
+
+/*
+* G_PackSaveFile: compresses the index behind the header, stores it as is if lz4 can't
+* make it any smaller
+*/
+static void G_PackSaveFile( saveWriter_t *writer )
+{
+	int compressedSize;
+
+	compressedSize = 0;
+	if ( writer->nIndexSize < LZ4_MAX_INPUT_SIZE ) {
+		compressedSize = LZ4_compress_default( (const char *)writer->pIndex, (char *)( writer->pFile + sizeof( writer->header ) ),
+			(int)writer->nIndexSize, LZ4_compressBound( (int)writer->nIndexSize ) );
+	}
+
+	if ( compressedSize > 0 && (uint64_t)compressedSize < writer->nIndexSize ) {
+		writer->header.compression = COMPRESS_LZ4;
+		writer->header.compressedSize = compressedSize;
+	} else {
+		writer->header.compression = COMPRESS_NONE;
+		writer->header.compressedSize = writer->nIndexSize;
+		memcpy( writer->pFile + sizeof( writer->header ), writer->pIndex, writer->nIndexSize );
+	}
+
+	memcpy( writer->pFile, &writer->header, sizeof( writer->header ) );
+	writer->nFileSize = sizeof( writer->header ) + writer->header.compressedSize;
+}
+
+static int G_SaveWriterThread( void *data )
+{
+	saveWriter_t *writer = (saveWriter_t *)data;
+	const uint64_t start = Sys_Microseconds();
+
+	writer->header.checksum = crc32_buffer( writer->pIndex, writer->nIndexSize );
+	G_PackSaveFile( writer );
+	writer->failed.store( !G_WriteSaveFile( writer->ospath, writer->tmppath, writer->pFile, writer->nFileSize ),
+		std::memory_order_relaxed );
+	writer->writeTime.store( Sys_Microseconds() - start, std::memory_order_relaxed );
+
+	return 0;
+}
+
+/*
+* G_WaitSaveWriter: joins the worker if there is one, the cloud gets the save once it's on the disk,
+* returns false if the last write failed
+*/
+static qboolean G_WaitSaveWriter( void )
+{
+	qboolean ok;
+
+	if ( !g_saveWriter.active ) {
+		return qtrue;
+	}
+
+	if ( g_saveWriter.thread ) {
+		SDL_WaitThread( g_saveWriter.thread, NULL );
+		g_saveWriter.thread = NULL;
+	}
+	g_saveWriter.active = qfalse;
+
+	Z_Free( g_saveWriter.pIndex );
+	Z_Free( g_saveWriter.pFile );
+	g_saveWriter.pIndex = NULL;
+	g_saveWriter.pFile = NULL;
+
+	ok = !g_saveWriter.failed.load( std::memory_order_relaxed );
+	if ( !ok ) {
+		Con_Printf( COLOR_RED "ERROR: couldn't write save file '%s'!\n", g_saveWriter.ospath );
+		return qfalse;
+	}
+
+	Con_DPrintf( "Wrote save file '%s' (%lu bytes compressed to %lu) in %lu usec\n", g_saveWriter.path,
+		g_saveWriter.nIndexSize, g_saveWriter.nFileSize, g_saveWriter.writeTime.load( std::memory_order_relaxed ) );
+
+	//
+	// save to steam
+	//
+#ifdef NOMAD_STEAMAPP
+	g_pSteamManager->Save( g_saveWriter.path );
+#endif
+
+	return qtrue;
+}
+
+/*
+* G_StartSaveWriter: hands the index over to the worker, the writer owns it from here on
+*/
+static void G_StartSaveWriter( const char *path, const ngdindexheader_t *header, byte *index, uint64_t indexSize )
+{
+	G_WaitSaveWriter();
+
+	g_saveWriter.header = *header;
+	g_saveWriter.pIndex = index;
+	g_saveWriter.nIndexSize = indexSize;
+	g_saveWriter.pFile = (byte *)Z_Malloc( sizeof( *header ) + ( indexSize < LZ4_MAX_INPUT_SIZE ? LZ4_compressBound( (int)indexSize )
+		: indexSize ), TAG_SAVEFILE );
+
+	N_strncpyz( g_saveWriter.path, path, sizeof( g_saveWriter.path ) );
+	N_strncpyz( g_saveWriter.ospath, FS_BuildOSPath( FS_GetHomePath(), FS_GetCurrentGameDir(), path ), sizeof( g_saveWriter.ospath ) );
+	Com_snprintf( g_saveWriter.tmppath, sizeof( g_saveWriter.tmppath ), "%s.tmp", g_saveWriter.ospath );
+	FS_CreatePath( g_saveWriter.ospath );
+
+	g_saveWriter.active = qtrue;
+	g_saveWriter.failed.store( false, std::memory_order_relaxed );
+	g_saveWriter.thread = SDL_CreateThread( G_SaveWriterThread, "SaveWriter", &g_saveWriter );
+	if ( !g_saveWriter.thread ) {
+		Con_DPrintf( "CGameArchive::Save: couldn't create the writer thread, %s\n", SDL_GetError() );
+		G_SaveWriterThread( &g_saveWriter );
+	}
+}
+
+/*
+===============================================================
+
+LOADING
+
+===============================================================
+*/
+
+typedef struct {
+	const byte *pData;
+	uint64_t nSize;
+	uint64_t nOffset;
+} ngdreader_t;
+
+static qboolean G_ReadSaveData( ngdreader_t *reader, void *out, uint64_t size )
+{
+	if ( size > reader->nSize - reader->nOffset ) {
+		return qfalse;
+	}
+	memcpy( out, reader->pData + reader->nOffset, size );
+	reader->nOffset += size;
+	return qtrue;
+}
+
+static const char *G_SlotPath( uint64_t nSlot, qboolean legacy )
+{
+	// the old save code wrote the slots somewhere the loader never looked, so anything
+	// left over from it is only ever found where it had to be copied by hand
+	if ( legacy ) {
+		return va( "gamedata/SaveData/SLOT_%lu.ngd", nSlot );
+	}
+	return va( "SaveData/SLOT_%lu.ngd", nSlot );
+}
+
 bool CGameArchive::ValidateHeader( const void *data ) const
 {
-	const ngdheader_t *h;
+	const ngdvalidation_t *h;
 
-	h = (const ngdheader_t *)data;
+	h = (const ngdvalidation_t *)data;
 
-	if ( h->validation.ident != IDENT ) {
+	if ( h->ident != IDENT && h->ident != IDENT_INDEXED ) {
 		Con_Printf( COLOR_RED "LoadArchiveFile: failed to load save, header has incorrect identifier (%i, should be %i).\n",
-			h->validation.ident, IDENT );
+			h->ident, IDENT_INDEXED );
 		return false;
 	}
 
-	if ( h->validation.version.m_nVersionMajor != NOMAD_VERSION
-		|| h->validation.version.m_nVersionUpdate != NOMAD_VERSION_UPDATE
-		|| h->validation.version.m_nVersionPatch != NOMAD_VERSION_PATCH )
+	if ( h->version.m_nVersionMajor != NOMAD_VERSION
+		|| h->version.m_nVersionUpdate != NOMAD_VERSION_UPDATE
+		|| h->version.m_nVersionPatch != NOMAD_VERSION_PATCH )
 	{
 		Con_Printf( COLOR_RED "LoadArchiveFile: failed to load save, header has incorrect version.\n" );
 		return false;
@@ -83,228 +592,329 @@ bool CGameArchive::ValidateHeader( const void *data ) const
 	return true;
 }
 
-static void G_ListMods( const char *pSaveFile, uint64_t nMods, fileHandle_t hFile ) {
-	uint64_t i;
-	char name[MAX_NPATH];
-	int32_t versionMajor, versionUpdate, versionPatch;
-	
-	Con_Printf( "%lu mods located in save file '%s'\n", nMods, pSaveFile );
-	for ( i = 0; i < nMods; i++ ) {
-		FS_Read( name, sizeof( name ), hFile );
-		FS_Read( &versionMajor, sizeof( versionMajor ), hFile );
-		FS_Read( &versionUpdate, sizeof( versionUpdate ), hFile );
-		FS_Read( &versionPatch, sizeof( versionPatch ), hFile );
+static void G_SwapValidation( ngdvalidation_t *validation )
+{
+	validation->ident = LittleInt( validation->ident );
+	validation->version.m_nVersionMajor = LittleShort( validation->version.m_nVersionMajor );
+	validation->version.m_nVersionUpdate = LittleShort( validation->version.m_nVersionUpdate );
+	validation->version.m_nVersionPatch = LittleInt( validation->version.m_nVersionPatch );
+}
 
-		versionMajor = LittleInt( versionMajor );
-		versionUpdate = LittleInt( versionUpdate );
-		versionPatch = LittleInt( versionPatch );
+static void G_SwapIndexHeader( ngdindexheader_t *header )
+{
+	G_SwapValidation( &header->validation );
+	header->mapIndex = LittleInt( header->mapIndex );
+	header->highestDif = LittleInt( header->highestDif );
+	header->saveDif = LittleInt( header->saveDif );
+	header->playTimeHours = LittleInt( header->playTimeHours );
+	header->playTimeMinutes = LittleInt( header->playTimeMinutes );
+	header->numMods = LittleLong( header->numMods );
+	header->compression = LittleInt( header->compression );
+	header->compressedSize = LittleInt( header->compressedSize );
+	header->checksum = LittleInt( header->checksum );
+	header->numSections = LittleInt( header->numSections );
+	header->numBuckets = LittleInt( header->numBuckets );
+	header->numFields = LittleInt( header->numFields );
+	header->stringsSize = LittleInt( header->stringsSize );
+	header->dataSize = LittleInt( header->dataSize );
+}
 
-		Con_Printf( "%lu: %s v%i.%i.%i\n", i, name, versionMajor, versionUpdate, versionPatch );
+/*
+* G_ReadLegacyHeader: pulls the header out of a v1 save, the reader is left at the first section
+*/
+static qboolean G_ReadLegacyHeader( ngdreader_t *reader, ngdheader_t *header )
+{
+	if ( !G_ReadSaveData( reader, &header->validation, sizeof( header->validation ) )
+		|| !G_ReadSaveData( reader, &header->numSections, sizeof( header->numSections ) )
+		|| !G_ReadSaveData( reader, &header->gamedata.mapIndex, sizeof( header->gamedata.mapIndex ) )
+		|| !G_ReadSaveData( reader, &header->gamedata.highestDif, sizeof( header->gamedata.highestDif ) )
+		|| !G_ReadSaveData( reader, &header->gamedata.saveDif, sizeof( header->gamedata.saveDif ) )
+		|| !G_ReadSaveData( reader, &header->gamedata.playTimeHours, sizeof( header->gamedata.playTimeHours ) )
+		|| !G_ReadSaveData( reader, &header->gamedata.playTimeMinutes, sizeof( header->gamedata.playTimeMinutes ) )
+		|| !G_ReadSaveData( reader, &header->gamedata.numMods, sizeof( header->gamedata.numMods ) ) )
+	{
+		return qfalse;
 	}
+
+	G_SwapValidation( &header->validation );
+	header->numSections = LittleLong( header->numSections );
+	header->gamedata.mapIndex = LittleInt( header->gamedata.mapIndex );
+	header->gamedata.highestDif = LittleInt( header->gamedata.highestDif );
+	header->gamedata.saveDif = LittleInt( header->gamedata.saveDif );
+	header->gamedata.playTimeHours = LittleInt( header->gamedata.playTimeHours );
+	header->gamedata.playTimeMinutes = LittleInt( header->gamedata.playTimeMinutes );
+	header->gamedata.numMods = LittleLong( header->gamedata.numMods );
+	header->gamedata.modList = NULL;
+
+	return qtrue;
 }
 
-static ngdfield_t *G_LoadArchiveField( ngdsection_read_t *section, const char *pSaveFile, fileHandle_t hFile )
+/*
+* G_ConvertLegacyArchive: reads every section of a v1 save and builds the same index a v2 save
+* has, so the lookups don't care which one they're reading from
+*/
+static qboolean G_ConvertLegacyArchive( ngdindex_t *index, const byte *buffer, uint64_t size, const char *name )
 {
-	PROFILE_FUNCTION();
+	ngdreader_t reader;
+	ngdheader_t header;
+	ngdindexheader_t indexHeader;
+	int32_t nameLength, numFields, type, dataSize;
+	char sectionName[ MAX_SAVE_SECTION_NAME ];
+	char fieldName[ MAX_SAVE_FIELD_NAME ];
+	uint64_t indexSize;
+	int64_t i, j;
+	byte *data;
 
-	uint64_t size;
-	int32_t nameLength;
-	int32_t dataSize;
-	int32_t type;
-	char szName[MAX_SAVE_FIELD_NAME];
-	ngdfield_t *field;
+	reader.pData = buffer;
+	reader.nSize = size;
+	reader.nOffset = 0;
+
+	if ( !G_ReadLegacyHeader( &reader, &header ) || header.numSections < 0 ) {
+		Con_Printf( COLOR_RED "ERROR: save file '%s' has a truncated header\n", name );
+		return qfalse;
+	}
+
+	G_ResetIndexBuilder( &g_indexBuilder );
 
-	memset( szName, 0, sizeof( szName ) );
+	for ( i = 0; i < header.numSections; i++ ) {
+		if ( !G_ReadSaveData( &reader, &nameLength, sizeof( nameLength ) ) ) {
+			break;
+		}
+		nameLength = LittleInt( nameLength );
+		if ( nameLength <= 0 || nameLength >= MAX_SAVE_SECTION_NAME || !G_ReadSaveData( &reader, sectionName, nameLength )
+			|| (size_t)nameLength != strnlen( sectionName, nameLength ) + 1 || !G_ReadSaveData( &reader, &numFields, sizeof( numFields ) ) )
+		{
+			Con_Printf( COLOR_RED "ERROR: save file '%s' section %li has a bad name\n", name, i );
+			return qfalse;
+		}
+		numFields = LittleInt( numFields );
 
-	dataSize = 0;
-	nameLength = 0;
-	type = 0;
+		G_BeginIndexSection( &g_indexBuilder, sectionName );
+		for ( j = 0; j < numFields; j++ ) {
+			if ( !G_ReadSaveData( &reader, &nameLength, sizeof( nameLength ) ) ) {
+				break;
+			}
+			nameLength = LittleInt( nameLength );
+			if ( nameLength <= 0 || nameLength >= MAX_SAVE_FIELD_NAME || !G_ReadSaveData( &reader, fieldName, nameLength )
+				|| (size_t)nameLength != strnlen( fieldName, nameLength ) + 1 || !G_ReadSaveData( &reader, &type, sizeof( type ) ) )
+			{
+				break;
+			}
+			type = LittleInt( type );
+
+			dataSize = G_FieldTypeSize( type );
+			if ( type == FT_STRING || type == FT_ARRAY ) {
+				if ( !G_ReadSaveData( &reader, &dataSize, sizeof( dataSize ) ) ) {
+					break;
+				}
+				dataSize = LittleInt( dataSize );
+			}
+			if ( type < FT_CHAR || type > FT_ARRAY || dataSize <= 0 || (uint64_t)dataSize > reader.nSize - reader.nOffset ) {
+				break;
+			}
 
-	FS_Read( &nameLength, sizeof( nameLength ), hFile );
-	nameLength = LittleInt( nameLength );
+			G_AddIndexField( &g_indexBuilder, fieldName, type, reader.pData + reader.nOffset, dataSize );
+			reader.nOffset += dataSize;
+		}
+		if ( j != numFields ) {
+			Con_Printf( COLOR_RED "ERROR: save file '%s' section '%s' field %li is corrupt\n", name, sectionName, j );
+			return qfalse;
+		}
+	}
+	if ( i != header.numSections ) {
+		Con_Printf( COLOR_RED "ERROR: save file '%s' is truncated, got %li of %li sections\n", name, i, header.numSections );
+		return qfalse;
+	}
 
-	FS_Read( szName, nameLength, hFile );
-	if ( nameLength != strlen( szName ) + 1 ) {
-		N_Error( ERR_DROP,
-			"CGameArchive::LoadArchiveFile: failed to load save '%s', field '%s', nameLength != strlen( szName )"
-		, pSaveFile, szName );
+	memset( &indexHeader, 0, sizeof( indexHeader ) );
+	data = G_BuildIndex( &g_indexBuilder, &indexHeader, &indexSize );
+	if ( !G_ParseIndex( index, data, indexSize, &indexHeader, name ) ) {
+		Z_Free( data );
+		memset( index, 0, sizeof( *index ) );
+		return qfalse;
 	}
 
-	FS_Read( &type, sizeof( type ), hFile );
-	type = LittleInt( type );
+	return qtrue;
+}
 
-	switch ( type ) {
-	case FT_ARRAY: {
-		FS_Read( &dataSize, sizeof( dataSize ), hFile );
-		if ( !dataSize ) {
-			N_Error( ERR_DROP,
-				"CGameArchive::LoadArchiveFile: failed to load save '%s', field '%s' (type = array), dataSize is corrupt"
-			, pSaveFile, szName );
+static qboolean G_LoadIndexedArchive( ngdindex_t *index, const byte *buffer, uint64_t size, const char *name )
+{
+	ngdindexheader_t header;
+	uint64_t indexSize;
+	byte *data;
+	int ret;
+
+	if ( size < sizeof( header ) ) {
+		Con_Printf( COLOR_RED "ERROR: save file '%s' has a truncated header\n", name );
+		return qfalse;
+	}
+	memcpy( &header, buffer, sizeof( header ) );
+	G_SwapIndexHeader( &header );
+
+	if ( header.compressedSize != size - sizeof( header ) ) {
+		Con_Printf( COLOR_RED "ERROR: save file '%s' is %lu bytes, should be %lu\n", name, size,
+			sizeof( header ) + header.compressedSize );
+		return qfalse;
+	}
+
+	indexSize = ( (uint64_t)header.numSections * sizeof( ngdsection_t ) ) + ( (uint64_t)header.numBuckets * sizeof( uint32_t ) )
+		+ ( (uint64_t)header.numFields * sizeof( ngdfield_t ) ) + header.stringsSize + header.dataSize;
+
+	switch ( header.compression ) {
+	case COMPRESS_NONE:
+		if ( header.compressedSize != indexSize ) {
+			Con_Printf( COLOR_RED "ERROR: save file '%s' index is %u bytes, should be %lu\n", name, header.compressedSize, indexSize );
+			return qfalse;
 		}
-		break; }
-	case FT_CHAR:
-	case FT_UCHAR:
-		dataSize = sizeof( uint8_t );
-		break;
-	case FT_SHORT:
-	case FT_USHORT:
-		dataSize = sizeof( uint16_t );
+		data = (byte *)Z_Malloc( MAX( indexSize, 1 ), TAG_SAVEFILE );
+		memcpy( data, buffer + sizeof( header ), indexSize );
 		break;
-	case FT_INT:
-	case FT_UINT:
-		dataSize = sizeof( uint32_t );
-		break;
-	case FT_LONG:
-	case FT_ULONG:
-		dataSize = sizeof( uint64_t );
-		break;
-	case FT_FLOAT:
-		dataSize = sizeof( float );
-		break;
-	case FT_VECTOR2:
-		dataSize = sizeof( vec2_t );
-		break;
-	case FT_VECTOR3:
-		dataSize = sizeof( vec3_t );
-		break;
-	case FT_VECTOR4:
-		dataSize = sizeof( vec4_t );
-		break;
-	case FT_STRING: {
-		FS_Read( &dataSize, sizeof( dataSize ), hFile );
-		if ( !dataSize ) {
-			N_Error( ERR_DROP,
-				"CGameArchive::LoadArchiveFile: failed to load save '%s', field '%s' (type = string), dataSize is corrupt"
-			, pSaveFile, szName );
+	case COMPRESS_LZ4:
+		if ( indexSize >= LZ4_MAX_INPUT_SIZE ) {
+			Con_Printf( COLOR_RED "ERROR: save file '%s' index is too large\n", name );
+			return qfalse;
 		}
-		break; }
+		data = (byte *)Z_Malloc( MAX( indexSize, 1 ), TAG_SAVEFILE );
+		ret = LZ4_decompress_safe( (const char *)buffer + sizeof( header ), (char *)data, header.compressedSize, (int)indexSize );
+		if ( ret < 0 || (uint64_t)ret != indexSize ) {
+			Con_Printf( COLOR_RED "ERROR: save file '%s' failed to decompress\n", name );
+			Z_Free( data );
+			return qfalse;
+		}
+		break;
 	default:
-		N_Error( ERR_DROP, "CGameArchive::LoadArchiveFile: failed to load save '%s', field '%s' has a bad dataType",
-			pSaveFile, szName );
+		Con_Printf( COLOR_RED "ERROR: save file '%s' has an unknown compression %i\n", name, header.compression );
+		return qfalse;
 	};
-	dataSize = LittleInt( dataSize );
 
-	size = 0;
-	size += PAD( sizeof( *field ), sizeof( uintptr_t ) );
-	size += PAD( nameLength, sizeof( uintptr_t ) );
-	size += PAD( dataSize, sizeof( uintptr_t ) );
+	if ( crc32_buffer( data, indexSize ) != header.checksum ) {
+		Con_Printf( COLOR_RED "ERROR: save file '%s' failed checksum\n", name );
+		Z_Free( data );
+		return qfalse;
+	}
+
+	if ( !G_ParseIndex( index, data, indexSize, &header, name ) ) {
+		Z_Free( data );
+		memset( index, 0, sizeof( *index ) );
+		return qfalse;
+	}
+
+	return qtrue;
+}
+
+/*
+* CGameArchive::OpenArchive: reads the whole save in one go and builds the field index for it
+*/
+qboolean CGameArchive::OpenArchive( const char *filename, ngdindex_t *index ) const
+{
+	ngdvalidation_t validation;
+	byte *buffer;
+	uint64_t size;
+	qboolean ok;
+
+	PROFILE_FUNCTION();
+
+	memset( index, 0, sizeof( *index ) );
+
+	size = FS_LoadFile( filename, (void **)&buffer );
+	if ( !buffer ) {
+		Con_Printf( COLOR_RED "ERROR: failed to open save file '%s'!\n", filename );
+		return qfalse;
+	}
+
+	if ( size < sizeof( validation ) ) {
+		Con_Printf( COLOR_RED "ERROR: save file '%s' is truncated\n", filename );
+		FS_FreeFile( buffer );
+		return qfalse;
+	}
+	memcpy( &validation, buffer, sizeof( validation ) );
+	G_SwapValidation( &validation );
+	if ( !ValidateHeader( &validation ) ) {
+		FS_FreeFile( buffer );
+		return qfalse;
+	}
 
-	field = (ngdfield_t *)Z_Malloc( size, TAG_SAVEFILE );
-	memset( field, 0, size );
-	field->name = (char *)( field + 1 );
-	field->dataSize = dataSize;
-	field->type = type;
-	field->nameLength = nameLength;
-	field->dataOffset = FS_FileTell( hFile );
-	strcpy( field->name, szName );
+	if ( validation.ident == IDENT ) {
+		ok = G_ConvertLegacyArchive( index, buffer, size, filename );
+	} else {
+		ok = G_LoadIndexedArchive( index, buffer, size, filename );
+	}
+	FS_FreeFile( buffer );
 
-	return field;
+	return ok;
 }
 
+/*
+* CGameArchive::LoadArchiveFile: only reads the header, the rest of the file is left alone until it's loaded
+*/
 qboolean CGameArchive::LoadArchiveFile( const char *filename, uint64_t index )
 {
 	PROFILE_FUNCTION();
 
+	byte buffer[ sizeof( ngdindexheader_t ) ];
+	ngdindexheader_t indexHeader;
 	ngdheader_t header;
-	int i, j;
-	int32_t nameLength, numFields;
-	uint64_t size;
+	ngdreader_t reader;
 	fileHandle_t hFile;
-	ngdsection_read_t *section;
-	ngdfield_t *field;
 	ngd_file_t *file;
-	char name[MAX_SAVE_SECTION_NAME];
-	
+
 	hFile = FS_FOpenRead( filename );
 	if ( hFile == FS_INVALID_HANDLE ) {
 		Con_Printf( COLOR_RED "ERROR: failed to open save file '%s'!\n", filename );
-		return false;
+		return qfalse;
 	}
 
-	N_strncpyz( name, COM_SkipPath( const_cast<char *>( filename ) ), sizeof( name ) );
-	
-	FS_Read( &header.validation.ident, sizeof( header.validation.ident ), hFile );
-	FS_Read( &header.validation.version.m_nVersionMajor, sizeof( header.validation.version.m_nVersionMajor ), hFile );
-	FS_Read( &header.validation.version.m_nVersionUpdate, sizeof( header.validation.version.m_nVersionUpdate ), hFile );
-	FS_Read( &header.validation.version.m_nVersionPatch, sizeof( header.validation.version.m_nVersionPatch ), hFile );
-
-	header.validation.ident = LittleInt( header.validation.ident );
-	header.validation.version.m_nVersionMajor = LittleShort( header.validation.version.m_nVersionMajor );
-	header.validation.version.m_nVersionUpdate = LittleShort( header.validation.version.m_nVersionUpdate );
-	header.validation.version.m_nVersionPatch = LittleInt( header.validation.version.m_nVersionPatch );
+	reader.pData = buffer;
+	reader.nSize = FS_Read( buffer, sizeof( buffer ), hFile );
+	reader.nOffset = 0;
+	FS_FClose( hFile );
 
-	if ( !ValidateHeader( &header ) ) {
-		return false;
+	memset( &header, 0, sizeof( header ) );
+	if ( reader.nSize < sizeof( header.validation ) ) {
+		Con_Printf( COLOR_RED "ERROR: save file '%s' is truncated\n", filename );
+		return qfalse;
+	}
+	memcpy( &header.validation, buffer, sizeof( header.validation ) );
+	G_SwapValidation( &header.validation );
+	if ( !ValidateHeader( &header.validation ) ) {
+		return qfalse;
 	}
 
-	FS_Read( &header.numSections, sizeof( header.numSections ), hFile );
-	FS_Read( &header.gamedata.mapIndex, sizeof( header.gamedata.mapIndex ), hFile );
-	FS_Read( &header.gamedata.highestDif, sizeof( header.gamedata.highestDif ), hFile );
-	FS_Read( &header.gamedata.saveDif, sizeof( header.gamedata.saveDif ), hFile );
-	FS_Read( &header.gamedata.playTimeHours, sizeof( header.gamedata.playTimeHours ), hFile );
-	FS_Read( &header.gamedata.playTimeMinutes, sizeof( header.gamedata.playTimeMinutes ), hFile );
-	FS_Read( &header.gamedata.numMods, sizeof( header.gamedata.numMods ), hFile );
-
-	header.numSections = LittleLong( header.numSections );
-	header.gamedata.mapIndex = LittleInt( header.gamedata.mapIndex );
-	header.gamedata.highestDif = LittleInt( header.gamedata.highestDif );
-	header.gamedata.saveDif = LittleInt( header.gamedata.saveDif );
-	header.gamedata.playTimeHours = LittleInt( header.gamedata.playTimeHours );
-	header.gamedata.playTimeMinutes = LittleInt( header.gamedata.playTimeMinutes );
-	header.gamedata.numMods = LittleLong( header.gamedata.numMods );
+	if ( header.validation.ident == IDENT ) {
+		if ( !G_ReadLegacyHeader( &reader, &header ) ) {
+			Con_Printf( COLOR_RED "ERROR: save file '%s' has a truncated header\n", filename );
+			return qfalse;
+		}
+	} else {
+		if ( reader.nSize != sizeof( indexHeader ) ) {
+			Con_Printf( COLOR_RED "ERROR: save file '%s' has a truncated header\n", filename );
+			return qfalse;
+		}
+		memcpy( &indexHeader, buffer, sizeof( indexHeader ) );
+		G_SwapIndexHeader( &indexHeader );
 
-	// skip past the mod data
-//	G_ListMods( name, header.gamedata.numMods, hFile );
-	//FS_FileSeek( hFile, ( MAX_NPATH + ( sizeof( int32_t ) * 3 ) ) * header.gamedata.numMods, FS_SEEK_CUR );
+		header.numSections = indexHeader.numSections;
+		header.gamedata.mapIndex = indexHeader.mapIndex;
+		header.gamedata.highestDif = indexHeader.highestDif;
+		header.gamedata.saveDif = indexHeader.saveDif;
+		header.gamedata.playTimeHours = indexHeader.playTimeHours;
+		header.gamedata.playTimeMinutes = indexHeader.playTimeMinutes;
+		header.gamedata.numMods = indexHeader.numMods;
+	}
 
-	size = PAD( sizeof( *file ) + ( sizeof( *file->m_pSectionList ) * header.numSections ), sizeof( uintptr_t ) );
+	file = (ngd_file_t *)Z_Malloc( sizeof( *file ), TAG_SAVEFILE );
+	memset( file, 0, sizeof( *file ) );
 
-	file = (ngd_file_t *)Z_Malloc( size, TAG_SAVEFILE );
-	memset( file, 0, size );
-	
 	memcpy( &file->gd, &header.gamedata, sizeof( gamedata_t ) );
 
-	file->m_pSectionList = (ngdsection_read_t *)( file + 1 );
-	strcpy( file->name, name );
+	N_strncpyz( file->name, COM_SkipPath( const_cast<char *>( filename ) ), sizeof( file->name ) );
+	N_strncpyz( file->path, filename, sizeof( file->path ) );
 	file->m_nSections = header.numSections;
-	section = file->m_pSectionList;
-
-	Con_DPrintf( "Adding save file '%s' to cache with %li sections...\n", name, header.numSections );
-	
-	for ( i = 0; i < header.numSections; i++ ) {		
-		FS_Read( &nameLength, sizeof( nameLength ), hFile );
-		nameLength = LittleInt( nameLength );
-
-		if ( !nameLength || nameLength >= MAX_SAVE_SECTION_NAME ) {
-			N_Error( ERR_DROP, "CGameArchive::LoadArchiveFile: failed to load save file '%s', section %i nameLength is invalid"
-				, name, i );
-		}
-		FS_Read( name, nameLength, hFile );
-		if ( nameLength != strlen( name ) + 1 ) {
-			N_Error( ERR_DROP, "CGameArchive::LoadArchiveFile: failed to load save file '%s', section %i nameLength != strlen( name )"
-				, name, i );
-		}
-		FS_Read( &numFields, sizeof( numFields ), hFile );
-		numFields = LittleInt( numFields );
-
-		memset( section, 0, sizeof( *section ) );
-		section->m_pFieldCache = (ngdfield_t **)Z_Malloc( sizeof( *section->m_pFieldCache ) * numFields, TAG_SAVEFILE );
-		section->numFields = numFields;
-		strcpy( section->name, name );
-		section->nameLength = nameLength;
 
-		for ( j = 0; j < section->numFields; j++ ) {
-			field = G_LoadArchiveField( section, name, hFile );
-			section->m_pFieldCache[ j ] = field;
-			FS_FileSeek( hFile, field->dataSize, FS_SEEK_CUR );
-		}
-		section++;
-	}
-	FS_FClose( hFile );
+	Con_DPrintf( "Adding save file '%s' to cache with %li sections...\n", file->name, header.numSections );
 
 	m_pArchiveCache[ index ] = file;
-	m_hFile = hFile;
-	
+
 	return qtrue;
 }
 
@@ -317,6 +927,16 @@ static void G_SaveGame_f( void )
 	g_pArchiveHandler->Save( atoi( Cmd_Argv( 1 ) ) );
 }
 
+static void G_SaveTest_f( void )
+{
+	g_pArchiveHandler->RunSaveTest();
+}
+
+static void G_SaveBench_f( void )
+{
+	g_pArchiveHandler->RunSaveBench( Cmd_Argc() > 1 ? MAX( atoi( Cmd_Argv( 1 ) ), 1 ) : 10000 );
+}
+
 CGameArchive::CGameArchive( void )
 {
 	PROFILE_FUNCTION();
@@ -336,15 +956,22 @@ CGameArchive::CGameArchive( void )
 	m_pArchiveFileList = (char **)Z_Malloc( sizeof( *m_pArchiveFileList ) * g_maxSaveSlots->i, TAG_SAVEFILE );
 	memset( m_pArchiveFileList, 0, sizeof( *m_pArchiveFileList ) * g_maxSaveSlots->i );
 
+	memset( &m_Index, 0, sizeof( m_Index ) );
+	m_nSectionDepth = 0;
+	m_nSections = 0;
 	m_nUsedSaveSlots = 0;
 
 	for ( i = 0; i < g_maxSaveSlots->i; i++ ) {
 		Com_snprintf( szName, sizeof( szName ) - 1, "SLOT_%lu", i );
-		m_pArchiveFileList[ i ] = (char *)Z_Malloc( strlen( szName ) + 1, TAG_SAVEFILE );
-		N_strncpyz( m_pArchiveFileList[ i ], szName, strlen( szName ) + 1 );
+		m_pArchiveFileList[ i ] = (char *)Z_Malloc( MAX_NPATH, TAG_SAVEFILE );
+		N_strncpyz( m_pArchiveFileList[ i ], szName, MAX_NPATH );
 
-		if ( FS_FileExists( va( "gamedata/SaveData/%s.ngd", szName ) ) ) {
-			LoadArchiveFile( va( "gamedata/SaveData/%s.ngd", szName ), i );
+		if ( FS_FileExists( G_SlotPath( i, qfalse ) ) ) {
+			LoadArchiveFile( G_SlotPath( i, qfalse ), i );
+		} else if ( FS_FileExists( G_SlotPath( i, qtrue ) ) ) {
+			LoadArchiveFile( G_SlotPath( i, qtrue ), i );
+		}
+		if ( m_pArchiveCache[ i ] ) {
 			Con_Printf( "...Cached save slot %lu\n", i );
 			m_nUsedSaveSlots++;
 		}
@@ -359,13 +986,21 @@ void G_InitArchiveHandler( void )
 
 	g_pArchiveHandler = new ( Hunk_Alloc( sizeof( *g_pArchiveHandler ), h_low ) ) CGameArchive();
 	Cmd_AddCommand( "sgame.save_game", G_SaveGame_f );
+	Cmd_AddCommand( "sgame.save_test", G_SaveTest_f );
+	Cmd_AddCommand( "sgame.save_bench", G_SaveBench_f );
 }
 
 void G_ShutdownArchiveHandler( void ) {
+	// don't lose a save that's still being written
+	G_WaitSaveWriter();
+
 	g_pArchiveHandler->~CGameArchive();
 	g_pArchiveHandler = NULL;
 	Cmd_RemoveCommand( "sgame.save_game" );
+	Cmd_RemoveCommand( "sgame.save_test" );
+	Cmd_RemoveCommand( "sgame.save_bench" );
 	Z_FreeTags( TAG_SAVEFILE );
+	memset( &g_indexBuilder, 0, sizeof( g_indexBuilder ) );
 }
 
 const char **CGameArchive::GetSaveFiles( uint64_t *nFiles ) const {
@@ -385,7 +1020,7 @@ void CGameArchive::BeginSaveSection( const char *moduleName, const char *name )
 {
 	const char *path;
 	int64_t nameLength = strlen( name ) + 1;
-	
+
 	if ( nameLength >= MAX_SAVE_SECTION_NAME ) {
 		N_Error( ERR_DROP, "CGameArchive::AddSection: section name '%s' is longer than %i characters, please shorten, like seriously",
 			name, MAX_SAVE_SECTION_NAME - 1 );
@@ -393,23 +1028,20 @@ void CGameArchive::BeginSaveSection( const char *moduleName, const char *name )
 	if ( m_nSectionDepth >= MAX_SAVE_SECTION_DEPTH ) {
 		N_Error( ERR_DROP, "CGameArchive::AddSection: section stack overflow" );
 	}
+	if ( m_nSectionDepth >= 1 ) {
+		N_Error( ERR_DROP, "CGameArchive::BeginSaveSection: cannot write embedded save sections" );
+	}
 
 	Con_DPrintf( "Adding section '%s' to archive file...\n", name );
 
 	m_pSection = &m_szSectionStack[ m_nSectionDepth++ ];
 
 	memset( m_pSection, 0, sizeof( *m_pSection ) );
-	m_pSection->offset = FS_FileTell( m_hFile );
 	m_pSection->numFields = 0;
 	m_pSection->nameLength = strlen( name ) + 1;
 	N_strncpyz( m_pSection->name, name, sizeof( m_pSection->name ) );
 
-	if ( m_nSectionDepth > 1 ) {
-		N_Error( ERR_DROP, "CGameArchive::BeginSaveSection: cannot write embedded save sections" );
-	}
-	FS_Write( &m_pSection->nameLength, sizeof( m_pSection->nameLength ), m_hFile );
-	FS_Write( m_pSection->name, m_pSection->nameLength, m_hFile );
-	FS_Write( &m_pSection->numFields, sizeof( m_pSection->numFields ), m_hFile );
+	G_BeginIndexSection( &g_indexBuilder, name );
 #ifdef SAVEFILE_MOD_SAFETY
 	m_pSection->m_pModuleName = moduleName;
 
@@ -426,13 +1058,9 @@ void CGameArchive::BeginSaveSection( const char *moduleName, const char *name )
 
 void CGameArchive::EndSaveSection( void )
 {
-	const uint64_t pos = FS_FileTell( m_hFile );
-
-	FS_FileSeek( m_hFile, m_pSection->offset, FS_SEEK_SET );
-	FS_Write( &m_pSection->nameLength, sizeof( m_pSection->nameLength ), m_hFile );
-	FS_Write( m_pSection->name, m_pSection->nameLength, m_hFile );
-	FS_Write( &m_pSection->numFields, sizeof( m_pSection->numFields ), m_hFile );
-	FS_FileSeek( m_hFile, pos, FS_SEEK_SET );
+	if ( !m_nSectionDepth ) {
+		N_Error( ERR_DROP, "CGameArchive::EndSaveSection: no section to end" );
+	}
 
 #ifdef SAVEFILE_MOD_SAFETY
 	FS_FileSeek( m_pSection->hFile, 0, FS_SEEK_SET );
@@ -448,41 +1076,33 @@ void CGameArchive::EndSaveSection( void )
 #endif
 
 	Con_DPrintf( "Finished save section '%s' with %i fields\n", m_pSection->name, m_pSection->numFields );
-	
+
 	m_nSectionDepth--;
 	m_nSections++;
 
-	m_pSection = &m_szSectionStack[ m_nSectionDepth - 1 ];
+	m_pSection = m_nSectionDepth ? &m_szSectionStack[ m_nSectionDepth - 1 ] : NULL;
 }
 
 void CGameArchive::AddField( const char *name, int32_t type, const void *data, uint32_t dataSize )
 {
-	ngdfield_t field;
-	int64_t i;
-	
-	m_pSection->numFields++;
-
-	field.type = type;
-	field.dataSize = dataSize;
-	field.nameLength = strlen( name ) + 1;
-
-	if ( field.nameLength >= MAX_SAVE_FIELD_NAME ) {
-		N_Error( ERR_DROP, "%s: name '%s' too long", __func__, name );
+	if ( !m_nSectionDepth ) {
+		N_Error( ERR_DROP, "%s: field '%s' isn't in a section", __func__, name );
 	}
-	
-	for ( i = 0; i < m_nSectionDepth; i++ ) {
-		Con_DPrintf( "-" );
+	if ( strlen( name ) + 1 >= MAX_SAVE_FIELD_NAME ) {
+		N_Error( ERR_DROP, "%s: name '%s' too long", __func__, name );
 	}
-	Con_DPrintf( "> Adding field %s to save file.\n", name );
 
-	FS_Write( &field.nameLength, sizeof( field.nameLength ), m_hFile );
-	FS_Write( name, field.nameLength, m_hFile );
-	FS_Write( &field.type, sizeof( field.type ), m_hFile );
-	FS_Write( data, dataSize, m_hFile );
+	m_pSection->numFields++;
+	G_AddIndexField( &g_indexBuilder, name, type, data, dataSize );
 #ifdef SAVEFILE_MOD_SAFETY
-	FS_Write( &field.nameLength, sizeof( field.nameLength ), m_pSection->hFile );
-	FS_Write( name, field.nameLength, m_pSection->hFile );
-	FS_Write( &field.type, sizeof( field.type ), m_pSection->hFile );
+	const int32_t nameLength = strlen( name ) + 1;
+
+	FS_Write( &nameLength, sizeof( nameLength ), m_pSection->hFile );
+	FS_Write( name, nameLength, m_pSection->hFile );
+	FS_Write( &type, sizeof( type ), m_pSection->hFile );
+	if ( type == FT_STRING || type == FT_ARRAY ) {
+		FS_Write( &dataSize, sizeof( dataSize ), m_pSection->hFile );
+	}
 	FS_Write( data, dataSize, m_pSection->hFile );
 #endif
 }
@@ -499,28 +1119,28 @@ void CGameArchive::SaveByte( const char *name, uint8_t data ) {
 	if ( !name ) {
 		N_Error( ERR_DROP, "%s: name is NULL", __func__ );
 	}
-	
+
 	AddField( name, FT_UCHAR, &data, sizeof( data ) );
 }
 void CGameArchive::SaveUShort( const char *name, uint16_t data ) {
 	if ( !name ) {
 		N_Error( ERR_DROP, "%s: name is NULL", __func__ );
 	}
-	
+
 	AddField( name, FT_USHORT, &data, sizeof( data ) );
 }
 void CGameArchive::SaveUInt( const char *name, uint32_t data ) {
 	if ( !name ) {
 		N_Error( ERR_DROP, "%s: name is NULL", __func__ );
 	}
-	
+
 	AddField( name, FT_UINT, &data, sizeof( data ) );
 }
 void CGameArchive::SaveULong( const char *name, uint64_t data ) {
 	if ( !name ) {
 		N_Error( ERR_DROP, "%s: name is NULL", __func__ );
 	}
-	
+
 	AddField( name, FT_ULONG, &data, sizeof( data ) );
 }
 
@@ -528,28 +1148,28 @@ void CGameArchive::SaveChar( const char *name, int8_t data ) {
 	if ( !name ) {
 		N_Error( ERR_DROP, "%s: name is NULL", __func__ );
 	}
-	
+
 	AddField( name, FT_CHAR, &data, sizeof( data ) );
 }
 void CGameArchive::SaveShort( const char *name, int16_t data ) {
 	if ( !name ) {
 		N_Error( ERR_DROP, "%s: name is NULL", __func__ );
 	}
-	
+
 	AddField( name, FT_SHORT, &data, sizeof( data ) );
 }
 void CGameArchive::SaveInt( const char *name, int32_t data ) {
 	if ( !name ) {
 		N_Error( ERR_DROP, "%s: name is NULL", __func__ );
 	}
-	
+
 	AddField( name, FT_INT, &data, sizeof( data ) );
 }
 void CGameArchive::SaveLong( const char *name, int64_t data ) {
 	if ( !name ) {
 		N_Error( ERR_DROP, "%s: name is NULL", __func__ );
 	}
-	
+
 	AddField( name, FT_LONG, &data, sizeof( data ) );
 }
 
@@ -557,7 +1177,7 @@ void CGameArchive::SaveVec2( const char *name, const vec2_t data ) {
 	if ( !name ) {
 		N_Error( ERR_DROP, "%s: name is NULL", __func__ );
 	}
-	
+
 	AddField( name, FT_VECTOR2, data, sizeof( vec2_t ) );
 }
 
@@ -565,7 +1185,7 @@ void CGameArchive::SaveVec3( const char *name, const vec3_t data ) {
 	if ( !name ) {
 		N_Error( ERR_DROP, "%s: name is NULL", __func__ );
 	}
-	
+
 	AddField( name, FT_VECTOR3, data, sizeof( vec3_t ) );
 }
 
@@ -573,13 +1193,11 @@ void CGameArchive::SaveVec4( const char *name, const vec4_t data ) {
 	if ( !name ) {
 		N_Error( ERR_DROP, "%s: name is NULL", __func__ );
 	}
-	
+
 	AddField( name, FT_VECTOR4, data, sizeof( vec4_t ) );
 }
 
 void CGameArchive::SaveCString( const char *name, const char *data ) {
-	ngdfield_t field;
-
 	if ( !name ) {
 		N_Error( ERR_DROP, "%s: name is NULL", __func__ );
 	}
@@ -587,32 +1205,10 @@ void CGameArchive::SaveCString( const char *name, const char *data ) {
 		N_Error( ERR_DROP, "%s: data is NULL", __func__ );
 	}
 
-	m_pSection->numFields++;
-
-	field.nameLength = strlen( name ) + 1;
-	field.type = FT_STRING;
-	field.dataSize = strlen( data ) + 1;
-	if ( field.nameLength >= MAX_SAVE_FIELD_NAME ) {
-		N_Error( ERR_DROP, "%s: name '%s' too long", __func__, name );
-	}
-
-	FS_Write( &field.nameLength, sizeof( field.nameLength ), m_hFile );
-	FS_Write( name, field.nameLength, m_hFile );
-	FS_Write( &field.type, sizeof( field.type ), m_hFile );
-	FS_Write( &field.dataSize, sizeof( field.dataSize ), m_hFile );
-	FS_Write( data, field.dataSize, m_hFile );
-#ifdef SAVEFILE_MOD_SAFETY
-	FS_Write( &field.nameLength, sizeof( field.nameLength ), m_pSection->hFile );
-	FS_Write( name, field.nameLength, m_pSection->hFile );
-	FS_Write( &field.type, sizeof( field.type ), m_pSection->hFile );
-	FS_Write( &field.dataSize, sizeof(field.dataSize), m_pSection->hFile );
-	FS_Write( data, field.dataSize, m_pSection->hFile );
-#endif
+	AddField( name, FT_STRING, data, strlen( data ) + 1 );
 }
 
 void CGameArchive::SaveString( const char *name, const string_t *pData ) {
-	ngdfield_t field;
-
 	if ( !name ) {
 		N_Error( ERR_DROP, "%s: name is NULL", __func__ );
 	}
@@ -620,27 +1216,7 @@ void CGameArchive::SaveString( const char *name, const string_t *pData ) {
 		N_Error( ERR_DROP, "%s: data is NULL", __func__ );
 	}
 
-	m_pSection->numFields++;
-
-	field.nameLength = strlen( name ) + 1;
-	field.type = FT_STRING;
-	field.dataSize = pData->size() + 1;
-	if ( field.nameLength >= MAX_SAVE_FIELD_NAME ) {
-		N_Error( ERR_DROP, "%s: name '%s' too long", __func__, name );
-	}
-	
-	FS_Write( &field.nameLength, sizeof( field.nameLength ), m_hFile );
-	FS_Write( name, field.nameLength, m_hFile );
-	FS_Write( &field.type, sizeof( field.type ), m_hFile );
-	FS_Write( &field.dataSize, sizeof( field.dataSize ), m_hFile );
-	FS_Write( pData->data(), field.dataSize, m_hFile );
-#ifdef SAVEFILE_MOD_SAFETY
-	FS_Write( &field.nameLength, sizeof( field.nameLength ), m_pSection->hFile );
-	FS_Write( name, field.nameLength, m_pSection->hFile );
-	FS_Write( &field.type, sizeof( field.type ), m_pSection->hFile );
-	FS_Write( &field.dataSize, sizeof( field.dataSize ), m_pSection->hFile );
-	FS_Write( pData->data(), field.dataSize, m_pSection->hFile );
-#endif
+	AddField( name, FT_STRING, pData->c_str(), pData->size() + 1 );
 }
 
 void CGameArchive::SaveArray( const char *name, const CScriptArray *pData )
@@ -650,8 +1226,6 @@ void CGameArchive::SaveArray( const char *name, const CScriptArray *pData )
 }
 
 void CGameArchive::SaveArray( const char *func, const char *name, const void *pData, uint32_t nBytes ) {
-	ngdfield_t field;
-
 	if ( !name ) {
 		N_Error( ERR_DROP, "%s: name is NULL", func );
 	}
@@ -659,45 +1233,38 @@ void CGameArchive::SaveArray( const char *func, const char *name, const void *pD
 		N_Error( ERR_DROP, "%s: data is NULL", func );
 	}
 
-	m_pSection->numFields++;
-
-	field.nameLength = strlen( name ) + 1;
-	field.type = FT_STRING;
-	field.dataSize = nBytes;
-	if ( field.nameLength >= MAX_SAVE_FIELD_NAME ) {
-		N_Error( ERR_DROP, "%s: name '%s' too long", func, name );
-	}
-
-	FS_Write( &field.nameLength, sizeof( field.nameLength ), m_hFile );
-	FS_Write( name, field.nameLength, m_hFile );
-	FS_Write( &field.type, sizeof( field.type ), m_hFile );
-	FS_Write( &field.dataSize, sizeof( field.dataSize ), m_hFile );
-	FS_Write( pData, nBytes, m_hFile );
-#ifdef SAVEFILE_MOD_SAFETY
-	FS_Write( &field.nameLength, sizeof( field.nameLength ), m_pSection->hFile );
-	FS_Write( name, field.nameLength, m_pSection->hFile );
-	FS_Write( &field.type, sizeof( field.type ), m_pSection->hFile );
-	FS_Write( &field.dataSize, sizeof( field.dataSize ), m_pSection->hFile );
-	FS_Write( pData, nBytes, m_pSection->hFile );
-#endif
+	AddField( name, FT_ARRAY, pData, nBytes );
 }
 
 const ngdfield_t *CGameArchive::FindField( const char *name, int32_t type, nhandle_t hSection ) const
 {
-	const ngdsection_read_t *section;
-	int i;
+	const ngdsection_t *section;
+	const ngdfield_t *field;
+	uint32_t hash, mask, slot, bucket, i;
 
-	section = &m_pArchiveCache[ m_nCurrentArchive ]->m_pSectionList[ hSection ];
+	if ( hSection < 0 || (uint32_t)hSection >= m_Index.m_nSections ) {
+		N_Error( ERR_DROP, "CGameArchive::FindField: invalid section handle %i", hSection );
+	}
+	section = &m_Index.m_pSections[ hSection ];
 
-	for ( i = 0; i < section->numFields; i++ ) {
-		if ( !N_stricmp( section->m_pFieldCache[i]->name, name ) ) {
-			if ( section->m_pFieldCache[i]->type != type ) {
+	hash = G_HashFieldName( name );
+	mask = section->numBuckets - 1;
+	slot = hash & mask;
+
+	for ( i = 0; i < section->numBuckets; i++ ) {
+		bucket = m_Index.m_pBuckets[ section->firstBucket + slot ];
+		if ( !bucket ) {
+			break;
+		}
+		field = &m_Index.m_pFields[ section->firstField + bucket - 1 ];
+		if ( field->hash == hash && !N_stricmp( m_Index.m_pStrings + field->nameOffset, name ) ) {
+			if ( field->type != type ) {
 				N_Error( ERR_DROP, "CGameArchive::FindField: save file corrupt or incompatible mod, field type doesn't match type given for '%s'",
 					name );
 			}
-			FS_FileSeek( m_hFile, section->m_pFieldCache[i]->dataOffset, FS_SEEK_SET );
-			return section->m_pFieldCache[i];
+			return field;
 		}
+		slot = ( slot + 1 ) & mask;
 	}
 
 	// we'll let the modder handle this
@@ -705,245 +1272,232 @@ const ngdfield_t *CGameArchive::FindField( const char *name, int32_t type, nhand
 	return NULL;
 }
 
+void CGameArchive::ReadField( const ngdfield_t *field, void *pBuffer ) const {
+	memcpy( pBuffer, m_Index.m_pData + field->dataOffset, field->dataSize );
+}
+
 float CGameArchive::LoadFloat( const char *name, nhandle_t hSection ) {
 	const ngdfield_t *field;
-	
+	float data;
+
 	if ( !name ) {
 		N_Error( ERR_DROP, "%s: name is NULL", __func__ );
 	}
 	if ( hSection == -1 ) {
 		N_Error( ERR_DROP, "%s: hSection is invalid", __func__ );
 	}
-	
+
 	field = FindField( name, FT_FLOAT, hSection );
 	if ( !field ) {
 		return 0.0f;
 	}
-	if ( !FS_Read( (void *)&field->data, field->dataSize, m_hFile ) ) {
-		N_Error( ERR_DROP, "%s: failed to read field '%s'", __func__, name );
-	}
-	
-	return field->data.f;
+	ReadField( field, &data );
+
+	return data;
 }
 
 uint8_t CGameArchive::LoadByte( const char *name, nhandle_t hSection ) {
 	const ngdfield_t *field;
-	
+	uint8_t data;
+
 	if ( !name ) {
 		N_Error( ERR_DROP, "%s: name is NULL", __func__ );
 	}
 	if ( hSection == -1 ) {
 		N_Error( ERR_DROP, "%s: hSection is invalid", __func__ );
 	}
-	
+
 	field = FindField( name, FT_UCHAR, hSection );
 	if ( !field ) {
 		return 0;
 	}
-	if ( !FS_Read( (void *)&field->data, field->dataSize, m_hFile ) ) {
-		N_Error( ERR_DROP, "%s: failed to read field '%s'", __func__, name );
-	}
-	
-	return field->data.u8;
+	ReadField( field, &data );
+
+	return data;
 }
 
 uint16_t CGameArchive::LoadUShort( const char *name, nhandle_t hSection ) {
 	const ngdfield_t *field;
-	
+	uint16_t data;
+
 	if ( !name ) {
 		N_Error( ERR_DROP, "%s: name is NULL", __func__ );
 	}
 	if ( hSection == -1 ) {
 		N_Error( ERR_DROP, "%s: hSection is invalid", __func__ );
 	}
-	
+
 	field = FindField( name, FT_USHORT, hSection );
 	if ( !field ) {
 		return 0;
 	}
-	if ( !FS_Read( (void *)&field->data, field->dataSize, m_hFile ) ) {
-		N_Error( ERR_DROP, "%s: failed to read field '%s'", __func__, name );
-	}
-	
-	return field->data.u16;
+	ReadField( field, &data );
+
+	return data;
 }
 
 uint32_t CGameArchive::LoadUInt( const char *name, nhandle_t hSection ) {
 	const ngdfield_t *field;
-	
+	uint32_t data;
+
 	if ( !name ) {
 		N_Error( ERR_DROP, "%s: name is NULL", __func__ );
 	}
 	if ( hSection == -1 ) {
 		N_Error( ERR_DROP, "%s: hSection is invalid", __func__ );
 	}
-	
+
 	field = FindField( name, FT_UINT, hSection );
 	if ( !field ) {
 		return 0;
 	}
-	if ( !FS_Read( (void *)&field->data, field->dataSize, m_hFile ) ) {
-		N_Error( ERR_DROP, "%s: failed to read field '%s'", __func__, name );
-	}
-	
-	return field->data.u32;
+	ReadField( field, &data );
+
+	return data;
 }
 
 uint64_t CGameArchive::LoadULong( const char *name, nhandle_t hSection ) {
 	const ngdfield_t *field;
-	
+	uint64_t data;
+
 	if ( !name ) {
 		N_Error( ERR_DROP, "%s: name is NULL", __func__ );
 	}
 	if ( hSection == -1 ) {
 		N_Error( ERR_DROP, "%s: hSection is invalid", __func__ );
 	}
-	
+
 	field = FindField( name, FT_ULONG, hSection );
 	if ( !field ) {
 		return 0;
 	}
-	if ( !FS_Read( (void *)&field->data, field->dataSize, m_hFile ) ) {
-		N_Error( ERR_DROP, "%s: failed to read field '%s'", __func__, name );
-	}
-	
-	return field->data.u64;
+	ReadField( field, &data );
+
+	return data;
 }
 
 int8_t CGameArchive::LoadChar( const char *name, nhandle_t hSection ) {
 	const ngdfield_t *field;
-	
+	int8_t data;
+
 	if ( !name ) {
 		N_Error( ERR_DROP, "%s: name is NULL", __func__ );
 	}
 	if ( hSection == -1 ) {
 		N_Error( ERR_DROP, "%s: hSection is invalid", __func__ );
 	}
-	
+
 	field = FindField( name, FT_CHAR, hSection );
 	if ( !field ) {
 		return 0;
 	}
-	if ( !FS_Read( (void *)&field->data, field->dataSize, m_hFile ) ) {
-		N_Error( ERR_DROP, "%s: failed to read field '%s'", __func__, name );
-	}
-	
-	return field->data.s8;
+	ReadField( field, &data );
+
+	return data;
 }
 
 int16_t CGameArchive::LoadShort( const char *name, nhandle_t hSection ) {
 	const ngdfield_t *field;
-	
+	int16_t data;
+
 	if ( !name ) {
 		N_Error( ERR_DROP, "%s: name is NULL", __func__ );
 	}
 	if ( hSection == -1 ) {
 		N_Error( ERR_DROP, "%s: hSection is invalid", __func__ );
 	}
-	
+
 	field = FindField( name, FT_SHORT, hSection );
 	if ( !field ) {
 		return 0;
 	}
-	if ( !FS_Read( (void *)&field->data, field->dataSize, m_hFile ) ) {
-		N_Error( ERR_DROP, "%s: failed to read field '%s'", __func__, name );
-	}
-	
-	return field->data.s16;
+	ReadField( field, &data );
+
+	return data;
 }
 
 int32_t CGameArchive::LoadInt( const char *name, nhandle_t hSection ) {
 	const ngdfield_t *field;
-	
+	int32_t data;
+
 	if ( !name ) {
 		N_Error( ERR_DROP, "%s: name is NULL", __func__ );
 	}
 	if ( hSection == -1 ) {
 		N_Error( ERR_DROP, "%s: hSection is invalid", __func__ );
 	}
-	
+
 	field = FindField( name, FT_INT, hSection );
 	if ( !field ) {
 		return 0;
 	}
-	if ( !FS_Read( (void *)&field->data, field->dataSize, m_hFile ) ) {
-		N_Error( ERR_DROP, "%s: failed to read field '%s'", __func__, name );
-	}
+	ReadField( field, &data );
 
-	return field->data.s32;
+	return data;
 }
 
 int64_t CGameArchive::LoadLong( const char *name, nhandle_t hSection ) {
 	const ngdfield_t *field;
-	
+	int64_t data;
+
 	if ( !name ) {
 		N_Error( ERR_DROP, "%s: name is NULL", __func__ );
 	}
 	if ( hSection == -1 ) {
 		N_Error( ERR_DROP, "%s: hSection is invalid", __func__ );
 	}
-	
+
 	field = FindField( name, FT_LONG, hSection );
 	if ( !field ) {
 		return 0;
 	}
-	if ( !FS_Read( (void *)&field->data, field->dataSize, m_hFile ) ) {
-		N_Error( ERR_DROP, "%s: failed to read field '%s'", __func__, name );
-	}
-	
-	return field->data.s64;
+	ReadField( field, &data );
+
+	return data;
 }
 
 void CGameArchive::LoadVec2( const char *name, vec2_t data, nhandle_t hSection )
 {
 	const ngdfield_t *field;
-	
+
 	if ( !name ) {
 		N_Error( ERR_DROP, "%s: name is NULL", __func__ );
 	}
 	if ( hSection == -1 ) {
 		N_Error( ERR_DROP, "%s: hSection is invalid", __func__ );
 	}
-	
+
 	field = FindField( name, FT_VECTOR2, hSection );
 	if ( !field ) {
 		VectorClear2( data );
 		return;
 	}
-	if ( !FS_Read( (void *)&field->data, field->dataSize, m_hFile ) ) {
-		N_Error( ERR_DROP, "%s: failed to read field '%s'", __func__, name );
-	}
-	
-	VectorCopy2( data, field->data.v2 );
+	ReadField( field, data );
 }
 
 void CGameArchive::LoadVec3( const char *name, vec3_t data, nhandle_t hSection )
 {
 	const ngdfield_t *field;
-	
+
 	if ( !name ) {
 		N_Error( ERR_DROP, "%s: name is NULL", __func__ );
 	}
 	if ( hSection == -1 ) {
 		N_Error( ERR_DROP, "%s: hSection is invalid", __func__ );
 	}
-	
+
 	field = FindField( name, FT_VECTOR3, hSection );
 	if ( !field ) {
 		VectorClear( data );
 		return;
 	}
-	if ( !FS_Read( (void *)&field->data, field->dataSize, m_hFile ) ) {
-		N_Error( ERR_DROP, "%s: failed to read field '%s'", __func__, name );
-	}
-	
-	VectorCopy( data, field->data.v3 );
+	ReadField( field, data );
 }
 
 void CGameArchive::LoadVec4( const char *name, vec4_t data, nhandle_t hSection )
 {
 	const ngdfield_t *field;
-	
+
 	if ( !name ) {
 		N_Error( ERR_DROP, "%s: name is NULL", __func__ );
 	}
@@ -956,37 +1510,32 @@ void CGameArchive::LoadVec4( const char *name, vec4_t data, nhandle_t hSection )
 		memset( data, 0, sizeof( vec4_t ) );
 		return;
 	}
-	if ( !FS_Read( (void *)&field->data, field->dataSize, m_hFile ) ) {
-		N_Error( ERR_DROP, "%s: failed to read field '%s'", __func__, name );
-	}
-
-	VectorCopy4( data, field->data.v2 );
+	ReadField( field, data );
 }
 
 void CGameArchive::LoadCString( const char *name, char *pBuffer, int32_t maxLength, nhandle_t hSection ) {
 	const ngdfield_t *field;
-	
+
 	if ( !name ) {
 		N_Error( ERR_DROP, "%s: name is NULL", __func__ );
 	}
 	if ( hSection == -1 ) {
 		N_Error( ERR_DROP, "%s: hSection is invalid", __func__ );
 	}
-	
+
 	field = FindField( name, FT_STRING, hSection );
 	if ( !field ) {
 		memset( pBuffer, 0, maxLength );
 		return;
 	}
 
-	// FIXME:
-	
-	N_strncpyz( pBuffer, field->data.str, maxLength );
+	N_strncpyz( pBuffer, (const char *)m_Index.m_pData + field->dataOffset, MIN( maxLength, (int32_t)field->dataSize ) );
 }
 
 void CGameArchive::LoadString( const char *name, string_t *pString, nhandle_t hSection ) {
 	const ngdfield_t *field;
-	
+	const char *data;
+
 	if ( !name ) {
 		N_Error( ERR_DROP, "%s: name is NULL", __func__ );
 	}
@@ -995,16 +1544,16 @@ void CGameArchive::LoadString( const char *name, string_t *pString, nhandle_t hS
 	}
 
 	pString->clear();
-	
+
 	field = FindField( name, FT_STRING, hSection );
 	if ( !field ) {
 		return;
 	}
-	
-	pString->resize( field->dataSize );
-	if ( !FS_Read( pString->data(), field->dataSize, m_hFile ) ) {
-		N_Error( ERR_DROP, "%s: failed to read field '%s'", __func__, name );
-	}
+
+	// the terminator is saved with the string, don't make it part of it
+	data = (const char *)m_Index.m_pData + field->dataOffset;
+	pString->resize( strnlen( data, field->dataSize ) );
+	memcpy( pString->data(), data, pString->size() );
 }
 
 void CGameArchive::LoadArray( const char *pszName, CScriptArray *pData, nhandle_t hSection ) {
@@ -1035,31 +1584,26 @@ void CGameArchive::LoadArray( const char *pszName, CScriptArray *pData, nhandle_
 		pData->Resize( field->dataSize / dataSize );
 	}
 
-	Con_DPrintf( "Successfully loaded array field '%s' containing %u bytes.\n", field->name, field->dataSize );
+	Con_DPrintf( "Successfully loaded array field '%s' containing %u bytes.\n", pszName, field->dataSize );
 
-	if ( !FS_Read( pData->GetBuffer(), field->dataSize, m_hFile ) ) {
-		N_Error( ERR_DROP, "%s: failed to read field '%s'", __func__, pszName );
-	}
+	ReadField( field, pData->GetBuffer() );
 }
 
 void CGameArchive::DeleteSlot( uint64_t nSlot )
 {
-	char path[ MAX_NPATH ];
-	uint64_t i, j;
-	
-	Com_snprintf( path, sizeof( path ) - 1, "SLOT_%lu", nSlot );
+	if ( nSlot >= g_maxSaveSlots->i || !m_pArchiveCache[ nSlot ] ) {
+		Con_Printf( COLOR_YELLOW "WARNING: CGameArchive::DeleteSlot: slot %lu isn't used\n", nSlot );
+		return;
+	}
 
 	Con_Printf( "Deleting save slot %lu...\n", nSlot );
 
-	FS_HomeRemove( va( "gamedata/SaveData/%s.ngd", path ) );
-	FS_Remove( va( "gamedata/SaveData/%s.ngd", path ) );
-	
-	for ( i = 0; i < m_pArchiveCache[ nSlot ]->m_nSections; i++ ) {
-		for ( j = 0; j < m_pArchiveCache[ nSlot ]->m_pSectionList[i].numFields; j++ ) {
-			Z_Free( m_pArchiveCache[ nSlot ]->m_pSectionList[i].m_pFieldCache[j] );
-		}
-		Z_Free( m_pArchiveCache[ nSlot ]->m_pSectionList[i].m_pFieldCache );
-	}
+	// a write that's still going would put it right back
+	G_WaitSaveWriter();
+
+	FS_HomeRemove( G_SlotPath( nSlot, qfalse ) );
+	FS_HomeRemove( G_SlotPath( nSlot, qtrue ) );
+
 	Z_Free( m_pArchiveCache[ nSlot ] );
 	m_pArchiveCache[ nSlot ] = NULL;
 
@@ -1069,71 +1613,45 @@ void CGameArchive::DeleteSlot( uint64_t nSlot )
 	Cbuf_ExecuteText( EXEC_APPEND, "ui.reload_savefiles\n" );
 }
 
-bool CGameArchive::Save( uint64_t nSlot )
+/*
+* CGameArchive::BuildSave: runs every module's save hook into the builder and lays the result out as an index,
+* the header only gets the compression and checksum left to fill in
+*/
+byte *CGameArchive::BuildSave( ngdindexheader_t *header, gamedata_t *gd, uint64_t *indexSize )
 {
-	char szPath[ MAX_NPATH ];
-	ngdheader_t header;
 	uint64_t i;
 	uint64_t now;
+	byte *index;
 
-	PROFILE_FUNCTION();
-
-	if ( nSlot >= g_maxSaveSlots->i ) {
-		N_Error( ERR_DROP, "CGameArchive::Save: invalid slot %lu", nSlot );
-	}
 	if ( m_nSectionDepth ) {
 		N_Error( ERR_DROP, "CGameArchive::Save: called when writing a section" );
 	}
-	Assert( nSlot < g_maxSaveSlots->i );
-
-	Com_snprintf( szPath, sizeof( szPath ) - 1, "SaveData/SLOT_%lu", nSlot );
-	m_hFile = FS_FOpenWrite( szPath );
-	if ( m_hFile == FS_INVALID_HANDLE ) {
-		Con_Printf( COLOR_RED "ERROR: failed to create save file '%s'!\n", szPath );
-		return false;
-	}
 
 	CModuleInfo *loadList = g_pModuleLib->GetLoadList();
-	
-	memset( &header, 0, sizeof( header ) );
-	header.gamedata.mapIndex = Cvar_VariableInteger( "g_levelIndex" );
-	header.gamedata.saveDif = Cvar_VariableInteger( "sgame_Difficulty" );
-	header.gamedata.numMods = g_pModuleLib->GetModCount();
+
+	memset( gd, 0, sizeof( *gd ) );
+	gd->mapIndex = Cvar_VariableInteger( "g_levelIndex" );
+	gd->saveDif = Cvar_VariableInteger( "sgame_Difficulty" );
+	gd->numMods = g_pModuleLib->GetModCount();
 
 	// give the best estimation, this is more just for brownie points than an actual ranking
 	now = Sys_Milliseconds();
-	header.gamedata.playTimeMinutes = ( now - gi.playTimeStart ) / 1000 / 60;
-	header.gamedata.playTimeHours = header.gamedata.playTimeMinutes / 60;
+	gd->playTimeMinutes = ( now - gi.playTimeStart ) / 1000 / 60;
+	gd->playTimeHours = gd->playTimeMinutes / 60;
 
-	if ( header.gamedata.saveDif > header.gamedata.highestDif ) {
-		header.gamedata.highestDif = header.gamedata.saveDif;
+	if ( gd->saveDif > gd->highestDif ) {
+		gd->highestDif = gd->saveDif;
 	}
 
 	for ( i = 0; i < g_pModuleLib->GetModCount(); i++ ) {
 		if ( !loadList[i].m_pHandle->IsValid() ) {
-			header.gamedata.numMods--;
+			gd->numMods--;
 		}
 	}
 
 	m_nSectionDepth = 0;
 	m_nSections = 0;
-	
-	header.validation.ident = IDENT;
-	header.validation.version.m_nVersionMajor = NOMAD_VERSION;
-	header.validation.version.m_nVersionUpdate = NOMAD_VERSION_UPDATE;
-	header.validation.version.m_nVersionPatch = NOMAD_VERSION_PATCH;
-
-	FS_Write( &header.validation.ident, sizeof( header.validation.ident ), m_hFile );
-	FS_Write( &header.validation.version.m_nVersionMajor, sizeof( header.validation.version.m_nVersionMajor ), m_hFile );
-	FS_Write( &header.validation.version.m_nVersionUpdate, sizeof( header.validation.version.m_nVersionUpdate ), m_hFile );
-	FS_Write( &header.validation.version.m_nVersionPatch, sizeof( header.validation.version.m_nVersionPatch ), m_hFile );
-	FS_Write( &header.numSections, sizeof( header.numSections ), m_hFile );
-	FS_Write( &header.gamedata.mapIndex, sizeof( header.gamedata.mapIndex ), m_hFile );
-	FS_Write( &header.gamedata.highestDif, sizeof( header.gamedata.highestDif ), m_hFile );
-	FS_Write( &header.gamedata.saveDif, sizeof( header.gamedata.saveDif ), m_hFile );
-	FS_Write( &header.gamedata.playTimeHours, sizeof( header.gamedata.playTimeHours ), m_hFile );
-	FS_Write( &header.gamedata.playTimeMinutes, sizeof( header.gamedata.playTimeMinutes ), m_hFile );
-	FS_Write( &header.gamedata.numMods, sizeof( header.gamedata.numMods ), m_hFile );
+	G_ResetIndexBuilder( &g_indexBuilder );
 
 	for ( i = 0; i < g_pModuleLib->GetModCount(); i++ ) {
 		Con_DPrintf( "Adding module '%s' save sections...\n", loadList[i].m_szName );
@@ -1141,41 +1659,66 @@ bool CGameArchive::Save( uint64_t nSlot )
 		g_pModuleLib->ModuleCall( &loadList[i], ModuleOnSaveGame, 0 );
 	}
 
-	header.numSections = m_nSections;
-	FS_FileSeek( m_hFile, 0, FS_SEEK_SET );
+	memset( header, 0, sizeof( *header ) );
+	header->validation.ident = IDENT_INDEXED;
+	header->validation.version.m_nVersionMajor = NOMAD_VERSION;
+	header->validation.version.m_nVersionUpdate = NOMAD_VERSION_UPDATE;
+	header->validation.version.m_nVersionPatch = NOMAD_VERSION_PATCH;
+	header->mapIndex = gd->mapIndex;
+	header->highestDif = gd->highestDif;
+	header->saveDif = gd->saveDif;
+	header->playTimeHours = gd->playTimeHours;
+	header->playTimeMinutes = gd->playTimeMinutes;
+	header->numMods = gd->numMods;
 
-	header.validation.ident = IDENT;
-	header.validation.version.m_nVersionMajor = NOMAD_VERSION;
-	header.validation.version.m_nVersionUpdate = NOMAD_VERSION_UPDATE;
-	header.validation.version.m_nVersionPatch = NOMAD_VERSION_PATCH;
+	index = G_BuildIndex( &g_indexBuilder, header, indexSize );
+	if ( *indexSize > UINT32_MAX ) {
+		Z_Free( index );
+		N_Error( ERR_DROP, "CGameArchive::Save: save file is larger than 4 GiB" );
+	}
 
-	FS_Write( &header.validation.ident, sizeof( header.validation.ident ), m_hFile );
-	FS_Write( &header.validation.version.m_nVersionMajor, sizeof( header.validation.version.m_nVersionMajor ), m_hFile );
-	FS_Write( &header.validation.version.m_nVersionUpdate, sizeof( header.validation.version.m_nVersionUpdate ), m_hFile );
-	FS_Write( &header.validation.version.m_nVersionPatch, sizeof( header.validation.version.m_nVersionPatch ), m_hFile );
-
-	FS_Write( &header.numSections, sizeof( header.numSections ), m_hFile );
-	FS_Write( &header.gamedata.mapIndex, sizeof( header.gamedata.mapIndex ), m_hFile );
-	FS_Write( &header.gamedata.highestDif, sizeof( header.gamedata.highestDif ), m_hFile );
-	FS_Write( &header.gamedata.saveDif, sizeof( header.gamedata.saveDif ), m_hFile );
-	FS_Write( &header.gamedata.playTimeHours, sizeof( header.gamedata.playTimeHours ), m_hFile );
-	FS_Write( &header.gamedata.playTimeMinutes, sizeof( header.gamedata.playTimeMinutes ), m_hFile );
-	FS_Write( &header.gamedata.numMods, sizeof( header.gamedata.numMods ), m_hFile );
-	
-	FS_FClose( m_hFile );
-	
-	//
-	// save to steam
-	//
-#ifdef NOMAD_STEAMAPP
-	g_pSteamManager->Save( szPath );
-#endif
+	return index;
+}
+
+bool CGameArchive::Save( uint64_t nSlot )
+{
+	ngdindexheader_t header;
+	gamedata_t gd;
+	ngd_file_t *file;
+	const char *path;
+	uint64_t indexSize;
+	byte *index;
+
+	PROFILE_FUNCTION();
+
+	if ( nSlot >= g_maxSaveSlots->i ) {
+		N_Error( ERR_DROP, "CGameArchive::Save: invalid slot %lu", nSlot );
+	}
+	Assert( nSlot < g_maxSaveSlots->i );
+
+	index = BuildSave( &header, &gd, &indexSize );
+
+	path = G_SlotPath( nSlot, qfalse );
+	Con_Printf( "Saving %u fields in %u sections to '%s'...\n", header.numFields, header.numSections, path );
+
+	G_StartSaveWriter( path, &header, index, indexSize );
 
 	//
-	// reload the cache
+	// the cache only keeps the headers, so there's nothing to read back from the new file
 	//
-	Z_FreeTags( TAG_SAVEFILE );
-	g_pArchiveHandler = new ( g_pArchiveHandler ) CGameArchive();
+	file = m_pArchiveCache[ nSlot ];
+	if ( !file ) {
+		file = (ngd_file_t *)Z_Malloc( sizeof( *file ), TAG_SAVEFILE );
+		m_pArchiveCache[ nSlot ] = file;
+		m_nUsedSaveSlots++;
+	}
+	memset( file, 0, sizeof( *file ) );
+	file->gd = gd;
+	file->m_nSections = header.numSections;
+	N_strncpyz( file->name, COM_SkipPath( const_cast<char *>( path ) ), sizeof( file->name ) );
+	N_strncpyz( file->path, path, sizeof( file->path ) );
+	Com_snprintf( m_pArchiveFileList[ nSlot ], MAX_NPATH, "SLOT_%lu", nSlot );
+
 	Cbuf_ExecuteText( EXEC_APPEND, "ui.reload_savefiles\n" );
 
 	return true;
@@ -1183,29 +1726,23 @@ bool CGameArchive::Save( uint64_t nSlot )
 
 nhandle_t CGameArchive::GetSection( const char *name )
 {
-	ngdsection_read_t *section;
-	int64_t i;
+	uint32_t i;
 
-	section = NULL;
 	Con_DPrintf( "Searching save file for section '%s'...\n", name );
-	for ( i = 0; i < m_pArchiveCache[ m_nCurrentArchive ]->m_nSections; i++ ) {
-		if ( !N_stricmp( m_pArchiveCache[ m_nCurrentArchive ]->m_pSectionList[i].name, name ) ) {
-			section = &m_pArchiveCache[ m_nCurrentArchive ]->m_pSectionList[i];
-			break;
+	for ( i = 0; i < m_Index.m_nSections; i++ ) {
+		if ( !N_stricmp( m_Index.m_pStrings + m_Index.m_pSections[i].nameOffset, name ) ) {
+			return i;
 		}
 	}
-	if ( !section ) {
-		Con_Printf( COLOR_RED "CGameArchive::GetSection: compatibility issue with save file section '%s', section not found in file\n", name );
-		return -1;
-	}
-	
-	return i;
+
+	Con_Printf( COLOR_RED "CGameArchive::GetSection: compatibility issue with save file section '%s', section not found in file\n", name );
+	return -1;
 }
 
 bool CGameArchive::LoadPartial( uint64_t nSlot, gamedata_t *gd )
 {
 	const ngd_file_t *data;
-	
+
 	data = m_pArchiveCache[ nSlot ];
 	if ( !data ) {
 		return false;
@@ -1227,39 +1764,508 @@ bool CGameArchive::LoadPartial( uint64_t nSlot, gamedata_t *gd )
 bool CGameArchive::Load( uint64_t nSlot )
 {
 	uint64_t i;
-	char szName[MAX_NPATH];
-	uint64_t offset;
 
-	Com_snprintf( szName, sizeof( szName ) - 1, "SLOT_%lu", nSlot );
+	if ( nSlot >= g_maxSaveSlots->i || !m_pArchiveCache[ nSlot ] ) {
+		N_Error( ERR_DROP, "CGameArchive::Load: invalid slot %lu", nSlot );
+	}
+
+	Con_Printf( "Loading save file '%s', please do not close out of the game...\n", m_pArchiveCache[ nSlot ]->name );
 
-	Con_Printf( "Loading save file '%s', please do not close out of the game...\n", szName );
+	// the slot might still be on its way to the disk
+	G_WaitSaveWriter();
 
 	m_nCurrentArchive = nSlot;
-	if ( !m_pArchiveCache[ nSlot ] || nSlot > g_maxSaveSlots->i ) {
-		N_Error( ERR_DROP, "CGameArchive::Load: couldn't invalid slot" );
+	G_FreeIndex( &m_Index );
+	if ( !OpenArchive( m_pArchiveCache[ nSlot ]->path, &m_Index ) ) {
+		N_Error( ERR_DROP, "CGameArchive::Load: failed to load save file '%s'", m_pArchiveCache[ nSlot ]->name );
 	}
 
-	for ( i = 0; i < m_pArchiveCache[ m_nCurrentArchive ]->m_nSections; i++ ) {
-		Con_DPrintf( "%lu: %-24s %-8i\n", i, m_pArchiveCache[ m_nCurrentArchive ]->m_pSectionList[i].name,
-			m_pArchiveCache[ m_nCurrentArchive ]->m_pSectionList[i].size );
+	for ( i = 0; i < m_Index.m_nSections; i++ ) {
+		Con_DPrintf( "%lu: %-24s %-8u\n", i, m_Index.m_pStrings + m_Index.m_pSections[i].nameOffset,
+			m_Index.m_pSections[i].numFields );
 	}
 
 	CModuleInfo *loadList = g_pModuleLib->GetLoadList();
 
-	m_hFile = FS_FOpenRead( va( "gamedata/SaveData/%s.ngd", szName ) );
-	if ( m_hFile == FS_INVALID_HANDLE ) {
-		N_Error( ERR_DROP, "CGameArchive::Load: failed to open save file '%s'", szName );
+	for ( i = 0; i < g_pModuleLib->GetModCount(); i++ ) {
+		g_pModuleLib->ModuleCall( &loadList[i], ModuleOnLoadGame, 0 );
+	}
+	G_FreeIndex( &m_Index );
+
+	return true;
+}
+
+/*
+* CGameArchive::SaveSnapshot: a save that never touches the disk, the index comes back uncompressed
+* with its header in front, the demo keyframes are made out of these
+*/
+byte *CGameArchive::SaveSnapshot( uint64_t *nLength )
+{
+	ngdindexheader_t header;
+	gamedata_t gd;
+	uint64_t indexSize;
+	byte *index, *snapshot;
+
+	PROFILE_FUNCTION();
+
+	index = BuildSave( &header, &gd, &indexSize );
+	header.compression = COMPRESS_NONE;
+	header.compressedSize = indexSize;
+	header.checksum = crc32_buffer( index, indexSize );
+
+	*nLength = sizeof( header ) + indexSize;
+	snapshot = (byte *)Z_Malloc( *nLength, TAG_SAVEFILE );
+	memcpy( snapshot, &header, sizeof( header ) );
+	memcpy( snapshot + sizeof( header ), index, indexSize );
+	Z_Free( index );
+
+	return snapshot;
+}
+
+/*
+* CGameArchive::LoadSnapshot: hands a snapshot from SaveSnapshot to the modules the same way Load does
+*/
+bool CGameArchive::LoadSnapshot( const byte *pBuffer, uint64_t nLength )
+{
+	ngdvalidation_t validation;
+	uint64_t i;
+
+	PROFILE_FUNCTION();
+
+	if ( nLength < sizeof( validation ) ) {
+		Con_Printf( COLOR_RED "ERROR: CGameArchive::LoadSnapshot: snapshot is truncated\n" );
+		return false;
+	}
+	memcpy( &validation, pBuffer, sizeof( validation ) );
+	G_SwapValidation( &validation );
+	if ( validation.ident != IDENT_INDEXED || !ValidateHeader( &validation ) ) {
+		Con_Printf( COLOR_RED "ERROR: CGameArchive::LoadSnapshot: not a snapshot\n" );
+		return false;
+	}
+
+	G_WaitSaveWriter();
+
+	G_FreeIndex( &m_Index );
+	if ( !G_LoadIndexedArchive( &m_Index, pBuffer, nLength, "snapshot" ) ) {
+		return false;
 	}
 
-	offset = 0;
-	offset += SIZEOF_HEADER;
-	offset += m_pArchiveCache[ m_nCurrentArchive ]->m_nMods * SIZEOF_MOD_METADATA;
+	CModuleInfo *loadList = g_pModuleLib->GetLoadList();
 
-	FS_FileSeek( m_hFile, offset, FS_SEEK_SET );
 	for ( i = 0; i < g_pModuleLib->GetModCount(); i++ ) {
 		g_pModuleLib->ModuleCall( &loadList[i], ModuleOnLoadGame, 0 );
 	}
-	FS_FClose( m_hFile );
+	G_FreeIndex( &m_Index );
 
 	return true;
-}
\ No newline at end of file
+}
+
+/*
+===============================================================
+
+TESTS
+
+===============================================================
+*/
+
+#define SAVETEST_PATH			"SaveData/savetest.ngd"
+#define SAVETEST_LEGACY_PATH	"SaveData/savetest_v1.ngd"
+
+/*
+* G_WriteLegacyArchive: writes what's in the builder the way the old save code did, field by field,
+* only here so the v1 loader has something to be checked against
+*/
+static qboolean G_WriteLegacyArchive( const char *path, const ngdbuilder_t *builder )
+{
+	const ngdsection_t *section;
+	const ngdfield_t *field;
+	const char *name;
+	ngdvalidation_t validation;
+	byte gamedata[ SIZEOF_GAMEDATA ];
+	fileHandle_t hFile;
+	int64_t numSections;
+	int32_t nameLength, numFields;
+	uint32_t i, j;
+
+	hFile = FS_FOpenWrite( path );
+	if ( hFile == FS_INVALID_HANDLE ) {
+		return qfalse;
+	}
+
+	validation.ident = IDENT;
+	validation.version.m_nVersionMajor = NOMAD_VERSION;
+	validation.version.m_nVersionUpdate = NOMAD_VERSION_UPDATE;
+	validation.version.m_nVersionPatch = NOMAD_VERSION_PATCH;
+	numSections = builder->nNumSections;
+	memset( gamedata, 0, sizeof( gamedata ) );
+
+	FS_Write( &validation, sizeof( validation ), hFile );
+	FS_Write( &numSections, sizeof( numSections ), hFile );
+	FS_Write( gamedata, sizeof( gamedata ), hFile );
+
+	for ( i = 0; i < builder->nNumSections; i++ ) {
+		section = (const ngdsection_t *)builder->sections.pData + i;
+		name = (const char *)builder->strings.pData + section->nameOffset;
+		nameLength = strlen( name ) + 1;
+		numFields = section->numFields;
+
+		FS_Write( &nameLength, sizeof( nameLength ), hFile );
+		FS_Write( name, nameLength, hFile );
+		FS_Write( &numFields, sizeof( numFields ), hFile );
+
+		for ( j = 0; j < section->numFields; j++ ) {
+			field = (const ngdfield_t *)builder->fields.pData + section->firstField + j;
+			name = (const char *)builder->strings.pData + field->nameOffset;
+			nameLength = strlen( name ) + 1;
+
+			FS_Write( &nameLength, sizeof( nameLength ), hFile );
+			FS_Write( name, nameLength, hFile );
+			FS_Write( &field->type, sizeof( field->type ), hFile );
+			if ( field->type == FT_STRING || field->type == FT_ARRAY ) {
+				FS_Write( &field->dataSize, sizeof( field->dataSize ), hFile );
+			}
+			FS_Write( builder->data.pData + field->dataOffset, field->dataSize, hFile );
+		}
+	}
+	FS_FClose( hFile );
+
+	return qtrue;
+}
+
+static void G_SaveTestCheck( qboolean ok, const char *what, const char *path, qboolean *passed )
+{
+	if ( !ok ) {
+		Con_Printf( COLOR_RED "sgame.save_test: %s: %s\n", path, what );
+		*passed = qfalse;
+	}
+}
+
+/*
+* G_CheckTestArchive: reads back everything CGameArchive::RunSaveTest saved through the same calls
+* the modules use
+*/
+static void G_CheckTestArchive( CGameArchive *archive, const char *path, qboolean *passed )
+{
+	const vec2_t v2 = { 1.5f, -2.5f };
+	const vec3_t v3 = { 0.1f, 0.2f, 0.3f };
+	const vec4_t v4 = { -1.0f, 1e-8f, 1e8f, 0.0f };
+	vec2_t l2;
+	vec3_t l3;
+	vec4_t l4;
+	char buffer[ 64 ];
+	string_t str;
+	nhandle_t hSection, hSection2;
+
+	hSection = archive->GetSection( "TestSection" );
+	hSection2 = archive->GetSection( "test.section2" );
+	G_SaveTestCheck( hSection != -1 && hSection2 != -1 && hSection != hSection2, "missing sections", path, passed );
+	if ( hSection == -1 || hSection2 == -1 ) {
+		return;
+	}
+
+	G_SaveTestCheck( archive->LoadChar( "char", hSection ) == -12, "char", path, passed );
+	G_SaveTestCheck( archive->LoadShort( "short", hSection ) == -1234, "short", path, passed );
+	G_SaveTestCheck( archive->LoadInt( "int", hSection ) == -123456, "int", path, passed );
+	G_SaveTestCheck( archive->LoadLong( "long", hSection ) == -1234567890123LL, "long", path, passed );
+	G_SaveTestCheck( archive->LoadByte( "byte", hSection ) == 250, "byte", path, passed );
+	G_SaveTestCheck( archive->LoadUShort( "ushort", hSection ) == 65000, "ushort", path, passed );
+	G_SaveTestCheck( archive->LoadUInt( "uint", hSection ) == 4000000000u, "uint", path, passed );
+	G_SaveTestCheck( archive->LoadULong( "ulong", hSection ) == 0xfedcba9876543210ULL, "ulong", path, passed );
+	G_SaveTestCheck( archive->LoadFloat( "float", hSection ) == 3.25f, "float", path, passed );
+
+	archive->LoadVec2( "vec2", l2, hSection );
+	archive->LoadVec3( "vec3", l3, hSection );
+	archive->LoadVec4( "vec4", l4, hSection );
+	G_SaveTestCheck( !memcmp( l2, v2, sizeof( l2 ) ) && !memcmp( l3, v3, sizeof( l3 ) ) && !memcmp( l4, v4, sizeof( l4 ) ),
+		"vectors", path, passed );
+
+	// lookups ignore case and names with dots in them don't get mixed up
+	archive->LoadCString( "Player.Name", buffer, sizeof( buffer ), hSection );
+	G_SaveTestCheck( !strcmp( buffer, "nomad" ), "player.name", path, passed );
+	archive->LoadCString( "player.class", buffer, 4, hSection );
+	G_SaveTestCheck( !strcmp( buffer, "mer" ), "truncated player.class", path, passed );
+	archive->LoadString( "string", &str, hSection );
+	G_SaveTestCheck( !strcmp( str.c_str(), "a string_t" ) && str.size() == strlen( "a string_t" ), "string", path, passed );
+
+	// the same name in another section is another field
+	G_SaveTestCheck( archive->LoadInt( "int", hSection2 ) == 7, "int in the second section", path, passed );
+	G_SaveTestCheck( archive->LoadInt( "missing", hSection2 ) == 0, "missing field", path, passed );
+}
+
+void CGameArchive::RunSaveTest( void )
+{
+	const vec2_t v2 = { 1.5f, -2.5f };
+	const vec3_t v3 = { 0.1f, 0.2f, 0.3f };
+	const vec4_t v4 = { -1.0f, 1e-8f, 1e8f, 0.0f };
+	const char *paths[] = { SAVETEST_PATH, SAVETEST_LEGACY_PATH };
+	ngdindexheader_t header;
+	ngdindex_t saved;
+	const ngdfield_t *field;
+	string_t str( "a string_t" );
+	int32_t array[ 16 ], loaded[ 16 ];
+	uint64_t indexSize, size;
+	byte *index, *buffer;
+	fileHandle_t hFile;
+	qboolean passed;
+	uint32_t i;
+
+	if ( m_nSectionDepth ) {
+		Con_Printf( "sgame.save_test: can't run in the middle of a save\n" );
+		return;
+	}
+
+	G_WaitSaveWriter();
+	saved = m_Index;
+	passed = qtrue;
+
+	for ( i = 0; i < arraylen( array ); i++ ) {
+		array[i] = i * i - 100;
+	}
+
+	G_ResetIndexBuilder( &g_indexBuilder );
+	m_nSections = 0;
+
+	BeginSaveSection( "sgame", "TestSection" );
+	SaveChar( "char", -12 );
+	SaveShort( "short", -1234 );
+	SaveInt( "int", -123456 );
+	SaveLong( "long", -1234567890123LL );
+	SaveByte( "byte", 250 );
+	SaveUShort( "ushort", 65000 );
+	SaveUInt( "uint", 4000000000u );
+	SaveULong( "ulong", 0xfedcba9876543210ULL );
+	SaveFloat( "float", 3.25f );
+	SaveVec2( "vec2", v2 );
+	SaveVec3( "vec3", v3 );
+	SaveVec4( "vec4", v4 );
+	SaveCString( "player.name", "nomad" );
+	SaveCString( "player.class", "mercenary" );
+	SaveString( "string", &str );
+	EndSaveSection();
+
+	BeginSaveSection( "sgame", "Test.Section2" );
+	SaveInt( "int", 7 );
+	SaveArray( __func__, "array", array, sizeof( array ) );
+	EndSaveSection();
+
+	memset( &header, 0, sizeof( header ) );
+	header.validation.ident = IDENT_INDEXED;
+	header.validation.version.m_nVersionMajor = NOMAD_VERSION;
+	header.validation.version.m_nVersionUpdate = NOMAD_VERSION_UPDATE;
+	header.validation.version.m_nVersionPatch = NOMAD_VERSION_PATCH;
+	index = G_BuildIndex( &g_indexBuilder, &header, &indexSize );
+
+	G_SaveTestCheck( G_WriteLegacyArchive( SAVETEST_LEGACY_PATH, &g_indexBuilder ), "couldn't write", SAVETEST_LEGACY_PATH, &passed );
+	G_StartSaveWriter( SAVETEST_PATH, &header, index, indexSize );
+	G_SaveTestCheck( G_WaitSaveWriter(), "couldn't write", SAVETEST_PATH, &passed );
+
+	// round trip through both formats
+	for ( i = 0; i < arraylen( paths ); i++ ) {
+		if ( !OpenArchive( paths[i], &m_Index ) ) {
+			G_SaveTestCheck( qfalse, "couldn't load", paths[i], &passed );
+			continue;
+		}
+		G_CheckTestArchive( this, paths[i], &passed );
+
+		field = FindField( "array", FT_ARRAY, GetSection( "Test.Section2" ) );
+		if ( field && field->dataSize == sizeof( loaded ) ) {
+			ReadField( field, loaded );
+		}
+		G_SaveTestCheck( field && field->dataSize == sizeof( loaded ) && !memcmp( loaded, array, sizeof( array ) ), "array",
+			paths[i], &passed );
+
+		G_FreeIndex( &m_Index );
+	}
+
+	// a damaged or cut off save has to be refused instead of handed to the modules
+	size = FS_LoadFile( SAVETEST_PATH, (void **)&buffer );
+	if ( buffer ) {
+		hFile = FS_FOpenWrite( SAVETEST_PATH );
+		if ( hFile != FS_INVALID_HANDLE ) {
+			buffer[ sizeof( ngdindexheader_t ) + ( size - sizeof( ngdindexheader_t ) ) / 2 ] ^= 0x5a;
+			FS_Write( buffer, size, hFile );
+			FS_FClose( hFile );
+			G_SaveTestCheck( !OpenArchive( SAVETEST_PATH, &m_Index ), "accepted a corrupt file", SAVETEST_PATH, &passed );
+			G_FreeIndex( &m_Index );
+		}
+		hFile = FS_FOpenWrite( SAVETEST_PATH );
+		if ( hFile != FS_INVALID_HANDLE ) {
+			FS_Write( buffer, size - 1, hFile );
+			FS_FClose( hFile );
+			G_SaveTestCheck( !OpenArchive( SAVETEST_PATH, &m_Index ), "accepted a truncated file", SAVETEST_PATH, &passed );
+			G_FreeIndex( &m_Index );
+		}
+		FS_FreeFile( buffer );
+	}
+
+	FS_HomeRemove( SAVETEST_PATH );
+	FS_HomeRemove( SAVETEST_LEGACY_PATH );
+	m_Index = saved;
+	m_nSections = 0;
+
+	Con_Printf( "sgame.save_test: %s, %u fields in %u sections, %lu byte index\n", passed ? "passed" : "FAILED",
+		header.numFields, header.numSections, indexSize );
+}
+
+/*
+* G_LinearFindField: what CGameArchive::FindField used to do minus the seek, walks the whole section
+*/
+static const ngdfield_t *G_LinearFindField( const ngdindex_t *index, const ngdsection_t *section, const char *name )
+{
+	uint32_t i;
+
+	for ( i = 0; i < section->numFields; i++ ) {
+		if ( !N_stricmp( index->m_pStrings + index->m_pFields[ section->firstField + i ].nameOffset, name ) ) {
+			return &index->m_pFields[ section->firstField + i ];
+		}
+	}
+	return NULL;
+}
+
+void CGameArchive::RunSaveBench( uint32_t nFields )
+{
+	char name[ MAX_SAVE_FIELD_NAME ];
+	char sectionName[ MAX_SAVE_SECTION_NAME ];
+	const ngdsection_t *section;
+	const ngdfield_t *field;
+	const char *fieldName;
+	CModuleInfo *loadList;
+	ngdindexheader_t header;
+	ngdindex_t saved;
+	uint64_t start, buildTime, handoffTime, legacyWriteTime, loadTime, legacyLoadTime, hashTime, linearTime;
+	uint64_t indexSize;
+	uint32_t numSections, hashFound, linearFound, i, j;
+	vec3_t v;
+	byte *index;
+
+	if ( m_nSectionDepth ) {
+		Con_Printf( "sgame.save_bench: can't run in the middle of a save\n" );
+		return;
+	}
+
+	G_WaitSaveWriter();
+	saved = m_Index;
+
+	// spread the fields over every module like a real save would
+	loadList = g_pModuleLib ? g_pModuleLib->GetLoadList() : NULL;
+	numSections = g_pModuleLib ? g_pModuleLib->GetModCount() : 0;
+	if ( !numSections ) {
+		numSections = 8;
+	}
+
+	//
+	// what the frame that saves pays for
+	//
+	start = Sys_Microseconds();
+	G_ResetIndexBuilder( &g_indexBuilder );
+	m_nSections = 0;
+	for ( i = 0; i < numSections; i++ ) {
+		if ( loadList ) {
+			N_strncpyz( sectionName, loadList[i].m_szName, sizeof( sectionName ) );
+		} else {
+			Com_snprintf( sectionName, sizeof( sectionName ), "module_%u", i );
+		}
+
+		BeginSaveSection( sectionName, sectionName );
+		for ( j = i; j < nFields; j += numSections ) {
+			Com_snprintf( name, sizeof( name ), "%s.field_%u", sectionName, j );
+			switch ( j & 3 ) {
+			case 0:
+				SaveInt( name, j );
+				break;
+			case 1:
+				SaveFloat( name, j * 0.5f );
+				break;
+			case 2:
+				VectorSet( v, j, j + 1, j + 2 );
+				SaveVec3( name, v );
+				break;
+			case 3:
+				SaveCString( name, va( "value %u", j ) );
+				break;
+			};
+		}
+		EndSaveSection();
+	}
+
+	memset( &header, 0, sizeof( header ) );
+	header.validation.ident = IDENT_INDEXED;
+	header.validation.version.m_nVersionMajor = NOMAD_VERSION;
+	header.validation.version.m_nVersionUpdate = NOMAD_VERSION_UPDATE;
+	header.validation.version.m_nVersionPatch = NOMAD_VERSION_PATCH;
+	index = G_BuildIndex( &g_indexBuilder, &header, &indexSize );
+	buildTime = Sys_Microseconds() - start;
+
+	start = Sys_Microseconds();
+	G_WriteLegacyArchive( SAVETEST_LEGACY_PATH, &g_indexBuilder );
+	legacyWriteTime = Sys_Microseconds() - start;
+
+	start = Sys_Microseconds();
+	G_StartSaveWriter( SAVETEST_PATH, &header, index, indexSize );
+	handoffTime = Sys_Microseconds() - start;
+	if ( !G_WaitSaveWriter() ) {
+		Con_Printf( "sgame.save_bench: couldn't write %s\n", SAVETEST_PATH );
+		FS_HomeRemove( SAVETEST_LEGACY_PATH );
+		m_nSections = 0;
+		return;
+	}
+
+	//
+	// loading
+	//
+	start = Sys_Microseconds();
+	OpenArchive( SAVETEST_LEGACY_PATH, &m_Index );
+	legacyLoadTime = Sys_Microseconds() - start;
+	G_FreeIndex( &m_Index );
+
+	start = Sys_Microseconds();
+	if ( !OpenArchive( SAVETEST_PATH, &m_Index ) ) {
+		Con_Printf( "sgame.save_bench: couldn't load %s\n", SAVETEST_PATH );
+		FS_HomeRemove( SAVETEST_PATH );
+		FS_HomeRemove( SAVETEST_LEGACY_PATH );
+		m_Index = saved;
+		m_nSections = 0;
+		return;
+	}
+	loadTime = Sys_Microseconds() - start;
+
+	//
+	// every field looked up once each way
+	//
+	linearFound = 0;
+	start = Sys_Microseconds();
+	for ( i = 0; i < m_Index.m_nSections; i++ ) {
+		section = &m_Index.m_pSections[i];
+		for ( j = 0; j < section->numFields; j++ ) {
+			fieldName = m_Index.m_pStrings + m_Index.m_pFields[ section->firstField + j ].nameOffset;
+			linearFound += G_LinearFindField( &m_Index, section, fieldName ) != NULL;
+		}
+	}
+	linearTime = Sys_Microseconds() - start;
+
+	hashFound = 0;
+	start = Sys_Microseconds();
+	for ( i = 0; i < m_Index.m_nSections; i++ ) {
+		section = &m_Index.m_pSections[i];
+		for ( j = 0; j < section->numFields; j++ ) {
+			field = &m_Index.m_pFields[ section->firstField + j ];
+			hashFound += FindField( m_Index.m_pStrings + field->nameOffset, field->type, i ) != NULL;
+		}
+	}
+	hashTime = Sys_Microseconds() - start;
+
+	Con_Printf( "sgame.save_bench: %u fields in %u sections, %lu byte index, %lu bytes on disk\n", header.numFields,
+		header.numSections, indexSize, g_saveWriter.nFileSize );
+	Con_Printf( "save: %lu usec to build, %lu usec to hand off, %lu usec compressing and writing on the worker\n",
+		buildTime, handoffTime, g_saveWriter.writeTime.load( std::memory_order_relaxed ) );
+	Con_Printf( "save (v1): %lu usec writing field by field\n", legacyWriteTime );
+	Con_Printf( "load: %lu usec, %lu usec for the same save in v1\n", loadTime, legacyLoadTime );
+	Con_Printf( "lookup: %lu usec hashed (%u found), %lu usec linear (%u found)\n", hashTime, hashFound,
+		linearTime, linearFound );
+
+	G_FreeIndex( &m_Index );
+	FS_HomeRemove( SAVETEST_PATH );
+	FS_HomeRemove( SAVETEST_LEGACY_PATH );
+	m_Index = saved;
+	m_nSections = 0;
+}
@@ -41,29 +41,23 @@ typedef struct {
 } gamedata_t;
 
 #pragma pack( push, 1 )
+// a field record in the index, the name and the data live in the index's string pool and data block
 typedef struct {
-	char *name;
-	int32_t nameLength;
+	uint32_t hash;
+	uint32_t nameOffset;
 	int32_t type;
-	int32_t dataSize;
-	int32_t dataOffset;
-	union {
-		int8_t s8;
-		int16_t s16;
-		int32_t s32;
-		int64_t s64;
-		uint8_t u8;
-		uint16_t u16;
-		uint32_t u32;
-		uint64_t u64;
-		float f;
-		char *str;
-		vec2_t v2;
-		vec3_t v3;
-		vec4_t v4;
-	} data;
+	uint32_t dataSize;
+	uint32_t dataOffset;
 } ngdfield_t;
 
+typedef struct {
+	uint32_t nameOffset;
+	uint32_t firstField;
+	uint32_t numFields;
+	uint32_t firstBucket;
+	uint32_t numBuckets; // power of two, each bucket holds a field number + 1 or 0 when it's empty
+} ngdsection_t;
+
 // version, 64 bits
 typedef union version_s {
 	struct {
@@ -85,6 +79,28 @@ typedef struct {
 	int32_t ident;
 	version_t version;
 } ngdvalidation_t;
+
+// the only part of a v2 save that isn't compressed, it's all the slot list ever has to read
+typedef struct {
+	ngdvalidation_t validation;
+
+	int32_t mapIndex;
+	int32_t highestDif;
+	int32_t saveDif;
+	uint32_t playTimeHours;
+	uint32_t playTimeMinutes;
+	uint64_t numMods;
+
+	int32_t compression;
+	uint32_t compressedSize;
+	uint32_t checksum;
+
+	uint32_t numSections;
+	uint32_t numBuckets;
+	uint32_t numFields;
+	uint32_t stringsSize;
+	uint32_t dataSize;
+} ngdindexheader_t;
 #pragma pack( pop )
 
 typedef struct {
@@ -98,7 +114,6 @@ typedef struct {
 	char name[MAX_SAVE_FIELD_NAME];
 	int32_t nameLength;
 	int32_t numFields;
-	uint32_t offset;
 #ifdef SAVEFILE_MOD_SAFETY
 	fileHandle_t hFile;
 	const char *m_pModuleName;
@@ -108,25 +123,33 @@ typedef struct {
 template<typename Key, typename Value>
 using ArchiveCache = eastl::unordered_map<Key, Value, eastl::hash<Key>, eastl::equal_to<Key>, CHunkAllocator<h_low>, true>;
 
-typedef struct ngdsection_read_s {
-	char name[MAX_SAVE_FIELD_NAME];
-	int32_t nameLength;
-	int32_t size;
-	int32_t numFields;
-	
-   ngdfield_t **m_pFieldCache;
-} ngdsection_read_t;
-
 typedef struct {
 	char name[MAX_NPATH];
+	char path[MAX_NPATH];
 	
 	gamedata_t gd;
 	
 	int64_t m_nSections;
 	uint64_t m_nMods;
-	ngdsection_read_t *m_pSectionList;
 } ngd_file_t;
 
+// a save file loaded into memory, v1 saves are converted into the same layout when they're loaded
+typedef struct {
+	byte *m_pBuffer;
+
+	const ngdsection_t *m_pSections;
+	const uint32_t *m_pBuckets;
+	const ngdfield_t *m_pFields;
+	const char *m_pStrings;
+	const byte *m_pData;
+
+	uint32_t m_nSections;
+	uint32_t m_nBuckets;
+	uint32_t m_nFields;
+	uint32_t m_nStringsSize;
+	uint32_t m_nDataSize;
+} ngdindex_t;
+
 class CGameArchive
 {
 public:
@@ -186,21 +209,30 @@ public:
 	bool Save( uint64_t nSlot );
 	bool LoadPartial( uint64_t nSlot, gamedata_t *gd );
 
+	byte *SaveSnapshot( uint64_t *nLength );
+	bool LoadSnapshot( const byte *pBuffer, uint64_t nLength );
+
 	nhandle_t GetSection( const char *name );
 
 	void InitCache( void );
 
+	void RunSaveTest( void );
+	void RunSaveBench( uint32_t nFields );
+
 	friend void G_InitArchiveHandler( void );
 	friend void G_ShutdownArchiveHandler( void );
 private:
 	void SaveArray( const char *func, const char *name, const void *pData, uint32_t nBytes );
 
 	void AddField( const char *name, int32_t type, const void *data, uint32_t dataSize );
+	byte *BuildSave( ngdindexheader_t *header, gamedata_t *gd, uint64_t *indexSize );
 	bool ValidateHeader( const void *header ) const;
 	qboolean LoadArchiveFile( const char *filename, uint64_t index );
+	qboolean OpenArchive( const char *filename, ngdindex_t *index ) const;
 	const ngdfield_t *FindField( const char *name, int32_t type, nhandle_t hSection ) const;
+	void ReadField( const ngdfield_t *field, void *pBuffer ) const;
 
-	fileHandle_t m_hFile;
+	ngdindex_t m_Index;
 	
 	int64_t m_nSections;
 	int64_t m_nSectionDepth;
@@ -0,0 +1,1432 @@
+// g_demo.cpp -- demo recording and playback, frames get packed into blocks that are compressed and written
+// in one go, with a save game snapshot every so often so a demo can be seeked
+
+#include "g_game.h"
+#include "g_archive.h"
+#include <lz4.h>
+#include <glm/gtc/type_ptr.hpp>
+
+#define DEMO_IDENT (('2'<<24)+('m'<<16)+('d'<<8)+'n')
+#define DEMO_VERSION 2
+
+// frames are written out once a block gets this big, it's about all the memory a recording holds on to
+#define DEMO_BLOCK_SIZE ( 64 * 1024 )
+
+// nothing the recorder writes comes close to these, anything bigger is a damaged file
+#define DEMO_MAX_BLOCK_SIZE ( 256 * 1024 * 1024 )
+#define DEMO_MAX_INFO_SIZE ( 1024 * 1024 )
+
+/*
+
+.dmne demo file layout (v2):
+
+demoHeader_t followed by infoSize bytes of demo info,
+	int32		length, char referencedBffs[ length ]
+	int32		numLines, { int32 length, char line[ length ] } * numLines
+	int32		difficulty
+	char		mapname[ 64 ]
+	int32		cheats[ 7 ]
+
+then blocks until the end of the file, each one is a demoBlock_t and compressedSize bytes of
+
+DEMO_BLOCK_FRAMES		numFrames * { demoFrame_t, numEvents * { demoEvent_t, evPtrLength bytes } }
+DEMO_BLOCK_KEYFRAME		demoKeyframe_t, snapshotSize bytes from CGameArchive::SaveSnapshot
+
+the first block is always a keyframe taken when the recording started, playback restores it and
+demo_seek goes back to the last keyframe before the requested time and runs the frames up to it
+without waiting
+
+a frame is everything the engine handed the game for one G_Frame, the events that went through
+Com_EventLoop and the msec, playing those back in the same order is what makes playback deterministic
+
+*/
+
+enum {
+	DEMO_BLOCK_FRAMES,
+	DEMO_BLOCK_KEYFRAME
+};
+
+typedef struct {
+	int32_t ident;
+	int32_t demoVersion;
+	version_t version;
+	uint32_t infoSize;
+} demoHeader_t;
+
+typedef struct {
+	uint32_t type;
+	uint32_t time;				// demo time at the start of the block
+	uint32_t endTime;			// and after its last frame
+	uint32_t numFrames;
+	uint32_t compression;
+	uint32_t size;
+	uint32_t compressedSize;
+	uint32_t checksum;			// crc of the uncompressed block
+} demoBlock_t;
+
+typedef struct {
+	uint32_t msec;
+	float cameraPos[3];
+	float cameraZoom;
+	uint32_t numEvents;
+} demoFrame_t;
+
+typedef struct {
+	uint32_t evTime;
+	uint32_t evType;
+	uint32_t evValue;
+	uint32_t evValue2;
+	uint32_t evPtrLength;
+} demoEvent_t;
+
+typedef struct {
+	int32_t realtime;
+	float cameraPos[3];
+	float cameraZoom;
+	uint32_t snapshotSize;
+} demoKeyframe_t;
+
+typedef struct {
+	byte *pData;
+	uint64_t nUsed;
+	uint64_t nSize;
+} demoBuffer_t;
+
+typedef struct {
+	fileHandle_t hFile;
+
+	demoBuffer_t block;			// frames that haven't been written yet
+	demoBuffer_t events;		// events since the last frame
+	demoBuffer_t packed;		// block header and the compressed block, what actually goes to the file
+
+	uint32_t numEvents;
+	uint32_t numFrames;
+	uint32_t blockTime;
+	uint32_t time;
+	uint32_t keyframeTime;
+
+	uint64_t fileSize;
+	uint64_t dataSize;
+	uint32_t numBlocks;
+	uint32_t numKeyframes;
+	qboolean failed;
+} demoWriter_t;
+
+typedef struct {
+	uint32_t time;
+	uint64_t offset;
+} demoKeyframeInfo_t;
+
+typedef struct {
+	fileHandle_t hFile;
+	uint64_t offset;
+	uint64_t fileSize;
+	uint64_t firstBlock;
+
+	demoBuffer_t packed;
+	demoBuffer_t block;
+	uint64_t blockPos;
+	uint32_t framesLeft;
+
+	// the next frame, peeked so the pacer knows how long it is before it runs
+	demoFrame_t frame;
+	const byte *pEvents;
+	qboolean framePending;
+
+	uint32_t time;				// demo time the next frame starts at
+	uint32_t length;
+
+	demoKeyframeInfo_t *pKeyframes;
+	uint32_t numKeyframes;
+} demoReader_t;
+
+static demoWriter_t g_demoWriter;
+static demoReader_t g_demoReader;
+
+// when seeking, frames are run without waiting until the reader gets here
+static uint32_t g_demoSeekTime;
+
+static cvar_t *g_demoSpeed;
+static cvar_t *g_demoKeyframeInterval;
+
+static void G_ReserveDemoBuffer( demoBuffer_t *buffer, uint64_t size )
+{
+	if ( size > buffer->nSize ) {
+		buffer->nSize = PAD( MAX( size, buffer->nSize * 2 ), 4096 );
+		buffer->pData = (byte *)Z_Realloc( buffer->pData, buffer->nSize, TAG_GAME );
+	}
+}
+
+static void G_AppendDemoBuffer( demoBuffer_t *buffer, const void *data, uint64_t size )
+{
+	G_ReserveDemoBuffer( buffer, buffer->nUsed + size );
+	if ( size ) {
+		memcpy( buffer->pData + buffer->nUsed, data, size );
+	}
+	buffer->nUsed += size;
+}
+
+static void G_FreeDemoBuffer( demoBuffer_t *buffer )
+{
+	if ( buffer->pData ) {
+		Z_Free( buffer->pData );
+	}
+	memset( buffer, 0, sizeof( *buffer ) );
+}
+
+static void G_SwapDemoBlock( demoBlock_t *block )
+{
+	block->type = LittleInt( block->type );
+	block->time = LittleInt( block->time );
+	block->endTime = LittleInt( block->endTime );
+	block->numFrames = LittleInt( block->numFrames );
+	block->compression = LittleInt( block->compression );
+	block->size = LittleInt( block->size );
+	block->compressedSize = LittleInt( block->compressedSize );
+	block->checksum = LittleInt( block->checksum );
+}
+
+static void G_SwapDemoFrame( demoFrame_t *frame )
+{
+	frame->msec = LittleInt( frame->msec );
+	frame->cameraPos[0] = LittleFloat( frame->cameraPos[0] );
+	frame->cameraPos[1] = LittleFloat( frame->cameraPos[1] );
+	frame->cameraPos[2] = LittleFloat( frame->cameraPos[2] );
+	frame->cameraZoom = LittleFloat( frame->cameraZoom );
+	frame->numEvents = LittleInt( frame->numEvents );
+}
+
+static void G_SwapDemoEvent( demoEvent_t *ev )
+{
+	ev->evTime = LittleInt( ev->evTime );
+	ev->evType = LittleInt( ev->evType );
+	ev->evValue = LittleInt( ev->evValue );
+	ev->evValue2 = LittleInt( ev->evValue2 );
+	ev->evPtrLength = LittleInt( ev->evPtrLength );
+}
+
+static void G_SwapDemoKeyframe( demoKeyframe_t *keyframe )
+{
+	keyframe->realtime = LittleInt( keyframe->realtime );
+	keyframe->cameraPos[0] = LittleFloat( keyframe->cameraPos[0] );
+	keyframe->cameraPos[1] = LittleFloat( keyframe->cameraPos[1] );
+	keyframe->cameraPos[2] = LittleFloat( keyframe->cameraPos[2] );
+	keyframe->cameraZoom = LittleFloat( keyframe->cameraZoom );
+	keyframe->snapshotSize = LittleInt( keyframe->snapshotSize );
+}
+
+/*
+===============================================================
+
+WRITING
+
+===============================================================
+*/
+
+static uint64_t G_DemoWriterMemory( const demoWriter_t *writer )
+{
+	return writer->block.nSize + writer->events.nSize + writer->packed.nSize;
+}
+
+/*
+* G_FlushDemoBlock: compresses whatever is in the block and writes it with its header in a single write,
+* stores it as is if lz4 can't make it any smaller
+*/
+static void G_FlushDemoBlock( demoWriter_t *writer, uint32_t type )
+{
+	demoBlock_t header;
+	int compressedSize;
+	uint64_t length;
+
+	if ( type == DEMO_BLOCK_FRAMES && !writer->numFrames ) {
+		return;
+	}
+	if ( writer->block.nUsed > DEMO_MAX_BLOCK_SIZE ) {
+		N_Error( ERR_DROP, "G_FlushDemoBlock: block is larger than %i bytes", DEMO_MAX_BLOCK_SIZE );
+	}
+
+	G_ReserveDemoBuffer( &writer->packed, sizeof( header ) + LZ4_compressBound( (int)writer->block.nUsed ) );
+
+	compressedSize = LZ4_compress_default( (const char *)writer->block.pData, (char *)( writer->packed.pData + sizeof( header ) ),
+		(int)writer->block.nUsed, LZ4_compressBound( (int)writer->block.nUsed ) );
+
+	memset( &header, 0, sizeof( header ) );
+	if ( compressedSize > 0 && (uint64_t)compressedSize < writer->block.nUsed ) {
+		header.compression = COMPRESS_LZ4;
+		header.compressedSize = compressedSize;
+	} else {
+		header.compression = COMPRESS_NONE;
+		header.compressedSize = writer->block.nUsed;
+		memcpy( writer->packed.pData + sizeof( header ), writer->block.pData, writer->block.nUsed );
+	}
+	header.type = type;
+	header.time = writer->blockTime;
+	header.endTime = writer->time;
+	header.numFrames = writer->numFrames;
+	header.size = writer->block.nUsed;
+	header.checksum = crc32_buffer( writer->block.pData, writer->block.nUsed );
+
+	length = sizeof( header ) + header.compressedSize;
+	G_SwapDemoBlock( &header );
+	memcpy( writer->packed.pData, &header, sizeof( header ) );
+
+	if ( FS_Write( writer->packed.pData, length, writer->hFile ) != length && !writer->failed ) {
+		Con_Printf( COLOR_RED "ERROR: G_FlushDemoBlock: failed to write %lu bytes to the demo\n", length );
+		writer->failed = qtrue;
+	}
+
+	writer->fileSize += length;
+	writer->dataSize += writer->block.nUsed;
+	writer->numBlocks++;
+
+	writer->block.nUsed = 0;
+	writer->numFrames = 0;
+	writer->blockTime = writer->time;
+}
+
+static void G_BeginDemoWriter( demoWriter_t *writer, fileHandle_t hFile, const demoBuffer_t *info )
+{
+	demoHeader_t header;
+
+	writer->hFile = hFile;
+	writer->block.nUsed = 0;
+	writer->events.nUsed = 0;
+	writer->packed.nUsed = 0;
+	writer->numEvents = 0;
+	writer->numFrames = 0;
+	writer->blockTime = 0;
+	writer->time = 0;
+	writer->keyframeTime = 0;
+	writer->fileSize = 0;
+	writer->dataSize = 0;
+	writer->numBlocks = 0;
+	writer->numKeyframes = 0;
+	writer->failed = qfalse;
+
+	header.ident = LittleInt( DEMO_IDENT );
+	header.demoVersion = LittleInt( DEMO_VERSION );
+	header.version.m_nVersionMajor = LittleShort( NOMAD_VERSION );
+	header.version.m_nVersionUpdate = LittleShort( NOMAD_VERSION_UPDATE );
+	header.version.m_nVersionPatch = LittleInt( NOMAD_VERSION_PATCH );
+	header.infoSize = LittleInt( info->nUsed );
+
+	G_AppendDemoBuffer( &writer->packed, &header, sizeof( header ) );
+	G_AppendDemoBuffer( &writer->packed, info->pData, info->nUsed );
+	FS_Write( writer->packed.pData, writer->packed.nUsed, hFile );
+	writer->fileSize += writer->packed.nUsed;
+	writer->packed.nUsed = 0;
+}
+
+static void G_WriteDemoEvent( demoWriter_t *writer, const sysEvent_t *ev )
+{
+	demoEvent_t event;
+
+	event.evTime = ev->evTime;
+	event.evType = ev->evType;
+	event.evValue = ev->evValue;
+	event.evValue2 = ev->evValue2;
+	event.evPtrLength = ev->evPtr ? ev->evPtrLength : 0;
+	G_SwapDemoEvent( &event );
+
+	G_AppendDemoBuffer( &writer->events, &event, sizeof( event ) );
+	if ( ev->evPtr ) {
+		G_AppendDemoBuffer( &writer->events, ev->evPtr, ev->evPtrLength );
+	}
+	writer->numEvents++;
+}
+
+static void G_WriteDemoFrame( demoWriter_t *writer, uint32_t msec, const float *cameraPos, float cameraZoom )
+{
+	demoFrame_t frame;
+
+	frame.msec = msec;
+	VectorCopy( frame.cameraPos, cameraPos );
+	frame.cameraZoom = cameraZoom;
+	frame.numEvents = writer->numEvents;
+	G_SwapDemoFrame( &frame );
+
+	G_AppendDemoBuffer( &writer->block, &frame, sizeof( frame ) );
+	G_AppendDemoBuffer( &writer->block, writer->events.pData, writer->events.nUsed );
+	writer->events.nUsed = 0;
+	writer->numEvents = 0;
+
+	writer->numFrames++;
+	writer->time += msec;
+
+	if ( writer->block.nUsed >= DEMO_BLOCK_SIZE ) {
+		G_FlushDemoBlock( writer, DEMO_BLOCK_FRAMES );
+	}
+}
+
+static void G_WriteDemoKeyframe( demoWriter_t *writer, int32_t realtime, const float *cameraPos, float cameraZoom,
+	const byte *snapshot, uint64_t snapshotSize )
+{
+	demoKeyframe_t keyframe;
+
+	// the keyframe has to come after every frame that led up to it
+	G_FlushDemoBlock( writer, DEMO_BLOCK_FRAMES );
+
+	keyframe.realtime = realtime;
+	VectorCopy( keyframe.cameraPos, cameraPos );
+	keyframe.cameraZoom = cameraZoom;
+	keyframe.snapshotSize = snapshotSize;
+	G_SwapDemoKeyframe( &keyframe );
+
+	G_AppendDemoBuffer( &writer->block, &keyframe, sizeof( keyframe ) );
+	G_AppendDemoBuffer( &writer->block, snapshot, snapshotSize );
+	G_FlushDemoBlock( writer, DEMO_BLOCK_KEYFRAME );
+
+	writer->keyframeTime = writer->time;
+	writer->numKeyframes++;
+}
+
+static void G_EndDemoWriter( demoWriter_t *writer )
+{
+	G_FlushDemoBlock( writer, DEMO_BLOCK_FRAMES );
+
+	G_FreeDemoBuffer( &writer->block );
+	G_FreeDemoBuffer( &writer->events );
+	G_FreeDemoBuffer( &writer->packed );
+	writer->hFile = FS_INVALID_HANDLE;
+}
+
+/*
+===============================================================
+
+READING
+
+===============================================================
+*/
+
+static uint64_t G_DemoReaderMemory( const demoReader_t *reader )
+{
+	return reader->block.nSize + reader->packed.nSize + ( reader->numKeyframes * sizeof( *reader->pKeyframes ) );
+}
+
+static qboolean G_ReadDemoData( demoReader_t *reader, void *data, uint64_t size )
+{
+	if ( size > reader->fileSize - reader->offset ) {
+		return qfalse;
+	}
+	if ( FS_Read( data, size, reader->hFile ) != size ) {
+		return qfalse;
+	}
+	reader->offset += size;
+	return qtrue;
+}
+
+static void G_SeekDemoData( demoReader_t *reader, uint64_t offset )
+{
+	FS_FileSeek( reader->hFile, offset, FS_SEEK_SET );
+	reader->offset = offset;
+}
+
+static qboolean G_ReadDemoBlockHeader( demoReader_t *reader, demoBlock_t *header )
+{
+	if ( !G_ReadDemoData( reader, header, sizeof( *header ) ) ) {
+		return qfalse;
+	}
+	G_SwapDemoBlock( header );
+
+	if ( header->type > DEMO_BLOCK_KEYFRAME || header->size > DEMO_MAX_BLOCK_SIZE || header->compressedSize > DEMO_MAX_BLOCK_SIZE
+		|| header->endTime < header->time || header->compressedSize > reader->fileSize - reader->offset )
+	{
+		return qfalse;
+	}
+	if ( header->compression != COMPRESS_LZ4 && ( header->compression != COMPRESS_NONE || header->size != header->compressedSize ) ) {
+		return qfalse;
+	}
+	return qtrue;
+}
+
+/*
+* G_ReadDemoBlock: pulls the next block into memory, keyframes are skipped over without being read
+* unless they're wanted
+*/
+static qboolean G_ReadDemoBlock( demoReader_t *reader, qboolean keyframes, demoBlock_t *header )
+{
+	int ret;
+
+	for ( ;; ) {
+		if ( !G_ReadDemoBlockHeader( reader, header ) ) {
+			return qfalse;
+		}
+		if ( header->type == DEMO_BLOCK_KEYFRAME && !keyframes ) {
+			G_SeekDemoData( reader, reader->offset + header->compressedSize );
+			continue;
+		}
+		break;
+	}
+
+	G_ReserveDemoBuffer( &reader->packed, header->compressedSize );
+	if ( !G_ReadDemoData( reader, reader->packed.pData, header->compressedSize ) ) {
+		return qfalse;
+	}
+
+	G_ReserveDemoBuffer( &reader->block, header->size );
+	if ( header->compression == COMPRESS_LZ4 ) {
+		ret = LZ4_decompress_safe( (const char *)reader->packed.pData, (char *)reader->block.pData, header->compressedSize, header->size );
+		if ( ret < 0 || (uint32_t)ret != header->size ) {
+			Con_Printf( COLOR_RED "ERROR: demo block at %lu failed to decompress\n", reader->offset - header->compressedSize );
+			return qfalse;
+		}
+	} else {
+		memcpy( reader->block.pData, reader->packed.pData, header->size );
+	}
+	if ( crc32_buffer( reader->block.pData, header->size ) != header->checksum ) {
+		Con_Printf( COLOR_RED "ERROR: demo block at %lu failed checksum\n", reader->offset - header->compressedSize );
+		return qfalse;
+	}
+
+	reader->block.nUsed = header->size;
+	reader->blockPos = 0;
+	reader->framesLeft = header->type == DEMO_BLOCK_FRAMES ? header->numFrames : 0;
+	reader->time = header->time;
+
+	return qtrue;
+}
+
+/*
+* G_OpenDemoReader: reads the header and walks the block headers to find the keyframes, a recording
+* that was cut off just ends at the last whole block
+*/
+static qboolean G_OpenDemoReader( demoReader_t *reader, fileHandle_t hFile, const char *name, demoBuffer_t *info )
+{
+	demoHeader_t header;
+	demoBlock_t block;
+	uint64_t offset;
+
+	memset( reader, 0, sizeof( *reader ) );
+	reader->hFile = hFile;
+	reader->fileSize = FS_FileLength( hFile );
+
+	if ( !G_ReadDemoData( reader, &header, sizeof( header ) ) ) {
+		Con_Printf( COLOR_RED "ERROR: demo '%s' is truncated\n", name );
+		return qfalse;
+	}
+	header.ident = LittleInt( header.ident );
+	header.demoVersion = LittleInt( header.demoVersion );
+	header.version.m_nVersionMajor = LittleShort( header.version.m_nVersionMajor );
+	header.version.m_nVersionUpdate = LittleShort( header.version.m_nVersionUpdate );
+	header.version.m_nVersionPatch = LittleInt( header.version.m_nVersionPatch );
+	header.infoSize = LittleInt( header.infoSize );
+
+	if ( header.ident != DEMO_IDENT ) {
+		Con_Printf( COLOR_RED "ERROR: demo '%s' was recorded by an older version and can't be played back\n", name );
+		return qfalse;
+	}
+	if ( header.demoVersion != DEMO_VERSION ) {
+		Con_Printf( COLOR_RED "ERROR: demo '%s' is version %i, should be %i\n", name, header.demoVersion, DEMO_VERSION );
+		return qfalse;
+	}
+	if ( header.version.m_nVersionMajor != NOMAD_VERSION || header.version.m_nVersionUpdate != NOMAD_VERSION_UPDATE
+		|| header.version.m_nVersionPatch != NOMAD_VERSION_PATCH )
+	{
+		Con_Printf( COLOR_YELLOW "WARNING: demo '%s' was recorded with v%hu.%hu.%u, playback might not match\n", name,
+			header.version.m_nVersionMajor, header.version.m_nVersionUpdate, header.version.m_nVersionPatch );
+	}
+	if ( header.infoSize > DEMO_MAX_INFO_SIZE ) {
+		Con_Printf( COLOR_RED "ERROR: demo '%s' has a bad header\n", name );
+		return qfalse;
+	}
+
+	info->nUsed = 0;
+	G_ReserveDemoBuffer( info, header.infoSize );
+	if ( !G_ReadDemoData( reader, info->pData, header.infoSize ) ) {
+		Con_Printf( COLOR_RED "ERROR: demo '%s' is truncated\n", name );
+		return qfalse;
+	}
+	info->nUsed = header.infoSize;
+
+	reader->firstBlock = reader->offset;
+	for ( ;; ) {
+		offset = reader->offset;
+		if ( !G_ReadDemoBlockHeader( reader, &block ) ) {
+			break;
+		}
+		if ( block.type == DEMO_BLOCK_KEYFRAME ) {
+			reader->pKeyframes = (demoKeyframeInfo_t *)Z_Realloc( reader->pKeyframes,
+				sizeof( *reader->pKeyframes ) * ( reader->numKeyframes + 1 ), TAG_GAME );
+			reader->pKeyframes[ reader->numKeyframes ].time = block.time;
+			reader->pKeyframes[ reader->numKeyframes ].offset = offset;
+			reader->numKeyframes++;
+		}
+		reader->length = block.endTime;
+		G_SeekDemoData( reader, reader->offset + block.compressedSize );
+	}
+
+	// anything after the last good block is ignored
+	reader->fileSize = reader->offset;
+	G_SeekDemoData( reader, reader->firstBlock );
+
+	if ( !reader->numKeyframes || reader->pKeyframes[0].offset != reader->firstBlock ) {
+		Con_Printf( COLOR_RED "ERROR: demo '%s' doesn't start with a keyframe\n", name );
+		return qfalse;
+	}
+
+	return qtrue;
+}
+
+static void G_CloseDemoReader( demoReader_t *reader )
+{
+	G_FreeDemoBuffer( &reader->block );
+	G_FreeDemoBuffer( &reader->packed );
+	if ( reader->pKeyframes ) {
+		Z_Free( reader->pKeyframes );
+	}
+	memset( reader, 0, sizeof( *reader ) );
+	reader->hFile = FS_INVALID_HANDLE;
+}
+
+/*
+* G_PeekDemoFrame: makes sure the next frame is loaded, returns false at the end of the demo
+*/
+static qboolean G_PeekDemoFrame( demoReader_t *reader )
+{
+	demoBlock_t header;
+	demoEvent_t ev;
+	const byte *end;
+	uint32_t i;
+
+	if ( reader->framePending ) {
+		return qtrue;
+	}
+
+	while ( !reader->framesLeft ) {
+		if ( !G_ReadDemoBlock( reader, qfalse, &header ) ) {
+			return qfalse;
+		}
+	}
+
+	if ( reader->block.nUsed - reader->blockPos < sizeof( reader->frame ) ) {
+		Con_Printf( COLOR_RED "ERROR: demo frame at %u msec is truncated\n", reader->time );
+		return qfalse;
+	}
+	memcpy( &reader->frame, reader->block.pData + reader->blockPos, sizeof( reader->frame ) );
+	G_SwapDemoFrame( &reader->frame );
+	reader->blockPos += sizeof( reader->frame );
+	reader->pEvents = reader->block.pData + reader->blockPos;
+
+	// check the events now so nothing after this has to
+	end = reader->block.pData + reader->block.nUsed;
+	for ( i = 0; i < reader->frame.numEvents; i++ ) {
+		if ( (uint64_t)( end - ( reader->block.pData + reader->blockPos ) ) < sizeof( ev ) ) {
+			Con_Printf( COLOR_RED "ERROR: demo frame at %u msec is truncated\n", reader->time );
+			return qfalse;
+		}
+		memcpy( &ev, reader->block.pData + reader->blockPos, sizeof( ev ) );
+		G_SwapDemoEvent( &ev );
+		reader->blockPos += sizeof( ev );
+
+		if ( ev.evPtrLength > (uint64_t)( end - ( reader->block.pData + reader->blockPos ) ) ) {
+			Con_Printf( COLOR_RED "ERROR: demo frame at %u msec is truncated\n", reader->time );
+			return qfalse;
+		}
+		if ( ev.evType == SE_CONSOLE && ( !ev.evPtrLength || reader->block.pData[ reader->blockPos + ev.evPtrLength - 1 ] ) ) {
+			Con_Printf( COLOR_RED "ERROR: demo frame at %u msec has a bad console event\n", reader->time );
+			return qfalse;
+		}
+		reader->blockPos += ev.evPtrLength;
+	}
+
+	reader->framesLeft--;
+	reader->framePending = qtrue;
+
+	return qtrue;
+}
+
+/*
+* G_NextDemoEvent: walks the peeked frame's events, evPtr points into the block
+*/
+static const byte *G_NextDemoEvent( const byte *pos, sysEvent_t *ev )
+{
+	demoEvent_t event;
+
+	memcpy( &event, pos, sizeof( event ) );
+	G_SwapDemoEvent( &event );
+	pos += sizeof( event );
+
+	ev->evTime = event.evTime;
+	ev->evType = (sysEventType_t)event.evType;
+	ev->evValue = event.evValue;
+	ev->evValue2 = event.evValue2;
+	ev->evPtrLength = event.evPtrLength;
+	ev->evPtr = event.evPtrLength ? (void *)pos : NULL;
+
+	return pos + event.evPtrLength;
+}
+
+static void G_ConsumeDemoFrame( demoReader_t *reader )
+{
+	reader->framePending = qfalse;
+	reader->time += reader->frame.msec;
+}
+
+/*
+* G_SeekDemoReader: loads the last keyframe at or before msec, the frames after it come next
+*/
+static qboolean G_SeekDemoReader( demoReader_t *reader, uint32_t msec, demoKeyframe_t *keyframe, const byte **snapshot )
+{
+	demoBlock_t header;
+	uint32_t i;
+
+	for ( i = reader->numKeyframes; i > 1; i-- ) {
+		if ( reader->pKeyframes[ i - 1 ].time <= msec ) {
+			break;
+		}
+	}
+
+	G_SeekDemoData( reader, reader->pKeyframes[ i - 1 ].offset );
+	reader->framePending = qfalse;
+	reader->framesLeft = 0;
+
+	if ( !G_ReadDemoBlock( reader, qtrue, &header ) || header.type != DEMO_BLOCK_KEYFRAME
+		|| header.size < sizeof( *keyframe ) )
+	{
+		return qfalse;
+	}
+
+	memcpy( keyframe, reader->block.pData, sizeof( *keyframe ) );
+	G_SwapDemoKeyframe( keyframe );
+	if ( keyframe->snapshotSize != header.size - sizeof( *keyframe ) ) {
+		return qfalse;
+	}
+	*snapshot = reader->block.pData + sizeof( *keyframe );
+
+	return qtrue;
+}
+
+/*
+===============================================================
+
+RECORDING
+
+===============================================================
+*/
+
+static void G_WriteDemoInfo( demoBuffer_t *info )
+{
+	const char *cheats[] = {
+		"sgame_cheats_enabled",
+		"sgame_cheat_BlindMobs",
+		"sgame_cheat_DeafMobs",
+		"sgame_cheat_GodMode",
+		"sgame_cheat_InfiniteAmmo",
+		"sgame_cheat_InfiniteHealth",
+		"sgame_cheat_InfiniteRage"
+	};
+	char mapname[64];
+	int32_t length, value;
+	uint32_t i;
+	extern eastl::vector<char *> com_consoleLines;
+	extern int com_numConsoleLines;
+
+	length = strlen( FS_ReferencedBFFNames() ) + 1;
+	G_AppendDemoBuffer( info, &length, sizeof( length ) );
+	G_AppendDemoBuffer( info, FS_ReferencedBFFNames(), length );
+
+	// write the command line
+	value = com_numConsoleLines;
+	G_AppendDemoBuffer( info, &value, sizeof( value ) );
+	for ( const auto& it : com_consoleLines ) {
+		length = strlen( it ) + 1;
+		G_AppendDemoBuffer( info, &length, sizeof( length ) );
+		G_AppendDemoBuffer( info, it, length );
+	}
+
+	value = Cvar_VariableInteger( "sgame_Difficulty" );
+	G_AppendDemoBuffer( info, &value, sizeof( value ) );
+
+	memset( mapname, 0, sizeof( mapname ) );
+	Cvar_VariableStringBuffer( "mapname", mapname, sizeof( mapname ) - 1 );
+	G_AppendDemoBuffer( info, mapname, sizeof( mapname ) );
+
+	for ( i = 0; i < arraylen( cheats ); i++ ) {
+		value = Cvar_VariableInteger( cheats[i] );
+		G_AppendDemoBuffer( info, &value, sizeof( value ) );
+	}
+}
+
+static qboolean G_ReadDemoInfo( const demoBuffer_t *info, const char *name )
+{
+	const char *cheats[] = {
+		"sgame_cheats_enabled",
+		"sgame_cheat_BlindMobs",
+		"sgame_cheat_DeafMobs",
+		"sgame_cheat_GodMode",
+		"sgame_cheat_InfiniteAmmo",
+		"sgame_cheat_InfiniteHealth",
+		"sgame_cheat_InfiniteRage"
+	};
+	const char *referencedBffs;
+	char mapname[64];
+	int32_t length, numLines, difficulty, value;
+	uint64_t pos;
+	uint32_t i;
+
+#define READ_INFO( dest, size ) \
+	if ( (uint64_t)( size ) > info->nUsed - pos ) { \
+		Con_Printf( COLOR_RED "ERROR: demo '%s' has a bad header\n", name ); \
+		return qfalse; \
+	} \
+	memcpy( dest, info->pData + pos, size ); \
+	pos += size;
+
+	pos = 0;
+
+	READ_INFO( &length, sizeof( length ) );
+	if ( length < 1 || (uint64_t)length > info->nUsed - pos || info->pData[ pos + length - 1 ] ) {
+		Con_Printf( COLOR_RED "ERROR: demo '%s' has a bad header\n", name );
+		return qfalse;
+	}
+	referencedBffs = (const char *)info->pData + pos;
+	pos += length;
+
+	// the command line is only there for reference
+	READ_INFO( &numLines, sizeof( numLines ) );
+	for ( i = 0; i < (uint32_t)MAX( numLines, 0 ); i++ ) {
+		READ_INFO( &length, sizeof( length ) );
+		if ( length < 0 || (uint64_t)length > info->nUsed - pos ) {
+			Con_Printf( COLOR_RED "ERROR: demo '%s' has a bad header\n", name );
+			return qfalse;
+		}
+		pos += length;
+	}
+
+	READ_INFO( &difficulty, sizeof( difficulty ) );
+	READ_INFO( mapname, sizeof( mapname ) );
+	mapname[ sizeof( mapname ) - 1 ] = '\0';
+
+	for ( i = 0; i < arraylen( cheats ); i++ ) {
+		READ_INFO( &value, sizeof( value ) );
+		Cvar_SetIntegerValue( cheats[i], value );
+	}
+
+#undef READ_INFO
+
+	Con_Printf( "--------------------------------\n" );
+	Con_Printf( "Demo Playback Begun\n" );
+	Con_Printf( "--------------------------------\n" );
+	Con_Printf( "referenced bffs: %s\n", referencedBffs );
+	Con_Printf( "difficulty: %i\n", difficulty );
+	Con_Printf( "map: %s\n", mapname );
+	Con_Printf( "--------------------------------\n" );
+
+	return qtrue;
+}
+
+static void G_DemoKeyframe( void )
+{
+	byte *snapshot;
+	uint64_t snapshotSize;
+
+	snapshot = g_pArchiveHandler->SaveSnapshot( &snapshotSize );
+	G_WriteDemoKeyframe( &g_demoWriter, gi.realtime, glm::value_ptr( gi.cameraPos ), gi.cameraZoom, snapshot, snapshotSize );
+	Z_Free( snapshot );
+}
+
+/*
+* G_BeginDemoRecord: writes the header and the keyframe everything after it is played back from
+*/
+void G_BeginDemoRecord( fileHandle_t hFile )
+{
+	demoBuffer_t info;
+
+	memset( &info, 0, sizeof( info ) );
+	G_WriteDemoInfo( &info );
+	G_BeginDemoWriter( &g_demoWriter, hFile, &info );
+	G_FreeDemoBuffer( &info );
+
+	G_DemoKeyframe();
+}
+
+void G_EndDemoRecord( void )
+{
+	G_EndDemoWriter( &g_demoWriter );
+
+	Con_Printf( "%u msec of demo in %lu bytes, %u blocks and %u keyframes\n", g_demoWriter.time, g_demoWriter.fileSize,
+		g_demoWriter.numBlocks, g_demoWriter.numKeyframes );
+}
+
+/*
+* G_RecordEvent: called for every event Com_EventLoop hands out, they're kept until the frame is written
+*/
+void G_RecordEvent( const sysEvent_t *ev )
+{
+	G_WriteDemoEvent( &g_demoWriter, ev );
+}
+
+void G_RecordDemoFrame( int msec )
+{
+	G_WriteDemoFrame( &g_demoWriter, msec, glm::value_ptr( gi.cameraPos ), gi.cameraZoom );
+}
+
+/*
+* G_RecordDemoKeyframe: called once the frame is done, takes a snapshot if it's been long enough
+* since the last one
+*/
+void G_RecordDemoKeyframe( void )
+{
+	if ( g_demoKeyframeInterval->i <= 0 || g_demoWriter.time - g_demoWriter.keyframeTime < (uint32_t)g_demoKeyframeInterval->i ) {
+		return;
+	}
+	G_DemoKeyframe();
+}
+
+/*
+===============================================================
+
+PLAYBACK
+
+===============================================================
+*/
+
+static qboolean G_RestoreDemoKeyframe( uint32_t msec )
+{
+	demoKeyframe_t keyframe;
+	const byte *snapshot;
+
+	if ( !G_SeekDemoReader( &g_demoReader, msec, &keyframe, &snapshot ) ) {
+		Con_Printf( COLOR_RED "ERROR: demo keyframe before %u msec is damaged\n", msec );
+		return qfalse;
+	}
+	if ( !g_pArchiveHandler->LoadSnapshot( snapshot, keyframe.snapshotSize ) ) {
+		return qfalse;
+	}
+
+	gi.realtime = keyframe.realtime;
+	VectorCopy( gi.cameraPos, keyframe.cameraPos );
+	gi.cameraZoom = keyframe.cameraZoom;
+
+	return qtrue;
+}
+
+qboolean G_BeginDemoPlayback( fileHandle_t hFile, const char *name )
+{
+	demoBuffer_t info;
+	qboolean ok;
+
+	memset( &info, 0, sizeof( info ) );
+	ok = G_OpenDemoReader( &g_demoReader, hFile, name, &info ) && G_ReadDemoInfo( &info, name );
+	G_FreeDemoBuffer( &info );
+
+	if ( !ok || !G_RestoreDemoKeyframe( 0 ) ) {
+		G_CloseDemoReader( &g_demoReader );
+		return qfalse;
+	}
+
+	Con_Printf( "%u msec, %u keyframes\n", g_demoReader.length, g_demoReader.numKeyframes );
+
+	g_demoSeekTime = 0;
+	gi.timeDemoFrames = 0;
+
+	return qtrue;
+}
+
+void G_EndDemoPlayback( void )
+{
+	G_CloseDemoReader( &g_demoReader );
+}
+
+/*
+* G_PlayDemoFrame: runs the next frame's events the same way Com_EventLoop did when it was recorded,
+* returns false once the demo is over
+*/
+qboolean G_PlayDemoFrame( int *msec )
+{
+	sysEvent_t ev;
+	const byte *pos;
+	uint32_t i;
+
+	if ( !G_PeekDemoFrame( &g_demoReader ) ) {
+		return qfalse;
+	}
+
+	if ( com_timedemo->i ) {
+		G_TimeDemoFrame();
+	}
+
+	VectorCopy( gi.cameraPos, g_demoReader.frame.cameraPos );
+	gi.cameraZoom = g_demoReader.frame.cameraZoom;
+
+	pos = g_demoReader.pEvents;
+	for ( i = 0; i < g_demoReader.frame.numEvents; i++ ) {
+		pos = G_NextDemoEvent( pos, &ev );
+		Com_RunEvent( &ev );
+	}
+	// the recording ran these before the frame too
+	Cbuf_Execute();
+
+	*msec = g_demoReader.frame.msec;
+	G_ConsumeDemoFrame( &g_demoReader );
+
+	return qtrue;
+}
+
+/*
+* G_DemoTargetUsec: playback is paced by the recording, one recorded frame for every engine frame,
+* scaled by g_demoSpeed, timedemos and seeks don't wait at all
+*/
+uint32_t G_DemoTargetUsec( uint32_t targetUsec )
+{
+	if ( !gi.demoplaying || gi.state != GS_LEVEL || !G_PeekDemoFrame( &g_demoReader ) ) {
+		return targetUsec;
+	}
+	if ( com_timedemo->i || g_demoReader.time < g_demoSeekTime ) {
+		return 0;
+	}
+	return (uint32_t)( g_demoReader.frame.msec * 1000.0f / g_demoSpeed->f );
+}
+
+/*
+====================
+G_DemoSeek_f
+
+demo_seek <msec>
+====================
+*/
+static void G_DemoSeek_f( void )
+{
+	uint32_t msec;
+
+	if ( Cmd_Argc() != 2 ) {
+		Con_Printf( "demo_seek <msec>\n" );
+		return;
+	}
+	if ( !gi.demoplaying ) {
+		Con_Printf( "Not playing a demo.\n" );
+		return;
+	}
+
+	msec = MIN( (uint32_t)MAX( atoi( Cmd_Argv( 1 ) ), 0 ), g_demoReader.length );
+	if ( !G_RestoreDemoKeyframe( msec ) ) {
+		G_StopDemo();
+		return;
+	}
+
+	Con_Printf( "Seeking to %u msec from the keyframe at %u msec...\n", msec, g_demoReader.time );
+	g_demoSeekTime = msec;
+}
+
+/*
+===============================================================
+
+TESTS
+
+===============================================================
+*/
+
+#define DEMOTEST_PATH "demos/demo_test." DEMOEXT
+#define DEMOTEST_KEYFRAME_INTERVAL 10000
+#define DEMOTEST_SNAPSHOT_SIZE ( 24 * 1024 )
+
+static uint32_t G_DemoTestHash( uint32_t x )
+{
+	x ^= x >> 16;
+	x *= 0x7feb352dU;
+	x ^= x >> 15;
+	x *= 0x846ca68bU;
+	x ^= x >> 16;
+	return x;
+}
+
+/*
+* G_DemoTestFrame: every frame is made from its number, so the playback can be checked against
+* the recording without keeping it around
+*/
+static uint32_t G_DemoTestFrame( uint32_t frameNum, float *cameraPos, float *cameraZoom, sysEvent_t *events, char *text, uint32_t textSize )
+{
+	uint32_t h, numEvents, i;
+
+	h = G_DemoTestHash( frameNum );
+	cameraPos[0] = (float)( frameNum % 1000 ) * 0.25f;
+	cameraPos[1] = (float)( h & 0xff ) * 0.5f;
+	cameraPos[2] = 0.0f;
+	*cameraZoom = 1.0f + (float)( ( h >> 8 ) & 0xf ) * 0.125f;
+
+	numEvents = ( h >> 12 ) & 3;
+	for ( i = 0; i < numEvents; i++ ) {
+		h = G_DemoTestHash( h + i );
+		memset( &events[i], 0, sizeof( events[i] ) );
+		events[i].evTime = frameNum * 16 + i;
+		switch ( h & 3 ) {
+		case 0:
+			events[i].evType = SE_KEY;
+			events[i].evValue = ( h >> 8 ) & 0xff;
+			events[i].evValue2 = ( h >> 16 ) & 1;
+			break;
+		case 1:
+			events[i].evType = SE_MOUSE;
+			events[i].evValue = (int32_t)( ( h >> 8 ) & 0x3f ) - 32;
+			events[i].evValue2 = (int32_t)( ( h >> 16 ) & 0x3f ) - 32;
+			break;
+		case 2:
+			events[i].evType = SE_JOYSTICK_AXIS;
+			events[i].evValue = ( h >> 8 ) & 7;
+			events[i].evValue2 = h >> 16;
+			break;
+		case 3:
+			events[i].evType = SE_CONSOLE;
+			Com_snprintf( text, textSize, "echo frame %u", frameNum );
+			events[i].evPtrLength = strlen( text ) + 1;
+			events[i].evPtr = text;
+			break;
+		};
+	}
+
+	return numEvents;
+}
+
+static void G_DemoTestSnapshot( uint32_t time, byte *snapshot )
+{
+	uint32_t i;
+
+	// half of it compresses, half of it doesn't
+	for ( i = 0; i < DEMOTEST_SNAPSHOT_SIZE / 2; i++ ) {
+		snapshot[i] = (byte)( time >> ( ( i & 3 ) * 8 ) );
+	}
+	for ( ; i < DEMOTEST_SNAPSHOT_SIZE; i++ ) {
+		snapshot[i] = (byte)G_DemoTestHash( time ^ i );
+	}
+}
+
+static uint64_t G_DemoTestDigest( uint64_t digest, const void *data, uint64_t size )
+{
+	const byte *p = (const byte *)data;
+	uint64_t i;
+
+	for ( i = 0; i < size; i++ ) {
+		digest ^= p[i];
+		digest *= 1099511628211ULL;
+	}
+	return digest;
+}
+
+static uint64_t G_DemoTestDigestEvent( uint64_t digest, const sysEvent_t *ev )
+{
+	const uint32_t values[] = { ev->evTime, (uint32_t)ev->evType, ev->evValue, ev->evValue2, ev->evPtrLength };
+
+	digest = G_DemoTestDigest( digest, values, sizeof( values ) );
+	if ( ev->evPtr ) {
+		digest = G_DemoTestDigest( digest, ev->evPtr, ev->evPtrLength );
+	}
+	return digest;
+}
+
+/*
+* G_DemoTestRecord: records numFrames generated frames with a keyframe every DEMOTEST_KEYFRAME_INTERVAL,
+* fills in the time every frame starts at and returns the most memory the writer ever held
+*/
+static uint64_t G_DemoTestRecord( uint32_t numFrames, uint32_t *frameTimes, uint64_t *digest, demoWriter_t *writer, uint64_t *usec )
+{
+	sysEvent_t events[4];
+	demoBuffer_t info;
+	fileHandle_t hFile;
+	byte *snapshot;
+	char text[64];
+	vec3_t cameraPos;
+	float cameraZoom;
+	uint32_t numEvents, msec, i, j;
+	uint64_t peak, start;
+
+	hFile = FS_FOpenWrite( DEMOTEST_PATH );
+	if ( hFile == FS_INVALID_HANDLE ) {
+		return 0;
+	}
+
+	memset( &info, 0, sizeof( info ) );
+	G_AppendDemoBuffer( &info, "demo_test", 10 );
+
+	snapshot = (byte *)Z_Malloc( DEMOTEST_SNAPSHOT_SIZE, TAG_GAME );
+	memset( writer, 0, sizeof( *writer ) );
+	peak = 0;
+	*digest = 14695981039346656037ULL;
+
+	start = Sys_Microseconds();
+	G_BeginDemoWriter( writer, hFile, &info );
+	G_DemoTestSnapshot( 0, snapshot );
+	G_WriteDemoKeyframe( writer, 0, vec3_origin, 1.0f, snapshot, DEMOTEST_SNAPSHOT_SIZE );
+
+	for ( i = 0; i < numFrames; i++ ) {
+		frameTimes[i] = writer->time;
+
+		numEvents = G_DemoTestFrame( i, cameraPos, &cameraZoom, events, text, sizeof( text ) );
+		for ( j = 0; j < numEvents; j++ ) {
+			G_WriteDemoEvent( writer, &events[j] );
+			*digest = G_DemoTestDigestEvent( *digest, &events[j] );
+		}
+
+		msec = 1 + ( G_DemoTestHash( i ^ 0x5bd1e995 ) % 33 );
+		G_WriteDemoFrame( writer, msec, cameraPos, cameraZoom );
+		*digest = G_DemoTestDigest( *digest, &msec, sizeof( msec ) );
+
+		if ( writer->time - writer->keyframeTime >= DEMOTEST_KEYFRAME_INTERVAL ) {
+			G_DemoTestSnapshot( writer->time, snapshot );
+			G_WriteDemoKeyframe( writer, writer->time, cameraPos, cameraZoom, snapshot, DEMOTEST_SNAPSHOT_SIZE );
+		}
+		peak = MAX( peak, G_DemoWriterMemory( writer ) );
+	}
+	G_EndDemoWriter( writer );
+	*usec = Sys_Microseconds() - start;
+
+	FS_FClose( hFile );
+	G_FreeDemoBuffer( &info );
+	Z_Free( snapshot );
+
+	return peak;
+}
+
+static void G_DemoTestCheck( qboolean ok, const char *what, uint32_t frameNum, qboolean *passed )
+{
+	if ( !ok ) {
+		Con_Printf( COLOR_RED "demo_test: %s at frame %u\n", what, frameNum );
+		*passed = qfalse;
+	}
+}
+
+/*
+* G_DemoTestCompare: reads the next frame and checks it against the generated one, stops at the first one that
+* doesn't match so a broken demo doesn't print a line for every frame after it
+*/
+static qboolean G_DemoTestCompare( demoReader_t *reader, uint32_t frameNum, uint32_t frameTime, uint64_t *digest, qboolean *passed )
+{
+	sysEvent_t events[4], ev;
+	char text[64];
+	vec3_t cameraPos;
+	float cameraZoom;
+	const byte *pos;
+	uint32_t numEvents, msec, i;
+	qboolean ok;
+
+	ok = qtrue;
+	if ( !G_PeekDemoFrame( reader ) ) {
+		G_DemoTestCheck( qfalse, "demo ended early", frameNum, passed );
+		return qfalse;
+	}
+
+	numEvents = G_DemoTestFrame( frameNum, cameraPos, &cameraZoom, events, text, sizeof( text ) );
+	msec = 1 + ( G_DemoTestHash( frameNum ^ 0x5bd1e995 ) % 33 );
+
+	G_DemoTestCheck( reader->time == frameTime, "wrong frame time", frameNum, &ok );
+	G_DemoTestCheck( reader->frame.msec == msec, "wrong msec", frameNum, &ok );
+	G_DemoTestCheck( VectorCompare( reader->frame.cameraPos, cameraPos ) && reader->frame.cameraZoom == cameraZoom,
+		"wrong camera", frameNum, &ok );
+	G_DemoTestCheck( reader->frame.numEvents == numEvents, "wrong event count", frameNum, &ok );
+	if ( !ok ) {
+		*passed = qfalse;
+		return qfalse;
+	}
+
+	pos = reader->pEvents;
+	for ( i = 0; i < numEvents; i++ ) {
+		pos = G_NextDemoEvent( pos, &ev );
+		G_DemoTestCheck( ev.evTime == events[i].evTime && ev.evType == events[i].evType && ev.evValue == events[i].evValue
+			&& ev.evValue2 == events[i].evValue2 && ev.evPtrLength == events[i].evPtrLength, "wrong event", frameNum, &ok );
+		G_DemoTestCheck( !ev.evPtrLength || ev.evPtrLength != events[i].evPtrLength
+			|| !memcmp( ev.evPtr, events[i].evPtr, ev.evPtrLength ), "wrong event data", frameNum, &ok );
+
+		*digest = G_DemoTestDigestEvent( *digest, &ev );
+	}
+	*digest = G_DemoTestDigest( *digest, &reader->frame.msec, sizeof( reader->frame.msec ) );
+
+	G_ConsumeDemoFrame( reader );
+
+	if ( !ok ) {
+		*passed = qfalse;
+	}
+	return ok;
+}
+
+/*
+* G_DemoTestPlay: plays the whole test demo back, returns the digest of everything it handed out
+*/
+static uint64_t G_DemoTestPlay( uint32_t numFrames, const uint32_t *frameTimes, uint64_t *peak, qboolean *passed )
+{
+	demoReader_t reader;
+	demoBuffer_t info;
+	fileHandle_t hFile;
+	uint64_t digest;
+	uint32_t i;
+
+	digest = 14695981039346656037ULL;
+	*peak = 0;
+
+	FS_FOpenFileRead( DEMOTEST_PATH, &hFile );
+	if ( hFile == FS_INVALID_HANDLE ) {
+		G_DemoTestCheck( qfalse, "couldn't open the demo", 0, passed );
+		return 0;
+	}
+
+	memset( &info, 0, sizeof( info ) );
+	if ( !G_OpenDemoReader( &reader, hFile, DEMOTEST_PATH, &info ) ) {
+		G_DemoTestCheck( qfalse, "couldn't read the demo", 0, passed );
+	} else {
+		G_DemoTestCheck( info.nUsed == 10 && !memcmp( info.pData, "demo_test", 10 ), "wrong demo info", 0, passed );
+		for ( i = 0; i < numFrames; i++ ) {
+			if ( !G_DemoTestCompare( &reader, i, frameTimes[i], &digest, passed ) ) {
+				break;
+			}
+			*peak = MAX( *peak, G_DemoReaderMemory( &reader ) );
+		}
+		G_DemoTestCheck( !G_PeekDemoFrame( &reader ), "frames after the end", numFrames, passed );
+	}
+
+	G_FreeDemoBuffer( &info );
+	G_CloseDemoReader( &reader );
+	FS_FClose( hFile );
+
+	return digest;
+}
+
+/*
+* G_DemoTestSeek: seeks to msec and checks the keyframe and the frames run up to it
+*/
+static void G_DemoTestSeek( uint32_t msec, uint32_t numFrames, const uint32_t *frameTimes, qboolean *passed )
+{
+	demoReader_t reader;
+	demoBuffer_t info;
+	demoKeyframe_t keyframe;
+	fileHandle_t hFile;
+	const byte *snapshot;
+	byte *expected;
+	uint64_t digest;
+	uint32_t first, last, mid, i;
+
+	FS_FOpenFileRead( DEMOTEST_PATH, &hFile );
+	if ( hFile == FS_INVALID_HANDLE ) {
+		G_DemoTestCheck( qfalse, "couldn't open the demo", 0, passed );
+		return;
+	}
+
+	memset( &info, 0, sizeof( info ) );
+	expected = (byte *)Z_Malloc( DEMOTEST_SNAPSHOT_SIZE, TAG_GAME );
+
+	if ( !G_OpenDemoReader( &reader, hFile, DEMOTEST_PATH, &info ) || !G_SeekDemoReader( &reader, msec, &keyframe, &snapshot ) ) {
+		Con_Printf( COLOR_RED "demo_test: seek to %u msec failed\n", msec );
+		*passed = qfalse;
+	} else {
+		G_DemoTestSnapshot( reader.time, expected );
+		if ( reader.time > msec || msec - reader.time > DEMOTEST_KEYFRAME_INTERVAL + 33 || keyframe.realtime != (int32_t)reader.time
+			|| keyframe.snapshotSize != DEMOTEST_SNAPSHOT_SIZE || memcmp( snapshot, expected, DEMOTEST_SNAPSHOT_SIZE ) )
+		{
+			Con_Printf( COLOR_RED "demo_test: seek to %u msec landed on a bad keyframe at %u msec\n", msec, reader.time );
+			*passed = qfalse;
+		}
+
+		// find the first frame after the keyframe, then run up to where the seek was going
+		first = 0;
+		last = numFrames;
+		while ( first < last ) {
+			mid = ( first + last ) / 2;
+			if ( frameTimes[ mid ] < reader.time ) {
+				first = mid + 1;
+			} else {
+				last = mid;
+			}
+		}
+		digest = 0;
+		for ( i = first; i < numFrames && reader.time < msec; i++ ) {
+			if ( !G_DemoTestCompare( &reader, i, frameTimes[i], &digest, passed ) ) {
+				break;
+			}
+		}
+	}
+
+	G_FreeDemoBuffer( &info );
+	G_CloseDemoReader( &reader );
+	FS_FClose( hFile );
+	Z_Free( expected );
+}
+
+/*
+* G_DemoTest_f: records a generated demo and plays it back, everything has to come back the way it went
+* in, twice, seeking has to land on the right keyframe and a long recording can't take more memory
+* than a short one
+*/
+static void G_DemoTest_f( void )
+{
+	demoWriter_t writer;
+	uint32_t *frameTimes;
+	uint32_t numFrames, shortFrames, i;
+	uint64_t recordDigest, playDigest, replayDigest;
+	uint64_t shortPeak, longPeak, readPeak, usec;
+	qboolean passed;
+
+	numFrames = Cmd_Argc() > 1 ? MAX( atoi( Cmd_Argv( 1 ) ), 1 ) : 216000;
+	shortFrames = MIN( numFrames, 3600 );
+	passed = qtrue;
+
+	frameTimes = (uint32_t *)Z_Malloc( sizeof( *frameTimes ) * numFrames, TAG_GAME );
+
+	shortPeak = G_DemoTestRecord( shortFrames, frameTimes, &recordDigest, &writer, &usec );
+	longPeak = G_DemoTestRecord( numFrames, frameTimes, &recordDigest, &writer, &usec );
+	if ( !longPeak ) {
+		Con_Printf( COLOR_RED "demo_test: couldn't open '%s'\n", DEMOTEST_PATH );
+		Z_Free( frameTimes );
+		return;
+	}
+
+	Con_Printf( "demo_test: %u frames, %u msec, %lu bytes in %u blocks and %u keyframes (%.1f%% of %lu), %.2f usec per frame\n",
+		numFrames, writer.time, writer.fileSize, writer.numBlocks, writer.numKeyframes,
+		writer.dataSize ? 100.0 * writer.fileSize / writer.dataSize : 0.0, writer.dataSize, (double)usec / numFrames );
+	Con_Printf( "demo_test: recording held %lu bytes after %u frames, %lu bytes after %u\n", shortPeak, shortFrames,
+		longPeak, numFrames );
+	if ( longPeak > shortPeak ) {
+		Con_Printf( COLOR_RED "demo_test: recording memory grows with the length of the demo\n" );
+		passed = qfalse;
+	}
+
+	playDigest = G_DemoTestPlay( numFrames, frameTimes, &readPeak, &passed );
+	replayDigest = G_DemoTestPlay( numFrames, frameTimes, &readPeak, &passed );
+	if ( playDigest != recordDigest || replayDigest != playDigest ) {
+		Con_Printf( COLOR_RED "demo_test: playback isn't deterministic (%lx recorded, %lx and %lx played)\n",
+			recordDigest, playDigest, replayDigest );
+		passed = qfalse;
+	}
+	Con_Printf( "demo_test: playback held %lu bytes\n", readPeak );
+
+	const uint32_t seeks[] = { 0, writer.time / 3, writer.time / 2, DEMOTEST_KEYFRAME_INTERVAL, writer.time - 1, writer.time + 1000 };
+	for ( i = 0; i < arraylen( seeks ); i++ ) {
+		G_DemoTestSeek( seeks[i], numFrames, frameTimes, &passed );
+	}
+
+	FS_HomeRemove( DEMOTEST_PATH );
+	Z_Free( frameTimes );
+
+	Con_Printf( "demo_test: %s\n", passed ? "passed" : "FAILED" );
+}
+
+void G_InitDemos( void )
+{
+	g_demoSpeed = Cvar_Get( "g_demoSpeed", "1", 0 );
+	Cvar_CheckRange( g_demoSpeed, "0.1", "100", CVT_FLOAT );
+	Cvar_SetDescription( g_demoSpeed, "Demo playback speed, 2 plays twice as fast, 0.5 at half speed." );
+
+	g_demoKeyframeInterval = Cvar_Get( "g_demoKeyframeInterval", "10000", CVAR_SAVE );
+	Cvar_CheckRange( g_demoKeyframeInterval, "0", NULL, CVT_INT );
+	Cvar_SetDescription( g_demoKeyframeInterval, "Milliseconds between the snapshots a recording demo takes to seek to, 0 only takes the first one." );
+
+	Cmd_AddCommand( "demo_seek", G_DemoSeek_f );
+	Cmd_AddCommand( "demo_test", G_DemoTest_f );
+
+	G_InitTimeDemo();
+}
+
+void G_ShutdownDemos( void )
+{
+	// don't lose the end of a recording
+	if ( gi.demorecording ) {
+		G_StopRecord_f();
+	}
+	if ( gi.demoplaying ) {
+		G_EndDemoPlayback();
+		FS_FClose( gi.demofile );
+		gi.demofile = FS_INVALID_HANDLE;
+		gi.demoplaying = qfalse;
+	}
+
+	Cmd_RemoveCommand( "demo_seek" );
+	Cmd_RemoveCommand( "demo_test" );
+
+	G_ShutdownTimeDemo();
+}
@@ -343,11 +343,15 @@ const char *Key_KeynumToString(uint32_t keynum)
 	return tinystr;
 }
 
+// set whenever a binding changes so Com_WriteConfiguration knows to write them out again
+qboolean key_bindingsModified;
+
 void Key_SetBinding( uint32_t keynum, const char *binding )
 {
 	if ( keynum >= NUMKEYS ) {
 		return;
 	}
+	key_bindingsModified = qtrue;
 
 	// free old binding
 	if ( keys[keynum].binding ) {
@@ -424,21 +428,27 @@ static void Key_Bind_f( void )
 }
 
 /*
-* Key_WriteBindings: Writes lines containing "bind key value"
+* Key_WriteBindings: Writes lines containing "bind key value" into the buffer, returns the length
+* of all of them, the buffer only holds all of them if that's less than bufferSize
 */
-void Key_WriteBindings( fileHandle_t f )
+uint64_t Key_WriteBindings( char *buffer, uint64_t bufferSize )
 {
 	uint32_t i;
+	uint64_t length;
+	char line[ MAX_STRING_CHARS ];
 
-	FS_Printf( f, "unbindall" GDR_NEWLINE );
+	length = Com_AppendText( buffer, bufferSize, 0, "unbindall" GDR_NEWLINE, strlen( "unbindall" GDR_NEWLINE ) );
 
 	for ( i = 0 ; i < NUMKEYS ; i++ ) {
 		if ( !keys[i].binding || !keys[i].binding[0] ) {
 			continue;
 		}
 		
-		FS_Printf( f, "bind \"%s\" \"%s\"" GDR_NEWLINE, Key_KeynumToString( i ), keys[i].binding );
+		length += Com_AppendText( buffer, bufferSize, length, line, Com_snprintf( line, sizeof( line ),
+			"bind \"%s\" \"%s\"" GDR_NEWLINE, Key_KeynumToString( i ), keys[i].binding ) );
 	}
+
+	return length;
 }
 
 static void Key_Bindlist_f( void )
@@ -24,6 +24,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 #include "g_sound.h"
 #include "g_world.h"
 #include "g_archive.h"
+#include "../AILib/AIFlowField.h"
 #include "../rendercommon/imgui.h"
 #include "../rendercommon/imgui_impl_sdl2.h"
 #include "../rendercommon/imgui_impl_opengl3.h"
@@ -170,6 +171,20 @@ static void G_RefImGuiFree( void *ptr, void * ) {
 	}
 }
 
+// with r_smp the render thread can still be drawing a frame's ui while the next one is being
+// built, so every frame's draw lists get copied out into one of two slots
+static ImDrawData s_ImGuiFrames[ 2 ];
+static uint32_t s_nImGuiFrame;
+
+static void G_RefImGuiFreeFrame( ImDrawData *pFrame ) {
+	int i;
+
+	for ( i = 0; i < pFrame->CmdLists.Size; i++ ) {
+		IM_DELETE( pFrame->CmdLists[i] );
+	}
+	pFrame->Clear();
+}
+
 static void G_RefImGuiShutdown( void ) {
 	const char *iniData;
 	size_t iniDataSize;
@@ -191,8 +206,16 @@ static void G_RefImGuiShutdown( void ) {
 	iniData = ImGui::SaveIniSettingsToMemory( &iniDataSize );
 	FS_WriteFile( LOG_DIR "/imgui.ini", iniData, iniDataSize );
 
-	ImGui_ImplOpenGL3_Shutdown();
-	ImGui_ImplSDL2_Shutdown();
+	G_RefImGuiFreeFrame( &s_ImGuiFrames[0] );
+	G_RefImGuiFreeFrame( &s_ImGuiFrames[1] );
+	s_ImGuiFrames[0].CmdLists.clear();
+	s_ImGuiFrames[1].CmdLists.clear();
+
+	// the null renderer never set up a backend
+	if ( N_stricmp( g_renderer->s, "null" ) ) {
+		ImGui_ImplOpenGL3_Shutdown();
+		ImGui_ImplSDL2_Shutdown();
+	}
 	ImGui::DestroyContext();
 	ImGui::SetCurrentContext( NULL );
 
@@ -226,8 +249,15 @@ static void G_RefImGuiNewFrame( void ) {
 		break;
 	};
 
-	ImGui_ImplOpenGL3_NewFrame();
-	ImGui_ImplSDL2_NewFrame();
+	if ( !N_stricmp( g_renderer->s, "null" ) ) {
+		// nothing to upload the font atlas to, but NewFrame still wants it built
+		if ( !io.Fonts->IsBuilt() ) {
+			io.Fonts->Build();
+		}
+	} else {
+		ImGui_ImplOpenGL3_NewFrame();
+		ImGui_ImplSDL2_NewFrame();
+	}
 	ImGui::NewFrame();
 }
 
@@ -245,10 +275,39 @@ static void G_SetScaling( float factor, uint32_t captureWidth, uint32_t captureH
 	gi.captureHeight = captureHeight;
 }
 
-static void G_RefImGuiDraw( void ) {
-	// draw imgui
+static uint64_t G_RefMicroseconds( void ) {
+	const uint64_t nCounter = SDL_GetPerformanceCounter();
+	const uint64_t nFrequency = SDL_GetPerformanceFrequency();
+
+	// split up so the multiply can't overflow after a few hours of uptime
+	return ( nCounter / nFrequency ) * 1000000 + ( ( nCounter % nFrequency ) * 1000000 ) / nFrequency;
+}
+
+static void *G_RefImGuiEndFrame( void ) {
+	ImDrawData *pFrame;
+	const ImDrawData *pDrawData;
+	int i;
+
 	ImGui::Render();
-	ImGui_ImplOpenGL3_RenderDrawData( ImGui::GetDrawData() );
+	pDrawData = ImGui::GetDrawData();
+
+	pFrame = &s_ImGuiFrames[ s_nImGuiFrame ];
+	s_nImGuiFrame ^= 1;
+
+	G_RefImGuiFreeFrame( pFrame );
+	*pFrame = *pDrawData;
+	for ( i = 0; i < pFrame->CmdLists.Size; i++ ) {
+		pFrame->CmdLists[i] = pDrawData->CmdLists[i]->CloneOutput();
+	}
+
+	return pFrame;
+}
+
+static void G_RefImGuiDraw( void *drawData ) {
+	// draw imgui
+	if ( drawData ) {
+		ImGui_ImplOpenGL3_RenderDrawData( (ImDrawData *)drawData );
+	}
 }
 
 //
@@ -523,6 +582,14 @@ static void G_InitRenderRef( void )
 	import.GLimp_Shutdown = GLimp_Shutdown;
 	import.GLimp_Minimize = GLimp_Minimize;
 	import.GLimp_HideFullscreenWindow = GLimp_HideFullscreenWindow;
+	import.GLimp_SpawnRenderThread = GLimp_SpawnRenderThread;
+	import.GLimp_ShutdownRenderThread = GLimp_ShutdownRenderThread;
+	import.Job_Add = G_AddRenderJob;
+	import.Job_GetFinished = G_GetFinishedRenderJob;
+	import.Job_NumWorkers = G_NumRenderJobWorkers;
+	import.GLimp_RenderSleep = GLimp_RenderSleep;
+	import.GLimp_FrontEndSleep = GLimp_FrontEndSleep;
+	import.GLimp_WakeRenderer = GLimp_WakeRenderer;
 	import.GL_GetProcAddress = GL_GetProcAddress;
 #endif
 
@@ -536,13 +603,17 @@ static void G_InitRenderRef( void )
 	import.GLM_MakeVPM = GLM_MakeVPM;
 
 	import.Milliseconds = Sys_Milliseconds;
+	import.Microseconds = G_RefMicroseconds;
 
 	import.Key_IsDown = Key_IsDown;
 
 	import.FS_LoadFile = FS_LoadFile;
 	import.FS_FreeFile = FS_FreeFile;
+	import.FS_LoadFileView = FS_LoadFileView;
+	import.FS_FreeFileView = FS_FreeFileView;
 	import.FS_WriteFile = FS_WriteFile;
 	import.FS_FileExists = FS_FileExists;
+	import.FS_FileInPathExists = FS_FileInPathExists;
 	import.FS_FreeFileList = FS_FreeFileList;
 	import.FS_ListFiles = FS_ListFiles;
 	import.FS_FOpenRead = FS_FOpenRead;
@@ -568,6 +639,7 @@ static void G_InitRenderRef( void )
 	import.ImGui_Init = G_RefImGuiInit;
 	import.ImGui_Shutdown = G_RefImGuiShutdown;
 	import.ImGui_NewFrame = G_RefImGuiNewFrame;
+	import.ImGui_EndFrame = G_RefImGuiEndFrame;
 	import.ImGui_Draw = G_RefImGuiDraw;
 
 	import.Sys_LoadDLL = Sys_LoadDLL;
@@ -661,6 +733,7 @@ void G_ShutdownRenderer( refShutdownCode_t code )
 		PROFILE_SCOPE( "Renderer Shutdown" );
 		re.Shutdown( code );
 	}
+	G_ShutdownRenderJobs();
 
 	if ( renderLib ) {
 		Sys_CloseDLL( renderLib );
@@ -740,131 +813,6 @@ static void G_ViewMemory_f( void ) {
 }
 
 
-static void G_BeginRecord( void )
-{
-	version_t version;
-	int difficulty;
-	int cheat;
-	char mapname[64];
-	int length;
-	extern eastl::vector<char *> com_consoleLines;
-	extern int com_numConsoleLines;
-
-	version.m_nVersionMajor = NOMAD_VERSION;
-	version.m_nVersionUpdate = NOMAD_VERSION_UPDATE;
-	version.m_nVersionPatch = NOMAD_VERSION_PATCH;
-
-	memset( mapname, 0, sizeof( mapname ) );
-	Cvar_VariableStringBuffer( "mapname", mapname, sizeof( mapname ) - 1 );
-
-	difficulty = Cvar_VariableInteger( "sgame_Difficulty" );
-
-	FS_Write( &version, sizeof( version ), gi.recordfile );
-
-	length = strlen( FS_ReferencedBFFNames() ) + 1;
-	FS_Write( &length, sizeof( length ), gi.recordfile );
-	FS_Write( FS_ReferencedBFFNames(), length, gi.recordfile );
-
-	// write the command line
-	FS_Write( &com_numConsoleLines, sizeof( com_numConsoleLines ), gi.recordfile );
-	for ( const auto& it : com_consoleLines ) {
-		length = strlen( it ) + 1;
-		FS_Write( &length, sizeof( length ), gi.recordfile );
-		FS_Write( it, strlen( it ) + 1, gi.recordfile );
-	}
-
-	FS_Write( &difficulty, sizeof( difficulty ), gi.recordfile );
-	FS_Write( mapname, sizeof( mapname ), gi.recordfile );
-
-	// write cheats
-
-	cheat = Cvar_VariableInteger( "sgame_cheats_enabled" );
-	FS_Write( &cheat, sizeof( cheat ), gi.recordfile );
-
-	cheat = Cvar_VariableInteger( "sgame_cheat_BlindMobs" );
-	FS_Write( &cheat, sizeof( cheat ), gi.recordfile );
-
-	cheat = Cvar_VariableInteger( "sgame_cheat_DeafMobs" );
-	FS_Write( &cheat, sizeof( cheat ), gi.recordfile );
-	
-	cheat = Cvar_VariableInteger( "sgame_cheat_GodMode" );
-	FS_Write( &cheat, sizeof( cheat ), gi.recordfile );
-	
-	cheat = Cvar_VariableInteger( "sgame_cheat_InfiniteAmmo" );
-	FS_Write( &cheat, sizeof( cheat ), gi.recordfile );
-	
-	cheat = Cvar_VariableInteger( "sgame_cheat_InfiniteHealth" );
-	FS_Write( &cheat, sizeof( cheat ), gi.recordfile );
-	
-	cheat = Cvar_VariableInteger( "sgame_cheat_InfiniteRage" );
-	FS_Write( &cheat, sizeof( cheat ), gi.recordfile );
-}
-
-static void G_BeginDemoPlay( void )
-{
-	version_t version;
-	int difficulty;
-	int cheat;
-	char mapname[64];
-	int length;
-	char *referencedBffs;
-	char **commandLine;
-	int numLines, i;
-
-	FS_Read( &version, sizeof( version ), gi.demofile );
-
-	FS_Read( &length, sizeof( length ), gi.demofile );
-	referencedBffs = (char *)Z_Malloc( length, TAG_STATIC );
-	FS_Read( referencedBffs, length, gi.demofile );
-
-	FS_Read( &numLines, sizeof( numLines ), gi.demofile );
-	commandLine = (char **)Z_Malloc( sizeof( *commandLine ) * numLines, TAG_STATIC );
-	for ( i = 0; i < numLines; i++ ) {
-		FS_Read( &length, sizeof( length ), gi.demofile );
-		commandLine[i] = (char *)Z_Malloc( length, TAG_STATIC );
-		FS_Read( commandLine[i], length, gi.demofile );
-	}
-
-	FS_Read( &difficulty, sizeof( difficulty ), gi.demofile );
-	FS_Read( mapname, sizeof( mapname ), gi.demofile );
-
-	FS_Read( &cheat, sizeof( cheat ), gi.demofile );
-	Cvar_SetIntegerValue( "sgame_cheats_enabled", cheat );
-
-	FS_Read( &cheat, sizeof( cheat ), gi.demofile );
-	Cvar_SetIntegerValue( "sgame_cheat_BlindMobs", cheat );
-
-	FS_Read( &cheat, sizeof( cheat ), gi.demofile );
-	Cvar_SetIntegerValue( "sgame_cheat_DeafMobs", cheat );
-
-	FS_Read( &cheat, sizeof( cheat ), gi.demofile );
-	Cvar_SetIntegerValue( "sgame_cheat_GodMode", cheat );
-	
-	FS_Read( &cheat, sizeof( cheat ), gi.demofile );
-	Cvar_SetIntegerValue( "sgame_cheat_InfiniteAmmo", cheat );
-
-	FS_Read( &cheat, sizeof( cheat ), gi.demofile );
-	Cvar_SetIntegerValue( "sgame_cheat_InfiniteHealth", cheat );
-
-	FS_Read( &cheat, sizeof( cheat ), gi.demofile );
-	Cvar_SetIntegerValue( "sgame_cheat_InfiniteRage", cheat );
-
-	Con_Printf( "--------------------------------\n" );
-	Con_Printf( "Demo Playback Begun\n" );
-	Con_Printf( "--------------------------------\n" );
-	Con_Printf( "version: v%hu.%hu.%u\n", version.m_nVersionMajor, version.m_nVersionUpdate, version.m_nVersionPatch );
-	Con_Printf( "referenced bffs: %s\n", referencedBffs );
-	Con_Printf( "difficulty: %i\n", difficulty );
-	Con_Printf( "map: %s\n", mapname );
-	Con_Printf( "--------------------------------\n" );
-
-	Z_Free( referencedBffs );
-	for ( i = 0; i < numLines; i++ ) {
-		Z_Free( commandLine[i] );
-	}
-	Z_Free( commandLine );
-}
-
 /*
 ====================
 G_Record_f
@@ -898,6 +846,11 @@ static void G_Record_f( void ) {
 		return;
 	}
 
+	if ( gi.demoplaying ) {
+		Con_Printf( "Can't record while playing a demo.\n" );
+		return;
+	}
+
 	if ( Cmd_Argc() == 2 ) {
 		// explicit demo name specified
 		N_strncpyz( demoName, Cmd_Argv( 1 ), sizeof( demoName ) );
@@ -956,7 +909,7 @@ static void G_Record_f( void ) {
 	gi.demowaiting = qtrue;
 
 	// write out initial data
-	G_BeginRecord();
+	G_BeginDemoRecord( gi.recordfile );
 }
 
 
@@ -1022,9 +975,36 @@ static void G_DemoCompleted( void ) {
 			Con_Printf( "%i frames, %3.*f seconds: %3.1f fps\n", gi.timeDemoFrames,
 			time > 10000 ? 1 : 2, time/1000.0, gi.timeDemoFrames*1000.0 / time );
 		}
+		G_TimeDemoCompleted();
 	}
 
 	G_NextDemo();
+
+	// benchmark runs exit on their own once the last demo's done
+	if ( com_timedemo->i && G_TimeDemoShouldQuit() ) {
+		Cbuf_AddText( "quit\n" );
+	}
+}
+
+/*
+=================
+G_StopDemo
+
+Called when a demo runs out of frames or can't be read anymore
+=================
+*/
+void G_StopDemo( void ) {
+	if ( !gi.demoplaying ) {
+		return;
+	}
+
+	G_EndDemoPlayback();
+
+	FS_FClose( gi.demofile );
+	gi.demofile = FS_INVALID_HANDLE;
+	gi.demoplaying = qfalse;
+
+	G_DemoCompleted();
 }
 
 /*
@@ -1105,6 +1085,8 @@ void G_StopRecord_f( void ) {
 		char finalName[MAX_OSPATH];
 		int	len, sequence;
 
+		G_EndDemoRecord();
+
 		FS_FClose( gi.recordfile );
 		gi.recordfile = FS_INVALID_HANDLE;
 
@@ -1135,59 +1117,6 @@ void G_StopRecord_f( void ) {
 	gi.spDemoRecording = qfalse;
 }
 
-static void G_WriteGamestate( void )
-{
-	FS_Write( glm::value_ptr( gi.cameraPos ), sizeof( gi.cameraPos ), gi.recordfile );
-	FS_Write( &gi.cameraZoom, sizeof( gi.cameraZoom ), gi.recordfile );
-	FS_Write( &gi.demoNumEvents, sizeof( gi.demoNumEvents ), gi.recordfile );
-}
-
-void G_RecordEvent( const sysEvent_t *ev )
-{
-	FS_Write( &ev->evTime, sizeof( ev->evTime ), gi.recordfile );
-	FS_Write( &ev->evType, sizeof( ev->evType ), gi.recordfile );
-	FS_Write( &ev->evValue, sizeof( ev->evValue ), gi.recordfile );
-	FS_Write( &ev->evValue2, sizeof( ev->evValue2 ), gi.recordfile );
-	FS_Write( &ev->evPtrLength, sizeof( ev->evPtrLength ), gi.recordfile );
-
-	if ( ev->evPtrLength > 0 ) {
-		FS_Write( ev->evPtr, ev->evPtrLength, gi.recordfile );
-	}
-
-	gi.demoNumEvents++;
-}
-
-static void G_ReadDemoEvents( void )
-{
-	sysEvent_t ev;
-	int i;
-
-	for ( i = 0; i < gi.demoNumEvents; i++ ) {
-		FS_Read( &ev.evTime, sizeof( ev.evTime ), gi.demofile );
-		FS_Read( &ev.evType, sizeof( ev.evType ), gi.demofile );
-		FS_Read( &ev.evValue, sizeof( ev.evValue ), gi.demofile );
-		FS_Read( &ev.evValue2, sizeof( ev.evValue2 ), gi.demofile );
-		FS_Read( &ev.evPtrLength, sizeof( ev.evPtrLength ), gi.demofile );
-
-		ev.evPtr = NULL;
-		if ( ev.evPtrLength ) {
-			ev.evPtr = Z_Malloc( ev.evPtrLength, TAG_STATIC );
-			FS_Read( ev.evPtr, ev.evPtrLength, gi.demofile );
-		}
-
-		Com_QueueEvent( ev.evTime, ev.evType, ev.evValue, ev.evValue2, ev.evPtrLength, ev.evPtr );
-	}
-}
-
-static void G_ReadGamestate( void )
-{
-	FS_Read( glm::value_ptr( gi.cameraPos ), sizeof( gi.cameraPos ), gi.demofile );
-	FS_Read( &gi.cameraZoom, sizeof( gi.cameraZoom ), gi.demofile );
-	FS_Read( &gi.demoNumEvents, sizeof( gi.demoNumEvents ), gi.demofile );
-
-	G_ReadDemoEvents();
-}
-
 /*
 ==================
 G_PlayDemo_f
@@ -1210,6 +1139,18 @@ static void G_PlayDemo_f( void )
 		return;
 	}
 
+	if ( gi.demorecording ) {
+		Con_Printf( "Can't play a demo while recording.\n" );
+		return;
+	}
+
+	if ( gi.demoplaying ) {
+		G_EndDemoPlayback();
+		FS_FClose( gi.demofile );
+		gi.demofile = FS_INVALID_HANDLE;
+		gi.demoplaying = qfalse;
+	}
+
 	// open the demo file
 	arg = Cmd_Argv( 1 );
 
@@ -1247,6 +1188,12 @@ static void G_PlayDemo_f( void )
 
 	N_strncpyz( gi.demoName, shortname, sizeof( gi.demoName ) );
 
+	if ( !G_BeginDemoPlayback( gi.demofile, name ) ) {
+		FS_FClose( gi.demofile );
+		gi.demofile = FS_INVALID_HANDLE;
+		return;
+	}
+
 	Con_Close();
 	
 	gi.state = GS_LEVEL;
@@ -1256,8 +1203,6 @@ static void G_PlayDemo_f( void )
 	// time from the gamestate load from messing causing a time skip
 	gi.firstDemoFrameSkipped = qfalse;
 
-	G_BeginDemoPlay();
-
 	UI_SetActiveMenu( UI_MENU_NONE );
 }
 
@@ -1822,6 +1767,108 @@ static void G_SetSkin_f( void )
 	Cvar_Set( "skin", s->name );
 }
 
+static void G_FreeSkins( void )
+{
+	skin_t *skin, *next;
+
+	for ( skin = s_pSkinList; skin; skin = next ) {
+		next = skin->next;
+		Z_Free( skin );
+	}
+	s_pSkinList = NULL;
+}
+
+typedef struct {
+	uint64_t missSyscalls;
+	uint64_t missUsec;
+	uint64_t cachedMissSyscalls;
+	uint64_t cachedMissUsec;
+	uint64_t skinsUsec;
+	uint64_t restartUsec;
+} indexBench_t;
+
+/*
+* G_IndexBenchMisses: makes the same lookups R_LoadImage does for an image that doesn't exist, a dds first
+* and then every loader's extension
+*/
+static void G_IndexBenchMisses( uint32_t nImages, uint64_t *syscalls, uint64_t *usec )
+{
+	static const char *imageExts[] = { "dds", "png", "tga", "jpg", "jpeg", "pcx", "bmp" };
+	fileHandle_t fd;
+	uint32_t i, j;
+
+	*syscalls = FS_LookupSyscalls();
+	*usec = G_RefMicroseconds();
+	for ( i = 0; i < nImages; i++ ) {
+		for ( j = 0; j < arraylen( imageExts ); j++ ) {
+			FS_FOpenFileRead( va( "textures/indexbench/missing%u.%s", i, imageExts[j] ), &fd );
+			if ( fd != FS_INVALID_HANDLE ) {
+				FS_FClose( fd );
+			}
+		}
+	}
+	*usec = G_RefMicroseconds() - *usec;
+	*syscalls = FS_LookupSyscalls() - *syscalls;
+}
+
+/*
+* G_IndexBench_f: fs_indexbench [images] [restart], runs the same loads with the asset index turned off and on.
+* Counts the syscalls made for R_LoadImage misses, the first time and once they're cached, and times
+* G_LoadSkins and, with "restart", a renderer restart which reloads every shader and texture
+*/
+static void G_IndexBench_f( void )
+{
+	indexBench_t results[2];
+	char oldValue[ MAX_CVAR_VALUE ];
+	uint32_t nImages, pass;
+	qboolean restart;
+	uint64_t start;
+
+	nImages = 256;
+	if ( Cmd_Argc() > 1 ) {
+		nImages = MAX( 1, atoi( Cmd_Argv( 1 ) ) );
+	}
+	restart = Cmd_Argc() > 2 && !N_stricmp( Cmd_Argv( 2 ), "restart" ) && gi.rendererStarted;
+
+	N_strncpyz( oldValue, Cvar_VariableString( "fs_assetIndex" ), sizeof( oldValue ) );
+	if ( !atoi( oldValue ) ) {
+		Con_Printf( "fs_indexbench: fs_assetIndex is off, set it and \\fs_restart to build the index first\n" );
+		return;
+	}
+
+	for ( pass = 0; pass < 2; pass++ ) {
+		Cvar_Set( "fs_assetIndex", pass ? "1" : "0" );
+		FS_FlushMissingFiles();
+
+		G_IndexBenchMisses( nImages, &results[ pass ].missSyscalls, &results[ pass ].missUsec );
+		G_IndexBenchMisses( nImages, &results[ pass ].cachedMissSyscalls, &results[ pass ].cachedMissUsec );
+
+		G_FreeSkins();
+		start = G_RefMicroseconds();
+		G_LoadSkins();
+		results[ pass ].skinsUsec = G_RefMicroseconds() - start;
+
+		results[ pass ].restartUsec = 0;
+		if ( restart ) {
+			start = G_RefMicroseconds();
+			G_Vid_Restart( REF_KEEP_CONTEXT );
+			results[ pass ].restartUsec = G_RefMicroseconds() - start;
+		}
+	}
+
+	Cvar_Set( "fs_assetIndex", oldValue );
+
+	Con_Printf( "fs_indexbench: %u missing images\n", nImages );
+	Con_Printf( "%-8s %14s %12s %14s %12s %12s %12s\n", "index", "syscalls/miss", "miss usec", "cached/miss",
+		"cached usec", "skins usec", "restart usec" );
+	for ( pass = 0; pass < 2; pass++ ) {
+		Con_Printf( "%-8s %14.2f %12lu %14.2f %12lu %12lu %12lu\n", pass ? "on" : "off",
+			(double)results[ pass ].missSyscalls / nImages, results[ pass ].missUsec,
+			(double)results[ pass ].cachedMissSyscalls / nImages, results[ pass ].cachedMissUsec,
+			results[ pass ].skinsUsec, results[ pass ].restartUsec );
+	}
+}
+
 static void G_InitRenderer_Cvars( void )
 {
 	cvar_t *temp;
@@ -1930,7 +1977,7 @@ static void G_InitRenderer_Cvars( void )
 
 	g_renderer = Cvar_Get( "g_renderer", "opengl", CVAR_SAVE | CVAR_LATCH );
 	Cvar_SetDescription( g_renderer,
-						"Set your desired renderer, valid options: opengl, vulkan, sdl2, d3d11\n"
+						"Set your desired renderer, valid options: opengl, vulkan, sdl2, d3d11, null\n"
 						"NOTICE: Vulkan, SDL2, and DirectX 11 rendering not supported yet... *will be tho soon :)*\n"
 						"requires \\vid_restart when changed"
 		);
@@ -1993,6 +2040,7 @@ void G_Init( void )
 	//
 
 	Cmd_AddCommand( "gameinfo", G_GameInfo_f );
+	G_InitDemos();
 	Cmd_AddCommand( "demo", G_PlayDemo_f );
 	Cmd_SetCommandCompletionFunc( "demo", G_CompleteDemoName );
 	Cmd_AddCommand( "record", G_Record_f );
@@ -2013,6 +2061,10 @@ void G_Init( void )
 	Cmd_AddCommand( "opened_bffs", G_OpenedBFFList_f );
 	Cmd_AddCommand( "setskin", G_SetSkin_f );
 	Cmd_AddCommand( "skinlist", G_ListSkins_f );
+	Cmd_AddCommand( "fs_indexbench", G_IndexBench_f );
+	Cmd_AddCommand( "world_bench", G_WorldBench_f );
+	Cmd_AddCommand( "nav_bench", G_NavBench_f );
+	Cmd_AddCommand( "flow_bench", G_FlowBench_f );
 
 #ifdef USE_MD5
 	G_GenerateGameKey();
@@ -2053,6 +2105,7 @@ void G_Shutdown( qboolean quit )
 	}
 
 	Cmd_RemoveCommand( "gameinfo" );
+	G_ShutdownDemos();
 	Cmd_RemoveCommand( "demo" );
 	Cmd_RemoveCommand( "record" );
 	Cmd_RemoveCommand( "stoprecord" );
@@ -2071,6 +2124,10 @@ void G_Shutdown( qboolean quit )
 	Cmd_RemoveCommand( "opened_bffs" );
 	Cmd_RemoveCommand( "setskin" );
 	Cmd_RemoveCommand( "skinlist" );
+	Cmd_RemoveCommand( "fs_indexbench" );
+	Cmd_RemoveCommand( "world_bench" );
+	Cmd_RemoveCommand( "nav_bench" );
+	Cmd_RemoveCommand( "flow_bench" );
 
 	Key_SetCatcher( 0 );
 	Con_Printf( "-------------------------------\n" );
@@ -2099,6 +2156,7 @@ void G_ShutdownVMs( qboolean quit ) {
 
 	G_ShutdownUI();
 	g_pModuleLib->Shutdown( quit );
+	Cvar_ClearWatches();
 
 	gi.uiStarted = qfalse;
 	gi.sgameStarted = qfalse;
@@ -2151,6 +2209,7 @@ void G_ShutdownAll( void )
 	G_ShutdownVMs( qfalse );
 
 	Cmd_RemoveCommand( "gameinfo" );
+	G_ShutdownDemos();
 	Cmd_RemoveCommand( "demo" );
 	Cmd_RemoveCommand( "record" );
 	Cmd_RemoveCommand( "stoprecord" );
@@ -2298,9 +2357,12 @@ void G_Frame( int msec, int realMsec )
 
 	if ( gi.state == GS_LEVEL ) {
 		if ( gi.demorecording && gi.recordfile != FS_INVALID_HANDLE ) {
-			G_WriteGamestate();
+			G_RecordDemoFrame( msec );
 		} else if ( gi.demoplaying && gi.demofile != FS_INVALID_HANDLE ) {
-			G_ReadGamestate();
+			// the level gets the same events and frame time it got when it was recorded
+			if ( !G_PlayDemoFrame( &msec ) ) {
+				G_StopDemo();
+			}
 		}
 	}
 	
@@ -2316,10 +2378,25 @@ void G_Frame( int msec, int realMsec )
 
 	SteamApp_Frame();
 
+	// run queued path searches and follow the player with the flow field
+	if ( gi.state == GS_LEVEL && g_pNavMesh ) {
+		g_pNavMesh->Update();
+		g_pFlowField->Update();
+	}
+
 	// update the screen
 	gi.framecount++;
 	SCR_UpdateScreen();
 
+	// collect script garbage once the frame's module calls are done
+	if ( g_pModuleLib ) {
+		g_pModuleLib->RunGarbageCollector();
+	}
+
+	if ( gi.state == GS_LEVEL && gi.demorecording && gi.recordfile != FS_INVALID_HANDLE ) {
+		G_RecordDemoKeyframe();
+	}
+
 	// update audio
 	Snd_Update( realMsec );
 
@@ -76,6 +76,9 @@ typedef struct {
 	uint32_t numLevels;
 } mapinfo_t;
 
+// linkEntity_t flags, kept in sync by the sgame
+#define LINKFLAG_DEAD 0x0001 // rays pass through it
+
 #pragma pack( push, 1 )
 typedef struct linkEntity_s {
 	bbox_t bounds;
@@ -83,6 +86,7 @@ typedef struct linkEntity_s {
 	uint32_t entityNumber;
 	uint32_t id;
 	uint32_t type;
+	uint32_t flags;
 	struct linkEntity_s *next;
 	struct linkEntity_s *prev;
 } linkEntity_t;
@@ -375,7 +379,8 @@ void GLimp_Minimize( void );
 qboolean G_CheckPaused( void );
 qboolean G_CheckWallHit( const vec3_t origin, dirtype_t dir );
 void G_SetCameraData( const vec2_t origin, float zoom, float rotation );
-void G_RecordEvent( const sysEvent_t *ev );
+void G_StopRecord_f( void );
+void G_StopDemo( void );
 void G_GetSkinData(
 	const char *pSkinName,
 	char *pszDescription,
@@ -384,6 +389,30 @@ void G_GetSkinData(
 	uvec2_t armsSheetSize, uvec2_t armsSpritesize,
 	uvec2_t legsSheetSize, uvec2_t legsSpriteSize );
 
+//
+// g_demo.cpp
+//
+void G_InitDemos( void );
+void G_ShutdownDemos( void );
+void G_BeginDemoRecord( fileHandle_t hFile );
+void G_EndDemoRecord( void );
+void G_RecordEvent( const sysEvent_t *ev );
+void G_RecordDemoFrame( int msec );
+void G_RecordDemoKeyframe( void );
+qboolean G_BeginDemoPlayback( fileHandle_t hFile, const char *name );
+void G_EndDemoPlayback( void );
+qboolean G_PlayDemoFrame( int *msec );
+uint32_t G_DemoTargetUsec( uint32_t targetUsec );
+
+//
+// g_timedemo.cpp
+//
+void G_InitTimeDemo( void );
+void G_ShutdownTimeDemo( void );
+void G_TimeDemoFrame( void );
+void G_TimeDemoCompleted( void );
+qboolean G_TimeDemoShouldQuit( void );
+
 //
 // g_threads.cpp
 //
@@ -391,6 +420,11 @@ qboolean GLimp_SpawnRenderThread( void (*function)( void ) );
 void *GLimp_RenderSleep( void );
 void GLimp_FrontEndSleep( void );
 void GLimp_WakeRenderer( void *data );
+void GLimp_ShutdownRenderThread( void );
+qboolean G_AddRenderJob( void (*function)( void *data ), void *data );
+void *G_GetFinishedRenderJob( qboolean wait );
+uint32_t G_NumRenderJobWorkers( void );
+void G_ShutdownRenderJobs( void );
 
 //
 // g_world.cpp
@@ -3,8 +3,166 @@
 
 extern cvar_t *sys_forceSingleThreading;
 
+//
+// the render thread owns the gl context while it's executing a frame's command list, the front end
+// gets the context back from GLimp_FrontEndSleep and hands it over again with GLimp_WakeRenderer
+//
+
 #ifdef _WIN32
 
+// no pthreads here, so this is the same handshake built on sdl's primitives
+static SDL_mutex *smpMutex;
+static SDL_cond *renderCommandsEvent;
+static SDL_cond *renderCompletedEvent;
+
+static void (*glimpRenderThread)( void );
+
+extern SDL_Window *SDL_window;
+extern SDL_GLContext SDL_glContext;
+
+static volatile void *smpData = NULL;
+static volatile qboolean smpDataReady;
+static qboolean smpThreadSleeping; // set once the thread first reaches GLimp_RenderSleep
+
+static int GLimp_RenderThreadWrapper( void *arg )
+{
+	Con_Printf( "Render thread starting\n" );
+
+	glimpRenderThread();
+
+	SDL_GL_MakeCurrent( SDL_window, NULL );
+
+	Con_Printf( "Render thread terminating\n" );
+
+	SDL_LockMutex( smpMutex );
+	{
+		glimpRenderThread = NULL;
+
+		// after this, GLimp_ShutdownRenderThread can take the context back
+		SDL_CondSignal( renderCompletedEvent );
+	}
+	SDL_UnlockMutex( smpMutex );
+
+	return 0;
+}
+
+qboolean GLimp_SpawnRenderThread( void (*function)( void ) )
+{
+	SDL_Thread *renderThread;
+
+	if ( glimpRenderThread ) {
+		return qtrue;
+	}
+
+	if ( !smpMutex ) {
+		smpMutex = SDL_CreateMutex();
+		renderCommandsEvent = SDL_CreateCond();
+		renderCompletedEvent = SDL_CreateCond();
+	}
+
+	glimpRenderThread = function;
+	smpThreadSleeping = qfalse;
+
+	renderThread = SDL_CreateThread( GLimp_RenderThreadWrapper, "RenderThread", NULL );
+	if ( !renderThread ) {
+		Con_Printf( "SDL_CreateThread() failed: %s\n", SDL_GetError() );
+		glimpRenderThread = NULL;
+		return qfalse;
+	}
+	SDL_DetachThread( renderThread );
+
+	// a frame handed over before the thread is waiting for one would get lost
+	SDL_LockMutex( smpMutex );
+	{
+		while ( !smpThreadSleeping ) {
+			SDL_CondWait( renderCompletedEvent, smpMutex );
+		}
+	}
+	SDL_UnlockMutex( smpMutex );
+
+	return qtrue;
+}
+
+void *GLimp_RenderSleep( void )
+{
+	void *data;
+
+	SDL_GL_MakeCurrent( SDL_window, NULL );
+
+	SDL_LockMutex( smpMutex );
+	{
+		smpData = NULL;
+		smpDataReady = qfalse;
+		smpThreadSleeping = qtrue;
+
+		// after this, the front end can exit GLimp_FrontEndSleep
+		SDL_CondSignal( renderCompletedEvent );
+
+		while ( !smpDataReady ) {
+			SDL_CondWait( renderCommandsEvent, smpMutex );
+		}
+
+		data = (void *)smpData;
+	}
+	SDL_UnlockMutex( smpMutex );
+
+	SDL_GL_MakeCurrent( SDL_window, SDL_glContext );
+
+	return data;
+}
+
+void GLimp_FrontEndSleep( void )
+{
+	SDL_LockMutex( smpMutex );
+	{
+		while ( smpData ) {
+			SDL_CondWait( renderCompletedEvent, smpMutex );
+		}
+	}
+	SDL_UnlockMutex( smpMutex );
+
+	SDL_GL_MakeCurrent( SDL_window, SDL_glContext );
+}
+
+void GLimp_WakeRenderer( void *data )
+{
+	SDL_GL_MakeCurrent( SDL_window, NULL );
+
+	SDL_LockMutex( smpMutex );
+	{
+		assert( smpData == NULL );
+		smpData = data;
+		smpDataReady = qtrue;
+
+		// after this, the renderer can continue through GLimp_RenderSleep
+		SDL_CondSignal( renderCommandsEvent );
+	}
+	SDL_UnlockMutex( smpMutex );
+}
+
+/*
+* GLimp_ShutdownRenderThread: the front end has to be synced with the render thread before calling this,
+* a NULL frame makes the thread return and we wait for it to release the context
+*/
+void GLimp_ShutdownRenderThread( void )
+{
+	if ( !glimpRenderThread ) {
+		return;
+	}
+
+	GLimp_WakeRenderer( NULL );
+
+	SDL_LockMutex( smpMutex );
+	{
+		while ( glimpRenderThread ) {
+			SDL_CondWait( renderCompletedEvent, smpMutex );
+		}
+	}
+	SDL_UnlockMutex( smpMutex );
+
+	SDL_GL_MakeCurrent( SDL_window, SDL_glContext );
+}
+
 #else
 #include <pthread.h>
 
@@ -20,6 +178,10 @@ static void (*glimpRenderThread)( void );
 extern SDL_Window *SDL_window;
 extern SDL_GLContext SDL_glContext;
 
+static volatile void *smpData = NULL;
+static volatile qboolean smpDataReady;
+static qboolean smpThreadSleeping; // set once the thread first reaches GLimp_RenderSleep
+
 static void *GLimp_RenderThreadWrapper( void *arg )
 {
 	Con_Printf( "Render thread starting\n" );
@@ -30,7 +192,14 @@ static void *GLimp_RenderThreadWrapper( void *arg )
 
 	Con_Printf( "Render thread terminating\n" );
 
-	glimpRenderThread = NULL;
+	pthread_mutex_lock( &smpMutex );
+	{
+		glimpRenderThread = NULL;
+
+		// after this, GLimp_ShutdownRenderThread can take the context back
+		pthread_cond_signal( &renderCompletedEvent );
+	}
+	pthread_mutex_unlock( &smpMutex );
 
 	return arg;
 }
@@ -50,10 +219,12 @@ qboolean GLimp_SpawnRenderThread( void (*function)( void ) )
 	pthread_cond_init( &renderCompletedEvent, NULL );
 
 	glimpRenderThread = function;
+	smpThreadSleeping = qfalse;
 
 	ret = pthread_create( &renderThread, NULL, GLimp_RenderThreadWrapper, NULL );
 	if ( ret ) {
 		Con_Printf( "pthread_create() returned %i: %s\n", ret, strerror( errno ) );
+		glimpRenderThread = NULL;
 		return qfalse;
 	} else {
 		ret = pthread_detach( renderThread );
@@ -62,12 +233,18 @@ qboolean GLimp_SpawnRenderThread( void (*function)( void ) )
 		}
 	}
 
+	// a frame handed over before the thread is waiting for one would get lost
+	pthread_mutex_lock( &smpMutex );
+	{
+		while ( !smpThreadSleeping ) {
+			pthread_cond_wait( &renderCompletedEvent, &smpMutex );
+		}
+	}
+	pthread_mutex_unlock( &smpMutex );
+
 	return qtrue;
 }
 
-static volatile void *smpData = NULL;
-static volatile qboolean smpDataReady;
-
 void *GLimp_RenderSleep( void )
 {
 	void *data;
@@ -78,6 +255,7 @@ void *GLimp_RenderSleep( void )
 	{
 		smpData = NULL;
 		smpDataReady = qfalse;
+		smpThreadSleeping = qtrue;
 
 		// after this, the front end can exit GLimp_FrontEndSleep
 		pthread_cond_signal( &renderCompletedEvent );
@@ -123,4 +301,207 @@ void GLimp_WakeRenderer( void *data )
 	}
 	pthread_mutex_unlock( &smpMutex );
 }
-#endif
\ No newline at end of file
+
+/*
+* GLimp_ShutdownRenderThread: the front end has to be synced with the render thread before calling this,
+* a NULL frame makes the thread return and we wait for it to release the context
+*/
+void GLimp_ShutdownRenderThread( void )
+{
+	if ( !glimpRenderThread ) {
+		return;
+	}
+
+	GLimp_WakeRenderer( NULL );
+
+	pthread_mutex_lock( &smpMutex );
+	{
+		while ( glimpRenderThread ) {
+			pthread_cond_wait( &renderCompletedEvent, &smpMutex );
+		}
+	}
+	pthread_mutex_unlock( &smpMutex );
+
+	SDL_GL_MakeCurrent( SDL_window, SDL_glContext );
+}
+#endif
+//
+// worker threads for the renderer's background jobs (image decoding and the like), jobs are run in the
+// order they're queued and come back through G_GetFinishedRenderJob once they're done. The renderer is
+// the only one draining the finished list, so it has to be called from the thread that queued them
+//
+
+#define MAX_RENDER_JOB_WORKERS 8
+#define MAX_RENDER_JOBS 2048
+
+typedef struct {
+	void (*function)( void *data );
+	void *data;
+} renderJob_t;
+
+static SDL_mutex *renderJobMutex;
+static SDL_cond *renderJobQueued;
+static SDL_cond *renderJobFinished;
+static SDL_Thread *renderJobWorkers[ MAX_RENDER_JOB_WORKERS ];
+static uint32_t numRenderJobWorkers;
+static qboolean renderJobsQuit;
+
+static renderJob_t pendingRenderJobs[ MAX_RENDER_JOBS ];
+static uint32_t pendingRenderJobHead, pendingRenderJobTail;
+static void *finishedRenderJobs[ MAX_RENDER_JOBS ];
+static uint32_t finishedRenderJobHead, finishedRenderJobTail;
+static uint32_t numOutstandingRenderJobs; // queued, running or finished and not picked up yet
+
+static int G_RenderJobWorker( void *arg )
+{
+	renderJob_t job;
+
+	SDL_LockMutex( renderJobMutex );
+	for ( ;; ) {
+		while ( pendingRenderJobHead == pendingRenderJobTail && !renderJobsQuit ) {
+			SDL_CondWait( renderJobQueued, renderJobMutex );
+		}
+		if ( renderJobsQuit ) {
+			break;
+		}
+
+		job = pendingRenderJobs[ pendingRenderJobHead % MAX_RENDER_JOBS ];
+		pendingRenderJobHead++;
+		SDL_UnlockMutex( renderJobMutex );
+
+		job.function( job.data );
+
+		SDL_LockMutex( renderJobMutex );
+		finishedRenderJobs[ finishedRenderJobTail % MAX_RENDER_JOBS ] = job.data;
+		finishedRenderJobTail++;
+		SDL_CondBroadcast( renderJobFinished );
+	}
+	SDL_UnlockMutex( renderJobMutex );
+
+	return 0;
+}
+
+static void G_InitRenderJobs( void )
+{
+	uint32_t nWorkers;
+
+	renderJobMutex = SDL_CreateMutex();
+	renderJobQueued = SDL_CreateCond();
+	renderJobFinished = SDL_CreateCond();
+	renderJobsQuit = qfalse;
+
+	// leave a core for the main thread
+	nWorkers = (uint32_t)MAX( 1, SDL_GetCPUCount() - 1 );
+	nWorkers = MIN( nWorkers, MAX_RENDER_JOB_WORKERS );
+
+	for ( numRenderJobWorkers = 0; numRenderJobWorkers < nWorkers; numRenderJobWorkers++ ) {
+		renderJobWorkers[ numRenderJobWorkers ] = SDL_CreateThread( G_RenderJobWorker, "RenderJob", NULL );
+		if ( !renderJobWorkers[ numRenderJobWorkers ] ) {
+			Con_Printf( "SDL_CreateThread() failed: %s\n", SDL_GetError() );
+			break;
+		}
+	}
+	Con_DPrintf( "Started %u render job workers\n", numRenderJobWorkers );
+}
+
+/*
+* G_AddRenderJob: queues function( data ) for one of the workers, if it returns qfalse the job wasn't
+* queued and the caller has to do the work itself
+*/
+qboolean G_AddRenderJob( void (*function)( void *data ), void *data )
+{
+	if ( sys_forceSingleThreading->i ) {
+		return qfalse;
+	}
+	if ( !renderJobMutex ) {
+		G_InitRenderJobs();
+	}
+	if ( !numRenderJobWorkers ) {
+		return qfalse;
+	}
+
+	SDL_LockMutex( renderJobMutex );
+	if ( numOutstandingRenderJobs == MAX_RENDER_JOBS ) {
+		SDL_UnlockMutex( renderJobMutex );
+		return qfalse;
+	}
+	pendingRenderJobs[ pendingRenderJobTail % MAX_RENDER_JOBS ].function = function;
+	pendingRenderJobs[ pendingRenderJobTail % MAX_RENDER_JOBS ].data = data;
+	pendingRenderJobTail++;
+	numOutstandingRenderJobs++;
+	SDL_CondSignal( renderJobQueued );
+	SDL_UnlockMutex( renderJobMutex );
+
+	return qtrue;
+}
+
+/*
+* G_GetFinishedRenderJob: returns the data of a job that's done, or NULL if there isn't one. With wait set it
+* blocks until one finishes and only returns NULL when nothing is outstanding at all
+*/
+void *G_GetFinishedRenderJob( qboolean wait )
+{
+	void *data;
+
+	if ( !renderJobMutex ) {
+		return NULL;
+	}
+
+	data = NULL;
+	SDL_LockMutex( renderJobMutex );
+	if ( wait ) {
+		while ( finishedRenderJobHead == finishedRenderJobTail && numOutstandingRenderJobs ) {
+			SDL_CondWait( renderJobFinished, renderJobMutex );
+		}
+	}
+	if ( finishedRenderJobHead != finishedRenderJobTail ) {
+		data = finishedRenderJobs[ finishedRenderJobHead % MAX_RENDER_JOBS ];
+		finishedRenderJobHead++;
+		numOutstandingRenderJobs--;
+	}
+	SDL_UnlockMutex( renderJobMutex );
+
+	return data;
+}
+
+uint32_t G_NumRenderJobWorkers( void )
+{
+	if ( sys_forceSingleThreading->i ) {
+		return 0;
+	}
+	if ( !renderJobMutex ) {
+		G_InitRenderJobs();
+	}
+	return numRenderJobWorkers;
+}
+
+/*
+* G_ShutdownRenderJobs: the renderer drains its jobs before it shuts down, so all that's left is the workers
+*/
+void G_ShutdownRenderJobs( void )
+{
+	uint32_t i;
+
+	if ( !renderJobMutex ) {
+		return;
+	}
+
+	SDL_LockMutex( renderJobMutex );
+	renderJobsQuit = qtrue;
+	SDL_CondBroadcast( renderJobQueued );
+	SDL_UnlockMutex( renderJobMutex );
+
+	for ( i = 0; i < numRenderJobWorkers; i++ ) {
+		SDL_WaitThread( renderJobWorkers[i], NULL );
+	}
+	numRenderJobWorkers = 0;
+
+	SDL_DestroyCond( renderJobFinished );
+	SDL_DestroyCond( renderJobQueued );
+	SDL_DestroyMutex( renderJobMutex );
+	renderJobMutex = NULL;
+
+	pendingRenderJobHead = pendingRenderJobTail = 0;
+	finishedRenderJobHead = finishedRenderJobTail = 0;
+	numOutstandingRenderJobs = 0;
+}
@@ -0,0 +1,301 @@
+// g_timedemo.cpp -- per-frame statistics for timedemos, written out as json when the demo is over so a
+// benchmark run can be compared against the last one by a script instead of by reading the console
+
+#include "g_game.h"
+
+typedef struct {
+	uint32_t usec;				// the whole frame, events through to the gc
+	uint32_t scriptUsec;		// time spent inside module calls
+	uint32_t gcUsec;
+	uint32_t allocs;			// zone allocations
+	uint32_t drawCalls;
+	uint32_t surfaces;
+} timeDemoFrame_t;
+
+// column order of the per-frame arrays in the json
+static const char *timeDemoFields[] = { "usec", "scriptUsec", "gcUsec", "allocs", "drawCalls", "surfaces" };
+
+typedef struct {
+	timeDemoFrame_t *pFrames;
+	uint32_t numFrames;
+	uint32_t maxFrames;
+
+	uint64_t startTime;
+	uint64_t frameStart;
+	uint64_t scriptTime;
+	uint64_t numAllocs;
+	uint64_t numFrees;
+	uint64_t totalAllocs;
+	uint64_t totalFrees;
+
+	backendCounters_t totals;
+} timeDemo_t;
+
+static timeDemo_t g_timeDemo;
+
+static cvar_t *timedemo_output;
+static cvar_t *timedemo_quit;
+
+static uint64_t G_TimeDemoScriptTime( void )
+{
+	return g_pModuleLib ? g_pModuleLib->GetScriptTime() : 0;
+}
+
+/*
+* G_TimeDemoSample: fills in the frame that started at frameStart, everything it reads was last
+* updated by that frame
+*/
+static void G_TimeDemoSample( uint64_t now )
+{
+	timeDemoFrame_t *frame;
+	uint64_t scriptTime, numAllocs, numFrees;
+
+	if ( g_timeDemo.numFrames == g_timeDemo.maxFrames ) {
+		g_timeDemo.maxFrames = g_timeDemo.maxFrames ? g_timeDemo.maxFrames * 2 : 4096;
+		g_timeDemo.pFrames = (timeDemoFrame_t *)Z_Realloc( g_timeDemo.pFrames, sizeof( *g_timeDemo.pFrames ) * g_timeDemo.maxFrames,
+			TAG_GAME );
+	}
+
+	scriptTime = G_TimeDemoScriptTime();
+	Z_GetAllocCounts( &numAllocs, &numFrees );
+
+	frame = &g_timeDemo.pFrames[ g_timeDemo.numFrames++ ];
+	frame->usec = (uint32_t)( now - g_timeDemo.frameStart );
+	frame->scriptUsec = (uint32_t)( scriptTime - g_timeDemo.scriptTime );
+	frame->gcUsec = g_pModuleLib ? (uint32_t)g_pModuleLib->GetGCFrameTime() : 0;
+	frame->allocs = (uint32_t)( numAllocs - g_timeDemo.numAllocs );
+	frame->drawCalls = (uint32_t)gi.pc.c_drawCalls;
+	frame->surfaces = gi.pc.c_surfaces;
+
+	g_timeDemo.totalAllocs += numAllocs - g_timeDemo.numAllocs;
+	g_timeDemo.totalFrees += numFrees - g_timeDemo.numFrees;
+
+	g_timeDemo.totals.msec += gi.pc.msec;
+	g_timeDemo.totals.postprocessMsec += gi.pc.postprocessMsec;
+	g_timeDemo.totals.c_drawCalls += gi.pc.c_drawCalls;
+	g_timeDemo.totals.c_glslShaderBinds += gi.pc.c_glslShaderBinds;
+	g_timeDemo.totals.c_bufferIndices += gi.pc.c_bufferIndices;
+	g_timeDemo.totals.c_bufferVertices += gi.pc.c_bufferVertices;
+	g_timeDemo.totals.c_iboBinds += gi.pc.c_iboBinds;
+	g_timeDemo.totals.c_vboBinds += gi.pc.c_vboBinds;
+	g_timeDemo.totals.c_vaoBinds += gi.pc.c_vaoBinds;
+	g_timeDemo.totals.c_dynamicBufferDraws += gi.pc.c_dynamicBufferDraws;
+	g_timeDemo.totals.c_staticBufferDraws += gi.pc.c_staticBufferDraws;
+	g_timeDemo.totals.c_bufferBinds += gi.pc.c_bufferBinds;
+	g_timeDemo.totals.c_surfaces += gi.pc.c_surfaces;
+	g_timeDemo.totals.c_overDraw += gi.pc.c_overDraw;
+	g_timeDemo.totals.c_lightallDraws += gi.pc.c_lightallDraws;
+	g_timeDemo.totals.c_genericDraws += gi.pc.c_genericDraws;
+	g_timeDemo.totals.c_worldChunks += gi.pc.c_worldChunks;
+	g_timeDemo.totals.c_worldChunksCulled += gi.pc.c_worldChunksCulled;
+	g_timeDemo.totals.c_worldTilesBaked += gi.pc.c_worldTilesBaked;
+	g_timeDemo.totals.c_worldUploadBytes += gi.pc.c_worldUploadBytes;
+	g_timeDemo.totals.c_polysSorted += gi.pc.c_polysSorted;
+	g_timeDemo.totals.c_polyBatches += gi.pc.c_polyBatches;
+	g_timeDemo.totals.c_stateChanges += gi.pc.c_stateChanges;
+	g_timeDemo.totals.polySortUsec += gi.pc.polySortUsec;
+
+	// taken after the realloc so the bookkeeping doesn't show up in the next frame's allocations
+	Z_GetAllocCounts( &g_timeDemo.numAllocs, &g_timeDemo.numFrees );
+	g_timeDemo.scriptTime = scriptTime;
+}
+
+/*
+* G_TimeDemoFrame: called at the start of every frame a timedemo plays, closes off the one before it
+*/
+void G_TimeDemoFrame( void )
+{
+	uint64_t now;
+
+	now = Sys_Microseconds();
+
+	if ( !gi.timeDemoFrames ) {
+		g_timeDemo.numFrames = 0;
+		memset( &g_timeDemo.totals, 0, sizeof( g_timeDemo.totals ) );
+		g_timeDemo.totalAllocs = 0;
+		g_timeDemo.totalFrees = 0;
+		g_timeDemo.startTime = now;
+		g_timeDemo.scriptTime = G_TimeDemoScriptTime();
+		Z_GetAllocCounts( &g_timeDemo.numAllocs, &g_timeDemo.numFrees );
+
+		gi.timeDemoStart = Sys_Milliseconds();
+	} else {
+		G_TimeDemoSample( now );
+	}
+
+	gi.timeDemoFrames++;
+	g_timeDemo.frameStart = now;
+}
+
+static int G_TimeDemoCompare( const void *a, const void *b )
+{
+	const uint32_t x = *(const uint32_t *)a;
+	const uint32_t y = *(const uint32_t *)b;
+
+	return x < y ? -1 : x > y ? 1 : 0;
+}
+
+/*
+* G_TimeDemoPrintStats: one column of the per-frame samples as min/mean/percentiles/max,
+* the percentiles are nearest rank
+*/
+static void G_TimeDemoPrintStats( fileHandle_t f, const char *name, size_t offset, uint32_t *sorted, qboolean last )
+{
+	const uint32_t n = g_timeDemo.numFrames;
+	uint64_t total;
+	uint32_t i;
+
+	total = 0;
+	for ( i = 0; i < n; i++ ) {
+		sorted[i] = *(const uint32_t *)( (const byte *)&g_timeDemo.pFrames[i] + offset );
+		total += sorted[i];
+	}
+	qsort( sorted, n, sizeof( *sorted ), G_TimeDemoCompare );
+
+#define PERCENTILE( p ) sorted[ ( n * (p) + 99 ) / 100 - 1 ]
+	FS_Printf( f, "\t\t\"%s\": { \"total\": %lu, \"min\": %u, \"mean\": %.2f, \"p50\": %u, \"p95\": %u, \"p99\": %u, \"max\": %u }%s\n",
+		name, total, sorted[0], (double)total / n, PERCENTILE( 50 ), PERCENTILE( 95 ), PERCENTILE( 99 ), sorted[ n - 1 ],
+		last ? "" : "," );
+#undef PERCENTILE
+}
+
+static void G_TimeDemoWriteJSON( const char *path, double seconds )
+{
+	fileHandle_t f;
+	uint32_t *sorted;
+	const timeDemoFrame_t *frame;
+	const backendCounters_t *pc;
+	uint32_t i;
+	const char *s;
+
+	f = FS_FOpenWrite( path );
+	if ( f == FS_INVALID_HANDLE ) {
+		Con_Printf( COLOR_RED "G_TimeDemoWriteJSON: couldn't create '%s'\n", path );
+		return;
+	}
+
+	FS_Printf( f, "{\n" );
+
+	// demo names are file names, only quotes and backslashes need escaping
+	FS_Printf( f, "\t\"demo\": \"" );
+	for ( s = gi.demoName; *s; s++ ) {
+		if ( *s == '"' || *s == '\\' ) {
+			FS_Write( "\\", 1, f );
+		}
+		FS_Write( s, 1, f );
+	}
+	FS_Printf( f, "\",\n" );
+
+	FS_Printf( f, "\t\"version\": \"%i.%i.%i\",\n", NOMAD_VERSION, NOMAD_VERSION_UPDATE, NOMAD_VERSION_PATCH );
+	FS_Printf( f, "\t\"renderer\": \"%s\",\n", Cvar_VariableString( "g_renderer" ) );
+	FS_Printf( f, "\t\"frames\": %u,\n", g_timeDemo.numFrames );
+	FS_Printf( f, "\t\"seconds\": %.3f,\n", seconds );
+	FS_Printf( f, "\t\"fps\": %.2f,\n", seconds > 0.0 ? g_timeDemo.numFrames / seconds : 0.0 );
+
+	sorted = (uint32_t *)Hunk_AllocateTempMemory( sizeof( *sorted ) * g_timeDemo.numFrames );
+
+	FS_Printf( f, "\t\"stats\": {\n" );
+	G_TimeDemoPrintStats( f, "usec", offsetof( timeDemoFrame_t, usec ), sorted, qfalse );
+	G_TimeDemoPrintStats( f, "scriptUsec", offsetof( timeDemoFrame_t, scriptUsec ), sorted, qfalse );
+	G_TimeDemoPrintStats( f, "gcUsec", offsetof( timeDemoFrame_t, gcUsec ), sorted, qfalse );
+	G_TimeDemoPrintStats( f, "allocs", offsetof( timeDemoFrame_t, allocs ), sorted, qfalse );
+	G_TimeDemoPrintStats( f, "drawCalls", offsetof( timeDemoFrame_t, drawCalls ), sorted, qfalse );
+	G_TimeDemoPrintStats( f, "surfaces", offsetof( timeDemoFrame_t, surfaces ), sorted, qtrue );
+	FS_Printf( f, "\t},\n" );
+
+	Hunk_FreeTempMemory( sorted );
+
+	FS_Printf( f, "\t\"memory\": { \"allocs\": %lu, \"frees\": %lu },\n", g_timeDemo.totalAllocs, g_timeDemo.totalFrees );
+
+	// the same counters r_speeds prints, summed over the whole demo
+	pc = &g_timeDemo.totals;
+	FS_Printf( f, "\t\"counters\": {\n" );
+	FS_Printf( f, "\t\t\"backendMsec\": %lu, \"postprocessMsec\": %lu,\n", pc->msec, pc->postprocessMsec );
+	FS_Printf( f, "\t\t\"drawCalls\": %lu, \"surfaces\": %u, \"overDraw\": %u, \"lightallDraws\": %u, \"genericDraws\": %u,\n",
+		pc->c_drawCalls, pc->c_surfaces, pc->c_overDraw, pc->c_lightallDraws, pc->c_genericDraws );
+	FS_Printf( f, "\t\t\"shaderBinds\": %u, \"bufferBinds\": %u, \"bufferIndices\": %u, \"bufferVertices\": %u,\n",
+		pc->c_glslShaderBinds, pc->c_bufferBinds, pc->c_bufferIndices, pc->c_bufferVertices );
+	FS_Printf( f, "\t\t\"iboBinds\": %u, \"vboBinds\": %u, \"vaoBinds\": %u, \"dynamicBufferDraws\": %u, \"staticBufferDraws\": %u,\n",
+		pc->c_iboBinds, pc->c_vboBinds, pc->c_vaoBinds, pc->c_dynamicBufferDraws, pc->c_staticBufferDraws );
+	FS_Printf( f, "\t\t\"worldChunks\": %u, \"worldChunksCulled\": %u, \"worldTilesBaked\": %u, \"worldUploadBytes\": %lu,\n",
+		pc->c_worldChunks, pc->c_worldChunksCulled, pc->c_worldTilesBaked, pc->c_worldUploadBytes );
+	FS_Printf( f, "\t\t\"polysSorted\": %u, \"polyBatches\": %u, \"stateChanges\": %u, \"polySortUsec\": %lu\n",
+		pc->c_polysSorted, pc->c_polyBatches, pc->c_stateChanges, pc->polySortUsec );
+	FS_Printf( f, "\t},\n" );
+
+	FS_Printf( f, "\t\"fields\": [ " );
+	for ( i = 0; i < arraylen( timeDemoFields ); i++ ) {
+		FS_Printf( f, "\"%s\"%s", timeDemoFields[i], i < arraylen( timeDemoFields ) - 1 ? ", " : "" );
+	}
+	FS_Printf( f, " ],\n" );
+
+	FS_Printf( f, "\t\"frameData\": [\n" );
+	for ( i = 0; i < g_timeDemo.numFrames; i++ ) {
+		frame = &g_timeDemo.pFrames[i];
+		FS_Printf( f, "\t\t[ %u, %u, %u, %u, %u, %u ]%s\n", frame->usec, frame->scriptUsec, frame->gcUsec, frame->allocs,
+			frame->drawCalls, frame->surfaces, i < g_timeDemo.numFrames - 1 ? "," : "" );
+	}
+	FS_Printf( f, "\t]\n" );
+
+	FS_Printf( f, "}\n" );
+	FS_FClose( f );
+
+	Con_Printf( "Wrote timedemo results to '%s'\n", path );
+}
+
+/*
+* G_TimeDemoCompleted: called once the demo's out of frames, writes the results to timedemo_output
+* or timedemo/<demo>.json
+*/
+void G_TimeDemoCompleted( void )
+{
+	char path[MAX_OSPATH];
+	char name[MAX_OSPATH];
+	uint64_t now;
+
+	if ( !gi.timeDemoFrames ) {
+		return;
+	}
+
+	now = Sys_Microseconds();
+	G_TimeDemoSample( now );
+
+	if ( timedemo_output->s[0] ) {
+		N_strncpyz( path, timedemo_output->s, sizeof( path ) );
+	} else {
+		COM_StripExtension( gi.demoName, name, sizeof( name ) );
+		Com_snprintf( path, sizeof( path ), "timedemo/%s.json", name );
+	}
+	G_TimeDemoWriteJSON( path, ( now - g_timeDemo.startTime ) / 1000000.0 );
+
+	Z_Free( g_timeDemo.pFrames );
+	g_timeDemo.pFrames = NULL;
+	g_timeDemo.numFrames = 0;
+	g_timeDemo.maxFrames = 0;
+}
+
+/*
+* G_TimeDemoShouldQuit: true once a timedemo's been finished with nothing queued up after it
+*/
+qboolean G_TimeDemoShouldQuit( void )
+{
+	return timedemo_quit->i && !gi.demoplaying ? qtrue : qfalse;
+}
+
+void G_InitTimeDemo( void )
+{
+	timedemo_output = Cvar_Get( "timedemo_output", "", 0 );
+	Cvar_SetDescription( timedemo_output, "Where a finished timedemo writes its json results, timedemo/<demo>.json when empty." );
+
+	timedemo_quit = Cvar_Get( "timedemo_quit", "0", 0 );
+	Cvar_CheckRange( timedemo_quit, "0", "1", CVT_INT );
+	Cvar_SetDescription( timedemo_quit, "Quit once a timedemo and any demos queued after it with nextdemo are done." );
+}
+
+void G_ShutdownTimeDemo( void )
+{
+	if ( g_timeDemo.pFrames ) {
+		Z_Free( g_timeDemo.pFrames );
+	}
+	memset( &g_timeDemo, 0, sizeof( g_timeDemo ) );
+}
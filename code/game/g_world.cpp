@@ -1,6 +1,16 @@
 #include "g_game.h"
 #include "g_world.h"
 #include "../sound/snd_local.h"
+#include "../AILib/AIFlowField.h"
+
+#if defined(__SSE2__) || defined(_MSC_SSE2_)
+#define USING_SSE2
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <emmintrin.h>
+#endif
+#endif
 
 CGameWorld *g_world;
 
@@ -196,6 +206,8 @@ void G_SetMap_f( void ) {
 		gi.mapCache.currentMapLoaded = FS_INVALID_HANDLE;
 
 		g_world = NULL;
+		g_pNavMesh = NULL;
+		g_pFlowField = NULL;
 
 		Cmd_RemoveCommand( "list_active_ents" );
 
@@ -311,6 +323,30 @@ void G_GetMapData( maptile_t **tiles, uint32_t *numTiles )
 	*numTiles = gi.mapCache.info.numTiles;
 }
 
+/*
+* G_SetTileIndex: swaps the tileset sprite the tile at x,y is drawn with, the renderer re-bakes
+* the chunk it's in before the next frame
+*/
+void G_SetTileIndex( uint32_t x, uint32_t y, int32_t index )
+{
+	mapinfo_t *info;
+
+	if ( !gi.mapCache.info.name[0] ) {
+		N_Error( ERR_DROP, "G_SetTileIndex: no map loaded" );
+	}
+
+	info = &gi.mapCache.info;
+	if ( x >= info->width || y >= info->height ) {
+		N_Error( ERR_DROP, "G_SetTileIndex: tile %u,%u out of range", x, y );
+	}
+	if ( index < -1 || index > INT16_MAX ) {
+		N_Error( ERR_DROP, "G_SetTileIndex: bad tileset index %i", index );
+	}
+
+	info->tiles[ y * info->width + x ].index = index;
+	re.SetWorldTile( x, y, index );
+}
+
 void G_SetActiveMap( nhandle_t hMap, uint32_t *nCheckpoints, uint32_t *nSpawns, uint32_t *nTiles, int32_t *pWidth, int32_t *pHeight )
 {
 	mapinfo_t *info;
@@ -336,6 +372,14 @@ void G_SetActiveMap( nhandle_t hMap, uint32_t *nCheckpoints, uint32_t *nSpawns,
 	static CGameWorld gameWorld;
 	g_world = &gameWorld;
 	g_world->Init( &gi.mapCache.info );
+
+	static CAIAStarNavMesh navMesh;
+	g_pNavMesh = &navMesh;
+	g_pNavMesh->Init( &gi.mapCache.info, Hunk_Alloc( CAIAStarNavMesh::MemoryRequired( info->width, info->height ), h_high ) );
+
+	static CAIFlowField flowField;
+	g_pFlowField = &flowField;
+	g_pFlowField->Init( g_pNavMesh, Hunk_Alloc( CAIFlowField::MemoryRequired( info->width, info->height ), h_high ) );
 	Key_SetCatcher( Key_GetCatcher() | KEYCATCH_SGAME );
 
 	static CSoundWorld soundWorld;
@@ -354,6 +398,9 @@ CGameWorld::~CGameWorld() {
 
 void CGameWorld::Init( mapinfo_t *info )
 {
+	uint32_t i;
+	uint32_t width, height;
+
 	m_nEntities = 0;
 	m_pMapInfo = info;
 	m_ActiveEnts.next =
@@ -361,34 +408,293 @@ void CGameWorld::Init( mapinfo_t *info )
 		&m_ActiveEnts;
 	
 	m_ActiveEnts.entityNumber = MAX_ENTITIES;
+
+	// pick the smallest cell size that keeps the grid within budget
+	width = MAX( info->width, 1 );
+	height = MAX( info->height, 1 );
+	for ( m_nCellShift = 0;; m_nCellShift++ ) {
+		m_nCellsX = ( width + ( 1 << m_nCellShift ) - 1 ) >> m_nCellShift;
+		m_nCellsY = ( height + ( 1 << m_nCellShift ) - 1 ) >> m_nCellShift;
+		if ( m_nCellsX * m_nCellsY <= MAX_WORLD_CELLS ) {
+			break;
+		}
+	}
+
+	memset( m_CellHeads, -1, sizeof( *m_CellHeads ) * m_nCellsX * m_nCellsY );
+	for ( i = 0; i < MAX_CELL_NODES - 1; i++ ) {
+		m_CellNodes[i].next = i + 1;
+	}
+	m_CellNodes[ MAX_CELL_NODES - 1 ].next = -1;
+	m_nFreeNode = 0;
+
+	memset( m_Links, 0, sizeof( m_Links ) );
+	for ( i = 0; i < MAX_ENTITIES; i++ ) {
+		m_Links[i].largeIndex = -1;
+	}
+	m_nLargeEnts = 0;
+
+	memset( m_QueryStamps, 0, sizeof( m_QueryStamps ) );
+	m_nQueryStamp = 0;
+
+	Con_DPrintf( "CGameWorld::Init: %ux%u entity grid, %u tiles per cell\n", m_nCellsX, m_nCellsY, 1 << m_nCellShift );
+}
+
+int32_t CGameWorld::CellCoord( float v, uint32_t nCells ) const
+{
+	// clamp in float space so that infinite or garbage bounds can't overflow the cast
+	if ( !( v >= 0.0f ) ) {
+		return 0;
+	}
+	if ( v >= (float)( nCells << m_nCellShift ) ) {
+		return nCells - 1;
+	}
+	return (int32_t)v >> m_nCellShift;
+}
+
+int32_t CGameWorld::CellForPoint( const vec3_t origin ) const {
+	return CellCoord( origin[1], m_nCellsY ) * m_nCellsX + CellCoord( origin[0], m_nCellsX );
+}
+
+void CGameWorld::CellBounds( const bbox_t *bounds, int32_t *absmin, int32_t *absmax ) const
+{
+	absmin[0] = CellCoord( bounds->mins[0], m_nCellsX );
+	absmin[1] = CellCoord( bounds->mins[1], m_nCellsY );
+	absmax[0] = CellCoord( bounds->maxs[0], m_nCellsX );
+	absmax[1] = CellCoord( bounds->maxs[1], m_nCellsY );
+}
+
+void CGameWorld::LinkToCells( worldLink_t *link )
+{
+	int32_t x, y;
+	int32_t node;
+	int32_t *head;
+	const uint32_t entityNumber = (uint32_t)( link - m_Links );
+
+	CellBounds( &link->ent->bounds, link->absmin, link->absmax );
+
+	// inverted bounds can't contain anything
+	if ( link->absmin[0] > link->absmax[0] || link->absmin[1] > link->absmax[1] ) {
+		return;
+	}
+
+	if ( ( link->absmax[0] - link->absmin[0] + 1 ) * ( link->absmax[1] - link->absmin[1] + 1 ) > MAX_CELLS_PER_ENTITY ) {
+		link->largeIndex = m_nLargeEnts;
+		m_LargeEnts[ m_nLargeEnts++ ] = entityNumber;
+		return;
+	}
+
+	for ( y = link->absmin[1]; y <= link->absmax[1]; y++ ) {
+		for ( x = link->absmin[0]; x <= link->absmax[0]; x++ ) {
+			// the pool holds MAX_CELLS_PER_ENTITY nodes for every entity, so this can't run dry
+			node = m_nFreeNode;
+			m_nFreeNode = m_CellNodes[ node ].next;
+
+			head = &m_CellHeads[ y * m_nCellsX + x ];
+			m_CellNodes[ node ].entityNumber = entityNumber;
+			m_CellNodes[ node ].next = *head;
+			*head = node;
+		}
+	}
+}
+
+void CGameWorld::UnlinkFromCells( worldLink_t *link )
+{
+	int32_t x, y;
+	int32_t node;
+	int32_t *prev;
+	const uint32_t entityNumber = (uint32_t)( link - m_Links );
+
+	if ( link->largeIndex != -1 ) {
+		m_LargeEnts[ link->largeIndex ] = m_LargeEnts[ --m_nLargeEnts ];
+		m_Links[ m_LargeEnts[ link->largeIndex ] ].largeIndex = link->largeIndex;
+		link->largeIndex = -1;
+		return;
+	}
+
+	for ( y = link->absmin[1]; y <= link->absmax[1]; y++ ) {
+		for ( x = link->absmin[0]; x <= link->absmax[0]; x++ ) {
+			prev = &m_CellHeads[ y * m_nCellsX + x ];
+			for ( node = *prev; node != -1; node = *prev ) {
+				if ( m_CellNodes[ node ].entityNumber == entityNumber ) {
+					*prev = m_CellNodes[ node ].next;
+					m_CellNodes[ node ].next = m_nFreeNode;
+					m_nFreeNode = node;
+					break;
+				}
+				prev = &m_CellNodes[ node ].next;
+			}
+		}
+	}
 }
 
 void CGameWorld::LinkEntity( linkEntity_t *ent )
 {
+	worldLink_t *link;
+
+	if ( ent->entityNumber >= MAX_ENTITIES ) {
+		N_Error( ERR_DROP, "CGameWorld::LinkEntity: entityNumber %u out of range", ent->entityNumber );
+	}
+
 	m_ActiveEnts.prev->next = ent;
 	ent->prev = m_ActiveEnts.prev;
 	ent->next = &m_ActiveEnts;
 	m_ActiveEnts.prev = ent;
 
 	m_nEntities++;
+
+	link = &m_Links[ ent->entityNumber ];
+	if ( link->linked ) {
+		// the entity number got reused before the old one was unlinked
+		UnlinkFromCells( link );
+	}
+	link->ent = ent;
+	link->linked = qtrue;
+	LinkToCells( link );
 	
-	Con_Printf( "Allocated link entity %u (%u type, %u id)\n", ent->entityNumber, ent->type, ent->id );
+	Con_DPrintf( "Allocated link entity %u (%u type, %u id)\n", ent->entityNumber, ent->type, ent->id );
 }
 
 void CGameWorld::UnlinkEntity( linkEntity_t *ent )
 {
+	worldLink_t *link;
+
 	ent->prev->next = ent->next;
 	ent->next->prev = ent->prev;
 
-	Con_Printf( "Removing link entity %u\n", ent->entityNumber );
+	if ( ent->entityNumber < MAX_ENTITIES ) {
+		link = &m_Links[ ent->entityNumber ];
+		if ( link->linked ) {
+			UnlinkFromCells( link );
+			link->linked = qfalse;
+			link->ent = NULL;
+		}
+	}
+
+	Con_DPrintf( "Removing link entity %u\n", ent->entityNumber );
 
 	m_nEntities--;
 }
 
+/*
+* CGameWorld::EntityMoved: must be called whenever a linked entity's bounds
+* change, only touches the grid when the entity crosses into a different set of cells
+*/
+void CGameWorld::EntityMoved( linkEntity_t *ent )
+{
+	worldLink_t *link;
+	int32_t absmin[2], absmax[2];
+
+	if ( ent->entityNumber >= MAX_ENTITIES ) {
+		return;
+	}
+	link = &m_Links[ ent->entityNumber ];
+	if ( !link->linked ) {
+		return;
+	}
+	link->ent = ent;
+
+	CellBounds( &ent->bounds, absmin, absmax );
+	if ( absmin[0] == link->absmin[0] && absmin[1] == link->absmin[1]
+		&& absmax[0] == link->absmax[0] && absmax[1] == link->absmax[1] )
+	{
+		return;
+	}
+
+	UnlinkFromCells( link );
+	LinkToCells( link );
+}
+
+/*
+* CGameWorld::AreaEntities: gathers the numbers of all the entities touching the given
+* box, if origin is set, only entities that also touch the sphere are returned
+*/
+uint32_t CGameWorld::AreaEntities( const bbox_t *area, const vec_t *origin, float radius, uint32_t *pList, uint32_t nMaxCount )
+{
+	int32_t x, y;
+	int32_t node;
+	int32_t absmin[2], absmax[2];
+	uint32_t i, entityNumber;
+	uint32_t count;
+	const linkEntity_t *ent;
+
+	if ( !nMaxCount ) {
+		return 0;
+	}
+
+	if ( ++m_nQueryStamp == 0 ) {
+		memset( m_QueryStamps, 0, sizeof( m_QueryStamps ) );
+		m_nQueryStamp = 1;
+	}
+
+	count = 0;
+	CellBounds( area, absmin, absmax );
+	for ( y = absmin[1]; y <= absmax[1]; y++ ) {
+		for ( x = absmin[0]; x <= absmax[0]; x++ ) {
+			for ( node = m_CellHeads[ y * m_nCellsX + x ]; node != -1; node = m_CellNodes[ node ].next ) {
+				entityNumber = m_CellNodes[ node ].entityNumber;
+				if ( m_QueryStamps[ entityNumber ] == m_nQueryStamp ) {
+					continue;
+				}
+				m_QueryStamps[ entityNumber ] = m_nQueryStamp;
+
+				ent = m_Links[ entityNumber ].ent;
+				if ( !BoundsIntersect( &ent->bounds, area ) ) {
+					continue;
+				}
+				if ( origin && !BoundsIntersectSphere( &ent->bounds, origin, radius ) ) {
+					continue;
+				}
+				pList[ count++ ] = entityNumber;
+				if ( count == nMaxCount ) {
+					return count;
+				}
+			}
+		}
+	}
+
+	for ( i = 0; i < m_nLargeEnts; i++ ) {
+		ent = m_Links[ m_LargeEnts[i] ].ent;
+		if ( !BoundsIntersect( &ent->bounds, area ) ) {
+			continue;
+		}
+		if ( origin && !BoundsIntersectSphere( &ent->bounds, origin, radius ) ) {
+			continue;
+		}
+		pList[ count++ ] = m_LargeEnts[i];
+		if ( count == nMaxCount ) {
+			break;
+		}
+	}
+
+	return count;
+}
+
+uint32_t CGameWorld::BoxEntities( const bbox_t *bounds, uint32_t *pList, uint32_t nMaxCount ) {
+	return AreaEntities( bounds, NULL, 0.0f, pList, nMaxCount );
+}
+
+uint32_t CGameWorld::RadiusEntities( const vec3_t origin, float radius, uint32_t *pList, uint32_t nMaxCount )
+{
+	bbox_t area;
+
+	area.mins[0] = origin[0] - radius;
+	area.mins[1] = origin[1] - radius;
+	area.mins[2] = origin[2] - radius;
+	area.maxs[0] = origin[0] + radius;
+	area.maxs[1] = origin[1] + radius;
+	area.maxs[2] = origin[2] + radius;
+
+	return AreaEntities( &area, origin, radius, pList, nMaxCount );
+}
+
 qboolean CGameWorld::CheckWallHit( const vec3_t origin, dirtype_t dir )
 {
 	vec3_t p;
 	ivec3_t tmp;
+	int32_t node;
+	uint32_t i;
+	const linkEntity_t *ent;
+
 	VectorCopy( p, origin );
 
 	/*
@@ -422,8 +728,8 @@ qboolean CGameWorld::CheckWallHit( const vec3_t origin, dirtype_t dir )
 	Sys_SnapVector( p );
 	VectorCopy( tmp, p );
 
-	tmp[0] = Com_Clamp( 0, m_pMapInfo->width, tmp[0] );
-	tmp[1] = Com_Clamp( 0, m_pMapInfo->height, tmp[1] );
+	tmp[0] = Com_Clamp( 0, m_pMapInfo->width - 1, tmp[0] );
+	tmp[1] = Com_Clamp( 0, m_pMapInfo->height - 1, tmp[1] );
 
 	if ( m_pMapInfo->tiles[ tmp[1] * m_pMapInfo->width + tmp[0] ].flags & TILESIDE_INSIDE 
 		|| m_pMapInfo->tiles[ tmp[1] * m_pMapInfo->width + tmp[0] ].flags & inversedirs_flags[ dir ] )
@@ -431,91 +737,309 @@ qboolean CGameWorld::CheckWallHit( const vec3_t origin, dirtype_t dir )
 		return qtrue;
 	}
 
+	// wall entities are linked like any other entity, so only the ones sharing the cell matter
+	for ( node = m_CellHeads[ CellForPoint( origin ) ]; node != -1; node = m_CellNodes[ node ].next ) {
+		ent = m_Links[ m_CellNodes[ node ].entityNumber ].ent;
+		if ( ent->type == ET_WALL && BoundsIntersectPoint( &ent->bounds, origin ) ) {
+			return qtrue;
+		}
+	}
+	for ( i = 0; i < m_nLargeEnts; i++ ) {
+		ent = m_Links[ m_LargeEnts[i] ].ent;
+		if ( ent->type == ET_WALL && BoundsIntersectPoint( &ent->bounds, origin ) ) {
+			return qtrue;
+		}
+	}
+
 	return qfalse;
 }
 
-void CGameWorld::CastRay( ray_t *ray )
+qboolean CGameWorld::CheckRayHit( const ray_t *ray, const linkEntity_t *ent, qboolean bNoClip ) const
+{
+	if ( ent->entityNumber == ray->ownerNumber || ent->entityNumber == ray->ownerNumber2
+		|| ( ent->flags & LINKFLAG_DEAD ) || !BoundsIntersectPoint( &ent->bounds, ray->origin ) )
+	{
+		return qfalse;
+	}
+
+	switch ( ent->type ) {
+	case ET_PLAYR:
+		if ( bNoClip ) {
+			return qfalse;
+		}
+	case ET_MOB:
+		return qtrue;
+	default:
+		break;
+	};
+
+	return qfalse;
+}
+
+/*
+* CGameWorld::TraceRayStep: checks the ray's current position against the entities and
+* walls, returns qtrue once the ray has hit something or run past its end point
+*/
+qboolean CGameWorld::TraceRayStep( ray_t *ray, dirtype_t rayDir, float sx, float sy, qboolean bNoClip )
+{
+	uint32_t i;
+	int32_t node;
+	const linkEntity_t *it;
+
+	// only the entities bucketed in the cell the ray is currently in can be hit
+	for ( node = m_CellHeads[ CellForPoint( ray->origin ) ]; node != -1; node = m_CellNodes[ node ].next ) {
+		it = m_Links[ m_CellNodes[ node ].entityNumber ].ent;
+		if ( CheckRayHit( ray, it, bNoClip ) ) {
+			ray->entityNumber = it->entityNumber;
+			return qtrue;
+		}
+	}
+	for ( i = 0; i < m_nLargeEnts; i++ ) {
+		it = m_Links[ m_LargeEnts[i] ].ent;
+		if ( CheckRayHit( ray, it, bNoClip ) ) {
+			ray->entityNumber = it->entityNumber;
+			return qtrue;
+		}
+	}
+
+	if ( ( sy == -ray->speed && ray->origin[1] <= ray->end[1] ) || ( sy == ray->speed && ray->origin[1] >= ray->end[1] )
+		|| ( sx == -ray->speed && ray->origin[0] <= ray->end[0] ) || ( sx == ray->speed && ray->origin[0] >= ray->end[0] ) )
+	{
+		ray->entityNumber = ENTITYNUM_INVALID;
+		return qtrue;
+	}
+
+	if ( CheckWallHit( ray->origin, rayDir ) ) {
+		// hit a wall
+		ray->entityNumber = ENTITYNUM_WALL;
+		return qtrue;
+	}
+
+	return qfalse;
+}
+
+void CGameWorld::CastRay( ray_t *ray ) {
+	CastRays( ray, 1, qfalse );
+}
+
+/*
+* CGameWorld::CastRays: traces the rays in groups of RAY_LANES. TraceRayStep still checks
+* the entities and walls one ray at a time, only the Bresenham error and position update
+* of the group is done together. Unless bTileUnits is set the start is divided by 10 first
+* like CastRay has always done, script rays are already in map tile units
+*/
+void CGameWorld::CastRays( ray_t *pRays, uint32_t nRays, qboolean bTileUnits )
 {
 	PROFILE_FUNCTION();
 
-	float dx, sx;
-	float dy, sy;
-	float err;
-	float e2;
-	vec3_t end;
-	vec3_t p;
-	dirtype_t rayDir;
-	uint64_t i;
+	float dx[ RAY_LANES ], sx[ RAY_LANES ];
+	float dy[ RAY_LANES ], sy[ RAY_LANES ];
+	float err[ RAY_LANES ];
+	float ox[ RAY_LANES ], oy[ RAY_LANES ];
+	dirtype_t rayDir[ RAY_LANES ];
+	ray_t *ray;
+	uint32_t base, lane, count;
+	uint32_t active;
 	float angle2;
-	linkEntity_t *it;
-	vec3_t tmp;
-	
-	// calculate the endpoint
-	ray->start[0] /= 10.0f;
-	ray->start[1] /= 10.0f;
-	ray->start[2] /= 10.0f;
-
-	ray->end[0] = ray->start[0] + ( ray->length * cos( ray->angle ) );
-	ray->end[1] = ray->start[1] + ( ray->length * sin( ray->angle ) );
-	ray->end[2] = ray->start[2] * sin( ray->angle );
-
-	dx = abs( ray->end[0] - ray->start[0] );
-	dy = abs( ray->end[1] - ray->start[1] );
-	sx = ray->end[0] > ray->start[0] ? ray->speed : -ray->speed;
-	sy = ray->end[1] > ray->start[1] ? ray->speed : -ray->speed;
-	err = ( dx > dy ? dx : -dy ) / 2.0f;
-	VectorCopy( ray->origin, ray->start );
-
-	angle2 = RAD2DEG( ray->angle );
-	if ( angle2 < 0.0f ) {
-		angle2 += 360.0f;
-	}
-
-	for ( ;; ) {
-		for ( it = m_ActiveEnts.next; it != &m_ActiveEnts; it = it->next ) {
-			if ( it->entityNumber != ray->ownerNumber && it->entityNumber != ray->ownerNumber2
-				&& BoundsIntersectPoint( &it->bounds, ray->origin ) )
-			{
-				switch ( it->type ) {
-				case ET_WALL:
-				case ET_BOT:
-				case ET_ITEM:
-				case ET_WEAPON:
-					break;
-				case ET_PLAYR:
-					if ( Cvar_VariableInteger( "sgame_NoClip" ) ) {
-						continue;
-					}
-				case ET_MOB:
-					ray->entityNumber = it->entityNumber;
-					return;
-				};
+	qboolean bNoClip;
+
+	static CvarHandle<bool> sgame_NoClip( "sgame_NoClip" );
+
+	// this can't change while tracing, no need to look it up every step
+	bNoClip = sgame_NoClip.Get();
+
+	for ( base = 0; base < nRays; base += RAY_LANES ) {
+		count = MIN( RAY_LANES, nRays - base );
+		active = 0;
+
+		for ( lane = 0; lane < RAY_LANES; lane++ ) {
+			if ( lane >= count ) {
+				dx[ lane ] = dy[ lane ] = sx[ lane ] = sy[ lane ] = err[ lane ] = ox[ lane ] = oy[ lane ] = 0.0f;
+				continue;
+			}
+			ray = &pRays[ base + lane ];
+
+			// a zero step would never reach the end point
+			if ( ray->speed <= 0.0f ) {
+				ray->speed = 0.5f;
+			}
+
+			// calculate the endpoint
+			if ( !bTileUnits ) {
+				ray->start[0] /= 10.0f;
+				ray->start[1] /= 10.0f;
+				ray->start[2] /= 10.0f;
 			}
-		}
 
-		if ( ( sy == -ray->speed && ray->origin[1] <= ray->end[1] ) || ( sy == ray->speed && ray->origin[1] >= ray->end[1] )
-			|| ( sx == -ray->speed && ray->origin[0] <= ray->end[0] ) || ( sx == ray->speed && ray->origin[0] >= ray->end[0] ) )
-		{
-			ray->entityNumber = ENTITYNUM_INVALID;
-			return;
+			ray->end[0] = ray->start[0] + ( ray->length * cos( ray->angle ) );
+			ray->end[1] = ray->start[1] + ( ray->length * sin( ray->angle ) );
+			ray->end[2] = ray->start[2] * sin( ray->angle );
+
+			dx[ lane ] = abs( ray->end[0] - ray->start[0] );
+			dy[ lane ] = abs( ray->end[1] - ray->start[1] );
+			sx[ lane ] = ray->end[0] > ray->start[0] ? ray->speed : -ray->speed;
+			sy[ lane ] = ray->end[1] > ray->start[1] ? ray->speed : -ray->speed;
+			err[ lane ] = ( dx[ lane ] > dy[ lane ] ? dx[ lane ] : -dy[ lane ] ) / 2.0f;
+			VectorCopy( ray->origin, ray->start );
+			ox[ lane ] = ray->origin[0];
+			oy[ lane ] = ray->origin[1];
+
+			angle2 = RAD2DEG( ray->angle );
+			if ( angle2 < 0.0f ) {
+				angle2 += 360.0f;
+			}
+			rayDir[ lane ] = inversedirs[ Angle2Dir( angle2 ) ];
+
+			active |= 1 << lane;
 		}
 
-		rayDir = inversedirs[ Angle2Dir( angle2 ) ];
+		while ( active ) {
+			for ( lane = 0; lane < count; lane++ ) {
+				if ( !( active & ( 1 << lane ) ) ) {
+					continue;
+				}
+				ray = &pRays[ base + lane ];
+				ray->origin[0] = ox[ lane ];
+				ray->origin[1] = oy[ lane ];
+				if ( TraceRayStep( ray, rayDir[ lane ], sx[ lane ], sy[ lane ], bNoClip ) ) {
+					active &= ~( 1 << lane );
+				}
+			}
 
-		if ( CheckWallHit( ray->origin, rayDir ) ) {
-			// hit a wall
-			ray->entityNumber = ENTITYNUM_WALL;
-			break;
+#ifdef USING_SSE2
+			{
+				const __m128 live = _mm_castsi128_ps( _mm_setr_epi32( -(int)( active & 1 ), -(int)( ( active >> 1 ) & 1 ),
+					-(int)( ( active >> 2 ) & 1 ), -(int)( ( active >> 3 ) & 1 ) ) );
+				const __m128 e2 = _mm_loadu_ps( err );
+				const __m128 vdx = _mm_loadu_ps( dx );
+				const __m128 vdy = _mm_loadu_ps( dy );
+				const __m128 stepX = _mm_and_ps( _mm_cmpgt_ps( e2, _mm_sub_ps( _mm_setzero_ps(), vdx ) ), live );
+				const __m128 stepY = _mm_and_ps( _mm_cmplt_ps( e2, vdy ), live );
+
+				_mm_storeu_ps( err, _mm_add_ps( _mm_sub_ps( e2, _mm_and_ps( vdy, stepX ) ), _mm_and_ps( vdx, stepY ) ) );
+				_mm_storeu_ps( ox, _mm_add_ps( _mm_loadu_ps( ox ), _mm_and_ps( _mm_loadu_ps( sx ), stepX ) ) );
+				_mm_storeu_ps( oy, _mm_add_ps( _mm_loadu_ps( oy ), _mm_and_ps( _mm_loadu_ps( sy ), stepY ) ) );
+			}
+#else
+			for ( lane = 0; lane < count; lane++ ) {
+				const float e2 = err[ lane ];
+
+				if ( !( active & ( 1 << lane ) ) ) {
+					continue;
+				}
+				if ( e2 > -dx[ lane ] ) {
+					err[ lane ] -= dy[ lane ];
+					ox[ lane ] += sx[ lane ];
+				}
+				if ( e2 < dy[ lane ] ) {
+					err[ lane ] += dx[ lane ];
+					oy[ lane ] += sy[ lane ];
+				}
+			}
+#endif
 		}
-		
-		e2 = err;
-		if ( e2 > -dx ) {
-			err -= dy;
-			ray->origin[0] += sx;
+	}
+}
+
+/*
+* G_WorldBench_f: casts single and batched rays and runs radius queries against a synthetic 1024x1024
+* map with every entity slot linked, doesn't need a loaded level so it can be run
+* headless with "+world_bench"
+*/
+void G_WorldBench_f( void )
+{
+	CGameWorld *world;
+	mapinfo_t info;
+	linkEntity_t *ents;
+	ray_t *rays;
+	vec3_t origin;
+	uint32_t list[ MAX_ENTITIES ];
+	uint32_t i, nRays, nHits, nFound, nMismatched;
+	uint64_t start, rayTime, batchTime, queryTime;
+	int seed;
+
+	nRays = 10000;
+	if ( Cmd_Argc() > 1 ) {
+		nRays = MAX( atoi( Cmd_Argv( 1 ) ), 1 );
+	}
+
+	memset( &info, 0, sizeof( info ) );
+	N_strncpyz( info.name, "world_bench", sizeof( info.name ) );
+	info.width = 1024;
+	info.height = 1024;
+	info.numTiles = info.width * info.height;
+	info.numLevels = 1;
+
+	info.tiles = (maptile_t *)Hunk_AllocateTempMemory( sizeof( *info.tiles ) * info.numTiles );
+	memset( info.tiles, 0, sizeof( *info.tiles ) * info.numTiles );
+	ents = (linkEntity_t *)Hunk_AllocateTempMemory( sizeof( *ents ) * MAX_ENTITIES );
+	memset( ents, 0, sizeof( *ents ) * MAX_ENTITIES );
+	world = new ( Hunk_AllocateTempMemory( sizeof( *world ) ) ) CGameWorld();
+
+	world->Init( &info );
+
+	seed = 0x4e4d4144;
+	for ( i = 0; i < MAX_ENTITIES; i++ ) {
+		ents[i].origin[0] = Q_random( &seed ) * info.width;
+		ents[i].origin[1] = Q_random( &seed ) * info.height;
+		VectorSet( ents[i].bounds.mins, ents[i].origin[0] - 0.5f, ents[i].origin[1] - 0.5f, -0.5f );
+		VectorSet( ents[i].bounds.maxs, ents[i].origin[0] + 0.5f, ents[i].origin[1] + 0.5f, 0.5f );
+		ents[i].entityNumber = i;
+		ents[i].type = ET_MOB;
+		world->LinkEntity( &ents[i] );
+	}
+
+	// the same set of rays is cast one at a time and then as a batch
+	rays = (ray_t *)Hunk_AllocateTempMemory( sizeof( *rays ) * nRays * 2 );
+	memset( rays, 0, sizeof( *rays ) * nRays );
+	for ( i = 0; i < nRays; i++ ) {
+		rays[i].start[0] = Q_random( &seed ) * info.width * 10.0f;
+		rays[i].start[1] = Q_random( &seed ) * info.height * 10.0f;
+		rays[i].angle = Q_random( &seed ) * M_PI * 2.0f;
+		rays[i].length = 64.0f;
+		rays[i].speed = 1.0f;
+		rays[i].ownerNumber = ENTITYNUM_INVALID;
+		rays[i].ownerNumber2 = ENTITYNUM_INVALID;
+	}
+	memcpy( rays + nRays, rays, sizeof( *rays ) * nRays );
+
+	nHits = 0;
+	start = Sys_Milliseconds();
+	for ( i = 0; i < nRays; i++ ) {
+		world->CastRay( &rays[i] );
+		if ( rays[i].entityNumber < MAX_ENTITIES ) {
+			nHits++;
 		}
-		if ( e2 < dy ) {
-			err += dx;
-			ray->origin[1] += sy;
+	}
+	rayTime = Sys_Milliseconds() - start;
+
+	start = Sys_Milliseconds();
+	world->CastRays( rays + nRays, nRays, qfalse );
+	batchTime = Sys_Milliseconds() - start;
+
+	nMismatched = 0;
+	for ( i = 0; i < nRays; i++ ) {
+		if ( rays[i].entityNumber != rays[ nRays + i ].entityNumber || !VectorCompare( rays[i].origin, rays[ nRays + i ].origin ) ) {
+			nMismatched++;
 		}
 	}
+
+	nFound = 0;
+	start = Sys_Milliseconds();
+	for ( i = 0; i < nRays; i++ ) {
+		VectorSet( origin, Q_random( &seed ) * info.width, Q_random( &seed ) * info.height, 0.0f );
+		nFound += world->RadiusEntities( origin, 8.0f, list, arraylen( list ) );
+	}
+	queryTime = Sys_Milliseconds() - start;
+
+	Con_Printf( "world_bench: %u entities on a %ux%u map\n", world->NumEntities(), info.width, info.height );
+	Con_Printf( "%u rays in %lu msec, %u hits\n", nRays, rayTime, nHits );
+	Con_Printf( "%u batched rays in %lu msec, %u mismatched\n", nRays, batchTime, nMismatched );
+	Con_Printf( "%u radius queries in %lu msec, %u entities found\n", nRays, queryTime, nFound );
+
+	Hunk_FreeTempMemory( rays );
+	world->~CGameWorld();
+	Hunk_FreeTempMemory( world );
+	Hunk_FreeTempMemory( ents );
+	Hunk_FreeTempMemory( info.tiles );
 }
@@ -5,6 +5,38 @@
 
 #include "../engine/n_threads.h"
 
+#define ENTITYNUM_INVALID (unsigned)( ~0 )
+#define ENTITYNUM_WALL ENTITYNUM_INVALID - 1
+#define MAX_ENTITIES 4096
+
+//
+// entities are bucketed into a uniform grid of square cells, each cell covering
+// ( 1 << m_nCellShift ) tiles per side, the shift is picked at map load so that
+// the grid never exceeds MAX_WORLD_CELLS
+//
+#define MAX_WORLD_CELLS ( 64 * 1024 )
+
+// an entity spanning more cells than this goes onto the oversized list instead,
+// which every query checks
+#define MAX_CELLS_PER_ENTITY 16
+#define MAX_CELL_NODES ( MAX_ENTITIES * MAX_CELLS_PER_ENTITY )
+
+// number of rays CastRays steps together
+#define RAY_LANES 4
+
+typedef struct {
+    uint32_t entityNumber;
+    int32_t next;
+} worldCellNode_t;
+
+typedef struct {
+    linkEntity_t *ent;
+    int32_t absmin[2]; // first cell covered
+    int32_t absmax[2]; // last cell covered
+    int32_t largeIndex; // index into m_LargeEnts, -1 if bucketed
+    qboolean linked;
+} worldLink_t;
+
 class CGameWorld
 {
 public:
@@ -14,9 +46,14 @@ public:
     void Init( mapinfo_t *info );
     void LinkEntity( linkEntity_t *ent );
     void UnlinkEntity( linkEntity_t *ent );
+    void EntityMoved( linkEntity_t *ent );
     void CastRay( ray_t *ray );
+    void CastRays( ray_t *pRays, uint32_t nRays, qboolean bTileUnits );
     qboolean CheckWallHit( const vec3_t origin, dirtype_t dir );
 
+    uint32_t BoxEntities( const bbox_t *bounds, uint32_t *pList, uint32_t nMaxCount );
+    uint32_t RadiusEntities( const vec3_t origin, float radius, uint32_t *pList, uint32_t nMaxCount );
+
     inline uint32_t GetWidth( void ) const {
         return m_pMapInfo->width;
     }
@@ -30,9 +67,35 @@ public:
         return &m_ActiveEnts;
     }
 private:
+    int32_t CellCoord( float v, uint32_t nCells ) const;
+    int32_t CellForPoint( const vec3_t origin ) const;
+    void CellBounds( const bbox_t *bounds, int32_t *absmin, int32_t *absmax ) const;
+    void LinkToCells( worldLink_t *link );
+    void UnlinkFromCells( worldLink_t *link );
+    uint32_t AreaEntities( const bbox_t *area, const vec_t *origin, float radius, uint32_t *pList, uint32_t nMaxCount );
+    qboolean CheckRayHit( const ray_t *ray, const linkEntity_t *ent, qboolean bNoClip ) const;
+    qboolean TraceRayStep( ray_t *ray, dirtype_t rayDir, float sx, float sy, qboolean bNoClip );
+
     linkEntity_t m_ActiveEnts;
     mapinfo_t *m_pMapInfo;
     uint32_t m_nEntities;
+
+    uint32_t m_nCellShift;
+    uint32_t m_nCellsX;
+    uint32_t m_nCellsY;
+
+    int32_t m_nFreeNode;
+    int32_t m_CellHeads[ MAX_WORLD_CELLS ];
+    worldCellNode_t m_CellNodes[ MAX_CELL_NODES ];
+
+    worldLink_t m_Links[ MAX_ENTITIES ];
+
+    uint32_t m_LargeEnts[ MAX_ENTITIES ];
+    uint32_t m_nLargeEnts;
+
+    // used to avoid reporting an entity twice when it spans several cells
+    uint32_t m_QueryStamps[ MAX_ENTITIES ];
+    uint32_t m_nQueryStamp;
 };
 
 extern const uint64_t tileside_flags[ NUMDIRS ];
@@ -41,15 +104,13 @@ extern const uint64_t inversedirs_flags[ NUMDIRS ];
 #define IsWall( dir, flags ) (qboolean)( ( flags ) & tileside_flags[ dir ] )
 #define IsDoubleSidedWall( dir, flags ) (qboolean)( ( flags ) & inversedirs_flags[ dir ] )
 
-#define ENTITYNUM_INVALID (unsigned)( ~0 )
-#define ENTITYNUM_WALL ENTITYNUM_INVALID - 1
-#define MAX_ENTITIES 4096
-
 void G_GetTileData( uint64_t *pTiles, uint32_t nLevel );
 void G_GetCheckpointData( uvec3_t xyz, uvec2_t areaLock, uint32_t nIndex );
 void G_GetSpawnData( uvec3_t xyz, uint32_t *type, uint32_t *id, uint32_t nIndex, uint32_t *pCheckpointIndex );
 void G_GetSecretData( uint32_t *pCheckpointIndex, uint32_t nIndex );
 void G_GetMapData( maptile_t **tiles, uint32_t *numTiles );
+void G_SetTileIndex( uint32_t x, uint32_t y, int32_t index );
+void G_WorldBench_f( void );
 
 extern const dirtype_t inversedirs[NUMDIRS];
 extern CGameWorld *g_world;
@@ -5,6 +5,8 @@ namespace moblib::Script {
 	const uint MERC_AIM_TIME = 2500;
 	float MERC_SHOTGUN_DAMAGE = 25.0f;
 	float MERC_SHOTGUN_RANGE = 20.75f;
+	const uint MERC_SHOTGUN_PELLETS = 5;
+	const float MERC_SHOTGUN_SPREAD = 0.35f; // radians across the whole spread
 	const uint MERC_BARK_COOLDOWN = 300;
 	const uint MERC_AGGRESSION_SCALE = 6;
 	
@@ -98,55 +100,23 @@ namespace moblib::Script {
 
 			// NOTE: maybe add something in here if the player parries them up close right before they shoot
 			
-			TheNomad::GameSystem::RayCast ray;
-			
 			const vec3 origin = m_EntityData.GetOrigin();
+			const float angle = m_EntityData.GetAngle();
 
-			ray.m_Start = origin;
-			ray.m_nLength = MERC_SHOTGUN_RANGE;
-			ray.m_nAngle = m_EntityData.GetAngle();
-			ray.m_nOwner = m_EntityData.GetEntityNum();
-			ray.Cast();
-
-			if ( ray.m_nEntityNumber == ENTITYNUM_WALL ) {
-				// TODO: add wall hit mark here
-				const float velocity = ray.m_nLength - TheNomad::Util::Distance( ray.m_Origin, ray.m_Start );
-				TheNomad::SGame::GfxManager.AddDebrisCloud( ray.m_Origin, velocity );
-				TheNomad::SGame::GfxManager.AddBulletHole( ray.m_Origin );
-				m_EntityData.EmitSound( ResourceCache.ShottyAttackSfx, 10.0f, 0xff );
-				TheNomad::SGame::GfxManager.AddMuzzleFlash( origin );
-				
-				TheNomad::SGame::PlayrObject@ player = TheNomad::SGame::EntityManager.GetActivePlayer();
-				
-				if ( TheNomad::Util::Distance( player.GetOrigin(), ray.m_Origin ) <= 2.90f ) {
-					// if we're close to the bullet, then simulate a near-hit
-					player.EmitSound(
-						TheNomad::Engine::SoundSystem::RegisterSfx(
-							"event:/sfx/env/bullet_impact/ricochet_" + ( TheNomad::Util::PRandom() & 2 )
-						),
-						10.0f, 0xff
-					);
-					// TODO: shake screen?
-				}
-				return;
-			} else if ( ray.m_nEntityNumber == ENTITYNUM_INVALID ) {
-				TheNomad::SGame::PlayrObject@ player = TheNomad::SGame::EntityManager.GetActivePlayer();
-				
-				if ( TheNomad::Util::Distance( player.GetOrigin(), ray.m_Origin ) <= 2.90f ) {
-					// if we're close to the bullet, then simulate a near-hit
-					player.EmitSound(
-						TheNomad::Engine::SoundSystem::RegisterSfx(
-							"event:/sfx/env/bullet_impact/ricochet_" + ( TheNomad::Util::PRandom() & 2 )
-						),
-						10.0f, 0xff
-					);
-					// TODO: shake screen?
-				}
-				return;
+			// the whole spread is traced in one engine call
+			for ( uint i = 0; i < MERC_SHOTGUN_PELLETS; i++ ) {
+				m_Pellets[i].m_Start = origin;
+				m_Pellets[i].m_nLength = MERC_SHOTGUN_RANGE;
+				m_Pellets[i].m_nAngle = angle + MERC_SHOTGUN_SPREAD * ( float( i ) / float( MERC_SHOTGUN_PELLETS - 1 ) - 0.5f );
+				m_Pellets[i].m_nOwner = m_EntityData.GetEntityNum();
 			}
-			
-			TheNomad::SGame::EntityObject@ hit = TheNomad::SGame::EntityManager.GetEntityForNum( ray.m_nEntityNumber );
-			if ( hit.GetType() == TheNomad::GameSystem::EntityType::Mob ) {
+			TheNomad::GameSystem::CastRays( m_Pellets );
+
+			// the middle pellet is where they're aiming
+			const uint aimEntity = m_Pellets[ MERC_SHOTGUN_PELLETS / 2 ].m_nEntityNumber;
+			if ( aimEntity != ENTITYNUM_INVALID && aimEntity != ENTITYNUM_WALL
+				&& TheNomad::SGame::EntityManager.GetEntityForNum( aimEntity ).GetType() == TheNomad::GameSystem::EntityType::Mob )
+			{
 				m_EntityData.EmitSound( ResourceCache.ShottyOutOfTheWay[ TheNomad::Util::PRandom()
 					& ( ResourceCache.ShottyOutOfTheWay.Count() - 1 ) ], 10.0f, 0xff );
 				return; // don't shoot
@@ -154,7 +124,37 @@ namespace moblib::Script {
 			m_EntityData.EmitSound( ResourceCache.ShottyAttackSfx, 10.0f, 0xff );
 			TheNomad::SGame::GfxManager.AddMuzzleFlash( origin );
 
-			TheNomad::SGame::EntityManager.DamageEntity( hit, m_EntityData, MERC_SHOTGUN_DAMAGE );
+			TheNomad::SGame::PlayrObject@ player = TheNomad::SGame::EntityManager.GetActivePlayer();
+			bool nearMiss = false;
+			for ( uint i = 0; i < MERC_SHOTGUN_PELLETS; i++ ) {
+				const TheNomad::GameSystem::RayCast ray = m_Pellets[i];
+
+				if ( ray.m_nEntityNumber == ENTITYNUM_WALL ) {
+					// TODO: add wall hit mark here
+					const float velocity = ray.m_nLength - TheNomad::Util::Distance( ray.m_Origin, ray.m_Start );
+					TheNomad::SGame::GfxManager.AddDebrisCloud( ray.m_Origin, velocity );
+					TheNomad::SGame::GfxManager.AddBulletHole( ray.m_Origin );
+				} else if ( ray.m_nEntityNumber != ENTITYNUM_INVALID ) {
+					TheNomad::SGame::EntityObject@ hit = TheNomad::SGame::EntityManager.GetEntityForNum( ray.m_nEntityNumber );
+					if ( hit.GetType() != TheNomad::GameSystem::EntityType::Mob ) {
+						TheNomad::SGame::EntityManager.DamageEntity( hit, m_EntityData, MERC_SHOTGUN_DAMAGE / MERC_SHOTGUN_PELLETS );
+					}
+					continue;
+				}
+				if ( TheNomad::Util::Distance( player.GetOrigin(), ray.m_Origin ) <= 2.90f ) {
+					nearMiss = true;
+				}
+			}
+			if ( nearMiss ) {
+				// if we're close to the bullet, then simulate a near-hit
+				player.EmitSound(
+					TheNomad::Engine::SoundSystem::RegisterSfx(
+						"event:/sfx/env/bullet_impact/ricochet_" + ( TheNomad::Util::PRandom() & 2 )
+					),
+					10.0f, 0xff
+				);
+				// TODO: shake screen?
+			}
 		}
 		void FightMelee() override {
 		}
@@ -321,6 +321,8 @@ namespace moblib::Script {
 
 		private moblib::System::AISquad@ m_Squad = null;
 
+		private array<TheNomad::GameSystem::RayCast> m_Pellets = array<TheNomad::GameSystem::RayCast>( MERC_SHOTGUN_PELLETS );
+
 		private vec3 m_OldTargetPosition = vec3( 0.0f );
 		private uint m_nLastBarkTime = 0;
 		private uint m_nLastCheckTime = 0;
@@ -1,29 +1,46 @@
 namespace moblib::System {
-	class AIAStarNode {
-		AIAStarNode() {
+	//
+	// AIAStarPath: the searching itself is done by the engine over a few frames,
+	// Poll() has to be called every frame until it stops returning Pending
+	//
+	class AIAStarPath {
+		AIAStarPath() {
 		}
-		
-	};
-	
-	class AIAStarNodeLinkedList {
-		AIAStarNodeLinkedList() {
+		~AIAStarPath() {
+			Cancel();
 		}
-		
-		AIAStarNode@ m_OpenList = null;
-		AIAStarNode@ m_ClosedList = null;
-	};
-	
-	class AIAStarNavMesh {
-		AIAStarNodeLinkedList@ FindPath( const vec3& in goal, const vec3& in origin ) {
-			AIAStarNodeLinkedList@ path = null;
-			
-			path = AIAStarNodeLinkedList();
-			
-			path.
+
+		void Request( const vec3& in origin, const vec3& in goal ) {
+			Cancel();
+			m_Waypoints.Resize( 0 );
+			m_hPath = TheNomad::GameSystem::RequestPath( origin, goal );
+			m_nStatus = m_hPath != 0 ? TheNomad::GameSystem::PathStatus::Pending : TheNomad::GameSystem::PathStatus::Invalid;
+		}
+
+		TheNomad::GameSystem::PathStatus Poll() {
+			if ( m_nStatus == TheNomad::GameSystem::PathStatus::Pending ) {
+				m_nStatus = TheNomad::GameSystem::PollPath( m_hPath, @m_Waypoints );
+				if ( m_nStatus != TheNomad::GameSystem::PathStatus::Pending ) {
+					m_hPath = 0;
+				}
+			}
+			return m_nStatus;
+		}
+
+		void Cancel() {
+			if ( m_hPath != 0 ) {
+				TheNomad::GameSystem::CancelPath( m_hPath );
+				m_hPath = 0;
+			}
+			m_nStatus = TheNomad::GameSystem::PathStatus::Invalid;
+		}
+
+		const array<vec3>@ GetWaypoints() const {
+			return @m_Waypoints;
 		}
-		
-		array<array<AIAStarNode@>> m_NodeTree;
+
+		private array<vec3> m_Waypoints;
+		private int m_hPath = 0;
+		private TheNomad::GameSystem::PathStatus m_nStatus = TheNomad::GameSystem::PathStatus::Invalid;
 	};
-	
-	AIAStarNavMesh@ NavMesh = null;
-};
\ No newline at end of file
+};
@@ -9,7 +9,8 @@ namespace moblib::System {
 		}
 
 		void Init( TheNomad::SGame::MobObject@ mob ) {
-			@m_EntityData = @mob;	
+			@m_EntityData = @mob;
+			m_Eyes.Init( @mob );
 		}
 		
 		bool CheckSensor() {
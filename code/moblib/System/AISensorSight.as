@@ -1,15 +1,113 @@
 namespace moblib {
+	//
+	// AISightBatch: the line of sight rays of every mob go out in a single CastRays call,
+	// the first sight check of a tic resolves all of them and the rest read the results
+	//
+	class AISightBatch {
+		AISightBatch() {
+		}
+
+		void Add( AISensorSight@ sensor ) {
+			m_Sensors.Add( @sensor );
+		}
+		void Clear() {
+			m_Sensors.Clear();
+			m_Rays.Clear();
+		}
+
+		void Update() {
+			if ( m_nLastTic == TheNomad::GameSystem::GameTic ) {
+				return;
+			}
+			m_nLastTic = TheNomad::GameSystem::GameTic;
+
+			for ( uint i = 0; i < m_Sensors.Count(); ) {
+				if ( m_Sensors[i].GetMob().CheckFlags( TheNomad::SGame::EntityFlags::Dead ) ) {
+					m_Sensors.RemoveAt( i );
+					continue;
+				}
+				i++;
+			}
+			if ( m_Sensors.Count() == 0 ) {
+				return;
+			}
+
+			m_Rays.Resize( m_Sensors.Count() );
+			for ( uint i = 0; i < m_Sensors.Count(); i++ ) {
+				m_Rays[i] = m_Sensors[i].BuildRay();
+			}
+			TheNomad::GameSystem::CastRays( m_Rays );
+			for ( uint i = 0; i < m_Sensors.Count(); i++ ) {
+				m_Sensors[i].SetResult( m_Rays[i].m_nEntityNumber );
+			}
+		}
+
+		private array<AISensorSight@> m_Sensors;
+		private array<TheNomad::GameSystem::RayCast> m_Rays;
+		private uint m_nLastTic = 0;
+	};
+
+	AISightBatch SightBatch;
+
 	class AISensorSight {
 		AISensorSight() {
 		}
-		
-		bool DoCheck( TheNomad::SGame::MobObject@ mob ) const {
-//			TheNomad::SGame::EntityObject@ ent = null;
+
+		void Init( TheNomad::SGame::MobObject@ mob ) {
+			@m_EntityData = @mob;
+			SightBatch.Add( @this );
+		}
+
+		TheNomad::SGame::MobObject@ GetMob() {
+			return @m_EntityData;
+		}
+
+		bool DoCheck( TheNomad::SGame::MobObject@ mob ) {
+			SightBatch.Update();
+
+			if ( @mob.GetTarget() !is null ) {
+				const vec3 origin = mob.GetOrigin();
+				const vec3 target = TheNomad::SGame::EntityManager.GetActivePlayer().GetOrigin();
+				mob.SetAngle( -atan2( origin.y - target.y, target.x - origin.x ) );
+			}
+			if ( !m_bCanSee ) {
+				return false;
+			}
+
+			mob.SetTarget( @TheNomad::SGame::EntityManager.GetActivePlayer() );
+
+			return true;
+		}
+
+		void SetResult( uint nEntityNumber ) {
+			if ( !m_bInView ) {
+				m_bCanSee = false;
+				return;
+			}
+			if ( nEntityNumber != ENTITYNUM_INVALID && nEntityNumber != ENTITYNUM_WALL
+				&& nEntityNumber >= TheNomad::SGame::EntityManager.NumEntities() )
+			{
+				GameError( "MobObject::SightCheck: ray entity number is out of range (" + nEntityNumber + ")"  );
+			}
+			m_bCanSee = nEntityNumber == TheNomad::SGame::EntityManager.GetActivePlayer().GetEntityNum();
+		}
+
+		//
+		// BuildRay: fills in this tic's line of sight ray, a mob without a target only
+		// looks inside the box in front of it
+		//
+		TheNomad::GameSystem::RayCast BuildRay() {
+			TheNomad::SGame::MobObject@ mob = @m_EntityData;
 			const TheNomad::SGame::InfoSystem::MobInfo@ info = @mob.GetMobInfo();
 			const vec3 origin = mob.GetOrigin();
 			TheNomad::GameSystem::RayCast ray;
 
 			const vec3 target = TheNomad::SGame::EntityManager.GetActivePlayer().GetOrigin();
+
+			ray.m_Start = origin;
+			ray.m_nOwner = mob.GetEntityNum();
+			m_bInView = true;
+
 			if ( @mob.GetTarget() is null ) {
 				vec3 mins;
 				vec3 maxs;
@@ -94,50 +192,28 @@ namespace moblib {
 				}
 				*/
 				if ( !bounds.IntersectsPoint( target ) ) {
-					return false;
+					// nothing to trace, it still takes a slot in the batch
+					m_bInView = false;
+					ray.m_nLength = 0.0f;
+					return ray;
 				}
-				
+
 				//
 				// make sure that the line of sight isn't obstructed
 				//
-				ray.m_nLength = info.sightRange;
-				ray.m_Start = origin;
-				ray.m_nAngle = mob.GetAngle();
-				ray.m_nOwner = mob.GetEntityNum();
-
-				if ( ray.m_nAngle < 0.0f ) {
-					const float tmp = TheNomad::Util::RAD2DEG( ray.m_nAngle ) + 360.0f;
-					ray.m_nAngle = TheNomad::Util::DEG2RAD( tmp );
-				}
-
-				ray.Cast( target );
-
-				if ( ray.m_nEntityNumber != TheNomad::SGame::EntityManager.GetActivePlayer().GetEntityNum() ) {
-					return false;
-				} else if ( ray.m_nEntityNumber >= TheNomad::SGame::EntityManager.NumEntities() ) {
-					GameError( "MobObject::SightCheck: ray entity number is out of range (" + ray.m_nEntityNumber + ")"  );
-				}
+				ray.m_nLength = TheNomad::Util::Distance( origin, target );
+				ray.m_nAngle = -atan2( origin.y - target.y, target.x - origin.x );
 			}
 			else {
-				mob.SetAngle( -atan2( origin.y - target.y, target.x - origin.x ) );
-
 				ray.m_nLength = info.sightRange;
-				ray.m_Start = origin;
-				ray.m_nAngle = mob.GetAngle();
-				ray.m_nOwner = mob.GetEntityNum();
-
-				ray.Cast();
-
-				if ( ray.m_nEntityNumber != TheNomad::SGame::EntityManager.GetActivePlayer().GetEntityNum() ) {
-					return false;
-				} else if ( ray.m_nEntityNumber >= TheNomad::SGame::EntityManager.NumEntities() ) {
-					GameError( "MobObject::SightCheck: ray entity number is out of range (" + ray.m_nEntityNumber + ")"  );
-				}
+				ray.m_nAngle = -atan2( origin.y - target.y, target.x - origin.x );
 			}
-			
-			mob.SetTarget( @TheNomad::SGame::EntityManager.GetActivePlayer() );
-			
-			return true;
+
+			return ray;
 		}
+
+		private TheNomad::SGame::MobObject@ m_EntityData = null;
+		private bool m_bInView = false;
+		private bool m_bCanSee = false;
 	};
 };
\ No newline at end of file
@@ -39,6 +39,7 @@ namespace moblib {
 	}
 
 	int ModuleOnLevelEnd() {
+		SightBatch.Clear();
 		return 1;
 	}
 
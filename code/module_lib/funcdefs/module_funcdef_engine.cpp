@@ -36,6 +36,10 @@ const string_t CvarVariableString( const string_t *name )
 { return Cvar_VariableString( name->c_str() ); }
 void CvarSet( const string_t *name, const string_t *value )
 { Cvar_Set( name->c_str(), value->c_str() ); }
+void CvarWatch( cvarHandle_t cvarHandle )
+{ Cvar_Watch( cvarHandle ); }
+int CvarNextChanged( void )
+{ return Cvar_NextChanged(); }
 
 const string_t CmdArgv( asDWORD nArg )
 { return Cmd_Argv( nArg ); }
@@ -143,6 +147,8 @@ void ScriptLib_Register_Engine( void )
 		REGISTER_GLOBAL_FUNCTION( "void TheNomad::Engine::CvarUpdate( string& out value, int& out, float& out, int32& out, int )",
 			asFUNCTION( CvarUpdate ), asCALL_CDECL );
 		REGISTER_GLOBAL_FUNCTION( "void TheNomad::Engine::CvarSet( const string& in, const string& in )", asFUNCTION( CvarSet ), asCALL_CDECL );
+		REGISTER_GLOBAL_FUNCTION( "void TheNomad::Engine::CvarWatch( int )", asFUNCTION( CvarWatch ), asCALL_CDECL );
+		REGISTER_GLOBAL_FUNCTION( "int TheNomad::Engine::CvarNextChanged()", asFUNCTION( CvarNextChanged ), asCALL_CDECL );
 	}
 	{
 		REGISTER_GLOBAL_FUNCTION( "const string TheNomad::Engine::CmdArgv( uint )", asFUNCTION( CmdArgv ), asCALL_CDECL );
@@ -1,9 +1,12 @@
 #include "../module_public.h"
 #include "../../game/g_world.h"
+#include "../../AILib/AIFlowField.h"
 #include "module_funcdefs.h"
+#include "../module_bindings.h"
 #include "../../ui/ui_string_manager.h"
 #include "../module_engine/module_bbox.h"
 #include "../module_engine/module_linkentity.h"
+#include "../module_engine/module_raycast.h"
 #include "../module_engine/module_gpuconfig.h"
 #include <glm/gtc/type_ptr.hpp>
 
@@ -40,6 +43,9 @@ CModuleLinkEntity& CModuleLinkEntity::operator=( const CModuleLinkEntity& other
 
 void CModuleLinkEntity::Update( void ) {
 	ToLinkEntity( &handle );
+	if ( m_bLinked ) {
+		g_world->EntityMoved( &handle );
+	}
 }
 
 void CModuleLinkEntity::SetOrigin( const glm::vec3& origin ) {
@@ -73,6 +79,46 @@ void CModuleLinkEntity::ToLinkEntity( linkEntity_t *ent ) {
 	ent->id = m_nEntityId;
 	ent->type = m_nEntityType;
 	ent->entityNumber = m_nEntityNumber;
+	ent->flags = m_nFlags;
+}
+
+CModuleRayCast::CModuleRayCast( void ) {
+	memset( this, 0, sizeof( *this ) );
+	entityNumber = ENTITYNUM_INVALID;
+	ownerNumber = ENTITYNUM_INVALID;
+	ownerNumber2 = ENTITYNUM_INVALID;
+	speed = 0.5f;
+}
+
+void CModuleRayCast::ToRay( ray_t *ray ) const {
+	memset( ray, 0, sizeof( *ray ) );
+	VectorCopy( ray->start, start );
+	ray->ownerNumber = ownerNumber;
+	ray->ownerNumber2 = ownerNumber2;
+	ray->speed = speed;
+	ray->length = length;
+	ray->angle = angle;
+	ray->flags = flags;
+}
+
+void CModuleRayCast::FromRay( const ray_t *ray ) {
+	VectorCopy( end, ray->end );
+	VectorCopy( origin, ray->origin );
+	entityNumber = ray->entityNumber;
+}
+
+void CModuleRayCast::Cast( void ) {
+	ray_t ray;
+
+	ToRay( &ray );
+	g_world->CastRays( &ray, 1, qtrue );
+	FromRay( &ray );
+}
+
+void CModuleRayCast::Cast( const glm::vec3& endPoint ) {
+	length = glm::distance( glm::vec2( start ), glm::vec2( endPoint ) );
+	angle = atan2( endPoint.y - start.y, endPoint.x - start.x );
+	Cast();
 }
 
 CModuleBoundBox::CModuleBoundBox( void ) {
@@ -104,17 +150,9 @@ void CModuleBoundBox::Zero( void ) {
 
 bool CModuleBoundBox::IntersectsEntity( uint32_t *nEntityNumber ) const
 {
-	const linkEntity_t *activeEnts = g_world->GetEntities();
-	const linkEntity_t *ent = activeEnts->next;
 	const bbox_t thisData = ToPOD();
 
-	for ( ; ent != activeEnts; ent = ent->next ) {
-		if ( BoundsIntersect( &ent->bounds, &thisData ) ) {
-			*nEntityNumber = ent->entityNumber;
-			return true;
-		}
-	}
-	return false;
+	return g_world->BoxEntities( &thisData, nEntityNumber, 1 ) != 0;
 }
 
 float CModuleBoundBox::GetRadius( void ) const {
@@ -312,6 +350,8 @@ static CModuleLinkEntity LinkEntityCopyConstruct(
 { return CModuleLinkEntity( origin, bounds, nEntityId, nEntityType, nEntityNumber ); }
 static void LinkEntityDestruct( CModuleLinkEntity& entity )
 { entity.~CModuleLinkEntity(); }
+static void RayCastConstruct( CModuleRayCast *pRay )
+{ new ( pRay ) CModuleRayCast(); }
 
 static void BeginSaveSection( const string_t& name )
 { g_pArchiveHandler->BeginSaveSection( g_pModuleLib->GetCurrentHandle()->GetName().c_str(), name.c_str() ); }
@@ -406,6 +446,218 @@ static void CastRay( const glm::vec3& start, glm::vec3& origin, uint32_t& nEntit
 	VectorCopy( origin, ray.origin );
 }
 
+//
+// CastRays: resolves a whole array<RayCast> in one engine call, the hit entity and
+// end position of every ray are written back into the array
+//
+static void CastRays( CScriptArray *pArray )
+{
+	ray_t *pRays;
+	asUINT i, nRays;
+
+	nRays = pArray->GetSize();
+	if ( !nRays ) {
+		return;
+	}
+
+	// the array keeps a pointer per element even for value types, so go through At()
+	pRays = (ray_t *)Hunk_AllocateTempMemory( sizeof( *pRays ) * nRays );
+	for ( i = 0; i < nRays; i++ ) {
+		( (const CModuleRayCast *)pArray->At( i ) )->ToRay( &pRays[i] );
+	}
+
+	g_world->CastRays( pRays, nRays, qtrue );
+
+	for ( i = 0; i < nRays; i++ ) {
+		( (CModuleRayCast *)pArray->At( i ) )->FromRay( &pRays[i] );
+	}
+
+	Hunk_FreeTempMemory( pRays );
+}
+
+/*
+* ML_RayCastCheck_f: casts the same rays through a script array<RayCast> with CastRays and
+* one at a time with RayCast::Cast() against a synthetic map with every fourth entity dead,
+* the results have to match and no ray can stop on a dead entity
+*/
+void ML_RayCastCheck_f( void )
+{
+	asITypeInfo *pType;
+	CScriptArray *pArray;
+	CModuleRayCast *pRay, *pSingle;
+	CGameWorld *pWorld, *pOldWorld;
+	mapinfo_t info;
+	linkEntity_t *ents;
+	uint32_t i, nRays, nEnts, nHits, nDeadHits, nMismatched;
+	int seed;
+
+	if ( !g_pModuleLib || !g_pModuleLib->GetScriptEngine() ) {
+		Con_Printf( "ml.raycast_check: the script engine isn't running\n" );
+		return;
+	}
+	pType = g_pModuleLib->GetScriptEngine()->GetTypeInfoByDecl( "array<TheNomad::GameSystem::RayCast>" );
+	if ( !pType ) {
+		Con_Printf( "ml.raycast_check: array<TheNomad::GameSystem::RayCast> isn't registered\n" );
+		return;
+	}
+
+	nRays = 1000;
+	if ( Cmd_Argc() > 1 ) {
+		nRays = MAX( atoi( Cmd_Argv( 1 ) ), 1 );
+	}
+	nEnts = 1024;
+
+	memset( &info, 0, sizeof( info ) );
+	N_strncpyz( info.name, "raycast_check", sizeof( info.name ) );
+	info.width = 128;
+	info.height = 128;
+	info.numTiles = info.width * info.height;
+	info.numLevels = 1;
+
+	info.tiles = (maptile_t *)Hunk_AllocateTempMemory( sizeof( *info.tiles ) * info.numTiles );
+	memset( info.tiles, 0, sizeof( *info.tiles ) * info.numTiles );
+	ents = (linkEntity_t *)Hunk_AllocateTempMemory( sizeof( *ents ) * nEnts );
+	memset( ents, 0, sizeof( *ents ) * nEnts );
+	pWorld = new ( Hunk_AllocateTempMemory( sizeof( *pWorld ) ) ) CGameWorld();
+	pWorld->Init( &info );
+
+	seed = 0x52415943;
+	for ( i = 0; i < nEnts; i++ ) {
+		ents[i].origin[0] = Q_random( &seed ) * info.width;
+		ents[i].origin[1] = Q_random( &seed ) * info.height;
+		VectorSet( ents[i].bounds.mins, ents[i].origin[0] - 0.5f, ents[i].origin[1] - 0.5f, -0.5f );
+		VectorSet( ents[i].bounds.maxs, ents[i].origin[0] + 0.5f, ents[i].origin[1] + 0.5f, 0.5f );
+		ents[i].entityNumber = i;
+		ents[i].type = ET_MOB;
+		ents[i].flags = ( i & 3 ) == 0 ? LINKFLAG_DEAD : 0;
+		pWorld->LinkEntity( &ents[i] );
+	}
+
+	pArray = CScriptArray::Create( pType, nRays );
+	pSingle = (CModuleRayCast *)Hunk_AllocateTempMemory( sizeof( *pSingle ) * nRays );
+	for ( i = 0; i < nRays; i++ ) {
+		pRay = (CModuleRayCast *)pArray->At( i );
+		pRay->start = glm::vec3( Q_random( &seed ) * info.width, Q_random( &seed ) * info.height, 0.0f );
+		pRay->angle = Q_random( &seed ) * M_PI * 2.0f;
+		pRay->length = 32.0f;
+		pRay->ownerNumber = i % nEnts;
+		new ( &pSingle[i] ) CModuleRayCast( *pRay );
+	}
+
+	// RayCast goes through g_world like it does in a level
+	pOldWorld = g_world;
+	g_world = pWorld;
+	CastRays( pArray );
+	for ( i = 0; i < nRays; i++ ) {
+		pSingle[i].Cast();
+	}
+	g_world = pOldWorld;
+
+	nHits = nDeadHits = nMismatched = 0;
+	for ( i = 0; i < nRays; i++ ) {
+		pRay = (CModuleRayCast *)pArray->At( i );
+		if ( pRay->entityNumber != pSingle[i].entityNumber || pRay->origin != pSingle[i].origin ) {
+			nMismatched++;
+		}
+		if ( pRay->entityNumber < nEnts ) {
+			nHits++;
+			if ( ents[ pRay->entityNumber ].flags & LINKFLAG_DEAD ) {
+				nDeadHits++;
+			}
+		}
+	}
+
+	Con_Printf( "ml.raycast_check: %u rays, %u hits, %u mismatched, %u on dead entities, %s\n", nRays, nHits, nMismatched, nDeadHits,
+		nMismatched || nDeadHits ? "FAILED" : "passed" );
+
+	pArray->Release();
+	Hunk_FreeTempMemory( pSingle );
+	pWorld->~CGameWorld();
+	Hunk_FreeTempMemory( pWorld );
+	Hunk_FreeTempMemory( ents );
+	Hunk_FreeTempMemory( info.tiles );
+}
+
+static nhandle_t RequestPath( const glm::vec3& origin, const glm::vec3& goal, bool bJumpPoint )
+{
+	if ( !g_pNavMesh ) {
+		return FS_INVALID_HANDLE;
+	}
+	return g_pNavMesh->RequestPath( (const vec_t *)glm::value_ptr( origin ), (const vec_t *)glm::value_ptr( goal ), (qboolean)bJumpPoint );
+}
+
+//
+// PollPath: once a path is done the waypoints are copied out as tile coordinates and
+// the request is released, the handle can't be polled again after that
+//
+static pathStatus_t PollPath( nhandle_t hPath, CScriptArray *pWaypoints )
+{
+	const uint32_t *pTiles;
+	glm::vec3 *pPoint;
+	uint32_t i, nWaypoints;
+	pathStatus_t status;
+
+	if ( !g_pNavMesh ) {
+		return PATH_FREE;
+	}
+
+	status = g_pNavMesh->PollPath( hPath, &pTiles, &nWaypoints );
+	if ( status == PATH_FOUND && pWaypoints ) {
+		pWaypoints->Resize( nWaypoints );
+		for ( i = 0; i < nWaypoints; i++ ) {
+			pPoint = (glm::vec3 *)pWaypoints->At( i );
+			pPoint->x = pTiles[i] % g_pNavMesh->GetWidth();
+			pPoint->y = pTiles[i] / g_pNavMesh->GetWidth();
+			pPoint->z = 0.0f;
+		}
+	}
+	if ( status == PATH_FOUND || status == PATH_NOT_FOUND ) {
+		g_pNavMesh->ReleasePath( hPath );
+	}
+
+	return status;
+}
+
+static void CancelPath( nhandle_t hPath )
+{
+	if ( g_pNavMesh ) {
+		g_pNavMesh->ReleasePath( hPath );
+	}
+}
+
+static void SetFlowFieldTarget( const glm::vec3& origin )
+{
+	if ( g_pFlowField ) {
+		g_pFlowField->SetTarget( (const vec_t *)glm::value_ptr( origin ) );
+	}
+}
+
+//
+// GetFlowDirection: the direction to step in from the given position to get closer to
+// the flow field's target, Inside if the target is out of range or already reached
+//
+static dirtype_t GetFlowDirection( const glm::vec3& origin )
+{
+	if ( !g_pFlowField ) {
+		return DIR_NULL;
+	}
+	return g_pFlowField->GetDirection( g_pNavMesh->TileForPoint( (const vec_t *)glm::value_ptr( origin ) ) );
+}
+
+static void RebuildNavArea( uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1 )
+{
+	if ( !g_pNavMesh ) {
+		return;
+	}
+	x1 = MIN( x1, g_pNavMesh->GetWidth() - 1 );
+	y1 = MIN( y1, g_pNavMesh->GetHeight() - 1 );
+	if ( x0 > x1 || y0 > y1 ) {
+		return;
+	}
+	g_pNavMesh->RebuildArea( x0, y0, x1, y1 );
+	g_pFlowField->MarkDirty( x0, y0, x1, y1 );
+}
+
 static bool CheckWallHit( const glm::vec3& vec, dirtype_t nDir )
 { return g_world->CheckWallHit( (const vec_t *)glm::value_ptr( vec ), nDir ); }
 
@@ -451,21 +703,21 @@ void ScriptLib_Register_Game( void )
 	REGISTER_OBJECT_PROPERTY( "TheNomad::GameSystem::BBox", "vec3 m_nMins", offsetof( CModuleBoundBox, mins ) );
 	REGISTER_OBJECT_PROPERTY( "TheNomad::GameSystem::BBox", "vec3 m_nMaxs", offsetof( CModuleBoundBox, maxs ) );
 	REGISTER_METHOD_FUNCTION( "TheNomad::GameSystem::BBox", "TheNomad::GameSystem::BBox& opAssign( const TheNomad::GameSystem::BBox& in )",
-		asMETHODPR( CModuleBoundBox, operator=, ( const CModuleBoundBox& ), CModuleBoundBox& ), asCALL_THISCALL );
+		BIND_METHOD_PR( CModuleBoundBox, operator=, ( const CModuleBoundBox& ), CModuleBoundBox& ), BIND_CALL_THISCALL );
 	REGISTER_METHOD_FUNCTION( "TheNomad::GameSystem::BBox", "void MakeBounds( const vec3& in )",
-		asMETHODPR( CModuleBoundBox, MakeBounds, ( const glm::vec3& ), void ), asCALL_THISCALL );
+		BIND_METHOD_PR( CModuleBoundBox, MakeBounds, ( const glm::vec3& ), void ), BIND_CALL_THISCALL );
 	REGISTER_METHOD_FUNCTION( "TheNomad::GameSystem::BBox", "bool LineIntersection( const vec3& in, const vec3& in )",
-		asMETHODPR( CModuleBoundBox, LineIntersection, ( const glm::vec3&, const glm::vec3& ) const, bool ), asCALL_THISCALL );
+		BIND_METHOD_PR( CModuleBoundBox, LineIntersection, ( const glm::vec3&, const glm::vec3& ) const, bool ), BIND_CALL_THISCALL );
 	REGISTER_METHOD_FUNCTION( "TheNomad::GameSystem::BBox", "bool IntersectsPoint( const vec3& in )",
-		asMETHODPR( CModuleBoundBox, ContainsPoint, ( const glm::vec3& ) const, bool ), asCALL_THISCALL );
+		BIND_METHOD_PR( CModuleBoundBox, ContainsPoint, ( const glm::vec3& ) const, bool ), BIND_CALL_THISCALL );
 	REGISTER_METHOD_FUNCTION( "TheNomad::GameSystem::BBox", "bool IntersectsSphere( const vec3& in, float )",
-		asMETHODPR( CModuleBoundBox, IntersectsSphere, ( const glm::vec3&, float ) const, bool ), asCALL_THISCALL );
+		BIND_METHOD_PR( CModuleBoundBox, IntersectsSphere, ( const glm::vec3&, float ) const, bool ), BIND_CALL_THISCALL );
 	REGISTER_METHOD_FUNCTION( "TheNomad::GameSystem::BBox", "bool IntersectsBounds( const TheNomad::GameSystem::BBox& in )",
-		asMETHODPR( CModuleBoundBox, IntersectsBounds, ( const CModuleBoundBox& ) const, bool ), asCALL_THISCALL );
+		BIND_METHOD_PR( CModuleBoundBox, IntersectsBounds, ( const CModuleBoundBox& ) const, bool ), BIND_CALL_THISCALL );
 	REGISTER_METHOD_FUNCTION( "TheNomad::GameSystem::BBox", "bool RayIntersection( const vec3& in, const vec3& in, float )",
 		asMETHODPR( CModuleBoundBox, RayIntersection, ( const glm::vec3&, const glm::vec3&, float& ) const, bool ), asCALL_THISCALL );
-	REGISTER_METHOD_FUNCTION( "TheNomad::GameSystem::BBox", "void Clear()", asMETHODPR( CModuleBoundBox, Clear, ( void ), void ), asCALL_THISCALL );
-	REGISTER_METHOD_FUNCTION( "TheNomad::GameSystem::BBox", "void Zero()", asMETHODPR( CModuleBoundBox, Zero, ( void ), void ), asCALL_THISCALL );
+	REGISTER_METHOD_FUNCTION( "TheNomad::GameSystem::BBox", "void Clear()", BIND_METHOD_PR( CModuleBoundBox, Clear, ( void ), void ), BIND_CALL_THISCALL );
+	REGISTER_METHOD_FUNCTION( "TheNomad::GameSystem::BBox", "void Zero()", BIND_METHOD_PR( CModuleBoundBox, Zero, ( void ), void ), BIND_CALL_THISCALL );
 
 	REGISTER_OBJECT_TYPE( "LinkEntity", CModuleLinkEntity, asOBJ_VALUE );
 	REGISTER_OBJECT_BEHAVIOUR( "TheNomad::GameSystem::LinkEntity", asBEHAVE_CONSTRUCT, "void f()", asFUNCTION( LinkEntityConstruct ), asCALL_CDECL_OBJFIRST );
@@ -477,21 +729,22 @@ void ScriptLib_Register_Game( void )
 	REGISTER_OBJECT_PROPERTY( "TheNomad::GameSystem::LinkEntity", "uint32 m_nEntityId", offsetof( CModuleLinkEntity, m_nEntityId ) );
 	REGISTER_OBJECT_PROPERTY( "TheNomad::GameSystem::LinkEntity", "uint32 m_nEntityType", offsetof( CModuleLinkEntity, m_nEntityType ) );
 	REGISTER_OBJECT_PROPERTY( "TheNomad::GameSystem::LinkEntity", "uint32 m_nEntityNumber", offsetof( CModuleLinkEntity, m_nEntityNumber ) );
+	REGISTER_OBJECT_PROPERTY( "TheNomad::GameSystem::LinkEntity", "uint32 m_nFlags", offsetof( CModuleLinkEntity, m_nFlags ) );
 	
 	REGISTER_METHOD_FUNCTION( "TheNomad::GameSystem::LinkEntity", "void Create( const vec3& in, const BBox& in, uint, uint, uint )",
 		asFUNCTION( LinkEntityCopyConstruct ), asCALL_CDECL_OBJFIRST );
 	REGISTER_METHOD_FUNCTION( "TheNomad::GameSystem::LinkEntity", "TheNomad::GameSystem::LinkEntity& opAssign( const TheNomad::GameSystem::LinkEntity& in )",
-		asMETHODPR( CModuleLinkEntity, operator=, ( const CModuleLinkEntity& ), CModuleLinkEntity& ), asCALL_THISCALL );
+		BIND_METHOD_PR( CModuleLinkEntity, operator=, ( const CModuleLinkEntity& ), CModuleLinkEntity& ), BIND_CALL_THISCALL );
 	REGISTER_METHOD_FUNCTION( "TheNomad::GameSystem::LinkEntity", "void SetOrigin( const vec3& in )",
-		asMETHODPR( CModuleLinkEntity, SetOrigin, ( const glm::vec3& ), void ), asCALL_THISCALL );
+		BIND_METHOD_PR( CModuleLinkEntity, SetOrigin, ( const glm::vec3& ), void ), BIND_CALL_THISCALL );
 	REGISTER_METHOD_FUNCTION( "TheNomad::GameSystem::LinkEntity", "void SetBounds( const BBox& in )",
-		asMETHODPR( CModuleLinkEntity, SetBounds, ( const CModuleBoundBox& ), void ), asCALL_THISCALL );
+		BIND_METHOD_PR( CModuleLinkEntity, SetBounds, ( const CModuleBoundBox& ), void ), BIND_CALL_THISCALL );
 	REGISTER_METHOD_FUNCTION( "TheNomad::GameSystem::LinkEntity", "const vec3& GetOrigin( void ) const",
-		asMETHODPR( CModuleLinkEntity, GetOrigin, ( void ), const glm::vec3& ), asCALL_THISCALL );
+		BIND_METHOD_PR( CModuleLinkEntity, GetOrigin, ( void ), const glm::vec3& ), BIND_CALL_THISCALL );
 	REGISTER_METHOD_FUNCTION( "TheNomad::GameSystem::LinkEntity", "const BBox& GetBounds( void ) const",
-		asMETHODPR( CModuleLinkEntity, GetBounds, ( void ), const CModuleBoundBox& ), asCALL_THISCALL );
+		BIND_METHOD_PR( CModuleLinkEntity, GetBounds, ( void ), const CModuleBoundBox& ), BIND_CALL_THISCALL );
 	REGISTER_METHOD_FUNCTION( "TheNomad::GameSystem::LinkEntity", "void Update()",
-		asMETHODPR( CModuleLinkEntity, Update, ( void ), void ), asCALL_THISCALL );
+		BIND_METHOD_PR( CModuleLinkEntity, Update, ( void ), void ), BIND_CALL_THISCALL );
 
 	REGISTER_GLOBAL_FUNCTION( "void TheNomad::GameSystem::GetString( const string& in, string& out )", asFUNCTION( GetString ), asCALL_CDECL );
 
@@ -603,10 +856,49 @@ void ScriptLib_Register_Game( void )
 	REGISTER_ENUM_VALUE( "DirType", "Inside", DIR_NULL );
 	REGISTER_ENUM_VALUE( "DirType", "NumDirs", NUMDIRS );
 
+	// m_Start, m_End and m_Origin are in map tile units, the same space as entity origins
+	REGISTER_OBJECT_TYPE( "RayCast", CModuleRayCast, asOBJ_VALUE | asOBJ_POD | asOBJ_APP_CLASS_C );
+	REGISTER_OBJECT_BEHAVIOUR( "TheNomad::GameSystem::RayCast", asBEHAVE_CONSTRUCT, "void f()", asFUNCTION( RayCastConstruct ),
+		asCALL_CDECL_OBJFIRST );
+	REGISTER_OBJECT_PROPERTY( "TheNomad::GameSystem::RayCast", "vec3 m_Start", offsetof( CModuleRayCast, start ) );
+	REGISTER_OBJECT_PROPERTY( "TheNomad::GameSystem::RayCast", "vec3 m_End", offsetof( CModuleRayCast, end ) );
+	REGISTER_OBJECT_PROPERTY( "TheNomad::GameSystem::RayCast", "vec3 m_Origin", offsetof( CModuleRayCast, origin ) );
+	REGISTER_OBJECT_PROPERTY( "TheNomad::GameSystem::RayCast", "uint m_nEntityNumber", offsetof( CModuleRayCast, entityNumber ) );
+	REGISTER_OBJECT_PROPERTY( "TheNomad::GameSystem::RayCast", "uint m_nOwner", offsetof( CModuleRayCast, ownerNumber ) );
+	REGISTER_OBJECT_PROPERTY( "TheNomad::GameSystem::RayCast", "uint m_nOwner2", offsetof( CModuleRayCast, ownerNumber2 ) );
+	REGISTER_OBJECT_PROPERTY( "TheNomad::GameSystem::RayCast", "float m_nSpeed", offsetof( CModuleRayCast, speed ) );
+	REGISTER_OBJECT_PROPERTY( "TheNomad::GameSystem::RayCast", "float m_nLength", offsetof( CModuleRayCast, length ) );
+	REGISTER_OBJECT_PROPERTY( "TheNomad::GameSystem::RayCast", "float m_nAngle", offsetof( CModuleRayCast, angle ) );
+	REGISTER_OBJECT_PROPERTY( "TheNomad::GameSystem::RayCast", "uint m_Flags", offsetof( CModuleRayCast, flags ) );
+	REGISTER_METHOD_FUNCTION( "TheNomad::GameSystem::RayCast", "void Cast()",
+		BIND_METHOD_PR( CModuleRayCast, Cast, ( void ), void ), BIND_CALL_THISCALL );
+	REGISTER_METHOD_FUNCTION( "TheNomad::GameSystem::RayCast", "void Cast( const vec3& in )",
+		BIND_METHOD_PR( CModuleRayCast, Cast, ( const glm::vec3& ), void ), BIND_CALL_THISCALL );
+
+	// wide signatures like CastRay's are cheaper through angelscript's native call path than through
+	// asIScriptGeneric, see ml.binding_bench
 	REGISTER_GLOBAL_FUNCTION( "void TheNomad::GameSystem::CastRay( const vec3& in, vec3& out, uint32& out, uint, uint, float, float, float, uint32 )",
 		asFUNCTION( CastRay ), asCALL_CDECL );
-	REGISTER_GLOBAL_FUNCTION( "bool TheNomad::GameSystem::CheckWallHit( const vec3& in, TheNomad::GameSystem::DirType )", asFUNCTION( CheckWallHit ),
+	REGISTER_GLOBAL_FUNCTION( "void TheNomad::GameSystem::CastRays( array<TheNomad::GameSystem::RayCast>& inout )", asFUNCTION( CastRays ),
+		asCALL_CDECL );
+	REGISTER_GLOBAL_FUNCTION( "bool TheNomad::GameSystem::CheckWallHit( const vec3& in, TheNomad::GameSystem::DirType )", BIND_FUNCTION( CheckWallHit ),
+		BIND_CALL_CDECL );
+
+	REGISTER_ENUM_TYPE( "PathStatus" );
+	REGISTER_ENUM_VALUE( "PathStatus", "Invalid", PATH_FREE );
+	REGISTER_ENUM_VALUE( "PathStatus", "Pending", PATH_PENDING );
+	REGISTER_ENUM_VALUE( "PathStatus", "Found", PATH_FOUND );
+	REGISTER_ENUM_VALUE( "PathStatus", "NotFound", PATH_NOT_FOUND );
+
+	REGISTER_GLOBAL_FUNCTION( "int TheNomad::GameSystem::RequestPath( const vec3& in, const vec3& in, bool = true )", asFUNCTION( RequestPath ),
+		asCALL_CDECL );
+	REGISTER_GLOBAL_FUNCTION( "TheNomad::GameSystem::PathStatus TheNomad::GameSystem::PollPath( int, array<vec3>@ )", asFUNCTION( PollPath ),
 		asCALL_CDECL );
+	REGISTER_GLOBAL_FUNCTION( "void TheNomad::GameSystem::CancelPath( int )", asFUNCTION( CancelPath ), asCALL_CDECL );
+	REGISTER_GLOBAL_FUNCTION( "void TheNomad::GameSystem::SetFlowFieldTarget( const vec3& in )", asFUNCTION( SetFlowFieldTarget ), asCALL_CDECL );
+	REGISTER_GLOBAL_FUNCTION( "TheNomad::GameSystem::DirType TheNomad::GameSystem::GetFlowDirection( const vec3& in )", BIND_FUNCTION( GetFlowDirection ),
+		BIND_CALL_CDECL );
+	REGISTER_GLOBAL_FUNCTION( "void TheNomad::GameSystem::RebuildNavArea( uint, uint, uint, uint )", asFUNCTION( RebuildNavArea ), asCALL_CDECL );
 
 	REGISTER_GLOBAL_FUNCTION( "void TheNomad::GameSystem::GetSkinData( const string& in, string& out, string& out, uvec2& out, uvec2& out, uvec2& out, uvec2& out, uvec2& out, uvec2& out )",
 		asFUNCTION( GetSkinData ), asCALL_CDECL );
@@ -615,6 +907,7 @@ void ScriptLib_Register_Game( void )
 	REGISTER_GLOBAL_FUNCTION( "void TheNomad::GameSystem::GetSpawnData( uvec3& out, uint& out, uint& out, uint, uint& out )", asFUNCTION( G_GetSpawnData ),
 		asCALL_CDECL );
 	REGISTER_GLOBAL_FUNCTION( "void TheNomad::GameSystem::GetTileData( array<array<uint64>>@ )", asFUNCTION( GetTileData ), asCALL_CDECL );
+	REGISTER_GLOBAL_FUNCTION( "void TheNomad::GameSystem::SetTileIndex( uint, uint, int )", asFUNCTION( G_SetTileIndex ), asCALL_CDECL );
 	REGISTER_GLOBAL_FUNCTION( "void TheNomad::GameSystem::SetActiveMap( int, uint& out, uint& out, uint& out, int& out, int& out )",
 		asFUNCTION( G_SetActiveMap ), asCALL_CDECL );
 	REGISTER_GLOBAL_FUNCTION( "int TheNomad::GameSystem::LoadMap( const string& in )", asFUNCTION( LoadMap ), asCALL_CDECL );
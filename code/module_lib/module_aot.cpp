@@ -0,0 +1,1065 @@
+// module_aot.cpp -- ahead-of-time compilation of module bytecode to C++
+
+#include "module_public.h"
+#include "angelscript/as_config.h"
+
+/*
+* every script function gets translated into a single C++ function that runs on angelscript's jit interface:
+* the vm calls it at a JitEntry instruction with the offset of that instruction, the C++ then runs the plain
+* arithmetic, branching, local variable and property access instructions itself and hands anything involving
+* calls, objects or exceptions back to the vm with AOT_EXIT, which continues until it hits the next JitEntry.
+*
+* the generated code bakes in variable offsets and constants, so every function is identified by its
+* declaration plus a hash of exactly the opcodes and arguments the translation depends on. Pointer arguments
+* (global variables, type ids) aren't stable between runs, those are read back from the live bytecode.
+*/
+
+typedef enum {
+	AOT_LABEL_TARGET = 0x01, // something jumps here
+	AOT_LABEL_ENTRY = 0x02, // JitEntry the vm resumes the native code at
+} aotLabel_t;
+
+typedef struct {
+	asIScriptFunction *pFunction;
+	const asDWORD *pCode;
+	asUINT nLength;
+	byte *pLabels;
+	uint32_t nEntries;
+	uint64_t nHash;
+} aotFunction_t;
+
+static asUINT AOT_InstructionSize( const asDWORD *pOp )
+{
+	return asBCTypeSize[ asBCInfo[ *(const asBYTE *)pOp ].type ];
+}
+
+/*
+* AOT_IsSupported: instructions AOT_EmitInstruction translates, everything else goes back to the vm
+*/
+static qboolean AOT_IsSupported( asEBCInstr op )
+{
+	switch ( op ) {
+	case asBC_JitEntry:
+	case asBC_SUSPEND:
+	case asBC_JMP:
+	case asBC_JZ:
+	case asBC_JNZ:
+	case asBC_JS:
+	case asBC_JNS:
+	case asBC_JP:
+	case asBC_JNP:
+	case asBC_JLowZ:
+	case asBC_JLowNZ:
+	case asBC_TZ:
+	case asBC_TNZ:
+	case asBC_TS:
+	case asBC_TNS:
+	case asBC_TP:
+	case asBC_TNP:
+	case asBC_NOT:
+	case asBC_ClrHi:
+	case asBC_NEGi:
+	case asBC_NEGf:
+	case asBC_NEGd:
+	case asBC_NEGi64:
+	case asBC_INCi8:
+	case asBC_DECi8:
+	case asBC_INCi16:
+	case asBC_DECi16:
+	case asBC_INCi:
+	case asBC_DECi:
+	case asBC_INCi64:
+	case asBC_DECi64:
+	case asBC_INCf:
+	case asBC_DECf:
+	case asBC_INCd:
+	case asBC_DECd:
+	case asBC_IncVi:
+	case asBC_DecVi:
+	case asBC_BNOT:
+	case asBC_BNOT64:
+	case asBC_BAND:
+	case asBC_BOR:
+	case asBC_BXOR:
+	case asBC_BSLL:
+	case asBC_BSRL:
+	case asBC_BSRA:
+	case asBC_BAND64:
+	case asBC_BOR64:
+	case asBC_BXOR64:
+	case asBC_BSLL64:
+	case asBC_BSRL64:
+	case asBC_BSRA64:
+	case asBC_ADDi:
+	case asBC_SUBi:
+	case asBC_MULi:
+	case asBC_DIVi:
+	case asBC_MODi:
+	case asBC_DIVu:
+	case asBC_MODu:
+	case asBC_ADDf:
+	case asBC_SUBf:
+	case asBC_MULf:
+	case asBC_DIVf:
+	case asBC_MODf:
+	case asBC_ADDd:
+	case asBC_SUBd:
+	case asBC_MULd:
+	case asBC_DIVd:
+	case asBC_MODd:
+	case asBC_ADDi64:
+	case asBC_SUBi64:
+	case asBC_MULi64:
+	case asBC_DIVi64:
+	case asBC_MODi64:
+	case asBC_DIVu64:
+	case asBC_MODu64:
+	case asBC_ADDIi:
+	case asBC_SUBIi:
+	case asBC_MULIi:
+	case asBC_ADDIf:
+	case asBC_SUBIf:
+	case asBC_MULIf:
+	case asBC_CMPi:
+	case asBC_CMPu:
+	case asBC_CMPf:
+	case asBC_CMPd:
+	case asBC_CMPi64:
+	case asBC_CMPu64:
+	case asBC_CmpPtr:
+	case asBC_CMPIi:
+	case asBC_CMPIu:
+	case asBC_CMPIf:
+	case asBC_SetV1:
+	case asBC_SetV2:
+	case asBC_SetV4:
+	case asBC_SetV8:
+	case asBC_CpyVtoV4:
+	case asBC_CpyVtoV8:
+	case asBC_CpyVtoR4:
+	case asBC_CpyVtoR8:
+	case asBC_CpyRtoV4:
+	case asBC_CpyRtoV8:
+	case asBC_ClrVPtr:
+	case asBC_iTOf:
+	case asBC_fTOi:
+	case asBC_uTOf:
+	case asBC_fTOu:
+	case asBC_sbTOi:
+	case asBC_swTOi:
+	case asBC_ubTOi:
+	case asBC_uwTOi:
+	case asBC_iTOb:
+	case asBC_iTOw:
+	case asBC_dTOi:
+	case asBC_dTOu:
+	case asBC_dTOf:
+	case asBC_iTOd:
+	case asBC_uTOd:
+	case asBC_fTOd:
+	case asBC_i64TOi:
+	case asBC_uTOi64:
+	case asBC_iTOi64:
+	case asBC_fTOi64:
+	case asBC_fTOu64:
+	case asBC_i64TOf:
+	case asBC_u64TOf:
+	case asBC_dTOi64:
+	case asBC_dTOu64:
+	case asBC_i64TOd:
+	case asBC_u64TOd:
+	case asBC_PshC4:
+	case asBC_PshV4:
+	case asBC_PshC8:
+	case asBC_PshV8:
+	case asBC_PSF:
+	case asBC_PshVPtr:
+	case asBC_PshNull:
+	case asBC_PopPtr:
+	case asBC_VAR:
+	case asBC_TYPEID:
+	case asBC_SwapPtr:
+	case asBC_PopRPtr:
+	case asBC_PshRPtr:
+	case asBC_RDSPtr:
+	case asBC_CHKREF:
+	case asBC_ChkRefS:
+	case asBC_ChkNullV:
+	case asBC_ChkNullS:
+	case asBC_ADDSi:
+	case asBC_GETREF:
+	case asBC_GETOBJREF:
+	case asBC_LoadThisR:
+	case asBC_LDV:
+	case asBC_RDR1:
+	case asBC_RDR2:
+	case asBC_RDR4:
+	case asBC_RDR8:
+	case asBC_WRTV1:
+	case asBC_WRTV2:
+	case asBC_WRTV4:
+	case asBC_WRTV8:
+	case asBC_PshG4:
+	case asBC_LdGRdR4:
+	case asBC_CpyGtoV4:
+	case asBC_CpyVtoG4:
+	case asBC_SetG4:
+	case asBC_PGA:
+	case asBC_PshGPtr:
+	case asBC_LDG:
+		return qtrue;
+	default:
+		break;
+	};
+	return qfalse;
+}
+
+/*
+* AOT_HasLiveArgs: instructions whose generated code reads its argument from the bytecode at runtime
+* instead of baking it in, only the opcode and the variable offset go into the hash for these
+*/
+static qboolean AOT_HasLiveArgs( asEBCInstr op )
+{
+	switch ( op ) {
+	case asBC_PshG4:
+	case asBC_LdGRdR4:
+	case asBC_CpyGtoV4:
+	case asBC_CpyVtoG4:
+	case asBC_SetG4:
+	case asBC_PGA:
+	case asBC_PshGPtr:
+	case asBC_LDG:
+	case asBC_TYPEID:
+	case asBC_ADDSi: // the dword is a type id the vm doesn't use
+	case asBC_LoadThisR: // same
+		return qtrue;
+	default:
+		break;
+	};
+	return qfalse;
+}
+
+/*
+* AOT_HashInstruction: mixes in the parts of an instruction asCByteCode::Output actually writes, the padding
+* isn't guaranteed to be zero
+*/
+static uint64_t AOT_HashInstruction( uint64_t nHash, const asDWORD *pOp )
+{
+	const asEBCInstr op = (asEBCInstr)*(const asBYTE *)pOp;
+	const asWORD *pWords = (const asWORD *)pOp;
+	const asUINT nSize = AOT_InstructionSize( pOp );
+	asUINT nWords, nFirstDWord;
+
+	nHash = ML_HashBytes( nHash, pOp, 1 );
+	if ( op == asBC_JitEntry || !AOT_IsSupported( op ) ) {
+		// the vm runs these straight from the bytecode, only the layout matters
+		return nHash;
+	}
+
+	switch ( asBCInfo[ op ].type ) {
+	case asBCTYPE_W_ARG:
+	case asBCTYPE_rW_ARG:
+	case asBCTYPE_wW_ARG:
+		nWords = 1;
+		nFirstDWord = nSize;
+		break;
+	case asBCTYPE_wW_rW_ARG:
+	case asBCTYPE_rW_rW_ARG:
+	case asBCTYPE_wW_W_ARG:
+		nWords = 2;
+		nFirstDWord = nSize;
+		break;
+	case asBCTYPE_wW_rW_rW_ARG:
+		nWords = 3;
+		nFirstDWord = nSize;
+		break;
+	case asBCTYPE_wW_DW_ARG:
+	case asBCTYPE_rW_DW_ARG:
+	case asBCTYPE_W_DW_ARG:
+	case asBCTYPE_wW_QW_ARG:
+	case asBCTYPE_rW_QW_ARG:
+	case asBCTYPE_rW_DW_DW_ARG:
+		nWords = 1;
+		nFirstDWord = 1;
+		break;
+	case asBCTYPE_wW_rW_DW_ARG:
+	case asBCTYPE_rW_W_DW_ARG:
+		nWords = 2;
+		nFirstDWord = 2;
+		break;
+	case asBCTYPE_DW_ARG:
+	case asBCTYPE_QW_ARG:
+	case asBCTYPE_DW_DW_ARG:
+	case asBCTYPE_QW_DW_ARG:
+		nWords = 0;
+		nFirstDWord = 1;
+		break;
+	default:
+		nWords = 0;
+		nFirstDWord = nSize;
+		break;
+	};
+
+	if ( nWords ) {
+		nHash = ML_HashBytes( nHash, pWords + 1, nWords * sizeof( asWORD ) );
+	}
+	if ( !AOT_HasLiveArgs( op ) && nFirstDWord < nSize ) {
+		nHash = ML_HashBytes( nHash, pOp + nFirstDWord, ( nSize - nFirstDWord ) * sizeof( asDWORD ) );
+	}
+	return nHash;
+}
+
+static asUINT AOT_JumpTarget( const asDWORD *pOp, asUINT nOffset )
+{
+	return nOffset + 2 + asBC_INTARG( pOp );
+}
+
+/*
+* AOT_AnalyzeFunction: finds the jump targets and resume points of a function and hashes it,
+* returns qfalse if there's nothing worth translating
+*/
+static qboolean AOT_AnalyzeFunction( aotFunction_t *pFunc, asIScriptFunction *pFunction )
+{
+	const asDWORD *pOp;
+	const char *pDecl;
+	asUINT nOffset, nNext;
+	asEBCInstr op;
+
+	memset( pFunc, 0, sizeof( *pFunc ) );
+
+	if ( pFunction->GetFuncType() != asFUNC_SCRIPT ) {
+		return qfalse;
+	}
+	pFunc->pFunction = pFunction;
+	pFunc->pCode = pFunction->GetByteCode( &pFunc->nLength );
+	if ( !pFunc->pCode || !pFunc->nLength ) {
+		return qfalse;
+	}
+
+	pDecl = pFunction->GetDeclaration( true, true, true );
+	pFunc->nHash = ML_HashBytes( ML_HASH_INIT, pDecl, strlen( pDecl ) );
+
+	pFunc->pLabels = (byte *)Hunk_AllocateTempMemory( pFunc->nLength );
+	memset( pFunc->pLabels, 0, pFunc->nLength );
+
+	for ( nOffset = 0; nOffset < pFunc->nLength; nOffset = nNext ) {
+		pOp = pFunc->pCode + nOffset;
+		op = (asEBCInstr)*(const asBYTE *)pOp;
+		nNext = nOffset + AOT_InstructionSize( pOp );
+
+		pFunc->nHash = AOT_HashInstruction( pFunc->nHash, pOp );
+
+		switch ( op ) {
+		case asBC_JMP:
+		case asBC_JZ:
+		case asBC_JNZ:
+		case asBC_JS:
+		case asBC_JNS:
+		case asBC_JP:
+		case asBC_JNP:
+		case asBC_JLowZ:
+		case asBC_JLowNZ:
+			pFunc->pLabels[ AOT_JumpTarget( pOp, nOffset ) ] |= AOT_LABEL_TARGET;
+			break;
+		case asBC_JitEntry:
+			// no point in entering native code that immediately exits again
+			if ( nNext < pFunc->nLength && AOT_IsSupported( (asEBCInstr)*(const asBYTE *)( pFunc->pCode + nNext ) ) ) {
+				pFunc->pLabels[ nOffset ] |= AOT_LABEL_ENTRY;
+				pFunc->nEntries++;
+			}
+			break;
+		default:
+			break;
+		};
+	}
+
+	if ( !pFunc->nEntries ) {
+		Hunk_FreeTempMemory( pFunc->pLabels );
+		pFunc->pLabels = NULL;
+		return qfalse;
+	}
+
+	return qtrue;
+}
+
+static void AOT_FreeFunction( aotFunction_t *pFunc )
+{
+	if ( pFunc->pLabels ) {
+		Hunk_FreeTempMemory( pFunc->pLabels );
+		pFunc->pLabels = NULL;
+	}
+}
+
+//
+// code generation
+//
+
+static const char *AOT_BoolResult( const char *pCondition )
+{
+#if AS_SIZEOF_BOOL == 1
+	return va( "{ asBYTE b = ( %s ) ? %i : 0; l_value = 0; AOT_SETR( asBYTE, b ); }", pCondition, VALUE_OF_BOOLEAN_TRUE );
+#else
+	return va( "AOT_SETR( int, ( %s ) ? %i : 0 );", pCondition, VALUE_OF_BOOLEAN_TRUE );
+#endif
+}
+
+static const char *AOT_BinaryOp( const char *pType, const char *pOperator, const asDWORD *pOp )
+{
+	return va( "AOT_SET( %s, %i, AOT_GET( %s, %i ) %s AOT_GET( %s, %i ) );", pType, asBC_SWORDARG0( pOp ),
+		pType, asBC_SWORDARG1( pOp ), pOperator, pType, asBC_SWORDARG2( pOp ) );
+}
+
+static const char *AOT_ShiftOp( const char *pType, const char *pOperator, const asDWORD *pOp )
+{
+	return va( "AOT_SET( %s, %i, AOT_GET( %s, %i ) %s AOT_GET( asDWORD, %i ) );", pType, asBC_SWORDARG0( pOp ),
+		pType, asBC_SWORDARG1( pOp ), pOperator, asBC_SWORDARG2( pOp ) );
+}
+
+// the vm raises the exception when it runs the instruction itself, the formats get the dividend's variable
+static const char *AOT_DivideOp( const char *pType, const char *pExpression, const char *pOverflow, const asDWORD *pOp, asUINT nOffset )
+{
+	char szExpression[ 128 ];
+	char szOverflow[ 128 ];
+
+	Com_snprintf( szExpression, sizeof( szExpression ), pExpression, asBC_SWORDARG1( pOp ) );
+	Com_snprintf( szOverflow, sizeof( szOverflow ), pOverflow, asBC_SWORDARG1( pOp ) );
+
+	return va( "{ %s d = AOT_GET( %s, %i ); if ( d == 0%s ) AOT_EXIT( %u ); AOT_SET( %s, %i, %s ); }", pType, pType,
+		asBC_SWORDARG2( pOp ), szOverflow, nOffset, pType, asBC_SWORDARG0( pOp ), szExpression );
+}
+
+static const char *AOT_Convert( const char *pTo, const char *pFrom, const char *pCast, short nDest, short nSource )
+{
+	return va( "AOT_SET( %s, %i, %sAOT_GET( %s, %i ) );", pTo, nDest, pCast, pFrom, nSource );
+}
+
+static const char *AOT_Compare( const char *pType, const asDWORD *pOp )
+{
+	return va( "AOT_SETR( int, AOT_Compare<%s>( AOT_GET( %s, %i ), AOT_GET( %s, %i ) ) );", pType, pType, asBC_SWORDARG0( pOp ),
+		pType, asBC_SWORDARG1( pOp ) );
+}
+
+static const char *AOT_Step( const char *pType, const char *pOperator )
+{
+	return va( "{ void *p = AOT_GETR( void * ); AOT_Store<%s>( p, (%s)( AOT_Load<%s>( p ) %s 1 ) ); }", pType, pType, pType, pOperator );
+}
+
+static const char *AOT_Jump( const char *pCondition, const asDWORD *pOp, asUINT nOffset )
+{
+	return va( "if ( %s ) goto bc_%u;", pCondition, AOT_JumpTarget( pOp, nOffset ) );
+}
+
+/*
+* AOT_EmitInstruction: returns the C++ for a single instruction, NULL if it has to run on the vm
+*/
+static const char *AOT_EmitInstruction( const asDWORD *pOp, asUINT nOffset )
+{
+	const asEBCInstr op = (asEBCInstr)*(const asBYTE *)pOp;
+	const short a = asBC_SWORDARG0( pOp );
+	const short b = asBC_SWORDARG1( pOp );
+
+	switch ( op ) {
+	case asBC_JitEntry:
+		return "";
+	case asBC_SUSPEND:
+		return va( "if ( pRegs->doProcessSuspend ) AOT_EXIT( %u );", nOffset );
+
+	case asBC_JMP:
+		return va( "goto bc_%u;", AOT_JumpTarget( pOp, nOffset ) );
+	case asBC_JZ:
+		return AOT_Jump( "AOT_GETR( int ) == 0", pOp, nOffset );
+	case asBC_JNZ:
+		return AOT_Jump( "AOT_GETR( int ) != 0", pOp, nOffset );
+	case asBC_JS:
+		return AOT_Jump( "AOT_GETR( int ) < 0", pOp, nOffset );
+	case asBC_JNS:
+		return AOT_Jump( "AOT_GETR( int ) >= 0", pOp, nOffset );
+	case asBC_JP:
+		return AOT_Jump( "AOT_GETR( int ) > 0", pOp, nOffset );
+	case asBC_JNP:
+		return AOT_Jump( "AOT_GETR( int ) <= 0", pOp, nOffset );
+	case asBC_JLowZ:
+		return AOT_Jump( "AOT_GETR( asBYTE ) == 0", pOp, nOffset );
+	case asBC_JLowNZ:
+		return AOT_Jump( "AOT_GETR( asBYTE ) != 0", pOp, nOffset );
+
+	case asBC_TZ:
+		return AOT_BoolResult( "AOT_GETR( int ) == 0" );
+	case asBC_TNZ:
+		return AOT_BoolResult( "AOT_GETR( int ) != 0" );
+	case asBC_TS:
+		return AOT_BoolResult( "AOT_GETR( int ) < 0" );
+	case asBC_TNS:
+		return AOT_BoolResult( "AOT_GETR( int ) >= 0" );
+	case asBC_TP:
+		return AOT_BoolResult( "AOT_GETR( int ) > 0" );
+	case asBC_TNP:
+		return AOT_BoolResult( "AOT_GETR( int ) <= 0" );
+	case asBC_NOT:
+#if AS_SIZEOF_BOOL == 1
+		return va( "{ asBYTE b = AOT_GET( asBYTE, %i ) == 0 ? %i : 0; AOT_SET( asDWORD, %i, 0 ); AOT_SET( asBYTE, %i, b ); }",
+			a, VALUE_OF_BOOLEAN_TRUE, a, a );
+#else
+		return va( "AOT_SET( asDWORD, %i, AOT_GET( asDWORD, %i ) == 0 ? %i : 0 );", a, a, VALUE_OF_BOOLEAN_TRUE );
+#endif
+	case asBC_ClrHi:
+#if AS_SIZEOF_BOOL == 1
+		return "{ asBYTE b = AOT_GETR( asBYTE ); AOT_SETR( asDWORD, 0 ); AOT_SETR( asBYTE, b ); }";
+#else
+		return "";
+#endif
+
+	case asBC_NEGi:
+		return va( "AOT_SET( asDWORD, %i, 0u - AOT_GET( asDWORD, %i ) );", a, a );
+	case asBC_NEGf:
+		return va( "AOT_SET( float, %i, -AOT_GET( float, %i ) );", a, a );
+	case asBC_NEGd:
+		return va( "AOT_SET( double, %i, -AOT_GET( double, %i ) );", a, a );
+	case asBC_NEGi64:
+		return va( "AOT_SET( asQWORD, %i, 0ull - AOT_GET( asQWORD, %i ) );", a, a );
+
+	case asBC_INCi8:
+		return AOT_Step( "char", "+" );
+	case asBC_DECi8:
+		return AOT_Step( "char", "-" );
+	case asBC_INCi16:
+		return AOT_Step( "short", "+" );
+	case asBC_DECi16:
+		return AOT_Step( "short", "-" );
+	case asBC_INCi:
+		return AOT_Step( "asDWORD", "+" );
+	case asBC_DECi:
+		return AOT_Step( "asDWORD", "-" );
+	case asBC_INCi64:
+		return AOT_Step( "asQWORD", "+" );
+	case asBC_DECi64:
+		return AOT_Step( "asQWORD", "-" );
+	case asBC_INCf:
+		return AOT_Step( "float", "+" );
+	case asBC_DECf:
+		return AOT_Step( "float", "-" );
+	case asBC_INCd:
+		return AOT_Step( "double", "+" );
+	case asBC_DECd:
+		return AOT_Step( "double", "-" );
+	case asBC_IncVi:
+		return va( "AOT_SET( asDWORD, %i, AOT_GET( asDWORD, %i ) + 1 );", a, a );
+	case asBC_DecVi:
+		return va( "AOT_SET( asDWORD, %i, AOT_GET( asDWORD, %i ) - 1 );", a, a );
+
+	case asBC_BNOT:
+		return va( "AOT_SET( asDWORD, %i, ~AOT_GET( asDWORD, %i ) );", a, a );
+	case asBC_BNOT64:
+		return va( "AOT_SET( asQWORD, %i, ~AOT_GET( asQWORD, %i ) );", a, a );
+	case asBC_BAND:
+		return AOT_BinaryOp( "asDWORD", "&", pOp );
+	case asBC_BOR:
+		return AOT_BinaryOp( "asDWORD", "|", pOp );
+	case asBC_BXOR:
+		return AOT_BinaryOp( "asDWORD", "^", pOp );
+	case asBC_BSLL:
+		return AOT_ShiftOp( "asDWORD", "<<", pOp );
+	case asBC_BSRL:
+		return AOT_ShiftOp( "asDWORD", ">>", pOp );
+	case asBC_BSRA:
+		return AOT_ShiftOp( "int", ">>", pOp );
+	case asBC_BAND64:
+		return AOT_BinaryOp( "asQWORD", "&", pOp );
+	case asBC_BOR64:
+		return AOT_BinaryOp( "asQWORD", "|", pOp );
+	case asBC_BXOR64:
+		return AOT_BinaryOp( "asQWORD", "^", pOp );
+	case asBC_BSLL64:
+		return AOT_ShiftOp( "asQWORD", "<<", pOp );
+	case asBC_BSRL64:
+		return AOT_ShiftOp( "asQWORD", ">>", pOp );
+	case asBC_BSRA64:
+		return AOT_ShiftOp( "asINT64", ">>", pOp );
+
+	// integer math wraps the same way the vm's does, without the signed overflow
+	case asBC_ADDi:
+		return AOT_BinaryOp( "asDWORD", "+", pOp );
+	case asBC_SUBi:
+		return AOT_BinaryOp( "asDWORD", "-", pOp );
+	case asBC_MULi:
+		return AOT_BinaryOp( "asDWORD", "*", pOp );
+	case asBC_DIVi:
+		return AOT_DivideOp( "int", "AOT_GET( int, %i ) / d", " || ( d == -1 && AOT_GET( asDWORD, %i ) == 0x80000000u )",
+			pOp, nOffset );
+	case asBC_MODi:
+		return AOT_DivideOp( "int", "AOT_GET( int, %i ) %% d", " || ( d == -1 && AOT_GET( asDWORD, %i ) == 0x80000000u )",
+			pOp, nOffset );
+	case asBC_DIVu:
+		return AOT_DivideOp( "asDWORD", "AOT_GET( asDWORD, %i ) / d", "", pOp, nOffset );
+	case asBC_MODu:
+		return AOT_DivideOp( "asDWORD", "AOT_GET( asDWORD, %i ) %% d", "", pOp, nOffset );
+	case asBC_ADDf:
+		return AOT_BinaryOp( "float", "+", pOp );
+	case asBC_SUBf:
+		return AOT_BinaryOp( "float", "-", pOp );
+	case asBC_MULf:
+		return AOT_BinaryOp( "float", "*", pOp );
+	case asBC_DIVf:
+		return AOT_DivideOp( "float", "AOT_GET( float, %i ) / d", "", pOp, nOffset );
+	case asBC_MODf:
+		return AOT_DivideOp( "float", "fmodf( AOT_GET( float, %i ), d )", "", pOp, nOffset );
+	case asBC_ADDd:
+		return AOT_BinaryOp( "double", "+", pOp );
+	case asBC_SUBd:
+		return AOT_BinaryOp( "double", "-", pOp );
+	case asBC_MULd:
+		return AOT_BinaryOp( "double", "*", pOp );
+	case asBC_DIVd:
+		return AOT_DivideOp( "double", "AOT_GET( double, %i ) / d", "", pOp, nOffset );
+	case asBC_MODd:
+		return AOT_DivideOp( "double", "fmod( AOT_GET( double, %i ), d )", "", pOp, nOffset );
+	case asBC_ADDi64:
+		return AOT_BinaryOp( "asQWORD", "+", pOp );
+	case asBC_SUBi64:
+		return AOT_BinaryOp( "asQWORD", "-", pOp );
+	case asBC_MULi64:
+		return AOT_BinaryOp( "asQWORD", "*", pOp );
+	case asBC_DIVi64:
+		return AOT_DivideOp( "asINT64", "AOT_GET( asINT64, %i ) / d",
+			" || ( d == -1 && AOT_GET( asQWORD, %i ) == 0x8000000000000000ull )", pOp, nOffset );
+	case asBC_MODi64:
+		return AOT_DivideOp( "asINT64", "AOT_GET( asINT64, %i ) %% d",
+			" || ( d == -1 && AOT_GET( asQWORD, %i ) == 0x8000000000000000ull )", pOp, nOffset );
+	case asBC_DIVu64:
+		return AOT_DivideOp( "asQWORD", "AOT_GET( asQWORD, %i ) / d", "", pOp, nOffset );
+	case asBC_MODu64:
+		return AOT_DivideOp( "asQWORD", "AOT_GET( asQWORD, %i ) %% d", "", pOp, nOffset );
+	case asBC_ADDIi:
+		return va( "AOT_SET( asDWORD, %i, AOT_GET( asDWORD, %i ) + 0x%08xu );", a, b, asBC_DWORDARG( pOp + 1 ) );
+	case asBC_SUBIi:
+		return va( "AOT_SET( asDWORD, %i, AOT_GET( asDWORD, %i ) - 0x%08xu );", a, b, asBC_DWORDARG( pOp + 1 ) );
+	case asBC_MULIi:
+		return va( "AOT_SET( asDWORD, %i, AOT_GET( asDWORD, %i ) * 0x%08xu );", a, b, asBC_DWORDARG( pOp + 1 ) );
+	case asBC_ADDIf:
+		return va( "AOT_SET( float, %i, AOT_GET( float, %i ) + AOT_Float( 0x%08xu ) );", a, b, asBC_DWORDARG( pOp + 1 ) );
+	case asBC_SUBIf:
+		return va( "AOT_SET( float, %i, AOT_GET( float, %i ) - AOT_Float( 0x%08xu ) );", a, b, asBC_DWORDARG( pOp + 1 ) );
+	case asBC_MULIf:
+		return va( "AOT_SET( float, %i, AOT_GET( float, %i ) * AOT_Float( 0x%08xu ) );", a, b, asBC_DWORDARG( pOp + 1 ) );
+
+	case asBC_CMPi:
+		return AOT_Compare( "int", pOp );
+	case asBC_CMPu:
+		return AOT_Compare( "asDWORD", pOp );
+	case asBC_CMPf:
+		return AOT_Compare( "float", pOp );
+	case asBC_CMPd:
+		return AOT_Compare( "double", pOp );
+	case asBC_CMPi64:
+		return AOT_Compare( "asINT64", pOp );
+	case asBC_CMPu64:
+		return AOT_Compare( "asQWORD", pOp );
+	case asBC_CmpPtr:
+		return AOT_Compare( "asPWORD", pOp );
+	case asBC_CMPIi:
+		return va( "AOT_SETR( int, AOT_Compare<int>( AOT_GET( int, %i ), (int)0x%08xu ) );", a, asBC_DWORDARG( pOp ) );
+	case asBC_CMPIu:
+		return va( "AOT_SETR( int, AOT_Compare<asDWORD>( AOT_GET( asDWORD, %i ), 0x%08xu ) );", a, asBC_DWORDARG( pOp ) );
+	case asBC_CMPIf:
+		return va( "AOT_SETR( int, AOT_Compare<float>( AOT_GET( float, %i ), AOT_Float( 0x%08xu ) ) );", a, asBC_DWORDARG( pOp ) );
+
+	case asBC_SetV1:
+	case asBC_SetV2:
+	case asBC_SetV4:
+		return va( "AOT_SET( asDWORD, %i, 0x%08xu );", a, asBC_DWORDARG( pOp ) );
+	case asBC_SetV8:
+		return va( "AOT_SET( asQWORD, %i, 0x%016llxull );", a, (unsigned long long)asBC_QWORDARG( pOp ) );
+	case asBC_CpyVtoV4:
+		return va( "AOT_SET( asDWORD, %i, AOT_GET( asDWORD, %i ) );", a, b );
+	case asBC_CpyVtoV8:
+		return va( "AOT_SET( asQWORD, %i, AOT_GET( asQWORD, %i ) );", a, b );
+	case asBC_CpyVtoR4:
+		return va( "AOT_SETR( asDWORD, AOT_GET( asDWORD, %i ) );", a );
+	case asBC_CpyVtoR8:
+		return va( "l_value = AOT_GET( asQWORD, %i );", a );
+	case asBC_CpyRtoV4:
+		return va( "AOT_SET( asDWORD, %i, AOT_GETR( asDWORD ) );", a );
+	case asBC_CpyRtoV8:
+		return va( "AOT_SET( asQWORD, %i, l_value );", a );
+	case asBC_ClrVPtr:
+		return va( "AOT_SET( asPWORD, %i, 0 );", a );
+
+	case asBC_iTOf:
+		return AOT_Convert( "float", "int", "(float)", a, a );
+	case asBC_fTOi:
+		return AOT_Convert( "int", "float", "(int)", a, a );
+	case asBC_uTOf:
+		return AOT_Convert( "float", "asDWORD", "(float)", a, a );
+	case asBC_fTOu:
+		return AOT_Convert( "asDWORD", "float", "(asDWORD)(int)", a, a );
+	case asBC_sbTOi:
+		return AOT_Convert( "int", "signed char", "", a, a );
+	case asBC_swTOi:
+		return AOT_Convert( "int", "short", "", a, a );
+	case asBC_ubTOi:
+		return AOT_Convert( "int", "asBYTE", "", a, a );
+	case asBC_uwTOi:
+		return AOT_Convert( "int", "asWORD", "", a, a );
+	case asBC_iTOb:
+		return va( "{ asBYTE v = (asBYTE)AOT_GET( asDWORD, %i ); AOT_SET( asDWORD, %i, 0 ); AOT_SET( asBYTE, %i, v ); }", a, a, a );
+	case asBC_iTOw:
+		return va( "{ asWORD v = (asWORD)AOT_GET( asDWORD, %i ); AOT_SET( asDWORD, %i, 0 ); AOT_SET( asWORD, %i, v ); }", a, a, a );
+	case asBC_dTOi:
+		return AOT_Convert( "int", "double", "(int)", a, b );
+	case asBC_dTOu:
+		return AOT_Convert( "asDWORD", "double", "(asDWORD)(int)", a, b );
+	case asBC_dTOf:
+		return AOT_Convert( "float", "double", "(float)", a, b );
+	case asBC_iTOd:
+		return AOT_Convert( "double", "int", "(double)", a, b );
+	case asBC_uTOd:
+		return AOT_Convert( "double", "asDWORD", "(double)", a, b );
+	case asBC_fTOd:
+		return AOT_Convert( "double", "float", "(double)", a, b );
+	case asBC_i64TOi:
+		return AOT_Convert( "int", "asINT64", "(int)", a, b );
+	case asBC_uTOi64:
+		return AOT_Convert( "asINT64", "asDWORD", "(asINT64)", a, b );
+	case asBC_iTOi64:
+		return AOT_Convert( "asINT64", "int", "(asINT64)", a, b );
+	case asBC_fTOi64:
+		return AOT_Convert( "asINT64", "float", "(asINT64)", a, b );
+	case asBC_fTOu64:
+		return AOT_Convert( "asQWORD", "float", "(asQWORD)(asINT64)", a, b );
+	case asBC_i64TOf:
+		return AOT_Convert( "float", "asINT64", "(float)", a, b );
+	case asBC_u64TOf:
+		return AOT_Convert( "float", "asQWORD", "(float)", a, b );
+	case asBC_dTOi64:
+		return AOT_Convert( "asINT64", "double", "(asINT64)", a, a );
+	case asBC_dTOu64:
+		return AOT_Convert( "asQWORD", "double", "(asQWORD)(asINT64)", a, a );
+	case asBC_i64TOd:
+		return AOT_Convert( "double", "asINT64", "(double)", a, a );
+	case asBC_u64TOd:
+		return AOT_Convert( "double", "asQWORD", "(double)", a, a );
+
+	case asBC_PshC4:
+		return va( "l_sp -= 1; AOT_Store<asDWORD>( l_sp, 0x%08xu );", asBC_DWORDARG( pOp ) );
+	case asBC_PshV4:
+		return va( "l_sp -= 1; AOT_Store<asDWORD>( l_sp, AOT_GET( asDWORD, %i ) );", a );
+	case asBC_PshC8:
+		return va( "l_sp -= 2; AOT_Store<asQWORD>( l_sp, 0x%016llxull );", (unsigned long long)asBC_QWORDARG( pOp ) );
+	case asBC_PshV8:
+		return va( "l_sp -= 2; AOT_Store<asQWORD>( l_sp, AOT_GET( asQWORD, %i ) );", a );
+	case asBC_PSF:
+		return va( "l_sp -= AS_PTR_SIZE; AOT_Store<asPWORD>( l_sp, (asPWORD)( l_fp - ( %i ) ) );", a );
+	case asBC_PshVPtr:
+		return va( "l_sp -= AS_PTR_SIZE; AOT_Store<asPWORD>( l_sp, AOT_GET( asPWORD, %i ) );", a );
+	case asBC_PshNull:
+		return "l_sp -= AS_PTR_SIZE; AOT_Store<asPWORD>( l_sp, 0 );";
+	case asBC_PopPtr:
+		return "l_sp += AS_PTR_SIZE;";
+	case asBC_VAR:
+		return va( "l_sp -= AS_PTR_SIZE; AOT_Store<asPWORD>( l_sp, (asPWORD)( %i ) );", a );
+	case asBC_TYPEID:
+		return va( "l_sp -= 1; AOT_Store<asDWORD>( l_sp, AOT_DWORDARG( %u, 1 ) );", nOffset );
+	case asBC_SwapPtr:
+		return "{ asPWORD p = AOT_Load<asPWORD>( l_sp ); AOT_Store<asPWORD>( l_sp, AOT_Load<asPWORD>( l_sp + AS_PTR_SIZE ) );"
+			" AOT_Store<asPWORD>( l_sp + AS_PTR_SIZE, p ); }";
+	case asBC_PopRPtr:
+		return "AOT_SETR( asPWORD, AOT_Load<asPWORD>( l_sp ) ); l_sp += AS_PTR_SIZE;";
+	case asBC_PshRPtr:
+		return "l_sp -= AS_PTR_SIZE; AOT_Store<asPWORD>( l_sp, AOT_GETR( asPWORD ) );";
+	case asBC_RDSPtr:
+		return va( "{ asPWORD p = AOT_Load<asPWORD>( l_sp ); if ( !p ) AOT_EXIT( %u ); AOT_Store<asPWORD>( l_sp, AOT_Load<asPWORD>( (const void *)p ) ); }",
+			nOffset );
+	case asBC_CHKREF:
+		return va( "if ( !AOT_Load<asPWORD>( l_sp ) ) AOT_EXIT( %u );", nOffset );
+	case asBC_ChkRefS:
+		return va( "if ( !AOT_Load<asPWORD>( (const void *)AOT_Load<asPWORD>( l_sp ) ) ) AOT_EXIT( %u );", nOffset );
+	case asBC_ChkNullV:
+		return va( "if ( !AOT_GET( asPWORD, %i ) ) AOT_EXIT( %u );", a, nOffset );
+	case asBC_ChkNullS:
+		return va( "if ( !AOT_Load<asPWORD>( l_sp + %u ) ) AOT_EXIT( %u );", asBC_WORDARG0( pOp ), nOffset );
+	case asBC_ADDSi:
+		return va( "{ asPWORD p = AOT_Load<asPWORD>( l_sp ); if ( !p ) AOT_EXIT( %u ); AOT_Store<asPWORD>( l_sp, p + (asPWORD)( %i ) ); }",
+			nOffset, a );
+	case asBC_GETREF:
+		return va( "{ asDWORD *p = l_sp + %u; AOT_Store<asPWORD>( p, (asPWORD)( l_fp - (int)AOT_Load<asPWORD>( p ) ) ); }",
+			asBC_WORDARG0( pOp ) );
+	case asBC_GETOBJREF:
+		return va( "{ asDWORD *p = l_sp + %u; AOT_Store<asPWORD>( p, AOT_Load<asPWORD>( l_fp - AOT_Load<asPWORD>( p ) ) ); }",
+			asBC_WORDARG0( pOp ) );
+	case asBC_LoadThisR:
+		return va( "{ asPWORD p = AOT_GET( asPWORD, 0 ); if ( !p ) AOT_EXIT( %u ); AOT_SETR( asPWORD, p + (asPWORD)( %i ) ); }",
+			nOffset, a );
+
+	case asBC_LDV:
+		return va( "AOT_SETR( asPWORD, (asPWORD)( l_fp - ( %i ) ) );", a );
+	case asBC_RDR1:
+		return va( "{ asBYTE v = AOT_Load<asBYTE>( AOT_GETR( void * ) ); AOT_SET( asDWORD, %i, 0 ); AOT_SET( asBYTE, %i, v ); }", a, a );
+	case asBC_RDR2:
+		return va( "{ asWORD v = AOT_Load<asWORD>( AOT_GETR( void * ) ); AOT_SET( asDWORD, %i, 0 ); AOT_SET( asWORD, %i, v ); }", a, a );
+	case asBC_RDR4:
+		return va( "AOT_SET( asDWORD, %i, AOT_Load<asDWORD>( AOT_GETR( void * ) ) );", a );
+	case asBC_RDR8:
+		return va( "AOT_SET( asQWORD, %i, AOT_Load<asQWORD>( AOT_GETR( void * ) ) );", a );
+	case asBC_WRTV1:
+		return va( "AOT_Store<asBYTE>( AOT_GETR( void * ), AOT_GET( asBYTE, %i ) );", a );
+	case asBC_WRTV2:
+		return va( "AOT_Store<asWORD>( AOT_GETR( void * ), AOT_GET( asWORD, %i ) );", a );
+	case asBC_WRTV4:
+		return va( "AOT_Store<asDWORD>( AOT_GETR( void * ), AOT_GET( asDWORD, %i ) );", a );
+	case asBC_WRTV8:
+		return va( "AOT_Store<asQWORD>( AOT_GETR( void * ), AOT_GET( asQWORD, %i ) );", a );
+
+	case asBC_PshG4:
+		return va( "l_sp -= 1; AOT_Store<asDWORD>( l_sp, AOT_Load<asDWORD>( (const void *)AOT_PTRARG( %u ) ) );", nOffset );
+	case asBC_LdGRdR4:
+		return va( "AOT_SETR( asPWORD, AOT_PTRARG( %u ) ); AOT_SET( asDWORD, %i, AOT_Load<asDWORD>( (const void *)AOT_PTRARG( %u ) ) );",
+			nOffset, a, nOffset );
+	case asBC_CpyGtoV4:
+		return va( "AOT_SET( asDWORD, %i, AOT_Load<asDWORD>( (const void *)AOT_PTRARG( %u ) ) );", a, nOffset );
+	case asBC_CpyVtoG4:
+		return va( "AOT_Store<asDWORD>( (void *)AOT_PTRARG( %u ), AOT_GET( asDWORD, %i ) );", nOffset, a );
+	case asBC_SetG4:
+		return va( "AOT_Store<asDWORD>( (void *)AOT_PTRARG( %u ), AOT_DWORDARG( %u, 1 + AS_PTR_SIZE ) );", nOffset, nOffset );
+	case asBC_PGA:
+		return va( "l_sp -= AS_PTR_SIZE; AOT_Store<asPWORD>( l_sp, AOT_PTRARG( %u ) );", nOffset );
+	case asBC_PshGPtr:
+		return va( "l_sp -= AS_PTR_SIZE; AOT_Store<asPWORD>( l_sp, AOT_Load<asPWORD>( (const void *)AOT_PTRARG( %u ) ) );", nOffset );
+	case asBC_LDG:
+		return va( "AOT_SETR( asPWORD, AOT_PTRARG( %u ) );", nOffset );
+	default:
+		break;
+	};
+
+	return NULL;
+}
+
+static void AOT_WriteFunction( fileHandle_t hFile, const aotFunction_t *pFunc, uint32_t nIndex )
+{
+	const asDWORD *pOp;
+	const char *pCode;
+	asUINT nOffset;
+
+	FS_Printf( hFile, "// %s\n", pFunc->pFunction->GetDeclaration( true, true, true ) );
+	FS_Printf( hFile, "static void AOT_Function%u( asSVMRegisters *pRegs, asPWORD nEntry )\n{\n", nIndex );
+	FS_Printf( hFile, "\tAOT_BEGIN();\n\n" );
+
+	FS_Printf( hFile, "\tswitch ( nEntry ) {\n" );
+	for ( nOffset = 0; nOffset < pFunc->nLength; nOffset++ ) {
+		if ( pFunc->pLabels[ nOffset ] & AOT_LABEL_ENTRY ) {
+			FS_Printf( hFile, "\tcase %u: goto bc_%u;\n", nOffset + 1, nOffset );
+		}
+	}
+	// shouldn't ever happen, skip the JitEntry so the vm doesn't call us again
+	FS_Printf( hFile, "\tdefault: pRegs->programPointer += 1 + AS_PTR_SIZE; return;\n" );
+	FS_Printf( hFile, "\t};\n\n" );
+
+	for ( nOffset = 0; nOffset < pFunc->nLength; nOffset += AOT_InstructionSize( pOp ) ) {
+		pOp = pFunc->pCode + nOffset;
+
+		if ( pFunc->pLabels[ nOffset ] ) {
+			FS_Printf( hFile, "bc_%u: ;\n", nOffset );
+		}
+
+		pCode = AOT_IsSupported( (asEBCInstr)*(const asBYTE *)pOp ) ? AOT_EmitInstruction( pOp, nOffset ) : NULL;
+		if ( !pCode ) {
+			FS_Printf( hFile, "\tAOT_EXIT( %u ); // %s\n", nOffset, asBCInfo[ *(const asBYTE *)pOp ].name );
+		} else if ( *pCode ) {
+			FS_Printf( hFile, "\t%s\n", pCode );
+		}
+	}
+
+	FS_Printf( hFile, "}\n\n" );
+}
+
+static void AOT_WriteString( fileHandle_t hFile, const char *pString )
+{
+	FS_Printf( hFile, "\"" );
+	for ( ; *pString; pString++ ) {
+		if ( *pString == '"' || *pString == '\\' ) {
+			FS_Printf( hFile, "\\%c", *pString );
+		} else {
+			FS_Printf( hFile, "%c", *pString );
+		}
+	}
+	FS_Printf( hFile, "\"" );
+}
+
+static void AOT_AddFunction( UtlVector<asIScriptFunction *>& functions, asIScriptFunction *pFunction )
+{
+	if ( !pFunction || pFunction->GetFuncType() != asFUNC_SCRIPT ) {
+		return;
+	}
+	if ( eastl::find( functions.begin(), functions.end(), pFunction ) != functions.end() ) {
+		return;
+	}
+	functions.push_back( pFunction );
+}
+
+/*
+* ML_AOTGenerate_f: writes the C++ translation of every function in the module bytecode to Cache/asaot.cpp,
+* built into Cache/asaot(.so/.dll) it gets picked up on the next start as long as the bytecode cache matches
+*/
+void ML_AOTGenerate_f( void )
+{
+	asIScriptModule *pModule;
+	asITypeInfo *pType;
+	UtlVector<asIScriptFunction *> functions;
+	aotFunction_t func;
+	fileHandle_t hFile;
+	uint32_t nWritten, i, j;
+	uint64_t nInstructions, nTranslated;
+	const asDWORD *pOp;
+	asUINT nOffset;
+	const char *pPath;
+
+	if ( !g_pModuleLib || !g_pModuleLib->GetScriptModule() ) {
+		Con_Printf( "ml.aot_generate: no modules loaded\n" );
+		return;
+	}
+	pModule = g_pModuleLib->GetScriptModule();
+
+	for ( i = 0; i < pModule->GetFunctionCount(); i++ ) {
+		AOT_AddFunction( functions, pModule->GetFunctionByIndex( i ) );
+	}
+	for ( i = 0; i < pModule->GetObjectTypeCount(); i++ ) {
+		pType = pModule->GetObjectTypeByIndex( i );
+		for ( j = 0; j < pType->GetMethodCount(); j++ ) {
+			AOT_AddFunction( functions, pType->GetMethodByIndex( j, false ) );
+		}
+		for ( j = 0; j < pType->GetBehaviourCount(); j++ ) {
+			AOT_AddFunction( functions, pType->GetBehaviourByIndex( j, NULL ) );
+		}
+		for ( j = 0; j < pType->GetFactoryCount(); j++ ) {
+			AOT_AddFunction( functions, pType->GetFactoryByIndex( j ) );
+		}
+	}
+
+	pPath = CACHE_DIR "/" MODULE_AOT_SOURCE;
+	hFile = FS_FOpenWrite( pPath );
+	if ( hFile == FS_INVALID_HANDLE ) {
+		Con_Printf( COLOR_RED "ml.aot_generate: couldn't open '%s' for writing\n", pPath );
+		return;
+	}
+
+	FS_Printf( hFile, "// generated by ml.aot_generate from the module bytecode, don't edit\n" );
+	FS_Printf( hFile, "// build it into " CACHE_DIR "/" MODULE_AOT_LIBRARY DLL_EXT " with the same defines and include paths as the engine\n\n" );
+	FS_Printf( hFile, "#include \"module_lib/module_aot.h\"\n\n" );
+
+	nWritten = 0;
+	nInstructions = 0;
+	nTranslated = 0;
+	for ( i = 0; i < functions.size(); i++ ) {
+		if ( !AOT_AnalyzeFunction( &func, functions[i] ) ) {
+			continue;
+		}
+		for ( nOffset = 0; nOffset < func.nLength; nOffset += AOT_InstructionSize( pOp ) ) {
+			pOp = func.pCode + nOffset;
+			if ( AOT_IsSupported( (asEBCInstr)*(const asBYTE *)pOp ) ) {
+				nTranslated++;
+			}
+			nInstructions++;
+		}
+		AOT_WriteFunction( hFile, &func, i );
+		AOT_FreeFunction( &func );
+		nWritten++;
+	}
+
+	FS_Printf( hFile, "static const moduleAOTFunction_t s_Functions[] = {\n" );
+	for ( i = 0; i < functions.size(); i++ ) {
+		if ( !AOT_AnalyzeFunction( &func, functions[i] ) ) {
+			continue;
+		}
+		FS_Printf( hFile, "\t{ " );
+		AOT_WriteString( hFile, functions[i]->GetDeclaration( true, true, true ) );
+		FS_Printf( hFile, ", 0x%016llxull, AOT_Function%u },\n", (unsigned long long)func.nHash, i );
+		AOT_FreeFunction( &func );
+	}
+	if ( !nWritten ) {
+		FS_Printf( hFile, "\t{ NULL, 0, NULL }\n" );
+	}
+	FS_Printf( hFile, "};\n\n" );
+
+	FS_Printf( hFile, "static const moduleAOTTable_t s_Table = {\n" );
+	FS_Printf( hFile, "\t%i,\n", MODULE_AOT_VERSION );
+	FS_Printf( hFile, "\t0x%016llxull,\n", (unsigned long long)g_pModuleLib->GetCodeChecksum() );
+	FS_Printf( hFile, "\t%i, %i, %i,\n", _NOMAD_VERSION_MAJOR, _NOMAD_VERSION_UPDATE, _NOMAD_VERSION_PATCH );
+	FS_Printf( hFile, "\t%u,\n", nWritten );
+	FS_Printf( hFile, "\ts_Functions\n" );
+	FS_Printf( hFile, "};\n\n" );
+
+	FS_Printf( hFile, "MODULE_AOT_EXPORT const moduleAOTTable_t *" MODULE_AOT_SYMBOL "( void ) {\n" );
+	FS_Printf( hFile, "\treturn &s_Table;\n" );
+	FS_Printf( hFile, "}\n" );
+
+	FS_FClose( hFile );
+
+	Con_Printf( "ml.aot_generate: wrote %u of %lu functions to '%s', %lu of %lu instructions run natively\n", nWritten,
+		(uint64_t)functions.size(), pPath, nTranslated, nInstructions );
+}
+
+//
+// CModuleAOTCompiler
+//
+
+CModuleAOTCompiler::CModuleAOTCompiler( const moduleAOTTable_t *pTable, asIJITCompiler *pFallback )
+	: m_pTable( pTable ), m_pFallback( pFallback ), m_nCompiled( 0 ), m_nFallbacks( 0 )
+{
+	uint32_t i;
+
+	for ( i = 0; i < pTable->nFunctions; i++ ) {
+		m_Functions[ pTable->pFunctions[i].nHash ] = &pTable->pFunctions[i];
+	}
+}
+
+CModuleAOTCompiler::~CModuleAOTCompiler()
+{
+}
+
+int CModuleAOTCompiler::CompileFunction( asIScriptFunction *pFunction, asJITFunction *pOutput )
+{
+	aotFunction_t func;
+	asUINT nOffset;
+
+	*pOutput = NULL;
+
+	if ( AOT_AnalyzeFunction( &func, pFunction ) ) {
+		const auto it = m_Functions.find( func.nHash );
+
+		if ( it != m_Functions.end() && N_streq( it->second->pDecl, pFunction->GetDeclaration( true, true, true ) ) ) {
+			// the generated code finds the start of the function from the entry it was called at
+			for ( nOffset = 0; nOffset < func.nLength; nOffset++ ) {
+				if ( func.pLabels[ nOffset ] & AOT_LABEL_ENTRY ) {
+					asBC_PTRARG( (asDWORD *)func.pCode + nOffset ) = nOffset + 1;
+				}
+			}
+			AOT_FreeFunction( &func );
+
+			*pOutput = it->second->pFunc;
+			m_nCompiled++;
+			return asSUCCESS;
+		}
+		AOT_FreeFunction( &func );
+	}
+
+	// changed since the library was generated or nothing to translate
+	m_nFallbacks++;
+	if ( m_pFallback ) {
+		return m_pFallback->CompileFunction( pFunction, pOutput );
+	}
+	return asNOT_SUPPORTED;
+}
+
+void CModuleAOTCompiler::ReleaseJITFunction( asJITFunction pFunc )
+{
+	uint32_t i;
+
+	// the native code lives in the library, only the jit's own code needs releasing
+	for ( i = 0; i < m_pTable->nFunctions; i++ ) {
+		if ( m_pTable->pFunctions[i].pFunc == pFunc ) {
+			return;
+		}
+	}
+	if ( m_pFallback ) {
+		m_pFallback->ReleaseJITFunction( pFunc );
+	}
+}
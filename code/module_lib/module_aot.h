@@ -0,0 +1,100 @@
+#ifndef __MODULE_AOT__
+#define __MODULE_AOT__
+
+#pragma once
+
+//
+// ahead-of-time compiled module code: ml.aot_generate translates the bytecode of every script function
+// into C++ that runs on angelscript's jit interface, that source gets built into Cache/asaot(.so/.dll) and
+// CModuleAOTCompiler hands the native functions to the engine when the library matches the bytecode cache.
+//
+// this header is included by the generated source as well, so it must only depend on angelscript.h
+//
+
+#include "angelscript/angelscript.h"
+#include <string.h>
+#include <math.h>
+
+// bump whenever the generated code or the table layout changes
+#define MODULE_AOT_VERSION 1
+
+#define MODULE_AOT_LIBRARY "asaot"
+#define MODULE_AOT_SOURCE "asaot.cpp"
+#define MODULE_AOT_SYMBOL "ML_GetModuleAOT"
+
+typedef struct {
+	const char *pDecl;
+	uint64_t nHash; // code hash of the function the C++ was generated from, see AOT_AnalyzeFunction
+	asJITFunction pFunc;
+} moduleAOTFunction_t;
+
+typedef struct {
+	uint32_t nVersion;
+	uint64_t nChecksum; // bytecode cache checksum the library was generated against
+	uint32_t nGameVersionMajor;
+	uint32_t nGameVersionUpdate;
+	uint32_t nGameVersionPatch;
+	uint32_t nFunctions;
+	const moduleAOTFunction_t *pFunctions;
+} moduleAOTTable_t;
+
+typedef const moduleAOTTable_t *(*GetModuleAOT_t)( void );
+
+#if defined( _WIN32 )
+	#define MODULE_AOT_EXPORT extern "C" __declspec( dllexport )
+#else
+	#define MODULE_AOT_EXPORT extern "C" __attribute__( ( visibility( "default" ) ) )
+#endif
+
+//
+// helpers for the generated code, everything goes through memcpy so the C++ compiler is free
+// to keep values in registers without tripping over the stack's type punning
+//
+
+template<typename T>
+inline T AOT_Load( const void *pAddress ) {
+	T value;
+	memcpy( &value, pAddress, sizeof( value ) );
+	return value;
+}
+
+template<typename T>
+inline void AOT_Store( void *pAddress, T value ) {
+	memcpy( pAddress, &value, sizeof( value ) );
+}
+
+template<typename T>
+inline int AOT_Compare( T a, T b ) {
+	return a == b ? 0 : ( a < b ? -1 : 1 );
+}
+
+inline float AOT_Float( asDWORD nBits ) {
+	return AOT_Load<float>( &nBits );
+}
+
+#define AOT_GET( type, var ) AOT_Load<type>( l_fp - ( var ) )
+#define AOT_SET( type, var, value ) AOT_Store<type>( l_fp - ( var ), (type)( value ) )
+#define AOT_GETR( type ) AOT_Load<type>( &l_value )
+#define AOT_SETR( type, value ) AOT_Store<type>( &l_value, (type)( value ) )
+#define AOT_PTRARG( offset ) AOT_Load<asPWORD>( l_bc + ( offset ) + 1 )
+#define AOT_DWORDARG( offset, index ) AOT_Load<asDWORD>( l_bc + ( offset ) + ( index ) )
+
+// nEntry is the offset of the JitEntry instruction we're resuming at plus one
+#define AOT_BEGIN() \
+	asDWORD *l_bc = pRegs->programPointer - ( nEntry - 1 ); \
+	asDWORD *l_sp = pRegs->stackPointer; \
+	asDWORD *l_fp = pRegs->stackFramePointer; \
+	asQWORD l_value = pRegs->valueRegister; \
+	(void)l_bc; (void)l_sp; (void)l_fp
+
+// hand the instruction at offset back to the vm
+#define AOT_EXIT( offset ) \
+	do { \
+		pRegs->programPointer = l_bc + ( offset ); \
+		pRegs->stackPointer = l_sp; \
+		pRegs->stackFramePointer = l_fp; \
+		pRegs->valueRegister = l_value; \
+		return; \
+	} while ( 0 )
+
+#endif
@@ -0,0 +1,258 @@
+// module_binding_bench.cpp -- measures the cost of calling into the engine from a module with each calling convention
+
+#include "module_public.h"
+#include "module_bindings.h"
+#include "angelscript/as_scriptfunction.h"
+#include "angelscript/as_callfunc.h"
+
+extern void Module_ASMessage_f( const asSMessageInfo *pMsg, void *param );
+
+class CBindingBenchObject
+{
+public:
+	int Next( int nAmount ) {
+		m_nValue += nAmount;
+		return m_nValue;
+	}
+
+	int m_nValue;
+};
+
+static CBindingBenchObject s_BenchObject;
+
+static void BindingBench_Void( void ) {
+}
+static int BindingBench_Add( int a, int b ) {
+	return a + b;
+}
+static float BindingBench_Mad( float a, float b, float c ) {
+	return a * b + c;
+}
+static uint64_t BindingBench_QWord( uint64_t a ) {
+	return a + 1;
+}
+static int BindingBench_Ref( const int *pIn, int *pOut ) {
+	*pOut = *pIn;
+	return *pIn;
+}
+static void BindingBench_Ray( const float& start, float& end, uint32_t& nEntity, uint32_t nOwner, uint32_t nOwner2,
+	float length, float angle, float speed, uint32_t flags )
+{
+	end = start + length * angle * speed;
+	nEntity = nOwner + nOwner2 + flags;
+}
+
+typedef enum {
+	BINDING_GENERIC,
+	BINDING_CDECL,
+	BINDING_THISCALL,
+
+	NUM_BINDING_STYLES
+} bindingStyle_t;
+
+static const char *bindingStyleNames[ NUM_BINDING_STYLES ] = {
+	"generic",
+	"cdecl",
+	"thiscall"
+};
+
+typedef struct {
+	const char *name;
+	const char *decl; // %s is replaced with the binding style
+	const char *call;
+	asSFuncPtr generic;
+	asSFuncPtr native;
+} bindingBench_t;
+
+static bindingStyle_t BindingBench_Style( internalCallConv callConv )
+{
+	switch ( callConv ) {
+	case ICC_GENERIC_FUNC:
+	case ICC_GENERIC_FUNC_RETURNINMEM:
+	case ICC_GENERIC_METHOD:
+	case ICC_GENERIC_METHOD_RETURNINMEM:
+		return BINDING_GENERIC;
+	case ICC_THISCALL:
+	case ICC_THISCALL_RETURNINMEM:
+	case ICC_VIRTUAL_THISCALL:
+	case ICC_VIRTUAL_THISCALL_RETURNINMEM:
+		return BINDING_THISCALL;
+	default:
+		break;
+	};
+	return BINDING_CDECL;
+}
+
+/*
+* BindingBench_Run: returns the time in microseconds a script loop of nCalls took,
+* pResult gets whatever the loop accumulated so each binding style can be checked against the others
+*/
+static uint64_t BindingBench_Run( asIScriptContext *pContext, asIScriptModule *pModule, const char *pFuncName, uint32_t nCalls,
+	int *pResult )
+{
+	asIScriptFunction *pFunc;
+	uint64_t start;
+	int retn;
+
+	pFunc = pModule->GetFunctionByName( pFuncName );
+	if ( !pFunc ) {
+		N_Error( ERR_DROP, "BindingBench_Run: couldn't find function '%s'", pFuncName );
+	}
+
+	CheckASCall( pContext->Prepare( pFunc ) );
+	CheckASCall( pContext->SetArgDWord( 0, nCalls ) );
+
+	s_BenchObject.m_nValue = 0;
+
+	start = ML_Microseconds();
+	retn = pContext->Execute();
+	if ( retn != asEXECUTION_FINISHED ) {
+		N_Error( ERR_DROP, "BindingBench_Run: '%s' didn't finish -- %s", pFuncName, AS_PrintErrorString( retn ) );
+	}
+	start = ML_Microseconds() - start;
+
+	*pResult = (int)pContext->GetReturnDWord();
+
+	return start;
+}
+
+static double BindingBench_CallsPerSecond( uint64_t time, uint64_t emptyTime, uint32_t nCalls )
+{
+	// just in case the empty loop is slower than the call because of timer noise
+	if ( time <= emptyTime ) {
+		return 0.0f;
+	}
+	return (double)nCalls / ( (double)( time - emptyTime ) * 1e-6 );
+}
+
+/*
+* ML_BindingBench_f: lists the calling convention of every global the engine exposes to modules,
+* then runs the same set of engine calls through a scratch script engine with each binding style
+* as a loop of ml.binding_bench [calls] iterations
+*/
+void ML_BindingBench_f( void )
+{
+	static char source[ 8192 ];
+	asIScriptEngine *pEngine;
+	asIScriptContext *pContext;
+	asIScriptModule *pModule;
+	const asCScriptFunction *pFunc;
+	uint32_t nCalls, nGlobals, i;
+	uint32_t nStyles[ NUM_BINDING_STYLES ];
+	bindingStyle_t style;
+	uint64_t emptyTime, genericTime, nativeTime;
+	int genericResult, nativeResult;
+	double genericRate, nativeRate;
+	qboolean bNative;
+
+	nCalls = 1000000;
+	if ( Cmd_Argc() > 1 ) {
+		nCalls = MAX( 1, atoi( Cmd_Argv( 1 ) ) );
+	}
+
+	// angelscript only has a native call path on some platforms, the generic one is always there
+#if defined( __x86_64__ ) || defined( _M_X64 )
+	bNative = qtrue;
+#else
+	bNative = qfalse;
+#endif
+
+	if ( g_pModuleLib && g_pModuleLib->GetScriptEngine() ) {
+		nGlobals = g_pModuleLib->GetScriptEngine()->GetGlobalFunctionCount();
+		memset( nStyles, 0, sizeof( nStyles ) );
+		for ( i = 0; i < nGlobals; i++ ) {
+			pFunc = (const asCScriptFunction *)g_pModuleLib->GetScriptEngine()->GetGlobalFunctionByIndex( i );
+			if ( !pFunc->sysFuncIntf ) {
+				continue;
+			}
+			style = BindingBench_Style( pFunc->sysFuncIntf->callConv );
+			nStyles[ style ]++;
+			if ( Cmd_Argc() > 2 && !N_stricmp( Cmd_Argv( 2 ), "-v" ) ) {
+				Con_Printf( "%-8s %s\n", bindingStyleNames[ style ], pFunc->GetDeclaration( true, true ) );
+			}
+		}
+		Con_Printf( "%u registered globals: %u cdecl, %u thiscall, %u generic\n", nGlobals, nStyles[ BINDING_CDECL ],
+			nStyles[ BINDING_THISCALL ], nStyles[ BINDING_GENERIC ] );
+	}
+
+	const bindingBench_t benches[] = {
+		{ "void()", "void Void_%s()", "Void_%s();",
+			GENERIC_FUNCTION( BindingBench_Void ), asFUNCTION( BindingBench_Void ) },
+		{ "int(int,int)", "int Add_%s( int, int )", "s += Add_%s( i, 1 );",
+			GENERIC_FUNCTION( BindingBench_Add ), asFUNCTION( BindingBench_Add ) },
+		{ "float(float,float,float)", "float Mad_%s( float, float, float )", "f = Mad_%s( f, 0.5f, 1.0f );",
+			GENERIC_FUNCTION( BindingBench_Mad ), asFUNCTION( BindingBench_Mad ) },
+		{ "uint64(uint64)", "uint64 QWord_%s( uint64 )", "q = QWord_%s( q );",
+			GENERIC_FUNCTION( BindingBench_QWord ), asFUNCTION( BindingBench_QWord ) },
+		{ "int(const int&in,int&out)", "int Ref_%s( const int& in, int& out )", "s += Ref_%s( i, o );",
+			GENERIC_FUNCTION( BindingBench_Ref ), asFUNCTION( BindingBench_Ref ) },
+		{ "CastRay(9 args)", "void Ray_%s( const float& in, float& out, uint& out, uint, uint, float, float, float, uint )",
+			"Ray_%s( f, f, o, 1, 2, 0.5f, 1.0f, 2.0f, 3 );",
+			GENERIC_FUNCTION( BindingBench_Ray ), asFUNCTION( BindingBench_Ray ) },
+		{ "BenchObject::Next(int)", NULL, "s += bench.Next_%s( 1 );",
+			GENERIC_METHOD_PR( CBindingBenchObject, Next, ( int ), int ), asMETHODPR( CBindingBenchObject, Next, ( int ), int ) },
+	};
+	const uint32_t nBenches = arraylen( benches );
+
+	pEngine = asCreateScriptEngine();
+	if ( !pEngine ) {
+		N_Error( ERR_DROP, "ML_BindingBench_f: failed to create an AngelScript Engine context" );
+	}
+	CheckASCall( pEngine->SetMessageCallback( asFUNCTION( Module_ASMessage_f ), NULL, asCALL_CDECL ) );
+
+	CheckASCall( pEngine->RegisterObjectType( "BenchObject", 0, asOBJ_REF | asOBJ_NOCOUNT ) );
+	CheckASCall( pEngine->RegisterObjectMethod( "BenchObject", "int Next_Generic( int )", benches[ nBenches - 1 ].generic,
+		asCALL_GENERIC ) );
+	if ( bNative ) {
+		CheckASCall( pEngine->RegisterObjectMethod( "BenchObject", "int Next_Native( int )", benches[ nBenches - 1 ].native,
+			asCALL_THISCALL ) );
+	}
+	CheckASCall( pEngine->RegisterGlobalProperty( "BenchObject bench", &s_BenchObject ) );
+
+	N_strncpyz( source, "int Run_Empty( int n ) { int s = 0; for ( int i = 0; i < n; i++ ) { s += i; } return s; }\n",
+		sizeof( source ) );
+	for ( i = 0; i < nBenches; i++ ) {
+		if ( benches[i].decl ) {
+			CheckASCall( pEngine->RegisterGlobalFunction( va( benches[i].decl, "Generic" ), benches[i].generic, asCALL_GENERIC ) );
+			if ( bNative ) {
+				CheckASCall( pEngine->RegisterGlobalFunction( va( benches[i].decl, "Native" ), benches[i].native, asCALL_CDECL ) );
+			}
+		}
+		N_strcat( source, sizeof( source ), va( "int Run_%u_Generic( int n ) { int s = 0, o = 0; float f = 0; uint64 q = 0;"
+			" for ( int i = 0; i < n; i++ ) { %s } return s + o + int( f ) + int( q ); }\n", i, va( benches[i].call, "Generic" ) ) );
+		if ( bNative ) {
+			N_strcat( source, sizeof( source ), va( "int Run_%u_Native( int n ) { int s = 0, o = 0; float f = 0; uint64 q = 0;"
+				" for ( int i = 0; i < n; i++ ) { %s } return s + o + int( f ) + int( q ); }\n", i, va( benches[i].call, "Native" ) ) );
+		}
+	}
+
+	pModule = pEngine->GetModule( "BindingBench", asGM_ALWAYS_CREATE );
+	CheckASCall( pModule->AddScriptSection( "BindingBench", source ) );
+	CheckASCall( pModule->Build() );
+
+	pContext = pEngine->CreateContext();
+
+	emptyTime = BindingBench_Run( pContext, pModule, "Run_Empty", nCalls, &genericResult );
+
+	Con_Printf( "ml.binding_bench: %u calls per binding (empty loop %lu usec)\n", nCalls, emptyTime );
+	Con_Printf( "%-28s %16s %16s %8s\n", "signature", "generic/sec", "native/sec", "speedup" );
+	for ( i = 0; i < nBenches; i++ ) {
+		genericTime = BindingBench_Run( pContext, pModule, va( "Run_%u_Generic", i ), nCalls, &genericResult );
+		genericRate = BindingBench_CallsPerSecond( genericTime, emptyTime, nCalls );
+		if ( !bNative ) {
+			Con_Printf( "%-28s %16.0f %16s %8s\n", benches[i].name, genericRate, "n/a", "n/a" );
+			continue;
+		}
+		nativeTime = BindingBench_Run( pContext, pModule, va( "Run_%u_Native", i ), nCalls, &nativeResult );
+		nativeRate = BindingBench_CallsPerSecond( nativeTime, emptyTime, nCalls );
+		Con_Printf( "%-28s %16.0f %16.0f %7.2fx\n", benches[i].name, genericRate, nativeRate,
+			genericRate > 0.0f ? nativeRate / genericRate : 0.0f );
+		if ( genericResult != nativeResult ) {
+			Con_Printf( COLOR_YELLOW "WARNING: %s returned %i through the generic binding and %i through the native one\n",
+				benches[i].name, genericResult, nativeResult );
+		}
+	}
+
+	pContext->Release();
+	pEngine->ShutDownAndRelease();
+}
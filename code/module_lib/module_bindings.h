@@ -0,0 +1,112 @@
+#ifndef __MODULE_BINDINGS_H__
+#define __MODULE_BINDINGS_H__
+
+#pragma once
+
+#include "angelscript/angelscript.h"
+#include "aswrappedcall.h"
+#include <utility>
+#include <new>
+
+//
+// engine api bindings: BIND_FUNCTION/BIND_METHOD_PR generate an asIScriptGeneric wrapper for the
+// function at compile time, so angelscript calls it directly instead of going through its native
+// call path (which copies every argument into a buffer and calls through an asm thunk). On x86-64 a
+// build with MODULE_NATIVE_CALLS defined registers the same bindings with asCALL_CDECL/asCALL_THISCALL
+// instead, ml.binding_bench measures both
+//
+
+#if defined( MODULE_NATIVE_CALLS ) && !( defined( __x86_64__ ) || defined( _M_X64 ) )
+	#undef MODULE_NATIVE_CALLS
+#endif
+
+namespace ModuleBindings {
+	template<typename T>
+	struct CArg {
+		static T Get( asIScriptGeneric *pGeneric, asUINT nArg ) {
+			return static_cast<gw::Proxy<T> *>( pGeneric->GetAddressOfArg( nArg ) )->value;
+		}
+	};
+
+	template<typename T>
+	struct CFunction;
+
+	template<typename R, typename... Args>
+	struct CFunction<R (*)( Args... )> {
+		template<R (*Fn)( Args... ), size_t... I>
+		static void Call( asIScriptGeneric *pGeneric, std::index_sequence<I...> ) {
+			if constexpr ( std::is_void<R>::value ) {
+				Fn( CArg<Args>::Get( pGeneric, I )... );
+			} else {
+				new ( pGeneric->GetAddressOfReturnLocation() ) gw::Proxy<R>( Fn( CArg<Args>::Get( pGeneric, I )... ) );
+			}
+		}
+	};
+
+	template<typename C, typename R, typename... Args>
+	struct CFunction<R (C::*)( Args... )> {
+		template<R (C::*Fn)( Args... ), size_t... I>
+		static void Call( asIScriptGeneric *pGeneric, std::index_sequence<I...> ) {
+			C *pObject = static_cast<C *>( pGeneric->GetObjectData() );
+			if constexpr ( std::is_void<R>::value ) {
+				( pObject->*Fn )( CArg<Args>::Get( pGeneric, I )... );
+			} else {
+				new ( pGeneric->GetAddressOfReturnLocation() ) gw::Proxy<R>( ( pObject->*Fn )( CArg<Args>::Get( pGeneric, I )... ) );
+			}
+		}
+	};
+
+	template<typename C, typename R, typename... Args>
+	struct CFunction<R (C::*)( Args... ) const> {
+		template<R (C::*Fn)( Args... ) const, size_t... I>
+		static void Call( asIScriptGeneric *pGeneric, std::index_sequence<I...> ) {
+			const C *pObject = static_cast<const C *>( pGeneric->GetObjectData() );
+			if constexpr ( std::is_void<R>::value ) {
+				( pObject->*Fn )( CArg<Args>::Get( pGeneric, I )... );
+			} else {
+				new ( pGeneric->GetAddressOfReturnLocation() ) gw::Proxy<R>( ( pObject->*Fn )( CArg<Args>::Get( pGeneric, I )... ) );
+			}
+		}
+	};
+
+	template<typename T>
+	struct CArgCount;
+	template<typename R, typename... Args>
+	struct CArgCount<R (*)( Args... )> { static constexpr size_t value = sizeof...( Args ); };
+	template<typename C, typename R, typename... Args>
+	struct CArgCount<R (C::*)( Args... )> { static constexpr size_t value = sizeof...( Args ); };
+	template<typename C, typename R, typename... Args>
+	struct CArgCount<R (C::*)( Args... ) const> { static constexpr size_t value = sizeof...( Args ); };
+
+	template<auto Fn>
+	void Generic( asIScriptGeneric *pGeneric ) {
+		CFunction<decltype( Fn )>::template Call<Fn>( pGeneric, std::make_index_sequence<CArgCount<decltype( Fn )>::value>() );
+	}
+};
+
+#define GENERIC_FUNCTION( name ) asFUNCTION( ( ModuleBindings::Generic<name> ) )
+#define GENERIC_FUNCTION_PR( name, params, returnType ) asFUNCTION( ( ModuleBindings::Generic<static_cast<returnType (*)params>( name )> ) )
+#define GENERIC_METHOD_PR( classType, name, params, returnType ) \
+	asFUNCTION( ( ModuleBindings::Generic<static_cast<returnType (classType::*)params>( &classType::name )> ) )
+
+#ifdef MODULE_NATIVE_CALLS
+	#define BIND_FUNCTION( name ) asFUNCTION( name )
+	#define BIND_FUNCTION_PR( name, params, returnType ) asFUNCTIONPR( name, params, returnType )
+	#define BIND_METHOD_PR( classType, name, params, returnType ) asMETHODPR( classType, name, params, returnType )
+	#define BIND_CALL_CDECL asCALL_CDECL
+	#define BIND_CALL_THISCALL asCALL_THISCALL
+#else
+	#define BIND_FUNCTION( name ) GENERIC_FUNCTION( name )
+	#define BIND_FUNCTION_PR( name, params, returnType ) GENERIC_FUNCTION_PR( name, params, returnType )
+	#define BIND_METHOD_PR( classType, name, params, returnType ) GENERIC_METHOD_PR( classType, name, params, returnType )
+	#define BIND_CALL_CDECL asCALL_GENERIC
+	#define BIND_CALL_THISCALL asCALL_GENERIC
+#endif
+
+// calls/second of every binding style angelscript can use for the engine api
+void ML_BindingBench_f( void );
+
+// compares CastRays on a script array<RayCast> with RayCast::Cast(), lives in module_funcdef_game.cpp
+void ML_RayCastCheck_f( void );
+
+#endif
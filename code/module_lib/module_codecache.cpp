@@ -0,0 +1,347 @@
+// module_codecache.cpp -- content hashes of the module sources and the engine api for the bytecode cache
+
+#include "module_public.h"
+#include "module_handle.h"
+#include "../game/g_game.h"
+
+/*
+* the bytecode cache is keyed by a hash of everything that goes into building it: the contents of every file in
+* every module directory and every declaration the engine registers. Each module gets its own hash so we can
+* tell which ones changed, but they all live in the one GlobalModule so any change still rebuilds every module
+* (see the FIXME in the CModuleLib constructor). The files are read and hashed on a few worker threads since
+* that's most of the time a cold start spends before it knows whether it has to recompile.
+*/
+
+#define MODULE_HASH_MAX_WORKERS 8
+
+typedef struct {
+	char szPath[ MAX_NPATH ];
+	uint32_t nModule;
+	uint64_t nHash;
+	uint64_t nSize;
+} moduleCacheFile_t;
+
+typedef struct {
+	moduleCacheFile_t *pFiles;
+	uint32_t nFiles;
+	SDL_atomic_t nNext;
+} moduleHashJob_t;
+
+uint64_t ML_HashBytes( uint64_t nHash, const void *pData, uint64_t nBytes )
+{
+	const byte *p = (const byte *)pData;
+	uint64_t i;
+
+	for ( i = 0; i < nBytes; i++ ) {
+		nHash ^= p[i];
+		nHash *= ML_HASH_PRIME;
+	}
+	return nHash;
+}
+
+static uint64_t ML_HashString( uint64_t nHash, const char *pString )
+{
+	// include the terminator so "ab" + "c" doesn't hash the same as "a" + "bc"
+	return ML_HashBytes( nHash, pString, strlen( pString ) + 1 );
+}
+
+static void ML_ListModuleFiles( UtlVector<moduleCacheFile_t>& files, uint32_t nModule, const char *pDirectory )
+{
+	char **fileList;
+	uint64_t nFiles, i;
+	moduleCacheFile_t file;
+
+	memset( &file, 0, sizeof( file ) );
+	file.nModule = nModule;
+
+	fileList = FS_ListFiles( pDirectory, "/", &nFiles );
+	for ( i = 0; i < nFiles; i++ ) {
+		if ( *fileList[i] == '.' ) {
+			continue;
+		}
+		if ( fileList[i][ strlen( fileList[i] ) - 1 ] != '/' ) {
+			Com_snprintf( file.szPath, sizeof( file.szPath ), "%s%s/", pDirectory, fileList[i] );
+		} else {
+			Com_snprintf( file.szPath, sizeof( file.szPath ), "%s%s", pDirectory, fileList[i] );
+		}
+		ML_ListModuleFiles( files, nModule, file.szPath );
+	}
+	FS_FreeFileList( fileList );
+
+	fileList = FS_ListFiles( pDirectory, ".as", &nFiles );
+	for ( i = 0; i < nFiles; i++ ) {
+		Com_snprintf( file.szPath, sizeof( file.szPath ), "%s%s", pDirectory, fileList[i] );
+		files.push_back( file );
+	}
+	FS_FreeFileList( fileList );
+}
+
+/*
+* ML_HashFile: runs on the worker threads, the file system calls lock on their own
+*/
+static void ML_HashFile( moduleCacheFile_t *pFile, byte **pBuffer, uint64_t *nBufferSize )
+{
+	fileHandle_t hFile;
+	uint64_t nLength;
+
+	pFile->nHash = ML_HashString( ML_HASH_INIT, pFile->szPath );
+	pFile->nSize = 0;
+
+	nLength = FS_FOpenFileRead( pFile->szPath, &hFile );
+	if ( hFile == FS_INVALID_HANDLE ) {
+		// deleted since we listed it, the path alone still counts as a change
+		return;
+	}
+	if ( nLength > *nBufferSize ) {
+		free( *pBuffer );
+		*pBuffer = (byte *)malloc( nLength );
+		*nBufferSize = *pBuffer ? nLength : 0;
+	}
+	if ( *pBuffer && FS_Read( *pBuffer, nLength, hFile ) == nLength ) {
+		pFile->nHash = ML_HashBytes( pFile->nHash, *pBuffer, nLength );
+		pFile->nSize = nLength;
+	}
+	FS_FClose( hFile );
+}
+
+static int SDLCALL ML_HashWorker( void *pData )
+{
+	moduleHashJob_t *pJob = (moduleHashJob_t *)pData;
+	byte *pBuffer;
+	uint64_t nBufferSize;
+	int nIndex;
+
+	pBuffer = NULL;
+	nBufferSize = 0;
+	while ( ( nIndex = SDL_AtomicAdd( &pJob->nNext, 1 ) ) < (int)pJob->nFiles ) {
+		ML_HashFile( &pJob->pFiles[ nIndex ], &pBuffer, &nBufferSize );
+	}
+	free( pBuffer );
+
+	return 0;
+}
+
+/*
+* ML_HashEngineAPI: anything the engine registers changing makes the bytecode invalid even when the
+* scripts didn't change
+*/
+static uint64_t ML_HashEngineAPI( asIScriptEngine *pEngine )
+{
+	asITypeInfo *pType;
+	const char *pName, *pNamespace;
+	int nTypeId, nValue;
+	bool bConst;
+	asUINT i, j;
+	uint64_t nHash;
+
+	nHash = ML_HashString( ML_HASH_INIT, ANGELSCRIPT_VERSION_STRING );
+
+	for ( i = 0; i < pEngine->GetObjectTypeCount(); i++ ) {
+		pType = pEngine->GetObjectTypeByIndex( i );
+		nHash = ML_HashString( nHash, pType->GetName() );
+		nHash = ML_HashString( nHash, va( "%u %lu", pType->GetSize(), (uint64_t)pType->GetFlags() ) );
+		for ( j = 0; j < pType->GetBehaviourCount(); j++ ) {
+			nHash = ML_HashString( nHash, pType->GetBehaviourByIndex( j, NULL )->GetDeclaration( true, true, true ) );
+		}
+		for ( j = 0; j < pType->GetFactoryCount(); j++ ) {
+			nHash = ML_HashString( nHash, pType->GetFactoryByIndex( j )->GetDeclaration( true, true, true ) );
+		}
+		for ( j = 0; j < pType->GetMethodCount(); j++ ) {
+			nHash = ML_HashString( nHash, pType->GetMethodByIndex( j, false )->GetDeclaration( true, true, true ) );
+		}
+		for ( j = 0; j < pType->GetPropertyCount(); j++ ) {
+			nHash = ML_HashString( nHash, pType->GetPropertyDeclaration( j, true ) );
+		}
+	}
+	for ( i = 0; i < pEngine->GetGlobalFunctionCount(); i++ ) {
+		nHash = ML_HashString( nHash, pEngine->GetGlobalFunctionByIndex( i )->GetDeclaration( true, true, true ) );
+	}
+	for ( i = 0; i < pEngine->GetGlobalPropertyCount(); i++ ) {
+		pEngine->GetGlobalPropertyByIndex( i, &pName, &pNamespace, &nTypeId, &bConst );
+		nHash = ML_HashString( nHash, va( "%s%s %s::%s", bConst ? "const " : "", pEngine->GetTypeDeclaration( nTypeId, true ),
+			pNamespace, pName ) );
+	}
+	for ( i = 0; i < pEngine->GetEnumCount(); i++ ) {
+		pType = pEngine->GetEnumByIndex( i );
+		nHash = ML_HashString( nHash, pType->GetName() );
+		for ( j = 0; j < pType->GetEnumValueCount(); j++ ) {
+			pName = pType->GetEnumValueByIndex( j, &nValue );
+			nHash = ML_HashString( nHash, pName );
+			nHash = ML_HashBytes( nHash, &nValue, sizeof( nValue ) );
+		}
+	}
+	for ( i = 0; i < pEngine->GetFuncdefCount(); i++ ) {
+		nHash = ML_HashString( nHash, pEngine->GetFuncdefByIndex( i )->GetFuncdefSignature()->GetDeclaration( true, true, true ) );
+	}
+	for ( i = 0; i < pEngine->GetTypedefCount(); i++ ) {
+		pType = pEngine->GetTypedefByIndex( i );
+		nHash = ML_HashString( nHash, va( "%s %i", pType->GetName(), pType->GetTypedefTypeId() ) );
+	}
+
+	return nHash;
+}
+
+/*
+* CModuleLib::HashModules: hashes every module into pModuleHashes (m_nModuleCount of them) and the engine api into
+* pApiHash, returns the total the bytecode cache is keyed by
+*/
+uint64_t CModuleLib::HashModules( qboolean bParallel, uint64_t *pModuleHashes, uint64_t *pApiHash )
+{
+	UtlVector<moduleCacheFile_t> files;
+	moduleCacheFile_t file;
+	moduleHashJob_t job;
+	SDL_Thread *pWorkers[ MODULE_HASH_MAX_WORKERS ];
+	uint32_t nWorkers, i;
+	uint64_t start, nHash;
+
+	start = ML_Microseconds();
+
+	// the listing has to happen here, FS_FreeFileList doesn't lock
+	memset( &file, 0, sizeof( file ) );
+	for ( i = 0; i < m_nModuleCount; i++ ) {
+		file.nModule = i;
+		Com_snprintf( file.szPath, sizeof( file.szPath ), "%smodule.json", m_pLoadList[i].m_pHandle->GetModulePath() );
+		files.push_back( file );
+		ML_ListModuleFiles( files, i, m_pLoadList[i].m_pHandle->GetModulePath() );
+	}
+
+	memset( &job, 0, sizeof( job ) );
+	job.pFiles = files.data();
+	job.nFiles = files.size();
+
+	nWorkers = 0;
+	if ( bParallel ) {
+		nWorkers = MIN( MIN( (uint32_t)SDL_GetCPUCount(), (uint32_t)MODULE_HASH_MAX_WORKERS ), job.nFiles );
+		for ( i = 0; i < nWorkers; i++ ) {
+			pWorkers[i] = SDL_CreateThread( ML_HashWorker, "ModuleHash", &job );
+			if ( !pWorkers[i] ) {
+				break;
+			}
+		}
+		nWorkers = i;
+	}
+
+	// the api has nothing to do with the file system, so it gets done while the workers read
+	*pApiHash = ML_HashEngineAPI( m_pEngine );
+
+	// whatever the workers didn't get to (all of it without any)
+	ML_HashWorker( &job );
+	for ( i = 0; i < nWorkers; i++ ) {
+		SDL_WaitThread( pWorkers[i], NULL );
+	}
+
+	for ( i = 0; i < m_nModuleCount; i++ ) {
+		pModuleHashes[i] = ML_HashString( ML_HASH_INIT, m_pLoadList[i].m_szId );
+	}
+	m_nHashedBytes = 0;
+	for ( i = 0; i < job.nFiles; i++ ) {
+		pModuleHashes[ job.pFiles[i].nModule ] = ML_HashBytes( pModuleHashes[ job.pFiles[i].nModule ], &job.pFiles[i].nHash,
+			sizeof( job.pFiles[i].nHash ) );
+		m_nHashedBytes += job.pFiles[i].nSize;
+	}
+	m_nHashedFiles = job.nFiles;
+
+	nHash = *pApiHash;
+	for ( i = 0; i < m_nModuleCount; i++ ) {
+		nHash = ML_HashBytes( nHash, &pModuleHashes[i], sizeof( pModuleHashes[i] ) );
+	}
+
+	m_nHashTime = ML_Microseconds() - start;
+
+	return nHash;
+}
+
+/*
+* CModuleLib::PrintChangedModules: lists what changed since the bytecode cache was written, the whole
+* GlobalModule gets rebuilt either way but it saves digging through the scripts for why
+*/
+void CModuleLib::PrintChangedModules( void ) const
+{
+	const asCodeCacheModule_t *pCached;
+	uint64_t i, j, k;
+	qboolean *pChanged;
+
+	if ( !m_pCacheData || !m_pModuleHashes ) {
+		return;
+	}
+
+	if ( m_pCacheData->apiHash != m_nApiHash ) {
+		Con_Printf( COLOR_MAGENTA "...engine api changed, every module needs a rebuild\n" );
+		return;
+	}
+
+	pChanged = (qboolean *)Hunk_AllocateTempMemory( sizeof( *pChanged ) * MAX( 1, m_nModuleCount ) );
+	for ( i = 0; i < m_nModuleCount; i++ ) {
+		pChanged[i] = qtrue;
+		for ( j = 0; j < m_pCacheData->modCount; j++ ) {
+			pCached = &m_pCacheData->modList[j];
+			if ( !N_stricmp( pCached->name, m_pLoadList[i].m_szId ) ) {
+				pChanged[i] = (qboolean)( pCached->hash != m_pModuleHashes[i] );
+				break;
+			}
+		}
+		if ( pChanged[i] ) {
+			Con_Printf( COLOR_MAGENTA "...module '%s' changed\n", m_pLoadList[i].m_szId );
+		}
+	}
+	for ( i = 0; i < m_nModuleCount; i++ ) {
+		if ( pChanged[i] ) {
+			continue;
+		}
+		for ( j = 0; j < m_pLoadList[i].m_nDependencies; j++ ) {
+			for ( k = 0; k < m_nModuleCount; k++ ) {
+				if ( pChanged[k] && N_streq( m_pLoadList[i].m_pDependencies[j].c_str(), m_pLoadList[k].m_szName ) ) {
+					Con_Printf( COLOR_MAGENTA "...module '%s' depends on '%s'\n", m_pLoadList[i].m_szId, m_pLoadList[k].m_szId );
+				}
+			}
+		}
+	}
+	Hunk_FreeTempMemory( pChanged );
+}
+
+/*
+* ML_CodeCacheBench_f: times what a cold start spends deciding whether the bytecode cache is usable,
+* with the file hashing on one thread and spread over the workers
+*/
+void ML_CodeCacheBench_f( void )
+{
+	uint32_t nIterations, i;
+	uint64_t serialTime, parallelTime, nHash, nApiHash;
+	uint64_t *pModuleHashes;
+
+	if ( !g_pModuleLib || !g_pModuleLib->GetScriptEngine() ) {
+		Con_Printf( "ml.cache_bench: module library isn't loaded\n" );
+		return;
+	}
+
+	nIterations = 4;
+	if ( Cmd_Argc() > 1 ) {
+		nIterations = MAX( 1, atoi( Cmd_Argv( 1 ) ) );
+	}
+
+	pModuleHashes = (uint64_t *)Hunk_AllocateTempMemory( sizeof( *pModuleHashes ) * MAX( 1, g_pModuleLib->GetModCount() ) );
+
+	nHash = 0;
+	serialTime = 0;
+	parallelTime = 0;
+	for ( i = 0; i < nIterations; i++ ) {
+		g_pModuleLib->HashModules( qfalse, pModuleHashes, &nApiHash );
+		serialTime += g_pModuleLib->GetHashTime();
+		nHash = g_pModuleLib->HashModules( qtrue, pModuleHashes, &nApiHash );
+		parallelTime += g_pModuleLib->GetHashTime();
+	}
+
+	Hunk_FreeTempMemory( pModuleHashes );
+
+	Con_Printf( "ml.cache_bench: %lu modules, %u files, %lu KiB, %i CPUs\n", g_pModuleLib->GetModCount(),
+		g_pModuleLib->GetHashedFiles(), g_pModuleLib->GetHashedBytes() / 1024, SDL_GetCPUCount() );
+	Con_Printf( "%-24s %10.2f msec\n", "hash, one thread", (double)serialTime / nIterations / 1000.0f );
+	Con_Printf( "%-24s %10.2f msec\n", "hash, worker threads", (double)parallelTime / nIterations / 1000.0f );
+	Con_Printf( "%-24s %10.2f msec (%s)\n", "startup, cache check", (double)g_pModuleLib->GetStartupHashTime() / 1000.0f,
+		g_pModuleLib->IsCodeCached() ? "up to date" : "rebuilt" );
+	Con_Printf( "%-24s %10.2f msec\n", g_pModuleLib->IsCodeCached() ? "startup, bytecode load" : "startup, compile",
+		(double)g_pModuleLib->GetStartupBuildTime() / 1000.0f );
+	if ( nHash != g_pModuleLib->GetCodeChecksum() ) {
+		Con_Printf( COLOR_YELLOW "module sources changed since startup, restart to rebuild them\n" );
+	}
+}
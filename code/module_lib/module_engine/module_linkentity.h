@@ -31,6 +31,7 @@ public:
 	uint32_t m_nEntityId;
 	uint32_t m_nEntityType;
 	uint32_t m_nEntityNumber;
+	uint32_t m_nFlags;
 
 	qboolean m_bLinked;
 	
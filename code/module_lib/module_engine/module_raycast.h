@@ -8,19 +8,30 @@
 class CModuleRayCast
 {
 public:
-    CModuleRayCast( void ) = default;
+    CModuleRayCast( void );
     ~CModuleRayCast() = default;
 
     CModuleRayCast& operator=( const CModuleRayCast& ) = default;
 
+    void Cast( void );
+
+    // casts towards the given point instead of along length and angle
+    void Cast( const glm::vec3& end );
+
+    // internal
+    void ToRay( ray_t *ray ) const;
+    void FromRay( const ray_t *ray );
+
     glm::vec3 start;
 	glm::vec3 end;
 	glm::vec3 origin;
     uint32_t entityNumber;
-//	float speed;
+    uint32_t ownerNumber;
+    uint32_t ownerNumber2;
+	float speed;
 	float length;
 	float angle;
     uint32_t flags; // unused for now
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -25,6 +25,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 #include <glm/gtc/type_ptr.hpp>
 #include <limits.h>
 #include "aswrappedcall.h"
+#include "module_bindings.h"
 #include "imgui_stdlib.h"
 #include "../ui/ui_lib.h"
 #include "module_stringfactory.hpp"
@@ -72,6 +73,12 @@ void ScriptLib_Register_Renderer( void );
 #define REGISTER_GLOBAL_FUNCTION( decl, funcPtr ) \
 	ValidateFunction( __func__, decl,\
 		g_pModuleLib->GetScriptEngine()->RegisterGlobalFunction( decl, funcPtr, asCALL_GENERIC ) )
+#define REGISTER_ENGINE_FUNCTION( decl, name ) \
+	ValidateFunction( __func__, decl,\
+		g_pModuleLib->GetScriptEngine()->RegisterGlobalFunction( decl, BIND_FUNCTION( name ), BIND_CALL_CDECL ) )
+#define REGISTER_ENGINE_FUNCTION_PR( decl, name, parameters, returnType ) \
+	ValidateFunction( __func__, decl,\
+		g_pModuleLib->GetScriptEngine()->RegisterGlobalFunction( decl, BIND_FUNCTION_PR( name, parameters, returnType ), BIND_CALL_CDECL ) )
 #define REGISTER_OBJECT_TYPE( name, obj, traits ) \
 	ValidateObjectType( __func__, name, g_pModuleLib->GetScriptEngine()->RegisterObjectType( name, sizeof(obj), traits | asGetTypeTraits<obj>() ) )
 #define REGISTER_OBJECT_PROPERTY( obj, var, offset ) \
@@ -820,8 +827,8 @@ static void KeyGetKey( asIScriptGeneric *pGeneric ) {
 	pGeneric->SetReturnDWord( Key_GetKey( ( (const string_t *)pGeneric->GetArgObject( 0 ) )->c_str() ) );
 }
 
-static void SysMilliseconds( asIScriptGeneric *pGeneric ) {
-	pGeneric->SetReturnQWord( Sys_Milliseconds() );
+static uint64_t SysMilliseconds( void ) {
+	return Sys_Milliseconds();
 }
 
 static void ScriptPolyQuad_Construct( asIScriptGeneric *pGeneric ) {
@@ -1854,7 +1861,9 @@ static void RegisterGameObject( asIScriptGeneric *pGeneric ) {
 */
 
 static void DebugPrint( asIScriptGeneric *pGeneric ) {
-	if ( !Cvar_VariableInteger( "sgame_DebugMode" ) ) {
+	static CvarHandle<bool> sgame_DebugMode( "sgame_DebugMode" );
+
+	if ( !sgame_DebugMode.Get() ) {
 		return;
 	}
 
@@ -2367,8 +2376,7 @@ void ModuleLib_Register_Engine( void )
 	{ // ImGui
 		#undef REGISTER_GLOBAL_FUNCTION
 		#define REGISTER_GLOBAL_FUNCTION( decl, funcPtr, params, returnType ) \
-			ValidateFunction( __func__, decl,\
-				g_pModuleLib->GetScriptEngine()->RegisterGlobalFunction( decl, WRAP_FN_PR( funcPtr, params, returnType ), asCALL_GENERIC ) )
+			REGISTER_ENGINE_FUNCTION_PR( decl, funcPtr, params, returnType )
 		
 		RESET_NAMESPACE();
 
@@ -2429,7 +2437,10 @@ void ModuleLib_Register_Engine( void )
 
 		SET_NAMESPACE( "ImGui" );
 
-		REGISTER_GLOBAL_FUNCTION( "bool ImGui::Begin( const string& in, ref@ = null, ImGuiWindowFlags = ImGuiWindowFlags::None )", ImGui_Begin, ( const string_t *, bool *, ImGuiWindowFlags ), bool );
+		// ref@ doesn't map onto a native bool *, so this one always goes through the generic wrapper
+		ValidateFunction( __func__, "ImGui::Begin", g_pModuleLib->GetScriptEngine()->RegisterGlobalFunction(
+			"bool ImGui::Begin( const string& in, ref@ = null, ImGuiWindowFlags = ImGuiWindowFlags::None )",
+			WRAP_FN_PR( ImGui_Begin, ( const string_t *, bool *, ImGuiWindowFlags ), bool ), asCALL_GENERIC ) );
 		REGISTER_GLOBAL_FUNCTION( "void ImGui::End()", ImGui_End, ( void ), void );
 		REGISTER_GLOBAL_FUNCTION( "void ImGui::SetWindowSize( const vec2& in )", ImGui_SetWindowSize, ( const vec2 * ), void );
 		REGISTER_GLOBAL_FUNCTION( "void ImGui::SetWindowPos( const vec2& in )", ImGui_SetWindowPos, ( const vec2 * ), void );
@@ -2526,7 +2537,7 @@ void ModuleLib_Register_Engine( void )
 		ScriptLib_Register_Engine();
 
 		SET_NAMESPACE( "TheNomad::Engine::System" );
-		REGISTER_GLOBAL_FUNCTION( "uint64 TheNomad::Engine::System::Milliseconds()", asFUNCTION( SysMilliseconds ) );
+		REGISTER_ENGINE_FUNCTION( "uint64 TheNomad::Engine::System::Milliseconds()", SysMilliseconds );
 		SET_NAMESPACE( "TheNomad::Engine" );
 
 		REGISTER_OBJECT_TYPE( "Timer", CTimer, asOBJ_VALUE );
@@ -2742,19 +2753,19 @@ void ModuleLib_Register_Engine( void )
 
 		REGISTER_GLOBAL_FUNCTION( "void TheNomad::Util::LoadFunction( const string& in moduleName, const string& in funcName, ?&in )",
 			asFUNCTION( LoadModuleFunction ) );
-		REGISTER_GLOBAL_FUNCTION( "void TheNomad::Util::GetModuleList( array<string>& out )", WRAP_FN( GetModuleList ) );
-		REGISTER_GLOBAL_FUNCTION( "bool TheNomad::Util::IsModuleActive( const string& in )", WRAP_FN( IsModuleActive ) );
-
-		REGISTER_GLOBAL_FUNCTION( "int TheNomad::Util::StrICmp( const string& in, const string& in )", WRAP_FN( StrICmp ) );
-		REGISTER_GLOBAL_FUNCTION( "int TheNomad::Util::StrCmp( const string& in, const string& in )", WRAP_FN( StrCmp ) );
-		REGISTER_GLOBAL_FUNCTION( "int TheNomad::Util::StrICmpn( const string& in, const string& in, uint )", WRAP_FN( StrICmpn ) );
-		REGISTER_GLOBAL_FUNCTION( "int TheNomad::Util::StrCmpn( const string& in, const string& in, uint )", WRAP_FN( StrCmpn ) );
-		REGISTER_GLOBAL_FUNCTION( "int TheNomad::Util::StringToInt( const string& in )", WRAP_FN( StringToInt ) );
-		REGISTER_GLOBAL_FUNCTION( "uint TheNomad::Util::StringToUInt( const string& in )", WRAP_FN( StringToUInt ) );
-		REGISTER_GLOBAL_FUNCTION( "float TheNomad::Util::StringToFloat( const string& in )", WRAP_FN( StringToFloat ) );
-		REGISTER_GLOBAL_FUNCTION( "int TheNomad::Util::StringToInt( const int8[]& in )", WRAP_FN( StringBufferToInt ) );
-		REGISTER_GLOBAL_FUNCTION( "uint TheNomad::Util::StringToUInt( const int8[]& in )", WRAP_FN( StringBufferToUInt ) );
-		REGISTER_GLOBAL_FUNCTION( "float TheNomad::Util::StringToFloat( const int8[]& in )", WRAP_FN( StringBufferToFloat ) );
+		REGISTER_ENGINE_FUNCTION( "void TheNomad::Util::GetModuleList( array<string>& out )", GetModuleList );
+		REGISTER_ENGINE_FUNCTION( "bool TheNomad::Util::IsModuleActive( const string& in )", IsModuleActive );
+
+		REGISTER_ENGINE_FUNCTION( "int TheNomad::Util::StrICmp( const string& in, const string& in )", StrICmp );
+		REGISTER_ENGINE_FUNCTION( "int TheNomad::Util::StrCmp( const string& in, const string& in )", StrCmp );
+		REGISTER_ENGINE_FUNCTION( "int TheNomad::Util::StrICmpn( const string& in, const string& in, uint )", StrICmpn );
+		REGISTER_ENGINE_FUNCTION( "int TheNomad::Util::StrCmpn( const string& in, const string& in, uint )", StrCmpn );
+		REGISTER_ENGINE_FUNCTION( "int TheNomad::Util::StringToInt( const string& in )", StringToInt );
+		REGISTER_ENGINE_FUNCTION( "uint TheNomad::Util::StringToUInt( const string& in )", StringToUInt );
+		REGISTER_ENGINE_FUNCTION( "float TheNomad::Util::StringToFloat( const string& in )", StringToFloat );
+		REGISTER_ENGINE_FUNCTION( "int TheNomad::Util::StringToInt( const int8[]& in )", StringBufferToInt );
+		REGISTER_ENGINE_FUNCTION( "uint TheNomad::Util::StringToUInt( const int8[]& in )", StringBufferToUInt );
+		REGISTER_ENGINE_FUNCTION( "float TheNomad::Util::StringToFloat( const int8[]& in )", StringBufferToFloat );
 		g_pModuleLib->GetScriptEngine()->RegisterGlobalFunction(
 			"float TheNomad::Util::Distance( const vec2& in, const vec2& in )", WRAP_FN_PR( disBetweenOBJ, ( const vec2&, const vec2& ), float ), asCALL_GENERIC );
 		g_pModuleLib->GetScriptEngine()->RegisterGlobalFunction(
@@ -2769,9 +2780,9 @@ void ModuleLib_Register_Engine( void )
 			"bool TheNomad::Util::AddScriptSectionToModule( const string& in, const string& in )", asFUNCTION( AddScriptSectionToModule ), asCALL_GENERIC );
 		g_pModuleLib->GetScriptEngine()->RegisterGlobalFunction(
 			"bool TheNomad::Util::LoadFunctionFromSection( const string& in, const string& in, const string& in, ?& out )", asFUNCTION( LoadFunctionFromSection ), asCALL_GENERIC );
-		REGISTER_GLOBAL_FUNCTION( "bool TheNomad::Util::BoundsIntersect( const TheNomad::GameSystem::BBox& in, const TheNomad::GameSystem::BBox& in )", WRAP_FN_PR( BoundsIntersect, ( const CModuleBoundBox *, const CModuleBoundBox * ), bool ) );
-		REGISTER_GLOBAL_FUNCTION( "bool TheNomad::Util::BoundsIntersectPoint( const TheNomad::GameSystem::BBox& in, const vec3& in )", WRAP_FN_PR( BoundsIntersectPoint, ( const CModuleBoundBox *, const vec3 * ), bool ) );
-		REGISTER_GLOBAL_FUNCTION( "bool TheNomad::Util::BoundsIntersectSphere( const TheNomad::GameSystem::BBox& in, const vec3& in, float )", WRAP_FN_PR( BoundsIntersectSphere, ( const CModuleBoundBox *, const vec3 *, float ), bool ) );
+		REGISTER_ENGINE_FUNCTION_PR( "bool TheNomad::Util::BoundsIntersect( const TheNomad::GameSystem::BBox& in, const TheNomad::GameSystem::BBox& in )", BoundsIntersect, ( const CModuleBoundBox *, const CModuleBoundBox * ), bool );
+		REGISTER_ENGINE_FUNCTION_PR( "bool TheNomad::Util::BoundsIntersectPoint( const TheNomad::GameSystem::BBox& in, const vec3& in )", BoundsIntersectPoint, ( const CModuleBoundBox *, const vec3 * ), bool );
+		REGISTER_ENGINE_FUNCTION_PR( "bool TheNomad::Util::BoundsIntersectSphere( const TheNomad::GameSystem::BBox& in, const vec3& in, float )", BoundsIntersectSphere, ( const CModuleBoundBox *, const vec3 *, float ), bool );
 
 		CheckASCall( g_pModuleLib->GetScriptEngine()->RegisterInterface( "ScriptClass" ) );
 		REGISTER_GLOBAL_FUNCTION( "TheNomad::Util::ScriptClass@ TheNomad::Util::AllocateExternalScriptClass( const string& in nameSpace, const string& in name )",
@@ -2783,9 +2794,9 @@ void ModuleLib_Register_Engine( void )
 	// misc & global funcdefs
 	//
 	
-	REGISTER_GLOBAL_FUNCTION( "void ConsolePrint( const string& in )", WRAP_FN( ConsolePrint ) );
-	REGISTER_GLOBAL_FUNCTION( "void ConsoleWarning( const string& in )", WRAP_FN( ConsoleWarning ) );
-	REGISTER_GLOBAL_FUNCTION( "void GameError( const string& in )", WRAP_FN( GameError ) );
+	REGISTER_ENGINE_FUNCTION( "void ConsolePrint( const string& in )", ConsolePrint );
+	REGISTER_ENGINE_FUNCTION( "void ConsoleWarning( const string& in )", ConsoleWarning );
+	REGISTER_ENGINE_FUNCTION( "void GameError( const string& in )", GameError );
 
 	//    SET_NAMESPACE( "TheNomad::Constants" );
 	{ // Constants
@@ -4,6 +4,7 @@
 #pragma once
 
 #include "module_public.h"
+#include "module_aot.h"
 
 template<typename Key, typename T>
 using UtlMultimap = eastl::multimap<Key, T, eastl::less<Key>, CModuleAllocator>;
@@ -56,4 +57,32 @@ public:
 	void finalizePages( void );
 };
 
+//
+// CModuleAOTCompiler: hands out the functions of an ahead-of-time compiled library (see module_aot.h),
+// anything that changed since the library was generated goes to the fallback jit if there is one
+//
+class CModuleAOTCompiler : public asIJITCompiler {
+public:
+	CModuleAOTCompiler( const moduleAOTTable_t *pTable, asIJITCompiler *pFallback );
+	~CModuleAOTCompiler();
+
+	int CompileFunction( asIScriptFunction *pFunction, asJITFunction *pOutput );
+	void ReleaseJITFunction( asJITFunction pFunc );
+
+	uint32_t GetCompiledCount( void ) const {
+		return m_nCompiled;
+	}
+	uint32_t GetFallbackCount( void ) const {
+		return m_nFallbacks;
+	}
+private:
+	UtlHashMap<uint64_t, const moduleAOTFunction_t *> m_Functions;
+	const moduleAOTTable_t *m_pTable;
+	asIJITCompiler *m_pFallback;
+	uint32_t m_nCompiled;
+	uint32_t m_nFallbacks;
+};
+
+void ML_AOTGenerate_f( void );
+
 #endif
\ No newline at end of file
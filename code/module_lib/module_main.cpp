@@ -15,6 +15,8 @@
 #include "scriptlib/scriptdictionary.h"
 #include "scriptlib/scriptany.h"
 #include "angelscript/as_thread.h"
+#include "module_bindings.h"
+#include <EASTL/chrono.h>
 
 moduleImport_t moduleImport;
 
@@ -24,7 +26,15 @@ cvar_t *ml_angelScript_DebugPrint;
 cvar_t *ml_debugMode;
 cvar_t *ml_alwaysCompile;
 cvar_t *ml_allowJIT;
+cvar_t *ml_allowAOT;
 cvar_t *ml_garbageCollectionIterations;
+cvar_t *ml_gcBudgetUsec;
+cvar_t *ml_gcFullCycleObjects;
+
+uint64_t ML_Microseconds( void ) {
+	return (uint64_t)eastl::chrono::duration_cast<eastl::chrono::microseconds>(
+		eastl::chrono::steady_clock::now().time_since_epoch() ).count();
+}
 
 static void ML_CleanCache_f( void ) {
 	const char *path;
@@ -56,9 +66,59 @@ static void ML_GarbageCollectionStats_f( void ) {
 	Con_Printf( "Total Detected: %u\n", totalDetected );
 	Con_Printf( "New Objects: %u\n", newObjects );
 	Con_Printf( "Total New Destroyed: %u\n", totalNewDestroyed );
+	Con_Printf( "Last Frame: %lu usec\n", g_pModuleLib->GetGCFrameTime() );
+	Con_Printf( "Full Cycles: %u\n", g_pModuleLib->GetGCFullCycles() );
 	Con_Printf( "--------------------\n" );
 }
 
+/*
+* ML_DispatchBench_f: times the same cheap module call with the old garbage collection
+* behaviour (a full cycle before every dispatch) against the per-frame collector
+*/
+static void ML_DispatchBench_f( void ) {
+	CModuleInfo *pModule;
+	uint64_t nCalls, i;
+	uint64_t start, legacyTime, frameTime, gcTime;
+
+	if ( !sgvm ) {
+		Con_Printf( "ml.dispatch_bench: no sgame module loaded\n" );
+		return;
+	}
+	pModule = sgvm;
+
+	nCalls = 10000;
+	if ( Cmd_Argc() > 1 ) {
+		nCalls = MAX( 1, atoi( Cmd_Argv( 1 ) ) );
+	}
+
+	// OnConsoleCommand doesn't recognize "ml.dispatch_bench", so it's about the cheapest
+	// proc that every module implements
+	start = ML_Microseconds();
+	for ( i = 0; i < nCalls; i++ ) {
+		g_pModuleLib->GetScriptEngine()->GarbageCollect( asGC_DETECT_GARBAGE | asGC_DESTROY_GARBAGE | asGC_FULL_CYCLE,
+			(uint32_t)ml_garbageCollectionIterations->i );
+		pModule->m_pHandle->CallFunc( ModuleCommandLine, 0, NULL );
+		g_pModuleLib->GetScriptEngine()->GarbageCollect( asGC_DETECT_GARBAGE, 1 );
+	}
+	legacyTime = ML_Microseconds() - start;
+
+	start = ML_Microseconds();
+	for ( i = 0; i < nCalls; i++ ) {
+		pModule->m_pHandle->CallFunc( ModuleCommandLine, 0, NULL );
+	}
+	frameTime = ML_Microseconds() - start;
+
+	start = ML_Microseconds();
+	g_pModuleLib->RunGarbageCollector();
+	gcTime = ML_Microseconds() - start;
+
+	Con_Printf( "ml.dispatch_bench: %lu calls into \"%s\"\n", nCalls, pModule->m_szName );
+	Con_Printf( "  gc per call: %8.3f usec/call (%lu usec total)\n",
+		(double)legacyTime / nCalls, legacyTime );
+	Con_Printf( "  gc per frame: %8.3f usec/call (%lu usec total, %lu usec collecting)\n",
+		(double)( frameTime + gcTime ) / nCalls, frameTime + gcTime, gcTime );
+}
+
 const char *AS_PrintErrorString( int code )
 {
 	switch ( code ) {
@@ -246,10 +306,9 @@ void CModuleLib::LoadModule( const char *pModule )
 void CModuleLib::RunModules( EModuleFuncId nCallId, uint32_t nArgs, ... )
 {
 	va_list argptr;
-	uint64_t j;
+	uint64_t j, start;
 	uint32_t i;
 	int *args;
-	CTimer time;
 
 	if ( !m_pContext || !m_pEngine ) {
 		return;
@@ -266,10 +325,8 @@ void CModuleLib::RunModules( EModuleFuncId nCallId, uint32_t nArgs, ... )
 	}
 	va_end( argptr );
 
-	time.Start();
-	g_pModuleLib->GetScriptEngine()->GarbageCollect( asGC_DETECT_GARBAGE | asGC_DESTROY_GARBAGE | asGC_FULL_CYCLE,
-		(uint32_t)ml_garbageCollectionIterations->i );
-	time.Stop();
+	start = ML_Microseconds();
+	m_nCallDepth++;
 
 	for ( j = 0; j < m_nModuleCount; j++ ) {
 		if ( sgvm == &m_pLoadList[j] ) {
@@ -280,6 +337,58 @@ void CModuleLib::RunModules( EModuleFuncId nCallId, uint32_t nArgs, ... )
 				m_pLoadList[i].m_szName, funcDefs[ nCallId ].name );
 		}
 	}
+
+	// calls made from inside a script are already being timed by the outer one
+	if ( --m_nCallDepth == 0 ) {
+		m_nScriptTime += ML_Microseconds() - start;
+	}
+}
+
+/*
+* CModuleLib::RunGarbageCollector: called once per frame instead of before every module call,
+* steps through the collector until ml_gcBudgetUsec runs out and only falls back to a full
+* cycle when the number of live objects has grown past ml_gcFullCycleObjects
+*/
+void CModuleLib::RunGarbageCollector( void )
+{
+	asUINT currentSize;
+	uint64_t start, budget;
+	int retn;
+
+	PROFILE_FUNCTION();
+
+	if ( !m_pEngine ) {
+		return;
+	}
+
+	start = ML_Microseconds();
+
+	// nothing is running at this point, so a call that was dropped out of can't leave the depth stuck
+	m_nCallDepth = 0;
+
+	m_pEngine->GetGCStatistics( &currentSize );
+	if ( currentSize < m_nGCBaseSize ) {
+		m_nGCBaseSize = currentSize;
+	}
+	if ( currentSize - m_nGCBaseSize >= (asUINT)ml_gcFullCycleObjects->i ) {
+		m_pEngine->GarbageCollect( asGC_DETECT_GARBAGE | asGC_DESTROY_GARBAGE | asGC_FULL_CYCLE,
+			(uint32_t)ml_garbageCollectionIterations->i );
+		m_pEngine->GetGCStatistics( &m_nGCBaseSize );
+		m_nGCFullCycles++;
+	} else {
+		// always do at least one step so that a zero budget can't stall the collector
+		budget = (uint64_t)ml_gcBudgetUsec->i;
+		do {
+			retn = m_pEngine->GarbageCollect( asGC_DETECT_GARBAGE | asGC_DESTROY_GARBAGE | asGC_ONE_STEP,
+				(uint32_t)ml_garbageCollectionIterations->i );
+		} while ( retn == 1 && ML_Microseconds() - start < budget );
+	}
+
+	m_nGCFrameTime = ML_Microseconds() - start;
+	m_pEngine->GetGCStatistics( &m_nGCObjects );
+
+	PROFILE_VALUE( "gcFrameTime", m_nGCFrameTime );
+	PROFILE_VALUE( "gcObjects", m_nGCObjects );
 }
 
 int CModuleLib::ModuleCall( CModuleInfo *pModule, EModuleFuncId nCallId, uint32_t nArgs, ... )
@@ -287,8 +396,9 @@ int CModuleLib::ModuleCall( CModuleInfo *pModule, EModuleFuncId nCallId, uint32_
 	va_list argptr;
 	uint32_t i;
 	int *args;
+	int retn;
+	uint64_t start;
 	const char *name;
-	CTimer time;
 
 	if ( !m_pContext || !m_pEngine ) {
 		return 0;
@@ -310,12 +420,16 @@ int CModuleLib::ModuleCall( CModuleInfo *pModule, EModuleFuncId nCallId, uint32_
 
 	name = funcDefs[ nCallId ].name;
 
-	time.Start();
-	g_pModuleLib->GetScriptEngine()->GarbageCollect( asGC_DETECT_GARBAGE | asGC_DESTROY_GARBAGE | asGC_FULL_CYCLE,
-		(uint32_t)ml_garbageCollectionIterations->i );
-	time.Stop();
+	start = ML_Microseconds();
+	m_nCallDepth++;
+
+	retn = pModule->m_pHandle->CallFunc( nCallId, nArgs, args );
 
-	return pModule->m_pHandle->CallFunc( nCallId, nArgs, args );
+	if ( --m_nCallDepth == 0 ) {
+		m_nScriptTime += ML_Microseconds() - start;
+	}
+
+	return retn;
 }
 
 void Module_ASMessage_f( const asSMessageInfo *pMsg, void *param )
@@ -432,91 +546,36 @@ bool CModuleLib::AddDefaultProcs( void ) const {
 
 #define AS_CACHE_CODE_IDENT (('C'<<24)+('B'<<16)+('S'<<8)+'A')
 
-static fileTime_t ModuleLib_GetDirectoryChecksum( const char *dir )
-{
-	char **fileList, **dirList;
-	uint64_t numFiles, numDirs;
-	uint64_t i;
-	fileStats_t stats;
-	fileTime_t total;
-	char szDirectory[ MAX_OSPATH ];
-	char szPath[ MAX_OSPATH*2+1 ];
-
-	total = 0;
-
-	memset( szDirectory, 0, sizeof( szDirectory ) );
-
-	if ( !N_stristr( dir, "gamedata" ) ) {
-		snprintf( szDirectory, sizeof( szDirectory ) - 1, "gamedata/%s", dir );
-	} else {
-		N_strncpyz( szDirectory, dir, sizeof( szDirectory ) );
-	}
-
-	dirList = FS_ListFiles( szDirectory, "/", &numDirs );
-	for ( i = 0; i < numDirs; i++ ) {
-		if ( *dirList[i] == '.' || ( *dirList[i] == '.' && *( dirList[i]+1 ) == '.' ) ) {
-			continue;
-		}
-		if ( dirList[i][ strlen( dirList[i] ) - 1 ] != '/' ) {
-			snprintf( szPath, sizeof( szPath ) - 1, "%s%s/", szDirectory, dirList[i] );
-		} else {
-			snprintf( szPath, sizeof( szPath ) - 1, "%s%s", szDirectory, dirList[i] );
-		}
-		total += ModuleLib_GetDirectoryChecksum( szPath );
-		Con_Printf( "..fetched checksum of directory '%s'\n", szPath );
-	}
-	FS_FreeFileList( dirList );
-
-	fileList = FS_ListFiles( szDirectory, ".as", &numFiles );
-	for ( i = 0; i < numFiles; i++ ) {
-		if ( szDirectory[ strlen( szDirectory ) - 1 ] != '/' ) {
-			snprintf( szPath, sizeof( szPath ) - 1, "%s/%s", szDirectory, fileList[i] );
-		} else {
-			snprintf( szPath, sizeof( szPath ) - 1, "%s%s", szDirectory, fileList[i] );
-		}
-		if ( !Sys_GetFileStats( &stats, szPath ) ) {
-			N_Error( ERR_DROP, "ModuleLib_GetDirectoryChecksum: couldn't get filestats for '%s'", szPath );
-		}
-		total += stats.mtime;
-	}
-	FS_FreeFileList( fileList );
-
-	return total;
-}
-
 void CModuleLib::SaveByteCodeCache( void )
 {
 	int ret;
 	asCodeCacheHeader_t *header;
 	CModuleCacheHandle dataStream( va( CACHE_DIR "/ascodecache.dat" ), FS_OPEN_WRITE );
-	byte *pByteCode;
 	uint64_t nLength;
-	fileHandle_t hFile;
 	uint64_t i;
-	char *ptr;
 
 	const CModuleInfo *pModule = GetModule( "nomadmain" );
 
-	header = (asCodeCacheHeader_t *)Hunk_AllocateTempMemory( sizeof( *header ) + ( MAX_NPATH * m_nModuleCount ) );
+	nLength = sizeof( *header ) + ( sizeof( *header->modList ) * m_nModuleCount );
+	header = (asCodeCacheHeader_t *)Hunk_AllocateTempMemory( nLength );
+	memset( header, 0, nLength );
 	header->hasDebugSymbols = ml_debugMode->i;
 	header->gameVersion.m_nVersionMajor = _NOMAD_VERSION_MAJOR;
 	header->gameVersion.m_nVersionUpdate = _NOMAD_VERSION_UPDATE;
 	header->gameVersion.m_nVersionPatch = _NOMAD_VERSION_PATCH;
 	header->ident = AS_CACHE_CODE_IDENT;
+	header->version = AS_CACHE_CODE_VERSION;
 	header->moduleVersionMajor = pModule->m_nModVersionMajor;
 	header->moduleVersionUpdate = pModule->m_nModVersionUpdate;
 	header->moduleVersionPatch = pModule->m_nModVersionPatch;
 	header->modCount = m_nModuleCount;
-	header->checksum = 0;
-	for ( i = 0; i < m_nModuleCount; i++ ) {
-		header->checksum += ModuleLib_GetDirectoryChecksum( m_pModList[i].info->m_pHandle->GetModulePath() );
-	}
-	Con_Printf( "Total module checksum is %lu\n", header->checksum );
-	
-	ptr = header->modList;
+	header->checksum = m_nCodeHash;
+	header->apiHash = m_nApiHash;
+	Con_Printf( "Total module checksum is %016lx\n", header->checksum );
+
 	for ( i = 0; i < m_nModuleCount; i++ ) {
-		memcpy( ptr, m_pModList[ i ].info->m_szId, MAX_NPATH );
-		ptr += MAX_NPATH;
+		N_strncpyz( header->modList[i].name, m_pLoadList[i].m_szId, sizeof( header->modList[i].name ) );
+		header->modList[i].hash = m_pModuleHashes[i];
 	}
 
 	ret = m_pModule->SaveByteCode( &dataStream, header->hasDebugSymbols );
@@ -525,18 +584,49 @@ void CModuleLib::SaveByteCodeCache( void )
 	}
 	FS_FClose( dataStream.m_hFile );
 
+	FS_WriteFile( va( CACHE_DIR "/asmetadata.bin" ), header, nLength );
+
 	Hunk_FreeTempMemory( header );
+}
+
+/*
+* CModuleLib::LoadAOT: swaps the jit out for the ahead-of-time compiled library if there is one and it was
+* generated from the bytecode we're about to load
+*/
+void CModuleLib::LoadAOT( void )
+{
+	GetModuleAOT_t GetModuleAOT;
+	const moduleAOTTable_t *pTable;
+
+	if ( !ml_allowAOT->i ) {
+		return;
+	}
+
+	m_pAOTLibrary = FS_LoadLibrary( CACHE_DIR "/" MODULE_AOT_LIBRARY DLL_EXT );
+	if ( !m_pAOTLibrary ) {
+		return;
+	}
+
+	GetModuleAOT = (GetModuleAOT_t)Sys_GetProcAddress( m_pAOTLibrary, MODULE_AOT_SYMBOL );
+	pTable = GetModuleAOT ? GetModuleAOT() : NULL;
+	if ( !pTable || pTable->nVersion != MODULE_AOT_VERSION || pTable->nChecksum != m_pCacheData->checksum
+		|| pTable->nGameVersionMajor != _NOMAD_VERSION_MAJOR || pTable->nGameVersionUpdate != _NOMAD_VERSION_UPDATE
+		|| pTable->nGameVersionPatch != _NOMAD_VERSION_PATCH )
+	{
+		Con_Printf( COLOR_YELLOW "WARNING: " CACHE_DIR "/" MODULE_AOT_LIBRARY DLL_EXT " is out of date, run ml.aot_generate and rebuild it\n" );
+		Sys_CloseDLL( m_pAOTLibrary );
+		m_pAOTLibrary = NULL;
+		return;
+	}
 
-	FS_WriteFile( va( CACHE_DIR "/asmetadata.bin" ), header, sizeof( *header ) + ( MAX_NPATH * m_nModuleCount ) );
+	m_pAOTCompiler = new ( Hunk_Alloc( sizeof( *m_pAOTCompiler ), h_high ) ) CModuleAOTCompiler( pTable, m_pCompiler );
+	CheckASCall( m_pEngine->SetJITCompiler( m_pAOTCompiler ) );
+
+	Con_Printf( "...loaded %u ahead-of-time compiled functions\n", pTable->nFunctions );
 }
 
 qboolean CModuleLib::RecompileNeeded( void )
 {
-	fileTime_t total, added;
-	char **fileList, **dirList;
-	uint64_t numFiles, numDirs;
-	uint64_t i;
-
 	if ( ml_alwaysCompile->i ) {
 		Con_Printf( COLOR_MAGENTA "forced recompilation is enabled.\n" );
 		return qtrue;
@@ -545,27 +635,21 @@ qboolean CModuleLib::RecompileNeeded( void )
 		return qtrue;
 	}
 
-	total = 0;
-	for ( i = 0; i < m_nModuleCount; i++ ) {
-		Con_DPrintf( "fetching checksum of '%s'...\n", m_pModList[i].info->m_szId );
-		added = ModuleLib_GetDirectoryChecksum( m_pModList[i].info->m_pHandle->GetModulePath() );
-		Con_DPrintf( "...got %lu\n", added );
-		total += added;
-	}
-
-	Con_Printf( COLOR_MAGENTA "...Got total checksum of %lu\n", total );
+	Con_Printf( COLOR_MAGENTA "...Got total checksum of %016lx\n", m_nCodeHash );
 
-	return m_pCacheData->checksum != total;
+	if ( m_pCacheData->checksum != m_nCodeHash ) {
+		PrintChangedModules();
+		Con_Printf( COLOR_MAGENTA "...rebuilding all %lu modules, they share GlobalModule\n", m_nModuleCount );
+		return qtrue;
+	}
+	return qfalse;
 }
 
 bool CModuleLib::LoadByteCodeCache( void )
 {
 	const char *path;
 	uint64_t nLength;
-	uint64_t i;
 	asCodeCacheHeader_t *header;
-	fileStats_t cacheStats, dataStats;
-	bool recompiled;
 
 	if ( ml_alwaysCompile->i ) {
 		Con_Printf( "Forced recompilation is on.\n" );
@@ -582,28 +666,32 @@ bool CModuleLib::LoadByteCodeCache( void )
 
 	if ( nLength < sizeof( *header ) ) {
 		Con_Printf( COLOR_RED "LoadByteCodeCache: metadata header too small for a valid file\n" );
+		FS_FreeFile( header );
+		return false;
+	}
+	if ( header->ident != AS_CACHE_CODE_IDENT || header->version != AS_CACHE_CODE_VERSION ) {
+		Con_Printf( COLOR_MAGENTA "LoadByteCodeCache: metadata is from an older version, rebuilding\n" );
+		FS_FreeFile( header );
+		return false;
+	}
+	if ( nLength < sizeof( *header ) + ( sizeof( *header->modList ) * header->modCount ) ) {
+		Con_Printf( COLOR_RED "LoadByteCodeCache: metadata module list is truncated\n" );
+		FS_FreeFile( header );
 		return false;
 	}
 
-	m_pCacheData = (asCodeCacheHeader_t *)Hunk_Alloc( sizeof( *header ) + ( MAX_NPATH * header->modCount ), h_high );
-	memcpy( m_pCacheData, header, sizeof( *header ) + ( MAX_NPATH * header->modCount ) );
+	m_pCacheData = (asCodeCacheHeader_t *)Hunk_Alloc( sizeof( *header ) + ( sizeof( *header->modList ) * header->modCount ), h_high );
+	memcpy( m_pCacheData, header, sizeof( *header ) + ( sizeof( *header->modList ) * header->modCount ) );
 
 	FS_FreeFile( header );
 
-	Con_Printf( "...Got checksum %lu\n", m_pCacheData->checksum );
+	Con_Printf( "...Got checksum %016lx\n", m_pCacheData->checksum );
 
-	if ( ( recompiled = RecompileNeeded() ) ) {
-		m_bModulesOutdated = qtrue;
+	if ( RecompileNeeded() ) {
 		Con_Printf( COLOR_MAGENTA "...module code has been changed.\n" );
-
-		for ( i = 0; i < m_nModuleCount; i++ ) {
-			m_pModList[i].info->m_pHandle->Compile();
-		}
 		return false;
-	} else {
-		m_bModulesOutdated = qfalse;
-		Con_Printf( COLOR_GREEN "...module code is up to date.\n" );
 	}
+	Con_Printf( COLOR_GREEN "...module code is up to date.\n" );
 
 	if ( m_pCacheData->gameVersion.m_nVersionMajor != _NOMAD_VERSION_MAJOR || m_pCacheData->gameVersion.m_nVersionUpdate != _NOMAD_VERSION_UPDATE
 		|| m_pCacheData->gameVersion.m_nVersionPatch != _NOMAD_VERSION_PATCH )
@@ -615,8 +703,14 @@ bool CModuleLib::LoadByteCodeCache( void )
 		// load the bytecode
 		CModuleCacheHandle dataStream( va( CACHE_DIR "/ascodecache.dat" ), FS_OPEN_READ );
 		int ret;
+
+		LoadAOT();
 		
 		ret = m_pModule->LoadByteCode( &dataStream, (bool *)&m_pCacheData->hasDebugSymbols );
+		if ( m_pAOTCompiler ) {
+			Con_Printf( "...%u functions running ahead-of-time compiled code, %u changed or without any\n",
+				m_pAOTCompiler->GetCompiledCount(), m_pAOTCompiler->GetFallbackCount() );
+		}
 		/*
 		if ( ret != asSUCCESS ) {
 			// clean cache to get rid of any old and/or corrupt code
@@ -640,19 +734,16 @@ bool CModuleLib::LoadByteCodeCache( void )
 qboolean CModuleLib::IsModuleInCache( const char *name ) const
 {
 	uint64_t i;
-	char *ptr;
 
 	if ( !m_pCacheData || m_bModulesOutdated ) {
 		// failed to load
 		return qfalse;
 	}
 
-	ptr = m_pCacheData->modList;
-	for ( i = 0; i < m_nModuleCount; i++ ) {
-		if ( !N_stricmp( ptr, name ) ) {
+	for ( i = 0; i < m_pCacheData->modCount; i++ ) {
+		if ( !N_stricmp( m_pCacheData->modList[i].name, name ) ) {
 			return qtrue;
 		}
-		ptr += MAX_NPATH;
 	}
 	return qfalse;
 }
@@ -782,7 +873,7 @@ CModuleLib::CModuleLib( void )
 	char **fileList;
 	uint64_t nFiles, i;
 	int error;
-	bool loaded, recompiled;
+	bool loaded;
 
 	if ( s_pModuleInstance && s_pModuleInstance->m_pEngine ) {
 		return;
@@ -827,6 +918,10 @@ CModuleLib::CModuleLib( void )
 	}
 	m_pScriptBuilder->SetIncludeCallback( Module_IncludeCallback_f, NULL );
 
+	// FIXME: every module still compiles into this one script module with one bytecode cache, so changing a single
+	// module rebuilds all of them. Giving each module its own script module and cache entry needs the scripts to
+	// stop reaching into nomadmain's globals (EntityManager, StateManager, ...) directly, shared entities can't
+	// have global variables
 	if ( ( error = g_pModuleLib->GetScriptBuilder()->StartNewModule( g_pModuleLib->GetScriptEngine(), "GlobalModule" ) ) != asSUCCESS ) {
 		N_Error( ERR_DROP, "CModuleHandle::CModuleHandle: failed to start module 'GlobalModule' -- %s", AS_PrintErrorString( error ) );
 	}
@@ -859,8 +954,14 @@ CModuleLib::CModuleLib( void )
 	LoadModList();
 
 	Con_Printf( "Checking if recompilation is needed...\n" );
+	m_pModuleHashes = (uint64_t *)Hunk_Alloc( sizeof( *m_pModuleHashes ) * MAX( 1, m_nModuleCount ), h_high );
+	m_nCodeHash = HashModules( qtrue, m_pModuleHashes, &m_nApiHash );
+	m_nStartupHashTime = m_nHashTime;
+	Con_Printf( "...hashed %u module files in %lu msec\n", m_nHashedFiles, m_nStartupHashTime / 1000 );
+
+	m_nStartupBuildTime = ML_Microseconds();
 	loaded = LoadByteCodeCache();
-	if ( ( recompiled = RecompileNeeded() ) ) {
+	if ( !loaded ) {
 		Con_Printf( COLOR_MAGENTA "...module code changed.\n" );
 		m_bModulesOutdated = qtrue;
 
@@ -868,7 +969,7 @@ CModuleLib::CModuleLib( void )
 			m_pLoadList[i].m_pHandle->Compile();
 		}
 	} else {
-		Con_Printf( COLOR_GREEN "...module code up to date.\n" );\
+		Con_Printf( COLOR_GREEN "...module code up to date.\n" );
 		m_bModulesOutdated = qfalse;
 	}
 
@@ -905,6 +1006,9 @@ CModuleLib::CModuleLib( void )
 		}
 	}
 
+	m_nStartupBuildTime = ML_Microseconds() - m_nStartupBuildTime;
+	Con_Printf( "...%s module code in %lu msec\n", loaded ? "loaded cached" : "compiled", m_nStartupBuildTime / 1000 );
+
 	if ( !loaded ) {
 		// only save if we've got new stuff
 		SaveByteCodeCache();
@@ -948,12 +1052,27 @@ CModuleLib *InitModuleLib( const moduleImport_t *pImport, const renderExport_t *
 	Cvar_SetDescription( ml_alwaysCompile, "Toggle forced compilation of a module every time the game loads as opposed to using cached bytecode" );
 	ml_allowJIT = Cvar_Get( "ml_allowJIT", "0", CVAR_LATCH | CVAR_PRIVATE | CVAR_SAVE );
 	Cvar_SetDescription( ml_allowJIT, "Toggle JIT compilation of a module" );
+	ml_allowAOT = Cvar_Get( "ml_allowAOT", "1", CVAR_LATCH | CVAR_PRIVATE | CVAR_SAVE );
+	Cvar_SetDescription( ml_allowAOT, "Use the ahead-of-time compiled module code in " CACHE_DIR "/" MODULE_AOT_LIBRARY DLL_EXT
+		" when it matches the bytecode cache, build it from the output of ml.aot_generate" );
 	ml_debugMode = Cvar_Get( "ml_debugMode", "0", CVAR_LATCH | CVAR_TEMP );
 	Cvar_SetDescription( ml_debugMode, "Set to 1 whenever a module is being debugged" );
 	ml_garbageCollectionIterations = Cvar_Get( "ml_garbageCollectionIterations", "4", CVAR_TEMP | CVAR_PRIVATE );
 	Cvar_SetDescription( ml_garbageCollectionIterations, "Sets the number of iterations per garbage collection loop" );
+	ml_gcBudgetUsec = Cvar_Get( "ml_gcBudgetUsec", "1000", CVAR_SAVE | CVAR_PRIVATE );
+	Cvar_SetDescription( ml_gcBudgetUsec, "Sets the time in microseconds the script garbage collector can take every frame" );
+	Cvar_CheckRange( ml_gcBudgetUsec, "0", "100000", CVT_INT );
+	ml_gcFullCycleObjects = Cvar_Get( "ml_gcFullCycleObjects", "8192", CVAR_SAVE | CVAR_PRIVATE );
+	Cvar_SetDescription( ml_gcFullCycleObjects,
+		"Sets how many objects the script garbage collector can gain since the last full cycle before it runs another one" );
+	Cvar_CheckRange( ml_gcFullCycleObjects, "256", "1048576", CVT_INT );
 
 	Cmd_AddCommand( "ml.garbage_collection_stats", ML_GarbageCollectionStats_f );
+	Cmd_AddCommand( "ml.dispatch_bench", ML_DispatchBench_f );
+	Cmd_AddCommand( "ml.binding_bench", ML_BindingBench_f );
+	Cmd_AddCommand( "ml.raycast_check", ML_RayCastCheck_f );
+	Cmd_AddCommand( "ml.aot_generate", ML_AOTGenerate_f );
+	Cmd_AddCommand( "ml.cache_bench", ML_CodeCacheBench_f );
 	Cmd_AddCommand( "ml_debug.print_string_cache", ML_PrintStringCache_f );
 
 	asSetGlobalMemoryFunctions( AS_Alloc, AS_Free );
@@ -988,6 +1107,11 @@ void CModuleLib::Shutdown( qboolean quit )
 	}
 
 	Cmd_RemoveCommand( "ml.garbage_collection_stats" );
+	Cmd_RemoveCommand( "ml.dispatch_bench" );
+	Cmd_RemoveCommand( "ml.binding_bench" );
+	Cmd_RemoveCommand( "ml.raycast_check" );
+	Cmd_RemoveCommand( "ml.aot_generate" );
+	Cmd_RemoveCommand( "ml.cache_bench" );
 	Cmd_RemoveCommand( "ml_debug.set_active" );
 	Cmd_RemoveCommand( "ml_debug.print_help" );
 	Cmd_RemoveCommand( "ml_debug.stacktrace" );
@@ -1005,6 +1129,10 @@ void CModuleLib::Shutdown( qboolean quit )
 		if ( m_pCompiler ) {
 			m_pCompiler->~asCJITCompiler();
 		}
+		// the library stays mapped, the engine still holds on to the functions in it
+		if ( m_pAOTCompiler ) {
+			m_pAOTCompiler->~CModuleAOTCompiler();
+		}
 		m_pScriptBuilder->~CScriptBuilder();
 		g_pDebugger->~CDebugger();
 	}
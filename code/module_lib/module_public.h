@@ -471,16 +471,25 @@ inline bool module_s::operator!=( const string_t& other ) const {
 	return N_strcmp( info->m_szName, other.c_str() ) != 0;
 }
 
+#define AS_CACHE_CODE_VERSION 2
+
+typedef struct {
+	char name[MAX_NPATH];
+	uint64_t hash;
+} asCodeCacheModule_t;
+
 typedef struct {
 	int64_t ident;
+	int32_t version;
 	version_t gameVersion;
 	int16_t moduleVersionMajor;
 	int16_t moduleVersionUpdate;
 	int32_t moduleVersionPatch;
-	fileTime_t checksum;
+	uint64_t checksum; // content hash of every module and the engine api
+	uint64_t apiHash;
 	qboolean hasDebugSymbols;
 	uint64_t modCount;
-	char modList[0];
+	asCodeCacheModule_t modList[0];
 } asCodeCacheHeader_t;
 
 class CModuleLib
@@ -498,6 +507,20 @@ public:
 	// runs all modules besides for sgame
 	void RunModules( EModuleFuncId nCallId, uint32_t nArgs, ... );
 
+	// incremental garbage collection, once per frame
+	void RunGarbageCollector( void );
+	uint64_t GetGCFrameTime( void ) const {
+		return m_nGCFrameTime;
+	}
+	uint32_t GetGCFullCycles( void ) const {
+		return m_nGCFullCycles;
+	}
+
+	// running total of the time spent inside ModuleCall and RunModules
+	uint64_t GetScriptTime( void ) const {
+		return m_nScriptTime;
+	}
+
 	// only for module_lib
 	CScriptBuilder *GetScriptBuilder( void );
 	asIScriptEngine *GetScriptEngine( void );
@@ -524,6 +547,30 @@ public:
 	CDebugger *GetDebugger( void );
 
 	qboolean IsModuleInCache( const char *name ) const;
+	uint64_t GetCodeChecksum( void ) const {
+		return m_nCodeHash;
+	}
+
+	// bytecode cache keys, see module_codecache.cpp
+	uint64_t HashModules( qboolean bParallel, uint64_t *pModuleHashes, uint64_t *pApiHash );
+	uint64_t GetHashTime( void ) const {
+		return m_nHashTime;
+	}
+	uint32_t GetHashedFiles( void ) const {
+		return m_nHashedFiles;
+	}
+	uint64_t GetHashedBytes( void ) const {
+		return m_nHashedBytes;
+	}
+	uint64_t GetStartupHashTime( void ) const {
+		return m_nStartupHashTime;
+	}
+	uint64_t GetStartupBuildTime( void ) const {
+		return m_nStartupBuildTime;
+	}
+	qboolean IsCodeCached( void ) const {
+		return (qboolean)!m_bModulesOutdated;
+	}
 
 	module_t *m_pModList;
 private:
@@ -532,6 +579,8 @@ private:
 	void LoadModList( void );
 	void LoadModule( const char *pModuleName );
 	qboolean RecompileNeeded( void );
+	void PrintChangedModules( void ) const;
+	void LoadAOT( void );
 
 	CModuleInfo *m_pLoadList;
 	uint64_t m_nModuleCount;
@@ -544,6 +593,8 @@ private:
 	qboolean m_bRecursiveShutdown;
 
 	asCJITCompiler *m_pCompiler;
+	CModuleAOTCompiler *m_pAOTCompiler;
+	void *m_pAOTLibrary;
 	CModuleHandle *m_pCurrentHandle;
 
 	asIScriptModule *m_pModule;
@@ -552,6 +603,23 @@ private:
 	asCodeCacheHeader_t *m_pCacheData;
 
 	qboolean m_bModulesOutdated;
+
+	uint64_t m_nCodeHash;
+	uint64_t m_nApiHash;
+	uint64_t *m_pModuleHashes;
+	uint64_t m_nHashTime;
+	uint32_t m_nHashedFiles;
+	uint64_t m_nHashedBytes;
+	uint64_t m_nStartupHashTime;
+	uint64_t m_nStartupBuildTime;
+
+	uint64_t m_nGCFrameTime;
+	uint32_t m_nGCFullCycles;
+	asUINT m_nGCBaseSize;
+	asUINT m_nGCObjects;
+
+	uint64_t m_nScriptTime;
+	uint32_t m_nCallDepth;
 };
 
 extern moduleImport_t moduleImport;
@@ -569,10 +637,22 @@ extern void *AS_Alloc( size_t nSize, const char *, unsigned int );
 extern void AS_Free( void *pBuffer, const char *, unsigned int );
 #endif
 
+uint64_t ML_Microseconds( void );
+
+// 64-bit FNV-1a, used for the bytecode cache and ahead-of-time code hashes
+#define ML_HASH_INIT 0xcbf29ce484222325ULL
+#define ML_HASH_PRIME 0x100000001b3ULL
+uint64_t ML_HashBytes( uint64_t nHash, const void *pData, uint64_t nBytes );
+
+void ML_CodeCacheBench_f( void );
+
 extern cvar_t *ml_debugMode;
 extern cvar_t *ml_angelScript_DebugPrint;
 extern cvar_t *ml_alwaysCompile;
 extern cvar_t *ml_allowJIT;
+extern cvar_t *ml_allowAOT;
 extern cvar_t *ml_garbageCollectionIterations;
+extern cvar_t *ml_gcBudgetUsec;
+extern cvar_t *ml_gcFullCycleObjects;
 
 #endif
\ No newline at end of file
@@ -1,6 +1,14 @@
 #include "../engine/n_shared.h"
+#include "../engine/n_common.h"
+#include "../engine/n_cvar.h"
+
+// the ui reads these whether or not there's anything to take input from
+cvar_t *in_mode;
+cvar_t *in_joystick;
 
 void IN_Init( void ) {
+    in_mode = Cvar_Get( "in_mode", "0", 0 );
+    in_joystick = Cvar_Get( "in_joystick", "0", CVAR_SAVE | CVAR_LATCH );
 }
 
 void IN_Frame( void ) {
@@ -13,4 +21,11 @@ void IN_JoyMove( void ) {
 }
 
 void IN_StartupJoystick( void ) {
-}
\ No newline at end of file
+}
+
+void HandleEvents( void ) {
+}
+
+void Com_JoystickGetAngle( int joystickIndex, float *angle, ivec2_t joystickPosition ) {
+    *angle = 0.0f;
+}
@@ -4,15 +4,46 @@
 #include "../engine/n_common.h"
 #include "../game/g_game.h"
 #include <SDL2/SDL.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+// null_input.cpp
+void IN_Init( void );
+void IN_Frame( void );
 
 uint64_t Sys_Milliseconds( void ) {
-    return time( NULL );
+    return SDL_GetTicks64();
+}
+
+uint64_t Sys_Microseconds( void ) {
+    const uint64_t counter = SDL_GetPerformanceCounter();
+    const uint64_t frequency = SDL_GetPerformanceFrequency();
+    return ( counter / frequency ) * 1000000 + ( counter % frequency ) * 1000000 / frequency;
+}
+
+void Sys_SleepUntil( uint64_t usec ) {
+    uint64_t now = Sys_Microseconds();
+    if ( usec > now ) {
+        SDL_Delay( ( usec - now ) / 1000 );
+    }
+}
+
+uint64_t Sys_ThreadCPUTime( void ) {
+    return (uint64_t)clock() * 1000000 / CLOCKS_PER_SEC;
 }
 
 FILE *Sys_FOpen( const char *filepath, const char *mode ) {
     return fopen( filepath, mode );
 }
 
+qboolean Sys_FSync( FILE *fp ) {
+    return fflush( fp ) == 0 ? qtrue : qfalse;
+}
+
+qboolean Sys_ReplaceFile( const char *from, const char *to ) {
+    return rename( from, to ) == 0 ? qtrue : qfalse;
+}
+
 int Sys_MessageBox( const char *title, const char *text, bool ShowOkAndCancelButton ) {
     return 0;
 }
@@ -63,7 +94,7 @@ void Sys_Print( const char *msg ) {
     memset( printmsg, 0, sizeof( printmsg ) );
 
     char *out = printmsg;
-    while ( *msg != '\0' && out < printmsg + sizeof( printmsg ) ) {
+    while ( *msg != '\0' && out < printmsg + sizeof( printmsg ) - 1 ) {
         if ( printableChar( *msg ) ) {
             *out++ = *msg;
 		}
@@ -73,7 +104,7 @@ void Sys_Print( const char *msg ) {
     
     // don't bother with an fprintf, we've already got it all
     // formatted
-    fwrite( msg, len, 1, stdout );
+    fwrite( printmsg, len, 1, stdout );
 }
 
 void GDR_NORETURN GDR_ATTRIBUTE((format(printf, 1, 2))) GDR_DECL Sys_Error( const char *fmt, ... )
@@ -123,19 +154,23 @@ const char *Sys_pwd( void ) {
     return NULL;
 }
 
+// the renderer is still a library, the null one when running headless
 void *Sys_LoadDLL( const char *name ) {
-    return NULL;
+    return SDL_LoadObject( name );
 }
 
 void Sys_CloseDLL( void *handle ) {
+    if ( handle ) {
+        SDL_UnloadObject( handle );
+    }
 }
 
 void *Sys_GetProcAddress( void *handle, const char *name ){
-    return NULL;
+    return SDL_LoadFunction( handle, name );
 }
 
 const char *Sys_GetError( void ) {
-    return NULL;
+    return SDL_GetError();
 }
 
 void GDR_NORETURN Sys_Exit( int code ) {
@@ -158,14 +193,142 @@ void Sys_FreeFileList( char **list ) {
 }
 
 void Sys_ListFilteredFiles( const char *basedir, const char *subdirs, const char *filter, char **list, uint64_t *numfiles ) {
+    char search[MAX_OSPATH*2+1];
+    char newsubdirs[MAX_OSPATH*2];
+    char filename[MAX_OSPATH*2];
+    DIR *fdir;
+    struct dirent *d;
+    struct stat st;
+
+    if ( *numfiles >= MAX_FOUND_FILES - 1 ) {
+        return;
+    }
+
+    if ( *subdirs ) {
+        Com_snprintf( search, sizeof( search ) - 1, "%s/%s", basedir, subdirs );
+    } else {
+        Com_snprintf( search, sizeof( search ) - 1, "%s", basedir );
+    }
+
+    if ( ( fdir = opendir( search ) ) == NULL ) {
+        return;
+    }
+
+    while ( ( d = readdir( fdir ) ) != NULL ) {
+        Com_snprintf( filename, sizeof( filename ), "%s/%s", search, d->d_name );
+        if ( stat( filename, &st ) == -1 ) {
+            continue;
+        }
+
+        if ( S_ISDIR( st.st_mode ) ) {
+            if ( !N_streq( d->d_name, "." ) && !N_streq( d->d_name, ".." ) ) {
+                if ( *subdirs ) {
+                    Com_snprintf( newsubdirs, sizeof( newsubdirs ), "%s/%s", subdirs, d->d_name );
+                } else {
+                    Com_snprintf( newsubdirs, sizeof( newsubdirs ), "%s", d->d_name );
+                }
+                Sys_ListFilteredFiles( basedir, newsubdirs, filter, list, numfiles );
+            }
+        }
+        if ( *numfiles >= MAX_FOUND_FILES - 1 ) {
+            break;
+        }
+
+        Com_snprintf( filename, sizeof( filename ), "%s/%s", subdirs, d->d_name );
+        if ( !Com_FilterPath( filter, filename ) ) {
+            continue;
+        }
+
+        list[ *numfiles ] = FS_CopyString( filename );
+        (*numfiles)++;
+    }
+    closedir( fdir );
 }
 
 char **Sys_ListFiles( const char *directory, const char *extension, const char *filter, uint64_t *numfiles, qboolean wantsubs ) {
-    return NULL;
+    char search[MAX_OSPATH*2+MAX_GDR_PATH+1];
+    char *list[MAX_FOUND_FILES];
+    char **listCopy;
+    DIR *fdir;
+    struct dirent *d;
+    struct stat st;
+    qboolean dironly, hasPatterns;
+    uint64_t nfiles, extLen, length, i;
+    const char *x;
+
+    nfiles = 0;
+    dironly = wantsubs;
+
+    if ( filter ) {
+        Sys_ListFilteredFiles( directory, "", filter, list, &nfiles );
+    } else {
+        if ( !extension ) {
+            extension = "";
+        }
+        if ( extension[0] == '/' && extension[1] == '\0' ) {
+            extension = "";
+            dironly = qtrue;
+        }
+
+        if ( ( fdir = opendir( directory ) ) == NULL ) {
+            *numfiles = 0;
+            return NULL;
+        }
+
+        extLen = strlen( extension );
+        hasPatterns = Com_HasPatterns( extension );
+        if ( hasPatterns && extension[0] == '.' && extension[1] != '\0' ) {
+            extension++;
+        }
+
+        while ( ( d = readdir( fdir ) ) != NULL ) {
+            if ( nfiles >= MAX_FOUND_FILES - 1 ) {
+                break;
+            }
+
+            Com_snprintf( search, sizeof( search ), "%s/%s", directory, d->d_name );
+            if ( stat( search, &st ) == -1 ) {
+                continue;
+            }
+            if ( ( dironly && !S_ISDIR( st.st_mode ) ) || ( !dironly && S_ISDIR( st.st_mode ) ) ) {
+                continue;
+            }
+
+            if ( *extension ) {
+                if ( hasPatterns ) {
+                    x = strrchr( d->d_name, '.' );
+                    if ( !x || !Com_FilterExt( extension, x + 1 ) ) {
+                        continue;
+                    }
+                } else {
+                    length = strlen( d->d_name );
+                    if ( length < extLen || N_stricmp( d->d_name + length - extLen, extension ) ) {
+                        continue;
+                    }
+                }
+            }
+            list[ nfiles++ ] = FS_CopyString( d->d_name );
+        }
+        closedir( fdir );
+    }
+
+    *numfiles = nfiles;
+    if ( !nfiles ) {
+        return NULL;
+    }
+
+    listCopy = (char **)Z_Malloc( ( nfiles + 1 ) * sizeof( *listCopy ), TAG_STATIC );
+    for ( i = 0; i < nfiles; i++ ) {
+        listCopy[i] = list[i];
+    }
+    listCopy[i] = NULL;
+
+    return listCopy;
 }
 
+// kept apart from the game's so a headless run's config can't leave the player with the null renderer
 const char *Sys_DefaultHomePath( void ) {
-    return SDL_GetPrefPath( "GDRSoftware", "TheNomad" );
+    return SDL_GetPrefPath( "GDRSoftware", "TheNomad-null" );
 }
 
 const char *Sys_DefaultBasePath( void ) {
@@ -229,9 +392,46 @@ int Sys_GetDLLErrorCount( void ) {
 }
 
 const char *Sys_GetDLLError( void ) {
+    return SDL_GetError();
+}
+
+dialogResult_t Sys_Dialog( dialogType_t type, const char *message, const char *title ) {
+    // nobody's there to answer
+    fprintf( stderr, "%s: %s\n", title, message );
+    return DR_OK;
+}
+
+int Sys_PID( void ) {
+    return 0;
+}
+
+qboolean Sys_PIDIsRunning( int pid ) {
+    return qfalse;
+}
+
+bool Sys_IsInDebugSession( void ) {
+    return false;
+}
+
+// no file mappings, the filesystem reads bffs the normal way when these fail
+void *Sys_MapFile( const char *path, qboolean temp ) {
+    return NULL;
+}
+
+void *Sys_GetMappedFileBuffer( void *file ) {
     return NULL;
 }
 
+uint64_t Sys_GetMappedFileSize( void *file ) {
+    return 0;
+}
+
+void Sys_UnmapFile( void *file ) {
+}
+
+// there's no window to draw in, the rest of the command line comes after so it can still be overridden
+#define NULL_CMDLINE "+set g_renderer null"
+
 int main( int argc, char **argv )
 {
     char *cmdline;
@@ -241,7 +441,7 @@ int main( int argc, char **argv )
     Con_Printf( "WARNING: Sys_Null THIS IS NOT A RELEASE BUILD!!!!!!\n" );
 
     // merge the command line, this is kinda silly
-	for ( len = 1, i = 1; i < argc; i++ ) {
+	for ( len = strlen( NULL_CMDLINE ) + 1, i = 1; i < argc; i++ ) {
 		len += strlen( argv[i] ) + 1;
     }
 
@@ -250,8 +450,17 @@ int main( int argc, char **argv )
         Sys_Error( "main(): malloc failed on %i bytes", len );
     }
 
+    strcpy( cmdline, NULL_CMDLINE );
+    for ( i = 1; i < argc; i++ ) {
+        strcat( cmdline, " " );
+        strcat( cmdline, argv[i] );
+    }
+
     Com_Init( cmdline );
 
+    // nothing calls GLimp_Init to do this for us
+    IN_Init();
+
     while ( 1 ) {
         IN_Frame();
         Com_Frame( qfalse );
@@ -28,6 +28,16 @@ typedef struct {
 	uint32_t c_overDraw;
 	uint32_t c_lightallDraws;
 	uint32_t c_genericDraws;
+
+	uint32_t c_worldChunks;
+	uint32_t c_worldChunksCulled;
+	uint32_t c_worldTilesBaked;
+	uint64_t c_worldUploadBytes;
+
+	uint32_t c_polysSorted;
+	uint32_t c_polyBatches;     // draws R_DrawPolys issued after sorting
+	uint32_t c_stateChanges;    // shader switches between those draws
+	uint64_t polySortUsec;
 } backendCounters_t;
 
 typedef struct {
@@ -98,6 +108,7 @@ typedef struct {
 	const char *(*Cmd_Argv)(uint32_t index);
 
 	uint64_t (*Milliseconds)(void);
+	uint64_t (*Microseconds)(void);
 
 	qboolean (*Key_IsDown)(uint32_t keynum);
 
@@ -108,11 +119,14 @@ typedef struct {
 	fileOffset_t (*FS_FileTell)(fileHandle_t f);
 	uint64_t (*FS_FileLength)(fileHandle_t f);
 	qboolean (*FS_FileExists)(const char *filename);
+	qboolean (*FS_FileInPathExists)(const char *npath);
 	fileHandle_t (*FS_FOpenRead)(const char *path);
 	fileHandle_t (*FS_FOpenWrite)(const char *path);
 	void (*FS_FClose)(fileHandle_t f);
 	void (*FS_FreeFile)(void *buffer);
 	uint64_t (*FS_LoadFile)(const char *path, void **buffer);
+	void (*FS_FreeFileView)(const void *buffer);
+	uint64_t (*FS_LoadFileView)(const char *path, const void **buffer);
 	char **(*FS_ListFiles)(const char *path, const char *extension, uint64_t *numfiles);
 	void (*FS_WriteFile)(const char *npath, const void *buffer, uint64_t size);
 	void (*FS_Remove)( const char *npath );
@@ -131,8 +145,18 @@ typedef struct {
 	void (*GLimp_Shutdown)(qboolean unloadDLL);
 	void (*GLimp_LogComment)(const char *comment);
 	void (*GLimp_Minimize)( void );
+	qboolean (*GLimp_SpawnRenderThread)( void (*function)( void ) );
+	void (*GLimp_ShutdownRenderThread)( void );
+	void *(*GLimp_RenderSleep)( void );
+	void (*GLimp_FrontEndSleep)( void );
+	void (*GLimp_WakeRenderer)( void *data );
 	void *(*GL_GetProcAddress)( const char *name );
 
+	// background work for the renderer, finished jobs have to be collected on the thread that queued them
+	qboolean (*Job_Add)( void (*function)( void *data ), void *data );
+	void *(*Job_GetFinished)( qboolean wait );
+	uint32_t (*Job_NumWorkers)( void );
+
 	void *(*Sys_LoadDLL)(const char *name);
 	void *(*Sys_GetProcAddress)(void *handle, const char *name);
 	void (*Sys_CloseDLL)(void *handle);
@@ -140,7 +164,8 @@ typedef struct {
 	void (*ImGui_Init)( void *shaderData, const void *importData );
 	void (*ImGui_Shutdown)( void );
 	void (*ImGui_NewFrame)( void );
-	void (*ImGui_Draw)( void );
+	void *(*ImGui_EndFrame)( void );
+	void (*ImGui_Draw)( void *drawData );
 
 	void (*ProfileFunctionBegin)( const char *function );
 	void (*ProfileFunctionEnd)( void );
@@ -168,6 +193,7 @@ typedef struct {
 	nhandle_t (*RegisterSpriteSheet)( const char *npath, uint32_t sheetWidth, uint32_t sheetHeight, uint32_t spriteWidth, uint32_t spriteHeight );
 	nhandle_t (*RegisterSprite)( nhandle_t hSpriteSheet, uint32_t index );
 	void (*LoadWorld)( const char *name );
+	void (*SetWorldTile)( uint32_t x, uint32_t y, int32_t index );
 
 	// EndRegistration will draw a tiny polygon with each texture, forcing
 	// them to be loaded into card memory
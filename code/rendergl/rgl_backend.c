@@ -466,6 +466,10 @@ static const void *RB_SwapBuffers( const void *data )
 {
 	const swapBuffersCmd_t *cmd;
 	uint64_t start, end;
+
+	cmd = (const swapBuffersCmd_t *)data;
+
+	backend.drawBatch.shaderTime = backend.refdef.floatTime;
 	
 	// texture swapping test
 	if ( r_showImages->i ) {
@@ -474,11 +478,9 @@ static const void *RB_SwapBuffers( const void *data )
 	
 	// only draw imgui data after everything else has finished
 //	if ( !backend.framePostProcessed ) {
-		ri.ImGui_Draw();
+		ri.ImGui_Draw( cmd->imguiData );
 		GL_CheckErrors();
 //	}
-	
-	cmd = (const swapBuffersCmd_t *)data;
 
 	if ( r_glDiagnostics->i ) {
 		if ( rg.beganQuery ) {
@@ -612,12 +614,6 @@ static const void *RB_PostProcess( const void *data )
 		RB_FlushBatchBuffer();
 	}
 
-	// only draw imgui data after everything else has finished
-//	if ( !backend.framePostProcessed ) {
-		ri.ImGui_Draw();
-		GL_CheckErrors();
-//	}
-
 	if ( !glContext.ARB_framebuffer_object || !r_postProcess->i ) {
 		// do nothing
 		return (const void *)( cmd + 1 );
@@ -936,13 +932,13 @@ static const void *RB_DrawImage( const void *data ) {
 		if ( backend.drawBatch.idxOffset ) {
 			RB_FlushBatchBuffer();
 		}
-		RB_SetBatchBuffer( backend.drawBuffer[ backend.cpuBuffer ], backendData[ rg.smpFrame ]->verts, sizeof( srfVert_t ),
-			backendData[ rg.smpFrame ]->indices, sizeof( glIndex_t ) );
+		RB_SetBatchBuffer( backend.drawBuffer[ backend.cpuBuffer ], backendData[ backend.smpFrame ]->verts, sizeof( srfVert_t ),
+			backendData[ backend.smpFrame ]->indices, sizeof( glIndex_t ) );
 	}
 	backend.drawBatch.shader = shader;
 
-	verts = backendData[ rg.smpFrame ]->verts;
-	indices = backendData[ rg.smpFrame ]->indices;
+	verts = backendData[ backend.smpFrame ]->verts;
+	indices = backendData[ backend.smpFrame ]->indices;
 	numVerts = backend.drawBatch.vtxOffset;
 	numIndices = backend.drawBatch.idxOffset;
 
@@ -954,51 +950,51 @@ static const void *RB_DrawImage( const void *data ) {
 
 //		VectorScale4( backend.color2D, 257, color );
 
-		VectorCopy4( backendData[ rg.smpFrame ]->verts[ numVerts + 0 ].color.rgba, backend.color2D );
-		VectorCopy4( backendData[ rg.smpFrame ]->verts[ numVerts + 1 ].color.rgba, backend.color2D );
-		VectorCopy4( backendData[ rg.smpFrame ]->verts[ numVerts + 2 ].color.rgba, backend.color2D );
-		VectorCopy4( backendData[ rg.smpFrame ]->verts[ numVerts + 3 ].color.rgba, backend.color2D );
+		VectorCopy4( backendData[ backend.smpFrame ]->verts[ numVerts + 0 ].color.rgba, backend.color2D );
+		VectorCopy4( backendData[ backend.smpFrame ]->verts[ numVerts + 1 ].color.rgba, backend.color2D );
+		VectorCopy4( backendData[ backend.smpFrame ]->verts[ numVerts + 2 ].color.rgba, backend.color2D );
+		VectorCopy4( backendData[ backend.smpFrame ]->verts[ numVerts + 3 ].color.rgba, backend.color2D );
 
-//		R_VaoPackColor( backendData[ rg.smpFrame ]->verts[ numVerts + 0 ].color.rgba, backend.color2D );
-//		R_VaoPackColor( backendData[ rg.smpFrame ]->verts[ numVerts + 1 ].color.rgba, backend.color2D );
-//		R_VaoPackColor( backendData[ rg.smpFrame ]->verts[ numVerts + 2 ].color.rgba, backend.color2D );
-//		R_VaoPackColor( backendData[ rg.smpFrame ]->verts[ numVerts + 3 ].color.rgba, backend.color2D );
+//		R_VaoPackColor( backendData[ backend.smpFrame ]->verts[ numVerts + 0 ].color.rgba, backend.color2D );
+//		R_VaoPackColor( backendData[ backend.smpFrame ]->verts[ numVerts + 1 ].color.rgba, backend.color2D );
+//		R_VaoPackColor( backendData[ backend.smpFrame ]->verts[ numVerts + 2 ].color.rgba, backend.color2D );
+//		R_VaoPackColor( backendData[ backend.smpFrame ]->verts[ numVerts + 3 ].color.rgba, backend.color2D );
 	}
 
-	backendData[ rg.smpFrame ]->verts[ numVerts + 0 ].xyz[0] = cmd->x;
-	backendData[ rg.smpFrame ]->verts[ numVerts + 0 ].xyz[1] = cmd->y;
-	backendData[ rg.smpFrame ]->verts[ numVerts + 0 ].xyz[2] = 0;
+	backendData[ backend.smpFrame ]->verts[ numVerts + 0 ].xyz[0] = cmd->x;
+	backendData[ backend.smpFrame ]->verts[ numVerts + 0 ].xyz[1] = cmd->y;
+	backendData[ backend.smpFrame ]->verts[ numVerts + 0 ].xyz[2] = 0;
 
-	backendData[ rg.smpFrame ]->verts[ numVerts + 0 ].st[0] = cmd->u1;
-	backendData[ rg.smpFrame ]->verts[ numVerts + 0 ].st[1] = cmd->v1;
+	backendData[ backend.smpFrame ]->verts[ numVerts + 0 ].st[0] = cmd->u1;
+	backendData[ backend.smpFrame ]->verts[ numVerts + 0 ].st[1] = cmd->v1;
 
-	backendData[ rg.smpFrame ]->verts[ numVerts + 1 ].xyz[0] = cmd->x + cmd->w;
-	backendData[ rg.smpFrame ]->verts[ numVerts + 1 ].xyz[1] = cmd->y;
-	backendData[ rg.smpFrame ]->verts[ numVerts + 1 ].xyz[2] = 0;
+	backendData[ backend.smpFrame ]->verts[ numVerts + 1 ].xyz[0] = cmd->x + cmd->w;
+	backendData[ backend.smpFrame ]->verts[ numVerts + 1 ].xyz[1] = cmd->y;
+	backendData[ backend.smpFrame ]->verts[ numVerts + 1 ].xyz[2] = 0;
 
-	backendData[ rg.smpFrame ]->verts[ numVerts + 1 ].st[0] = cmd->u2;
-	backendData[ rg.smpFrame ]->verts[ numVerts + 1 ].st[1] = cmd->v1;
+	backendData[ backend.smpFrame ]->verts[ numVerts + 1 ].st[0] = cmd->u2;
+	backendData[ backend.smpFrame ]->verts[ numVerts + 1 ].st[1] = cmd->v1;
 
-	backendData[ rg.smpFrame ]->verts[ numVerts + 2 ].xyz[0] = cmd->x + cmd->w;
-	backendData[ rg.smpFrame ]->verts[ numVerts + 2 ].xyz[1] = cmd->y + cmd->h;
-	backendData[ rg.smpFrame ]->verts[ numVerts + 2 ].xyz[2] = 0;
+	backendData[ backend.smpFrame ]->verts[ numVerts + 2 ].xyz[0] = cmd->x + cmd->w;
+	backendData[ backend.smpFrame ]->verts[ numVerts + 2 ].xyz[1] = cmd->y + cmd->h;
+	backendData[ backend.smpFrame ]->verts[ numVerts + 2 ].xyz[2] = 0;
 
-	backendData[ rg.smpFrame ]->verts[ numVerts + 2 ].st[0] = cmd->u2;
-	backendData[ rg.smpFrame ]->verts[ numVerts + 2 ].st[1] = cmd->v2;
+	backendData[ backend.smpFrame ]->verts[ numVerts + 2 ].st[0] = cmd->u2;
+	backendData[ backend.smpFrame ]->verts[ numVerts + 2 ].st[1] = cmd->v2;
 
-	backendData[ rg.smpFrame ]->verts[ numVerts + 3 ].xyz[0] = cmd->x;
-	backendData[ rg.smpFrame ]->verts[ numVerts + 3 ].xyz[1] = cmd->y + cmd->h;
-	backendData[ rg.smpFrame ]->verts[ numVerts + 3 ].xyz[2] = 0;
+	backendData[ backend.smpFrame ]->verts[ numVerts + 3 ].xyz[0] = cmd->x;
+	backendData[ backend.smpFrame ]->verts[ numVerts + 3 ].xyz[1] = cmd->y + cmd->h;
+	backendData[ backend.smpFrame ]->verts[ numVerts + 3 ].xyz[2] = 0;
 
-	backendData[ rg.smpFrame ]->verts[ numVerts + 3 ].st[0] = cmd->u1;
-	backendData[ rg.smpFrame ]->verts[ numVerts + 3 ].st[1] = cmd->v2;
+	backendData[ backend.smpFrame ]->verts[ numVerts + 3 ].st[0] = cmd->u1;
+	backendData[ backend.smpFrame ]->verts[ numVerts + 3 ].st[1] = cmd->v2;
 
-	backendData[ rg.smpFrame ]->indices[ numIndices + 0 ] = 0;
-	backendData[ rg.smpFrame ]->indices[ numIndices + 1 ] = 1;
-	backendData[ rg.smpFrame ]->indices[ numIndices + 2 ] = 2;
-	backendData[ rg.smpFrame ]->indices[ numIndices + 3 ] = 0;
-	backendData[ rg.smpFrame ]->indices[ numIndices + 4 ] = 2;
-	backendData[ rg.smpFrame ]->indices[ numIndices + 5 ] = 3;
+	backendData[ backend.smpFrame ]->indices[ numIndices + 0 ] = 0;
+	backendData[ backend.smpFrame ]->indices[ numIndices + 1 ] = 1;
+	backendData[ backend.smpFrame ]->indices[ numIndices + 2 ] = 2;
+	backendData[ backend.smpFrame ]->indices[ numIndices + 3 ] = 0;
+	backendData[ backend.smpFrame ]->indices[ numIndices + 4 ] = 2;
+	backendData[ backend.smpFrame ]->indices[ numIndices + 5 ] = 3;
 
 	return (const void *)( cmd + 1 );
 }
@@ -1009,23 +1005,228 @@ static const void *RB_DrawWorldView( const void *data )
 	
 	cmd = (const drawWorldView_t *)data;
 
+	backend.refdef = cmd->refdef;
+	glState.viewData = cmd->viewData;
+
 	// draw the tilemap
 	R_DrawWorld();
 
-	RE_ProcessEntities();
-
 	// render all submitted sgame polygons
 	R_DrawPolys();
 
 	return (const void *)( cmd + 1 );
 }
 
+/*
+=============
+RB_BeginFrame
+
+sets up the gl state for a new frame, everything RE_BeginFrame used to do with
+the context now happens here so it runs on whichever thread owns it
+=============
+*/
+static const void *RB_BeginFrame( const void *data )
+{
+	const beginFrameCmd_t *cmd;
+	int width, height;
+	unsigned clearBits;
+	int i;
+	char buf[ MAX_CVAR_VALUE ], *v[4];
+
+	cmd = (const beginFrameCmd_t *)data;
+
+	backend.refdef.stereoFrame = cmd->stereoFrame;
+	backend.refdef.time = cmd->time;
+	backend.refdef.floatTime = backend.refdef.time * 0.001f;
+	backend.drawBatch.shaderTime = backend.refdef.floatTime;
+	backend.gamePaused = cmd->gamePaused;
+	backend.viewZoom = cmd->viewZoom;
+
+	glState.finishCalled = qfalse;
+
+	if ( glContext.ARB_framebuffer_object && r_arb_framebuffer_object->i && rg.renderFbo.frameBuffer ) {
+		ri.ProfileFunctionBegin( "BindFramebuffer" );
+		GL_BindFramebuffer( GL_FRAMEBUFFER, rg.renderFbo.frameBuffer );
+		ri.ProfileFunctionEnd();
+	}
+
+	if ( glState.currentFbo ) {
+		width = glState.currentFbo->width;
+		height = glState.currentFbo->height;
+	} else {
+		if ( r_fixedRendering->i ) {
+			if ( r_fixedResolutionScale->f == 0.0f ) {
+				width = SCREEN_WIDTH;
+				height = SCREEN_HEIGHT;
+			} else {
+				width = glConfig.vidWidth * r_fixedResolutionScale->f;
+				height = glConfig.vidHeight * r_fixedResolutionScale->f;
+			}
+		} else {
+			width = glConfig.vidWidth;
+			height = glConfig.vidHeight;
+		}
+	}
+
+	clearBits = GL_COLOR_BUFFER_BIT;
+
+	if ( r_glDiagnostics->i ) {
+		if ( !rg.beganQuery ) {
+			nglBeginQuery( GL_TIME_ELAPSED, rg.queries[TIME_QUERY] );
+			nglBeginQuery( GL_SAMPLES_PASSED, rg.queries[SAMPLES_QUERY] );
+			nglBeginQuery( GL_PRIMITIVES_GENERATED, rg.queries[PRIMTIVES_QUERY] );
+		}
+		rg.beganQuery = qtrue;
+	}
+
+	if ( r_measureOverdraw->i ) {
+		clearBits |= GL_STENCIL_BUFFER_BIT;
+	}
+
+	if ( r_clearColor->s ) {
+		// track changes
+		if ( strcmp( r_clearColor->s, glState.clearColorString ) )  {
+			N_strncpyz( glState.clearColorString, r_clearColor->s, sizeof( glState.clearColorString ) );
+			N_strncpyz( buf, r_clearColor->s, sizeof( buf ) );
+			Com_Split( buf, v, 4, ' ' );
+			for ( i = 0; i < 4 ; i++ ) {
+				glState.clearColor[ i ] = N_atof( v[ i ] ) / 255.0f;
+				if ( glState.clearColor[ i ] > 1.0f ) {
+					glState.clearColor[ i ] = 1.0f;
+				} else if ( glState.clearColor[ i ] < 0.0f ) {
+					glState.clearColor[ i ] = 0.0f;
+				}
+			}
+			nglClearColor( glState.clearColor[0], glState.clearColor[1], glState.clearColor[2], glState.clearColor[3] );
+		}
+	}
+
+	// set 2D virtual screen size
+	{
+		ri.ProfileFunctionBegin( "Set GL State" );
+
+		nglViewport( 0, 0, width, height );
+		nglScissor( 0, 0, width, height );
+
+		// clear relevant buffers
+		nglClear( clearBits );
+		nglActiveTexture( GL_TEXTURE0 );
+
+		// setup basic state
+		nglEnable( GL_BLEND );
+		nglEnable( GL_SCISSOR_TEST );
+		nglDisable( GL_STENCIL_TEST );
+		nglDisable( GL_DEPTH_TEST );
+		nglBlendFunc( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA );
+
+		ri.ProfileFunctionEnd();
+	}
+
+	//
+	// do overdraw measurement, RE_BeginFrame already turned it off if we don't have the stencil bits
+	//
+	if ( r_measureOverdraw->i ) {
+		nglEnable( GL_STENCIL_TEST );
+		nglStencilMask( ~0U );
+		nglClearStencil( 0U );
+		nglStencilFunc( GL_ALWAYS, 0U, ~0U );
+		nglStencilOp( GL_KEEP, GL_INCR, GL_INCR );
+	}
+
+	if ( !rg.world ) {
+		RB_SetBatchBuffer( backend.drawBuffer[ backend.cpuBuffer ], backendData[ backend.smpFrame ]->verts, sizeof( srfVert_t ),
+			backendData[ backend.smpFrame ]->indices, sizeof( glIndex_t ) );
+	}
+
+	return (const void *)( cmd + 1 );
+}
+
+uint64_t R_ChecksumPolys( const srfPoly_t *polys, uint64_t numPolys )
+{
+	uint64_t hash, i;
+	uint32_t j;
+	const byte *b;
+
+	// fnv-1a over every vertex
+	hash = 0xcbf29ce484222325ULL;
+	for ( i = 0; i < numPolys; i++ ) {
+		b = (const byte *)polys[i].verts;
+		for ( j = 0; j < polys[i].numVerts * sizeof( *polys[i].verts ); j++ ) {
+			hash = ( hash ^ b[j] ) * 0x100000001b3ULL;
+		}
+	}
+	return hash;
+}
+
+/*
+=============
+RB_ExecuteNullCommands
+
+r_smpstress swaps the backend for this, it touches the same data a real frame
+would without going near gl
+=============
+*/
+static void RB_ExecuteNullCommands( const void *data )
+{
+	const drawWorldView_t *cmd;
+
+	while ( 1 ) {
+		data = PADP( data, sizeof( void * ) );
+
+		switch ( *(const renderCmdType_t *)data ) {
+		case RC_SET_COLOR:
+			data = (const void *)( (const setColorCmd_t *)data + 1 );
+			break;
+		case RC_DRAW_IMAGE:
+			data = (const void *)( (const drawImageCmd_t *)data + 1 );
+			break;
+		case RC_DRAW_BUFFER:
+			data = (const void *)( (const drawBufferCmd_t *)data + 1 );
+			break;
+		case RC_SWAP_BUFFERS:
+			data = (const void *)( (const swapBuffersCmd_t *)data + 1 );
+			break;
+		case RC_SCREENSHOT:
+			data = (const void *)( (const screenshotCommand_t *)data + 1 );
+			break;
+		case RC_COLORMASK:
+			data = (const void *)( (const colorMaskCmd_t *)data + 1 );
+			break;
+		case RC_CLEARDEPTH:
+			data = (const void *)( (const clearDepthCommand_t *)data + 1 );
+			break;
+		case RC_POSTPROCESS:
+			data = (const void *)( (const postProcessCmd_t *)data + 1 );
+			break;
+		case RC_BEGIN_FRAME:
+			data = (const void *)( (const beginFrameCmd_t *)data + 1 );
+			break;
+		case RC_DRAW_WORLDVIEW:
+			cmd = (const drawWorldView_t *)data;
+			backendData[ backend.smpFrame ]->frameChecksum += R_ChecksumPolys( cmd->refdef.polys, cmd->refdef.numPolys );
+			data = (const void *)( cmd + 1 );
+			break;
+		case RC_END_OF_LIST:
+		default:
+			return;
+		}
+	}
+}
+
 void RB_ExecuteRenderCommands( const void *data )
 {
 	uint64_t t1, t2;
 
 	t1 = ri.Milliseconds();
 
+	// the command list lives in the frame's backend data, so that's what tells us which one we're drawing
+	backend.smpFrame = ( !backendData[ 1 ] || data == backendData[ 0 ]->commandList.buffer ) ? 0 : 1;
+
+	if ( rg.nullBackend ) {
+		RB_ExecuteNullCommands( data );
+		return;
+	}
+
 	while ( 1 ) {
 		data = PADP( data, sizeof( void * ) );
 
@@ -1043,9 +1244,13 @@ void RB_ExecuteRenderCommands( const void *data )
 			data = RB_SwapBuffers( data );
 			break;
 		case RC_SCREENSHOT:
-			backendData[ rg.smpFrame ]->screenshotBuf = *(const screenshotCommand_t *)data;
+			backendData[ backend.smpFrame ]->screenshotBuf = *(const screenshotCommand_t *)data;
+			screenshotFrame = qtrue;
 			data = (const void *)( (const screenshotCommand_t *)data + 1 );
 			break;
+		case RC_BEGIN_FRAME:
+			data = RB_BeginFrame( data );
+			break;
 		case RC_COLORMASK:
 			data = RB_ColorMask( data );
 			break;
@@ -1069,4 +1274,30 @@ void RB_ExecuteRenderCommands( const void *data )
 			return;
 		}
 	}
-}
\ No newline at end of file
+}
+
+/*
+=============
+RB_RenderThread
+
+the render thread's main loop when r_smp is on, it owns the context while it's drawing
+and hands it back to the front end whenever it goes to sleep
+=============
+*/
+void RB_RenderThread( void )
+{
+	const void *data;
+
+	while ( 1 ) {
+		// sleep until we have work to do
+		data = ri.GLimp_RenderSleep();
+		if ( !data ) {
+			// all done, renderer is shutting down
+			return;
+		}
+
+		renderThreadActive = qtrue;
+		RB_ExecuteRenderCommands( data );
+		renderThreadActive = qfalse;
+	}
+}
@@ -373,6 +373,9 @@ void R_InitGPUBuffers( void )
 	VBO_MapBuffers( &backend.drawBuffer[0]->index, qfalse );
 	VBO_MapBuffers( &backend.drawBuffer[1]->index, qfalse );
 	backendData[ 0 ]->indices = (glIndex_t *)backend.drawBuffer[0]->index.data;
+	if ( backendData[ 1 ] ) {
+		backendData[ 1 ]->indices = backendData[ 0 ]->indices;
+	}
 
 	backend.cpuBuffer = 0;
 	backend.gpuBuffer = 1;
@@ -487,6 +490,8 @@ vertexBuffer_t *R_AllocateBuffer( const char *name, void *vertices, uint32_t ver
 	GLenum err;
 	qboolean interleaved;
 
+	R_SyncRenderThread();
+
 	switch ( type ) {
 	case BUFFER_STATIC:
 		vertexUsage = GL_STATIC_DRAW;
@@ -855,8 +860,13 @@ void RB_SetBatchBuffer( vertexBuffer_t *buffer, void *vertexBuffer, uintptr_t vt
 		return;
 	}
 
-	backendData[ 0 ]->verts = backend.drawBuffer[ backend.cpuBuffer ]->vertex->data;
-	backendData[ 0 ]->indices = backend.drawBuffer[ backend.cpuBuffer ]->index.data;
+	// both frames batch through the same client buffers, only the backend ever touches them
+	for ( i = 0; i < SMP_FRAMES; i++ ) {
+		if ( backendData[ i ] ) {
+			backendData[ i ]->verts = backend.drawBuffer[ backend.cpuBuffer ]->vertex->data;
+			backendData[ i ]->indices = backend.drawBuffer[ backend.cpuBuffer ]->index.data;
+		}
+	}
 
     backend.drawBatch.buffer = buffer;
 
@@ -920,23 +930,8 @@ void RB_FlushBatchBuffer( void )
 
 	buf = backend.drawBatch.buffer;
 	
-	if ( rg.world && rg.world->buffer == buf ) {
-		if ( HAVE_DIRECT_STATE_ACCESS ) {
-			nglFlushMappedNamedBufferRange(
-				rg.world->buffer->vertex[ ATTRIB_INDEX_POSITION ].id,
-				rg.world->buffer->vertex[ ATTRIB_INDEX_POSITION ].offset,
-				backend.drawBatch.vtxDataSize * backend.drawBatch.vtxOffset
-			);
-		} else {
-			nglFlushMappedBufferRange(
-				GL_ARRAY_BUFFER,
-				sizeof( worldPos_t ) * rg.world->numVertices + ( rg.world->buffer->vertex->offset ),
-				backend.drawBatch.vtxDataSize * backend.drawBatch.vtxOffset
-			);
-		}
-		GL_CheckErrors();
-	}
-	else {
+	// the world is baked at load, R_RebakeWorldChunks flushes anything that changed since
+	if ( !rg.world || rg.world->buffer != buf ) {
 		void *data;
 
 #ifdef _WIN32
@@ -30,11 +30,9 @@ volatile qboolean renderThreadActive;
 
 static void R_PerformanceCounters( void )
 {
-	if ( !r_speeds->i ) {
-		// clear the counters even if we aren't printing
-		memset( &backend.pc, 0, sizeof( backend.pc ) );
-		return;
-	}
+	// the backend is idle here, hand its stats to the front end before they're cleared
+	rg.pc = backend.pc;
+	memcpy( rg.frameQueryCounts, rg.queryCounts, sizeof( rg.frameQueryCounts ) );
 
 	if ( r_speeds->i == 1 ) {
 		ri.Printf( PRINT_INFO, "%u/%u/%u binds/indices/vertices %u dynamic buffers %u static buffers %u IBOs %u VBOs %u VAOs\n",
@@ -42,7 +40,17 @@ static void R_PerformanceCounters( void )
 			backend.pc.c_staticBufferDraws, backend.pc.c_iboBinds, backend.pc.c_vboBinds, backend.pc.c_vaoBinds );
 	}
 	else if ( r_speeds->i == 2 ) {
+		ri.Printf( PRINT_INFO, "%u/%u world chunks drawn/culled %u tiles baked %lu bytes uploaded\n",
+			backend.pc.c_worldChunks, backend.pc.c_worldChunksCulled, backend.pc.c_worldTilesBaked, backend.pc.c_worldUploadBytes );
 	}
+	else if ( r_speeds->i == 3 ) {
+		ri.Printf( PRINT_INFO, "%lu draw calls %u poly batches %u shader changes %u polys sorted in %lu usec\n",
+			backend.pc.c_drawCalls, backend.pc.c_polyBatches, backend.pc.c_stateChanges, backend.pc.c_polysSorted,
+			backend.pc.polySortUsec );
+	}
+
+	// the counters are per frame
+	memset( &backend.pc, 0, sizeof( backend.pc ) );
 }
 
 void R_IssueRenderCommands( qboolean runPerformanceCounters, qboolean finalCommand )
@@ -58,6 +66,11 @@ void R_IssueRenderCommands( qboolean runPerformanceCounters, qboolean finalComma
 	// clear it out, in case this is a sync and not a buffer flip
 	cmdList->usedBytes = 0;
 
+	if ( glContext.smpActive ) {
+		// sleep until the renderer has finished the last frame we gave it
+		ri.GLimp_FrontEndSleep();
+	}
+
 	if ( runPerformanceCounters ) {
 		R_PerformanceCounters();
 	}
@@ -65,7 +78,11 @@ void R_IssueRenderCommands( qboolean runPerformanceCounters, qboolean finalComma
 	// actually start the commands going
 	if ( !r_skipBackEnd->i ) {
 		// let it start on the new batch
-		RB_ExecuteRenderCommands( cmdList->buffer );
+		if ( !glContext.smpActive ) {
+			RB_ExecuteRenderCommands( cmdList->buffer );
+		} else {
+			ri.GLimp_WakeRenderer( cmdList->buffer );
+		}
 	}
 }
 
@@ -83,6 +100,28 @@ void R_IssuePendingRenderCommands( void )
 	}
 
 	R_IssueRenderCommands( qfalse, qfalse );
+
+	if ( glContext.smpActive ) {
+		// wait for the commands to finish and take the context back
+		ri.GLimp_FrontEndSleep();
+	}
+}
+
+/*
+============
+R_SyncRenderThread
+
+issue any pending commands and wait for them to complete, only when the backend
+runs on its own thread. Anything in the front end that touches gl outside of
+the command list must call this first
+============
+*/
+void R_SyncRenderThread( void )
+{
+	if ( !glContext.smpActive ) {
+		return;
+	}
+	R_IssuePendingRenderCommands();
 }
 
 /*
@@ -136,6 +175,8 @@ void RE_AddDrawWorldCmd( void )
 		return;
 	}
 	cmd->commandId = RC_DRAW_WORLDVIEW;
+	cmd->refdef = rg.refdef;
+	cmd->viewData = rg.viewData;
 }
 
 /*
@@ -209,18 +250,13 @@ void R_AddPostProcessCmd( void ) {
 	}
 	cmd->commandId = RC_POSTPROCESS;
 
-	cmd->refdef = backend.refdef;
-	cmd->viewData = glState.viewData;
+	cmd->refdef = rg.refdef;
+	cmd->viewData = rg.viewData;
 }
 
 void RE_BeginFrame( stereoFrame_t stereoFrame )
 {
-	int width, height;
-	unsigned clearBits;
-	int i;
-	char buf[ MAX_CVAR_VALUE ], *v[4];
-	mat4_t matrix;
-	drawBufferCmd_t *cmd = NULL;
+	beginFrameCmd_t *cmd;
 
 	ri.ProfileFunctionBegin( "BeginFrame" );
 
@@ -228,129 +264,28 @@ void RE_BeginFrame( stereoFrame_t stereoFrame )
 		return;
 	}
 
-	if ( glContext.ARB_framebuffer_object && r_arb_framebuffer_object->i && rg.renderFbo.frameBuffer ) {
-		ri.ProfileFunctionBegin( "BindFramebuffer" );
-		GL_BindFramebuffer( GL_FRAMEBUFFER, rg.renderFbo.frameBuffer );
-		ri.ProfileFunctionEnd();
-	}
-
-	if ( glState.currentFbo ) {
-		width = glState.currentFbo->width;
-		height = glState.currentFbo->height;
-	} else {
-		if ( r_fixedRendering->i ) {
-			if ( r_fixedResolutionScale->f == 0.0f ) {
-				width = SCREEN_WIDTH;
-				height = SCREEN_HEIGHT;
-			} else {
-				width = glConfig.vidWidth * r_fixedResolutionScale->f;
-				height = glConfig.vidHeight * r_fixedResolutionScale->f;
-			}
-		} else {
-			width = glConfig.vidWidth;
-			height = glConfig.vidHeight;
-		}
-	}
-
-	clearBits = GL_COLOR_BUFFER_BIT;
-
-	if ( r_glDiagnostics->i ) {
-		if ( !rg.beganQuery ) {
-			nglBeginQuery( GL_TIME_ELAPSED, rg.queries[TIME_QUERY] );
-			nglBeginQuery( GL_SAMPLES_PASSED, rg.queries[SAMPLES_QUERY] );
-			nglBeginQuery( GL_PRIMITIVES_GENERATED, rg.queries[PRIMTIVES_QUERY] );
-		}
-		rg.beganQuery = qtrue;
-	}
-
-	if ( r_measureOverdraw->i ) {
-		clearBits |= GL_STENCIL_BUFFER_BIT;
-	}
-
-	if ( r_clearColor->s ) {
-		// track changes
-		if ( strcmp( r_clearColor->s, glState.clearColorString ) )  {
-			N_strncpyz( glState.clearColorString, r_clearColor->s, sizeof( glState.clearColorString ) );
-			N_strncpyz( buf, r_clearColor->s, sizeof( buf ) );
-			Com_Split( buf, v, 4, ' ' );
-			for ( i = 0; i < 4 ; i++ ) {
-				glState.clearColor[ i ] = N_atof( v[ i ] ) / 255.0f;
-				if ( glState.clearColor[ i ] > 1.0f ) {
-					glState.clearColor[ i ] = 1.0f;
-				} else if ( glState.clearColor[ i ] < 0.0f ) {
-					glState.clearColor[ i ] = 0.0f;
-				}
-			}
-			nglClearColor( glState.clearColor[0], glState.clearColor[1], glState.clearColor[2], glState.clearColor[3] );
-		}
-	}
-
-	// set 2D virtual screen size
-	{
-		ri.ProfileFunctionBegin( "Set GL State" );
-
-		nglViewport( 0, 0, width, height );
-		nglScissor( 0, 0, width, height );
-
-		// clear relevant buffers
-		nglClear( clearBits );
-		nglActiveTexture( GL_TEXTURE0 );
-
-		// setup basic state
-		nglEnable( GL_BLEND );
-		nglEnable( GL_SCISSOR_TEST );
-		nglDisable( GL_STENCIL_TEST );
-		nglDisable( GL_DEPTH_TEST );
-		nglBlendFunc( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA );
-
-		ri.ProfileFunctionEnd();
-	}
-
-	if ( !sys_forceSingleThreading->i ) {
-//		R_IssuePendingRenderCommands();
-	}
-
 	ri.ImGui_NewFrame();
 
 	R_EvictUnusedTextures();
+	R_UploadFinishedImages();
 
 	rg.frameCount++;
 	rg.frameSceneNum = 0;
 
-	glState.finishCalled = qfalse;
-
 	//
-	// do overdraw measurement
+	// do overdraw measurement, the stencil setup happens in RB_BeginFrame
 	//
 	if ( r_measureOverdraw->i ) {
 		if ( glConfig.stencilBits < 4 ) {
 			ri.Printf( PRINT_INFO, "Warning: not enough stencil bits to measure overdraw: %d\n", glConfig.stencilBits );
 			ri.Cvar_Set( "r_measureOverdraw", "0" );
-			r_measureOverdraw->modified = qfalse;
 		}
 		else if ( /* r_shadows->i == 2 */ 0 ) {
 			ri.Printf( PRINT_INFO, "Warning: stencil shadows and overdraw measurement are mutually exclusive\n" );
 			ri.Cvar_Set( "r_measureOverdraw", "0" );
-			r_measureOverdraw->modified = qfalse;
-		}
-		else {
-			R_IssuePendingRenderCommands();
-			nglEnable( GL_STENCIL_TEST );
-			nglStencilMask( ~0U );
-			nglClearStencil( 0U );
-			nglStencilFunc( GL_ALWAYS, 0U, ~0U );
-			nglStencilOp( GL_KEEP, GL_INCR, GL_INCR );
-		}
-		r_measureOverdraw->modified = qfalse;
-	}
-	else {
-		// this is only reached if it was on and is now off
-		if ( r_measureOverdraw->modified ) {
-			R_IssuePendingRenderCommands();
-			nglDisable( GL_STENCIL_TEST );
 		}
-		r_measureOverdraw->modified = qfalse;
 	}
+	r_measureOverdraw->modified = qfalse;
 
 	//
 	// texture filtering
@@ -371,51 +306,27 @@ void RE_BeginFrame( stereoFrame_t stereoFrame )
 		}
 	}
 
-	/*
-	if ( glConfig.stereoEnabled ) {
-		if ( !( cmd = R_GetCommandBuffer( sizeof(*cmd) ) ) )
-			return;
-		
-		cmd->commandId = RC_DRAW_BUFFER;
-
-		if ( stereoFrame == STEREO_LEFT ) {
-			cmd->buffer = GL_BACK_LEFT;
-		}
-		else if ( stereoFrame == STEREO_RIGHT ) {
-			cmd->buffer = GL_BACK_RIGHT;
-		}
-		else {
-			ri.Error( ERR_FATAL, "RE_BeginFrame: Stereo is enabled, but stereoFrame was %i", stereoFrame );
-		}
-	}
-	else {
-		if ( stereoFrame != STEREO_CENTER )
-			ri.Error( ERR_FATAL, "RE_BeginFrame: Stereo is disabled, but stereoFrame was %i", stereoFrame );
-		if ( !( cmd = R_GetCommandBuffer( sizeof(*cmd) ) ) )
-			return;
-		
-		if ( cmd ) {
-			cmd->commandId = RC_DRAW_BUFFER;
-
-			if ( !N_stricmp( r_drawBuffer->s, "GL_FRONT" ) )
-				cmd->buffer = GL_FRONT;
-			else
-				cmd->buffer = GL_BACK;
-		}
+	if ( !glConfig.stereoEnabled && stereoFrame != STEREO_CENTER ) {
+		ri.Error( ERR_FATAL, "RE_BeginFrame: Stereo is disabled, but stereoFrame was %i", stereoFrame );
 	}
-	*/
 
-	backend.refdef.stereoFrame = stereoFrame;
-	backend.refdef.time = ri.Milliseconds();
-	backend.refdef.floatTime = backend.refdef.time * 0.001f;
+	rg.refdef.stereoFrame = stereoFrame;
+	rg.refdef.time = ri.Milliseconds();
+	rg.refdef.floatTime = rg.refdef.time * 0.001f;
 
-	if ( !rg.world ) {
-		RB_SetBatchBuffer( backend.drawBuffer[ backend.cpuBuffer ], backendData[ rg.smpFrame ]->verts, sizeof( srfVert_t ),
-			backendData[ rg.smpFrame ]->indices, sizeof( glIndex_t ) );
+	// the gl state for the frame gets set up by the backend
+	cmd = R_GetCommandBuffer( sizeof( *cmd ) );
+	if ( cmd ) {
+		cmd->commandId = RC_BEGIN_FRAME;
+		cmd->stereoFrame = stereoFrame;
+		cmd->time = rg.refdef.time;
+		cmd->gamePaused = ri.Cvar_VariableInteger( "g_paused" ) != 0;
+		cmd->viewZoom = (float)ri.Cvar_VariableInteger( "sgame_CameraZoom" ) / 0.001f;
 	}
 
 	ri.ProfileFunctionEnd();
 }
+
 /*
 =============
 RE_EndFrame
@@ -433,9 +344,8 @@ void RE_EndFrame( uint64_t *frontEndMsec, uint64_t *backEndMsec, backendCounters
 	}
 	cmd->commandId = RC_SWAP_BUFFERS;
 
-	if ( pc ) {
-		*pc = backend.pc;
-	}
+	// the ui gets built on this thread, the backend draws a snapshot of it
+	cmd->imguiData = ri.ImGui_EndFrame();
 
 	// compute shader
 	if ( NGL_VERSION_ATLEAST( 4, 3 ) ) {
@@ -454,17 +364,119 @@ void RE_EndFrame( uint64_t *frontEndMsec, uint64_t *backEndMsec, backendCounters
 //		ri.ProfileFunctionEnd();
 	}
 
-	backend.drawBatch.shaderTime = backend.refdef.floatTime;
-
 	R_IssueRenderCommands( qtrue, qtrue );
 	R_InitNextFrame();
 
+	if ( pc ) {
+		*pc = rg.pc;
+	}
 	if ( frontEndMsec ) {
 		*frontEndMsec = rg.frontEndMsec;
 	}
 	rg.frontEndMsec = 0;
 	if ( backEndMsec ) {
-		*backEndMsec = backend.pc.msec;
+		*backEndMsec = rg.pc.msec;
+	}
+}
+
+/*
+=============
+R_SmpStress_f
+
+r_smpstress [frames]: pushes frames of synthetic polys through the command lists with
+the backend only walking them. The backend checksums every frame's polys and the front
+end compares that against what it wrote once the slot comes back around, so a build with
+-fsanitize=thread can check the front end/backend split without a gpu in the way
+=============
+*/
+void R_SmpStress_f( void )
+{
+	uint64_t expected[ SMP_FRAMES ];
+	qboolean pending[ SMP_FRAMES ];
+	uint32_t numFrames, frame, mismatches, i, j;
+	uint64_t numPolys, start;
+	renderBackendData_t *data;
+	drawWorldView_t *cmd;
+	srfPoly_t *poly;
+	polyVert_t *vert;
+
+	if ( !rg.registered ) {
+		return;
+	}
+
+	numFrames = 1000;
+	if ( ri.Cmd_Argc() > 1 ) {
+		numFrames = MAX( 1, atoi( ri.Cmd_Argv( 1 ) ) );
 	}
-	backend.pc.msec = 0;
+	numPolys = r_maxPolys->i;
+
+	// finish whatever's queued before the backend stops drawing
+	R_IssuePendingRenderCommands();
+	rg.nullBackend = qtrue;
+
+	memset( expected, 0, sizeof( expected ) );
+	memset( pending, 0, sizeof( pending ) );
+	mismatches = 0;
+
+	start = ri.Milliseconds();
+	for ( frame = 0; frame < numFrames; frame++ ) {
+		data = backendData[ rg.smpFrame ];
+
+		for ( i = 0; i < numPolys; i++ ) {
+			poly = &data->polys[i];
+			vert = &data->polyVerts[ i * 4 ];
+
+			poly->hShader = 0;
+			poly->numVerts = 4;
+			poly->verts = vert;
+
+			for ( j = 0; j < 4; j++ ) {
+				vert[j].xyz[0] = (float)( frame + i );
+				vert[j].xyz[1] = (float)j;
+				vert[j].worldPos[0] = (float)i;
+				vert[j].worldPos[1] = (float)frame;
+				vert[j].uv[0] = (float)( j & 1 );
+				vert[j].uv[1] = (float)( j >> 1 );
+				vert[j].modulate.u32 = frame ^ i;
+			}
+		}
+		data->frameChecksum = 0;
+		expected[ rg.smpFrame ] = R_ChecksumPolys( data->polys, numPolys );
+		pending[ rg.smpFrame ] = qtrue;
+
+		rg.refdef.polys = data->polys;
+		rg.refdef.numPolys = numPolys;
+
+		cmd = R_GetCommandBuffer( sizeof( *cmd ) );
+		if ( cmd ) {
+			cmd->commandId = RC_DRAW_WORLDVIEW;
+			cmd->refdef = rg.refdef;
+			cmd->viewData = rg.viewData;
+		}
+
+		R_IssueRenderCommands( qfalse, qtrue );
+		R_InitNextFrame();
+
+		// the backend is done with the slot we're about to fill, it waited on it before taking the last frame
+		if ( pending[ rg.smpFrame ] ) {
+			if ( backendData[ rg.smpFrame ]->frameChecksum != expected[ rg.smpFrame ] ) {
+				mismatches++;
+			}
+			pending[ rg.smpFrame ] = qfalse;
+		}
+	}
+
+	R_IssuePendingRenderCommands();
+	for ( i = 0; i < SMP_FRAMES; i++ ) {
+		if ( pending[i] && backendData[i]->frameChecksum != expected[i] ) {
+			mismatches++;
+		}
+	}
+
+	rg.refdef.polys = NULL;
+	rg.refdef.numPolys = 0;
+	rg.nullBackend = qfalse;
+
+	ri.Printf( PRINT_INFO, "r_smpstress: %u frames of %lu polys in %lu msec, %u checksum mismatches (%s backend)\n",
+		numFrames, numPolys, ri.Milliseconds() - start, mismatches, glContext.smpActive ? "threaded" : "synchronous" );
 }
@@ -12,6 +12,12 @@ void R_DrawElements( uint32_t numElements, uintptr_t nOffset ) {
 	}
 }
 
+void R_DrawWorldChunk( const worldChunk_t *chunk ) {
+	backend.pc.c_drawCalls++;
+
+	nglDrawElementsBaseVertex( GL_TRIANGLES, chunk->numTiles * 6, GLN_INDEX_TYPE, NULL, chunk->firstVertex );
+}
+
 /*
 =================
 R_BindAnimatedImageToTMU
@@ -467,7 +473,7 @@ void RB_DrawShaderStages( nhandle_t hShader, uint32_t nElems, uint32_t type, con
 
 		GLSL_SetUniformInt( sp, UNIFORM_COLORGEN, stageP->rgbGen );
 		GLSL_SetUniformInt( sp, UNIFORM_ALPHAGEN, stageP->alphaGen );
-		GLSL_SetUniformInt( sp, UNIFORM_GAMEPAUSED, ri.Cvar_VariableInteger( "g_paused" ) );
+		GLSL_SetUniformInt( sp, UNIFORM_GAMEPAUSED, backend.gamePaused );
 		GLSL_SetUniformFloat( sp, UNIFORM_SHARPENING, r_imageSharpenAmount->f );
 		GLSL_SetUniformInt( sp, UNIFORM_ANTIALIASING, r_multisampleType->i );
 		GLSL_SetUniformInt( sp, UNIFORM_POSTPROCESS, r_postProcess->i );
@@ -603,7 +609,11 @@ static void RB_StageIteratorGeneric( shader_t *shader )
 		GLSL_UseProgram( sp );
 
 		GLSL_SetUniformInt( sp, UNIFORM_NUM_LIGHTS, numLights );
-		GLSL_SetUniformMatrix4( sp, UNIFORM_MODELVIEWPROJECTION, glState.viewData.camera.viewProjectionMatrix );
+		if ( sp == &rg.tileShader ) {
+			GLSL_SetUniformMatrix4( sp, UNIFORM_MODELVIEWPROJECTION, rg.world->modelViewProjection );
+		} else {
+			GLSL_SetUniformMatrix4( sp, UNIFORM_MODELVIEWPROJECTION, glState.viewData.camera.viewProjectionMatrix );
+		}
 
 		GLSL_SetUniformInt( sp, UNIFORM_DEFORMGEN, deformGen );
 
@@ -647,7 +657,7 @@ static void RB_StageIteratorGeneric( shader_t *shader )
 			}
 		}
 
-		GLSL_SetUniformFloat( sp, UNIFORM_VIEWZOOM, (float)ri.Cvar_VariableInteger( "sgame_CameraZoom" ) / 0.001f );
+		GLSL_SetUniformFloat( sp, UNIFORM_VIEWZOOM, backend.viewZoom );
 		GLSL_SetUniformVec3( sp, UNIFORM_VIEWORIGIN, glState.viewData.camera.origin );
 
 		{
@@ -664,7 +674,7 @@ static void RB_StageIteratorGeneric( shader_t *shader )
 		GLSL_SetUniformInt( sp, UNIFORM_ALPHAGEN, stageP->alphaGen );
 		GLSL_SetUniformVec4( sp, UNIFORM_NORMAL_SCALE, stageP->normalScale );
 		GLSL_SetUniformVec4( sp, UNIFORM_SPECULAR_SCALE, stageP->specularScale );
-		nglUniform1i( nglGetUniformLocation( sp->programId, "u_GamePaused" ), ri.Cvar_VariableInteger( "g_paused" ) && rg.world );
+		nglUniform1i( nglGetUniformLocation( sp->programId, "u_GamePaused" ), backend.gamePaused && rg.world );
 		GLSL_SetUniformInt( sp, UNIFORM_ANTIALIASING, r_multisampleType->i );
 		GLSL_SetUniformInt( sp, UNIFORM_HARDWAREGAMMA, !r_ignorehwgamma->i );
 		GLSL_SetUniformFloat( sp, UNIFORM_GAMMA, r_gammaAmount->f );
@@ -732,7 +742,13 @@ static void RB_StageIteratorGeneric( shader_t *shader )
 		//
 		// draw
 		//
-		R_DrawElements( backend.drawBatch.idxOffset, backend.drawBatch.buffer->index.offset );
+		if ( sp == &rg.tileShader ) {
+			for ( j = 0; j < rg.world->numVisibleChunks; j++ ) {
+				R_DrawWorldChunk( rg.world->visibleChunks[j] );
+			}
+		} else {
+			R_DrawElements( backend.drawBatch.idxOffset, backend.drawBatch.buffer->index.offset );
+		}
 	}
 
 	if ( r_showTris->i ) {
@@ -828,7 +844,7 @@ void RB_InstantQuad( vec4_t quadVerts[4] )
 
 	GLSL_UseProgram( &rg.textureColorShader );
 
-	RB_MakeViewMatrix();
+	R_MakeViewMatrix( &glState.viewData );
 	GLSL_SetUniformMatrix4( &rg.textureColorShader, UNIFORM_MODELVIEWPROJECTION, glState.viewData.camera.viewProjectionMatrix );
 	GLSL_SetUniformVec4( &rg.textureColorShader, UNIFORM_COLOR, colorWhite );
 
@@ -306,12 +306,12 @@ static void FBO_Init_f( void )
 	rg.numFBOs = 0;
 	multisample = 0;
 
+	R_IssuePendingRenderCommands();
+
 	GL_BindFramebuffer( GL_FRAMEBUFFER, 0 );
 
 	GL_CheckErrors();
 
-	R_IssuePendingRenderCommands();
-
 	width = glConfig.vidWidth;
 	height = glConfig.vidHeight;
 	if ( r_multisampleType->i == AntiAlias_SSAA ) {
@@ -42,6 +42,7 @@ cvar_t *r_norefresh;
 cvar_t *r_drawentities;
 cvar_t *r_drawworld;
 cvar_t *r_speeds;
+cvar_t *r_sortPolys;
 cvar_t *r_detailTextures;
 
 cvar_t *r_cameraExposure;
@@ -155,8 +156,10 @@ cvar_t *r_antialiasQuality;
 cvar_t *r_swapInterval;
 
 cvar_t *r_loadTexturesOnDemand;
+cvar_t *r_asyncTextures;
 
 cvar_t *sys_forceSingleThreading;
+cvar_t *r_smp;
 
 // OpenGL extensions
 cvar_t *r_arb_texture_compression;
@@ -453,7 +456,7 @@ RB_TakeScreenshotCmd
 void RB_TakeScreenshotCmd( void ) {
 	const screenshotCommand_t *cmd;
 	
-	cmd = (const screenshotCommand_t *)&backendData[ rg.smpFrame ]->screenshotBuf;
+	cmd = (const screenshotCommand_t *)&backendData[ backend.smpFrame ]->screenshotBuf;
 
 	if ( cmd->jpeg ) {
 		RB_TakeScreenshotJPEG( cmd->x, cmd->y, cmd->width, cmd->height, cmd->fileName);
@@ -863,11 +866,18 @@ static void R_Register( void )
 
 	sys_forceSingleThreading = ri.Cvar_Get( "sys_forceSingleThreading", "0", CVAR_LATCH | CVAR_SAVE );
 
+	r_smp = ri.Cvar_Get( "r_smp", "0", CVAR_LATCH | CVAR_SAVE );
+	ri.Cvar_SetDescription( r_smp, "Runs the rendering backend on its own thread, the next frame gets built while the last one is drawn.\n"
+		"Does nothing with sys_forceSingleThreading." );
+
 	r_bloom = ri.Cvar_Get( "r_bloom", "1", CVAR_SAVE );
 	ri.Cvar_SetDescription( r_bloom, "Enables framebuffer based bloom to make light sources stand out, requires \\r_hdr." );
 
 	r_loadTexturesOnDemand = ri.Cvar_Get( "r_loadTexturesOnDemand", "1", CVAR_LATCH | CVAR_SAVE );
 	ri.Cvar_SetDescription( r_loadTexturesOnDemand, "Enables loading textures on demand, requires GL_ARB_bindless_textures\n" );
+	r_asyncTextures = ri.Cvar_Get( "r_asyncTextures", "1", CVAR_SAVE );
+	ri.Cvar_SetDescription( r_asyncTextures, "Decodes images and builds their mipmaps on worker threads, the default image is drawn in their "
+		"place until they're uploaded.\nDoes nothing with sys_forceSingleThreading." );
 
 	r_normalMapping = ri.Cvar_Get( "r_normalMapping", "1", CVAR_SAVE | CVAR_LATCH );
 	ri.Cvar_SetDescription( r_normalMapping, "Enable normal maps for materials that support it." );
@@ -1029,6 +1039,9 @@ static void R_Register( void )
 							"1: Backend drawing\n"
 							"2: Lighting\n"
 							"3: OpenGL state changes" );
+	r_sortPolys = ri.Cvar_Get( "r_sortPolys", "1", CVAR_SAVE );
+	ri.Cvar_SetDescription( r_sortPolys, "Sorts the scene's polys by layer, blend mode, shader and texture before drawing so "
+							"polys sharing a material are drawn together, 0 draws them in submission order." );
 
 	//
 	// temporary variables that can change at any time
@@ -1085,6 +1098,11 @@ static void R_Register( void )
 	ri.Cmd_AddCommand( "screenshotJPEG", R_ScreenShotJPEG_f );
 	ri.Cmd_AddCommand( "gpuinfo", GpuInfo_f );
 	ri.Cmd_AddCommand( "gpumeminfo", GpuMemInfo_f );
+	ri.Cmd_AddCommand( "r_worldbench", R_WorldBench_f );
+	ri.Cmd_AddCommand( "r_quadbench", R_QuadBench_f );
+	ri.Cmd_AddCommand( "r_smpstress", R_SmpStress_f );
+	ri.Cmd_AddCommand( "r_polysortbench", R_PolySortBench_f );
+	ri.Cmd_AddCommand( "r_imagebench", R_ImageBench_f );
 }
 
 static void R_InitGLContext( void )
@@ -1334,21 +1352,28 @@ static void R_AllocBackend( void ) {
 	backendData[ 0 ]->polyVerts = (polyVert_t *)( backendData[ 0 ]->verts + r_maxPolys->i * 4 );
 	backendData[ 0 ]->polys = (srfPoly_t *)( backendData[ 0 ]->polyVerts + r_maxPolys->i * 4 );
 //	backendData[ 0 ]->indices = (glIndex_t *)( backendData[ 0 ]->polys + r_maxPolys->i );
-	backendData[ 0 ]->entities = (renderEntityDef_t *)( backendData[ 0 ]->polys + r_maxPolys->i * 6 );
+	backendData[ 0 ]->entities = (renderEntityDef_t *)( backendData[ 0 ]->polys + r_maxPolys->i );
 	backendData[ 0 ]->dlights = (dlight_t *)( backendData[ 0 ]->entities + r_maxEntities->i );
 
 	if ( !sys_forceSingleThreading->i ) {
 		backendData[ 1 ] = (renderBackendData_t *)ri.Malloc( size );
+		memset( backendData[ 1 ], 0, sizeof( *backendData[ 1 ] ) );
 //		backendData[ 1 ]->verts = (srfVert_t *)( backendData[ 1 ] + 1 );
 		backendData[ 1 ]->polyVerts = (polyVert_t *)( backendData[ 1 ] + 1 );
 		backendData[ 1 ]->polys = (srfPoly_t *)( backendData[ 1 ]->polyVerts + r_maxPolys->i * 4 );
 //		backendData[ 1 ]->indices = (glIndex_t *)( backendData[ 1 ]->polys + r_maxPolys->i );
-		backendData[ 1 ]->entities = (renderEntityDef_t *)( backendData[ 1 ]->polys + r_maxPolys->i * 6 );
+		backendData[ 1 ]->entities = (renderEntityDef_t *)( backendData[ 1 ]->polys + r_maxPolys->i );
 		backendData[ 1 ]->dlights = (dlight_t *)( backendData[ 1 ]->entities + r_maxEntities->i );
 	} else {
 		backendData[ 1 ] = NULL;
 	}
 
+	// sort keys and the order they put the polys in, [1] is the radix sort's scratch space
+	for ( i = 0; i < 2; i++ ) {
+		backend.polyKeys[i] = (uint64_t *)ri.Hunk_Alloc( sizeof( *backend.polyKeys[i] ) * r_maxPolys->i, h_low );
+		backend.polyOrder[i] = (uint32_t *)ri.Hunk_Alloc( sizeof( *backend.polyOrder[i] ) * r_maxPolys->i, h_low );
+	}
+
 	ri.Printf( PRINT_DEVELOPER,
 		COLOR_CYAN "---------- Renderer Backend Allocation Info ----------\n"
 		COLOR_CYAN "%-10lu Bytes : %-8.04lf KiB : %-4.04lf MiB allocated to renderer backend\n"
@@ -1371,16 +1396,16 @@ static void R_AllocBackend( void ) {
 static void R_CameraInfo_f( void ) {
 	ri.Printf( PRINT_INFO, "\n---------- Camera Info ----------\n" );
 	ri.Printf( PRINT_INFO, "** Matrix Dump: Projection Matrix **\n" );
-	Mat4Dump( glState.viewData.camera.projectionMatrix );
+	Mat4Dump( rg.viewData.camera.projectionMatrix );
 	ri.Printf( PRINT_INFO, "** Matrix Dump: View Matrix **\n" );
-	Mat4Dump( glState.viewData.camera.viewMatrix );
+	Mat4Dump( rg.viewData.camera.viewMatrix );
 	ri.Printf( PRINT_INFO, "** Matrix Dump: View Projection Matrix **\n" );
-	Mat4Dump( glState.viewData.camera.viewProjectionMatrix );
+	Mat4Dump( rg.viewData.camera.viewProjectionMatrix );
 
 	ri.Printf( PRINT_INFO, "\n" );
-	ri.Printf( PRINT_INFO, "Origin: %f, %f\n", glState.viewData.camera.origin[0], glState.viewData.camera.origin[1] );
-	ri.Printf( PRINT_INFO, "Zoom: %f\n", glState.viewData.camera.zoom );
-	ri.Printf( PRINT_INFO, "Aspect: %f\n", glState.viewData.camera.aspect );
+	ri.Printf( PRINT_INFO, "Origin: %f, %f\n", rg.viewData.camera.origin[0], rg.viewData.camera.origin[1] );
+	ri.Printf( PRINT_INFO, "Zoom: %f\n", rg.viewData.camera.zoom );
+	ri.Printf( PRINT_INFO, "Aspect: %f\n", rg.viewData.camera.aspect );
 }
 
 static void R_InitSamplers( void )
@@ -1412,6 +1437,7 @@ void R_Init( void )
 	memset( &backend, 0, sizeof( backend ) );
 	
 	glState.viewData.camera.zoom = 1.0f;
+	rg.viewData.camera.zoom = 1.0f;
 	screenshotFrame = qfalse;
 
 	//
@@ -1471,6 +1497,19 @@ void R_Init( void )
 	// print info
 	GpuInfo_f();
 	GpuMemInfo_f();
+
+	// the render thread takes the context from here on, anything above needed it on this one
+	glContext.smpActive = qfalse;
+	if ( r_smp->i && !sys_forceSingleThreading->i ) {
+		ri.Printf( PRINT_INFO, "Trying SMP acceleration...\n" );
+		if ( ri.GLimp_SpawnRenderThread( RB_RenderThread ) ) {
+			ri.Printf( PRINT_INFO, "...succeeded.\n" );
+			glContext.smpActive = qtrue;
+		} else {
+			ri.Printf( PRINT_INFO, "...failed.\n" );
+		}
+	}
+
 	ri.Printf( PRINT_INFO, "---------- finished RE_Init ----------\n" );
 }
 
@@ -1485,11 +1524,23 @@ void RE_Shutdown( refShutdownCode_t code )
 {
 	ri.Printf( PRINT_INFO, "RE_Shutdown( %i )\n", code );
 
+	if ( glContext.smpActive ) {
+		// let the render thread finish its frame, then take the context back for good
+		ri.GLimp_FrontEndSleep();
+		ri.GLimp_ShutdownRenderThread();
+		glContext.smpActive = qfalse;
+	}
+
 	ri.Cmd_RemoveCommand( "texturelist" );
 	ri.Cmd_RemoveCommand( "shaderlist" );
 	ri.Cmd_RemoveCommand( "screenshot" );
 	ri.Cmd_RemoveCommand( "gpuinfo" );
 	ri.Cmd_RemoveCommand( "gpumeminfo" );
+	ri.Cmd_RemoveCommand( "r_worldbench" );
+	ri.Cmd_RemoveCommand( "r_quadbench" );
+	ri.Cmd_RemoveCommand( "r_smpstress" );
+	ri.Cmd_RemoveCommand( "r_polysortbench" );
+	ri.Cmd_RemoveCommand( "r_imagebench" );
 	ri.Cmd_RemoveCommand( "camerainfo" );
 	ri.Cmd_RemoveCommand( "unloadworld" );
 	ri.Cmd_RemoveCommand( "fbo_restart" );
@@ -1529,6 +1580,9 @@ RE_EndRegistration
 */
 void RE_EndRegistration( void ) {
 	R_IssuePendingRenderCommands();
+
+	// everything registered during the load gets uploaded before the first frame
+	R_FinishImages();
 }
 
 void RE_GetConfig( gpuConfig_t *config ) {
@@ -1536,9 +1590,9 @@ void RE_GetConfig( gpuConfig_t *config ) {
 }
 
 void RE_GetGPUFrameStats( uint32_t *time, uint32_t *samples, uint32_t *primitives ) {
-	*time = rg.queryCounts[TIME_QUERY];
-	*samples = rg.queryCounts[SAMPLES_QUERY];
-	*primitives = rg.queryCounts[PRIMTIVES_QUERY];
+	*time = rg.frameQueryCounts[TIME_QUERY];
+	*samples = rg.frameQueryCounts[SAMPLES_QUERY];
+	*primitives = rg.frameQueryCounts[PRIMTIVES_QUERY];
 }
 
 void *RE_GetImGuiTextureData( nhandle_t hShader )
@@ -1551,6 +1605,9 @@ void *RE_GetImGuiTextureData( nhandle_t hShader )
 		return NULL;
 	}
 
+	// imgui holds onto the id, so it can't be the placeholder's
+	R_FinishImage( shader->stages[0]->bundle[0].image[0] );
+
 	return (void *)(intptr_t)shader->stages[0]->bundle[0].image[0]->id;
 }
 
@@ -1602,6 +1659,7 @@ GDR_EXPORT renderExport_t *GDR_DECL GetRenderAPI( uint32_t version, refimport_t
 	re.RegisterShader = RE_RegisterShader;
 
 	re.LoadWorld = RE_LoadWorldMap;
+	re.SetWorldTile = RE_SetWorldTile;
 	re.EndRegistration = RE_EndRegistration;
 	
 	re.AddDynamicLightToScene = RE_AddDynamicLightToScene;
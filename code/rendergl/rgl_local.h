@@ -235,6 +235,10 @@ typedef struct texture_s
 	GLint internalFormat;
 	imgType_t type;
 	imgFlags_t flags;
+
+	uint32_t numMips;           // mip levels in data, 0 or 1 has the driver generate them
+	qboolean pending;           // still being decoded on a worker thread
+	qboolean placeholder;       // drawing with the default image's id until the real one's uploaded
 } texture_t;
 
 #include "rgl_fbo.h"
@@ -962,6 +966,23 @@ typedef int16_t bitangent_t[4];
 typedef int16_t normal_t[4];
 typedef vec2_t texCoord_t;
 
+// the world is baked into chunks of WORLD_CHUNK_SIZE x WORLD_CHUNK_SIZE tiles at load, each one
+// drawn with a base vertex so every chunk can share the same indices
+#define WORLD_CHUNK_SIZE 32
+#define WORLD_CHUNK_TILES ( WORLD_CHUNK_SIZE * WORLD_CHUNK_SIZE )
+
+typedef struct {
+	bbox_t bounds; // in world space
+
+	uint32_t firstVertex;
+	uint32_t numTiles;
+
+	uint16_t x, y; // first tile
+	uint16_t width, height;
+
+	qboolean dirty;
+} worldChunk_t;
+
 typedef struct {
 	char baseName[MAX_NPATH];
 	char name[MAX_NPATH];
@@ -979,20 +1000,33 @@ typedef struct {
 	maptile_t *tiles;
 	uint32_t numTiles;
 
-	glIndex_t *indices;
-	uint16_t numIndices;
+	glIndex_t *indices; // one chunk's worth
+	uint32_t numIndices;
 
 	worldPos_t *worldPos;
 	vec2_t *xyz;
 	texCoord_t *uv;
 	color4ub_t *color;
 	drawVert_t *vertices;
-	uint16_t numVertices;
+	uint32_t numVertices;
+
+	worldChunk_t *chunks;
+	uint32_t numChunks;
+	uint32_t chunksWide;
+	uint32_t chunksHigh;
+
+	spriteCoord_t *sprites; // tileset texture coordinates, kept for re-baking
+	uint32_t numSprites;
 
 	// frame based draw data
 	vertexBuffer_t *buffer;
 	shader_t *shader;
 	nhandle_t tileset;
+
+	worldChunk_t **visibleChunks;
+	uint32_t numVisibleChunks;
+	uint32_t numDirtyChunks;
+	mat4_t modelViewProjection;
 } world_t;
 
 
@@ -1056,9 +1090,17 @@ typedef struct {
 
 	batch_t drawBatch;
 
+	// R_DrawPolys sort keys, the second of each is the radix sort's scratch
+	uint64_t *polyKeys[2];
+	uint32_t *polyOrder[2];
+
 	int smpFrame;
 	int gpuBuffer;
 	int cpuBuffer;
+
+	// game cvars the draw code needs for every stage, copied once a frame in RB_BeginFrame
+	qboolean gamePaused;
+	float viewZoom;
 } renderBackend_t;
 
 // the renderer front end should never modify glstate_t
@@ -1207,6 +1249,16 @@ typedef struct
 
 	uint64_t frontEndMsec;
 
+	// the front end's copy of the scene and view, the backend gets its own through the command list
+	renderSceneDef_t refdef;
+	viewData_t viewData;
+
+	// backend stats copied out while the backend is idle
+	backendCounters_t pc;
+	uint32_t frameQueryCounts[NUMQUERIES];
+
+	qboolean nullBackend; // set by r_smpstress, the backend only walks the command lists
+
 	uint32_t numLightmaps;
 	texture_t **lightmaps;
 
@@ -1319,6 +1371,7 @@ extern cvar_t *r_norefresh;			    // bypasses the ref rendering
 extern cvar_t *r_drawentities;		    // disable/enable entity rendering
 extern cvar_t *r_drawworld;			    // disable/enable world rendering
 extern cvar_t *r_speeds;				// various levels of information display
+extern cvar_t *r_sortPolys;				// sort submitted polys by material before drawing them
 extern cvar_t *r_detailTextures;		// enables/disables detail texturing stages
 
 extern cvar_t *r_cameraExposure;
@@ -1428,10 +1481,12 @@ extern cvar_t *r_lightingQuality;
 extern cvar_t *r_antialiasQuality;
 
 extern cvar_t *r_loadTexturesOnDemand;
+extern cvar_t *r_asyncTextures;
 
 extern cvar_t *r_swapInterval;
 
 extern cvar_t *sys_forceSingleThreading;
+extern cvar_t *r_smp;
 
 // OpenGL extensions
 extern cvar_t *r_arb_texture_compression;
@@ -1558,6 +1613,31 @@ int32_t NextPowerOfTwo(int32_t in);
 uint16_t FloatToHalf( float in );
 float HalfToFloat( uint16_t in );
 void Mat4Identity( mat4_t out );
+void Mat4Copy( const mat4_t in, mat4_t out );
+void Mat4Multiply( const mat4_t in1, const mat4_t in2, mat4_t out );
+void Mat4Transform( const mat4_t in1, const vec4_t in2, vec4_t out );
+
+//
+// rgl_transform.c
+//
+
+#define QUAD_BATCH 4
+
+// QUAD_BATCH quads in SoA form, one simd lane per quad
+typedef struct {
+	float x[ QUAD_BATCH ];
+	float y[ QUAD_BATCH ];
+	float scaleX[ QUAD_BATCH ];
+	float scaleY[ QUAD_BATCH ];
+	float cosine[ QUAD_BATCH ];
+	float sine[ QUAD_BATCH ];
+} quadInput_t;
+
+void R_SetQuadInput( quadInput_t *in, uint32_t index, const vec3_t origin, const vec2_t scale, float rotation );
+void R_TransformQuads( const quadInput_t *in, polyVert_t *out, uint32_t count, const mat4_t viewProj );
+void R_TransformQuadsScalar( const quadInput_t *in, polyVert_t *out, uint32_t count, const mat4_t viewProj );
+const char *R_QuadTransformPath( void );
+void R_QuadBench_f( void );
 
 //
 // rgl_texture.c
@@ -1573,6 +1653,10 @@ texture_t *R_CreateImage(  const char *name, byte *pic, int width, int height, i
 qboolean R_ClearTextureCache( void );
 void R_TouchTexture( texture_t *image );
 void R_EvictUnusedTextures( void );
+void R_UploadFinishedImages( void );
+void R_FinishImage( texture_t *image );
+void R_FinishImages( void );
+void R_ImageBench_f( void );
 
 extern int gl_filter_min, gl_filter_max;
 
@@ -1602,7 +1686,7 @@ void R_ApplyLighting( const dlight_t *dl, shaderLight_t *gpuLight );
 // rgl_main.c
 //
 qboolean R_ClipTile( const vec3_t origin );
-void RB_MakeViewMatrix( void );
+void R_MakeViewMatrix( viewData_t *viewData );
 void R_RenderView( const viewData_t *parms );
 void GL_CameraResize(void);
 qboolean R_HasExtension(const char *ext);
@@ -1614,6 +1698,21 @@ void R_WorldToGL( drawVert_t *verts, vec3_t pos );
 qboolean R_CalcTangentVectors(drawVert_t dv[3]);
 void R_DrawPolys( void );
 void R_DrawWorld( void );
+uint32_t R_CullWorldChunks( worldChunk_t *chunks, uint32_t numChunks, const mat4_t mvp, worldChunk_t **visible );
+
+// every poly R_DrawPolys draws gets a 64-bit key, most significant field first
+#define POLYSORT_LAYER_SHIFT		60	// shader_t::sort
+#define POLYSORT_BLEND_SHIFT		52	// GLS_BLEND_BITS of the first stage
+#define POLYSORT_PROGRAM_SHIFT		42
+#define POLYSORT_SHADER_SHIFT		32	// shader_t::index
+#define POLYSORT_TEXTURE_SHIFT		22
+#define POLYSORT_DEPTH_BITS			22	// submission order, the painter's depth in an orthographic scene
+#define POLYSORT_MATERIAL_MASK		( ~0ULL << POLYSORT_DEPTH_BITS )
+
+uint64_t R_MakePolySortKey( uint32_t layer, uint32_t blend, uint32_t program, uint32_t shader, uint32_t texture, uint32_t depth );
+uint64_t R_PolySortKey( const shader_t *shader, uint32_t depth );
+void R_RadixSortPolys( uint64_t *keys, uint32_t *order, uint64_t *scratchKeys, uint32_t *scratchOrder, uint32_t numPolys );
+void R_PolySortBench_f( void );
 
 //
 // rgl_scene.c
@@ -1649,6 +1748,7 @@ void R_UnloadLevelShaders( void );
 // rgl_draw.c
 //
 void R_DrawElements( uint32_t numElements, uintptr_t nOffset );
+void R_DrawWorldChunk( const worldChunk_t *chunk );
 void R_DrawPolys( void );
 void RB_IterateShaderStages( shader_t *shader );
 void RB_InstantQuad(vec4_t quadVerts[4]);
@@ -1778,12 +1878,15 @@ typedef enum
 	RC_DRAW_WORLDVIEW,
 
 	RC_BLUR_PASS,
+	RC_BEGIN_FRAME,
 
 	RC_END_OF_LIST
 } renderCmdType_t;
 
 typedef struct {
 	renderCmdType_t commandId;
+	viewData_t viewData;
+	renderSceneDef_t refdef;
 } drawWorldView_t;
 
 typedef struct {
@@ -1802,8 +1905,17 @@ typedef struct {
 
 typedef struct {
 	renderCmdType_t commandId;
+	void *imguiData; // this frame's ui, see ri.ImGui_EndFrame
 } swapBuffersCmd_t;
 
+typedef struct {
+	renderCmdType_t commandId;
+	stereoFrame_t stereoFrame;
+	int64_t time;
+	qboolean gamePaused;
+	float viewZoom;
+} beginFrameCmd_t;
+
 typedef struct {
 	renderCmdType_t commandId;
 } blurPassCmd_t;
@@ -1854,6 +1966,8 @@ typedef struct {
 	uint64_t numIndices;
 
 	screenshotCommand_t screenshotBuf;
+
+	uint64_t frameChecksum; // only written by the null backend, see r_smpstress
 } renderBackendData_t;
 
 extern qboolean screenshotFrame;
@@ -1865,13 +1979,20 @@ extern volatile qboolean renderThreadActive;
 void RB_RenderPass( void );
 
 void RB_RenderThread( void );
+uint64_t R_ChecksumPolys( const srfPoly_t *polys, uint64_t numPolys );
+void R_SmpStress_f( void );
 void R_InitCommandBuffers( void );
 void R_ShutdownCommandBuffers( void );
 
 void RE_DrawImage( float x, float y, float w, float h, float u1, float v1, float u2, float v2, nhandle_t hShader );
 void RE_LoadWorldMap( const char *filename );
+void RE_SetWorldTile( uint32_t x, uint32_t y, int32_t index );
+uint32_t R_BuildWorldChunks( worldChunk_t *chunks, uint32_t width, uint32_t height );
+uint64_t R_RebakeWorldChunks( void );
+void R_WorldBench_f( void );
 void RE_SetColor( const float *rgba );
 void R_IssuePendingRenderCommands( void );
+void R_SyncRenderThread( void );
 void RE_AddDrawWorldCmd( void );
 
 void RB_TakeScreenshot( int x, int y, int width, int height, const char *fileName );
@@ -26,7 +26,7 @@ void GDR_DECL Con_Printf( const char *fmt, ... )
 	ri.Printf( PRINT_INFO, "%s", msg );
 }
 
-void RB_MakeViewMatrix( void )
+void R_MakeViewMatrix( viewData_t *viewData )
 {
 	float aspect;
 	uint32_t viewFlags;
@@ -34,9 +34,9 @@ void RB_MakeViewMatrix( void )
 
 	aspect = glConfig.vidWidth / glConfig.vidHeight;
 
-	glState.viewData.zFar = -1.0f;
-	glState.viewData.zNear = 1.0f;
-	viewFlags = glState.viewData.flags & RSF_ORTHO_BITS;
+	viewData->zFar = -1.0f;
+	viewData->zNear = 1.0f;
+	viewFlags = viewData->flags & RSF_ORTHO_BITS;
 
 	switch ( viewFlags ) {
 	case RSF_ORTHO_TYPE_SCREENSPACE:
@@ -45,7 +45,7 @@ void RB_MakeViewMatrix( void )
 		ortho[2] = glConfig.vidHeight;
 		ortho[3] = 0;
 
-		VectorClear( glState.viewData.camera.origin );
+		VectorClear( viewData->camera.origin );
 		break;
 	case RSF_ORTHO_TYPE_WORLD:
 		ortho[0] = 0.0f;
@@ -63,64 +63,249 @@ void RB_MakeViewMatrix( void )
 		ri.Error( ERR_DROP, "R_RenderView: invalid orthographic matrix type" );
 	};
 
-	ri.GLM_MakeVPM( ortho, &glState.viewData.camera.zoom, glState.viewData.zNear, glState.viewData.zFar, glState.viewData.camera.origin,
-		glState.viewData.camera.viewProjectionMatrix, glState.viewData.camera.projectionMatrix, glState.viewData.camera.viewMatrix,
+	ri.GLM_MakeVPM( ortho, &viewData->camera.zoom, viewData->zNear, viewData->zFar, viewData->camera.origin,
+		viewData->camera.viewProjectionMatrix, viewData->camera.projectionMatrix, viewData->camera.viewMatrix,
 		viewFlags );
 }
 
 /*
-===============
-R_Radix
-===============
+* R_MakePolySortKey: packs the fields into a key that sorts by layer, then blend mode, program, shader, texture
+* and finally depth. Fields wider than their slot get masked so they can't bleed into the one above
 */
-static GDR_INLINE void R_Radix( int32_t byte, uint32_t size, const srfPoly_t *source, srfPoly_t *dest )
+uint64_t R_MakePolySortKey( uint32_t layer, uint32_t blend, uint32_t program, uint32_t shader, uint32_t texture, uint32_t depth )
 {
-	uint32_t       count[ 256 ] = { 0 };
-	uint32_t       index[ 256 ];
-	uint32_t       i;
-	uint8_t        *sortKey;
-	uint8_t        *end;
+	return ( (uint64_t)( layer & 0xf ) << POLYSORT_LAYER_SHIFT )
+		| ( (uint64_t)( blend & 0xff ) << POLYSORT_BLEND_SHIFT )
+		| ( (uint64_t)( program & 0x3ff ) << POLYSORT_PROGRAM_SHIFT )
+		| ( (uint64_t)( shader & 0x3ff ) << POLYSORT_SHADER_SHIFT )
+		| ( (uint64_t)( texture & 0x3ff ) << POLYSORT_TEXTURE_SHIFT )
+		| (uint64_t)MIN( depth, ( 1U << POLYSORT_DEPTH_BITS ) - 1 );
+}
 
-	sortKey = ( (uint8_t *)&source[ 0 ].hShader ) + byte;
-	end = sortKey + ( size * sizeof( srfPoly_t ) );
-	for ( ; sortKey < end; sortKey += sizeof( srfPoly_t ) ) {
-		++count[ *sortKey ];
+uint64_t R_PolySortKey( const shader_t *shader, uint32_t depth )
+{
+	const shaderStage_t *stage;
+	uint32_t blend, program, texture;
+
+	blend = 0;
+	program = 0;
+	texture = 0;
+
+	stage = shader->stages[0];
+	if ( stage ) {
+		blend = stage->stateBits & GLS_BLEND_BITS;
+		if ( stage->glslShaderGroup ) {
+			program = stage->glslShaderGroup->programId;
+		}
+		if ( stage->bundle[0].image[0] ) {
+			texture = stage->bundle[0].image[0]->id;
+		}
 	}
 
-	index[ 0 ] = 0;
+	return R_MakePolySortKey( shader->sort, blend, program, shader->index, texture, depth );
+}
+
+/*
+* R_RadixSortPolys: stable lsd radix sort of keys with order carried along, one byte per pass. All eight
+* histograms come out of one read of the keys and any byte that's the same in every key skips its pass,
+* a frame's polys usually only differ in a few of them. The result ends up back in keys and order
+*/
+void R_RadixSortPolys( uint64_t *keys, uint32_t *order, uint64_t *scratchKeys, uint32_t *scratchOrder, uint32_t numPolys )
+{
+	uint32_t count[ 8 ][ 256 ];
+	uint32_t offset[ 256 ];
+	uint64_t *srcKeys, *dstKeys, *tmpKeys;
+	uint32_t *srcOrder, *dstOrder, *tmpOrder;
+	uint32_t i, pass, shift, digit, sum;
 
-	for ( i = 1; i < 256; ++i ) {
-		index[ i ] = index[ i - 1 ] + count[ i - 1 ];
+	if ( numPolys < 2 ) {
+		return;
 	}
 
-	sortKey = ( (uint8_t *)&source[ 0 ].hShader ) + byte;
-	for ( i = 0; i < size; ++i, sortKey += sizeof( srfPoly_t ) ) {
-		dest[ index[ *sortKey ]++ ] = source[ i ];
+	memset( count, 0, sizeof( count ) );
+	for ( i = 0; i < numPolys; i++ ) {
+		for ( pass = 0; pass < 8; pass++ ) {
+			count[ pass ][ ( keys[i] >> ( pass * 8 ) ) & 0xff ]++;
+		}
+	}
+
+	srcKeys = keys;
+	srcOrder = order;
+	dstKeys = scratchKeys;
+	dstOrder = scratchOrder;
+
+	for ( pass = 0; pass < 8; pass++ ) {
+		shift = pass * 8;
+		if ( count[ pass ][ ( srcKeys[0] >> shift ) & 0xff ] == numPolys ) {
+			continue;
+		}
+
+		sum = 0;
+		for ( digit = 0; digit < 256; digit++ ) {
+			offset[ digit ] = sum;
+			sum += count[ pass ][ digit ];
+		}
+
+		for ( i = 0; i < numPolys; i++ ) {
+			digit = ( srcKeys[i] >> shift ) & 0xff;
+			dstKeys[ offset[ digit ] ] = srcKeys[i];
+			dstOrder[ offset[ digit ] ] = srcOrder[i];
+			offset[ digit ]++;
+		}
+
+		tmpKeys = srcKeys;
+		srcKeys = dstKeys;
+		dstKeys = tmpKeys;
+
+		tmpOrder = srcOrder;
+		srcOrder = dstOrder;
+		dstOrder = tmpOrder;
+	}
+
+	if ( srcKeys != keys ) {
+		memcpy( keys, srcKeys, sizeof( *keys ) * numPolys );
+		memcpy( order, srcOrder, sizeof( *order ) * numPolys );
 	}
 }
 
+static int R_ComparePolySortKeys( const void *a, const void *b )
+{
+	const uint64_t k1 = *(const uint64_t *)a;
+	const uint64_t k2 = *(const uint64_t *)b;
+	return k1 < k2 ? -1 : ( k1 > k2 ? 1 : 0 );
+}
 
-/*
-===============
-R_RadixSort
+static uint32_t R_CountPolySortBatches( const uint64_t *keys, uint32_t numPolys )
+{
+	uint32_t i, numBatches;
 
-Radix sort with 4 byte size buckets
-===============
+	numBatches = numPolys ? 1 : 0;
+	for ( i = 1; i < numPolys; i++ ) {
+		if ( ( keys[i] & POLYSORT_MATERIAL_MASK ) != ( keys[i - 1] & POLYSORT_MATERIAL_MASK ) ) {
+			numBatches++;
+		}
+	}
+	return numBatches;
+}
+
+/*
+* R_PolySortBench_f: r_polysortbench [polys] [iterations], checks the key layout against a few fixed cases and
+* that the radix sort is a stable permutation matching qsort on a seeded set of keys, then times both and
+* shows how many material switches the sort saves
 */
-static void R_RadixSort( srfPoly_t *source, uint32_t size )
+void R_PolySortBench_f( void )
 {
-	srfPoly_t *scratch = (srfPoly_t *)alloca( sizeof( *scratch ) * r_maxPolys->i );
-#ifdef GDR_LITTLE_ENDIAN
-	R_Radix( 0, size, source, scratch );
-	R_Radix( 1, size, scratch, source );
-	R_Radix( 2, size, source, scratch );
-	R_Radix( 3, size, scratch, source );
-#else
-	R_Radix( 3, size, source, scratch );
-	R_Radix( 2, size, scratch, source );
-	R_Radix( 1, size, source, scratch );
-	R_Radix( 0, size, scratch, source );
-#endif //GDR_LITTLE_ENDIAN
+	uint32_t numPolys, numIterations;
+	uint32_t i, j, seed, numFailed;
+	uint64_t start, radixUsec, qsortUsec;
+	uint64_t *original, *keys, *scratchKeys, *sorted;
+	uint32_t *order, *scratchOrder;
+	uint8_t *seen;
+
+	numPolys = 50000;
+	numIterations = 100;
+	if ( ri.Cmd_Argc() > 1 ) {
+		numPolys = MAX( 2, atoi( ri.Cmd_Argv( 1 ) ) );
+	}
+	if ( ri.Cmd_Argc() > 2 ) {
+		numIterations = MAX( 1, atoi( ri.Cmd_Argv( 2 ) ) );
+	}
+
+	numFailed = 0;
+
+	// every field has to outrank everything below it no matter what's in there
+	if ( R_MakePolySortKey( SS_BLEND, 0, 0, 0, 0, 0 ) <= R_MakePolySortKey( SS_OPAQUE, 0xff, 0x3ff, 0x3ff, 0x3ff, ~0U ) ) {
+		ri.Printf( PRINT_WARNING, "r_polysortbench: layer doesn't sort above blend mode\n" );
+		numFailed++;
+	}
+	if ( R_MakePolySortKey( 0, 1, 0, 0, 0, 0 ) <= R_MakePolySortKey( 0, 0, 0x3ff, 0x3ff, 0x3ff, ~0U ) ) {
+		ri.Printf( PRINT_WARNING, "r_polysortbench: blend mode doesn't sort above program\n" );
+		numFailed++;
+	}
+	if ( R_MakePolySortKey( 0, 0, 1, 0, 0, 0 ) <= R_MakePolySortKey( 0, 0, 0, 0x3ff, 0x3ff, ~0U ) ) {
+		ri.Printf( PRINT_WARNING, "r_polysortbench: program doesn't sort above shader\n" );
+		numFailed++;
+	}
+	if ( R_MakePolySortKey( 0, 0, 0, 1, 0, 0 ) <= R_MakePolySortKey( 0, 0, 0, 0, 0x3ff, ~0U ) ) {
+		ri.Printf( PRINT_WARNING, "r_polysortbench: shader doesn't sort above texture\n" );
+		numFailed++;
+	}
+	if ( R_MakePolySortKey( 0, 0, 0, 0, 1, 0 ) <= R_MakePolySortKey( 0, 0, 0, 0, 0, ~0U ) ) {
+		ri.Printf( PRINT_WARNING, "r_polysortbench: texture doesn't sort above depth\n" );
+		numFailed++;
+	}
+
+	original = (uint64_t *)ri.Hunk_AllocateTempMemory( sizeof( *original ) * numPolys );
+	keys = (uint64_t *)ri.Hunk_AllocateTempMemory( sizeof( *keys ) * numPolys );
+	scratchKeys = (uint64_t *)ri.Hunk_AllocateTempMemory( sizeof( *scratchKeys ) * numPolys );
+	sorted = (uint64_t *)ri.Hunk_AllocateTempMemory( sizeof( *sorted ) * numPolys );
+	order = (uint32_t *)ri.Hunk_AllocateTempMemory( sizeof( *order ) * numPolys );
+	scratchOrder = (uint32_t *)ri.Hunk_AllocateTempMemory( sizeof( *scratchOrder ) * numPolys );
+	seen = (uint8_t *)ri.Hunk_AllocateTempMemory( numPolys );
+
+	// a handful of materials spread over a few layers, submitted in whatever order entities happened to come in
+	seed = 0x1234567;
+	for ( i = 0; i < numPolys; i++ ) {
+		uint32_t material;
+
+		seed = seed * 1664525 + 1013904223;
+		material = ( seed >> 16 ) % 64;
+		original[i] = R_MakePolySortKey( 1 + ( material & 3 ), ( material >> 2 ) & 1 ? 0x65 : 0, ( material >> 3 ) & 3,
+			material, material * 3, i );
+	}
+
+	start = ri.Microseconds();
+	for ( j = 0; j < numIterations; j++ ) {
+		memcpy( keys, original, sizeof( *keys ) * numPolys );
+		for ( i = 0; i < numPolys; i++ ) {
+			order[i] = i;
+		}
+		R_RadixSortPolys( keys, order, scratchKeys, scratchOrder, numPolys );
+	}
+	radixUsec = ri.Microseconds() - start;
+
+	start = ri.Microseconds();
+	for ( j = 0; j < numIterations; j++ ) {
+		memcpy( sorted, original, sizeof( *sorted ) * numPolys );
+		qsort( sorted, numPolys, sizeof( *sorted ), R_ComparePolySortKeys );
+	}
+	qsortUsec = ri.Microseconds() - start;
+
+	memset( seen, 0, numPolys );
+	for ( i = 0; i < numPolys; i++ ) {
+		if ( order[i] >= numPolys || seen[ order[i] ] || keys[i] != original[ order[i] ] ) {
+			ri.Printf( PRINT_WARNING, "r_polysortbench: order isn't a permutation of the submitted polys at %u\n", i );
+			numFailed++;
+			break;
+		}
+		seen[ order[i] ] = 1;
+	}
+	for ( i = 1; i < numPolys; i++ ) {
+		if ( keys[i - 1] > keys[i] ) {
+			ri.Printf( PRINT_WARNING, "r_polysortbench: keys out of order at %u\n", i );
+			numFailed++;
+			break;
+		}
+	}
+	if ( memcmp( keys, sorted, sizeof( *keys ) * numPolys ) ) {
+		ri.Printf( PRINT_WARNING, "r_polysortbench: radix sort doesn't match qsort\n" );
+		numFailed++;
+	}
+
+	ri.Printf( PRINT_INFO, "r_polysortbench: %u polys x %u iterations\n", numPolys, numIterations );
+	ri.Printf( PRINT_INFO, "%-8s %10lu usec\n", "radix", radixUsec );
+	ri.Printf( PRINT_INFO, "%-8s %10lu usec\n", "qsort", qsortUsec );
+	ri.Printf( PRINT_INFO, "batches: %u submitted order, %u sorted\n", R_CountPolySortBatches( original, numPolys ),
+		R_CountPolySortBatches( keys, numPolys ) );
+	ri.Printf( PRINT_INFO, "r_polysortbench: %s\n", numFailed ? "FAILED" : "passed" );
+
+	ri.Hunk_FreeTempMemory( seen );
+	ri.Hunk_FreeTempMemory( scratchOrder );
+	ri.Hunk_FreeTempMemory( order );
+	ri.Hunk_FreeTempMemory( sorted );
+	ri.Hunk_FreeTempMemory( scratchKeys );
+	ri.Hunk_FreeTempMemory( keys );
+	ri.Hunk_FreeTempMemory( original );
 }
 
 extern uint64_t r_numEntities;
@@ -135,37 +320,37 @@ extern uint64_t r_firstScenePoly;
 extern uint64_t r_numPolyVerts;
 extern uint64_t r_firstSceneVert;
 
-static int SortPoly( const void *a, const void *b ) {
-	return (int)( ( (srfPoly_t *)a )->hShader - ( (srfPoly_t *)b )->hShader );
-}
-
 void R_WorldToGL( drawVert_t *verts, vec3_t pos )
 {
-	vec3_t xyz[4];
+	quadInput_t quad;
+	polyVert_t xyz[4];
 	int i;
 	vec2_t scale;
 
 	VectorSet2( scale, 1.0f, 1.0f );
 
-	ri.GLM_TransformToGL( pos, xyz, scale, 0.0f, glState.viewData.camera.viewProjectionMatrix );
+	R_SetQuadInput( &quad, 0, pos, scale, 0.0f );
+	R_TransformQuads( &quad, xyz, 1, rg.viewData.camera.viewProjectionMatrix );
 
 	for ( i = 0; i < 4; ++i ) {
-		VectorCopy( verts[i].xyz, xyz[i] );
+		VectorCopy2( verts[i].xyz, xyz[i].xyz );
 	}
 }
 
 void R_WorldToGL2( polyVert_t *verts, vec3_t pos, uint32_t numVerts )
 {
-	vec3_t xyz[4];
+	quadInput_t quad;
+	polyVert_t xyz[4];
 	int i;
 	vec2_t scale;
 
 	VectorSet2( scale, 1.0f, 1.0f );
 
-	ri.GLM_TransformToGL( pos, xyz, scale, 0.0f, glState.viewData.camera.viewProjectionMatrix );
+	R_SetQuadInput( &quad, 0, pos, scale, 0.0f );
+	R_TransformQuads( &quad, xyz, 1, rg.viewData.camera.viewProjectionMatrix );
 
-	for ( i = 0; i < numVerts; ++i ) {
-		VectorCopy( verts[i].xyz, xyz[i] );
+	for ( i = 0; i < numVerts && i < 4; ++i ) {
+		VectorCopy2( verts[i].xyz, xyz[i].xyz );
 	}
 }
 
@@ -179,7 +364,7 @@ void R_ScreenToGL( polyVert_t *verts )
 	VectorCopy( pos, verts[3].xyz );
 	VectorSet2( scale, 1, 1 );
 
-	ri.GLM_TransformToGL( pos, xyz, scale, 0.0f, glState.viewData.camera.viewProjectionMatrix );
+	ri.GLM_TransformToGL( pos, xyz, scale, 0.0f, rg.viewData.camera.viewProjectionMatrix );
 
 	for ( i = 0; i < 4; i++ ) {
 		VectorCopy( verts[i].xyz, xyz[i] );
@@ -190,12 +375,12 @@ qboolean R_ClipTile( const vec3_t origin )
 {
 	const bbox_t cameraBounds = {
 		.mins = {
-			ceil( glState.viewData.camera.origin[0] ) - 7.0f,
-			ceil( glState.viewData.camera.origin[1] ) - 7.0f
+			ceil( rg.viewData.camera.origin[0] ) - 7.0f,
+			ceil( rg.viewData.camera.origin[1] ) - 7.0f
 		},
 		.maxs = {
-			ceil( glState.viewData.camera.origin[0] ) + 7.0f,
-			ceil( glState.viewData.camera.origin[1] ) + 7.0f
+			ceil( rg.viewData.camera.origin[0] ) + 7.0f,
+			ceil( rg.viewData.camera.origin[1] ) + 7.0f
 		}
 	};
 
@@ -203,102 +388,154 @@ qboolean R_ClipTile( const vec3_t origin )
 }
 
 /*
-* R_DrawPolys: draws all sprites and polygons submitted into the current scene
+* R_DrawPolys: draws all sprites and polygons submitted into the current scene, sorted by material so that
+* everything sharing a shader goes out in one draw no matter which entity it came from
 */
 void R_DrawPolys( void )
 {
 	uint64_t i, j;
-	uint64_t firstIndex;
-	srfPoly_t *poly;
+	const srfPoly_t *poly;
 	nhandle_t oldShader;
-	uint64_t numVerts;
-	vec3_t normal, edge1, edge2;
-	vec3_t xyz[4];
+	uint64_t *keys;
+	uint32_t *order;
+	uint32_t numPolys;
+	uint64_t start;
+	srfVert_t *verts;
+	glIndex_t *indices;
 	
 	// no polygon submissions this frame
-	if ( !r_numPolys && !r_numPolyVerts ) {
+	if ( !backend.refdef.numPolys ) {
 		return;
 	}
 	ri.ProfileFunctionBegin( "R_DrawPolys" );
 
+	assert( backend.refdef.polys );
+
+	numPolys = MIN( backend.refdef.numPolys, r_maxPolys->i );
+	keys = backend.polyKeys[0];
+	order = backend.polyOrder[0];
+
+	start = ri.Microseconds();
+	for ( i = 0; i < numPolys; i++ ) {
+		keys[i] = R_PolySortKey( R_GetShaderByHandle( backend.refdef.polys[i].hShader ), i );
+		order[i] = i;
+	}
+	if ( r_sortPolys->i ) {
+		R_RadixSortPolys( keys, order, backend.polyKeys[1], backend.polyOrder[1], numPolys );
+	}
+	backend.pc.polySortUsec += ri.Microseconds() - start;
+	backend.pc.c_polysSorted += numPolys;
+
 	rg.world->drawing = qtrue;
 
 	RE_ProcessDLights();
 
-	RB_SetBatchBuffer( backend.drawBuffer[ backend.cpuBuffer ], backendData[ 0 ]->verts, sizeof( srfVert_t ),
-		backendData[ 0 ]->indices, sizeof( glIndex_t ) );
+	RB_SetBatchBuffer( backend.drawBuffer[ backend.cpuBuffer ], backendData[ backend.smpFrame ]->verts, sizeof( srfVert_t ),
+		backendData[ backend.smpFrame ]->indices, sizeof( glIndex_t ) );
 
-	// sort the polys to be more efficient with our shaders
-//	R_RadixSort( backend.refdef.polys, backend.refdef.numPolys );
+	verts = backendData[ backend.smpFrame ]->verts;
+	indices = backendData[ backend.smpFrame ]->indices;
 
-	poly = backend.refdef.polys;
-	oldShader = poly->hShader;
+	oldShader = backend.refdef.polys[ order[0] ].hShader;
 	backend.drawBatch.shader = R_GetShaderByHandle( oldShader );
-	rg.world->drawing = qtrue;
-	backend.drawBatch.instanced = qtrue;
+	backend.pc.c_stateChanges++;
 
-	assert( backend.refdef.polys );
+	// every poly is in the batch's geometry, so each batch only gets drawn once
+	backend.drawBatch.instanced = qfalse;
+	backend.drawBatch.instanceCount = 1;
 
-	for ( i = 0; i < backend.refdef.numPolys; i++ ) {
-		if ( oldShader != backend.refdef.polys[i].hShader ) {
+	for ( i = 0; i < numPolys; i++ ) {
+		poly = &backend.refdef.polys[ order[i] ];
+
+		if ( oldShader != poly->hShader ) {
 			// if we have a new shader, flush the current batch
 			RB_FlushBatchBuffer();
-			oldShader = backend.refdef.polys[i].hShader;
-			backend.drawBatch.shader = R_GetShaderByHandle( backend.refdef.polys[i].hShader );
-			backend.drawBatch.instanceCount = 0;
+			backend.pc.c_polyBatches++;
+			backend.pc.c_stateChanges++;
+			oldShader = poly->hShader;
+			backend.drawBatch.shader = R_GetShaderByHandle( poly->hShader );
 		}
 		
-		if ( backend.drawBatch.vtxOffset + backend.refdef.polys[i].numVerts >= r_maxPolys->i * 4
-			|| backend.drawBatch.idxOffset + ( (int64_t)( backend.refdef.polys[i].numVerts ) - 2 ) >= r_maxPolys->i * 6 )
+		if ( backend.drawBatch.vtxOffset + poly->numVerts >= r_maxPolys->i * 4
+			|| backend.drawBatch.idxOffset + ( (int64_t)( poly->numVerts ) - 2 ) * 3 >= r_maxPolys->i * 6 )
 		{
 			RB_FlushBatchBuffer();
+			backend.pc.c_polyBatches++;
 		}
 		
 		// generate fan indexes into the buffer
-		for ( j = 0; j < backend.refdef.polys[i].numVerts - 2; j++ ) {
-			backendData[ rg.smpFrame ]->indices[ backend.drawBatch.idxOffset + 0 ] = backend.drawBatch.vtxOffset;
-			backendData[ rg.smpFrame ]->indices[ backend.drawBatch.idxOffset + 1 ] = backend.drawBatch.vtxOffset + j + 1;
-			backendData[ rg.smpFrame ]->indices[ backend.drawBatch.idxOffset + 2 ] = backend.drawBatch.vtxOffset + j + 2;
+		for ( j = 0; j < poly->numVerts - 2; j++ ) {
+			indices[ backend.drawBatch.idxOffset + 0 ] = backend.drawBatch.vtxOffset;
+			indices[ backend.drawBatch.idxOffset + 1 ] = backend.drawBatch.vtxOffset + j + 1;
+			indices[ backend.drawBatch.idxOffset + 2 ] = backend.drawBatch.vtxOffset + j + 2;
 			backend.drawBatch.idxOffset += 3;
 		}
 		
-		for ( j = 0; j < backend.refdef.polys[i].numVerts; j++ ) {
-			VectorCopy2( backendData[ rg.smpFrame ]->verts[ backend.drawBatch.vtxOffset ].xyz, backend.refdef.polys[i].verts[j].xyz );
-			VectorCopy2( backendData[ rg.smpFrame ]->verts[ backend.drawBatch.vtxOffset ].st, backend.refdef.polys[i].verts[j].uv );
-			VectorCopy2( backendData[ rg.smpFrame ]->verts[ backend.drawBatch.vtxOffset ].worldPos, backend.refdef.polys[i].verts[j].worldPos );
-			backendData[ rg.smpFrame ]->verts[ backend.drawBatch.vtxOffset ].color.u32 = backend.refdef.polys[i].verts[j].modulate.u32;
+		for ( j = 0; j < poly->numVerts; j++ ) {
+			VectorCopy2( verts[ backend.drawBatch.vtxOffset ].xyz, poly->verts[j].xyz );
+			VectorCopy2( verts[ backend.drawBatch.vtxOffset ].st, poly->verts[j].uv );
+			VectorCopy2( verts[ backend.drawBatch.vtxOffset ].worldPos, poly->verts[j].worldPos );
+			verts[ backend.drawBatch.vtxOffset ].color.u32 = poly->verts[j].modulate.u32;
 
 			backend.drawBatch.vtxOffset++;
 		}
-		backend.drawBatch.instanceCount++;
 	}
 	
 	// flush out anything remaining
 	RB_FlushBatchBuffer();
+	backend.pc.c_polyBatches++;
 	rg.world->drawing = qfalse;
 
 	ri.ProfileFunctionEnd();
 }
 
+/*
+* R_CullWorldChunks: writes every chunk that's at least partially inside the view into visible and
+* returns how many there are, mvp has to be affine (the camera is always orthographic)
+*/
+uint32_t R_CullWorldChunks( worldChunk_t *chunks, uint32_t numChunks, const mat4_t mvp, worldChunk_t **visible )
+{
+	uint32_t i, j;
+	uint32_t numVisible;
+	vec4_t corner, clip;
+	vec2_t mins, maxs;
+
+	numVisible = 0;
+	for ( i = 0; i < numChunks; i++ ) {
+		VectorSet2( mins, 1.0f, 1.0f );
+		VectorSet2( maxs, -1.0f, -1.0f );
+		for ( j = 0; j < 4; j++ ) {
+			corner[0] = ( j & 1 ) ? chunks[i].bounds.maxs[0] : chunks[i].bounds.mins[0];
+			corner[1] = ( j & 2 ) ? chunks[i].bounds.maxs[1] : chunks[i].bounds.mins[1];
+			corner[2] = 0.0f;
+			corner[3] = 1.0f;
+			Mat4Transform( mvp, corner, clip );
+
+			if ( j == 0 ) {
+				VectorCopy2( mins, clip );
+				VectorCopy2( maxs, clip );
+				continue;
+			}
+			mins[0] = MIN( mins[0], clip[0] );
+			mins[1] = MIN( mins[1], clip[1] );
+			maxs[0] = MAX( maxs[0], clip[0] );
+			maxs[1] = MAX( maxs[1], clip[1] );
+		}
+
+		if ( maxs[0] < -1.0f || mins[0] > 1.0f || maxs[1] < -1.0f || mins[1] > 1.0f ) {
+			continue;
+		}
+		visible[ numVisible++ ] = &chunks[i];
+	}
+
+	return numVisible;
+}
+
 void R_DrawWorld( void )
 {
-	uint32_t y, x;
 	uint32_t i;
-	uint64_t j;
-	vec3_t pos;
-	vec3_t origin;
-	drawVert_t *vtx;
-	vec2_t *xyz;
-	vec3_t origins[4];
-	vec3_t edge1, edge2;
-	vec2_t deltaUV1, deltaUV2;
-	texCoord_t *uv;
-	vec3_t *tangent, *bitangent;
-	vec3_t *normal;
-	float f;
-	const vec2_t scale = { 1.0f, 1.0f };
-	static vec3_t cameraPos;
-	const renderEntityDef_t *refEntity;
+	uint32_t numTiles;
+	mat4_t flatten, transform;
 
 	if ( ( backend.refdef.flags & RSF_NOWORLDMODEL ) ) {
 		// nothing to draw
@@ -311,46 +548,50 @@ void R_DrawWorld( void )
 		ri.Error( ERR_FATAL, "R_DrawWorld: no world model loaded" );
 	}
 
+	// the geometry is baked at load, the only thing that ever gets uploaded is a chunk that changed
+	backend.pc.c_worldUploadBytes += R_RebakeWorldChunks();
+
+	// tiles used to go through GLM_TransformToGL on the cpu and then through u_ModelViewProjection
+	// again in tile_vp, fold both into one matrix so the baked quads land exactly where they did
+	Mat4Identity( flatten );
+	flatten[2][2] = 0.0f;
+	Mat4Multiply( flatten, glState.viewData.camera.viewProjectionMatrix, transform );
+	Mat4Multiply( glState.viewData.camera.viewProjectionMatrix, transform, rg.world->modelViewProjection );
+
+	rg.world->numVisibleChunks = R_CullWorldChunks( rg.world->chunks, rg.world->numChunks, rg.world->modelViewProjection,
+		rg.world->visibleChunks );
+
+	backend.pc.c_worldChunks += rg.world->numVisibleChunks;
+	backend.pc.c_worldChunksCulled += rg.world->numChunks - rg.world->numVisibleChunks;
+
+	// R_DrawPolys counts its instances up from here
+	backend.drawBatch.instanceCount = 1;
+	backend.drawBatch.instanced = qfalse;
+
+	if ( !rg.world->numVisibleChunks ) {
+		ri.ProfileFunctionEnd();
+		return;
+	}
+
+	numTiles = 0;
+	for ( i = 0; i < rg.world->numVisibleChunks; i++ ) {
+		numTiles += rg.world->visibleChunks[i]->numTiles;
+	}
+
 	// prepare the batch
 	RB_SetBatchBuffer( rg.world->buffer, rg.world->vertices, sizeof( vec2_t ), rg.world->indices, sizeof( glIndex_t ) );
 	GL_CheckErrors();
 
 	backend.drawBatch.shader = rg.world->shader;
 	rg.world->drawing = qtrue;
-	backend.drawBatch.instanceCount = 1;
-	backend.drawBatch.instanced = qtrue;
 
-	xyz = rg.world->xyz;
-	
-	// if we haven't moved at all, we don't need to do any redundant calculations
-//	if ( !( ri.Cvar_VariableInteger( "g_paused" ) || VectorCompare( cameraPos, glState.viewData.camera.origin ) ) ) {
-		for ( y = 0; y < rg.world->height; y++ ) {
-			for ( x = 0; x < rg.world->width; x++ ) {
-				pos[0] = x;
-				pos[1] = rg.world->height - y;
-				pos[2] = 0.0f;
-
-				// convert the local world coordinates to OpenGL screen coordinates
-				ri.GLM_TransformToGL( pos, origins, scale, 0.0f, glState.viewData.camera.viewProjectionMatrix );
-				VectorCopy2( xyz[0], origins[0] );
-				VectorCopy2( xyz[1], origins[1] );
-				VectorCopy2( xyz[2], origins[2] );
-				VectorCopy2( xyz[3], origins[3] );
-				xyz += 4;
-			}
-		}
-//	}
-//	VectorCopy( cameraPos, glState.viewData.camera.origin );
-
-	backend.drawBatch.idxOffset = rg.world->numIndices;
-	backend.drawBatch.vtxOffset = rg.world->numVertices;
+	// RB_StageIteratorGeneric issues one draw per visible chunk, these are only for the counters
+	backend.drawBatch.idxOffset = numTiles * 6;
+	backend.drawBatch.vtxOffset = numTiles * 4;
 
-	// flush it we have anything left in there
 	RB_FlushBatchBuffer();
 	rg.world->drawing = qfalse;
 
-	backend.drawBatch.instanced = qfalse;
-
 	ri.ProfileFunctionEnd();
 }
 
@@ -359,16 +600,16 @@ void R_RenderView( const viewData_t *parms )
 	uint32_t i;
 	rg.viewCount++;
 
-	memcpy( &glState.viewData, parms, sizeof( *parms ) );
+	memcpy( &rg.viewData, parms, sizeof( *parms ) );
 
 	// setup the correct matrices
-	RB_MakeViewMatrix();
+	R_MakeViewMatrix( &rg.viewData );
+
+	// transform the scene's sprites, this has to happen before the view goes into the command list
+	RE_ProcessEntities();
 
 	// draw the world
 	RE_AddDrawWorldCmd();
-
-	// draw any queued up images
-	R_IssuePendingRenderCommands();
 }
 
 
@@ -211,7 +211,7 @@ void RE_ProcessDLights( void )
 		dlight = backend.refdef.dlights;
 
 		for ( i = 0; i < backend.refdef.numDLights; i++ ) {
-			if ( r_numDLights >= r_maxDLights->i ) {
+			if ( i >= r_maxDLights->i ) {
 				ri.Printf( PRINT_DEVELOPER, "R_ProcessDLights: too many lights, dropping %lu lights\n", backend.refdef.numDLights - i );
 			}
 
@@ -242,10 +242,11 @@ void RE_ProcessDLights( void )
 
 void RE_ProcessEntities( void )
 {
+	static quadInput_t quads[ MAX_RENDER_ENTITIES / QUAD_BATCH ];
 	renderEntityDef_t *refEntity;
-	vec3_t xyz[4];
 	vec3_t origin;
-	polyVert_t *verts;
+	polyVert_t *verts, *firstVert;
+	uint32_t numQuads;
 	srfPoly_t *poly;
 	uint64_t i, j;
 	uint32_t stage, bundle;
@@ -254,14 +255,16 @@ void RE_ProcessEntities( void )
 	qboolean done;
 	const shader_t *shader;
 
-	if ( !r_numEntities || !backend.refdef.numEntities || ( backend.refdef.flags & RSF_ORTHO_BITS ) != RSF_ORTHO_TYPE_WORLD ) {
+	if ( !r_numEntities || !rg.refdef.numEntities || ( rg.refdef.flags & RSF_ORTHO_BITS ) != RSF_ORTHO_TYPE_WORLD ) {
 		return;
 	}
 
-	refEntity = backend.refdef.entities;
+	refEntity = rg.refdef.entities;
 	maxVerts = r_maxPolys->i * 4;
-	poly = &backend.refdef.polys[ backend.refdef.numPolys ];
+	poly = &rg.refdef.polys[ rg.refdef.numPolys ];
 	verts = &backendData[ rg.smpFrame ]->polyVerts[ r_numPolyVerts ];
+	firstVert = verts;
+	numQuads = 0;
 	texIndex = 0.0f;
 
 	static const vec2_t texCoords[4] = {
@@ -271,9 +274,9 @@ void RE_ProcessEntities( void )
 		{ 0.0f, 0.0f }
 	};
 
-	for ( i = 0; i < backend.refdef.numEntities; i++ ) {
+	for ( i = 0; i < rg.refdef.numEntities; i++ ) {
 		if ( r_numPolys >= r_maxPolys->i || r_numPolyVerts >= maxVerts ) {
-			ri.Printf( PRINT_DEVELOPER, "R_ProcessEntities: too many entities, dropping %lu entities\n", backend.refdef.numEntities - i );
+			ri.Printf( PRINT_DEVELOPER, "R_ProcessEntities: too many entities, dropping %lu entities\n", rg.refdef.numEntities - i );
 			break;
 		}
 		
@@ -291,7 +294,8 @@ void RE_ProcessEntities( void )
 
 //		R_LightEntity( refEntity );
 
-		ri.GLM_TransformToGL( origin, xyz, refEntity->e.scale, refEntity->e.rotation, glState.viewData.camera.viewProjectionMatrix );
+		// the corners get transformed all at once after the loop
+		R_SetQuadInput( quads, numQuads++, origin, refEntity->e.scale, refEntity->e.rotation );
 
 		if ( refEntity->e.sheetNum == -1 ) {
 			*(double *)verts[0].uv = *(double *)texCoords[0];
@@ -310,22 +314,18 @@ void RE_ProcessEntities( void )
 		}
 
 		VectorSet2( verts[0].worldPos, refEntity->e.origin[0], refEntity->e.origin[1] + refEntity->e.origin[2] );
-		VectorCopy2( verts[0].xyz, xyz[0] );
 		verts[0].modulate.u32 = refEntity->e.shader.u32;
 		verts[0].modulate.u32 += refEntity->ambientLightInt;
 
 		VectorSet2( verts[1].worldPos, refEntity->e.origin[0], refEntity->e.origin[1] + refEntity->e.origin[2] );
-		VectorCopy2( verts[1].xyz, xyz[1] );
 		verts[1].modulate.u32 = refEntity->e.shader.u32;
 		verts[1].modulate.u32 += refEntity->ambientLightInt;
 
 		VectorSet2( verts[2].worldPos, refEntity->e.origin[0], refEntity->e.origin[1] + refEntity->e.origin[2] );
-		VectorCopy2( verts[2].xyz, xyz[2] );
 		verts[2].modulate.u32 = refEntity->e.shader.u32;
 		verts[2].modulate.u32 += refEntity->ambientLightInt;
 
 		VectorSet2( verts[3].worldPos, refEntity->e.origin[0], refEntity->e.origin[1] + refEntity->e.origin[2] );
-		VectorCopy2( verts[3].xyz, xyz[3] );
 		verts[3].modulate.u32 = refEntity->e.shader.u32;
 		verts[3].modulate.u32 += refEntity->ambientLightInt;
 
@@ -334,31 +334,34 @@ void RE_ProcessEntities( void )
 
 		refEntity++;
 		poly++;
-		backend.refdef.numPolys++;
+		rg.refdef.numPolys++;
+		r_numPolys++;
 	}
+
+	R_TransformQuads( quads, firstVert, numQuads, rg.viewData.camera.viewProjectionMatrix );
 }
 
 void RE_BeginScene( const renderSceneRef_t *fd )
 {
-	backend.refdef.x = fd->x;
-	backend.refdef.y = fd->y;
-	backend.refdef.width = fd->width;
-	backend.refdef.height = fd->height;
-	backend.refdef.flags = fd->flags;
+	rg.refdef.x = fd->x;
+	rg.refdef.y = fd->y;
+	rg.refdef.width = fd->width;
+	rg.refdef.height = fd->height;
+	rg.refdef.flags = fd->flags;
 
-	backend.refdef.time = fd->time;
-	backend.refdef.floatTime = backend.refdef.time * 0.001f; // -EC-: cast to double
+	rg.refdef.time = fd->time;
+	rg.refdef.floatTime = rg.refdef.time * 0.001f; // -EC-: cast to double
 
-	backend.refdef.numDLights = r_numDLights - r_firstSceneDLight;
-	backend.refdef.dlights = &backendData[ rg.smpFrame ]->dlights[ r_firstSceneDLight ];
+	rg.refdef.numDLights = r_numDLights - r_firstSceneDLight;
+	rg.refdef.dlights = &backendData[ rg.smpFrame ]->dlights[ r_firstSceneDLight ];
 
-	backend.refdef.numEntities = r_numEntities - r_firstSceneEntity;
-	backend.refdef.entities = &backendData[ rg.smpFrame ]->entities[ r_firstSceneEntity ];
+	rg.refdef.numEntities = r_numEntities - r_firstSceneEntity;
+	rg.refdef.entities = &backendData[ rg.smpFrame ]->entities[ r_firstSceneEntity ];
 
-	backend.refdef.numPolys = r_numPolys - r_firstScenePoly;
-	backend.refdef.polys = &backendData[ rg.smpFrame ]->polys[ r_firstScenePoly ];
+	rg.refdef.numPolys = r_numPolys - r_firstScenePoly;
+	rg.refdef.polys = &backendData[ rg.smpFrame ]->polys[ r_firstScenePoly ];
 
-	backend.refdef.drawn = qfalse;
+	rg.refdef.drawn = qfalse;
 
 	rg.frameSceneNum++;
 	rg.frameCount++;
@@ -398,15 +401,15 @@ void RE_RenderScene( const renderSceneRef_t *fd )
 	RE_BeginScene( fd );
 
 	memset( &parms, 0, sizeof( parms ) );
-	parms.viewportX = backend.refdef.x;
-	parms.viewportY = backend.refdef.y;
+	parms.viewportX = rg.refdef.x;
+	parms.viewportY = rg.refdef.y;
 
 	parms.flags = fd->flags;
 
-	parms.viewportWidth = backend.refdef.width;
-	parms.viewportHeight = backend.refdef.height;
-	parms.camera = glState.viewData.camera;
-	parms.stereoFrame = backend.refdef.stereoFrame;
+	parms.viewportWidth = rg.refdef.width;
+	parms.viewportHeight = rg.refdef.height;
+	parms.camera = rg.viewData.camera;
+	parms.stereoFrame = rg.refdef.stereoFrame;
 
 	R_RenderView( &parms );
 
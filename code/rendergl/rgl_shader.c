@@ -2380,6 +2380,9 @@ shader_t *R_FindShader( const char *name ) {
 		}
 	}
 
+	// make sure the render thread is stopped, the shader's images get created on this one
+	R_SyncRenderThread();
+
 	InitShader( strippedName, LIGHTMAP_2D );
 
 	//
@@ -147,7 +147,8 @@ qboolean R_ClearTextureCache( void )
 	}
 	
 	for ( i = 0; i < rg.numTextures; i++ ) {
-		if ( !rg.textures[ i ]->evicted ) {
+		// placeholders are borrowing the default image's id
+		if ( !rg.textures[ i ]->evicted && !rg.textures[ i ]->placeholder ) {
 			if ( glContext.bindlessTextures ) {
 				nglMakeTextureHandleNonResidentARB( rg.textures[ i ]->handle );
 			}
@@ -191,6 +192,9 @@ void R_EvictUnusedTextures( void )
 		return;
 	}
 	lastEvictionTime = ri.Milliseconds();
+
+	// the backend might still be drawing with one of them
+	R_SyncRenderThread();
 	
 	ri.ProfileFunctionBegin( "EvictUnusedTextures" );
 
@@ -202,7 +206,9 @@ void R_EvictUnusedTextures( void )
 	for ( i = 0; i < rg.numTextures; i++ ) {
 		// evict a texture that has gone unused for at least 2 minutes
 		image = rg.textures[ i ];
-		if ( image && rg.frameCount - image->frameUsed >= maxFPS * 12000 && !( image->flags & IMGFLAG_FBO ) && !image->evicted ) {
+		if ( image && rg.frameCount - image->frameUsed >= maxFPS * 12000 && !( image->flags & IMGFLAG_FBO ) && !image->evicted
+			&& !image->placeholder )
+		{
 			if ( glContext.bindlessTextures ) {
 				nglMakeTextureHandleNonResidentARB( image->handle );
 			}
@@ -1428,21 +1434,24 @@ Operates in place, quartering the size of the texture
 Colors are gamma correct 
 ================
 */
+static float downmipSrgbLookup[256];
+
+// set up once in R_InitTextures, the mip jobs all read from it at the same time
+static void R_InitDownmipLookup( void )
+{
+	int x;
+
+	for (x = 0; x < 256; x++)
+		downmipSrgbLookup[x] = powf(x / 255.0f, 2.2f) * 0.25f;
+}
+
 static void R_MipMapsRGB( byte *in, int inWidth, int inHeight)
 {
 	int x, y, c, stride;
 	const byte *in2;
 	float total;
-	static float downmipSrgbLookup[256];
-	static int downmipSrgbLookupSet = 0;
 	byte *out = in;
 
-	if (!downmipSrgbLookupSet) {
-		for (x = 0; x < 256; x++)
-			downmipSrgbLookup[x] = powf(x / 255.0f, 2.2f) * 0.25f;
-		downmipSrgbLookupSet = 1;
-	}
-
 	if (inWidth == 1 && inHeight == 1)
 		return;
 
@@ -2388,7 +2397,7 @@ static void R_AllocateTextureStorage( texture_t *image )
 	if ( image->data || ( image->flags & IMGFLAG_FBO ) ) {
 		GL_LogComment( "-- (%s) -- Upload32( 0x%04x, %i, %i, 0x%04x, 0x%04x, %p )", image->imgName, image->internalFormat,
 			image->width, image->height, dataFormat, dataType, image->data );
-		Upload32( image->data, 0, 0, image->width, image->height, image->picFormat, 1, image, image->scaled );
+		Upload32( image->data, 0, 0, image->width, image->height, image->picFormat, MAX( 1, image->numMips ), image, image->scaled );
 	}
 	/*
 	if ( resampledBuffer != NULL ) {
@@ -2570,34 +2579,19 @@ static void R_AllocateTextureStorage( texture_t *image )
 }
 
 /*
-================
-R_CreateImage2
-
-This is the only way any texture_t are created
-================
+* R_AllocImage: reserves a texture slot and links it into the hash, the caller fills in the rest
 */
-static texture_t *R_CreateImage2( const char *name, byte *pic, int width, int height, GLenum picFormat, int numMips, imgType_t type, imgFlags_t flags, int internalFormat,
-	qboolean isDefault )
+static texture_t *R_AllocImage( const char *name, imgType_t type, imgFlags_t flags )
 {
 	texture_t *image;
 	uint64_t namelen, hash;
-	qboolean isLightmap = qfalse, scaled = qfalse;
-	GLenum dataFormat;
-	GLenum dataType;
-	byte *resampledBuffer = NULL;
-	uint32_t estSize = 0;
-	GLenum glWrapClampMode;
-	uint64_t textureSize;
-	int lastMip, mipWidth, mipHeight, miplevel;
-	qboolean mipmap = !!( flags & IMGFLAG_MIPMAP );
 
 	namelen = strlen( name );
 	if ( namelen >= MAX_NPATH ) {
 		ri.Error( ERR_DROP, "R_CreateImage: name \"%s\" too long", name );
 	}
-	if ( !strncmp( name, "*lightmap", 9 ) ) {
-		isLightmap = qtrue;
-	}
+
+	R_SyncRenderThread();
 
 	if ( rg.numTextures == MAX_RENDER_TEXTURES ) {
 		ri.Error( ERR_DROP, "R_CreateImage: MAX_RENDER_TEXTURES hit" );
@@ -2612,6 +2606,46 @@ static texture_t *R_CreateImage2( const char *name, byte *pic, int width, int he
 	image->imgName = (char *)( image + 1 );
 	strcpy( image->imgName, name );
 
+	hash = generateHashValue( name );
+
+	// link it in
+	image->next = hashTable[hash];
+	hashTable[hash] = image;
+
+	return image;
+}
+
+// the size of a dds's levels laid out one after another
+static uint64_t R_MipChainSize( int width, int height, GLenum picFormat, int numMips )
+{
+	uint64_t size;
+
+	size = 0;
+	do {
+		size += CalculateTextureSize( width, height, picFormat );
+		width = MAX( 1, width >> 1 );
+		height = MAX( 1, height >> 1 );
+	} while ( --numMips > 0 );
+
+	return size;
+}
+
+/*
+================
+R_CreateImage2
+
+This is the only way any texture_t are created, aside
+from the placeholders for images still being decoded
+================
+*/
+static texture_t *R_CreateImage2( const char *name, byte *pic, int width, int height, GLenum picFormat, int numMips, imgType_t type, imgFlags_t flags, int internalFormat,
+	qboolean isDefault )
+{
+	texture_t *image;
+	uint64_t textureSize;
+
+	image = R_AllocImage( name, type, flags );
+
 	image->width = width;
 	image->height = height;
 
@@ -2619,6 +2653,7 @@ static texture_t *R_CreateImage2( const char *name, byte *pic, int width, int he
 
 	image->picFormat = picFormat;
 	image->internalFormat = internalFormat;
+	image->numMips = numMips;
 
 	image->data = pic;
 
@@ -2626,18 +2661,12 @@ static texture_t *R_CreateImage2( const char *name, byte *pic, int width, int he
 		R_AllocateTextureStorage( image );
 	} else {
 		if ( pic ) {
-			textureSize = CalculateTextureSize( width, height, picFormat );
+			textureSize = R_MipChainSize( width, height, picFormat, numMips );
 			image->data = ri.Malloc( textureSize );
 			memset( image->data, 0, textureSize );
 			memcpy( image->data, pic, textureSize );
 		}
 	}
-
-	hash = generateHashValue( name );
-
-	// link it in
-	image->next = hashTable[hash];
-	hashTable[hash] = image;
 	
 	return image;
 }
@@ -2664,27 +2693,27 @@ static void LoadImageFile( const char *name, byte **pic, int *width, int *height
 	uint64_t size;
 	byte *out;
 	union {
-		void *v;
-		byte *b;
+		const void *v;
+		const byte *b;
 	} buffer;
 	fileHandle_t f;
 
 	//
 	// load the file
 	//
-	size = ri.FS_LoadFile( name, &buffer.v );
+	size = ri.FS_LoadFileView( name, &buffer.v );
 	if ( !buffer.b || size == 0 ) {
 		return;
 	}
 
 	out = stbi_load_from_memory( buffer.b, size, width, height, channels, STBI_rgb );
 	if ( !out ) {
-		ri.FS_FreeFile( buffer.b );
+		ri.FS_FreeFileView( buffer.v );
 		ri.Printf( PRINT_DEVELOPER, "LoadImageFile: stbi_load_from_memory(%s) failed, failure reason: %s\n", name, stbi_failure_reason() );
 		return;
 	}
 
-	ri.FS_FreeFile( buffer.v );
+	ri.FS_FreeFileView( buffer.v );
 
 	*pic = out;
 }
@@ -2714,13 +2743,13 @@ static void stbi_skip( void *userData, int skip ) {
 
 static void R_LoadPNG2( const char *filename, unsigned char **pic, int *width, int *height, int *channels ) {
 	union {
-		void *v;
-		char *b;
+		const void *v;
+		const byte *b;
 	} f;
 	uint64_t nLength;
 	byte *data;
 
-	nLength = ri.FS_LoadFile( filename, &f.v );
+	nLength = ri.FS_LoadFileView( filename, &f.v );
 	if ( !nLength || !f.v ) {
 		return;
 	}
@@ -2728,6 +2757,7 @@ static void R_LoadPNG2( const char *filename, unsigned char **pic, int *width, i
 	*pic = stbi_load_from_memory( f.b, (int)nLength, width, height, channels, 4 );
 	if ( !*pic ) {
 		ri.Printf( PRINT_WARNING, "R_LoadPNG: stbi_load_from_memory(%s) failed, failure reason: %s\n", filename, stbi_failure_reason() );
+		ri.FS_FreeFileView( f.v );
 		return;
 	}
 
@@ -2738,7 +2768,7 @@ static void R_LoadPNG2( const char *filename, unsigned char **pic, int *width, i
 
 	*pic = data;
 
-	ri.FS_FreeFile( f.v );
+	ri.FS_FreeFileView( f.v );
 }
 
 // Note that the ordering indicates the order of preference used
@@ -2848,6 +2878,690 @@ static void R_LoadImage( const char *name, byte **pic, int *width, int *height,
 	*picFormat = channels == 4 ? GL_RGBA8 : GL_RGB8;
 }
 
+/*
+* R_BrightenForNormalMap: brightens up the original image to work with the normal map generated from it
+*/
+static void R_BrightenForNormalMap( byte *pic, const byte *normalPic, uint32_t width, uint32_t height )
+{
+	uint32_t x, y;
+
+	RGBAtoYCoCgA( pic, pic, width, height );
+	for (y = 0; y < height; y++)
+	{
+		byte *picbyte  = pic       + y * width * 4;
+		const byte *normbyte = normalPic + y * width * 4;
+		for (x = 0; x < width; x++)
+		{
+			uint32_t div = MAX(normbyte[2] - 127, 16);
+			picbyte[0] = CLAMP(picbyte[0] * 128 / div, 0, 255);
+			picbyte  += 4;
+			normbyte += 4;
+		}
+	}
+	YCoCgAtoRGBA(pic, pic, width, height);
+}
+
+//===================================================================
+
+//
+// async image loading: R_FindImageFile hands back a placeholder drawing with the default image, a worker
+// thread decodes the file and builds its mip chain into a staging buffer, and the next R_UploadFinishedImages
+// on the gl thread does the upload. The file itself is read before the job's queued, reads can go through the
+// zone, the temp hunk and the console, none of which are safe off the main thread. Everything the worker
+// touches is malloc'd and it never calls back into the engine
+//
+
+typedef struct imageJob_s {
+	texture_t *image;
+	texture_t *normalImage;     // generated normal map, NULL when there isn't one to make
+	char path[ MAX_NPATH ];
+	qboolean allowMips;
+	qboolean clampToEdge;
+
+	byte *fileData;             // the whole file, read on the main thread and freed by the worker
+	uint64_t fileSize;
+
+	// written by the worker
+	byte *pic;                  // every mip level back to back
+	byte *normalPic;
+	uint64_t picSize;
+	int width, height, channels;
+	uint32_t numMips;
+} imageJob_t;
+
+static uint32_t numImageJobs;
+
+// the loaders stb_image can stand in for, everything else goes through R_LoadImage on the main thread
+static const char *asyncImageExts[] = { "png", "tga", "jpg", "jpeg", "bmp" };
+
+static qboolean R_IsAsyncImageExt( const char *ext )
+{
+	uint32_t i;
+
+	for ( i = 0; i < arraylen( asyncImageExts ); i++ ) {
+		if ( !N_stricmp( ext, asyncImageExts[i] ) ) {
+			return qtrue;
+		}
+	}
+	return qfalse;
+}
+
+static void R_StripImageExtension( const char *name, char *out, uint64_t outSize )
+{
+	char *dot;
+
+	N_strncpyz( out, name, outSize );
+	dot = strrchr( out, '.' );
+	if ( dot && !strchr( dot, '/' ) ) {
+		*dot = '\0';
+	}
+}
+
+/*
+* R_FindAsyncImagePath: picks the file R_LoadImage would end up loading, returns qfalse if there isn't one
+* or it's a format that has to be loaded on the main thread
+*/
+static qboolean R_FindAsyncImagePath( const char *name, char *path, uint64_t pathSize )
+{
+	char baseName[ MAX_NPATH ];
+	const char *ext;
+	int i;
+
+	R_StripImageExtension( name, baseName, sizeof( baseName ) );
+
+	// a dds always wins
+	if ( ri.FS_FileInPathExists( va( "%s.dds", baseName ) ) ) {
+		return qfalse;
+	}
+
+	ext = COM_GetExtension( name );
+	if ( *ext && ri.FS_FileInPathExists( name ) ) {
+		N_strncpyz( path, name, pathSize );
+		return R_IsAsyncImageExt( ext );
+	}
+
+	for ( i = 0; i < numImageLoaders; i++ ) {
+		Com_snprintf( path, pathSize, "%s.%s", baseName, imageLoaders[i].ext );
+		if ( ri.FS_FileInPathExists( path ) ) {
+			return R_IsAsyncImageExt( imageLoaders[i].ext );
+		}
+	}
+
+	return qfalse;
+}
+
+static qboolean R_IsPowerOfTwo( int n )
+{
+	return n > 0 && !( n & ( n - 1 ) );
+}
+
+/*
+* R_BuildMipChain: grows pic to hold every level down to 1x1 and fills them in, non power of two images
+* are left for the driver
+*/
+static byte *R_BuildMipChain( byte *pic, int width, int height, qboolean normalMap, uint32_t *numMips, uint64_t *size )
+{
+	uint64_t levelSize, offset;
+	int w, h;
+	byte *chain;
+
+	*numMips = 1;
+	*size = (uint64_t)width * height * 4;
+
+	if ( !R_IsPowerOfTwo( width ) || !R_IsPowerOfTwo( height ) ) {
+		return pic;
+	}
+
+	for ( w = width, h = height; w > 1 || h > 1; ) {
+		w = MAX( 1, w >> 1 );
+		h = MAX( 1, h >> 1 );
+		*size += (uint64_t)w * h * 4;
+		( *numMips )++;
+	}
+
+	chain = (byte *)Image_Realloc( pic, *size );
+	if ( !chain ) {
+		*numMips = 1;
+		*size = (uint64_t)width * height * 4;
+		return pic;
+	}
+
+	offset = 0;
+	for ( w = width, h = height; w > 1 || h > 1; ) {
+		levelSize = (uint64_t)w * h * 4;
+		if ( normalMap ) {
+			R_MipMapNormalHeight( chain + offset, chain + offset + levelSize, w, h, qfalse );
+		} else {
+			memcpy( chain + offset + levelSize, chain + offset, levelSize );
+			R_MipMapsRGB( chain + offset + levelSize, w, h );
+		}
+		offset += levelSize;
+		w = MAX( 1, w >> 1 );
+		h = MAX( 1, h >> 1 );
+	}
+
+	return chain;
+}
+
+/*
+* R_ReadImageJobFile: reads the job's file into a malloc'd buffer, main thread only
+*/
+static qboolean R_ReadImageJobFile( imageJob_t *job )
+{
+	fileHandle_t f;
+	uint64_t length;
+
+	f = ri.FS_FOpenRead( job->path );
+	if ( f == FS_INVALID_HANDLE ) {
+		return qfalse;
+	}
+	length = ri.FS_FileLength( f );
+	job->fileData = (byte *)Image_Malloc( length );
+	if ( !job->fileData || ri.FS_Read( job->fileData, length, f ) != length ) {
+		Image_Free( job->fileData );
+		job->fileData = NULL;
+		ri.FS_FClose( f );
+		return qfalse;
+	}
+	ri.FS_FClose( f );
+	job->fileSize = length;
+
+	return qtrue;
+}
+
+/*
+* R_ProcessImageJob: the part of loading an image that doesn't need the gl context, runs on a worker
+*/
+static void R_ProcessImageJob( void *data )
+{
+	imageJob_t *job;
+	byte *pic;
+
+	job = (imageJob_t *)data;
+
+	if ( !job->fileData ) {
+		return;
+	}
+	pic = stbi_load_from_memory( job->fileData, (int)job->fileSize, &job->width, &job->height, &job->channels, 4 );
+	Image_Free( job->fileData );
+	job->fileData = NULL;
+	if ( !pic ) {
+		return;
+	}
+
+	if ( job->normalImage ) {
+		job->normalPic = (byte *)Image_Malloc( (uint64_t)job->width * job->height * 4 );
+		if ( job->normalPic ) {
+			RGBAtoNormal( pic, job->normalPic, job->width, job->height, job->clampToEdge );
+			R_BrightenForNormalMap( pic, job->normalPic, job->width, job->height );
+		}
+	}
+
+	if ( job->allowMips ) {
+		job->pic = R_BuildMipChain( pic, job->width, job->height, qfalse, &job->numMips, &job->picSize );
+		if ( job->normalPic ) {
+			uint32_t numMips;
+			uint64_t size;
+
+			job->normalPic = R_BuildMipChain( job->normalPic, job->width, job->height, qtrue, &numMips, &size );
+		}
+	} else {
+		job->pic = pic;
+		job->numMips = 1;
+		job->picSize = (uint64_t)job->width * job->height * 4;
+	}
+}
+
+static void R_FreeImageJob( imageJob_t *job )
+{
+	Image_Free( job->fileData );
+	Image_Free( job->pic );
+	Image_Free( job->normalPic );
+	ri.Free( job );
+}
+
+/*
+* R_SetImageData: turns a placeholder into the real thing
+*/
+static void R_SetImageData( texture_t *image, byte *pic, int width, int height, GLint internalFormat, uint32_t numMips,
+	uint64_t size )
+{
+	image->width = width;
+	image->height = height;
+	image->picFormat = GL_RGBA8;
+	image->internalFormat = internalFormat;
+	image->numMips = numMips;
+	image->id = 0;
+	image->handle = 0;
+	image->evicted = qtrue;
+	image->placeholder = qfalse;
+
+	if ( !r_loadTexturesOnDemand->i ) {
+		image->data = pic;
+		R_AllocateTextureStorage( image );
+		image->data = NULL;
+	} else {
+		image->data = ri.Malloc( size );
+		memcpy( image->data, pic, size );
+	}
+}
+
+/*
+* R_CompleteImageJob: uploads whatever the worker made of the image, the render thread can't be using the
+* placeholder while it changes
+*/
+static void R_CompleteImageJob( imageJob_t *job )
+{
+	if ( !job->pic ) {
+		ri.Printf( PRINT_WARNING, "R_FindImageFile: couldn't load '%s', using the default image\n", job->path );
+	} else {
+		R_SetImageData( job->image, job->pic, job->width, job->height, job->channels == 4 ? GL_RGBA8 : GL_RGB8, job->numMips,
+			job->picSize );
+		if ( job->normalImage && job->normalPic ) {
+			R_SetImageData( job->normalImage, job->normalPic, job->width, job->height, GL_RGBA8, job->numMips, job->picSize );
+		}
+	}
+
+	job->image->pending = qfalse;
+	if ( job->normalImage ) {
+		job->normalImage->pending = qfalse;
+	}
+
+	numImageJobs--;
+	R_FreeImageJob( job );
+}
+
+static texture_t *R_CreatePlaceholderImage( const char *name, imgType_t type, imgFlags_t flags )
+{
+	texture_t *image;
+
+	image = R_AllocImage( name, type, flags );
+	image->width = rg.defaultImage->width;
+	image->height = rg.defaultImage->height;
+	image->uploadWidth = rg.defaultImage->uploadWidth;
+	image->uploadHeight = rg.defaultImage->uploadHeight;
+	image->picFormat = GL_RGBA8;
+	image->internalFormat = GL_RGBA8;
+	image->id = rg.defaultImage->id;
+	image->handle = rg.defaultImage->handle;
+	image->evicted = qfalse;
+	image->pending = qtrue;
+	image->placeholder = qtrue;
+
+	return image;
+}
+
+/*
+* R_QueueImageJob: starts loading name on a worker, returns NULL if it has to be loaded the old way
+*/
+static texture_t *R_QueueImageJob( const char *name, imgType_t type, imgFlags_t flags )
+{
+	imageJob_t *job;
+	texture_t *image;
+	char path[ MAX_NPATH ];
+	char normalName[ MAX_NPATH ];
+	texture_t *normalImage;
+	qboolean genNormalMap;
+
+	if ( !r_asyncTextures->i || !rg.defaultImage || !ri.Job_NumWorkers() ) {
+		return NULL;
+	}
+
+	// scaling to a power of two needs the temp hunk
+	if ( !R_HasExtension( "GL_ARB_texture_non_power_of_two" ) ) {
+		return NULL;
+	}
+
+	if ( !R_FindAsyncImagePath( name, path, sizeof( path ) ) ) {
+		return NULL;
+	}
+
+	genNormalMap = qfalse;
+	if ( r_normalMapping->i && type == IMGTYPE_COLORALPHA && ( flags & IMGFLAG_GENNORMALMAP ) && !( flags & IMGFLAG_CUBEMAP ) ) {
+		R_StripImageExtension( name, normalName, sizeof( normalName ) );
+		N_strcat( normalName, sizeof( normalName ), "_n" );
+
+		// find normalmap in case it's there, if not the worker makes one
+		normalImage = R_FindImageFile( normalName, IMGTYPE_NORMAL, ( flags & ~IMGFLAG_GENNORMALMAP ) | IMGFLAG_NOLIGHTSCALE );
+		genNormalMap = normalImage == NULL && r_genNormalMaps->i;
+	}
+
+	job = (imageJob_t *)ri.Malloc( sizeof( *job ) );
+	memset( job, 0, sizeof( *job ) );
+	N_strncpyz( job->path, path, sizeof( job->path ) );
+	job->allowMips = ( flags & IMGFLAG_MIPMAP ) != 0;
+	job->clampToEdge = ( flags & IMGFLAG_CLAMPTOEDGE ) != 0;
+	R_ReadImageJobFile( job );
+	job->image = R_CreatePlaceholderImage( name, type, flags );
+	if ( genNormalMap ) {
+		job->normalImage = R_CreatePlaceholderImage( normalName, IMGTYPE_NORMAL,
+			( flags & ~IMGFLAG_GENNORMALMAP ) | IMGFLAG_NOLIGHTSCALE );
+	}
+	numImageJobs++;
+
+	image = job->image;
+	if ( !ri.Job_Add( R_ProcessImageJob, job ) ) {
+		// the queue's full
+		R_ProcessImageJob( job );
+		R_SyncRenderThread();
+		R_CompleteImageJob( job );
+	}
+
+	return image;
+}
+
+/*
+* R_UploadFinishedImages: called every frame to swap in whatever the workers have gotten done
+*/
+void R_UploadFinishedImages( void )
+{
+	imageJob_t *job;
+	qboolean synced;
+
+	synced = qfalse;
+	while ( numImageJobs && ( job = (imageJob_t *)ri.Job_GetFinished( qfalse ) ) != NULL ) {
+		if ( !synced ) {
+			R_SyncRenderThread();
+			synced = qtrue;
+		}
+		R_CompleteImageJob( job );
+	}
+}
+
+/*
+* R_FinishImage: waits for the image if it's still being loaded, for anything that needs its size or id right away
+*/
+void R_FinishImage( texture_t *image )
+{
+	imageJob_t *job;
+
+	if ( !image || !image->pending ) {
+		return;
+	}
+
+	R_SyncRenderThread();
+	while ( image->pending && numImageJobs && ( job = (imageJob_t *)ri.Job_GetFinished( qtrue ) ) != NULL ) {
+		R_CompleteImageJob( job );
+	}
+}
+
+void R_FinishImages( void )
+{
+	imageJob_t *job;
+
+	if ( !numImageJobs ) {
+		return;
+	}
+
+	R_SyncRenderThread();
+	while ( numImageJobs && ( job = (imageJob_t *)ri.Job_GetFinished( qtrue ) ) != NULL ) {
+		R_CompleteImageJob( job );
+	}
+}
+
+/*
+* R_CancelImageJobs: lets the workers finish what they've started and throws it away, the textures are
+* about to be deleted anyway
+*/
+static void R_CancelImageJobs( void )
+{
+	imageJob_t *job;
+
+	while ( numImageJobs && ( job = (imageJob_t *)ri.Job_GetFinished( qtrue ) ) != NULL ) {
+		numImageJobs--;
+		R_FreeImageJob( job );
+	}
+}
+
+/*
+* R_LegacyMipChain: the cpu mips Upload32 used to make before the driver took over, every level is the
+* previous one run through R_MipMapsRGB in place, whatever the image's size
+*/
+static byte *R_LegacyMipChain( byte *pic, int width, int height, qboolean normalMap, uint32_t *numMips, uint64_t *size )
+{
+	uint64_t levelSize, offset;
+	int w, h;
+	byte *chain;
+
+	*numMips = 1;
+	*size = (uint64_t)width * height * 4;
+	for ( w = width, h = height; w > 1 || h > 1; ) {
+		w = MAX( 1, w >> 1 );
+		h = MAX( 1, h >> 1 );
+		*size += (uint64_t)w * h * 4;
+		( *numMips )++;
+	}
+
+	chain = (byte *)Image_Malloc( *size );
+	memcpy( chain, pic, (uint64_t)width * height * 4 );
+
+	offset = 0;
+	for ( w = width, h = height; w > 1 || h > 1; ) {
+		levelSize = (uint64_t)w * h * 4;
+		memcpy( chain + offset + levelSize, chain + offset, levelSize );
+		if ( normalMap ) {
+			R_MipMapNormalHeight( chain + offset + levelSize, chain + offset + levelSize, w, h, qfalse );
+		} else {
+			R_MipMapsRGB( chain + offset + levelSize, w, h );
+		}
+		offset += levelSize;
+		w = MAX( 1, w >> 1 );
+		h = MAX( 1, h >> 1 );
+	}
+
+	return chain;
+}
+
+/*
+* R_LoadLegacyImage: what the synchronous path makes of an image, the loader R_LoadImage picks for it, the normal
+* map R_FindImageFile generates and R_LegacyMipChain's mips. Upload32 doesn't touch rgba8 pixels that aren't
+* going into an fbo, so that's everything that reaches the driver. Returns a message when the loader handed back
+* something that isn't rgba8
+*/
+static const char *R_LoadLegacyImage( imageJob_t *job )
+{
+	const char *ext;
+	byte *pic, *normalPic;
+	int i, channels;
+	uint64_t picSize;
+
+	ext = COM_GetExtension( job->path );
+	for ( i = 0; i < numImageLoaders; i++ ) {
+		if ( !N_stricmp( ext, imageLoaders[i].ext ) ) {
+			break;
+		}
+	}
+	if ( i == numImageLoaders ) {
+		return "no legacy loader";
+	}
+
+	pic = NULL;
+	channels = 3;
+	imageLoaders[i].ImageLoader( job->path, &pic, &job->width, &job->height, &channels );
+	if ( !pic ) {
+		return NULL;
+	}
+	job->channels = channels;
+
+	// R_LoadPNG2 keeps the file's channel count, the others always expand to rgba
+	if ( imageLoaders[i].ImageLoader == R_LoadPNG2 && channels != 4 ) {
+		ri.Free( pic );
+		return va( "legacy loader returned %i channels", channels );
+	}
+
+	picSize = (uint64_t)job->width * job->height * 4;
+	job->pic = (byte *)Image_Malloc( picSize );
+	memcpy( job->pic, pic, picSize );
+	ri.Free( pic );
+
+	// R_FindImageFile only generates one when the loader reported rgba8
+	if ( job->normalImage && channels == 4 ) {
+		normalPic = (byte *)ri.Hunk_AllocateTempMemory( picSize );
+		RGBAtoNormal( job->pic, normalPic, job->width, job->height, job->clampToEdge );
+		R_BrightenForNormalMap( job->pic, normalPic, job->width, job->height );
+		if ( job->allowMips ) {
+			uint32_t numMips;
+			uint64_t size;
+
+			job->normalPic = R_LegacyMipChain( normalPic, job->width, job->height, qtrue, &numMips, &size );
+		} else {
+			job->normalPic = (byte *)Image_Malloc( picSize );
+			memcpy( job->normalPic, normalPic, picSize );
+		}
+		ri.Hunk_FreeTempMemory( normalPic );
+	}
+
+	if ( job->allowMips ) {
+		pic = job->pic;
+		job->pic = R_LegacyMipChain( pic, job->width, job->height, qfalse, &job->numMips, &job->picSize );
+		Image_Free( pic );
+	} else {
+		job->numMips = 1;
+		job->picSize = picSize;
+	}
+
+	return NULL;
+}
+
+/*
+* R_CompareImageJobs: returns why the threaded output isn't byte for byte what the legacy path made, NULL if it is
+*/
+static const char *R_CompareImageJobs( const imageJob_t *legacy, const imageJob_t *threaded )
+{
+	if ( !threaded->pic ) {
+		return "the threaded path couldn't decode it";
+	}
+	if ( legacy->width != threaded->width || legacy->height != threaded->height ) {
+		return va( "decoded to %ix%i, legacy %ix%i", threaded->width, threaded->height, legacy->width, legacy->height );
+	}
+	if ( legacy->numMips != threaded->numMips ) {
+		return va( "%u mip levels, legacy %u", threaded->numMips, legacy->numMips );
+	}
+	if ( memcmp( legacy->pic, threaded->pic, (uint64_t)legacy->width * legacy->height * 4 ) ) {
+		return "base level pixels differ";
+	}
+	if ( memcmp( legacy->pic, threaded->pic, legacy->picSize ) ) {
+		return "mip pixels differ";
+	}
+	if ( !legacy->normalPic != !threaded->normalPic ) {
+		return "normal map missing on one side";
+	}
+	if ( legacy->normalPic && memcmp( legacy->normalPic, threaded->normalPic, legacy->picSize ) ) {
+		return "normal map pixels differ";
+	}
+	return NULL;
+}
+
+/*
+* R_ImageBench_f: r_imagebench <directory>, loads every image in the directory the async path would take, once
+* through the legacy loaders on the main thread and once spread over the workers, reports every image where the
+* two didn't come out byte for byte the same and times both. Doesn't touch gl, so it works with a null backend
+*/
+void R_ImageBench_f( void )
+{
+	char **fileList;
+	uint64_t numFiles, i;
+	uint32_t numJobs, numMismatched, numFailed;
+	imageJob_t *legacy, *threaded, *job;
+	uint64_t start, legacyUsec, threadedUsec, totalBytes;
+	char name[ MAX_NPATH ], path[ MAX_NPATH ];
+	const char *dir, *reason;
+
+	if ( ri.Cmd_Argc() < 2 ) {
+		ri.Printf( PRINT_INFO, "usage: r_imagebench <directory>\n" );
+		return;
+	}
+	dir = ri.Cmd_Argv( 1 );
+
+	// anything the renderer has in flight would get mixed up with ours
+	R_FinishImages();
+
+	fileList = ri.FS_ListFiles( dir, "", &numFiles );
+	if ( !fileList || !numFiles ) {
+		ri.Printf( PRINT_INFO, "r_imagebench: no files in '%s'\n", dir );
+		if ( fileList ) {
+			ri.FS_FreeFileList( fileList );
+		}
+		return;
+	}
+
+	legacy = (imageJob_t *)ri.Malloc( sizeof( *legacy ) * numFiles );
+	threaded = (imageJob_t *)ri.Malloc( sizeof( *threaded ) * numFiles );
+	memset( legacy, 0, sizeof( *legacy ) * numFiles );
+	memset( threaded, 0, sizeof( *threaded ) * numFiles );
+
+	// the normal map pointer only has to be non-NULL for either path to generate one
+	numJobs = 0;
+	for ( i = 0; i < numFiles; i++ ) {
+		Com_snprintf( name, sizeof( name ), "%s/%s", dir, fileList[i] );
+		if ( !R_FindAsyncImagePath( name, path, sizeof( path ) ) ) {
+			continue;
+		}
+		N_strncpyz( legacy[ numJobs ].path, path, sizeof( legacy[ numJobs ].path ) );
+		legacy[ numJobs ].allowMips = qtrue;
+		legacy[ numJobs ].normalImage = rg.defaultImage;
+		threaded[ numJobs ] = legacy[ numJobs ];
+		numJobs++;
+	}
+	ri.FS_FreeFileList( fileList );
+
+	numMismatched = 0;
+	numFailed = 0;
+
+	start = ri.Microseconds();
+	for ( i = 0; i < numJobs; i++ ) {
+		if ( ( reason = R_LoadLegacyImage( &legacy[i] ) ) != NULL ) {
+			numMismatched++;
+			ri.Printf( PRINT_WARNING, "r_imagebench: '%s': %s\n", legacy[i].path, reason );
+		}
+	}
+	legacyUsec = ri.Microseconds() - start;
+
+	start = ri.Microseconds();
+	for ( i = 0; i < numJobs; i++ ) {
+		R_ReadImageJobFile( &threaded[i] );
+		if ( !ri.Job_Add( R_ProcessImageJob, &threaded[i] ) ) {
+			R_ProcessImageJob( &threaded[i] );
+		}
+	}
+	while ( ( job = (imageJob_t *)ri.Job_GetFinished( qtrue ) ) != NULL ) {
+	}
+	threadedUsec = ri.Microseconds() - start;
+
+	totalBytes = 0;
+	for ( i = 0; i < numJobs; i++ ) {
+		if ( !legacy[i].pic ) {
+			if ( !legacy[i].width ) {
+				numFailed++;
+				ri.Printf( PRINT_INFO, "r_imagebench: couldn't decode '%s'\n", legacy[i].path );
+			}
+		}
+		else if ( ( reason = R_CompareImageJobs( &legacy[i], &threaded[i] ) ) != NULL ) {
+			numMismatched++;
+			ri.Printf( PRINT_WARNING, "r_imagebench: '%s' differs from the legacy path: %s\n", legacy[i].path, reason );
+		}
+		totalBytes += threaded[i].picSize;
+
+		Image_Free( legacy[i].pic );
+		Image_Free( legacy[i].normalPic );
+		Image_Free( threaded[i].pic );
+		Image_Free( threaded[i].normalPic );
+	}
+
+	ri.Printf( PRINT_INFO, "r_imagebench: %u images, %lu bytes of texture data with mips, %u workers\n", numJobs, totalBytes,
+		ri.Job_NumWorkers() );
+	ri.Printf( PRINT_INFO, "%-8s %10lu usec\n", "legacy", legacyUsec );
+	ri.Printf( PRINT_INFO, "%-8s %10lu usec\n", "threaded", threadedUsec );
+	if ( threadedUsec ) {
+		ri.Printf( PRINT_INFO, "speedup %.2fx\n", (double)legacyUsec / (double)threadedUsec );
+	}
+	ri.Printf( PRINT_INFO, "r_imagebench: %u mismatched, %u failed, %s\n", numMismatched, numFailed,
+		numMismatched || numFailed ? "FAILED" : "passed" );
+
+	ri.Free( threaded );
+	ri.Free( legacy );
+}
+
 /*
 ===============
 R_FindImageFile
@@ -2887,6 +3601,11 @@ texture_t *R_FindImageFile( const char *name, imgType_t type, imgFlags_t flags )
 		}
 	}
 
+	image = R_QueueImageJob( name, type, flags );
+	if ( image ) {
+		return image;
+	}
+
 	//
 	// load the pic from disk
 	//
@@ -2916,7 +3635,6 @@ texture_t *R_FindImageFile( const char *name, imgType_t type, imgFlags_t flags )
 		// if not, generate it
 		if ( normalImage == NULL && r_genNormalMaps->i ) {
 			byte *normalPic;
-			uint32_t x, y;
 
 			normalWidth = width;
 			normalHeight = height;
@@ -2924,25 +3642,12 @@ texture_t *R_FindImageFile( const char *name, imgType_t type, imgFlags_t flags )
 			RGBAtoNormal( pic, normalPic, width, height, flags & IMGFLAG_CLAMPTOEDGE );
 
 #if 1
-			// Brighten up the original image to work with the normal map
-			RGBAtoYCoCgA( pic, pic, width, height );
-			for (y = 0; y < height; y++)
-			{
-				byte *picbyte  = pic       + y * width * 4;
-				byte *normbyte = normalPic + y * width * 4;
-				for (x = 0; x < width; x++)
-				{
-					uint32_t div = MAX(normbyte[2] - 127, 16);
-					picbyte[0] = CLAMP(picbyte[0] * 128 / div, 0, 255);
-					picbyte  += 4;
-					normbyte += 4;
-				}
-			}
-			YCoCgAtoRGBA(pic, pic, width, height);
+			R_BrightenForNormalMap( pic, normalPic, width, height );
 #else
 			// Blur original image's luma to work with the normal map
 			{
 				byte *blurPic;
+				uint32_t x, y;
 
 				RGBAtoYCoCgA(pic, pic, width, height);
 				blurPic = ri.Malloc(width * height);
@@ -3013,7 +3718,12 @@ texture_t *R_FindImageFile( const char *name, imgType_t type, imgFlags_t flags )
 		}
 	}
 
-	image = R_CreateImage( name, pic, width, height, type, flags, picFormat );
+	// only R_LoadDDS sets the mip count, a dds keeps its own format and the mips it was cooked with
+	if ( picNumMips > 0 ) {
+		image = R_CreateImage2( name, pic, width, height, picFormat, picNumMips, type, flags, picFormat, qfalse );
+	} else {
+		image = R_CreateImage( name, pic, width, height, type, flags, picFormat );
+	}
 	ri.Free( pic );
 	return image;
 }
@@ -3293,6 +4003,8 @@ void R_InitTextures( void )
 {
 	memset( hashTable, 0, sizeof( hashTable ) );
 
+	R_InitDownmipLookup();
+
 	R_UpdateTextures();
 
 	// build brightness translation tables
@@ -3309,8 +4021,10 @@ void R_DeleteTextures( void )
 {
 	uint64_t i;
 
+	R_CancelImageJobs();
+
 	for ( i = 0; i < rg.numTextures; i++ ) {
-		if ( !rg.textures[i] ) {
+		if ( !rg.textures[i] || rg.textures[i]->placeholder ) {
 			continue;
 		}
 		nglDeleteTextures( 1, &rg.textures[i]->id );
@@ -0,0 +1,390 @@
+// rgl_transform.c -- batched sprite quad transforms, replaces a trip through ri.GLM_TransformToGL for every quad
+
+#include "rgl_local.h"
+
+#if defined( __AVX2__ )
+	#include <immintrin.h>
+	#define USING_AVX2
+#elif defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+	#include <emmintrin.h>
+	#define USING_SSE2
+#elif defined( __ARM_NEON ) || defined( __ARM_NEON__ )
+	#include <arm_neon.h>
+	#define USING_NEON
+#endif
+
+// the simd paths are only bit exact with R_TransformQuadLane if nothing gets reassociated or fused into an fma,
+// the makefile builds this file with -ffp-contract=off -fno-fast-math
+#if defined( __FAST_MATH__ )
+	#error "rgl_transform.c must not be compiled with -ffast-math"
+#endif
+
+// same constant glm::radians uses
+#define QUAD_DEG2RAD 0.01745329251994329576923690768489f
+
+// glm rounds its full 4x4 multiplies differently than we do, so its output is only checked to within a few ulps of
+// the largest term that went into each coordinate (measured at ~2.5 ulps, 1.0e-6 is ~8)
+#define QUAD_GLM_TOLERANCE 1.0e-6f
+
+/*
+* R_SetQuadInput: fills in the lane for quad index, origin and rotation are the same
+* as what GLM_TransformToGL takes (origin[2] gets folded into the y axis)
+*/
+void R_SetQuadInput( quadInput_t *in, uint32_t index, const vec3_t origin, const vec2_t scale, float rotation )
+{
+	quadInput_t *block;
+	const uint32_t lane = index % QUAD_BATCH;
+
+	block = &in[ index / QUAD_BATCH ];
+
+	block->x[ lane ] = origin[0];
+	block->y[ lane ] = origin[1] + origin[2];
+	block->scaleX[ lane ] = scale[0];
+	block->scaleY[ lane ] = scale[1];
+	block->cosine[ lane ] = cosf( rotation * QUAD_DEG2RAD );
+	block->sine[ lane ] = sinf( rotation * QUAD_DEG2RAD );
+}
+
+/*
+* R_TransformQuadLane: the reference every simd path has to match, the quad's half extents get
+* rotated into u and v, and since the camera is orthographic the corners are just O +/- U +/- V
+* in clip space. Every operation is done in the same order the simd paths do them in.
+*/
+static void R_TransformQuadLane( const quadInput_t *in, uint32_t lane, polyVert_t *out, const mat4_t m )
+{
+	float hx, hy;
+	float ux, uy, vx, vy;
+	float ox, oy;
+	float Ux, Uy, Vx, Vy;
+
+	hx = 0.5f * in->scaleX[ lane ];
+	hy = 0.5f * in->scaleY[ lane ];
+
+	ux = hx * in->cosine[ lane ];
+	uy = hx * in->sine[ lane ];
+	vx = 0.0f - hy * in->sine[ lane ];
+	vy = hy * in->cosine[ lane ];
+
+	ox = ( m[0][0] * in->x[ lane ] + m[1][0] * in->y[ lane ] ) + m[3][0];
+	oy = ( m[0][1] * in->x[ lane ] + m[1][1] * in->y[ lane ] ) + m[3][1];
+
+	Ux = m[0][0] * ux + m[1][0] * uy;
+	Uy = m[0][1] * ux + m[1][1] * uy;
+	Vx = m[0][0] * vx + m[1][0] * vy;
+	Vy = m[0][1] * vx + m[1][1] * vy;
+
+	out[0].xyz[0] = ( ox + Ux ) + Vx;
+	out[0].xyz[1] = ( oy + Uy ) + Vy;
+	out[1].xyz[0] = ( ox + Ux ) - Vx;
+	out[1].xyz[1] = ( oy + Uy ) - Vy;
+	out[2].xyz[0] = ( ox - Ux ) - Vx;
+	out[2].xyz[1] = ( oy - Uy ) - Vy;
+	out[3].xyz[0] = ( ox - Ux ) + Vx;
+	out[3].xyz[1] = ( oy - Uy ) + Vy;
+}
+
+void R_TransformQuadsScalar( const quadInput_t *in, polyVert_t *out, uint32_t count, const mat4_t viewProj )
+{
+	uint32_t i;
+
+	for ( i = 0; i < count; i++ ) {
+		R_TransformQuadLane( &in[ i / QUAD_BATCH ], i % QUAD_BATCH, out + i * 4, viewProj );
+	}
+}
+
+#if defined( USING_SSE2 ) || defined( USING_AVX2 )
+// writes corner c of four quads, x/y hold one quad per lane
+static GDR_INLINE void R_StoreCornersSSE2( polyVert_t *out, uint32_t c, __m128 x, __m128 y )
+{
+	const __m128 lo = _mm_unpacklo_ps( x, y );
+	const __m128 hi = _mm_unpackhi_ps( x, y );
+
+	_mm_storel_pi( (__m64 *)out[ 0 * 4 + c ].xyz, lo );
+	_mm_storeh_pi( (__m64 *)out[ 1 * 4 + c ].xyz, lo );
+	_mm_storel_pi( (__m64 *)out[ 2 * 4 + c ].xyz, hi );
+	_mm_storeh_pi( (__m64 *)out[ 3 * 4 + c ].xyz, hi );
+}
+#endif
+
+#if defined( USING_SSE2 )
+static uint32_t R_TransformQuadsSIMD( const quadInput_t *in, polyVert_t *out, uint32_t count, const mat4_t m )
+{
+	uint32_t i;
+	const __m128 m00 = _mm_set1_ps( m[0][0] ), m10 = _mm_set1_ps( m[1][0] ), m30 = _mm_set1_ps( m[3][0] );
+	const __m128 m01 = _mm_set1_ps( m[0][1] ), m11 = _mm_set1_ps( m[1][1] ), m31 = _mm_set1_ps( m[3][1] );
+	const __m128 half = _mm_set1_ps( 0.5f );
+	const __m128 zero = _mm_setzero_ps();
+	__m128 hx, hy, ux, uy, vx, vy, ox, oy, Ux, Uy, Vx, Vy;
+
+	for ( i = 0; i + QUAD_BATCH <= count; i += QUAD_BATCH, in++, out += QUAD_BATCH * 4 ) {
+		hx = _mm_mul_ps( half, _mm_loadu_ps( in->scaleX ) );
+		hy = _mm_mul_ps( half, _mm_loadu_ps( in->scaleY ) );
+
+		ux = _mm_mul_ps( hx, _mm_loadu_ps( in->cosine ) );
+		uy = _mm_mul_ps( hx, _mm_loadu_ps( in->sine ) );
+		vx = _mm_sub_ps( zero, _mm_mul_ps( hy, _mm_loadu_ps( in->sine ) ) );
+		vy = _mm_mul_ps( hy, _mm_loadu_ps( in->cosine ) );
+
+		ox = _mm_add_ps( _mm_add_ps( _mm_mul_ps( m00, _mm_loadu_ps( in->x ) ), _mm_mul_ps( m10, _mm_loadu_ps( in->y ) ) ), m30 );
+		oy = _mm_add_ps( _mm_add_ps( _mm_mul_ps( m01, _mm_loadu_ps( in->x ) ), _mm_mul_ps( m11, _mm_loadu_ps( in->y ) ) ), m31 );
+
+		Ux = _mm_add_ps( _mm_mul_ps( m00, ux ), _mm_mul_ps( m10, uy ) );
+		Uy = _mm_add_ps( _mm_mul_ps( m01, ux ), _mm_mul_ps( m11, uy ) );
+		Vx = _mm_add_ps( _mm_mul_ps( m00, vx ), _mm_mul_ps( m10, vy ) );
+		Vy = _mm_add_ps( _mm_mul_ps( m01, vx ), _mm_mul_ps( m11, vy ) );
+
+		R_StoreCornersSSE2( out, 0, _mm_add_ps( _mm_add_ps( ox, Ux ), Vx ), _mm_add_ps( _mm_add_ps( oy, Uy ), Vy ) );
+		R_StoreCornersSSE2( out, 1, _mm_sub_ps( _mm_add_ps( ox, Ux ), Vx ), _mm_sub_ps( _mm_add_ps( oy, Uy ), Vy ) );
+		R_StoreCornersSSE2( out, 2, _mm_sub_ps( _mm_sub_ps( ox, Ux ), Vx ), _mm_sub_ps( _mm_sub_ps( oy, Uy ), Vy ) );
+		R_StoreCornersSSE2( out, 3, _mm_add_ps( _mm_sub_ps( ox, Ux ), Vx ), _mm_add_ps( _mm_sub_ps( oy, Uy ), Vy ) );
+	}
+
+	return i;
+}
+#elif defined( USING_AVX2 )
+static GDR_INLINE __m256 R_LoadQuadPair( const float *a, const float *b )
+{
+	return _mm256_insertf128_ps( _mm256_castps128_ps256( _mm_loadu_ps( a ) ), _mm_loadu_ps( b ), 1 );
+}
+
+// two quadInput_t blocks per iteration
+static uint32_t R_TransformQuadsSIMD( const quadInput_t *in, polyVert_t *out, uint32_t count, const mat4_t m )
+{
+	uint32_t i;
+	const __m256 m00 = _mm256_set1_ps( m[0][0] ), m10 = _mm256_set1_ps( m[1][0] ), m30 = _mm256_set1_ps( m[3][0] );
+	const __m256 m01 = _mm256_set1_ps( m[0][1] ), m11 = _mm256_set1_ps( m[1][1] ), m31 = _mm256_set1_ps( m[3][1] );
+	const __m256 half = _mm256_set1_ps( 0.5f );
+	const __m256 zero = _mm256_setzero_ps();
+	__m256 x, y, cosine, sine;
+	__m256 hx, hy, ux, uy, vx, vy, ox, oy, Ux, Uy, Vx, Vy;
+	__m256 cx[4], cy[4];
+	uint32_t c;
+
+	for ( i = 0; i + QUAD_BATCH * 2 <= count; i += QUAD_BATCH * 2, in += 2, out += QUAD_BATCH * 8 ) {
+		x = R_LoadQuadPair( in[0].x, in[1].x );
+		y = R_LoadQuadPair( in[0].y, in[1].y );
+		cosine = R_LoadQuadPair( in[0].cosine, in[1].cosine );
+		sine = R_LoadQuadPair( in[0].sine, in[1].sine );
+
+		hx = _mm256_mul_ps( half, R_LoadQuadPair( in[0].scaleX, in[1].scaleX ) );
+		hy = _mm256_mul_ps( half, R_LoadQuadPair( in[0].scaleY, in[1].scaleY ) );
+
+		ux = _mm256_mul_ps( hx, cosine );
+		uy = _mm256_mul_ps( hx, sine );
+		vx = _mm256_sub_ps( zero, _mm256_mul_ps( hy, sine ) );
+		vy = _mm256_mul_ps( hy, cosine );
+
+		ox = _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps( m00, x ), _mm256_mul_ps( m10, y ) ), m30 );
+		oy = _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps( m01, x ), _mm256_mul_ps( m11, y ) ), m31 );
+
+		Ux = _mm256_add_ps( _mm256_mul_ps( m00, ux ), _mm256_mul_ps( m10, uy ) );
+		Uy = _mm256_add_ps( _mm256_mul_ps( m01, ux ), _mm256_mul_ps( m11, uy ) );
+		Vx = _mm256_add_ps( _mm256_mul_ps( m00, vx ), _mm256_mul_ps( m10, vy ) );
+		Vy = _mm256_add_ps( _mm256_mul_ps( m01, vx ), _mm256_mul_ps( m11, vy ) );
+
+		cx[0] = _mm256_add_ps( _mm256_add_ps( ox, Ux ), Vx );
+		cy[0] = _mm256_add_ps( _mm256_add_ps( oy, Uy ), Vy );
+		cx[1] = _mm256_sub_ps( _mm256_add_ps( ox, Ux ), Vx );
+		cy[1] = _mm256_sub_ps( _mm256_add_ps( oy, Uy ), Vy );
+		cx[2] = _mm256_sub_ps( _mm256_sub_ps( ox, Ux ), Vx );
+		cy[2] = _mm256_sub_ps( _mm256_sub_ps( oy, Uy ), Vy );
+		cx[3] = _mm256_add_ps( _mm256_sub_ps( ox, Ux ), Vx );
+		cy[3] = _mm256_add_ps( _mm256_sub_ps( oy, Uy ), Vy );
+
+		for ( c = 0; c < 4; c++ ) {
+			R_StoreCornersSSE2( out, c, _mm256_castps256_ps128( cx[c] ), _mm256_castps256_ps128( cy[c] ) );
+			R_StoreCornersSSE2( out + QUAD_BATCH * 4, c, _mm256_extractf128_ps( cx[c], 1 ), _mm256_extractf128_ps( cy[c], 1 ) );
+		}
+	}
+
+	return i;
+}
+#elif defined( USING_NEON )
+static GDR_INLINE void R_StoreCornersNEON( polyVert_t *out, uint32_t c, float32x4_t x, float32x4_t y )
+{
+	const float32x4x2_t xy = vzipq_f32( x, y );
+
+	vst1_f32( out[ 0 * 4 + c ].xyz, vget_low_f32( xy.val[0] ) );
+	vst1_f32( out[ 1 * 4 + c ].xyz, vget_high_f32( xy.val[0] ) );
+	vst1_f32( out[ 2 * 4 + c ].xyz, vget_low_f32( xy.val[1] ) );
+	vst1_f32( out[ 3 * 4 + c ].xyz, vget_high_f32( xy.val[1] ) );
+}
+
+static uint32_t R_TransformQuadsSIMD( const quadInput_t *in, polyVert_t *out, uint32_t count, const mat4_t m )
+{
+	uint32_t i;
+	const float32x4_t m00 = vdupq_n_f32( m[0][0] ), m10 = vdupq_n_f32( m[1][0] ), m30 = vdupq_n_f32( m[3][0] );
+	const float32x4_t m01 = vdupq_n_f32( m[0][1] ), m11 = vdupq_n_f32( m[1][1] ), m31 = vdupq_n_f32( m[3][1] );
+	const float32x4_t half = vdupq_n_f32( 0.5f );
+	const float32x4_t zero = vdupq_n_f32( 0.0f );
+	float32x4_t hx, hy, ux, uy, vx, vy, ox, oy, Ux, Uy, Vx, Vy;
+
+	// no vmlaq here, it's fused on some cores and the output has to match R_TransformQuadLane
+	for ( i = 0; i + QUAD_BATCH <= count; i += QUAD_BATCH, in++, out += QUAD_BATCH * 4 ) {
+		hx = vmulq_f32( half, vld1q_f32( in->scaleX ) );
+		hy = vmulq_f32( half, vld1q_f32( in->scaleY ) );
+
+		ux = vmulq_f32( hx, vld1q_f32( in->cosine ) );
+		uy = vmulq_f32( hx, vld1q_f32( in->sine ) );
+		vx = vsubq_f32( zero, vmulq_f32( hy, vld1q_f32( in->sine ) ) );
+		vy = vmulq_f32( hy, vld1q_f32( in->cosine ) );
+
+		ox = vaddq_f32( vaddq_f32( vmulq_f32( m00, vld1q_f32( in->x ) ), vmulq_f32( m10, vld1q_f32( in->y ) ) ), m30 );
+		oy = vaddq_f32( vaddq_f32( vmulq_f32( m01, vld1q_f32( in->x ) ), vmulq_f32( m11, vld1q_f32( in->y ) ) ), m31 );
+
+		Ux = vaddq_f32( vmulq_f32( m00, ux ), vmulq_f32( m10, uy ) );
+		Uy = vaddq_f32( vmulq_f32( m01, ux ), vmulq_f32( m11, uy ) );
+		Vx = vaddq_f32( vmulq_f32( m00, vx ), vmulq_f32( m10, vy ) );
+		Vy = vaddq_f32( vmulq_f32( m01, vx ), vmulq_f32( m11, vy ) );
+
+		R_StoreCornersNEON( out, 0, vaddq_f32( vaddq_f32( ox, Ux ), Vx ), vaddq_f32( vaddq_f32( oy, Uy ), Vy ) );
+		R_StoreCornersNEON( out, 1, vsubq_f32( vaddq_f32( ox, Ux ), Vx ), vsubq_f32( vaddq_f32( oy, Uy ), Vy ) );
+		R_StoreCornersNEON( out, 2, vsubq_f32( vsubq_f32( ox, Ux ), Vx ), vsubq_f32( vsubq_f32( oy, Uy ), Vy ) );
+		R_StoreCornersNEON( out, 3, vaddq_f32( vsubq_f32( ox, Ux ), Vx ), vaddq_f32( vsubq_f32( oy, Uy ), Vy ) );
+	}
+
+	return i;
+}
+#endif
+
+/*
+* R_TransformQuads: writes the clip space corners of count quads into out[ i * 4 ... i * 4 + 3 ].xyz,
+* viewProj has to be affine, which it always is for our orthographic cameras
+*/
+void R_TransformQuads( const quadInput_t *in, polyVert_t *out, uint32_t count, const mat4_t viewProj )
+{
+	uint32_t i;
+
+#if defined( USING_SSE2 ) || defined( USING_AVX2 ) || defined( USING_NEON )
+	i = R_TransformQuadsSIMD( in, out, count, viewProj );
+#else
+	i = 0;
+#endif
+
+	// whatever didn't fill a whole batch
+	for ( ; i < count; i++ ) {
+		R_TransformQuadLane( &in[ i / QUAD_BATCH ], i % QUAD_BATCH, out + i * 4, viewProj );
+	}
+}
+
+const char *R_QuadTransformPath( void )
+{
+#if defined( USING_AVX2 )
+	return "avx2";
+#elif defined( USING_SSE2 )
+	return "sse2";
+#elif defined( USING_NEON )
+	return "neon";
+#else
+	return "scalar";
+#endif
+}
+
+/*
+* R_QuadBench_f: times R_TransformQuads against the scalar path and a GLM_TransformToGL call per quad, and checks that
+* the simd output matches the scalar output exactly and glm's within QUAD_GLM_TOLERANCE
+*/
+void R_QuadBench_f( void )
+{
+	uint32_t numQuads, numIterations;
+	uint32_t i, j, numMismatched;
+	uint64_t start, simdMsec, scalarMsec, glmMsec;
+	quadInput_t *in;
+	polyVert_t *simdOut, *scalarOut, *glmOut;
+	vec3_t *origins;
+	vec2_t *scales;
+	float *rotations;
+	vec3_t xyz[4];
+	float error, maxError, magnitude;
+	uint32_t numOutside;
+	mat4_t vpm;
+
+	numQuads = MAX_RENDER_ENTITIES;
+	numIterations = 1000;
+	if ( ri.Cmd_Argc() > 1 ) {
+		numQuads = MAX( 1, atoi( ri.Cmd_Argv( 1 ) ) );
+	}
+	if ( ri.Cmd_Argc() > 2 ) {
+		numIterations = MAX( 1, atoi( ri.Cmd_Argv( 2 ) ) );
+	}
+
+	// GLM_TransformToGL always uses the game's camera, so compare against the last view we rendered
+	Mat4Copy( rg.viewData.camera.viewProjectionMatrix, vpm );
+
+	origins = (vec3_t *)ri.Hunk_AllocateTempMemory( sizeof( *origins ) * numQuads );
+	scales = (vec2_t *)ri.Hunk_AllocateTempMemory( sizeof( *scales ) * numQuads );
+	rotations = (float *)ri.Hunk_AllocateTempMemory( sizeof( *rotations ) * numQuads );
+	in = (quadInput_t *)ri.Hunk_AllocateTempMemory( sizeof( *in ) * PAD( numQuads, QUAD_BATCH ) / QUAD_BATCH );
+	simdOut = (polyVert_t *)ri.Hunk_AllocateTempMemory( sizeof( *simdOut ) * numQuads * 4 );
+	scalarOut = (polyVert_t *)ri.Hunk_AllocateTempMemory( sizeof( *scalarOut ) * numQuads * 4 );
+	glmOut = (polyVert_t *)ri.Hunk_AllocateTempMemory( sizeof( *glmOut ) * numQuads * 4 );
+
+	srand( 0 );
+	for ( i = 0; i < numQuads; i++ ) {
+		VectorSet( origins[i], (float)( rand() % 256 ) + (float)rand() / RAND_MAX, (float)( rand() % 256 ), (float)( rand() % 4 ) );
+		VectorSet2( scales[i], 0.5f + (float)rand() / RAND_MAX, 0.5f + (float)rand() / RAND_MAX );
+		rotations[i] = ( i & 1 ) ? (float)( rand() % 360 ) : 0.0f;
+		R_SetQuadInput( in, i, origins[i], scales[i], rotations[i] );
+	}
+
+	start = ri.Milliseconds();
+	for ( j = 0; j < numIterations; j++ ) {
+		R_TransformQuads( in, simdOut, numQuads, vpm );
+	}
+	simdMsec = ri.Milliseconds() - start;
+
+	start = ri.Milliseconds();
+	for ( j = 0; j < numIterations; j++ ) {
+		R_TransformQuadsScalar( in, scalarOut, numQuads, vpm );
+	}
+	scalarMsec = ri.Milliseconds() - start;
+
+	start = ri.Milliseconds();
+	for ( j = 0; j < numIterations; j++ ) {
+		for ( i = 0; i < numQuads; i++ ) {
+			ri.GLM_TransformToGL( origins[i], xyz, scales[i], rotations[i], vpm );
+			VectorCopy2( glmOut[ i * 4 + 0 ].xyz, xyz[0] );
+			VectorCopy2( glmOut[ i * 4 + 1 ].xyz, xyz[1] );
+			VectorCopy2( glmOut[ i * 4 + 2 ].xyz, xyz[2] );
+			VectorCopy2( glmOut[ i * 4 + 3 ].xyz, xyz[3] );
+		}
+	}
+	glmMsec = ri.Milliseconds() - start;
+
+	numMismatched = 0;
+	numOutside = 0;
+	maxError = 0.0f;
+	for ( i = 0; i < numQuads * 4; i++ ) {
+		if ( memcmp( simdOut[i].xyz, scalarOut[i].xyz, sizeof( vec2_t ) ) ) {
+			numMismatched++;
+		}
+
+		// relative to the terms rather than the result, a corner right under the camera is the difference of two
+		// large numbers and lands near zero
+		for ( j = 0; j < 2; j++ ) {
+			magnitude = 1.0f + fabsf( vpm[0][j] * origins[ i / 4 ][0] ) + fabsf( vpm[1][j] * ( origins[ i / 4 ][1] + origins[ i / 4 ][2] ) )
+				+ fabsf( vpm[3][j] );
+			error = fabsf( simdOut[i].xyz[j] - glmOut[i].xyz[j] ) / magnitude;
+			if ( error > QUAD_GLM_TOLERANCE ) {
+				numOutside++;
+			}
+			maxError = MAX( maxError, error );
+		}
+	}
+
+	ri.Printf( PRINT_INFO, "r_quadbench: %u quads x %u iterations, %s path\n", numQuads, numIterations, R_QuadTransformPath() );
+	ri.Printf( PRINT_INFO, "%-8s %8lu msec\n", R_QuadTransformPath(), simdMsec );
+	ri.Printf( PRINT_INFO, "%-8s %8lu msec\n", "scalar", scalarMsec );
+	ri.Printf( PRINT_INFO, "%-8s %8lu msec\n", "glm", glmMsec );
+	ri.Printf( PRINT_INFO, "r_quadbench: %u vertices differ between the %s and scalar paths, %u outside glm's by more than %g"
+		" (max %g), %s\n", numMismatched, R_QuadTransformPath(), numOutside, QUAD_GLM_TOLERANCE, maxError,
+		numMismatched || numOutside ? "FAILED" : "passed" );
+
+	ri.Hunk_FreeTempMemory( glmOut );
+	ri.Hunk_FreeTempMemory( scalarOut );
+	ri.Hunk_FreeTempMemory( simdOut );
+	ri.Hunk_FreeTempMemory( in );
+	ri.Hunk_FreeTempMemory( rotations );
+	ri.Hunk_FreeTempMemory( scales );
+	ri.Hunk_FreeTempMemory( origins );
+}
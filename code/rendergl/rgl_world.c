@@ -83,6 +83,108 @@ static void R_CalcSpriteTextureCoords( uint32_t x, uint32_t y, uint32_t spriteWi
 	(*texCoords)[3][1] = max[1];
 }
 
+/*
+* R_BuildWorldChunks: splits a width x height tile map into chunks and returns how many there are, vertices
+* are laid out chunk by chunk so that each one is a contiguous range of the world buffer
+*/
+uint32_t R_BuildWorldChunks( worldChunk_t *chunks, uint32_t width, uint32_t height )
+{
+	uint32_t x, y;
+	uint32_t numChunks, firstVertex;
+	worldChunk_t *chunk;
+
+	numChunks = 0;
+	firstVertex = 0;
+	for ( y = 0; y < height; y += WORLD_CHUNK_SIZE ) {
+		for ( x = 0; x < width; x += WORLD_CHUNK_SIZE ) {
+			chunk = &chunks[ numChunks++ ];
+
+			chunk->x = x;
+			chunk->y = y;
+			chunk->width = MIN( WORLD_CHUNK_SIZE, width - x );
+			chunk->height = MIN( WORLD_CHUNK_SIZE, height - y );
+			chunk->numTiles = chunk->width * chunk->height;
+			chunk->firstVertex = firstVertex;
+			chunk->dirty = qfalse;
+
+			firstVertex += chunk->numTiles * 4;
+
+			// tile x,y is centered on x,height - y
+			chunk->bounds.mins[0] = (float)x - 0.5f;
+			chunk->bounds.maxs[0] = (float)( x + chunk->width - 1 ) + 0.5f;
+			chunk->bounds.mins[1] = (float)( height - ( y + chunk->height - 1 ) ) - 0.5f;
+			chunk->bounds.maxs[1] = (float)( height - y ) + 0.5f;
+			chunk->bounds.mins[2] = 0.0f;
+			chunk->bounds.maxs[2] = 0.0f;
+		}
+	}
+
+	return numChunks;
+}
+
+static void R_BakeWorldChunkTexCoords( const world_t *world, const worldChunk_t *chunk )
+{
+	uint32_t y, x;
+	uint32_t index;
+	texCoord_t *uv;
+
+	uv = world->uv + chunk->firstVertex;
+	for ( y = chunk->y; y < chunk->y + chunk->height; y++ ) {
+		for ( x = chunk->x; x < chunk->x + chunk->width; x++ ) {
+			index = world->tiles[ y * world->width + x ].index;
+			if ( index >= world->numSprites ) {
+				index = 0;
+			}
+			memcpy( uv, world->sprites[ index ], sizeof( spriteCoord_t ) );
+			uv += 4;
+		}
+	}
+}
+
+/*
+* R_BakeWorldChunk: the positions are static world space quads, tile_vp does the transform
+*/
+static void R_BakeWorldChunk( const worldChunk_t *chunk )
+{
+	uint32_t y, x;
+	vec2_t pos;
+	vec2_t *xyz;
+	color4ub_t *color;
+	worldPos_t *worldPos;
+
+	xyz = rg.world->xyz + chunk->firstVertex;
+	worldPos = rg.world->worldPos + chunk->firstVertex;
+	color = rg.world->color + chunk->firstVertex;
+	for ( y = chunk->y; y < chunk->y + chunk->height; y++ ) {
+		for ( x = chunk->x; x < chunk->x + chunk->width; x++ ) {
+			pos[0] = x;
+			pos[1] = rg.world->height - y;
+
+			// same winding GLM_TransformToGL uses
+			VectorSet2( xyz[0], pos[0] + 0.5f, pos[1] + 0.5f );
+			VectorSet2( xyz[1], pos[0] + 0.5f, pos[1] - 0.5f );
+			VectorSet2( xyz[2], pos[0] - 0.5f, pos[1] - 0.5f );
+			VectorSet2( xyz[3], pos[0] - 0.5f, pos[1] + 0.5f );
+
+			VectorSet2( worldPos[0], x, y );
+			VectorSet2( worldPos[1], x, y );
+			VectorSet2( worldPos[2], x, y );
+			VectorSet2( worldPos[3], x, y );
+
+			VectorCopy4( color[0].rgba, colorWhite );
+			VectorCopy4( color[1].rgba, colorWhite );
+			VectorCopy4( color[2].rgba, colorWhite );
+			VectorCopy4( color[3].rgba, colorWhite );
+
+			xyz += 4;
+			worldPos += 4;
+			color += 4;
+		}
+	}
+
+	R_BakeWorldChunkTexCoords( rg.world, chunk );
+}
+
 static void R_GenerateTexCoords( tile2d_info_t *info )
 {
 	uint32_t y, x;
@@ -91,13 +193,6 @@ static void R_GenerateTexCoords( tile2d_info_t *info )
 	uint32_t sheetWidth, sheetHeight;
 	const texture_t *image;
 	char texture[MAX_NPATH];
-	vec3_t tmp1, tmp2;
-	drawVert_t *vtx;
-	spriteCoord_t *sprites;
-	vec2_t *xyz;
-	texCoord_t *uv;
-	color4ub_t *color;
-	worldPos_t *worldPos;
 
 	COM_StripExtension( info->texture, texture, sizeof( texture ) );
 	if ( texture[ strlen( texture ) - 1 ] == '.' ) {
@@ -111,6 +206,7 @@ static void R_GenerateTexCoords( tile2d_info_t *info )
 	}
 
 	image = rg.world->shader->stages[0]->bundle[0].image[0];
+	R_FinishImage( rg.world->shader->stages[0]->bundle[0].image[0] );
 
 	// we might be getting higher quality textures, so scale coordinates appropriately
 	scaleWidth = image->width / info->imageWidth;
@@ -128,283 +224,122 @@ static void R_GenerateTexCoords( tile2d_info_t *info )
 	ri.Printf( PRINT_DEVELOPER, "Generating worldData tileset %ux%u:%ux%u, %u sprites, (%ux%u tiles, %0.02fx%0.02f scale)\n", info->imageWidth, info->imageHeight,
 		info->tileWidth, info->tileHeight, info->numTiles, info->tileCountX, info->tileCountY, scaleWidth, scaleHeight );
 
-	sprites = (spriteCoord_t *)ri.Hunk_AllocateTempMemory( sizeof( *sprites ) * info->tileCountX * info->tileCountY );
+	// kept around so that a dirty chunk can be re-baked without reloading the tileset
+	rg.world->numSprites = info->tileCountX * info->tileCountY;
+	rg.world->sprites = (spriteCoord_t *)ri.Hunk_Alloc( sizeof( *rg.world->sprites ) * rg.world->numSprites, h_low );
 
 	for ( y = 0; y < info->tileCountY; y++ ) {
 		for ( x = 0; x < info->tileCountX; x++ ) {
 			R_CalcSpriteTextureCoords( x, y, info->tileWidth, info->tileHeight, sheetWidth, sheetHeight,
-				&sprites[ y * info->tileCountX + x ] );
+				&rg.world->sprites[ y * info->tileCountX + x ] );
 		}
 	}
 
-	xyz = rg.world->xyz;
-	uv = rg.world->uv;
-	worldPos = rg.world->worldPos;
-	color = rg.world->color;
-	for ( y = 0; y < rg.world->height; y++ ) {
-		for ( x = 0; x < rg.world->width; x++ ) {
-		#if 0
-			VectorCopy2( uv[0], sprites[ rg.world->tiles[ y * rg.world->width + x ].index ][0] );
-			VectorCopy2( uv[1], sprites[ rg.world->tiles[ y * rg.world->width + x ].index ][1] );
-			VectorCopy2( uv[2], sprites[ rg.world->tiles[ y * rg.world->width + x ].index ][2] );
-			VectorCopy2( uv[3], sprites[ rg.world->tiles[ y * rg.world->width + x ].index ][3] );
-		#else
-			memcpy( uv, sprites[ rg.world->tiles[ y * rg.world->width + x ].index ], sizeof( spriteCoord_t ) );
-		#endif
-
-			VectorSet2( worldPos[0], x, y );
-			VectorSet2( worldPos[1], x, y );
-			VectorSet2( worldPos[2], x, y );
-			VectorSet2( worldPos[3], x, y );
-
-			VectorCopy4( color[0].rgba, colorWhite );
-			VectorCopy4( color[1].rgba, colorWhite );
-			VectorCopy4( color[2].rgba, colorWhite );
-			VectorCopy4( color[3].rgba, colorWhite );
-			
-			xyz += 4;
-			uv += 4;
-			worldPos += 4;
-			color += 4;
-		}
+	for ( i = 0; i < rg.world->numChunks; i++ ) {
+		R_BakeWorldChunk( &rg.world->chunks[i] );
 	}
-//	R_SetupTileLighting();
-	ri.Hunk_FreeTempMemory( sprites );
 }
 
+static void R_FlushWorldTexCoords( const world_t *world, const worldChunk_t *chunk )
+{
+	const uint64_t offset = sizeof( texCoord_t ) * chunk->firstVertex;
+	const uint64_t size = sizeof( texCoord_t ) * chunk->numTiles * 4;
 
-float stsvco_valenceScore( const uint32_t numTris ) {
-    return 2 * powf( numTris, -0.5f );
+	if ( glContext.directStateAccess ) {
+		nglFlushMappedNamedBufferRange( world->buffer->vertex[ ATTRIB_INDEX_TEXCOORD ].id, offset, size );
+	} else {
+		VBO_Bind( world->buffer );
+		nglFlushMappedBufferRange( GL_ARRAY_BUFFER, world->buffer->attribs[ ATTRIB_INDEX_TEXCOORD ].offset + offset, size );
+	}
 }
 
-#define LRU_CACHE_SIZE 64
-
-static void R_OptimizeVertexCache( void )
+/*
+* R_SetWorldTile: points the tile at x,y at another tileset sprite and flags its chunk for re-baking,
+* returns qfalse if the tile's out of range
+*/
+static qboolean R_SetWorldTile( world_t *world, uint32_t x, uint32_t y, int32_t index )
 {
-	glIndex_t *pIndices;
-	drawVert_t *pVerts;
-	uint64_t i, j, t, v;
+	worldChunk_t *chunk;
 
-	typedef struct {
-		int numAdjecentTris;
-		int numTrisLeft;
-		int triListIndex;
-		int cacheIndex;
-	} vertex_t;
+	if ( x >= world->width || y >= world->height ) {
+		return qfalse;
+	}
 
-	typedef struct {
-		int vertices[3];
-		qboolean drawn;
-	} triangle_t;
+	world->tiles[ y * world->width + x ].index = index;
 
-	vertex_t *vertices;
-	triangle_t *triangles;
-	uint32_t *vertToTri;
+	chunk = &world->chunks[ ( y / WORLD_CHUNK_SIZE ) * world->chunksWide + ( x / WORLD_CHUNK_SIZE ) ];
+	if ( !chunk->dirty ) {
+		chunk->dirty = qtrue;
+		world->numDirtyChunks++;
+	}
+	return qtrue;
+}
 
-	const uint32_t numTriangles = rg.world->numIndices / 3;
+/*
+* RE_SetWorldTile: the game changed the tile at x,y, its chunk gets re-baked before the next draw
+*/
+void RE_SetWorldTile( uint32_t x, uint32_t y, int32_t index )
+{
+	if ( !rg.world ) {
+		return;
+	}
 
-	pIndices = rg.world->indices;
-	pVerts = rg.world->vertices;
+	// the backend clears the flags when it re-bakes
+	R_SyncRenderThread();
 
-	vertices = ri.Hunk_AllocateTempMemory( rg.world->numVertices * sizeof( *vertices ) );
-	triangles = ri.Hunk_AllocateTempMemory( numTriangles * sizeof( *triangles ) );
-	
-	for ( i = 0; i < rg.world->numVertices; ++i ) {
-		vertices[i].numAdjecentTris = 0;
-		vertices[i].numTrisLeft = 0;
-		vertices[i].triListIndex = 0;
-		vertices[i].cacheIndex = -1;
+	if ( !R_SetWorldTile( rg.world, x, y, index ) ) {
+		ri.Printf( PRINT_DEVELOPER, "RE_SetWorldTile: tile %u,%u out of range\n", x, y );
 	}
-	
-	for ( i = 0; i < numTriangles; ++i ) {
-		for ( j = 0; j < 3; ++j ) {
-			triangles[i].vertices[j] = pIndices[ i * 3 + j ];
-			++vertices[ triangles[i].vertices[j] ].numAdjecentTris;
+}
+
+/*
+* R_BakeDirtyWorldChunks: re-bakes the texture coordinates of every dirty chunk and flushes them to the
+* world buffer if flush is set, returns the number of bytes baked
+*/
+static uint64_t R_BakeDirtyWorldChunks( world_t *world, qboolean flush )
+{
+	uint32_t i;
+	uint64_t bytes;
+	worldChunk_t *chunk;
+
+	bytes = 0;
+	for ( i = 0; i < world->numChunks && world->numDirtyChunks; i++ ) {
+		chunk = &world->chunks[i];
+		if ( !chunk->dirty ) {
+			continue;
 		}
-		triangles[i].drawn = false;
-	}
-	
-	// Loop through and find index for the tri list for vertex->tri
-	for ( i = 1; i < rg.world->numVertices; ++i ) {
-		vertices[i].triListIndex = vertices[ i - 1 ].triListIndex+vertices[ i - 1 ].numAdjecentTris;
-	}
-	
-	const int numVertToTri = vertices[ rg.world->numVertices - 1 ].triListIndex+vertices[ rg.world->numVertices - 1 ].numAdjecentTris;
-	vertToTri = ri.Hunk_AllocateTempMemory( numVertToTri * sizeof( *vertToTri ) );
-	
-	for ( i = 0; i < numTriangles; ++i ) {
-		for ( j = 0; j < 3; ++j ) {
-			const int index = triangles[ i ].vertices[ j ];
-			const int triListIndex = vertices[ index ].triListIndex + vertices[index].numTrisLeft;
-			vertToTri[ triListIndex ] = i;
-			++vertices[index].numTrisLeft;
+
+		R_BakeWorldChunkTexCoords( world, chunk );
+		if ( flush ) {
+			R_FlushWorldTexCoords( world, chunk );
 		}
-	}
-	
-	// Make LRU cache
-	const int LRUCacheSize = 64;
-	int *LRUCache = alloca( LRUCacheSize * sizeof( *LRUCache ) );
-	float *scoring = alloca( LRUCacheSize * sizeof( *scoring ) );
 
-	for ( i = 0; i < LRUCacheSize; ++i ) {
-		LRUCache[i] = -1;
-		scoring[i] = -1.0f;
+		chunk->dirty = qfalse;
+		world->numDirtyChunks--;
+
+		bytes += sizeof( texCoord_t ) * chunk->numTiles * 4;
 	}
-	
-	int numIndicesDone = 0;
-	while ( numIndicesDone != rg.world->numIndices ) {
-		// update vertex scoring
-		for ( i = 0; i < LRUCacheSize && LRUCache[i] >= 0; ++i ) {
-			int vertexIndex = LRUCache[i];
-			if ( vertexIndex != -1 ) {
-				// Do scoring based on cache position
-				if ( i < 3 ) {
-					scoring[i] = 0.75f;
-				} else {
-					const float scaler = 1.0f / ( LRUCacheSize - 3 );
-					const float scoreBase = 1.0f - ( i - 3 ) * scaler;
-					scoring[i] = powf ( scoreBase, 1.5f );
-				}
-				// Add score based on tris left for vertex (valence score)
-				const int numTrisLeft = vertices[ vertexIndex ].numTrisLeft;
-				scoring[i] += stsvco_valenceScore(numTrisLeft);
-			}
-		}
-		// find triangle to draw based on score
-		// Update score for all triangles with vertexes in cache
-		int triangleToDraw = -1;
-		float bestTriScore = 0.0f;
-		for ( i = 0; i < LRUCacheSize && LRUCache[i] >= 0; ++i ) {
-			const int vIndex = LRUCache[i];
-			if ( vertices[vIndex].numTrisLeft > 0 ) {
-				for ( t = 0; t < vertices[vIndex].numAdjecentTris; ++t ) {
-					const int tIndex = vertToTri[ vertices[vIndex].triListIndex + t];
-					if ( !triangles[ tIndex ].drawn ) {
-						float triScore = .0f;
-						for ( v = 0; v < 3; ++v ) {
-							const int cacheIndex = vertices[ triangles[ tIndex ].vertices[v] ].cacheIndex;
-							if ( cacheIndex >= 0 ) {
-								triScore += scoring[ cacheIndex ];
-							}
-						}
-						if ( triScore > bestTriScore ) {
-							triangleToDraw = tIndex;
-							bestTriScore = triScore;
-						}
-					}
-				}
-			}
-		}
-		
-		if ( triangleToDraw < 0 ) {
-			// No triangle can be found by heuristic, simply choose first and best
-			for ( t = 0; t < numTriangles; ++t ) {
-				if ( !triangles[t].drawn ) {
-					//compute valence for each vertex
-					float triScore = .0f;
-					for ( v = 0; v < 3; ++v ) {
-						const uint32_t vertexIndex = triangles[t].vertices[v];
-						// Add score based on tris left for vertex (valence score)
-						const int numTrisLeft = vertices[ vertexIndex ].numTrisLeft;
-						triScore += stsvco_valenceScore( numTrisLeft );
-					}
-					if ( triScore >= bestTriScore ) {
-						triangleToDraw = t;
-						bestTriScore = triScore;
-					}
-				}
-			}
-		}
-		
-		// update cache
-		int cacheIndex = 3;
-		int numVerticesFound = 0;
-		while ( LRUCache[numVerticesFound] >= 0 && numVerticesFound < 3 && cacheIndex < LRUCacheSize ) {
-			qboolean topOfCacheInTri = qfalse;
-			// Check if index is in triangle
-			for ( i = 0; i < 3; ++i ) {
-				if( triangles[triangleToDraw].vertices[i] == LRUCache[numVerticesFound]) {
-					++numVerticesFound;
-					topOfCacheInTri = qtrue;
-					break;
-				}
-			}
-			
-			if ( !topOfCacheInTri ) {
-				int topIndex = LRUCache[ numVerticesFound ];
-				for ( int j = numVerticesFound; j < 2; ++j) {
-					LRUCache[j] = LRUCache[j+1];
-				}
-				LRUCache[2] = LRUCache[cacheIndex];
-				if ( LRUCache[2] >= 0 ) {
-					vertices[ LRUCache[2] ].cacheIndex = -1;
-				}
-				
-				LRUCache[cacheIndex] = topIndex;
-				if ( topIndex >= 0 ) {
-					vertices[ topIndex ].cacheIndex = cacheIndex;
-				}
-				++cacheIndex;
-			}
-		}
-		
-		// Set triangle as drawn
-		for ( v = 0; v < 3; ++v ) {
-			const int index = triangles[triangleToDraw].vertices[v];
-			
-			LRUCache[ v ] = index;
-			vertices[ index ].cacheIndex = v;
-			
-			--vertices[index].numTrisLeft;
-			
-			pIndices[ numIndicesDone ] = index;
-			++numIndicesDone;
-		}
-		
-		
-		triangles[ triangleToDraw ].drawn = qtrue;
-	}
-	// Memory cleanup
-	ri.Hunk_FreeTempMemory( vertToTri );
-	ri.Hunk_FreeTempMemory( triangles );
-	ri.Hunk_FreeTempMemory( vertices );
+
+	return bytes;
 }
 
-float R_CalcCacheEfficiency( void )
+/*
+* R_RebakeWorldChunks: re-bakes and uploads every dirty chunk of the loaded world, returns the number of bytes uploaded
+*/
+uint64_t R_RebakeWorldChunks( void )
 {
-	uint32_t numCacheMisses;
-	glIndex_t index;
-	int cache[ LRU_CACHE_SIZE ];
-	int i, c;
-	qboolean foundInCache;
-
-	numCacheMisses = 0;
-
-    for ( i = 0; i < LRU_CACHE_SIZE; ++i ) {
-		cache[i] = -1;
-	}
-    
-    for ( i = 0; i < rg.world->numIndices; ++i ) {
-    	index = rg.world->indices[i];
-
-        // check if vertex in cache
-        foundInCache = qfalse;
-        for ( c = 0; c < LRU_CACHE_SIZE && cache[c] >= 0 && !foundInCache; ++c) {
-            if ( cache[ c ] == index ) {
-				foundInCache = qtrue;
-			}
-        }
-        
-        if ( !foundInCache ) {
-            ++numCacheMisses;
-            for ( c = LRU_CACHE_SIZE - 1; c  >= 1; --c ) {
-                cache[c] = cache[ c-1 ];
-            }
-            cache[0] = index;
-        }
-    }
-    
-    return (float)numCacheMisses / (float)( rg.world->numIndices / 3 );
+	uint64_t bytes;
+
+	if ( !rg.world->numDirtyChunks ) {
+		return 0;
+	}
+
+	bytes = R_BakeDirtyWorldChunks( rg.world, qtrue );
+	GL_CheckErrors();
+
+	backend.pc.c_worldTilesBaked += bytes / ( sizeof( texCoord_t ) * 4 );
+
+	return bytes;
 }
 
 static void R_ProcessLights( void )
@@ -517,7 +452,14 @@ static void R_InitWorldBuffer( tile2d_header_t *theader )
 	vec3_t *normal;
 	float f;
 
-	rg.world->numIndices = rg.world->width * rg.world->height * 6;
+	rg.world->chunksWide = ( rg.world->width + WORLD_CHUNK_SIZE - 1 ) / WORLD_CHUNK_SIZE;
+	rg.world->chunksHigh = ( rg.world->height + WORLD_CHUNK_SIZE - 1 ) / WORLD_CHUNK_SIZE;
+	rg.world->chunks = ri.Hunk_Alloc( sizeof( *rg.world->chunks ) * rg.world->chunksWide * rg.world->chunksHigh, h_low );
+	rg.world->visibleChunks = ri.Hunk_Alloc( sizeof( *rg.world->visibleChunks ) * rg.world->chunksWide * rg.world->chunksHigh, h_low );
+	rg.world->numChunks = R_BuildWorldChunks( rg.world->chunks, rg.world->width, rg.world->height );
+
+	// every chunk is drawn with its own base vertex, so they can all share one chunk's worth of indices
+	rg.world->numIndices = MIN( rg.world->width * rg.world->height, WORLD_CHUNK_TILES ) * 6;
 	rg.world->numVertices = rg.world->width * rg.world->height * 4;
 
 	memset( attribs, 0, sizeof( attribs ) );
@@ -562,8 +504,8 @@ static void R_InitWorldBuffer( tile2d_header_t *theader )
 	attribs[ATTRIB_INDEX_BITANGENT].normalized	= GL_FALSE;
 	attribs[ATTRIB_INDEX_NORMAL].normalized		= GL_FALSE;
 
-	attribs[ATTRIB_INDEX_POSITION].usage		= BUFFER_STREAM;
-	attribs[ATTRIB_INDEX_TEXCOORD].usage		= BUFFER_STATIC;
+	attribs[ATTRIB_INDEX_POSITION].usage		= BUFFER_STATIC;
+	attribs[ATTRIB_INDEX_TEXCOORD].usage		= BUFFER_STREAM; // stays mapped for re-baking dirty chunks
 	attribs[ATTRIB_INDEX_COLOR].usage			= BUFFER_STATIC;
 	attribs[ATTRIB_INDEX_WORLDPOS].usage		= BUFFER_STATIC;
 	attribs[ATTRIB_INDEX_TANGENT].usage			= BUFFER_STATIC;
@@ -606,8 +548,8 @@ static void R_InitWorldBuffer( tile2d_header_t *theader )
 
 		rg.world->buffer->index.target = GL_ELEMENT_ARRAY_BUFFER;
 
-		VBO_MapBuffers( &rg.world->buffer->vertex[ ATTRIB_INDEX_POSITION ], qfalse );
-		VBO_MapBuffers( &rg.world->buffer->vertex[ ATTRIB_INDEX_TEXCOORD ], qtrue );
+		VBO_MapBuffers( &rg.world->buffer->vertex[ ATTRIB_INDEX_POSITION ], qtrue );
+		VBO_MapBuffers( &rg.world->buffer->vertex[ ATTRIB_INDEX_TEXCOORD ], qfalse );
 		VBO_MapBuffers( &rg.world->buffer->vertex[ ATTRIB_INDEX_WORLDPOS ], qtrue );
 		VBO_MapBuffers( &rg.world->buffer->vertex[ ATTRIB_INDEX_COLOR ], qtrue );
 	} else {
@@ -619,7 +561,7 @@ static void R_InitWorldBuffer( tile2d_header_t *theader )
 
 	rg.world->indices = rg.world->buffer->index.data;
 
-	// cache the indices so that we aren't calculating these every frame (there could be thousands)
+	// cache the indices so that we aren't calculating these every frame
 	for ( i = 0, offset = 0; i < rg.world->numIndices; i += 6, offset += 4 ) {
 		rg.world->indices[ i + 0 ] = offset + 0;
 		rg.world->indices[ i + 1 ] = offset + 1;
@@ -630,9 +572,7 @@ static void R_InitWorldBuffer( tile2d_header_t *theader )
 		rg.world->indices[ i + 5 ] = offset + 0;
 	}
 
-	ri.Printf( PRINT_INFO, "Optimizing vertex cache... (Current cache misses: %f)\n", R_CalcCacheEfficiency() );
-	R_OptimizeVertexCache();
-	ri.Printf( PRINT_INFO, "Optimized cache misses: %f\n", R_CalcCacheEfficiency() );
+	ri.Printf( PRINT_DEVELOPER, "Baking %u world chunks (%ux%u tiles each)\n", rg.world->numChunks, WORLD_CHUNK_SIZE, WORLD_CHUNK_SIZE );
 
 	if ( glContext.directStateAccess ) {
 		rg.world->worldPos = (worldPos_t *)rg.world->buffer->vertex[ ATTRIB_INDEX_WORLDPOS ].data;
@@ -663,11 +603,14 @@ static void R_InitWorldBuffer( tile2d_header_t *theader )
 //		nglFlushMappedNamedBufferRange( rg.world->buffer->vertex[ ATTRIB_INDEX_COLOR ].id, 0, sizeof( color4ub_t ) * rg.world->numVertices );
 //		nglFlushMappedNamedBufferRange( rg.world->buffer->index.id, 0, sizeof( glIndex_t ) * rg.world->numIndices );
 
+		nglFlushMappedNamedBufferRange( rg.world->buffer->vertex[ ATTRIB_INDEX_TEXCOORD ].id, 0, sizeof( texCoord_t ) * rg.world->numVertices );
+
 		nglUnmapNamedBuffer( rg.world->buffer->vertex[ ATTRIB_INDEX_WORLDPOS ].id );
-		nglUnmapNamedBuffer( rg.world->buffer->vertex[ ATTRIB_INDEX_TEXCOORD ].id );
+		nglUnmapNamedBuffer( rg.world->buffer->vertex[ ATTRIB_INDEX_POSITION ].id );
 		nglUnmapNamedBuffer( rg.world->buffer->vertex[ ATTRIB_INDEX_COLOR ].id );
 		nglUnmapNamedBuffer( rg.world->buffer->index.id );
 	} else {
+		nglFlushMappedBufferRange( GL_ARRAY_BUFFER, attribs[ ATTRIB_INDEX_POSITION ].offset, sizeof( vec2_t ) * rg.world->numVertices );
 		nglFlushMappedBufferRange( GL_ARRAY_BUFFER, attribs[ ATTRIB_INDEX_WORLDPOS ].offset, sizeof( worldPos_t ) * rg.world->numVertices );
 		nglFlushMappedBufferRange( GL_ARRAY_BUFFER, attribs[ ATTRIB_INDEX_TEXCOORD ].offset, sizeof( vec2_t ) * rg.world->numVertices );
 		nglFlushMappedBufferRange( GL_ARRAY_BUFFER, attribs[ ATTRIB_INDEX_COLOR ].offset, sizeof( color4ub_t ) * rg.world->numVertices );
@@ -697,6 +640,9 @@ void RE_LoadWorldMap( const char *filename )
 		ri.Error(ERR_DROP, "RE_LoadWorldMap: name '%s' too long", filename );
 	}
 
+	// the old world can't go away while the backend is drawing it
+	R_SyncRenderThread();
+
 	if ( rg.worldMapLoaded ) {
 		ri.Error( ERR_DROP, "attempted to reduntantly load world map" );
 	}
@@ -752,6 +698,144 @@ void RE_LoadWorldMap( const char *filename )
 	ri.FS_FreeFile( buffer.v );
 }
 
+#define WORLDBENCH_SPRITES 8 // per side of the synthetic tileset
+
+/*
+* R_WorldBench_f: culls a synthetic width x height map with a camera panning across it and compares it
+* against what the old per-tile path did every frame. Tiles are changed through the same path as
+* RE_SetWorldTile and their chunks re-baked, nothing here touches the GL so it runs headless
+*/
+void R_WorldBench_f( void )
+{
+	uint32_t width, height, numFrames, legacyFrames;
+	uint32_t numChunks, numVisible, frame;
+	uint32_t i, x, y;
+	uint32_t numChanged, numBadUVs;
+	int32_t index;
+	uint64_t start, cullMsec, legacyMsec;
+	uint64_t visibleTotal, tilesTotal, bakeBytes;
+	worldChunk_t *chunks, **visible;
+	world_t world;
+	const worldChunk_t *chunk;
+	mat4_t mvp;
+	vec3_t pos;
+	vec3_t xyz[4];
+	const vec2_t scale = { 1.0f, 1.0f };
+	float cameraX, cameraY;
+
+	width = 512;
+	height = 512;
+	numFrames = 10000;
+	if ( ri.Cmd_Argc() > 1 ) {
+		width = MIN( MAX( 1, atoi( ri.Cmd_Argv( 1 ) ) ), UINT16_MAX );
+	}
+	if ( ri.Cmd_Argc() > 2 ) {
+		height = MIN( MAX( 1, atoi( ri.Cmd_Argv( 2 ) ) ), UINT16_MAX );
+	}
+	if ( ri.Cmd_Argc() > 3 ) {
+		numFrames = MAX( 1, atoi( ri.Cmd_Argv( 3 ) ) );
+	}
+
+	numChunks = ( ( width + WORLD_CHUNK_SIZE - 1 ) / WORLD_CHUNK_SIZE ) * ( ( height + WORLD_CHUNK_SIZE - 1 ) / WORLD_CHUNK_SIZE );
+	chunks = (worldChunk_t *)ri.Hunk_AllocateTempMemory( sizeof( *chunks ) * numChunks );
+	visible = (worldChunk_t **)ri.Hunk_AllocateTempMemory( sizeof( *visible ) * numChunks );
+
+	numChunks = R_BuildWorldChunks( chunks, width, height );
+
+	// just enough of a world for the tiles to be changed and re-baked
+	memset( &world, 0, sizeof( world ) );
+	world.width = width;
+	world.height = height;
+	world.numTiles = width * height;
+	world.chunks = chunks;
+	world.numChunks = numChunks;
+	world.chunksWide = ( width + WORLD_CHUNK_SIZE - 1 ) / WORLD_CHUNK_SIZE;
+	world.chunksHigh = ( height + WORLD_CHUNK_SIZE - 1 ) / WORLD_CHUNK_SIZE;
+	world.numSprites = WORLDBENCH_SPRITES * WORLDBENCH_SPRITES;
+	world.sprites = (spriteCoord_t *)ri.Hunk_AllocateTempMemory( sizeof( *world.sprites ) * world.numSprites );
+	world.tiles = (maptile_t *)ri.Hunk_AllocateTempMemory( sizeof( *world.tiles ) * world.numTiles );
+	world.uv = (texCoord_t *)ri.Hunk_AllocateTempMemory( sizeof( *world.uv ) * world.numTiles * 4 );
+
+	for ( y = 0; y < WORLDBENCH_SPRITES; y++ ) {
+		for ( x = 0; x < WORLDBENCH_SPRITES; x++ ) {
+			R_CalcSpriteTextureCoords( x, y, 32, 32, 32 * WORLDBENCH_SPRITES, 32 * WORLDBENCH_SPRITES,
+				&world.sprites[ y * WORLDBENCH_SPRITES + x ] );
+		}
+	}
+	memset( world.tiles, 0, sizeof( *world.tiles ) * world.numTiles );
+	for ( i = 0; i < numChunks; i++ ) {
+		R_BakeWorldChunkTexCoords( &world, &chunks[i] );
+	}
+
+	visibleTotal = 0;
+	tilesTotal = 0;
+	bakeBytes = 0;
+	numChanged = 0;
+	numBadUVs = 0;
+
+	start = ri.Milliseconds();
+	for ( frame = 0; frame < numFrames; frame++ ) {
+		// pan diagonally across the map, one tile every 4 frames
+		cameraX = (float)( ( frame / 4 ) % width );
+		cameraY = (float)( ( frame / 4 ) % height );
+		Mat4Ortho( cameraX - 12.0f, cameraX + 12.0f, cameraY - 7.0f, cameraY + 7.0f, -1.0f, 1.0f, mvp );
+
+		numVisible = R_CullWorldChunks( chunks, numChunks, mvp, visible );
+		visibleTotal += numVisible;
+		for ( i = 0; i < numVisible; i++ ) {
+			tilesTotal += visible[i]->numTiles;
+		}
+
+		// a tile changing every 16 frames re-bakes one chunk's texture coordinates
+		if ( !( frame & 15 ) ) {
+			chunk = &chunks[ ( frame / 16 ) % numChunks ];
+			x = chunk->x + ( frame / 16 ) % chunk->width;
+			y = chunk->y + ( frame / 16 ) % chunk->height;
+			index = ( frame / 16 + 1 ) % world.numSprites;
+
+			R_SetWorldTile( &world, x, y, index );
+			bakeBytes += R_BakeDirtyWorldChunks( &world, qfalse );
+			numChanged++;
+
+			if ( memcmp( &world.uv[ chunk->firstVertex + ( ( y - chunk->y ) * chunk->width + ( x - chunk->x ) ) * 4 ],
+				world.sprites[ index ], sizeof( spriteCoord_t ) ) )
+			{
+				numBadUVs++;
+			}
+		}
+	}
+	cullMsec = ri.Milliseconds() - start;
+
+	// the old path ran every tile through GLM_TransformToGL and streamed the positions every frame
+	legacyFrames = MIN( numFrames, 16 );
+	start = ri.Milliseconds();
+	for ( frame = 0; frame < legacyFrames; frame++ ) {
+		for ( y = 0; y < height; y++ ) {
+			for ( x = 0; x < width; x++ ) {
+				VectorSet( pos, x, height - y, 0.0f );
+				ri.GLM_TransformToGL( pos, xyz, scale, 0.0f, mvp );
+			}
+		}
+	}
+	legacyMsec = ri.Milliseconds() - start;
+
+	ri.Printf( PRINT_INFO, "r_worldbench: %ux%u tiles, %u chunks of %ux%u, %u frames\n", width, height, numChunks,
+		WORLD_CHUNK_SIZE, WORLD_CHUNK_SIZE, numFrames );
+	ri.Printf( PRINT_INFO, "per-tile: %u tiles transformed, %lu bytes uploaded, %u draws, %.4f msec per frame\n",
+		width * height, (uint64_t)width * height * 4 * sizeof( vec2_t ), 1, (double)legacyMsec / legacyFrames );
+	ri.Printf( PRINT_INFO, "chunked: 0 tiles transformed, %.0f bytes uploaded, %.1f/%u draws, %.0f tiles submitted, %.4f msec per frame\n",
+		(double)bakeBytes / numFrames, (double)visibleTotal / numFrames, numChunks, (double)tilesTotal / numFrames,
+		(double)cullMsec / numFrames );
+	ri.Printf( PRINT_INFO, "r_worldbench: %u tiles changed, %u re-baked with the wrong texture coordinates, %s\n", numChanged,
+		numBadUVs, numBadUVs ? "FAILED" : "passed" );
+
+	ri.Hunk_FreeTempMemory( world.uv );
+	ri.Hunk_FreeTempMemory( world.tiles );
+	ri.Hunk_FreeTempMemory( world.sprites );
+	ri.Hunk_FreeTempMemory( visible );
+	ri.Hunk_FreeTempMemory( chunks );
+}
+
 typedef struct {
 	size_t minOutsideRoot;
 	size_t maxOutsideRoot;
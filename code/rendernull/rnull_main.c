@@ -0,0 +1,269 @@
+// rnull_main.c -- a renderer that doesn't draw anything, loaded with g_renderer "null" so timedemos can run
+// on a machine without a gpu. Everything the game submits is still counted, the backendCounters_t handed
+// back from EndFrame are what the scene would have cost to draw
+
+#include "../engine/n_shared.h"
+#include "../rendercommon/r_public.h"
+#include "../rendercommon/r_types.h"
+
+#define PRINT_INFO 0
+
+refimport_t ri;
+
+static gpuConfig_t glConfig;
+static backendCounters_t pc;
+
+static nhandle_t numHandles;
+static qboolean registered;
+static qboolean imguiActive;
+
+static cvar_t *r_customWidth;
+static cvar_t *r_customHeight;
+
+static void RE_Shutdown( refShutdownCode_t code )
+{
+	ri.Printf( PRINT_INFO, "RE_Shutdown( %i )\n", code );
+
+	if ( imguiActive ) {
+		ri.ImGui_Shutdown();
+		imguiActive = qfalse;
+	}
+
+	ri.FreeAll();
+	registered = qfalse;
+}
+
+static void RE_BeginRegistration( gpuConfig_t *config )
+{
+	r_customWidth = ri.Cvar_Get( "r_customWidth", "1980", CVAR_SAVE );
+	r_customHeight = ri.Cvar_Get( "r_customHeight", "1080", CVAR_SAVE );
+
+	memset( &glConfig, 0, sizeof( glConfig ) );
+	strcpy( glConfig.vendor_string, "GDR Games" );
+	strcpy( glConfig.renderer_string, "null" );
+	strcpy( glConfig.version_string, "0" );
+	glConfig.vidWidth = r_customWidth->i;
+	glConfig.vidHeight = r_customHeight->i;
+	glConfig.windowAspect = (float)glConfig.vidWidth / (float)glConfig.vidHeight;
+	glConfig.displayFrequency = 60;
+	glConfig.maxTextureSize = 16384;
+	glConfig.maxTextureUnits = 16;
+
+	memset( &pc, 0, sizeof( pc ) );
+	numHandles = 0;
+	registered = qtrue;
+
+	*config = glConfig;
+}
+
+// every handle is just unique, nothing gets loaded for it
+static nhandle_t RE_RegisterShader( const char *name )
+{
+	return ++numHandles;
+}
+
+static nhandle_t RE_RegisterSpriteSheet( const char *npath, uint32_t sheetWidth, uint32_t sheetHeight, uint32_t spriteWidth, uint32_t spriteHeight )
+{
+	return ++numHandles;
+}
+
+static nhandle_t RE_RegisterSprite( nhandle_t hSpriteSheet, uint32_t index )
+{
+	return ++numHandles;
+}
+
+static void RE_LoadWorld( const char *name )
+{
+}
+
+static void RE_SetWorldTile( uint32_t x, uint32_t y, int32_t index )
+{
+}
+
+static void RE_EndRegistration( void )
+{
+}
+
+static void RE_WaitRegistered( void )
+{
+	// the game builds its ui with imgui whether or not it's ever drawn
+	if ( !imguiActive ) {
+		ri.ImGui_Init( NULL, NULL );
+		imguiActive = qtrue;
+	}
+}
+
+static void RE_ClearScene( void )
+{
+}
+
+static void RE_BeginScene( const renderSceneRef_t *fd )
+{
+}
+
+static void RE_EndScene( void )
+{
+}
+
+static void RE_AddSpriteToScene( const vec3_t origin, nhandle_t hShader )
+{
+	pc.c_surfaces++;
+	pc.c_bufferVertices += 4;
+	pc.c_bufferIndices += 6;
+}
+
+static void RE_AddPolyToScene( nhandle_t hShader, const polyVert_t *verts, uint32_t numVerts )
+{
+	pc.c_surfaces++;
+	pc.c_bufferVertices += numVerts;
+	if ( numVerts >= 3 ) {
+		pc.c_bufferIndices += ( numVerts - 2 ) * 3;
+	}
+}
+
+static void RE_AddPolyListToScene( const poly_t *polys, uint32_t numPolys )
+{
+	uint32_t i;
+
+	for ( i = 0; i < numPolys; i++ ) {
+		RE_AddPolyToScene( polys[i].hShader, polys[i].verts, polys[i].numVerts );
+	}
+}
+
+static void RE_AddEntityToScene( const renderEntityRef_t *ent )
+{
+	pc.c_surfaces++;
+	pc.c_bufferVertices += 4;
+	pc.c_bufferIndices += 6;
+}
+
+static void RE_AddDynamicLightToScene( const vec3_t origin, float range, float constant, float linear, float quadratic,
+	float brightness, const vec3_t color )
+{
+}
+
+static void RE_DrawImage( float x, float y, float w, float h, float u1, float v1, float u2, float v2, nhandle_t hShader )
+{
+	pc.c_surfaces++;
+	pc.c_bufferVertices += 4;
+	pc.c_bufferIndices += 6;
+	pc.c_drawCalls++;
+}
+
+// one draw for everything that was added to the scene
+static void RE_RenderScene( const renderSceneRef_t *fd )
+{
+	pc.c_drawCalls++;
+}
+
+static void *RE_GetImGuiTextureData( nhandle_t hShader )
+{
+	return NULL;
+}
+
+static void RE_GetConfig( gpuConfig_t *config )
+{
+	*config = glConfig;
+}
+
+static void RE_GetGPUFrameStats( uint32_t *time, uint32_t *samples, uint32_t *primitives )
+{
+	*time = 0;
+	*samples = 0;
+	*primitives = 0;
+}
+
+static void RE_GetGPUMemStats( gpuMemory_t *memstats )
+{
+	memset( memstats, 0, sizeof( *memstats ) );
+}
+
+static void RE_SetColor( const float *rgba )
+{
+}
+
+static void RE_BeginFrame( stereoFrame_t stereoFrame )
+{
+	if ( !registered ) {
+		return;
+	}
+	if ( imguiActive ) {
+		ri.ImGui_NewFrame();
+	}
+}
+
+static void RE_EndFrame( uint64_t *frontEndMsec, uint64_t *backEndMsec, backendCounters_t *counters )
+{
+	if ( imguiActive ) {
+		// imgui won't start another frame until this one's been rendered
+		ri.ImGui_EndFrame();
+	}
+
+	if ( counters ) {
+		*counters = pc;
+	}
+	if ( frontEndMsec ) {
+		*frontEndMsec = 0;
+	}
+	if ( backEndMsec ) {
+		*backEndMsec = 0;
+	}
+
+	// the counters are per frame
+	memset( &pc, 0, sizeof( pc ) );
+}
+
+static void RE_ThrottleBackend( void )
+{
+}
+
+static void RE_VertexLighting( qboolean allowed )
+{
+}
+
+GDR_EXPORT renderExport_t *GDR_DECL GetRenderAPI( uint32_t version, refimport_t *import )
+{
+	static renderExport_t re;
+
+	ri = *import;
+	memset( &re, 0, sizeof( re ) );
+
+	if ( version != NOMAD_VERSION_FULL ) {
+		ri.Error( ERR_FATAL, "GetRenderAPI: rendernull version (%i) != glnomad engine version (%i)", NOMAD_VERSION_FULL, version );
+	}
+
+	re.Shutdown = RE_Shutdown;
+	re.BeginRegistration = RE_BeginRegistration;
+	re.RegisterShader = RE_RegisterShader;
+	re.RegisterSpriteSheet = RE_RegisterSpriteSheet;
+	re.RegisterSprite = RE_RegisterSprite;
+	re.LoadWorld = RE_LoadWorld;
+	re.SetWorldTile = RE_SetWorldTile;
+	re.EndRegistration = RE_EndRegistration;
+	re.WaitRegistered = RE_WaitRegistered;
+
+	re.ClearScene = RE_ClearScene;
+	re.BeginScene = RE_BeginScene;
+	re.EndScene = RE_EndScene;
+	re.RenderScene = RE_RenderScene;
+
+	re.AddSpriteToScene = RE_AddSpriteToScene;
+	re.AddPolyToScene = RE_AddPolyToScene;
+	re.AddPolyListToScene = RE_AddPolyListToScene;
+	re.AddEntityToScene = RE_AddEntityToScene;
+	re.AddDynamicLightToScene = RE_AddDynamicLightToScene;
+	re.DrawImage = RE_DrawImage;
+	re.SetColor = RE_SetColor;
+
+	re.ImGui_TextureData = RE_GetImGuiTextureData;
+	re.GetConfig = RE_GetConfig;
+	re.GetGPUFrameStats = RE_GetGPUFrameStats;
+	re.GetGPUMemStats = RE_GetGPUMemStats;
+
+	re.BeginFrame = RE_BeginFrame;
+	re.EndFrame = RE_EndFrame;
+	re.ThrottleBackend = RE_ThrottleBackend;
+	re.VertexLighting = RE_VertexLighting;
+
+	return &re;
+}
@@ -16,6 +16,7 @@ namespace TheNomad {
 			m_Flags = flags;
 			m_bTrackChanges = bTrackChanges;
 			TheNomad::Engine::CvarRegister( name, value, flags, m_IntValue, m_FloatValue, m_nModificationCount, m_nCvarHandle );
+			TheNomad::Engine::WatchCvar( @this );
 		}
 		
 		const string& GetName() const {
@@ -53,7 +54,14 @@ namespace TheNomad {
 			if ( m_nCvarHandle == FS_INVALID_HANDLE ) {
 				TheNomad::Engine::CvarRegister( m_Name, m_Value, m_Flags, intValue, m_FloatValue, m_nModificationCount, m_nCvarHandle );
 			}
+			const int modificationCount = m_nModificationCount;
 			TheNomad::Engine::CvarUpdate( m_Value, m_IntValue, m_FloatValue, m_nModificationCount, m_nCvarHandle );
+			if ( m_bTrackChanges && modificationCount != m_nModificationCount ) {
+				ConsolePrint( "Changed \"" + m_Name + "\" to \"" + m_Value + "\"\n" );
+			}
+		}
+		int GetHandle() const {
+			return m_nCvarHandle;
 		}
 		
 		private string m_Name = "";
@@ -65,4 +73,33 @@ namespace TheNomad {
 		private int m_nCvarHandle = FS_INVALID_HANDLE;
 		private bool m_bTrackChanges = false;
 	};
+};
+
+namespace TheNomad::Engine {
+	//
+	// the engine queues a registered ConVar's handle whenever it's changed, UpdateCvars
+	// only has to update the ones in the queue instead of asking about every ConVar every frame
+	//
+	array<TheNomad::ConVar@> WatchedCvars;
+
+	void WatchCvar( TheNomad::ConVar@ cvar ) {
+		const int handle = cvar.GetHandle();
+		if ( handle == FS_INVALID_HANDLE ) {
+			return;
+		}
+		if ( uint( handle ) >= WatchedCvars.Count() ) {
+			WatchedCvars.Resize( handle + 1 );
+		}
+		@WatchedCvars[ handle ] = @cvar;
+		CvarWatch( handle );
+	}
+
+	void UpdateCvars() {
+		int handle;
+		while ( ( handle = CvarNextChanged() ) != FS_INVALID_HANDLE ) {
+			if ( uint( handle ) < WatchedCvars.Count() && @WatchedCvars[ handle ] !is null ) {
+				WatchedCvars[ handle ].Update();
+			}
+		}
+	}
 };
\ No newline at end of file
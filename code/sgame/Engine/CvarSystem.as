@@ -21,17 +21,8 @@ namespace TheNomad::Engine {
 			m_CvarCache.Add( var );
 		}
 		void UpdateCvars() {
-			// update all cvars
-			for ( uint i = 0; i < m_CvarCache.Count(); ++i ) {
-				m_CvarCache[i].m_Handle.Update();
-				if ( m_CvarCache[i].m_nModificationCount != m_CvarCache[i].m_Handle.GetModificationCount()
-					&& m_CvarCache[i].m_Handle.Track() )
-				{
-					m_CvarCache[i].m_nModificationCount = m_CvarCache[i].m_Handle.GetModificationCount();
-					ConsolePrint( "Changed \"" + m_CvarCache[i].m_Handle.GetName() + "\" to \""
-						+ m_CvarCache[i].m_Handle.GetValue() + "\"\n" );
-				}
-			}
+			// only the ones that changed, ConVar.Update prints the tracked ones
+			TheNomad::Engine::UpdateCvars();
 		}
 		
 		void ListVars_f() {
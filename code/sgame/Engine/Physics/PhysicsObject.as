@@ -1,4 +1,5 @@
 #include "Engine/Physics/Bounds.as"
+#include "SGame/Cvars.as"
 
 namespace TheNomad::Engine::Physics {
 	enum WaterType {
@@ -58,7 +59,7 @@ namespace TheNomad::Engine::Physics {
         }
 
         private void ClipBounds() {
-			if ( TheNomad::Engine::CvarVariableInteger( "sgame_NoClip" ) == 1 ) {
+			if ( TheNomad::SGame::sgame_NoClip.GetInt() == 1 ) {
 				return;
 			}
 
@@ -17,95 +17,16 @@ namespace TheNomad::GameSystem {
 		return @SystemHandle;
 	}
 
+	//
+	// TheNomad::GameSystem::RayCast is registered by the engine and works in map tile units,
+	// Cast() traces a single ray against the linked entities, skipping the ones flagged
+	// LINKFLAG_DEAD, several rays can be resolved in one call with
+	// TheNomad::GameSystem::CastRays( rays ), which writes m_Origin and m_nEntityNumber back
+	//
 	const uint RAYFLAG_WALLPIERCING = 0x0001;
 
-	class RayCast {
-		RayCast() {
-		}
-
-		void Cast( const vec3& in endDefault = vec3( 0.0f ) ) {
-			vec3 end;
-//			TheNomad::GameSystem::CastRay( m_Start, m_Origin, m_nEntityNumber, m_nOwner, m_nOwner2, m_nLength, m_nAngle, m_nSpeed, m_Flags );
-			if ( endDefault != vec3( 0.0f ) ) {
-				end = endDefault;
-			} else {
-				end.x = m_Start.x + ( m_nLength * cos( m_nAngle ) );
-				end.y = m_Start.y + ( m_nLength * sin( m_nAngle ) );
-				end.z = m_Start.z * sin( m_nAngle );
-			}
-
-			const float dx = abs( end.x - m_Start.x );
-			const float dy = abs( end.y - m_Start.y );
-			const float sx = m_Start.x < end.x ? 0.5f : -0.5f;
-			const float sy = m_Start.y < end.y ? 0.5f : -0.5f;
-			float err = ( dx > dy ? dx : -dy ) * 0.5f;
-			
-			m_Origin = m_Start;
-			float angle = m_nAngle;
-			if ( m_nOwner2 != ENTITYNUM_INVALID ) {
-				angle = Util::RAD2DEG( angle );
-				if ( angle < 0.0f ) {
-					angle += 360.0f;
-				}
-			}
-
-			TheNomad::SGame::EntityObject@ activeEnts = @TheNomad::SGame::EntityManager.GetActiveEnts();
-			TheNomad::SGame::EntityObject@ ent = null;
-			for ( ;; ) {
-				for ( @ent = @activeEnts.m_Next; @ent !is @activeEnts; @ent = @ent.m_Next ) {
-					if ( ent.GetEntityNum() != m_nOwner && ent.GetEntityNum() != m_nOwner2 && ent.GetBounds().IntersectsPoint( m_Origin )
-						&& !ent.CheckFlags( TheNomad::SGame::EntityFlags::Dead ) )
-					{
-						switch ( ent.GetType() ) {
-						case TheNomad::GameSystem::EntityType::Wall:
-						case TheNomad::GameSystem::EntityType::Item:
-						case TheNomad::GameSystem::EntityType::Weapon:
-							break;
-						case TheNomad::GameSystem::EntityType::Playr:
-							if ( TheNomad::Engine::CvarVariableInteger( "sgame_NoClip" ) == 1 ) {
-								continue;
-							}
-						case TheNomad::GameSystem::EntityType::Mob:
-							m_nEntityNumber = ent.GetEntityNum();
-							return;
-						};
-					}
-				}
-				if ( ( sy == -0.5f && m_Origin.y <= end.y ) || ( sy == 0.5f && m_Origin.y >= end.y )
-					|| ( sx == -0.5f && m_Origin.x <= end.x || ( sx == 0.5f && m_Origin.x >= end.x ) ) )
-				{
-					m_nEntityNumber = ENTITYNUM_INVALID;
-					return;
-				}
-
-				const TheNomad::GameSystem::DirType rayDir = Util::InverseDir( Util::Angle2Dir( angle ) );
-				if ( TheNomad::GameSystem::CheckWallHit( m_Origin, rayDir ) ) {
-					m_nEntityNumber = ENTITYNUM_WALL;
-					return;
-				}
-
-				const float e2 = err;
-				if ( e2 > -dx ) {
-					err -= dy;
-					m_Origin.x += sx;
-				}
-				if ( e2 < dy ) {
-					err += dx;
-					m_Origin.y += sy;
-				}
-			}
-		}
-
-		vec3 m_Start = vec3( 0.0f );
-		vec3 m_Origin = vec3( 0.0f );
-		uint m_nEntityNumber = ENTITYNUM_INVALID;
-		uint m_nOwner = ENTITYNUM_INVALID;
-		uint m_nOwner2 = ENTITYNUM_INVALID;
-		float m_nLength = 0.0f;
-		float m_nAngle = 0.0f;
-		float m_nSpeed = 0.5f;
-	    uint m_Flags = 0; // unused for now
-	};
+	// matches LINKFLAG_DEAD in g_game.h
+	const uint LINKFLAG_DEAD = 0x0001;
 
 	// constants, its a lot faster just to keep these globals
 	// I don't care about the whole OOP bullshit, this is
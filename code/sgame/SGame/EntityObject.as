@@ -172,7 +172,14 @@ namespace TheNomad::SGame {
 			m_State.Reset( m_nTicker );
 		}
 		void SetFlags( uint flags ) {
+			const bool wasDead = ( uint( m_Flags ) & EntityFlags::Dead ) != 0;
 			m_Flags = EntityFlags( flags );
+
+			// rays skip dead entities, the engine only knows through the link
+			if ( wasDead != ( ( flags & EntityFlags::Dead ) != 0 ) ) {
+				m_Link.m_nFlags = ( flags & EntityFlags::Dead ) != 0 ? TheNomad::GameSystem::LINKFLAG_DEAD : 0;
+				m_Link.Update();
+			}
 		}
 		void SetProjectile( bool bProjectile ) {
 			if ( bProjectile ) {
@@ -54,7 +54,7 @@ namespace TheNomad::SGame {
 			return "GfxManager";
 		}
 		void OnRenderScene() {
-			if ( TheNomad::Engine::CvarVariableInteger( "sgame_EnableParticles" ) == 0 || TheNomad::GameSystem::IsRespawnActive ) {
+			if ( TheNomad::SGame::sgame_EnableParticles.GetInt() == 0 || TheNomad::GameSystem::IsRespawnActive ) {
 				return;
 			}
 
@@ -178,7 +178,7 @@ namespace TheNomad::SGame {
 		}
 
 		void AddBloodSplatter( const vec3& in origin, int facing ) {
-			if ( TheNomad::Engine::CvarVariableInteger( "sgame_EnableParticles" ) == 0 || TheNomad::GameSystem::IsRespawnActive ) {
+			if ( TheNomad::SGame::sgame_EnableParticles.GetInt() == 0 || TheNomad::GameSystem::IsRespawnActive ) {
 				return;
 			}
 
@@ -195,7 +195,7 @@ namespace TheNomad::SGame {
 		}
 
 		void SmokeCloud( const vec3& in origin ) {
-			if ( TheNomad::Engine::CvarVariableInteger( "sgame_EnableParticles" ) == 0 || TheNomad::GameSystem::IsRespawnActive ) {
+			if ( TheNomad::SGame::sgame_EnableParticles.GetInt() == 0 || TheNomad::GameSystem::IsRespawnActive ) {
 				return;
 			}
 
@@ -208,7 +208,7 @@ namespace TheNomad::SGame {
 		// cloud
 		//
 		void AddDebrisCloud( const vec3& in origin, float velocity ) {
-			if ( TheNomad::Engine::CvarVariableInteger( "sgame_EnableParticles" ) == 0 || TheNomad::GameSystem::IsRespawnActive ) {
+			if ( TheNomad::SGame::sgame_EnableParticles.GetInt() == 0 || TheNomad::GameSystem::IsRespawnActive ) {
 				return;
 			}
 			const uint numSmokeClouds = floor( velocity );
@@ -232,7 +232,7 @@ namespace TheNomad::SGame {
 		}
 
 		void AddWaterWake( const vec3& in origin, uint lifeTime = 200, float scale = 2.5f ) {
-			if ( TheNomad::Engine::CvarVariableInteger( "sgame_EnableParticles" ) == 0 || TheNomad::GameSystem::IsRespawnActive ) {
+			if ( TheNomad::SGame::sgame_EnableParticles.GetInt() == 0 || TheNomad::GameSystem::IsRespawnActive ) {
 				return;
 			}
 
@@ -241,7 +241,7 @@ namespace TheNomad::SGame {
 		}
 
 		void AddBulletHole( const vec3& in origin ) {
-			if ( TheNomad::Engine::CvarVariableInteger( "sgame_EnableParticles" ) == 0 || TheNomad::GameSystem::IsRespawnActive ) {
+			if ( TheNomad::SGame::sgame_EnableParticles.GetInt() == 0 || TheNomad::GameSystem::IsRespawnActive ) {
 				return;
 			}
 
@@ -250,7 +250,7 @@ namespace TheNomad::SGame {
 		}
 
 		void AddLanding( const vec3& in origin ) {
-			if ( TheNomad::Engine::CvarVariableInteger( "sgame_EnableParticles" ) == 0 || TheNomad::GameSystem::IsRespawnActive ) {
+			if ( TheNomad::SGame::sgame_EnableParticles.GetInt() == 0 || TheNomad::GameSystem::IsRespawnActive ) {
 				return;
 			}
 
@@ -261,7 +261,7 @@ namespace TheNomad::SGame {
 		}
 
 		void AddDustPuff( const vec3& in origin, int facing ) {
-			if ( TheNomad::Engine::CvarVariableInteger( "sgame_EnableParticles" ) == 0 || TheNomad::GameSystem::IsRespawnActive ) {
+			if ( TheNomad::SGame::sgame_EnableParticles.GetInt() == 0 || TheNomad::GameSystem::IsRespawnActive ) {
 				return;
 			}
 
@@ -277,7 +277,7 @@ namespace TheNomad::SGame {
 		}
 
 		void AddDustTrail( const vec3& in origin, int facing ) {
-			if ( TheNomad::Engine::CvarVariableInteger( "sgame_EnableParticles" ) == 0 || TheNomad::GameSystem::IsRespawnActive ) {
+			if ( TheNomad::SGame::sgame_EnableParticles.GetInt() == 0 || TheNomad::GameSystem::IsRespawnActive ) {
 				return;
 			}
 
@@ -298,7 +298,7 @@ namespace TheNomad::SGame {
 		void AddMuzzleFlash( const vec3& in origin, float range = 10.0f, float brightness = 0.3f, float constant = 0.5f, float quadratic = 0.05f,
 			float linear = 0.05f, const vec3& in color = vec3( 1.0f ) )
 		{
-			if ( TheNomad::Engine::CvarVariableInteger( "sgame_EnableParticles" ) == 0 || TheNomad::GameSystem::IsRespawnActive ) {
+			if ( TheNomad::SGame::sgame_EnableParticles.GetInt() == 0 || TheNomad::GameSystem::IsRespawnActive ) {
 				return;
 			}
 
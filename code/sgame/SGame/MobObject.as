@@ -3,6 +3,10 @@
 #include "moblib/MobScript.as"
 
 namespace TheNomad::SGame {
+	// tile steps for each DirType, north is -y
+	const array<int> FlowDirX = { 0, 1, 1, 1, 0, -1, -1, -1 };
+	const array<int> FlowDirY = { -1, -1, 0, 1, 1, 1, 0, -1 };
+
 	class MobObject : EntityObject {
 		MobObject() {
 		}
@@ -119,6 +123,14 @@ namespace TheNomad::SGame {
 
 			if ( m_Target is null ) {
 				SetState( m_Info.idleState );
+			} else if ( @m_Target is @EntityManager.GetActivePlayer() ) {
+				// the engine keeps a shared path to the player for every mob, follow that
+				// instead of walking straight at them when it's in range
+				const TheNomad::GameSystem::DirType flowDir = TheNomad::GameSystem::GetFlowDirection( m_Link.m_Origin );
+				if ( flowDir != TheNomad::GameSystem::DirType::Inside ) {
+					m_Direction = flowDir;
+					m_PhysicsObject.SetAngle( atan2( float( FlowDirY[ flowDir ] ), float( FlowDirX[ flowDir ] ) ) );
+				}
 			}
 
 			// chase towards player
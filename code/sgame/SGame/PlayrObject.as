@@ -833,6 +833,7 @@ namespace TheNomad::SGame {
 			m_Link.m_Bounds.MakeBounds( m_Link.m_Origin );
 			// update engine data
 			m_Link.Update();
+			TheNomad::GameSystem::SetFlowFieldTarget( m_Link.m_Origin );
 			
 			//
 			// check reflex mode
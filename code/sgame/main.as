@@ -30,7 +30,7 @@ void InitCvars() {
 	TheNomad::SGame::sgame_cheat_InfiniteRage.Register( "sgame_cheat_InfiniteRage", "0", CVAR_CHEAT | CVAR_SAVE, false );
 	TheNomad::SGame::sgame_cheat_GodMode.Register( "sgame_cheat_GodMode", "0", CVAR_CHEAT | CVAR_SAVE, false );
 	TheNomad::SGame::sgame_cheats_enabled.Register( "sgame_cheats_enabled", "0", CVAR_CHEAT | CVAR_SAVE, false );
-	TheNomad::SGame::sgame_cheats_enabled.Register( "sgame_NoClip", "0", CVAR_CHEAT, true );
+	TheNomad::SGame::sgame_NoClip.Register( "sgame_NoClip", "0", CVAR_CHEAT, true );
 	/*
 	TheNomad::Engine::CvarManager.AddCvar( @TheNomad::SGame::sgame_LockShotMaxTargets, "sgame_LockShotMaxTargets", "20", CVAR_TEMP, false );
 	TheNomad::Engine::CvarManager.AddCvar( @TheNomad::SGame::sgame_LockShotTime, "sgame_LockShotTime", "100", CVAR_TEMP, false );
@@ -365,6 +365,8 @@ int ModuleOnMouseEvent( int dx, int dy ) {
 	return 0;
 }
 int ModuleOnRunTic( int msec ) {
+	TheNomad::Engine::UpdateCvars();
+
 	switch ( TheNomad::SGame::GlobalState ) {
 	case TheNomad::SGame::GameState::InLevel:
 	{
@@ -20,7 +20,7 @@ FMOD::Studio::EventDescription *CSoundBank::GetEvent( const char *pName )
 
 bool CSoundBank::Load( const char *npath )
 {
-	char *pBuffer;
+	const char *pBuffer;
 	uint64_t nLength;
 	int i, recieved;
 	char szPath[ MAX_NPATH ];
@@ -30,7 +30,7 @@ bool CSoundBank::Load( const char *npath )
 	N_strncpyz( m_szName, npath, sizeof( m_szName ) );
 
 	Com_snprintf( szPath, sizeof( szPath ) - 1, "soundbanks/%s.fsb", npath );
-	nLength = FS_LoadFile( szPath, (void **)&pBuffer );
+	nLength = FS_LoadFileView( szPath, (const void **)&pBuffer );
 	if ( !nLength || !pBuffer ) {
 		Con_Printf( COLOR_RED "Error loading sound bank file \"soundbanks/%s.fsb\".\n", npath );
 		return false;
@@ -39,10 +39,10 @@ bool CSoundBank::Load( const char *npath )
 	ERRCHECK( CSoundSystem::GetStudioSystem()->loadBankMemory( pBuffer, nLength, FMOD_STUDIO_LOAD_MEMORY,
 		FMOD_STUDIO_LOAD_BANK_NORMAL, &m_pBank ) );
 	
-	FS_FreeFile( pBuffer );
+	FS_FreeFileView( pBuffer );
 
 	Com_snprintf( szPath, sizeof( szPath ) - 1, "soundbanks/%s.fsb.strings", npath );
-	nLength = FS_LoadFile( szPath, (void **)&pBuffer );
+	nLength = FS_LoadFileView( szPath, (const void **)&pBuffer );
 	if ( !nLength || !pBuffer ) {
 		Con_Printf( COLOR_RED "Error loading sound bank strings file \"soundbanks/%s.fsb.strings\".\n", npath );
 		m_pBank->unload();
@@ -53,7 +53,7 @@ bool CSoundBank::Load( const char *npath )
 	ERRCHECK( CSoundSystem::GetStudioSystem()->loadBankMemory( pBuffer, nLength, FMOD_STUDIO_LOAD_MEMORY,
 		FMOD_STUDIO_LOAD_BANK_NORMAL, &m_pStrings ) );
 
-	FS_FreeFile( pBuffer );
+	FS_FreeFileView( pBuffer );
 
 	ERRCHECK( m_pBank->getEventCount( &m_nEventCount ) );
 
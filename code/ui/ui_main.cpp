@@ -366,7 +366,8 @@ static void UI_RegisterCvars( void )
 #endif
 
 	com_drawFPS = Cvar_Get( "com_drawFPS", "0", CVAR_SAVE );
-	Cvar_SetDescription( com_drawFPS, "Toggles displaying the average amount of frames drawn per second." );
+	Cvar_CheckRange( com_drawFPS, "0", "2", CVT_INT );
+	Cvar_SetDescription( com_drawFPS, "Toggles displaying the average amount of frames drawn per second, 2 also shows the frame time and its jitter." );
 
 #ifdef _NOMAD_DEBUG
 	ui_diagnostics = Cvar_Get( "ui_diagnostics", "3", CVAR_PROTECTED | CVAR_SAVE );
@@ -489,6 +490,13 @@ extern "C" void UI_DrawFPS( void )
 	ImGui::SetWindowPos( ImVec2( 900 * ui->scale + ui->bias, 8 * ui->scale ) );
 	ImGui::SetWindowFontScale( 1.5f * ui->scale );
 	ImGui::Text( "%i", fps );
+	if ( com_drawFPS->i > 1 ) {
+		frameStats_t stats;
+
+		Com_GetFrameStats( &stats );
+		ImGui::SetWindowFontScale( 1.0f * ui->scale );
+		ImGui::Text( "%.2f ms +/- %.2f", stats.meanUsec * 0.001f, stats.jitterUsec * 0.001f );
+	}
 	ImGui::End();
 }
 
@@ -574,6 +574,9 @@ void GDR_NORETURN GDR_ATTRIBUTE((format(printf, 1, 2))) GDR_DECL Sys_Error( cons
 	char text[MAXPRINTMSG];
 	const char *msg;
 
+	// get out whatever the writer thread hasn't gotten to yet, it's probably why we're here
+	Com_FlushLog();
+
 	// change stdin to non blocking
 	// NOTE TTimo not sure how well that goes with tty console mode
 	if ( stdin_active ) {
@@ -646,6 +649,7 @@ qboolean Sys_PIDIsRunning( int pid )
 
 void GDR_NORETURN Sys_Exit( int code )
 {
+	Com_FlushLog();
 	Sys_ConsoleInputShutdown();
 
 	if ( code != -1 && com_fullyInitialized ) {
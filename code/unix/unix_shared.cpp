@@ -14,6 +14,7 @@
 #include <sys/stat.h>
 #include <sys/resource.h>
 #include <sys/time.h>
+#include <time.h>
 #include <sys/sysinfo.h>
 #include <libgen.h>
 #include <fcntl.h>
@@ -488,6 +489,67 @@ uint64_t Sys_Milliseconds( void )
 	return curtime;
 }
 
+/*
+================
+Sys_Microseconds
+
+monotonic, so it doesn't jump around when the wall clock gets adjusted
+================
+*/
+uint64_t Sys_Microseconds( void )
+{
+	struct timespec ts;
+
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+	return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/*
+================
+Sys_SleepUntil
+
+blocks until Sys_Microseconds reaches usec
+================
+*/
+void Sys_SleepUntil( uint64_t usec )
+{
+	struct timespec ts;
+
+#ifdef __APPLE__
+	uint64_t now;
+
+	now = Sys_Microseconds();
+	if ( usec <= now ) {
+		return;
+	}
+	usec -= now;
+	ts.tv_sec = usec / 1000000;
+	ts.tv_nsec = ( usec % 1000000 ) * 1000;
+	while ( nanosleep( &ts, &ts ) == -1 && errno == EINTR )
+		;
+#else
+	ts.tv_sec = usec / 1000000;
+	ts.tv_nsec = ( usec % 1000000 ) * 1000;
+	while ( clock_nanosleep( CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL ) == EINTR )
+		;
+#endif
+}
+
+/*
+================
+Sys_ThreadCPUTime
+
+cpu time used by the calling thread in microseconds
+================
+*/
+uint64_t Sys_ThreadCPUTime( void )
+{
+	struct timespec ts;
+
+	clock_gettime( CLOCK_THREAD_CPUTIME_ID, &ts );
+	return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
 uint64_t Sys_EventSubtime( uint64_t time )
 {
 	uint64_t ret, t, test;
@@ -606,21 +668,40 @@ static memoryMap_t *MapMemory( size_t nBytes, int prot, int flags, int fd )
 	return mem;
 }
 
+/*
+* Sys_MapFile: maps a whole file read-only, temp mappings are private so the pages can be written to
+* without touching the file. Returns NULL if the file can't be mapped
+*/
 void *Sys_MapFile( const char *path, qboolean temp )
 {
 	memoryMap_t *file;
-	int prot, flags;
-	int fd;
-	size_t size;
+	struct stat fdata;
 	void *address;
+	int fd;
 
-	fd = open( path, 0 );
+	fd = open( path, O_RDONLY );
 	if ( fd == -1 ) {
-		N_Error( ERR_DROP, "Sys_MapFile: failed to create mapping for %s, strerror: %s", path, strerror( errno ) );
+		Con_Printf( COLOR_YELLOW "Sys_MapFile: failed to open %s, strerror: %s\n", path, strerror( errno ) );
+		return NULL;
+	}
+	if ( fstat( fd, &fdata ) == -1 || fdata.st_size == 0 ) {
+		close( fd );
+		return NULL;
 	}
 
-	file = MapMemory( lseek( fd, 0, SEEK_END ), PROT_READ | PROT_WRITE, temp ? MAP_PRIVATE : MAP_SHARED, fd );
-	lseek( fd, 0, SEEK_SET );
+	address = mmap( NULL, fdata.st_size, temp ? PROT_READ | PROT_WRITE : PROT_READ, MAP_PRIVATE, fd, 0 );
+	close( fd ); // the mapping keeps its own reference to the file
+	if ( address == MAP_FAILED ) {
+		Con_Printf( COLOR_YELLOW "Sys_MapFile: failed to map %s, strerror: %s\n", path, strerror( errno ) );
+		return NULL;
+	}
+
+	file = (memoryMap_t *)Z_Malloc( sizeof( *file ), TAG_STATIC );
+	memset( file, 0, sizeof( *file ) );
+	file->pAddress = address;
+	file->nBytes = fdata.st_size;
+	file->fileHandle = -1;
+	file->temporary = temp;
 
 	return file;
 }
@@ -657,7 +738,12 @@ void *Sys_MapMemory( FILE *fp, qboolean temp, fileHandle_t fd )
 
 void *Sys_GetMappedFileBuffer( void *file )
 {
-	return NULL; // FIXME: implement
+	return ( (memoryMap_t *)file )->pAddress;
+}
+
+uint64_t Sys_GetMappedFileSize( void *file )
+{
+	return ( (memoryMap_t *)file )->nBytes;
 }
 
 uint64_t Sys_ReadMappedFile( void *buffer, uint64_t size, void *file )
@@ -860,6 +946,20 @@ FILE *Sys_FOpen(const char *filepath, const char *mode)
 	return fopen(filepath, mode);
 }
 
+qboolean Sys_FSync( FILE *fp )
+{
+	if ( fflush( fp ) != 0 ) {
+		return qfalse;
+	}
+	return fsync( fileno( fp ) ) == 0;
+}
+
+// rename(2) replaces the target atomically, so readers either see the old file or the new one
+qboolean Sys_ReplaceFile( const char *from, const char *to )
+{
+	return rename( from, to ) == 0;
+}
+
 const char *Sys_pwd( void )
 {
 	static char pwd[MAX_OSPATH];
@@ -256,6 +256,9 @@ void GDR_NORETURN GDR_ATTRIBUTE((format(printf, 1, 2))) GDR_DECL Sys_Error( cons
 	char text[MAXPRINTMSG];
 	MSG msg;
 
+	// get out whatever the writer thread hasn't gotten to yet, it's probably why we're here
+	Com_FlushLog();
+
 	va_start( argptr, err );
 	N_vsnprintf( text, sizeof( text ), err, argptr );
 	va_end( argptr );
@@ -268,6 +271,8 @@ void GDR_NORETURN GDR_ATTRIBUTE((format(printf, 1, 2))) GDR_DECL Sys_Error( cons
 
 void GDR_NORETURN Sys_Exit( int code )
 {
+	Com_FlushLog();
+
 	if ( code != -1 && com_fullyInitialized ) {
 		// normal exit
 		Sys_RemovePIDFile( FS_GetCurrentGameDir() );
@@ -5,6 +5,7 @@
 #include <errhandlingapi.h>
 #include <processthreadsapi.h>
 #include <wincrypt.h>
+#include <io.h>
 
 uint64_t Sys_Milliseconds( void )
 {
@@ -26,6 +27,77 @@ void Sys_Sleep( double msec ) {
 	Sleep( msec );
 }
 
+uint64_t Sys_Microseconds( void )
+{
+	static LARGE_INTEGER frequency;
+	LARGE_INTEGER counter;
+
+	if ( !frequency.QuadPart ) {
+		QueryPerformanceFrequency( &frequency );
+	}
+	QueryPerformanceCounter( &counter );
+
+	return ( counter.QuadPart / frequency.QuadPart ) * 1000000
+		+ ( counter.QuadPart % frequency.QuadPart ) * 1000000 / frequency.QuadPart;
+}
+
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+
+/*
+==============
+Sys_SleepUntil
+
+Sleep() only has the resolution of the system timer (15.6 msec by default), the high resolution
+waitable timers are good for well under a millisecond on windows 10 1803 and up
+==============
+*/
+void Sys_SleepUntil( uint64_t usec )
+{
+	static HANDLE timer;
+	LARGE_INTEGER dueTime;
+	uint64_t now;
+
+	if ( !timer ) {
+		timer = CreateWaitableTimerExW( NULL, NULL, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS );
+		if ( !timer ) {
+			timer = CreateWaitableTimerW( NULL, TRUE, NULL );
+		}
+	}
+
+	now = Sys_Microseconds();
+	if ( usec <= now ) {
+		return;
+	}
+	if ( !timer ) {
+		Sleep( ( usec - now ) / 1000 );
+		return;
+	}
+
+	// negative means relative, in 100 nanosecond intervals
+	dueTime.QuadPart = -(LONGLONG)( ( usec - now ) * 10 );
+	if ( SetWaitableTimer( timer, &dueTime, 0, NULL, NULL, FALSE ) ) {
+		WaitForSingleObject( timer, INFINITE );
+	}
+}
+
+uint64_t Sys_ThreadCPUTime( void )
+{
+	FILETIME creationTime, exitTime, kernelTime, userTime;
+	ULARGE_INTEGER kernel, user;
+
+	if ( !GetThreadTimes( GetCurrentThread(), &creationTime, &exitTime, &kernelTime, &userTime ) ) {
+		return 0;
+	}
+	kernel.LowPart = kernelTime.dwLowDateTime;
+	kernel.HighPart = kernelTime.dwHighDateTime;
+	user.LowPart = userTime.dwLowDateTime;
+	user.HighPart = userTime.dwHighDateTime;
+
+	return ( kernel.QuadPart + user.QuadPart ) / 10;
+}
+
 uint64_t Sys_StackMemoryRemaining( void )
 {
 	// FIXME: implement
@@ -203,6 +275,75 @@ void Sys_ReleaseVirtualMemory( void *pMemory, uint64_t nBytes )
 	VirtualFree( pMemory, 0u, MEM_RELEASE );
 }
 
+typedef struct {
+	void *pAddress;
+	uint64_t nBytes;
+} memoryMap_t;
+
+/*
+* Sys_MapFile: maps a whole file read-only, temp mappings are copy-on-write so the pages can be written to
+* without touching the file. Returns NULL if the file can't be mapped
+*/
+void *Sys_MapFile( const char *path, qboolean temp )
+{
+	memoryMap_t *file;
+	HANDLE hFile, hMapping;
+	LARGE_INTEGER size;
+	void *address;
+
+	hFile = CreateFileA( path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL );
+	if ( hFile == INVALID_HANDLE_VALUE ) {
+		Con_Printf( COLOR_YELLOW "Sys_MapFile: failed to open %s, error code: %lu\n", path, GetLastError() );
+		return NULL;
+	}
+	if ( !GetFileSizeEx( hFile, &size ) || size.QuadPart == 0 ) {
+		CloseHandle( hFile );
+		return NULL;
+	}
+
+	hMapping = CreateFileMappingA( hFile, NULL, temp ? PAGE_WRITECOPY : PAGE_READONLY, 0, 0, NULL );
+	CloseHandle( hFile );
+	if ( !hMapping ) {
+		Con_Printf( COLOR_YELLOW "Sys_MapFile: failed to map %s, error code: %lu\n", path, GetLastError() );
+		return NULL;
+	}
+
+	// the view keeps the mapping object alive
+	address = MapViewOfFile( hMapping, temp ? FILE_MAP_COPY : FILE_MAP_READ, 0, 0, 0 );
+	CloseHandle( hMapping );
+	if ( !address ) {
+		Con_Printf( COLOR_YELLOW "Sys_MapFile: failed to map a view of %s, error code: %lu\n", path, GetLastError() );
+		return NULL;
+	}
+
+	file = (memoryMap_t *)Z_Malloc( sizeof( *file ), TAG_STATIC );
+	file->pAddress = address;
+	file->nBytes = size.QuadPart;
+
+	return file;
+}
+
+void *Sys_GetMappedFileBuffer( void *file )
+{
+	return ( (memoryMap_t *)file )->pAddress;
+}
+
+uint64_t Sys_GetMappedFileSize( void *file )
+{
+	return ( (memoryMap_t *)file )->nBytes;
+}
+
+void Sys_UnmapFile( void *file )
+{
+	memoryMap_t *mem;
+
+	mem = (memoryMap_t *)file;
+	if ( !UnmapViewOfFile( mem->pAddress ) ) {
+		N_Error( ERR_FATAL, "Sys_UnmapFile: UnmapViewOfFile failed on %p, error code: %lu", mem->pAddress, GetLastError() );
+	}
+	Z_Free( mem );
+}
+
 qboolean Sys_GetFileStats( fileStats_t *stats, const char *filename )
 {
     struct _stat fdata;
@@ -279,6 +420,33 @@ FILE *Sys_FOpen( const char *ospath, const char *mode )
 }
 
 
+/*
+==============
+Sys_FSync
+==============
+*/
+qboolean Sys_FSync( FILE *fp )
+{
+	if ( fflush( fp ) != 0 ) {
+		return qfalse;
+	}
+	return _commit( _fileno( fp ) ) == 0;
+}
+
+
+/*
+==============
+Sys_ReplaceFile
+
+AtoW isn't safe to call off the main thread, so this sticks to the ANSI api
+==============
+*/
+qboolean Sys_ReplaceFile( const char *from, const char *to )
+{
+	return MoveFileExA( from, to, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH ) ? qtrue : qfalse;
+}
+
+
 /*
 ==============
 Sys_ResetReadOnlyAttribute